@@ -0,0 +1,46 @@
+#ifndef CancelableFileH
+#define CancelableFileH
+//============================================================================
+/// \file   CancelableFile.h
+/// \brief  Declaration of CCancelableFile
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QFile>
+
+#include <atomic>
+
+
+/**
+ * @brief File that fails all reads once a flag is set.
+ *
+ * Handed to a QImageReader, it makes the decoder give up at its next read
+ * instead of decoding the rest of the image, so decoding in a worker
+ * thread can be canceled.
+ */
+class CCancelableFile : public QFile
+{
+private:
+	const std::atomic<bool>* m_Canceled;
+
+public:
+	CCancelableFile(const QString& Name, const std::atomic<bool>* Canceled)
+		: QFile(Name), m_Canceled(Canceled)
+	{
+	}
+
+protected:
+	qint64 readData(char* Data, qint64 MaxSize) override
+	{
+		if (m_Canceled->load())
+		{
+			return -1;
+		}
+		return QFile::readData(Data, MaxSize);
+	}
+}; // class CCancelableFile
+
+//---------------------------------------------------------------------------
+#endif // CancelableFileH
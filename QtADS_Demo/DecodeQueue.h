@@ -0,0 +1,160 @@
+#ifndef DecodeQueueH
+#define DecodeQueueH
+//============================================================================
+/// \file   DecodeQueue.h
+/// \brief  Declaration of CDecodeQueue
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+#include <deque>
+#include <memory>
+
+
+/**
+ * @brief Bounded queue of decode requests that hands out the most recent
+ * request first, with the workers serving it.
+ *
+ * Views request what they paint, so the newest requests are the ones on
+ * screen and the oldest ones were scrolled past. Requests beyond the limit
+ * are forgotten, oldest first, and requested again when painted again.
+ * A key stays pending from push() until finished(), so it is not queued
+ * twice while it is decoded.
+ *
+ * Workers run on the global thread pool and keep their owner alive through
+ * a shared pointer, so an owner going away never waits for a decode. Not
+ * thread safe, the owner guards the queue with its mutex.
+ */
+template <class Key>
+class CDecodeQueue
+{
+private:
+	std::deque<Key> m_Queue;///< most recent request first
+	QSet<Key> m_Pending;///< queued or being decoded
+	int m_Limit;
+	int m_ActiveWorkers = 0;
+
+	/**
+	 * Runs one worker loop of the owner
+	 */
+	template <class Owner>
+	class CWorker : public QRunnable
+	{
+	private:
+		std::shared_ptr<Owner> m_Owner;
+
+	public:
+		explicit CWorker(std::shared_ptr<Owner> _Owner) : m_Owner(std::move(_Owner)) {}
+
+		void run() override
+		{
+			m_Owner->runWorker();
+		}
+	};
+
+public:
+	explicit CDecodeQueue(int Limit) : m_Limit(Limit) {}
+
+	/**
+	 * @brief Workers per queue that keep decoding fast without taking the
+	 * whole global pool
+	 */
+	static int defaultMaxWorkers()
+	{
+		return qBound(2, QThread::idealThreadCount(), 4);
+	}
+
+	/**
+	 * @brief True if the key is queued or being decoded
+	 */
+	bool contains(const Key& RequestKey) const
+	{
+		return m_Pending.contains(RequestKey);
+	}
+
+	bool isEmpty() const
+	{
+		return m_Queue.empty();
+	}
+
+	int size() const
+	{
+		return int(m_Queue.size());
+	}
+
+	/**
+	 * @brief Queues a key unless it is pending already
+	 */
+	void push(const Key& RequestKey)
+	{
+		if (contains(RequestKey))
+		{
+			return;
+		}
+		m_Queue.push_front(RequestKey);
+		m_Pending.insert(RequestKey);
+		if (int(m_Queue.size()) > m_Limit)
+		{
+			m_Pending.remove(m_Queue.back());
+			m_Queue.pop_back();
+		}
+	}
+
+	/**
+	 * @brief Takes the most recent request. It stays pending until
+	 * finished() is called for it.
+	 */
+	Key takeNext()
+	{
+		Key RequestKey = m_Queue.front();
+		m_Queue.pop_front();
+		return RequestKey;
+	}
+
+	void finished(const Key& RequestKey)
+	{
+		m_Pending.remove(RequestKey);
+	}
+
+	/**
+	 * @brief Forgets the queued requests. Keys being decoded stay pending.
+	 */
+	void clear()
+	{
+		for (const Key& RequestKey : m_Queue)
+		{
+			m_Pending.remove(RequestKey);
+		}
+		m_Queue.clear();
+	}
+
+	/**
+	 * @brief Starts workers calling Owner->runWorker() until there is one
+	 * per queued request or MaxWorkers run. runWorker() takes requests
+	 * until the queue is empty and then calls workerFinished().
+	 */
+	template <class Owner>
+	void startWorkers(const std::shared_ptr<Owner>& WorkerOwner, int MaxWorkers)
+	{
+		int Wanted = qMin(MaxWorkers, m_ActiveWorkers + size());
+		while (m_ActiveWorkers < Wanted)
+		{
+			++m_ActiveWorkers;
+			QThreadPool::globalInstance()->start(new CWorker<Owner>(WorkerOwner));
+		}
+	}
+
+	void workerFinished()
+	{
+		--m_ActiveWorkers;
+	}
+}; // class CDecodeQueue
+
+//---------------------------------------------------------------------------
+#endif // DecodeQueueH
@@ -0,0 +1,183 @@
+//============================================================================
+/// \file   ImageBrowser.cpp
+/// \brief  Implementation of CImageBrowser
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ImageBrowser.h"
+#include "ThumbnailCache.h"
+#include "ThumbnailModel.h"
+
+#include <QAction>
+#include <QBoxLayout>
+#include <QDir>
+#include <QFileDialog>
+#include <QLabel>
+#include <QListView>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+
+
+namespace
+{
+/**
+ * Draws the thumbnail above the elided file name. QListView only does this in
+ * icon mode, which keeps a position for every item; list mode with wrapping
+ * lays out uniform items without touching them.
+ */
+class CThumbnailDelegate : public QStyledItemDelegate
+{
+private:
+	QSize m_Size;
+
+public:
+	CThumbnailDelegate(const QSize& Size, QObject* Parent)
+		: QStyledItemDelegate(Parent), m_Size(Size) {}
+
+	QSize sizeHint(const QStyleOptionViewItem& Option, const QModelIndex& Index) const override
+	{
+		Q_UNUSED(Option);
+		Q_UNUSED(Index);
+		return m_Size;
+	}
+
+protected:
+	void initStyleOption(QStyleOptionViewItem* Option, const QModelIndex& Index) const override
+	{
+		QStyledItemDelegate::initStyleOption(Option, Index);
+		Option->decorationPosition = QStyleOptionViewItem::Top;
+		Option->decorationAlignment = Qt::AlignCenter;
+		Option->displayAlignment = Qt::AlignHCenter | Qt::AlignTop;
+		Option->decorationSize = QSize(CThumbnailCache::ThumbnailSize,
+			CThumbnailCache::ThumbnailSize);
+		Option->textElideMode = Qt::ElideMiddle;
+		Option->features &= ~QStyleOptionViewItem::WrapText;
+	}
+};
+} // namespace
+
+
+/**
+ * Private data of CImageBrowser
+ */
+struct ImageBrowserPrivate
+{
+	CImageBrowser* _this;
+	CThumbnailModel* Model;
+	QListView* View;
+	QLabel* StatusLabel;
+
+	ImageBrowserPrivate(CImageBrowser* _public) : _this(_public) {}
+
+	/**
+	 * Shows the directory and the number of images
+	 */
+	void updateStatus();
+};
+
+
+//============================================================================
+void ImageBrowserPrivate::updateStatus()
+{
+	QString Directory = QDir::toNativeSeparators(Model->directory());
+	StatusLabel->setText(Model->isListing()
+		? CImageBrowser::tr("%1 - listing...").arg(Directory)
+		: CImageBrowser::tr("%1 - %2 images").arg(Directory).arg(Model->rowCount()));
+	StatusLabel->setToolTip(Directory);
+}
+
+
+//============================================================================
+CImageBrowser::CImageBrowser(QWidget* Parent)
+	: QWidget(Parent),
+	  d(new ImageBrowserPrivate(this))
+{
+	d->Model = new CThumbnailModel(this);
+	d->StatusLabel = new QLabel();
+	d->StatusLabel->setContentsMargins(4, 2, 4, 2);
+
+	const int Size = CThumbnailCache::ThumbnailSize;
+	QSize GridSize(Size + 16, Size + this->fontMetrics().height() + 16);
+	d->View = new QListView();
+	d->View->setItemDelegate(new CThumbnailDelegate(GridSize - QSize(4, 4), d->View));
+	d->View->setModel(d->Model);
+	d->View->setViewMode(QListView::ListMode);
+	d->View->setFlow(QListView::LeftToRight);
+	d->View->setWrapping(true);
+	d->View->setUniformItemSizes(true);
+	d->View->setGridSize(GridSize);
+	d->View->setIconSize(QSize(Size, Size));
+	d->View->setMovement(QListView::Static);
+	d->View->setResizeMode(QListView::Adjust);
+	d->View->setLayoutMode(QListView::Batched);
+	d->View->setBatchSize(2000);
+	d->View->setSelectionMode(QAbstractItemView::SingleSelection);
+	d->View->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+	d->View->verticalScrollBar()->setSingleStep(GridSize.height() / 4);
+
+	auto Layout = new QBoxLayout(QBoxLayout::TopToBottom);
+	Layout->setContentsMargins(0, 0, 0, 0);
+	Layout->setSpacing(0);
+	Layout->addWidget(d->StatusLabel);
+	Layout->addWidget(d->View, 1);
+	setLayout(Layout);
+
+	connect(d->View, &QListView::activated, this, [this](const QModelIndex& Index)
+	{
+		QString FileName = d->Model->filePath(Index);
+		if (!FileName.isEmpty())
+		{
+			Q_EMIT imageActivated(FileName);
+		}
+	});
+	connect(d->Model, &CThumbnailModel::listingFinished, this, [this]()
+	{
+		d->updateStatus();
+	});
+
+	auto a = new QAction(tr("Open Folder..."), this);
+	a->setIcon(QIcon(":/adsdemo/images/folder_open.svg"));
+	connect(a, &QAction::triggered, this, &CImageBrowser::openDirectory);
+	this->addAction(a);
+}
+
+
+//============================================================================
+CImageBrowser::~CImageBrowser()
+{
+	delete d;
+}
+
+
+//============================================================================
+void CImageBrowser::setDirectory(const QString& Path)
+{
+	d->Model->setDirectory(Path);
+	d->View->scrollToTop();
+	d->updateStatus();
+}
+
+
+//============================================================================
+QString CImageBrowser::directory() const
+{
+	return d->Model->directory();
+}
+
+
+//============================================================================
+void CImageBrowser::openDirectory()
+{
+	QString Path = QFileDialog::getExistingDirectory(this, tr("Open Folder"),
+		directory());
+	if (!Path.isEmpty())
+	{
+		setDirectory(Path);
+	}
+}
+
+//---------------------------------------------------------------------------
+// EOF ImageBrowser.cpp
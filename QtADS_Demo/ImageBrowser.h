@@ -0,0 +1,55 @@
+#ifndef ImageBrowserH
+#define ImageBrowserH
+//============================================================================
+/// \file   ImageBrowser.h
+/// \brief  Declaration of CImageBrowser
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QWidget>
+
+struct ImageBrowserPrivate;
+
+/**
+ * @brief Grid of thumbnails of the image files in a directory.
+ *
+ * The grid is a QListView with uniform item sizes, so only the visible rows
+ * are laid out and painted, and thumbnails come from CThumbnailModel, so
+ * scrolling never waits for an image to decode. Activating a thumbnail
+ * emits imageActivated().
+ */
+class CImageBrowser : public QWidget
+{
+	Q_OBJECT
+public:
+	explicit CImageBrowser(QWidget* Parent = nullptr);
+	virtual ~CImageBrowser();
+
+	/**
+	 * @brief Shows the image files of directory Path
+	 */
+	void setDirectory(const QString& Path);
+	QString directory() const;
+
+public slots:
+	/**
+	 * @brief Lets the user choose the directory to show
+	 */
+	void openDirectory();
+
+signals:
+	/**
+	 * @brief Emitted when the user double clicks or presses enter on a
+	 * thumbnail
+	 */
+	void imageActivated(const QString& FileName);
+
+private:
+	ImageBrowserPrivate* d;
+	friend struct ImageBrowserPrivate;
+}; // class CImageBrowser
+
+//---------------------------------------------------------------------------
+#endif // ImageBrowserH
@@ -0,0 +1,150 @@
+//============================================================================
+/// \file   ImageCache.cpp
+/// \brief  Implementation of CImageCache
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ImageCache.h"
+#include "LruImageCache.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+
+
+/**
+ * Private data of CImageCache
+ */
+struct ImageCachePrivate
+{
+	QMutex Mutex;
+	CLruImageCache<QString> Cache{CImageCache::DefaultLimit};
+
+	/**
+	 * Key of an image. Files include their modification time, so edited
+	 * files are decoded again; resources cannot change.
+	 */
+	static QString key(const QString& Source, const QSize& TargetSize,
+		qreal DevicePixelRatio)
+	{
+		QString Key = QString("%1|%2x%3@%4").arg(Source).arg(TargetSize.width())
+			.arg(TargetSize.height()).arg(DevicePixelRatio);
+		if (!Source.startsWith(QLatin1Char(':')))
+		{
+			Key += QLatin1Char('|')
+				+ QString::number(QFileInfo(Source).lastModified().toMSecsSinceEpoch());
+		}
+		return Key;
+	}
+};
+
+
+//============================================================================
+CImageCache::CImageCache()
+	: d(new ImageCachePrivate)
+{
+}
+
+
+//============================================================================
+CImageCache::~CImageCache()
+{
+	delete d;
+}
+
+
+//============================================================================
+CImageCache& CImageCache::instance()
+{
+	static CImageCache Cache;
+	return Cache;
+}
+
+
+//============================================================================
+QImage CImageCache::image(const QString& Source, const QSize& TargetSize,
+	qreal DevicePixelRatio)
+{
+	QImage Image = find(Source, TargetSize, DevicePixelRatio);
+	if (!Image.isNull())
+	{
+		return Image;
+	}
+
+	QImageReader Reader(Source);
+	Reader.setAutoTransform(true);
+	if (TargetSize.isValid())
+	{
+		QSize ImageSize = Reader.size();
+		QSize PixelSize = TargetSize * DevicePixelRatio;
+		Reader.setScaledSize(ImageSize.isValid()
+			? ImageSize.scaled(PixelSize, Qt::KeepAspectRatio) : PixelSize);
+	}
+	Image = Reader.read();
+	if (Image.isNull())
+	{
+		return Image;
+	}
+	return insert(Source, TargetSize, DevicePixelRatio, Image);
+}
+
+
+//============================================================================
+QImage CImageCache::find(const QString& Source, const QSize& TargetSize,
+	qreal DevicePixelRatio)
+{
+	QString Key = ImageCachePrivate::key(Source, TargetSize, DevicePixelRatio);
+	QMutexLocker Lock(&d->Mutex);
+	return d->Cache.find(Key);
+}
+
+
+//============================================================================
+QImage CImageCache::insert(const QString& Source, const QSize& TargetSize,
+	qreal DevicePixelRatio, const QImage& Image)
+{
+	QImage Paintable = Image;
+	if (Image.format() != QImage::Format_RGB32
+	 && Image.format() != QImage::Format_ARGB32_Premultiplied)
+	{
+		Paintable = Image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+	}
+	Paintable.setDevicePixelRatio(DevicePixelRatio);
+
+	QString Key = ImageCachePrivate::key(Source, TargetSize, DevicePixelRatio);
+	QMutexLocker Lock(&d->Mutex);
+	QImage Cached = d->Cache.find(Key);
+	if (!Cached.isNull())
+	{
+		return Cached;
+	}
+	if (qint64(Paintable.bytesPerLine()) * Paintable.height() <= d->Cache.limit())
+	{
+		d->Cache.insert(Key, Paintable);
+	}
+	return Paintable;
+}
+
+
+//============================================================================
+void CImageCache::setLimit(qint64 Bytes)
+{
+	QMutexLocker Lock(&d->Mutex);
+	d->Cache.setLimit(Bytes);
+}
+
+
+//============================================================================
+void CImageCache::clear()
+{
+	QMutexLocker Lock(&d->Mutex);
+	d->Cache.clear();
+}
+
+//---------------------------------------------------------------------------
+// EOF ImageCache.cpp
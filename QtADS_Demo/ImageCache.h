@@ -0,0 +1,87 @@
+#ifndef ImageCacheH
+#define ImageCacheH
+//============================================================================
+/// \file   ImageCache.h
+/// \brief  Declaration of CImageCache
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+struct ImageCachePrivate;
+
+/**
+ * @brief Process wide cache of decoded images and rasterized SVGs.
+ *
+ * Images are keyed by their source (a file or resource path), the size
+ * they were decoded to fit into and the device pixel ratio. Returned images
+ * are implicitly shared, so all viewers and icons showing the same source
+ * at the same size use one pixel buffer. Images are kept in a format
+ * QPainter draws without conversion, so the sharing survives painting.
+ *
+ * The cache is bounded in bytes and drops the least recently used images.
+ * Images larger than the whole cache are returned but not kept. Files are
+ * decoded again once their modification time changes. All functions are
+ * thread safe; decoding happens in the calling thread, outside the lock.
+ */
+class CImageCache
+{
+public:
+	static constexpr qint64 DefaultLimit = qint64(64) * 1024 * 1024;
+
+	/**
+	 * @brief The cache of this process
+	 */
+	static CImageCache& instance();
+
+	/**
+	 * @brief Returns the image of Source, decoding it on a cache miss.
+	 * @param[in] TargetSize The image is scaled to fit into this size,
+	 * keeping its aspect ratio. An invalid size keeps the image size.
+	 * @param[in] DevicePixelRatio TargetSize is in device independent
+	 * pixels; the image gets this many pixels per TargetSize pixel.
+	 * Returns a null image if Source cannot be read.
+	 */
+	QImage image(const QString& Source, const QSize& TargetSize = QSize(),
+		qreal DevicePixelRatio = 1);
+
+	/**
+	 * @brief Returns the cached image of Source or a null image, never
+	 * decodes.
+	 */
+	QImage find(const QString& Source, const QSize& TargetSize = QSize(),
+		qreal DevicePixelRatio = 1);
+
+	/**
+	 * @brief Adds an image decoded elsewhere and returns the image to use.
+	 * If another thread added the same image meanwhile, that one is
+	 * returned, so both share its buffer.
+	 */
+	QImage insert(const QString& Source, const QSize& TargetSize,
+		qreal DevicePixelRatio, const QImage& Image);
+
+	/**
+	 * @brief Changes the number of bytes the cache may use.
+	 */
+	void setLimit(qint64 Bytes);
+
+	/**
+	 * @brief Drops all cached images.
+	 */
+	void clear();
+
+private:
+	CImageCache();
+	~CImageCache();
+	CImageCache(const CImageCache&) = delete;
+	CImageCache& operator=(const CImageCache&) = delete;
+
+	ImageCachePrivate* d;
+}; // class CImageCache
+
+//---------------------------------------------------------------------------
+#endif // ImageCacheH
@@ -0,0 +1,472 @@
+//============================================================================
+/// \file   ImageCompare.cpp
+/// \brief  Implementation of CImageCompare
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ImageCompare.h"
+#include "ImageViewer.h"
+#include "RenderWidget.h"
+
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QLabel>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+#include <memory>
+
+
+/**
+ * Shared by the jobs of one comparison. The compare pointer is reset when
+ * the comparison is canceled, so late jobs drop their result.
+ */
+struct ImageDiffState
+{
+	QMutex Mutex;
+	CImageCompare* Compare = nullptr;
+	std::atomic<bool> Canceled{false};
+	QImage Reference;
+	QImage Test;
+	QImage Heatmap;
+	uint32_t* HeatmapBits = nullptr;///< detached once, tiles write disjoint parts
+	int Threshold = 0;
+	int Columns = 0;
+	int TileCount = 0;
+	std::atomic<int> NextTile{0};
+	std::atomic<int> RunningJobs{0};
+	QElapsedTimer Timer;
+	SImageDiffStatistics Statistics;///< guarded by Mutex
+	QVector<QImage> HeatmapLevels;///< guarded by Mutex
+	qint64 ElapsedMs = 0;///< guarded by Mutex
+	bool Finished = false;///< guarded by Mutex
+};
+
+
+namespace
+{
+/**
+ * Returns Image in a format with 0xAARRGGBB pixels
+ */
+QImage diffableImage(const QImage& Image)
+{
+	switch (Image.format())
+	{
+	case QImage::Format_RGB32:
+	case QImage::Format_ARGB32:
+	case QImage::Format_ARGB32_Premultiplied:
+		return Image;
+	default:
+		return Image.convertToFormat(QImage::Format_RGB32);
+	}
+}
+
+const uint32_t* constPixel(const QImage& Image, const QPoint& Pos)
+{
+	return reinterpret_cast<const uint32_t*>(Image.constScanLine(Pos.y())) + Pos.x();
+}
+
+/**
+ * Builds the levels of the heatmap, like the levels of the images in
+ * CRenderWidget but keeping the maximum instead of the average
+ */
+QVector<QImage> buildHeatmapLevels(const QImage& Heatmap,
+	const std::atomic<bool>& Canceled)
+{
+	QVector<QImage> Levels{Heatmap};
+	while (!Canceled)
+	{
+		QImage Last = Levels.last();
+		if (Last.width() / 2 < CRenderWidget::MinLevelSize
+		 || Last.height() / 2 < CRenderWidget::MinLevelSize)
+		{
+			break;
+		}
+		QImage Level(Last.width() / 2, Last.height() / 2,
+			QImage::Format_ARGB32_Premultiplied);
+		if (Level.isNull())
+		{
+			break;
+		}
+		halveByMaximum(reinterpret_cast<const uint32_t*>(Last.constBits()),
+			Last.bytesPerLine(), Last.width(), Last.height(),
+			reinterpret_cast<uint32_t*>(Level.bits()), Level.bytesPerLine());
+		Levels.append(Level);
+	}
+	return Levels;
+}
+
+/**
+ * Compares tiles until none are left. The job finishing last builds the
+ * heatmap levels and posts the result.
+ */
+class CDiffJob : public QRunnable
+{
+private:
+	std::shared_ptr<ImageDiffState> m_State;
+
+public:
+	explicit CDiffJob(std::shared_ptr<ImageDiffState> State)
+		: m_State(std::move(State)) {}
+
+	void run() override
+	{
+		ImageDiffState& State = *m_State;
+		const QRect Area(QPoint(0, 0), State.Heatmap.size());
+		const ptrdiff_t HeatmapStride = State.Heatmap.bytesPerLine();
+		SImageDiffStatistics Statistics;
+		for (int Tile = State.NextTile++; Tile < State.TileCount && !State.Canceled;
+			Tile = State.NextTile++)
+		{
+			QRect Rect = QRect((Tile % State.Columns) * CImageCompare::TileSize,
+				(Tile / State.Columns) * CImageCompare::TileSize,
+				CImageCompare::TileSize, CImageCompare::TileSize) & Area;
+			uint32_t* Heatmap = reinterpret_cast<uint32_t*>(
+				reinterpret_cast<uint8_t*>(State.HeatmapBits) + Rect.top() * HeatmapStride)
+				+ Rect.left();
+			diffRgb32(constPixel(State.Reference, Rect.topLeft()),
+				State.Reference.bytesPerLine(), constPixel(State.Test, Rect.topLeft()),
+				State.Test.bytesPerLine(), Heatmap, HeatmapStride, Rect.width(),
+				Rect.height(), State.Threshold, Statistics);
+		}
+
+		{
+			QMutexLocker Lock(&State.Mutex);
+			State.Statistics.add(Statistics);
+		}
+		if (--State.RunningJobs > 0 || State.Canceled)
+		{
+			return;
+		}
+
+		QVector<QImage> Levels = buildHeatmapLevels(State.Heatmap, State.Canceled);
+		QMutexLocker Lock(&State.Mutex);
+		if (!State.Compare)
+		{
+			return;
+		}
+		State.HeatmapLevels = std::move(Levels);
+		State.ElapsedMs = State.Timer.elapsed();
+		State.Finished = true;
+		QMetaObject::invokeMethod(State.Compare, "onDiffReady", Qt::QueuedConnection);
+	}
+};
+} // namespace
+
+
+/**
+ * Private data of CImageCompare
+ */
+struct ImageComparePrivate
+{
+	CImageCompare* _this;
+	CImageViewer* Reference = nullptr;///< reset when the viewer is destroyed
+	CImageViewer* Test = nullptr;///< reset when the viewer is destroyed
+	QPointer<QWidget> Viewport;///< viewport of Test
+	QPointer<QLabel> Summary;///< shown on Viewport
+	QTimer* CompareTimer = nullptr;///< coalesces image changes of both viewers
+	std::shared_ptr<ImageDiffState> Diff;///< running comparison
+	SImageDiffStatistics Statistics;
+	int Threshold = 0;
+	bool Syncing = false;
+
+	ImageComparePrivate(CImageCompare* _public) : _this(_public) {}
+
+	/**
+	 * Drops the result of the running comparison
+	 */
+	void cancelDiff();
+
+	/**
+	 * Moves the view of To to the view of From
+	 */
+	void syncView(CImageViewer* From, CImageViewer* To);
+
+	void showSummary(const QString& Text);
+	void placeSummary();
+};
+
+
+//============================================================================
+void ImageComparePrivate::cancelDiff()
+{
+	if (!Diff)
+	{
+		return;
+	}
+	Diff->Canceled = true;
+	QMutexLocker Lock(&Diff->Mutex);
+	Diff->Compare = nullptr;
+	Lock.unlock();
+	Diff.reset();
+}
+
+
+//============================================================================
+void ImageComparePrivate::syncView(CImageViewer* From, CImageViewer* To)
+{
+	// Moving To emits its viewChanged() signal again
+	if (Syncing || !From || !To)
+	{
+		return;
+	}
+	Syncing = true;
+	To->setView(From->scaleFactor(), From->viewCenter());
+	Syncing = false;
+}
+
+
+//============================================================================
+void ImageComparePrivate::showSummary(const QString& Text)
+{
+	if (!Summary)
+	{
+		return;
+	}
+	Summary->setText(Text);
+	Summary->adjustSize();
+	placeSummary();
+}
+
+
+//============================================================================
+void ImageComparePrivate::placeSummary()
+{
+	if (!Summary || !Viewport)
+	{
+		return;
+	}
+	Summary->move(4, Viewport->height() - Summary->height() - 4);
+	Summary->raise();
+}
+
+
+//============================================================================
+CImageCompare::CImageCompare(CImageViewer* Reference, CImageViewer* Test,
+	QObject* Parent)
+	: QObject(Parent),
+	  d(new ImageComparePrivate(this))
+{
+	d->Reference = Reference;
+	d->Test = Test;
+
+	d->Viewport = Test->viewport();
+	d->Summary = new QLabel(d->Viewport);
+	d->Summary->setAttribute(Qt::WA_TransparentForMouseEvents);
+	d->Summary->setAutoFillBackground(true);
+	QPalette Palette = d->Summary->palette();
+	Palette.setColor(QPalette::Window, QColor(0, 0, 0, 180));
+	Palette.setColor(QPalette::WindowText, Qt::white);
+	d->Summary->setPalette(Palette);
+	d->Summary->setMargin(4);
+	d->Summary->show();
+	d->Viewport->installEventFilter(this);
+
+	d->CompareTimer = new QTimer(this);
+	d->CompareTimer->setSingleShot(true);
+	d->CompareTimer->setInterval(0);
+	connect(d->CompareTimer, &QTimer::timeout, this, &CImageCompare::compare);
+	for (auto Viewer : {Reference, Test})
+	{
+		connect(Viewer, &CImageViewer::imageChanged, this, [this]()
+		{
+			d->CompareTimer->start();
+		});
+		connect(Viewer, &QObject::destroyed, this, [this](QObject* Object)
+		{
+			d->cancelDiff();
+			if (d->Reference == Object)
+			{
+				d->Reference = nullptr;
+			}
+			if (d->Test == Object)
+			{
+				d->Test = nullptr;
+			}
+			this->deleteLater();
+		});
+	}
+	connect(Reference, &CImageViewer::viewChanged, this, [this]()
+	{
+		d->syncView(d->Reference, d->Test);
+	});
+	connect(Test, &CImageViewer::viewChanged, this, [this]()
+	{
+		d->syncView(d->Test, d->Reference);
+	});
+
+	d->syncView(Reference, Test);
+	compare();
+}
+
+
+//============================================================================
+CImageCompare::~CImageCompare()
+{
+	d->cancelDiff();
+	if (d->Viewport)
+	{
+		d->Viewport->removeEventFilter(this);
+	}
+	if (d->Test)
+	{
+		d->Test->setOverlay(QVector<QImage>());
+	}
+	delete d->Summary;
+	delete d;
+}
+
+
+//============================================================================
+CImageViewer* CImageCompare::referenceViewer() const
+{
+	return d->Reference;
+}
+
+
+//============================================================================
+CImageViewer* CImageCompare::testViewer() const
+{
+	return d->Test;
+}
+
+
+//============================================================================
+void CImageCompare::setThreshold(int Threshold)
+{
+	Threshold = qBound(0, Threshold, 255);
+	if (d->Threshold == Threshold)
+	{
+		return;
+	}
+	d->Threshold = Threshold;
+	compare();
+}
+
+
+//============================================================================
+int CImageCompare::threshold() const
+{
+	return d->Threshold;
+}
+
+
+//============================================================================
+SImageDiffStatistics CImageCompare::statistics() const
+{
+	return d->Statistics;
+}
+
+
+//============================================================================
+void CImageCompare::compare()
+{
+	d->cancelDiff();
+	if (!d->Reference || !d->Test)
+	{
+		return;
+	}
+
+	d->Test->setOverlay(QVector<QImage>());
+	QImage Reference = d->Reference->image();
+	QImage Test = d->Test->image();
+	if (Reference.isNull() || Test.isNull())
+	{
+		// Also images shown in tiles, which are never decoded completely
+		d->showSummary(tr("Waiting for both images at full resolution"));
+		return;
+	}
+
+	auto State = std::make_shared<ImageDiffState>();
+	State->Reference = diffableImage(Reference);
+	State->Test = diffableImage(Test);
+	State->Heatmap = QImage(Reference.size().boundedTo(Test.size()),
+		QImage::Format_ARGB32_Premultiplied);
+	if (State->Heatmap.isNull())
+	{
+		d->showSummary(tr("Not enough memory to compare the images"));
+		return;
+	}
+	State->Compare = this;
+	State->HeatmapBits = reinterpret_cast<uint32_t*>(State->Heatmap.bits());
+	State->Threshold = d->Threshold;
+	State->Columns = (State->Heatmap.width() + TileSize - 1) / TileSize;
+	State->TileCount = State->Columns
+		* ((State->Heatmap.height() + TileSize - 1) / TileSize);
+	int JobCount = qBound(1, QThread::idealThreadCount(), State->TileCount);
+	State->RunningJobs = JobCount;
+	State->Timer.start();
+	d->Diff = State;
+	d->showSummary(tr("Comparing..."));
+	for (int i = 0; i < JobCount; ++i)
+	{
+		QThreadPool::globalInstance()->start(new CDiffJob(State));
+	}
+}
+
+
+//============================================================================
+void CImageCompare::onDiffReady()
+{
+	if (!d->Diff)
+	{
+		return;
+	}
+
+	QVector<QImage> Levels;
+	qint64 ElapsedMs;
+	{
+		QMutexLocker Lock(&d->Diff->Mutex);
+		if (!d->Diff->Finished)
+		{
+			return;
+		}
+		Levels = std::move(d->Diff->HeatmapLevels);
+		d->Statistics = d->Diff->Statistics;
+		ElapsedMs = d->Diff->ElapsedMs;
+	}
+	QSize ReferenceSize = d->Diff->Reference.size();
+	QSize TestSize = d->Diff->Test.size();
+	d->Diff.reset();
+	d->Test->setOverlay(Levels);
+
+	const SImageDiffStatistics& Statistics = d->Statistics;
+	QString Text = Statistics.SquaredError
+		? tr("Max delta %1  changed %2 pixels (%3%)  PSNR %4 dB")
+			.arg(Statistics.MaxDelta)
+			.arg(qulonglong(Statistics.ChangedPixels))
+			.arg(100.0 * Statistics.ChangedPixels / Statistics.PixelCount, 0, 'f', 2)
+			.arg(Statistics.psnr(), 0, 'f', 1)
+		: tr("Identical");
+	Text += tr("  (%1 ms)").arg(ElapsedMs);
+	if (ReferenceSize != TestSize)
+	{
+		Text += tr("\nSizes differ: %1 x %2 and %3 x %4, compared the top left area")
+			.arg(ReferenceSize.width()).arg(ReferenceSize.height())
+			.arg(TestSize.width()).arg(TestSize.height());
+	}
+	d->showSummary(Text);
+}
+
+
+//============================================================================
+bool CImageCompare::eventFilter(QObject* Object, QEvent* Event)
+{
+	if (Object == d->Viewport.data() && Event->type() == QEvent::Resize)
+	{
+		d->placeSummary();
+	}
+	return QObject::eventFilter(Object, Event);
+}
+
+//---------------------------------------------------------------------------
+// EOF ImageCompare.cpp
@@ -0,0 +1,86 @@
+#ifndef ImageCompareH
+#define ImageCompareH
+//============================================================================
+/// \file   ImageCompare.h
+/// \brief  Declaration of CImageCompare
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QObject>
+
+#include "ImageDiff.h"
+
+class CImageViewer;
+struct ImageComparePrivate;
+
+/**
+ * @brief Compares the images of two image viewers.
+ *
+ * Pan and zoom of both viewers are kept in sync. The test viewer shows a
+ * heatmap of the pixels that differ from the reference image and a summary
+ * with the largest channel difference, the number of changed pixels and
+ * the PSNR. Images of different size are compared where they overlap,
+ * aligned at their top left corner.
+ *
+ * The difference is computed with diffRgb32() in tiles of TileSize pixels,
+ * taken by one job per core on the global thread pool. It is computed again
+ * whenever one of the viewers shows another image. The comparison ends when
+ * this object or one of the viewers is deleted.
+ */
+class CImageCompare : public QObject
+{
+	Q_OBJECT
+public:
+	static constexpr int TileSize = 512;
+
+	CImageCompare(CImageViewer* Reference, CImageViewer* Test,
+		QObject* Parent = nullptr);
+
+	/**
+	 * Removes the heatmap and the summary from the test viewer
+	 */
+	virtual ~CImageCompare();
+
+	CImageViewer* referenceViewer() const;
+	CImageViewer* testViewer() const;
+
+	/**
+	 * @brief Channel differences up to Threshold do not count as changes.
+	 * Defaults to 0.
+	 */
+	void setThreshold(int Threshold);
+	int threshold() const;
+
+	/**
+	 * @brief Statistics of the last finished comparison
+	 */
+	SImageDiffStatistics statistics() const;
+
+public slots:
+	/**
+	 * @brief Starts comparing the current images, canceling a running
+	 * comparison.
+	 */
+	void compare();
+
+protected:
+	/**
+	 * @brief Keeps the summary at the bottom left of the test viewer.
+	 */
+	bool eventFilter(QObject* Object, QEvent* Event) override;
+
+private slots:
+	/**
+	 * @brief Shows the result of the running comparison.
+	 */
+	void onDiffReady();
+
+private:
+	ImageComparePrivate* d;
+	friend struct ImageComparePrivate;
+}; // class CImageCompare
+
+//---------------------------------------------------------------------------
+#endif // ImageCompareH
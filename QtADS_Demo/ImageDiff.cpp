@@ -0,0 +1,232 @@
+//============================================================================
+/// \file   ImageDiff.cpp
+/// \brief  Implementation of the image difference kernels
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ImageDiff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_DIFF_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+/**
+ * Heatmap colors by the largest channel difference of a pixel. The square
+ * root spreads the small differences typical for rendering changes over
+ * more of the yellow to red ramp.
+ */
+void buildHeatmapLookup(int Threshold, uint32_t* Lookup)
+{
+	for (int Delta = 0; Delta < 256; ++Delta)
+	{
+		if (Delta <= Threshold)
+		{
+			Lookup[Delta] = 0;
+			continue;
+		}
+		uint32_t Alpha = 160 + Delta * 95 / 255;
+		uint32_t Green = 255 - uint32_t(std::sqrt(Delta * 255.0));
+		Lookup[Delta] = (Alpha << 24) | (Alpha << 16) | ((Green * Alpha / 255) << 8);
+	}
+}
+
+void diffRowScalar(const uint32_t* A, const uint32_t* B, uint32_t* Heatmap,
+	int Begin, int Width, int Threshold, const uint32_t* Lookup,
+	SImageDiffStatistics& Statistics)
+{
+	for (int x = Begin; x < Width; ++x)
+	{
+		int Red = abs(int((A[x] >> 16) & 0xff) - int((B[x] >> 16) & 0xff));
+		int Green = abs(int((A[x] >> 8) & 0xff) - int((B[x] >> 8) & 0xff));
+		int Blue = abs(int(A[x] & 0xff) - int(B[x] & 0xff));
+		int Delta = std::max(Red, std::max(Green, Blue));
+		Statistics.SquaredError += uint64_t(Red * Red + Green * Green + Blue * Blue);
+		Statistics.MaxDelta = std::max(Statistics.MaxDelta, Delta);
+		Statistics.ChangedPixels += (Delta > Threshold) ? 1 : 0;
+		Heatmap[x] = Lookup[Delta];
+	}
+}
+
+void halveRowScalar(const uint32_t* Line0, const uint32_t* Line1,
+	uint32_t* Target, int Begin, int Width)
+{
+	for (int x = Begin; x < Width; ++x)
+	{
+		uint32_t Result = 0;
+		for (int Shift = 0; Shift < 32; Shift += 8)
+		{
+			uint32_t Channel = std::max(
+				std::max((Line0[2 * x] >> Shift) & 0xff, (Line0[2 * x + 1] >> Shift) & 0xff),
+				std::max((Line1[2 * x] >> Shift) & 0xff, (Line1[2 * x + 1] >> Shift) & 0xff));
+			Result |= Channel << Shift;
+		}
+		Target[x] = Result;
+	}
+}
+
+#ifdef IMAGE_DIFF_SSE2
+/**
+ * Compares 4 pixels per iteration and returns the number of pixels compared
+ */
+int diffRowSse2(const uint32_t* A, const uint32_t* B, uint32_t* Heatmap,
+	int Width, int Threshold, const uint32_t* Lookup,
+	SImageDiffStatistics& Statistics)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i ColorMask = _mm_set1_epi32(0x00ffffff);
+	const __m128i LowByte = _mm_set1_epi32(0xff);
+	const __m128i ThresholdVector = _mm_set1_epi32(Threshold);
+	// Each lane of the sums of squares grows by at most 4 * 255^2 per
+	// iteration, 4096 iterations stay far below 2^32
+	const int FlushPixels = 4 * 4096;
+	__m128i MaxDelta = Zero;
+	__m128i Changed = Zero;
+	alignas(16) uint32_t Lanes[4];
+
+	int x = 0;
+	while (x + 4 <= Width)
+	{
+		const int End = std::min(Width, x + FlushPixels);
+		__m128i Squares = Zero;
+		for (; x + 4 <= End; x += 4)
+		{
+			__m128i PixelsA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(A + x));
+			__m128i PixelsB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(B + x));
+			__m128i Difference = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(PixelsA, PixelsB),
+				_mm_subs_epu8(PixelsB, PixelsA)), ColorMask);
+
+			__m128i Low = _mm_unpacklo_epi8(Difference, Zero);
+			__m128i High = _mm_unpackhi_epi8(Difference, Zero);
+			Squares = _mm_add_epi32(Squares, _mm_add_epi32(_mm_madd_epi16(Low, Low),
+				_mm_madd_epi16(High, High)));
+
+			// Blue, green and red are bytes 0, 1 and 2 of each pixel
+			__m128i Delta = _mm_max_epu8(Difference, _mm_srli_epi32(Difference, 8));
+			Delta = _mm_and_si128(_mm_max_epu8(Delta, _mm_srli_epi32(Difference, 16)), LowByte);
+			MaxDelta = _mm_max_epu8(MaxDelta, Delta);
+			Changed = _mm_sub_epi32(Changed, _mm_cmpgt_epi32(Delta, ThresholdVector));
+
+			_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), Delta);
+			Heatmap[x] = Lookup[Lanes[0]];
+			Heatmap[x + 1] = Lookup[Lanes[1]];
+			Heatmap[x + 2] = Lookup[Lanes[2]];
+			Heatmap[x + 3] = Lookup[Lanes[3]];
+		}
+		_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), Squares);
+		Statistics.SquaredError += uint64_t(Lanes[0]) + Lanes[1] + Lanes[2] + Lanes[3];
+	}
+
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), MaxDelta);
+	Statistics.MaxDelta = std::max(Statistics.MaxDelta, int(std::max(
+		std::max(Lanes[0], Lanes[1]), std::max(Lanes[2], Lanes[3]))));
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), Changed);
+	Statistics.ChangedPixels += uint64_t(Lanes[0]) + Lanes[1] + Lanes[2] + Lanes[3];
+	return x;
+}
+
+/**
+ * Halves 4 source pixels per iteration and returns the number of target
+ * pixels written
+ */
+int halveRowSse2(const uint32_t* Line0, const uint32_t* Line1,
+	uint32_t* Target, int Width)
+{
+	int x = 0;
+	for (; x + 2 <= Width; x += 2)
+	{
+		__m128i Vertical = _mm_max_epu8(
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(Line0 + 2 * x)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(Line1 + 2 * x)));
+		// The maxima of the pixel pairs end up in lanes 0 and 2
+		__m128i Pairs = _mm_max_epu8(Vertical, _mm_srli_si128(Vertical, 4));
+		Pairs = _mm_shuffle_epi32(Pairs, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(Target + x), Pairs);
+	}
+	return x;
+}
+#endif
+} // namespace
+
+
+//============================================================================
+void SImageDiffStatistics::add(const SImageDiffStatistics& Other)
+{
+	MaxDelta = std::max(MaxDelta, Other.MaxDelta);
+	ChangedPixels += Other.ChangedPixels;
+	SquaredError += Other.SquaredError;
+	PixelCount += Other.PixelCount;
+}
+
+
+//============================================================================
+double SImageDiffStatistics::psnr() const
+{
+	if (!SquaredError || !PixelCount)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+	double MeanSquaredError = double(SquaredError) / (3.0 * PixelCount);
+	return 10 * std::log10(255.0 * 255.0 / MeanSquaredError);
+}
+
+
+//============================================================================
+void diffRgb32(const uint32_t* A, ptrdiff_t AStride, const uint32_t* B,
+	ptrdiff_t BStride, uint32_t* Heatmap, ptrdiff_t HeatmapStride,
+	int Width, int Height, int Threshold, SImageDiffStatistics& Statistics)
+{
+	uint32_t Lookup[256];
+	buildHeatmapLookup(Threshold, Lookup);
+	for (int Row = 0; Row < Height; ++Row)
+	{
+		const uint32_t* LineA = reinterpret_cast<const uint32_t*>(
+			reinterpret_cast<const uint8_t*>(A) + Row * AStride);
+		const uint32_t* LineB = reinterpret_cast<const uint32_t*>(
+			reinterpret_cast<const uint8_t*>(B) + Row * BStride);
+		uint32_t* Line = reinterpret_cast<uint32_t*>(
+			reinterpret_cast<uint8_t*>(Heatmap) + Row * HeatmapStride);
+		int Compared = 0;
+#ifdef IMAGE_DIFF_SSE2
+		Compared = diffRowSse2(LineA, LineB, Line, Width, Threshold, Lookup, Statistics);
+#endif
+		diffRowScalar(LineA, LineB, Line, Compared, Width, Threshold, Lookup, Statistics);
+	}
+	Statistics.PixelCount += uint64_t(Width) * uint64_t(Height);
+}
+
+
+//============================================================================
+void halveByMaximum(const uint32_t* Source, ptrdiff_t SourceStride,
+	int Width, int Height, uint32_t* Target, ptrdiff_t TargetStride)
+{
+	const int TargetWidth = Width / 2;
+	for (int Row = 0; Row < Height / 2; ++Row)
+	{
+		const uint32_t* Line0 = reinterpret_cast<const uint32_t*>(
+			reinterpret_cast<const uint8_t*>(Source) + 2 * Row * SourceStride);
+		const uint32_t* Line1 = reinterpret_cast<const uint32_t*>(
+			reinterpret_cast<const uint8_t*>(Line0) + SourceStride);
+		uint32_t* Line = reinterpret_cast<uint32_t*>(
+			reinterpret_cast<uint8_t*>(Target) + Row * TargetStride);
+		int Halved = 0;
+#ifdef IMAGE_DIFF_SSE2
+		Halved = halveRowSse2(Line0, Line1, Line, TargetWidth);
+#endif
+		halveRowScalar(Line0, Line1, Line, Halved, TargetWidth);
+	}
+}
+
+//---------------------------------------------------------------------------
+// EOF ImageDiff.cpp
@@ -0,0 +1,60 @@
+#ifndef ImageDiffH
+#define ImageDiffH
+//============================================================================
+/// \file   ImageDiff.h
+/// \brief  Declaration of the image difference kernels
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Summary of the differences between two images
+ *
+ * Only red, green and blue are compared, alpha is ignored.
+ */
+struct SImageDiffStatistics
+{
+	int MaxDelta = 0;///< largest difference of a channel
+	uint64_t ChangedPixels = 0;///< pixels with a channel differing by more than the threshold
+	uint64_t SquaredError = 0;///< sum of the squared channel differences
+	uint64_t PixelCount = 0;
+
+	void add(const SImageDiffStatistics& Other);
+
+	/**
+	 * @brief Peak signal to noise ratio in dB, infinite for equal images
+	 */
+	double psnr() const;
+};
+
+/**
+ * @brief Compares two images of 32 bit 0xAARRGGBB pixels and writes a
+ * heatmap of the differences.
+ *
+ * Heatmap pixels are premultiplied ARGB: transparent where no channel
+ * differs by more than Threshold, yellow to red with growing difference
+ * otherwise. The statistics of the area are added to Statistics.
+ * All strides are in bytes.
+ *
+ * Uses SSE2 where available. The SIMD and the scalar path produce identical
+ * results.
+ */
+void diffRgb32(const uint32_t* A, ptrdiff_t AStride, const uint32_t* B,
+	ptrdiff_t BStride, uint32_t* Heatmap, ptrdiff_t HeatmapStride,
+	int Width, int Height, int Threshold, SImageDiffStatistics& Statistics);
+
+/**
+ * @brief Halves a heatmap, each target pixel is the channel wise maximum of
+ * the 2 x 2 source pixels it covers, so single changed pixels stay visible
+ * when zoomed out. The target is Width / 2 x Height / 2 pixels.
+ */
+void halveByMaximum(const uint32_t* Source, ptrdiff_t SourceStride,
+	int Width, int Height, uint32_t* Target, ptrdiff_t TargetStride);
+
+//---------------------------------------------------------------------------
+#endif // ImageDiffH
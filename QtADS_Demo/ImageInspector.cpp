@@ -0,0 +1,154 @@
+//============================================================================
+/// \file   ImageInspector.cpp
+/// \brief  Implementation of CImageInspector
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ImageInspector.h"
+
+#include <QPainter>
+#include <QPainterPath>
+
+
+namespace
+{
+const int Margin = 8;
+const int HistogramHeight = 80;
+
+/**
+ * Alpha is only shown if the image has transparent pixels
+ */
+bool showsAlpha(const SImageStatistics& Statistics)
+{
+	return Statistics.PixelCount
+		&& Statistics.minimum(SImageStatistics::Alpha) < 255;
+}
+} // namespace
+
+
+//============================================================================
+CImageInspector::CImageInspector(QWidget* Parent)
+	: QWidget(Parent)
+{
+	this->setAttribute(Qt::WA_TransparentForMouseEvents);
+	this->setFixedSize(256 + 2 * Margin, 220);
+}
+
+
+//============================================================================
+void CImageInspector::setPixel(const QPoint& Pos, QRgb Pixel, bool Valid)
+{
+	if (m_PixelValid == Valid && (!Valid || (m_PixelPos == Pos && m_Pixel == Pixel)))
+	{
+		return;
+	}
+	m_PixelPos = Pos;
+	m_Pixel = Pixel;
+	m_PixelValid = Valid;
+	this->update();
+}
+
+
+//============================================================================
+void CImageInspector::setStatistics(const SImageStatistics& Statistics,
+	const QString& AreaText, bool Approximate)
+{
+	m_Statistics = Statistics;
+	m_AreaText = AreaText;
+	m_Approximate = Approximate;
+	this->update();
+}
+
+
+//============================================================================
+void CImageInspector::paintEvent(QPaintEvent* Event)
+{
+	Q_UNUSED(Event);
+	QPainter Painter(this);
+	Painter.setRenderHint(QPainter::Antialiasing, true);
+	Painter.setPen(Qt::NoPen);
+	Painter.setBrush(QColor(0, 0, 0, 180));
+	Painter.drawRoundedRect(this->rect(), 4, 4);
+
+	const bool Alpha = showsAlpha(m_Statistics);
+	const int ChannelCount = Alpha ? 4 : 3;
+	const QColor Colors[] = {QColor(255, 80, 80), QColor(80, 220, 80),
+		QColor(100, 140, 255), QColor(200, 200, 200)};
+	const char* Names[] = {"R", "G", "B", "A"};
+
+	// Histograms, scaled to the largest bin that is not clipped, so a few
+	// saturated pixels do not flatten everything else
+	QRect HistogramRect(Margin, Margin, 256, HistogramHeight);
+	quint32 Largest = 1;
+	for (int Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		for (int Value = 1; Value < 255; ++Value)
+		{
+			Largest = qMax(Largest, m_Statistics.Histogram[Channel][Value]);
+		}
+	}
+	Painter.setBrush(Qt::NoBrush);
+	for (int Channel = 0; Channel < ChannelCount && m_Statistics.PixelCount; ++Channel)
+	{
+		QPainterPath Path;
+		for (int Value = 0; Value < 256; ++Value)
+		{
+			double Height = qMin(1.0, double(m_Statistics.Histogram[Channel][Value]) / Largest);
+			QPointF Point(HistogramRect.left() + Value + 0.5,
+				HistogramRect.bottom() - Height * (HistogramHeight - 1));
+			if (Value)
+			{
+				Path.lineTo(Point);
+			}
+			else
+			{
+				Path.moveTo(Point);
+			}
+		}
+		Painter.setPen(Colors[Channel]);
+		Painter.drawPath(Path);
+	}
+
+	Painter.setRenderHint(QPainter::Antialiasing, false);
+	const int LineHeight = this->fontMetrics().height();
+	int y = HistogramRect.bottom() + Margin + this->fontMetrics().ascent();
+	Painter.setPen(Qt::white);
+	if (m_PixelValid)
+	{
+		QString Text = tr("%1, %2:  R %3  G %4  B %5").arg(m_PixelPos.x())
+			.arg(m_PixelPos.y()).arg(qRed(m_Pixel)).arg(qGreen(m_Pixel))
+			.arg(qBlue(m_Pixel));
+		if (Alpha)
+		{
+			Text += tr("  A %1").arg(qAlpha(m_Pixel));
+		}
+		Painter.drawText(Margin, y, Text);
+	}
+	y += LineHeight;
+	Painter.drawText(Margin, y, m_Approximate ? tr("%1 (approx.)").arg(m_AreaText)
+		: m_AreaText);
+	y += LineHeight;
+
+	if (!m_Statistics.PixelCount)
+	{
+		return;
+	}
+	for (int Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		Painter.setPen(Colors[Channel]);
+		Painter.drawText(Margin, y, tr("%1  min %2  max %3  mean %4  clip %5/%6")
+			.arg(QLatin1String(Names[Channel]))
+			.arg(m_Statistics.minimum(Channel))
+			.arg(m_Statistics.maximum(Channel))
+			.arg(m_Statistics.mean(Channel), 0, 'f', 1)
+			.arg(m_Statistics.clippedLow(Channel))
+			.arg(m_Statistics.clippedHigh(Channel)));
+		y += LineHeight;
+	}
+}
+
+//---------------------------------------------------------------------------
+// EOF ImageInspector.cpp
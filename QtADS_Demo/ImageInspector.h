@@ -0,0 +1,58 @@
+#ifndef ImageInspectorH
+#define ImageInspectorH
+//============================================================================
+/// \file   ImageInspector.h
+/// \brief  Declaration of CImageInspector
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QWidget>
+
+#include "ImageStatistics.h"
+
+
+/**
+ * @brief Overlay showing the pixel under the cursor and the histograms,
+ * minimum, maximum, mean and clipped pixel counts of an image area.
+ *
+ * Only displays values, CImageViewer computes them. Transparent for mouse
+ * events, so the image below stays usable.
+ */
+class CImageInspector : public QWidget
+{
+	Q_OBJECT
+private:
+	SImageStatistics m_Statistics;
+	QString m_AreaText;
+	bool m_Approximate = false;
+	QPoint m_PixelPos;
+	QRgb m_Pixel = 0;
+	bool m_PixelValid = false;
+
+protected:
+	void paintEvent(QPaintEvent* Event) override;
+
+public:
+	explicit CImageInspector(QWidget* Parent);
+
+	/**
+	 * @brief Shows the value of the pixel at Pos in image coordinates.
+	 * Valid is false if the cursor is outside the image or the pixel is
+	 * not decoded yet.
+	 */
+	void setPixel(const QPoint& Pos, QRgb Pixel, bool Valid);
+
+	/**
+	 * @brief Shows the statistics of an area.
+	 * @param[in] AreaText Description of the area, i.e. its rectangle
+	 * @param[in] Approximate True if the statistics come from a downscaled
+	 * image
+	 */
+	void setStatistics(const SImageStatistics& Statistics,
+		const QString& AreaText, bool Approximate);
+}; // class CImageInspector
+
+//---------------------------------------------------------------------------
+#endif // ImageInspectorH
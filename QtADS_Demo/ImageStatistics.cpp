@@ -0,0 +1,232 @@
+//============================================================================
+/// \file   ImageStatistics.cpp
+/// \brief  Implementation of the image statistics kernels
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ImageStatistics.h"
+
+#include <string.h>
+
+
+//============================================================================
+void SImageStatistics::clear()
+{
+	memset(Histogram, 0, sizeof(Histogram));
+	PixelCount = 0;
+}
+
+
+//============================================================================
+void SImageStatistics::add(const SImageStatistics& Other)
+{
+	for (int Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		for (int Value = 0; Value < 256; ++Value)
+		{
+			Histogram[Channel][Value] += Other.Histogram[Channel][Value];
+		}
+	}
+	PixelCount += Other.PixelCount;
+}
+
+
+//============================================================================
+int SImageStatistics::minimum(int Channel) const
+{
+	for (int Value = 0; Value < 256; ++Value)
+	{
+		if (Histogram[Channel][Value])
+		{
+			return Value;
+		}
+	}
+	return -1;
+}
+
+
+//============================================================================
+int SImageStatistics::maximum(int Channel) const
+{
+	for (int Value = 255; Value >= 0; --Value)
+	{
+		if (Histogram[Channel][Value])
+		{
+			return Value;
+		}
+	}
+	return -1;
+}
+
+
+//============================================================================
+double SImageStatistics::mean(int Channel) const
+{
+	if (!PixelCount)
+	{
+		return 0;
+	}
+	quint64 Sum = 0;
+	for (int Value = 1; Value < 256; ++Value)
+	{
+		Sum += quint64(Histogram[Channel][Value]) * Value;
+	}
+	return double(Sum) / PixelCount;
+}
+
+
+//============================================================================
+void accumulateImageStatistics(const QImage& Image, const QRect& Rect,
+	SImageStatistics& Statistics)
+{
+	QRect Area = Rect & Image.rect();
+	if (Area.isEmpty() || Image.depth() != 32)
+	{
+		return;
+	}
+
+	// Counting into one table per channel makes runs of equal pixels wait
+	// for the increment of the previous pixel. Alternating pixels between
+	// two tables halves that dependency chain; the tables fit into L1.
+	static_assert(SImageStatistics::ChannelCount == 4, "one table per byte");
+	quint32 Tables[2][4][256];
+	memset(Tables, 0, sizeof(Tables));
+	const int Width = Area.width();
+	for (int y = Area.top(); y <= Area.bottom(); ++y)
+	{
+		const quint32* Line = reinterpret_cast<const quint32*>(
+			Image.constScanLine(y)) + Area.left();
+		int x = 0;
+		for (; x + 2 <= Width; x += 2)
+		{
+			quint32 First = Line[x];
+			quint32 Second = Line[x + 1];
+			++Tables[0][SImageStatistics::Red][(First >> 16) & 0xff];
+			++Tables[0][SImageStatistics::Green][(First >> 8) & 0xff];
+			++Tables[0][SImageStatistics::Blue][First & 0xff];
+			++Tables[0][SImageStatistics::Alpha][First >> 24];
+			++Tables[1][SImageStatistics::Red][(Second >> 16) & 0xff];
+			++Tables[1][SImageStatistics::Green][(Second >> 8) & 0xff];
+			++Tables[1][SImageStatistics::Blue][Second & 0xff];
+			++Tables[1][SImageStatistics::Alpha][Second >> 24];
+		}
+		if (x < Width)
+		{
+			quint32 Pixel = Line[x];
+			++Tables[0][SImageStatistics::Red][(Pixel >> 16) & 0xff];
+			++Tables[0][SImageStatistics::Green][(Pixel >> 8) & 0xff];
+			++Tables[0][SImageStatistics::Blue][Pixel & 0xff];
+			++Tables[0][SImageStatistics::Alpha][Pixel >> 24];
+		}
+	}
+
+	for (int Channel = 0; Channel < SImageStatistics::ChannelCount; ++Channel)
+	{
+		for (int Value = 0; Value < 256; ++Value)
+		{
+			Statistics.Histogram[Channel][Value] += Tables[0][Channel][Value]
+				+ Tables[1][Channel][Value];
+		}
+	}
+	Statistics.PixelCount += quint64(Area.width()) * Area.height();
+}
+
+
+//============================================================================
+void CBlockStatisticsCache::reset(const QImage& Image)
+{
+	m_ImageKey = Image.cacheKey();
+	m_ImageSize = Image.size();
+	m_Columns = (Image.width() + BlockSize - 1) / BlockSize;
+	int Rows = (Image.height() + BlockSize - 1) / BlockSize;
+	m_Blocks.clear();
+	m_Blocks.resize(size_t(m_Columns) * Rows);
+}
+
+
+//============================================================================
+const SImageStatistics& CBlockStatisticsCache::block(const QImage& Image,
+	int Column, int Row)
+{
+	std::unique_ptr<SImageStatistics>& Block = m_Blocks[size_t(Row) * m_Columns + Column];
+	if (!Block)
+	{
+		Block.reset(new SImageStatistics);
+		accumulateImageStatistics(Image, QRect(Column * BlockSize, Row * BlockSize,
+			BlockSize, BlockSize), *Block);
+	}
+	return *Block;
+}
+
+
+//============================================================================
+bool CBlockStatisticsCache::compute(const QImage& Image, const QRect& Rect,
+	SImageStatistics& Statistics, const std::atomic<bool>* Canceled)
+{
+	Statistics.clear();
+	QRect Area = Rect & Image.rect();
+	if (Area.isEmpty())
+	{
+		return true;
+	}
+	if (Image.cacheKey() != m_ImageKey || Image.size() != m_ImageSize)
+	{
+		reset(Image);
+	}
+
+	// Blocks completely inside the area; blocks at the right and bottom
+	// image edge are smaller and count as inside if the area reaches the edge
+	int FirstColumn = (Area.left() + BlockSize - 1) / BlockSize;
+	int FirstRow = (Area.top() + BlockSize - 1) / BlockSize;
+	int EndColumn = (Area.right() == Image.width() - 1) ? m_Columns
+		: (Area.right() + 1) / BlockSize;
+	int EndRow = (Area.bottom() == Image.height() - 1)
+		? int(m_Blocks.size()) / m_Columns : (Area.bottom() + 1) / BlockSize;
+	if (FirstColumn >= EndColumn || FirstRow >= EndRow)
+	{
+		accumulateImageStatistics(Image, Area, Statistics);
+		return !(Canceled && Canceled->load());
+	}
+
+	for (int Row = FirstRow; Row < EndRow; ++Row)
+	{
+		if (Canceled && Canceled->load())
+		{
+			return false;
+		}
+		for (int Column = FirstColumn; Column < EndColumn; ++Column)
+		{
+			Statistics.add(block(Image, Column, Row));
+		}
+	}
+
+	// The partially covered border: full width strips above and below the
+	// blocks, short strips left and right of them
+	QRect Inner = QRect(QPoint(FirstColumn * BlockSize, FirstRow * BlockSize),
+		QPoint(EndColumn * BlockSize - 1, EndRow * BlockSize - 1)) & Area;
+	accumulateImageStatistics(Image, QRect(QPoint(Area.left(), Area.top()),
+		QPoint(Area.right(), Inner.top() - 1)), Statistics);
+	accumulateImageStatistics(Image, QRect(QPoint(Area.left(), Inner.bottom() + 1),
+		QPoint(Area.right(), Area.bottom())), Statistics);
+	accumulateImageStatistics(Image, QRect(QPoint(Area.left(), Inner.top()),
+		QPoint(Inner.left() - 1, Inner.bottom())), Statistics);
+	accumulateImageStatistics(Image, QRect(QPoint(Inner.right() + 1, Inner.top()),
+		QPoint(Area.right(), Inner.bottom())), Statistics);
+	return !(Canceled && Canceled->load());
+}
+
+
+//============================================================================
+void CBlockStatisticsCache::clear()
+{
+	m_ImageKey = 0;
+	m_ImageSize = QSize();
+	m_Columns = 0;
+	m_Blocks.clear();
+}
+
+//---------------------------------------------------------------------------
+// EOF ImageStatistics.cpp
@@ -0,0 +1,122 @@
+#ifndef ImageStatisticsH
+#define ImageStatisticsH
+//============================================================================
+/// \file   ImageStatistics.h
+/// \brief  Declaration of the image statistics kernels
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QImage>
+#include <QRect>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+/**
+ * @brief Per channel histograms of an image area.
+ *
+ * Minimum, maximum, mean and the number of clipped pixels are derived from
+ * the histograms, so statistics of areas combine by adding histograms.
+ */
+struct SImageStatistics
+{
+	enum eChannel
+	{
+		Red,
+		Green,
+		Blue,
+		Alpha,
+		ChannelCount
+	};
+
+	quint32 Histogram[ChannelCount][256];
+	quint64 PixelCount;
+
+	SImageStatistics() { clear(); }
+
+	void clear();
+
+	/**
+	 * @brief Adds the histograms of another, disjoint area.
+	 */
+	void add(const SImageStatistics& Other);
+
+	/**
+	 * @brief Smallest value of the channel, -1 if there are no pixels
+	 */
+	int minimum(int Channel) const;
+
+	/**
+	 * @brief Largest value of the channel, -1 if there are no pixels
+	 */
+	int maximum(int Channel) const;
+
+	double mean(int Channel) const;
+
+	/**
+	 * @brief Number of pixels with the channel at 0
+	 */
+	quint32 clippedLow(int Channel) const {return Histogram[Channel][0];}
+
+	/**
+	 * @brief Number of pixels with the channel at 255
+	 */
+	quint32 clippedHigh(int Channel) const {return Histogram[Channel][255];}
+};
+
+/**
+ * @brief Adds the pixels of Rect to Statistics.
+ * The image must have 32 bit 0xAARRGGBB pixels, i.e. Format_RGB32 or
+ * Format_ARGB32(_Premultiplied). Premultiplied pixels are counted as stored.
+ */
+void accumulateImageStatistics(const QImage& Image, const QRect& Rect,
+	SImageStatistics& Statistics);
+
+/**
+ * @brief Computes statistics of image areas incrementally.
+ *
+ * The image is divided into blocks of BlockSize pixels. The histograms of
+ * blocks lying completely inside a requested area are computed once and
+ * kept, only the partially covered blocks along its border are read again.
+ * So changing a selection or scrolling costs about the border of the area,
+ * not its size. The kept blocks belong to one image and are dropped when
+ * another image is passed.
+ *
+ * Not thread safe, use one cache per thread.
+ */
+class CBlockStatisticsCache
+{
+public:
+	static constexpr int BlockSize = 256;
+
+private:
+	qint64 m_ImageKey = 0;
+	QSize m_ImageSize;
+	int m_Columns = 0;
+	std::vector<std::unique_ptr<SImageStatistics>> m_Blocks;
+
+	void reset(const QImage& Image);
+	const SImageStatistics& block(const QImage& Image, int Column, int Row);
+
+public:
+	/**
+	 * @brief Computes the statistics of Rect of Image into Statistics.
+	 * Returns false if Canceled was set meanwhile; Statistics is incomplete
+	 * then, the kept blocks stay valid.
+	 */
+	bool compute(const QImage& Image, const QRect& Rect,
+		SImageStatistics& Statistics,
+		const std::atomic<bool>* Canceled = nullptr);
+
+	/**
+	 * @brief Drops all kept blocks.
+	 */
+	void clear();
+}; // class CBlockStatisticsCache
+
+//---------------------------------------------------------------------------
+#endif // ImageStatisticsH
@@ -9,6 +9,7 @@
 //                                   INCLUDES
 //============================================================================
 #include "ImageViewer.h"
+#include "CancelableFile.h"
 
 #include <math.h>
 
@@ -18,7 +19,9 @@
 #include <QMessageBox>
 #include <QApplication>
 #include <QDir>
+#include <QFile>
 #include <QFileDialog>
+#include <QGestureEvent>
 #include <QStandardPaths>
 #include <QAction>
 #include <QScrollBar>
@@ -26,9 +29,248 @@
 #include <QPainter>
 #include <QImage>
 #include <QMouseEvent>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNativeGestureEvent>
+#include <QRubberBand>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
+#include <QTransform>
 #include <QWheelEvent>
 
+#include <atomic>
+#include <memory>
+
+#include "ImageCache.h"
+#include "ImageInspector.h"
+#include "ImageStatistics.h"
 #include "RenderWidget.h"
+#include "TiledImage.h"
+#include "VideoFileSource.h"
+
+/**
+ * State of one loadFileAsync() call, shared with its job. Viewer is reset
+ * when the load is canceled, so a job finishing later does not post to a
+ * deleted viewer.
+ */
+struct ImageLoadState
+{
+	QMutex Mutex;
+	CImageViewer* Viewer;
+	QString FileName;
+	std::atomic<bool> Canceled{false};
+	QImage Preview;
+	QSize DisplaySize;///< size of the full image, after auto transform
+	QImage Image;
+	QString ErrorString;
+	bool Finished = false;
+
+	ImageLoadState(CImageViewer* _Viewer, const QString& _FileName)
+		: Viewer(_Viewer), FileName(_FileName) {}
+};
+
+
+/**
+ * Statistics jobs of one viewer, which run one at a time and so share the
+ * block cache. Viewer is reset when the viewer is deleted.
+ */
+struct ImageStatisticsState
+{
+	QMutex Mutex;
+	CImageViewer* Viewer;
+	std::atomic<bool> Canceled{false};
+	CBlockStatisticsCache Cache;///< only used by the running job
+	SImageStatistics Statistics;///< result waiting for onStatisticsReady()
+
+	ImageStatisticsState(CImageViewer* _Viewer) : Viewer(_Viewer) {}
+};
+
+
+namespace
+{
+/// Statistics are recomputed at most this often while the area changes
+const int StatisticsIntervalMs = 33;
+/// The zoom preview is updated at most this often
+const int ZoomIntervalMs = 16;
+/// Zooming counts as paused after this long without zoom steps
+const int ZoomSettleMs = 150;
+
+/// Previews are decoded for images larger than twice this size
+const QSize PreviewSize(1024, 1024);
+
+/**
+ * Decodes the preview and the full image of one load
+ */
+class CImageLoadJob : public QRunnable
+{
+private:
+	std::shared_ptr<ImageLoadState> m_State;
+
+	/**
+	 * Posts Slot to the viewer unless the load was canceled
+	 */
+	void post(const char* Slot)
+	{
+		QMutexLocker Lock(&m_State->Mutex);
+		if (m_State->Viewer && !m_State->Canceled)
+		{
+			QMetaObject::invokeMethod(m_State->Viewer, Slot, Qt::QueuedConnection);
+		}
+	}
+
+public:
+	explicit CImageLoadJob(std::shared_ptr<ImageLoadState> State)
+		: m_State(std::move(State))
+	{
+	}
+
+	void run() override
+	{
+		CCancelableFile File(m_State->FileName, &m_State->Canceled);
+		QImage Image;
+		QString ErrorString;
+		if (!File.open(QIODevice::ReadOnly))
+		{
+			ErrorString = File.errorString();
+		}
+		else
+		{
+			QImageReader Reader(&File);
+			Reader.setAutoTransform(true);
+			QSize Size = Reader.size();
+			QSize DisplaySize = Size;
+			if (Reader.transformation() & QImageIOHandler::TransformationRotate90)
+			{
+				DisplaySize.transpose();
+			}
+
+			// Only handlers that scale while decoding make previews cheap
+			if (Size.width() > 2 * PreviewSize.width()
+			 || Size.height() > 2 * PreviewSize.height())
+			{
+				if (Reader.supportsOption(QImageIOHandler::ScaledSize))
+				{
+					Reader.setScaledSize(Size.scaled(PreviewSize, Qt::KeepAspectRatio));
+					QImage Preview = Reader.read();
+					if (!Preview.isNull())
+					{
+						{
+							QMutexLocker Lock(&m_State->Mutex);
+							m_State->Preview = Preview;
+							m_State->DisplaySize = DisplaySize;
+						}
+						post("onPreviewDecoded");
+					}
+				}
+				File.seek(0);
+			}
+
+			if (!m_State->Canceled)
+			{
+				QImageReader FullReader(&File);
+				FullReader.setAutoTransform(true);
+				Image = FullReader.read();
+				ErrorString = FullReader.errorString();
+				if (!Image.isNull())
+				{
+					Image = CImageCache::instance().insert(m_State->FileName,
+						QSize(), 1, Image);
+				}
+			}
+		}
+
+		{
+			QMutexLocker Lock(&m_State->Mutex);
+			m_State->Image = Image;
+			m_State->ErrorString = ErrorString;
+			m_State->Finished = true;
+		}
+		post("onImageDecoded");
+	}
+};
+
+/**
+ * Computes the statistics of an image area
+ */
+class CStatisticsJob : public QRunnable
+{
+private:
+	std::shared_ptr<ImageStatisticsState> m_State;
+	QImage m_Image;
+	QRect m_Area;
+
+public:
+	CStatisticsJob(std::shared_ptr<ImageStatisticsState> State,
+		const QImage& Image, const QRect& Area)
+		: m_State(std::move(State)), m_Image(Image), m_Area(Area)
+	{
+	}
+
+	void run() override
+	{
+		SImageStatistics Statistics;
+		if (!m_State->Cache.compute(m_Image, m_Area, Statistics, &m_State->Canceled))
+		{
+			return;
+		}
+
+		QMutexLocker Lock(&m_State->Mutex);
+		if (!m_State->Viewer)
+		{
+			return;
+		}
+		m_State->Statistics = Statistics;
+		QMetaObject::invokeMethod(m_State->Viewer, "onStatisticsReady",
+			Qt::QueuedConnection);
+	}
+};
+
+
+/**
+ * Covers the viewport with a scaled snapshot of it while zooming, so zoom
+ * steps do not resize the render widget
+ */
+class CZoomPreview : public QWidget
+{
+private:
+	QPixmap m_Snapshot;
+	QTransform m_Transform;
+
+public:
+	explicit CZoomPreview(QWidget* Parent) : QWidget(Parent)
+	{
+		this->setAttribute(Qt::WA_TransparentForMouseEvents);
+		this->setAttribute(Qt::WA_OpaquePaintEvent);
+		this->setBackgroundRole(QPalette::Light);
+		this->setAutoFillBackground(true);
+		this->hide();
+	}
+
+	void setSnapshot(const QPixmap& Snapshot)
+	{
+		m_Snapshot = Snapshot;
+	}
+
+	/**
+	 * Maps snapshot positions to preview positions
+	 */
+	void setTransform(const QTransform& Transform)
+	{
+		m_Transform = Transform;
+		this->update();
+	}
+
+protected:
+	void paintEvent(QPaintEvent*) override
+	{
+		QPainter Painter(this);
+		Painter.setTransform(m_Transform);
+		Painter.drawPixmap(0, 0, m_Snapshot);
+	}
+};
+} // namespace
+
 
 /**
  * Private image viewer data
@@ -37,16 +279,380 @@ struct ImageViewerPrivate
 {
 	CImageViewer* _this;
 	CRenderWidget* RenderWidget;///< renders the image to screen
+	CTiledImage* TiledImage = nullptr;///< image shown in tiles, if too large to decode at once
 	bool AutoFit;///< automatically fit image to window size on resize events
 	QSize ImageSize;///< stores the image size to detect image size changes
 	QPoint MouseMoveStartPos;///< for calculation of mouse move vector
 	QLabel* ScalingLabel;///< label displays scaling factor
 	QList<QWidget*> OverlayTools;///< list of tool widget to overlay
+	std::shared_ptr<ImageLoadState> Load;///< running loadFileAsync()
+	CVideoFileSource* Video = nullptr;///< source of playVideo(), if one was played
+	bool VideoRealTime = true;///< play videos at their frame rate
+	CImageInspector* Inspector = nullptr;///< pixel inspector, created on first use
+	QRubberBand* SelectionBand = nullptr;
+	QRect Selection;///< selected area in image coordinates, empty for the visible area
+	bool Selecting = false;
+	QPoint SelectionStart;///< image position the selection was started at
+	QPoint CursorPos;///< last cursor position in viewport coordinates
+	QTimer* StatisticsTimer = nullptr;///< limits the statistics update rate
+	std::shared_ptr<ImageStatisticsState> Statistics;
+	bool StatisticsRunning = false;
+	bool StatisticsPending = false;///< area changed while a job was running
+	QRect StatisticsArea;///< area of the running job in image coordinates
+	bool StatisticsApproximate = false;
+	QTimer* ZoomTimer = nullptr;///< limits zoom preview updates to one per frame
+	QTimer* ZoomSettleTimer = nullptr;///< applies the zoom when zooming pauses
+	double PendingZoom = 1;///< zoom accumulated since the last preview update
+	QPoint ZoomAnchor;///< viewport position kept in place while zooming
+	CZoomPreview* ZoomPreview = nullptr;///< shown while zooming
+	QTransform ZoomTransform;///< zoom shown by ZoomPreview, in viewport coordinates
 
 	ImageViewerPrivate(CImageViewer* _public) : _this(_public) {}
+
+	bool inspecting() const
+	{
+		return Inspector && Inspector->isVisible();
+	}
+
+	/**
+	 * Image position of a viewport position
+	 */
+	QPoint imagePos(const QPoint& ViewportPos) const;
+
+	/**
+	 * Area of the image visible in the viewport
+	 */
+	QRect visibleImageRect() const;
+
+	/**
+	 * Reads a pixel of the image shown, returns false if it is not available
+	 */
+	bool pixelAt(const QPoint& Pos, QRgb* Pixel) const;
+
+	void placeInspector();
+	void updateSelectionBand();
+	void updatePixel();
+
+	/**
+	 * Starts a statistics job on the next tick of StatisticsTimer
+	 */
+	void scheduleStatistics();
+	void startStatistics();
+
+	/**
+	 * Adds a zoom step around Anchor, a viewport position. The first step
+	 * is shown immediately, further steps within a frame are accumulated.
+	 */
+	void queueZoom(double Zoom, const QPoint& Anchor);
+
+	/**
+	 * Shows the accumulated zoom in the zoom preview
+	 */
+	void applyZoom();
+
+	/**
+	 * Applies the zoom shown in the preview to the render widget, with a
+	 * single relayout, and hides the preview
+	 */
+	void settleZoom();
+
+	/**
+	 * Handles zoom gestures sent to Receiver, returns true if the event
+	 * was one
+	 */
+	bool zoomGesture(QEvent* Event, QWidget* Receiver);
 };
 
 
+//============================================================================
+void ImageViewerPrivate::queueZoom(double Zoom, const QPoint& Anchor)
+{
+	AutoFit = false;
+	PendingZoom *= Zoom;
+	ZoomAnchor = Anchor;
+	if (!ZoomTimer->isActive())
+	{
+		applyZoom();
+	}
+}
+
+
+//============================================================================
+void ImageViewerPrivate::applyZoom()
+{
+	double Zoom = PendingZoom;
+	PendingZoom = 1;
+	if (Zoom == 1)
+	{
+		return;
+	}
+
+	// The render widget keeps its size until zooming pauses, a snapshot of
+	// the viewport is scaled meanwhile
+	if (ZoomPreview->isHidden())
+	{
+		ZoomPreview->setSnapshot(_this->viewport()->grab());
+		ZoomPreview->setGeometry(_this->viewport()->rect());
+		ZoomTransform = QTransform();
+		ZoomPreview->show();
+		ZoomPreview->raise();
+		if (Inspector)
+		{
+			Inspector->raise();
+		}
+	}
+	ZoomTransform *= QTransform(Zoom, 0, 0, Zoom,
+		ZoomAnchor.x() * (1 - Zoom), ZoomAnchor.y() * (1 - Zoom));
+	ZoomPreview->setTransform(ZoomTransform);
+	ZoomSettleTimer->start();
+	ZoomTimer->start();
+}
+
+
+//============================================================================
+void ImageViewerPrivate::settleZoom()
+{
+	if (ZoomPreview->isHidden())
+	{
+		return;
+	}
+	ZoomTimer->stop();
+	ZoomSettleTimer->stop();
+	ZoomTransform *= QTransform(PendingZoom, 0, 0, PendingZoom,
+		ZoomAnchor.x() * (1 - PendingZoom), ZoomAnchor.y() * (1 - PendingZoom));
+	PendingZoom = 1;
+
+	// A widget position P shows at ZoomTransform.map(P) in the preview,
+	// so the widget moves to where the preview shows its origin
+	QPointF Origin = ZoomTransform.map(QPointF(RenderWidget->pos()));
+	RenderWidget->zoomByValue(ZoomTransform.m11());
+	// The scroll area updated the scroll bar ranges while resizing
+	_this->horizontalScrollBar()->setValue(qRound(-Origin.x()));
+	_this->verticalScrollBar()->setValue(qRound(-Origin.y()));
+	ZoomPreview->hide();
+	ZoomPreview->setSnapshot(QPixmap());
+}
+
+
+//============================================================================
+bool ImageViewerPrivate::zoomGesture(QEvent* Event, QWidget* Receiver)
+{
+#ifndef QT_NO_GESTURES
+	if (Event->type() == QEvent::NativeGesture)
+	{
+		auto Gesture = static_cast<QNativeGestureEvent*>(Event);
+		if (Gesture->gestureType() != Qt::ZoomNativeGesture)
+		{
+			return false;
+		}
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+		QPoint Pos = Gesture->position().toPoint();
+#else
+		QPoint Pos = Gesture->pos();
+#endif
+		queueZoom(1 + Gesture->value(), Receiver->mapTo(_this->viewport(), Pos));
+		return true;
+	}
+	if (Event->type() == QEvent::Gesture)
+	{
+		auto GestureEvent = static_cast<QGestureEvent*>(Event);
+		auto Pinch = static_cast<QPinchGesture*>(GestureEvent->gesture(Qt::PinchGesture));
+		if (!Pinch)
+		{
+			return false;
+		}
+		if (Pinch->changeFlags() & QPinchGesture::ScaleFactorChanged)
+		{
+			queueZoom(Pinch->scaleFactor(),
+				_this->viewport()->mapFromGlobal(Pinch->centerPoint().toPoint()));
+		}
+		GestureEvent->accept(Pinch);
+		return true;
+	}
+#else
+	Q_UNUSED(Event);
+	Q_UNUSED(Receiver);
+#endif
+	return false;
+}
+
+
+//============================================================================
+QPoint ImageViewerPrivate::imagePos(const QPoint& ViewportPos) const
+{
+	if (RenderWidget->width() <= 0 || RenderWidget->height() <= 0)
+	{
+		return QPoint(-1, -1);
+	}
+	QPoint Pos = RenderWidget->mapFrom(_this->viewport(), ViewportPos);
+	return QPoint(int(floor(Pos.x() * double(ImageSize.width()) / RenderWidget->width())),
+		int(floor(Pos.y() * double(ImageSize.height()) / RenderWidget->height())));
+}
+
+
+//============================================================================
+QRect ImageViewerPrivate::visibleImageRect() const
+{
+	QRect Visible = QRect(RenderWidget->mapFrom(_this->viewport(), QPoint(0, 0)),
+		_this->viewport()->size()) & RenderWidget->rect();
+	if (Visible.isEmpty())
+	{
+		return QRect();
+	}
+	double ScaleX = double(ImageSize.width()) / RenderWidget->width();
+	double ScaleY = double(ImageSize.height()) / RenderWidget->height();
+	return QRect(QPoint(int(floor(Visible.left() * ScaleX)), int(floor(Visible.top() * ScaleY))),
+		QPoint(int(ceil((Visible.right() + 1) * ScaleX)) - 1,
+			int(ceil((Visible.bottom() + 1) * ScaleY)) - 1))
+		& QRect(QPoint(0, 0), ImageSize);
+}
+
+
+//============================================================================
+bool ImageViewerPrivate::pixelAt(const QPoint& Pos, QRgb* Pixel) const
+{
+	if (!QRect(QPoint(0, 0), ImageSize).contains(Pos))
+	{
+		return false;
+	}
+
+	if (TiledImage)
+	{
+		// The finest level decoded so far
+		for (int Level = 0; Level < TiledImage->levelCount(); ++Level)
+		{
+			QPoint LevelPos(Pos.x() >> Level, Pos.y() >> Level);
+			int Column = LevelPos.x() / CTiledImage::TileSize;
+			int Row = LevelPos.y() / CTiledImage::TileSize;
+			QImage Tile = TiledImage->cachedTile(Level, Column, Row);
+			if (!Tile.isNull())
+			{
+				*Pixel = Tile.pixel(LevelPos - TiledImage->tileRect(Level, Column, Row).topLeft());
+				return true;
+			}
+		}
+		return false;
+	}
+
+	QImage Image = RenderWidget->currentImage();
+	if (Image.isNull())
+	{
+		return false;
+	}
+	// A preview is smaller than the displayed size
+	*Pixel = Image.pixel(Pos.x() * Image.width() / ImageSize.width(),
+		Pos.y() * Image.height() / ImageSize.height());
+	return true;
+}
+
+
+//============================================================================
+void ImageViewerPrivate::placeInspector()
+{
+	if (Inspector)
+	{
+		Inspector->move(_this->viewport()->width() - Inspector->width() - 8, 8);
+	}
+}
+
+
+//============================================================================
+void ImageViewerPrivate::updateSelectionBand()
+{
+	if (!SelectionBand)
+	{
+		return;
+	}
+	if (!inspecting() || Selection.isEmpty() || ImageSize.isEmpty())
+	{
+		SelectionBand->hide();
+		return;
+	}
+
+	double ScaleX = double(RenderWidget->width()) / ImageSize.width();
+	double ScaleY = double(RenderWidget->height()) / ImageSize.height();
+	SelectionBand->setGeometry(QRect(
+		QPoint(qRound(Selection.left() * ScaleX), qRound(Selection.top() * ScaleY)),
+		QPoint(qRound((Selection.right() + 1) * ScaleX) - 1,
+			qRound((Selection.bottom() + 1) * ScaleY) - 1)));
+	SelectionBand->show();
+}
+
+
+//============================================================================
+void ImageViewerPrivate::updatePixel()
+{
+	if (!inspecting())
+	{
+		return;
+	}
+	QPoint Pos = imagePos(CursorPos);
+	QRgb Pixel = 0;
+	bool Valid = _this->viewport()->rect().contains(CursorPos) && pixelAt(Pos, &Pixel);
+	Inspector->setPixel(Pos, Pixel, Valid);
+}
+
+
+//============================================================================
+void ImageViewerPrivate::scheduleStatistics()
+{
+	if (inspecting() && !StatisticsTimer->isActive())
+	{
+		StatisticsTimer->start();
+	}
+}
+
+
+//============================================================================
+void ImageViewerPrivate::startStatistics()
+{
+	if (!inspecting())
+	{
+		return;
+	}
+	if (StatisticsRunning)
+	{
+		StatisticsPending = true;
+		return;
+	}
+
+	QRect Area = Selection.isEmpty() ? visibleImageRect() : Selection;
+	QImage Image;
+	bool Approximate = false;
+	if (TiledImage)
+	{
+		// Reading the full resolution would decode the whole image, the
+		// single tile of the coarsest level stands in for it
+		Image = TiledImage->cachedTile(TiledImage->levelCount() - 1, 0, 0);
+		Approximate = true;
+	}
+	else
+	{
+		Image = RenderWidget->currentImage();
+	}
+	if (Image.isNull() || Area.isEmpty())
+	{
+		Inspector->setStatistics(SImageStatistics(), QString(), false);
+		return;
+	}
+
+	QRect ImageArea = Area;
+	if (Image.size() != ImageSize)
+	{
+		double ScaleX = double(Image.width()) / ImageSize.width();
+		double ScaleY = double(Image.height()) / ImageSize.height();
+		ImageArea = QRect(QPoint(int(floor(Area.left() * ScaleX)), int(floor(Area.top() * ScaleY))),
+			QPoint(int(ceil((Area.right() + 1) * ScaleX)) - 1,
+				int(ceil((Area.bottom() + 1) * ScaleY)) - 1));
+		Approximate = true;
+	}
+	StatisticsArea = Area;
+	StatisticsApproximate = Approximate;
+	StatisticsRunning = true;
+	QThreadPool::globalInstance()->start(new CStatisticsJob(Statistics, Image, ImageArea));
+}
+
+
 
 //============================================================================
 CImageViewer::CImageViewer(QWidget *parent)
@@ -59,14 +665,48 @@ CImageViewer::CImageViewer(QWidget *parent)
 	this->setBackgroundRole(QPalette::Light);
 	this->setAlignment(Qt::AlignCenter);
 	this->setWidget(d->RenderWidget);
+	// Frames of a video may change the size without setImage()
+	connect(d->RenderWidget, &CRenderWidget::imageSizeChanged, this,
+		&CImageViewer::adjustDisplaySize);
+	connect(this->horizontalScrollBar(), &QScrollBar::valueChanged, this,
+		&CImageViewer::viewChanged);
+	connect(this->verticalScrollBar(), &QScrollBar::valueChanged, this,
+		&CImageViewer::viewChanged);
 	this->createActions();
 	this->setMouseTracking(false); // only produce mouse move events if mouse button pressed
+
+	d->ZoomTimer = new QTimer(this);
+	d->ZoomTimer->setSingleShot(true);
+	d->ZoomTimer->setInterval(ZoomIntervalMs);
+	connect(d->ZoomTimer, &QTimer::timeout, this, [this]()
+	{
+		d->applyZoom();
+	});
+	d->ZoomSettleTimer = new QTimer(this);
+	d->ZoomSettleTimer->setSingleShot(true);
+	d->ZoomSettleTimer->setInterval(ZoomSettleMs);
+	connect(d->ZoomSettleTimer, &QTimer::timeout, this, [this]()
+	{
+		d->settleZoom();
+	});
+	d->ZoomPreview = new CZoomPreview(this->viewport());
+#ifndef QT_NO_GESTURES
+	this->viewport()->grabGesture(Qt::PinchGesture);
+#endif
 }
 
 
 //============================================================================
 CImageViewer::~CImageViewer()
 {
+	cancelLoad();
+	stopVideo();
+	if (d->Statistics)
+	{
+		QMutexLocker Lock(&d->Statistics->Mutex);
+		d->Statistics->Viewer = nullptr;
+		d->Statistics->Canceled = true;
+	}
 	delete d;
 }
 
@@ -75,8 +715,21 @@ CImageViewer::~CImageViewer()
 bool CImageViewer::loadFile(const QString& fileName)
 {
     QImageReader reader(fileName);
+    if (CTiledImage::needsTiling(reader.size()))
+    {
+        return loadTiledFile(fileName);
+    }
+
+    QImage newImage = CImageCache::instance().find(fileName);
+    if (!newImage.isNull())
+    {
+        setImage(newImage);
+        setWindowFilePath(fileName);
+        return true;
+    }
+
     reader.setAutoTransform(true);
-    const QImage newImage = reader.read();
+    newImage = reader.read();
     if (newImage.isNull())
     {
         QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
@@ -85,7 +738,190 @@ bool CImageViewer::loadFile(const QString& fileName)
         return false;
     }
 
-    setImage(newImage);
+    setImage(CImageCache::instance().insert(fileName, QSize(), 1, newImage));
+    setWindowFilePath(fileName);
+    return true;
+}
+
+
+//===========================================================================
+void CImageViewer::loadFileAsync(const QString& fileName)
+{
+    cancelLoad();
+    stopVideo();
+    QImageReader reader(fileName);
+    if (CTiledImage::needsTiling(reader.size()))
+    {
+        // Tiles are decoded asynchronously anyway
+        Q_EMIT fileLoaded(fileName, loadTiledFile(fileName));
+        return;
+    }
+
+    // Viewers showing the same file share one decoded image
+    QImage Cached = CImageCache::instance().find(fileName);
+    if (!Cached.isNull())
+    {
+        setImage(Cached);
+        setWindowFilePath(fileName);
+        Q_EMIT fileLoaded(fileName, true);
+        return;
+    }
+
+    d->Load = std::make_shared<ImageLoadState>(this, fileName);
+    QThreadPool::globalInstance()->start(new CImageLoadJob(d->Load));
+}
+
+
+//===========================================================================
+void CImageViewer::cancelLoad()
+{
+    if (!d->Load)
+    {
+        return;
+    }
+
+    {
+        QMutexLocker Lock(&d->Load->Mutex);
+        d->Load->Viewer = nullptr;
+        d->Load->Canceled = true;
+    }
+    d->Load.reset();
+}
+
+
+//===========================================================================
+void CImageViewer::onPreviewDecoded()
+{
+    if (!d->Load)
+    {
+        return;
+    }
+
+    QImage Preview;
+    QSize DisplaySize;
+    {
+        QMutexLocker Lock(&d->Load->Mutex);
+        Preview = d->Load->Preview;
+        d->Load->Preview = QImage();
+        DisplaySize = d->Load->DisplaySize;
+    }
+    if (Preview.isNull())
+    {
+        return;
+    }
+
+    d->RenderWidget->showImage(Preview, DisplaySize);
+    delete d->TiledImage;
+    d->TiledImage = nullptr;
+    this->adjustDisplaySize(DisplaySize);
+}
+
+
+//===========================================================================
+void CImageViewer::onImageDecoded()
+{
+    if (!d->Load)
+    {
+        return;
+    }
+
+    QImage Image;
+    QString ErrorString;
+    {
+        QMutexLocker Lock(&d->Load->Mutex);
+        if (!d->Load->Finished)
+        {
+            return;
+        }
+        Image = d->Load->Image;
+        ErrorString = d->Load->ErrorString;
+    }
+    QString FileName = d->Load->FileName;
+    d->Load.reset();
+
+    if (Image.isNull())
+    {
+        QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
+                                 tr("Cannot load %1: %2")
+                                 .arg(QDir::toNativeSeparators(FileName), ErrorString));
+        Q_EMIT fileLoaded(FileName, false);
+        return;
+    }
+
+    setImage(Image);
+    setWindowFilePath(FileName);
+    Q_EMIT fileLoaded(FileName, true);
+}
+
+
+//===========================================================================
+bool CImageViewer::playVideo(const QString& fileName)
+{
+    cancelLoad();
+    if (!d->Video)
+    {
+        d->Video = new CVideoFileSource(this);
+    }
+
+    QString ErrorString;
+    if (!d->Video->open(fileName, &ErrorString))
+    {
+        QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
+                                 tr("Cannot play %1: %2")
+                                 .arg(QDir::toNativeSeparators(fileName), ErrorString));
+        return false;
+    }
+
+    d->Video->setRealTime(d->VideoRealTime);
+    d->Video->start(d->RenderWidget);
+    delete d->TiledImage;
+    d->TiledImage = nullptr;
+    d->scheduleStatistics();
+    setWindowFilePath(fileName);
+    return true;
+}
+
+
+//===========================================================================
+void CImageViewer::stopVideo()
+{
+    if (d->Video)
+    {
+        d->Video->stop();
+    }
+}
+
+
+//===========================================================================
+bool CImageViewer::loadTiledFile(const QString& fileName)
+{
+    stopVideo();
+    auto TiledImage = new CTiledImage(this);
+    QString ErrorString;
+    if (!TiledImage->open(fileName, &ErrorString))
+    {
+        delete TiledImage;
+        QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
+                                 tr("Cannot load %1: %2")
+                                 .arg(QDir::toNativeSeparators(fileName), ErrorString));
+        return false;
+    }
+
+    connect(TiledImage, &CTiledImage::loadFailed, this, [this, fileName](const QString& Error)
+    {
+        QMessageBox::information(this, QGuiApplication::applicationDisplayName(),
+                                 tr("Cannot load %1: %2")
+                                 .arg(QDir::toNativeSeparators(fileName), Error));
+    });
+    // The overview tile the statistics are computed from arrives later
+    connect(TiledImage, &CTiledImage::tileReady, this, [this]()
+    {
+        d->scheduleStatistics();
+    });
+    d->RenderWidget->showTiledImage(TiledImage);
+    delete d->TiledImage;
+    d->TiledImage = TiledImage;
+    this->adjustDisplaySize(TiledImage->size());
     setWindowFilePath(fileName);
     return true;
 }
@@ -94,19 +930,26 @@ bool CImageViewer::loadFile(const QString& fileName)
 //===========================================================================
 void CImageViewer::setImage(const QImage &newImage)
 {
+    stopVideo();
     d->RenderWidget->showImage(newImage);
-    this->adjustDisplaySize(newImage);
+    delete d->TiledImage;
+    d->TiledImage = nullptr;
+    this->adjustDisplaySize(newImage.size());
 }
 
 
 //============================================================================
-void CImageViewer::adjustDisplaySize(const QImage& Image)
+void CImageViewer::adjustDisplaySize(const QSize& ImageSize)
 {
-	if (d->ImageSize == Image.size())
+	d->scheduleStatistics();
+	Q_EMIT imageChanged();
+	if (d->ImageSize == ImageSize)
 	{
 		return;
 	}
-	d->ImageSize = Image.size();
+	d->ImageSize = ImageSize;
+	d->Selection = QRect();
+	d->updateSelectionBand();
 	if (d->AutoFit)
 	{
 		this->fitToWindow();
@@ -144,7 +987,23 @@ void CImageViewer::open()
     QFileDialog dialog(this, tr("Open File"));
     initializeImageFileDialog(dialog, QFileDialog::AcceptOpen);
 
-    while (dialog.exec() == QDialog::Accepted && !loadFile(dialog.selectedFiles().first())) {}
+    if (dialog.exec() == QDialog::Accepted)
+    {
+        loadFileAsync(dialog.selectedFiles().first());
+    }
+}
+
+
+//===========================================================================
+void CImageViewer::openVideo()
+{
+    QFileDialog dialog(this, tr("Open Video"));
+    dialog.setNameFilters({tr("Video files (*.y4m *.yuv *.i420 *.iyuv *.nv12 *.gray *.y8 *.rgb *.rgb24 *.rgb32 *.bgra)"),
+        tr("All files (*)")});
+    if (dialog.exec() == QDialog::Accepted)
+    {
+        playVideo(dialog.selectedFiles().first());
+    }
 }
 
 
@@ -158,6 +1017,35 @@ void CImageViewer::createActions()
     a->setShortcut(QKeySequence::Open);;
     this->addAction(a);
 
+	a = new QAction(tr("Open &Video..."));
+	a->setIcon(QIcon(":/adsdemo/images/panorama.svg"));
+	connect(a, &QAction::triggered, this, &CImageViewer::openVideo);
+	this->addAction(a);
+
+	a = new QAction(tr("Play as Fast as Possible"));
+	a->setCheckable(true);
+	connect(a, &QAction::toggled, this, [this](bool Checked)
+	{
+		d->VideoRealTime = !Checked;
+		if (d->Video)
+		{
+			d->Video->setRealTime(d->VideoRealTime);
+		}
+	});
+	this->addAction(a);
+
+	a = new QAction(tr("Show Frame Statistics"));
+	a->setCheckable(true);
+	connect(a, &QAction::toggled, d->RenderWidget,
+		&CRenderWidget::setStatisticsOverlayVisible);
+	this->addAction(a);
+
+	a = new QAction(tr("Pixel Inspector"));
+	a->setIcon(QIcon(":/adsdemo/images/color_lens.svg"));
+	a->setCheckable(true);
+	connect(a, &QAction::toggled, this, &CImageViewer::setInspectorVisible);
+	this->addAction(a);
+
 	a = new QAction(tr("Fit on Screen"));
 	a->setIcon(QIcon(":/adsdemo/images/zoom_out_map.svg"));
 	connect(a, &QAction::triggered, this, &CImageViewer::fitToWindow);
@@ -189,6 +1077,7 @@ void CImageViewer::createActions()
 //===========================================================================
 void CImageViewer::zoomIn()
 {
+	d->settleZoom();
 	d->AutoFit = false;
 	d->RenderWidget->zoomIn();
 }
@@ -197,6 +1086,7 @@ void CImageViewer::zoomIn()
 //===========================================================================
 void CImageViewer::zoomOut()
 {
+	d->settleZoom();
 	d->AutoFit = false;
 	d->RenderWidget->zoomOut();
 }
@@ -205,6 +1095,7 @@ void CImageViewer::zoomOut()
 //===========================================================================
 void CImageViewer::normalSize()
 {
+	d->settleZoom();
 	d->AutoFit = false;
 	d->RenderWidget->normalSize();
 }
@@ -213,6 +1104,7 @@ void CImageViewer::normalSize()
 //===========================================================================
 void CImageViewer::fitToWindow()
 {
+	d->settleZoom();
 	d->AutoFit = true;
 	d->RenderWidget->scaleToSize(this->maximumViewportSize());
 }
@@ -222,16 +1114,28 @@ void CImageViewer::fitToWindow()
 void CImageViewer::resizeEvent(QResizeEvent* ResizeEvent)
 {
 	Super::resizeEvent(ResizeEvent);
+	d->settleZoom();
+	d->placeInspector();
 	if (d->AutoFit)
 	{
 		this->fitToWindow();
 	}
+	Q_EMIT viewChanged();
 }
 
 
 //============================================================================
 void CImageViewer::mousePressEvent(QMouseEvent* Event)
 {
+	if (d->inspecting() && Event->button() == Qt::LeftButton
+	 && (Event->modifiers() & Qt::ShiftModifier))
+	{
+		d->Selecting = true;
+		d->SelectionStart = d->imagePos(Event->pos());
+		d->Selection = QRect();
+		d->updateSelectionBand();
+		return;
+	}
 	d->RenderWidget->setCursor(Qt::ClosedHandCursor);
 	d->MouseMoveStartPos = Event->pos();
 	Super::mousePressEvent(Event);
@@ -241,6 +1145,18 @@ void CImageViewer::mousePressEvent(QMouseEvent* Event)
 //============================================================================
 void CImageViewer::mouseReleaseEvent(QMouseEvent* Event)
 {
+	if (d->Selecting)
+	{
+		d->Selecting = false;
+		// A click without dragging goes back to the visible area
+		if (d->Selection.width() < 2 || d->Selection.height() < 2)
+		{
+			d->Selection = QRect();
+			d->updateSelectionBand();
+		}
+		d->scheduleStatistics();
+		return;
+	}
 	d->RenderWidget->setCursor(Qt::OpenHandCursor);
 	Super::mouseReleaseEvent(Event);
 }
@@ -249,6 +1165,23 @@ void CImageViewer::mouseReleaseEvent(QMouseEvent* Event)
 //============================================================================
 void CImageViewer::mouseMoveEvent(QMouseEvent* Event)
 {
+	d->CursorPos = Event->pos();
+	if (d->Selecting)
+	{
+		d->Selection = QRect(d->SelectionStart, d->imagePos(Event->pos())).normalized()
+			& QRect(QPoint(0, 0), d->ImageSize);
+		d->updateSelectionBand();
+		d->updatePixel();
+		d->scheduleStatistics();
+		return;
+	}
+	d->updatePixel();
+
+	// With the inspector shown, moves without a button are tracked too
+	if (Event->buttons() == Qt::NoButton)
+	{
+		return;
+	}
 	QPoint MoveVector = Event->pos() - d->MouseMoveStartPos;
 	d->MouseMoveStartPos = Event->pos();
 	horizontalScrollBar()->setValue(horizontalScrollBar()->value()
@@ -262,7 +1195,6 @@ void CImageViewer::wheelEvent(QWheelEvent* Event)
 {
 	double numDegrees = Event->angleDelta().y() / 8;
 	double numSteps = numDegrees / 15;
-	d->AutoFit = false;
 	double Zoom;
 	if (numSteps < 0)
 	{
@@ -272,7 +1204,156 @@ void CImageViewer::wheelEvent(QWheelEvent* Event)
 	{
 		Zoom = pow(1.10, numSteps);
 	}
-	d->RenderWidget->zoomByValue(Zoom);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+	d->queueZoom(Zoom, Event->position().toPoint());
+#else
+	d->queueZoom(Zoom, Event->pos());
+#endif
+}
+
+
+//============================================================================
+bool CImageViewer::viewportEvent(QEvent* Event)
+{
+	if (d->zoomGesture(Event, this->viewport()))
+	{
+		return true;
+	}
+	return Super::viewportEvent(Event);
+}
+
+//============================================================================
+bool CImageViewer::eventFilter(QObject* Object, QEvent* Event)
+{
+	// QScrollArea filters the events of its widget already
+	if (Object == d->RenderWidget && d->zoomGesture(Event, d->RenderWidget))
+	{
+		return true;
+	}
+	if (Object == d->RenderWidget && d->inspecting()
+	 && (Event->type() == QEvent::Resize || Event->type() == QEvent::Move))
+	{
+		d->updateSelectionBand();
+		if (d->Selection.isEmpty())
+		{
+			d->scheduleStatistics();
+		}
+	}
+	// The scroll area updates the scroll bar ranges when its widget resizes
+	bool Result = Super::eventFilter(Object, Event);
+	if (Object == d->RenderWidget && Event->type() == QEvent::Resize)
+	{
+		Q_EMIT viewChanged();
+	}
+	return Result;
+}
+
+
+//============================================================================
+QImage CImageViewer::image() const
+{
+	QImage Image = d->RenderWidget->currentImage();
+	return (Image.size() == d->ImageSize) ? Image : QImage();
+}
+
+
+//============================================================================
+void CImageViewer::setOverlay(const QVector<QImage>& Levels)
+{
+	d->RenderWidget->setOverlay(Levels);
+}
+
+
+//============================================================================
+double CImageViewer::scaleFactor() const
+{
+	return d->RenderWidget->scaleFactor();
+}
+
+
+//============================================================================
+QPointF CImageViewer::viewCenter() const
+{
+	QPoint Pos = d->RenderWidget->mapFrom(this->viewport(),
+		this->viewport()->rect().center());
+	return QPointF(double(Pos.x()) / qMax(1, d->RenderWidget->width()),
+		double(Pos.y()) / qMax(1, d->RenderWidget->height()));
+}
+
+
+//============================================================================
+void CImageViewer::setView(double ScaleFactor, const QPointF& Center)
+{
+	d->settleZoom();
+	d->AutoFit = false;
+	if (ScaleFactor > 0 && ScaleFactor != d->RenderWidget->scaleFactor())
+	{
+		d->RenderWidget->setScaleFactor(ScaleFactor);
+	}
+	QPoint Pos(qRound(Center.x() * d->RenderWidget->width()),
+		qRound(Center.y() * d->RenderWidget->height()));
+	QPoint ViewportCenter = this->viewport()->rect().center();
+	horizontalScrollBar()->setValue(Pos.x() - ViewportCenter.x());
+	verticalScrollBar()->setValue(Pos.y() - ViewportCenter.y());
+}
+
+
+//============================================================================
+void CImageViewer::setInspectorVisible(bool Visible)
+{
+	if (!d->Inspector)
+	{
+		if (!Visible)
+		{
+			return;
+		}
+		d->Inspector = new CImageInspector(this->viewport());
+		d->SelectionBand = new QRubberBand(QRubberBand::Rectangle, d->RenderWidget);
+		d->Statistics = std::make_shared<ImageStatisticsState>(this);
+		d->StatisticsTimer = new QTimer(this);
+		d->StatisticsTimer->setSingleShot(true);
+		d->StatisticsTimer->setInterval(StatisticsIntervalMs);
+		connect(d->StatisticsTimer, &QTimer::timeout, this, [this]()
+		{
+			d->startStatistics();
+		});
+	}
+
+	d->Inspector->setVisible(Visible);
+	d->Inspector->raise();
+	d->placeInspector();
+	// Moves without a pressed button update the pixel under the cursor
+	d->RenderWidget->setMouseTracking(Visible);
+	this->viewport()->setMouseTracking(Visible);
+	d->updateSelectionBand();
+	d->updatePixel();
+	d->scheduleStatistics();
+}
+
+
+//============================================================================
+void CImageViewer::onStatisticsReady()
+{
+	SImageStatistics Statistics;
+	{
+		QMutexLocker Lock(&d->Statistics->Mutex);
+		Statistics = d->Statistics->Statistics;
+	}
+	d->StatisticsRunning = false;
+
+	QRect Area = d->StatisticsArea;
+	QString AreaText = d->Selection.isEmpty()
+		? tr("Visible %1 x %2").arg(Area.width()).arg(Area.height())
+		: tr("Selection %1 x %2 at %3, %4").arg(Area.width()).arg(Area.height())
+			.arg(Area.left()).arg(Area.top());
+	d->Inspector->setStatistics(Statistics, AreaText, d->StatisticsApproximate);
+	// Frames of a running video change below a resting cursor
+	d->updatePixel();
+	if (d->StatisticsPending || (d->Video && d->Video->isRunning()))
+	{
+		d->StatisticsPending = false;
+		d->scheduleStatistics();
+	}
 }
 
 #include "moc_ImageViewer.cpp"
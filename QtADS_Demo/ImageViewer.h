@@ -11,6 +11,8 @@
 //                                   INCLUDES
 //============================================================================
 #include <QScrollArea>
+#include <QImage>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 class QLabel;
@@ -31,11 +33,78 @@ public:
 	explicit CImageViewer(QWidget *parent = nullptr);
     virtual ~CImageViewer();
 
+	/**
+	 * @brief Loads an image file. Images too large to decode at once are
+	 * shown in tiles decoded on demand, see CTiledImage.
+	 */
 	bool loadFile(const QString& Filename);
+
+	/**
+	 * @brief Loads an image file on the global thread pool without blocking.
+	 * If the format can decode a scaled down image cheaply, a preview is
+	 * shown first and replaced when the full resolution image is ready.
+	 * Loading another file cancels the running load. fileLoaded() is
+	 * emitted when done.
+	 */
+	void loadFileAsync(const QString& Filename);
 	void setImage(const QImage &newImage);
 
+	/**
+	 * @brief Plays a video file as a stand-in for a capture device, see
+	 * CVideoFileSource for the supported files. Playback loops until
+	 * another file or image is shown.
+	 */
+	bool playVideo(const QString& Filename);
+
+	/**
+	 * @brief The image shown at full resolution. Null while only a preview
+	 * is decoded and for images shown in tiles.
+	 */
+	QImage image() const;
+
+	/**
+	 * @brief Draws image levels on top of the image, see
+	 * CRenderWidget::setOverlay().
+	 */
+	void setOverlay(const QVector<QImage>& Levels);
+
+	/**
+	 * @brief Displayed pixels per image pixel
+	 */
+	double scaleFactor() const;
+
+	/**
+	 * @brief Image position at the center of the viewport, relative to the
+	 * image size, i.e. (0.5, 0.5) for the center of the image.
+	 */
+	QPointF viewCenter() const;
+
+	/**
+	 * @brief Zooms to ScaleFactor and scrolls Center, relative to the image
+	 * size, to the center of the viewport. Ends fitting the image to the
+	 * window.
+	 */
+	void setView(double ScaleFactor, const QPointF& Center);
+
 public Q_SLOTS:
 	void open();
+	void openVideo();
+	/**
+	 * @brief Cancels a running loadFileAsync(). The preview, if one is
+	 * shown, stays.
+	 */
+	void cancelLoad();
+	/**
+	 * @brief Stops a running playVideo(). The last frame stays.
+	 */
+	void stopVideo();
+	/**
+	 * @brief Shows or hides the pixel inspector.
+	 * The inspector shows the pixel under the cursor and the statistics of
+	 * the visible area, or of a selection dragged with Shift held down.
+	 * Statistics are computed on the thread pool, at most 30 times a second.
+	 */
+	void setInspectorVisible(bool Visible);
     void zoomIn();
     void zoomOut();
     void normalSize();
@@ -65,20 +134,71 @@ protected:
 
 	/**
 	 * @brief Use mouse wheel to change scaling of the image.
+	 * While the wheel turns, a scaled snapshot of the view is shown. The
+	 * zoom is applied once it pauses, keeping the image point under the
+	 * cursor in place.
 	 */
 	virtual void wheelEvent(QWheelEvent* Event);
 
+	/**
+	 * @brief Handles pinch and trackpad zoom gestures like the wheel.
+	 */
+	virtual bool viewportEvent(QEvent* Event);
+
+	/**
+	 * @brief Follows moves and resizes of the render widget, which change
+	 * the visible area and the selection geometry.
+	 */
+	virtual bool eventFilter(QObject* Object, QEvent* Event);
+
+Q_SIGNALS:
+	/**
+	 * @brief Emitted when loadFileAsync() finished, unless it was canceled.
+	 */
+	void fileLoaded(const QString& Filename, bool Success);
+
+	/**
+	 * @brief Emitted when another image, preview or video is shown.
+	 */
+	void imageChanged();
+
+	/**
+	 * @brief Emitted when the zoom or the visible area changes.
+	 */
+	void viewChanged();
+
+private Q_SLOTS:
+	/**
+	 * @brief Shows the preview decoded by the running load.
+	 */
+	void onPreviewDecoded();
+
+	/**
+	 * @brief Shows the image decoded by the running load.
+	 */
+	void onImageDecoded();
+
+	/**
+	 * @brief Shows the statistics computed by the running job.
+	 */
+	void onStatisticsReady();
+
 private:
     /**
 	 * @brief Create the wiget actions.
 	 */
     void createActions();
 
+	/**
+	 * @brief Shows an image file in tiles.
+	 */
+	bool loadTiledFile(const QString& Filename);
+
 	/**
 	 * @brief Adjust size of render widget in case of image size change.
-	 * @param[in] Image The new image that may have a different image size.
+	 * @param[in] ImageSize Size of the new image.
 	 */
-	void adjustDisplaySize(const QImage& Image);
+	void adjustDisplaySize(const QSize& ImageSize);
 
     ImageViewerPrivate* d;
     friend ImageViewerPrivate;
@@ -0,0 +1,118 @@
+#ifndef LruImageCacheH
+#define LruImageCacheH
+//============================================================================
+/// \file   LruImageCache.h
+/// \brief  Declaration of CLruImageCache
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QHash>
+#include <QImage>
+
+#include <list>
+#include <utility>
+
+
+/**
+ * @brief Image cache bounded in bytes that drops the least recently used
+ * images first.
+ *
+ * Images are implicitly shared, so everybody holding an image returned by
+ * find() shares the cached pixel buffer, also after it was dropped from the
+ * cache. Not thread safe.
+ */
+template <class Key>
+class CLruImageCache
+{
+private:
+	typedef std::list<std::pair<Key, QImage>> tEntryList;
+	tEntryList m_Entries;///< most recently used first
+	QHash<Key, typename tEntryList::iterator> m_EntryByKey;
+	qint64 m_Bytes = 0;
+	qint64 m_Limit;
+
+	static qint64 imageBytes(const QImage& Image)
+	{
+		return qint64(Image.bytesPerLine()) * Image.height();
+	}
+
+	void trim()
+	{
+		// The newest image stays even if it alone exceeds the limit
+		while (m_Bytes > m_Limit && m_Entries.size() > 1)
+		{
+			m_Bytes -= imageBytes(m_Entries.back().second);
+			m_EntryByKey.remove(m_Entries.back().first);
+			m_Entries.pop_back();
+		}
+	}
+
+public:
+	explicit CLruImageCache(qint64 Limit) : m_Limit(Limit) {}
+
+	/**
+	 * @brief Returns the cached image and marks it as recently used, or a
+	 * null image.
+	 */
+	QImage find(const Key& ImageKey)
+	{
+		auto Entry = m_EntryByKey.constFind(ImageKey);
+		if (Entry == m_EntryByKey.constEnd())
+		{
+			return QImage();
+		}
+		m_Entries.splice(m_Entries.begin(), m_Entries, Entry.value());
+		return Entry.value()->second;
+	}
+
+	bool contains(const Key& ImageKey) const
+	{
+		return m_EntryByKey.contains(ImageKey);
+	}
+
+	/**
+	 * @brief Adds an image unless one is cached for the key already.
+	 */
+	void insert(const Key& ImageKey, const QImage& Image)
+	{
+		if (contains(ImageKey))
+		{
+			return;
+		}
+		m_Entries.emplace_front(ImageKey, Image);
+		m_EntryByKey.insert(ImageKey, m_Entries.begin());
+		m_Bytes += imageBytes(Image);
+		trim();
+	}
+
+	void clear()
+	{
+		m_Entries.clear();
+		m_EntryByKey.clear();
+		m_Bytes = 0;
+	}
+
+	qint64 limit() const
+	{
+		return m_Limit;
+	}
+
+	void setLimit(qint64 Bytes)
+	{
+		m_Limit = Bytes;
+		trim();
+	}
+
+	/**
+	 * @brief Bytes used by the cached images
+	 */
+	qint64 bytes() const
+	{
+		return m_Bytes;
+	}
+}; // class CLruImageCache
+
+//---------------------------------------------------------------------------
+#endif // LruImageCacheH
@@ -63,6 +63,8 @@
 #include <QMap>
 #include <QElapsedTimer>
 #include <QQuickWidget>
+#include <QStandardPaths>
+#include <QDir>
 
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
@@ -83,6 +85,9 @@
 #include "DockSplitter.h"
 #include "DockWidget.h"
 #include "FloatingDockContainer.h"
+#include "ImageBrowser.h"
+#include "ImageCache.h"
+#include "ImageCompare.h"
 #include "ImageViewer.h"
 #include "MyDockAreaTitleBar.h"
 #include "StatusDialog.h"
@@ -133,8 +138,10 @@ static QIcon svgIcon(const QString& File)
 {
 	// This is a workaround, because in item views SVG icons are not
 	// properly scaled and look blurry or pixelate
+	// The rasterized pixmap is shared by all icons of the same file
 	QIcon SvgIcon(File);
-	SvgIcon.addPixmap(SvgIcon.pixmap(92));
+	SvgIcon.addPixmap(QPixmap::fromImage(CImageCache::instance().image(File,
+		QSize(92, 92), qApp->devicePixelRatio())));
 	return SvgIcon;
 }
 
@@ -191,6 +198,9 @@ struct MainWindowPrivate
 	ads::CDockWidget* WindowTitleTestDockWidget = nullptr;
 	QPointer<ads::CDockWidget> LastDockedEditor;
 	QPointer<ads::CDockWidget> LastCreatedFloatingEditor;
+	// Shared by all file system dock widgets, so they share one directory
+	// crawl and one set of file system watchers
+	QFileSystemModel* FileSystemModel = nullptr;
 
 	MainWindowPrivate(CMainWindow* _public) : _this(_public) {}
 
@@ -230,12 +240,15 @@ struct MainWindowPrivate
 	ads::CDockWidget* createFileSystemTreeDockWidget()
 	{
 		static int FileSystemCount = 0;
+		if (!FileSystemModel)
+		{
+			FileSystemModel = new QFileSystemModel(_this);
+			FileSystemModel->setRootPath(QDir::currentPath());
+		}
 		QTreeView* w = new QTreeView();
 		w->setFrameShape(QFrame::NoFrame);
-		QFileSystemModel* m = new QFileSystemModel(w);
-		m->setRootPath(QDir::currentPath());
-		w->setModel(m);
-		w->setRootIndex(m->index(QDir::currentPath()));
+		w->setModel(FileSystemModel);
+		w->setRootIndex(FileSystemModel->index(QDir::currentPath()));
 		ads::CDockWidget* DockWidget = DockManager->createDockWidget(QString("Filesystem %1")
 			.arg(FileSystemCount++));
 		DockWidget->setWidget(w);
@@ -343,9 +356,9 @@ struct MainWindowPrivate
 	}
 
 	/**
-	 * Creates a simply image viewr
+	 * Creates a simply image viewr showing ImageFile or a random demo image
 	 */
-	ads::CDockWidget* createImageViewer()
+	ads::CDockWidget* createImageViewer(const QString& ImageFile = QString())
 	{
 		static int ImageViewerCount = 0;
 		auto w = new CImageViewer();
@@ -361,13 +374,96 @@ struct MainWindowPrivate
 		case 3: FileName = ":adsdemo/images/ads_tile_orange.svg"; break;
 		}
 
-		auto Result = w->loadFile(FileName);
-		qDebug() << "loadFile result: " << Result;
+		QObject::connect(w, &CImageViewer::fileLoaded, [](const QString& FileName, bool Result)
+		{
+			qDebug() << "loadFile result: " << FileName << Result;
+		});
+		w->loadFileAsync(ImageFile.isEmpty() ? QString(FileName) : ImageFile);
 		ads::CDockWidget* DockWidget = DockManager->createDockWidget(QString("Image Viewer %1").arg(ImageViewerCount++));
 		DockWidget->setIcon(svgIcon(":/adsdemo/images/photo.svg"));
 		DockWidget->setWidget(w,ads:: CDockWidget::ForceNoScrollArea);
+		QObject::connect(DockWidget, &ads::CDockWidget::closed, w, &CImageViewer::cancelLoad);
+		QObject::connect(DockWidget, &ads::CDockWidget::closed, w, &CImageViewer::stopVideo);
+		auto ToolBar = DockWidget->createDefaultToolBar();
+		ToolBar->addActions(w->actions());
+		auto Action = ToolBar->addAction(svgIcon(":/adsdemo/images/picture_in_picture.svg"),
+			QObject::tr("Compare With..."));
+		QObject::connect(Action, &QAction::triggered, [this, DockWidget]()
+		{
+			compareImageViewer(DockWidget);
+		});
+		return DockWidget;
+	}
+
+	/**
+	 * Lets the user pick another image viewer as reference for the image
+	 * viewer in DockWidget, see CImageCompare
+	 */
+	void compareImageViewer(ads::CDockWidget* DockWidget)
+	{
+		auto Test = qobject_cast<CImageViewer*>(DockWidget->widget());
+		QStringList Titles;
+		QList<CImageViewer*> Viewers;
+		for (auto Other : DockManager->dockWidgetsMap())
+		{
+			auto Viewer = qobject_cast<CImageViewer*>(Other->widget());
+			if (Viewer && Viewer != Test && !Other->isClosed())
+			{
+				Titles.append(Other->windowTitle());
+				Viewers.append(Viewer);
+			}
+		}
+		Titles.append(QObject::tr("None"));
+
+		bool Ok = false;
+		QString Title = QInputDialog::getItem(_this, QObject::tr("Compare Images"),
+			QObject::tr("Compare %1 with:").arg(DockWidget->windowTitle()),
+			Titles, 0, false, &Ok);
+		if (!Ok)
+		{
+			return;
+		}
+
+		// A viewer shows the differences to one reference at a time
+		for (auto Compare : _this->findChildren<CImageCompare*>())
+		{
+			if (Compare->testViewer() == Test)
+			{
+				delete Compare;
+			}
+		}
+		int Index = Titles.indexOf(Title);
+		if (Index >= 0 && Index < Viewers.size())
+		{
+			new CImageCompare(Viewers.at(Index), Test, _this);
+		}
+	}
+
+	/**
+	 * Creates a thumbnail browser that opens activated images in new image
+	 * viewers
+	 */
+	ads::CDockWidget* createImageBrowser()
+	{
+		auto w = new CImageBrowser();
+		QString Directory = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
+		w->setDirectory(QDir(Directory).exists() ? Directory : QDir::currentPath());
+		QObject::connect(w, &CImageBrowser::imageActivated, [this](const QString& FileName)
+		{
+			auto DockWidget = createImageViewer(FileName);
+			DockWidget->setFeature(ads::CDockWidget::DockWidgetDeleteOnClose, true);
+			DockWidget->setFeature(ads::CDockWidget::DockWidgetForceCloseWithArea, true);
+			DockWidget->setFeature(ads::CDockWidget::CustomCloseHandling, true);
+			QObject::connect(DockWidget, &ads::CDockWidget::closeRequested, _this,
+				&CMainWindow::onImageViewerCloseRequested);
+			DockManager->addDockWidget(ads::RightDockWidgetArea, DockWidget);
+		});
+		ads::CDockWidget* DockWidget = DockManager->createDockWidget("Image Browser");
+		DockWidget->setIcon(svgIcon(":/adsdemo/images/perm_media.svg"));
+		DockWidget->setWidget(w, ads::CDockWidget::ForceNoScrollArea);
 		auto ToolBar = DockWidget->createDefaultToolBar();
 		ToolBar->addActions(w->actions());
+		ui.menuView->addAction(DockWidget->toggleViewAction());
 		return DockWidget;
 	}
 
@@ -574,6 +670,7 @@ void MainWindowPrivate::createContent()
 	// Create image viewer
 	DockWidget = createImageViewer();
 	DockManager->addDockWidget(ads::LeftDockWidgetArea, DockWidget);
+	DockManager->addDockWidgetTabToArea(createImageBrowser(), DockWidget->dockAreaWidget());
 
     // Create quick widget
 	DockWidget = createQQuickWidget();
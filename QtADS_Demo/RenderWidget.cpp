@@ -10,14 +10,118 @@
 //                                   INCLUDES
 //============================================================================
 #include "RenderWidget.h"
+#include "TiledImage.h"
 
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPainter>
+#include <QPaintEvent>
+#include <QRunnable>
+#include <QThreadPool>
+#include <limits.h>
 #include <math.h>
 
+#include <chrono>
+
+
+/**
+ * Hand-off of a pyramid built on the thread pool. Widget is reset by the
+ * destructor, so a job finishing later does not touch a deleted widget.
+ */
+struct RenderWidgetPyramidState
+{
+	QMutex Mutex;
+	CRenderWidget* Widget;
+	quint64 Generation = 0;///< generation of the image being shown
+	QVector<QImage> Pyramid;///< built pyramid waiting for takePyramid()
+
+	RenderWidgetPyramidState(CRenderWidget* _Widget) : Widget(_Widget) {}
+};
+
+
+namespace
+{
+/// Length of the window the statistics overlay averages over
+const qint64 StatisticsWindow = 1000000000;
+
+qint64 steadyNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Converts the image to a format QPainter draws without conversion.
+ */
+QImage paintableImage(const QImage& Image)
+{
+	QImage::Format Format = Image.format();
+	if (Format == QImage::Format_RGB32
+	 || Format == QImage::Format_ARGB32_Premultiplied)
+	{
+		return Image;
+	}
+	return Image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+/**
+ * Builds up to MaxLevels levels, level 0 being the image itself.
+ */
+QVector<QImage> buildPyramid(const QImage& Image, int MaxLevels)
+{
+	QVector<QImage> Pyramid;
+	Pyramid.append(Image);
+	while (Pyramid.size() < MaxLevels)
+	{
+		QImage Last = Pyramid.last();
+		if (Last.width() / 2 < CRenderWidget::MinLevelSize
+		 || Last.height() / 2 < CRenderWidget::MinLevelSize)
+		{
+			break;
+		}
+		Pyramid.append(Last.scaled(Last.width() / 2, Last.height() / 2,
+			Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+	}
+	return Pyramid;
+}
+
+/**
+ * Builds the pyramid of a still image on the thread pool.
+ */
+class CPyramidJob : public QRunnable
+{
+private:
+	std::shared_ptr<RenderWidgetPyramidState> m_State;
+	QImage m_Image;
+	quint64 m_Generation;
+
+public:
+	CPyramidJob(std::shared_ptr<RenderWidgetPyramidState> State,
+		const QImage& Image, quint64 Generation)
+		: m_State(std::move(State)), m_Image(Image), m_Generation(Generation)
+	{
+	}
+
+	void run() override
+	{
+		QVector<QImage> Pyramid = buildPyramid(m_Image, INT_MAX);
+		QMutexLocker Lock(&m_State->Mutex);
+		if (!m_State->Widget || m_State->Generation != m_Generation)
+		{
+			return;
+		}
+		m_State->Pyramid = std::move(Pyramid);
+		QMetaObject::invokeMethod(m_State->Widget, "takePyramid",
+			Qt::QueuedConnection);
+	}
+};
+} // namespace
+
 
 //===========================================================================
 CRenderWidget::CRenderWidget(QWidget* Parent) :
-	QWidget(Parent), m_ScaleFactor(1)
+	QWidget(Parent), m_ScaleFactor(1),
+	m_PyramidState(std::make_shared<RenderWidgetPyramidState>(this))
 {
 	this->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
 	this->setCursor(Qt::OpenHandCursor);
@@ -26,26 +130,389 @@ CRenderWidget::CRenderWidget(QWidget* Parent) :
 //===========================================================================
 CRenderWidget::~CRenderWidget()
 {
-
+	QMutexLocker Lock(&m_PyramidState->Mutex);
+	m_PyramidState->Widget = nullptr;
 }
 
 //===========================================================================
-void CRenderWidget::showImage(const QImage& Image)
+void CRenderWidget::showImage(const QImage& Image, const QSize& DisplaySize)
 {
-	m_Image = QPixmap::fromImage(Image);
+	releaseTiledImage();
+	releaseFrames();
+	m_Pyramid = QVector<QImage>{paintableImage(Image)};
+	m_ImageSize = DisplaySize.isValid() ? DisplaySize : Image.size();
+	{
+		QMutexLocker Lock(&m_PyramidState->Mutex);
+		m_PyramidState->Pyramid.clear();
+		++m_PyramidState->Generation;
+		if (!Image.isNull())
+		{
+			QThreadPool::globalInstance()->start(new CPyramidJob(m_PyramidState,
+				m_Pyramid.first(), m_PyramidState->Generation));
+		}
+	}
 	this->adjustWidgetSize();
 	this->repaint();
 }
 
+//===========================================================================
+void CRenderWidget::showTiledImage(CTiledImage* Image)
+{
+	releaseTiledImage();
+	releaseFrames();
+	m_Pyramid.clear();
+	{
+		QMutexLocker Lock(&m_PyramidState->Mutex);
+		m_PyramidState->Pyramid.clear();
+		++m_PyramidState->Generation;
+	}
+
+	m_TiledImage = Image;
+	connect(Image, &CTiledImage::tileReady, this, &CRenderWidget::onTileReady);
+	connect(Image, &QObject::destroyed, this, [this]()
+	{
+		m_TiledImage = nullptr;
+		this->update();
+	});
+	this->adjustWidgetSize();
+	this->update();
+}
+
+//===========================================================================
+void CRenderWidget::releaseTiledImage()
+{
+	if (!m_TiledImage)
+	{
+		return;
+	}
+	disconnect(m_TiledImage, nullptr, this, nullptr);
+	m_TiledImage = nullptr;
+}
+
+//===========================================================================
+void CRenderWidget::releaseFrames()
+{
+	if (!m_FramePainted)
+	{
+		m_FramePainted = true;
+		++m_FramesDropped;
+	}
+	// A frame submitted before the source stopped must not replace the
+	// image shown next
+	if (m_Frames.swapFront())
+	{
+		++m_FramesDropped;
+	}
+	m_ShowsFrames = false;
+	m_WindowStart = 0;
+}
+
+//===========================================================================
+void CRenderWidget::onTileReady(int Level, int Column, int Row)
+{
+	if (m_TiledImage)
+	{
+		this->update(tileWidgetRect(Level, Column, Row));
+	}
+}
+
+//===========================================================================
+void CRenderWidget::takePyramid()
+{
+	QMutexLocker Lock(&m_PyramidState->Mutex);
+	if (m_PyramidState->Pyramid.isEmpty())
+	{
+		return;
+	}
+	m_Pyramid = std::move(m_PyramidState->Pyramid);
+	m_PyramidState->Pyramid.clear();
+	Lock.unlock();
+	if (!m_ShowsFrames && levelForScale(m_ScaleFactor) > 0)
+	{
+		this->update();
+	}
+}
+
+//===========================================================================
+void CRenderWidget::submitFrame(const QImage& Frame)
+{
+	++m_FramesProduced;
+	SFrame Next;
+	Next.Pyramid = buildPyramid(paintableImage(Frame), m_FrameLevels.load());
+	Next.SubmitTime = steadyNanoseconds();
+	if (m_Frames.write(std::move(Next)) != CTripleBuffer<SFrame>::Published)
+	{
+		++m_FramesDropped;
+	}
+
+	if (!m_PresentQueued.exchange(true))
+	{
+		QMetaObject::invokeMethod(this, "presentFrame", Qt::QueuedConnection);
+	}
+}
+
+//===========================================================================
+void CRenderWidget::presentFrame()
+{
+	// Frames submitted from now on queue the next call
+	m_PresentQueued.store(false);
+	QSize OldImageSize = imageSize();
+	if (!m_Frames.swapFront())
+	{
+		return;
+	}
+
+	if (!m_FramePainted)
+	{
+		++m_FramesDropped;
+	}
+	releaseTiledImage();
+	m_FramePainted = false;
+	m_ShowsFrames = true;
+	this->adjustWidgetSize();
+	if (imageSize() != OldImageSize)
+	{
+		Q_EMIT imageSizeChanged(imageSize());
+	}
+	this->update();
+}
+
+//===========================================================================
+CRenderWidget::SFrameStatistics CRenderWidget::frameStatistics() const
+{
+	SFrameStatistics Statistics;
+	Statistics.Produced = m_FramesProduced.load();
+	Statistics.Shown = m_FramesShown;
+	Statistics.Dropped = m_FramesDropped.load();
+	return Statistics;
+}
+
 //===========================================================================
 void CRenderWidget::paintEvent(QPaintEvent* Event)
 {
-	Q_UNUSED(Event);
+	QRect Exposed = Event->rect() & this->rect();
+	if (m_TiledImage && !Exposed.isEmpty())
+	{
+		QPainter Painter(this);
+		Painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+		paintTiles(Painter, Exposed);
+		if (m_StatisticsOverlayVisible)
+		{
+			paintStatisticsOverlay(Painter);
+		}
+		return;
+	}
+
+	const QVector<QImage>& Pyramid = currentPyramid();
+	if (Pyramid.isEmpty() || Pyramid.first().isNull() || Exposed.isEmpty())
+	{
+		return;
+	}
+
+	// Map the exposed rectangle into the chosen level instead of scaling
+	// the painter, so only the pixels on screen are read. Level 0 is smaller
+	// than the displayed size while a preview is shown.
+	QSize ImageSize = imageSize();
+	double LevelScale = m_ScaleFactor * ImageSize.width() / Pyramid.first().width();
+	int Level = qMin(levelForScale(LevelScale), Pyramid.size() - 1);
+	const QImage& Source = Pyramid.at(Level);
+	double ToSourceX = (double) Source.width()
+		/ (ImageSize.width() * m_ScaleFactor);
+	double ToSourceY = (double) Source.height()
+		/ (ImageSize.height() * m_ScaleFactor);
+	QRectF SourceRect(Exposed.x() * ToSourceX, Exposed.y() * ToSourceY,
+		Exposed.width() * ToSourceX, Exposed.height() * ToSourceY);
+
 	QPainter Painter(this);
 	Painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
-	Painter.setRenderHint(QPainter::Antialiasing, true);
-	Painter.scale(m_ScaleFactor, m_ScaleFactor);
-	Painter.drawPixmap(QPoint(0, 0), m_Image);
+	Painter.drawImage(QRectF(Exposed), Source, SourceRect);
+	if (!m_Overlay.isEmpty())
+	{
+		paintOverlay(Painter, Exposed);
+	}
+	if (m_ShowsFrames && !m_FramePainted)
+	{
+		m_FramePainted = true;
+		++m_FramesShown;
+		recordFramePainted();
+	}
+	if (m_StatisticsOverlayVisible)
+	{
+		paintStatisticsOverlay(Painter);
+	}
+}
+
+//============================================================================
+void CRenderWidget::moveEvent(QMoveEvent* MoveEvent)
+{
+	QWidget::moveEvent(MoveEvent);
+	if (m_StatisticsOverlayVisible)
+	{
+		this->update();
+	}
+}
+
+//============================================================================
+void CRenderWidget::recordFramePainted()
+{
+	// Time until the paint call, the compositor adds its own latency
+	qint64 Now = steadyNanoseconds();
+	if (!m_WindowStart)
+	{
+		m_WindowStart = Now;
+		m_WindowFrames = 0;
+		m_WindowLatency = 0;
+	}
+	++m_WindowFrames;
+	m_WindowLatency += Now - m_Frames.front().SubmitTime;
+	qint64 Elapsed = Now - m_WindowStart;
+	if (Elapsed < StatisticsWindow)
+	{
+		return;
+	}
+
+	m_StatisticsText = tr("%1 fps  latency %2 ms  dropped %3")
+		.arg(m_WindowFrames * 1e9 / Elapsed, 0, 'f', 1)
+		.arg(m_WindowLatency / 1e6 / m_WindowFrames, 0, 'f', 1)
+		.arg(m_FramesDropped.load());
+	m_WindowStart = Now;
+	m_WindowFrames = 0;
+	m_WindowLatency = 0;
+}
+
+//============================================================================
+void CRenderWidget::paintStatisticsOverlay(QPainter& Painter)
+{
+	QString Text = m_StatisticsText.isEmpty() ? tr("Waiting for frames")
+		: m_StatisticsText;
+	QRect Visible = this->visibleRegion().boundingRect();
+	QRect TextRect = this->fontMetrics().boundingRect(Text).adjusted(-4, -2, 4, 2);
+	TextRect.moveTopLeft(Visible.topLeft() + QPoint(4, 4));
+	Painter.fillRect(TextRect, QColor(0, 0, 0, 160));
+	Painter.setPen(Qt::white);
+	Painter.drawText(TextRect, Qt::AlignCenter, Text);
+}
+
+//============================================================================
+void CRenderWidget::paintOverlay(QPainter& Painter, const QRect& Exposed)
+{
+	const QSize OverlaySize = m_Overlay.first().size();
+	QRect Covered = Exposed & QRect(0, 0, int(ceil(OverlaySize.width() * m_ScaleFactor)),
+		int(ceil(OverlaySize.height() * m_ScaleFactor)));
+	if (Covered.isEmpty())
+	{
+		return;
+	}
+
+	int Level = qMin(levelForScale(m_ScaleFactor), m_Overlay.size() - 1);
+	const QImage& Source = m_Overlay.at(Level);
+	double ToSourceX = (double) Source.width() / (OverlaySize.width() * m_ScaleFactor);
+	double ToSourceY = (double) Source.height() / (OverlaySize.height() * m_ScaleFactor);
+	QRectF SourceRect(Covered.x() * ToSourceX, Covered.y() * ToSourceY,
+		Covered.width() * ToSourceX, Covered.height() * ToSourceY);
+	// Zoomed in, overlay pixels stay sharp blocks over their image pixels
+	Painter.save();
+	Painter.setRenderHint(QPainter::SmoothPixmapTransform, ToSourceX > 1);
+	Painter.drawImage(QRectF(Covered), Source, SourceRect);
+	Painter.restore();
+}
+
+//============================================================================
+void CRenderWidget::setOverlay(const QVector<QImage>& Levels)
+{
+	m_Overlay = Levels;
+	this->update();
+}
+
+//============================================================================
+double CRenderWidget::scaleFactor() const
+{
+	return m_ScaleFactor;
+}
+
+//============================================================================
+void CRenderWidget::setStatisticsOverlayVisible(bool Visible)
+{
+	if (m_StatisticsOverlayVisible == Visible)
+	{
+		return;
+	}
+	m_StatisticsOverlayVisible = Visible;
+	this->update();
+}
+
+//============================================================================
+bool CRenderWidget::isStatisticsOverlayVisible() const
+{
+	return m_StatisticsOverlayVisible;
+}
+
+//============================================================================
+void CRenderWidget::paintTiles(QPainter& Painter, const QRect& Exposed)
+{
+	int Level = qMin(levelForScale(m_ScaleFactor), m_TiledImage->levelCount() - 1);
+	// Widget pixels per pixel of the level
+	double Scale = m_ScaleFactor * (1 << Level);
+	QRect LevelRect = QRect(
+		QPoint(int(floor(Exposed.left() / Scale)), int(floor(Exposed.top() / Scale))),
+		QPoint(int(ceil((Exposed.right() + 1) / Scale)) - 1,
+			int(ceil((Exposed.bottom() + 1) / Scale)) - 1))
+		& QRect(QPoint(0, 0), m_TiledImage->levelSize(Level));
+	if (LevelRect.isEmpty())
+	{
+		return;
+	}
+
+	const int TileSize = CTiledImage::TileSize;
+	for (int Row = LevelRect.top() / TileSize; Row <= LevelRect.bottom() / TileSize; ++Row)
+	{
+		for (int Column = LevelRect.left() / TileSize; Column <= LevelRect.right() / TileSize; ++Column)
+		{
+			QRect Target = tileWidgetRect(Level, Column, Row);
+			QImage Tile = m_TiledImage->tile(Level, Column, Row);
+			if (!Tile.isNull())
+			{
+				Painter.drawImage(Target, Tile);
+				continue;
+			}
+
+			// While the tile is decoded, stretch the part of the closest
+			// coarser level that is cached
+			QRect TileRect = m_TiledImage->tileRect(Level, Column, Row);
+			bool Drawn = false;
+			for (int Coarser = Level + 1; Coarser < m_TiledImage->levelCount() && !Drawn; ++Coarser)
+			{
+				int Shift = Coarser - Level;
+				QImage Parent = m_TiledImage->cachedTile(Coarser, Column >> Shift, Row >> Shift);
+				if (Parent.isNull())
+				{
+					continue;
+				}
+				QRect ParentRect = m_TiledImage->tileRect(Coarser, Column >> Shift, Row >> Shift);
+				double Factor = 1.0 / (1 << Shift);
+				QRectF Source(TileRect.x() * Factor - ParentRect.x(),
+					TileRect.y() * Factor - ParentRect.y(),
+					TileRect.width() * Factor, TileRect.height() * Factor);
+				Painter.drawImage(QRectF(Target), Parent, Source);
+				Drawn = true;
+			}
+			if (!Drawn)
+			{
+				Painter.fillRect(Target, this->palette().color(QPalette::Mid));
+			}
+		}
+	}
+}
+
+//============================================================================
+QRect CRenderWidget::tileWidgetRect(int Level, int Column, int Row) const
+{
+	QRect TileRect = m_TiledImage->tileRect(Level, Column, Row);
+	double Scale = m_ScaleFactor * (1 << Level);
+	// Rounding both edges keeps neighbouring tiles free of gaps
+	return QRect(QPoint(qRound(TileRect.left() * Scale), qRound(TileRect.top() * Scale)),
+		QPoint(qRound((TileRect.right() + 1) * Scale) - 1,
+			qRound((TileRect.bottom() + 1) * Scale) - 1));
 }
 
 //============================================================================
@@ -73,6 +540,13 @@ void CRenderWidget::normalSize()
 	this->adjustWidgetSize();
 }
 
+//============================================================================
+void CRenderWidget::setScaleFactor(double ScaleFactor)
+{
+	m_ScaleFactor = ScaleFactor;
+	this->adjustWidgetSize();
+}
+
 //============================================================================
 void CRenderWidget::scaleImage(double ScaleFactor)
 {
@@ -83,23 +557,66 @@ void CRenderWidget::scaleImage(double ScaleFactor)
 //============================================================================
 void CRenderWidget::adjustWidgetSize()
 {
-	QSize ScaledImageSize = m_Image.size() * m_ScaleFactor;
+	m_FrameLevels.store(levelForScale(m_ScaleFactor) + 1);
+	QSize ScaledImageSize = imageSize() * m_ScaleFactor;
 	if (ScaledImageSize != this->size())
 	{
 		this->setFixedSize(ScaledImageSize);
 	}
 }
 
+//============================================================================
+QSize CRenderWidget::imageSize() const
+{
+	if (m_TiledImage)
+	{
+		return m_TiledImage->size();
+	}
+	if (m_ShowsFrames)
+	{
+		const QVector<QImage>& Pyramid = m_Frames.front().Pyramid;
+		return Pyramid.isEmpty() ? QSize() : Pyramid.first().size();
+	}
+	return m_ImageSize;
+}
+
+//============================================================================
+const QVector<QImage>& CRenderWidget::currentPyramid() const
+{
+	return m_ShowsFrames ? m_Frames.front().Pyramid : m_Pyramid;
+}
+
+//============================================================================
+QImage CRenderWidget::currentImage() const
+{
+	const QVector<QImage>& Pyramid = currentPyramid();
+	return (m_TiledImage || Pyramid.isEmpty()) ? QImage() : Pyramid.first();
+}
+
+//============================================================================
+int CRenderWidget::levelForScale(double ScaleFactor)
+{
+	// Each level halves the resolution, so level n suffices up to 2^-n
+	int Level = 0;
+	while (ScaleFactor <= 0.5 && Level < 16)
+	{
+		ScaleFactor *= 2;
+		++Level;
+	}
+	return Level;
+}
+
 //============================================================================
 void CRenderWidget::scaleToSize(const QSize& TargetSize)
 {
-	if (m_Image.isNull())
+	QSize ImageSize = imageSize();
+	if (ImageSize.isEmpty())
 	{
 		return;
 	}
-	double ScaleFactorH = (double) TargetSize.width() / m_Image.size().width();
+	double ScaleFactorH = (double) TargetSize.width() / ImageSize.width();
 	double ScaleFactorV = (double) TargetSize.height()
-	    / m_Image.size().height();
+	    / ImageSize.height();
 	m_ScaleFactor = (ScaleFactorH < ScaleFactorV) ? ScaleFactorH : ScaleFactorV;
 	this->adjustWidgetSize();
 }
@@ -11,23 +11,95 @@
 //                                   INCLUDES
 //============================================================================
 #include <QWidget>
-#include <QPixmap>
+#include <QImage>
+#include <QVector>
 
-//============================================================================
-//                           FORWARD DECLARATIONS
-//============================================================================
-class QImage;
+#include <atomic>
+#include <memory>
+
+#include "TripleBuffer.h"
 
+struct RenderWidgetPyramidState;
+class CTiledImage;
+class QPainter;
 
 /**
  * @brief Widget for fast display of images (i.e. for video capture devices)
+ *
+ * showImage() shows a single image synchronously. Video sources call
+ * submitFrame() instead, from any thread: frames go through a lock-free
+ * triple buffer, so the widget always paints the newest frame and frames
+ * that were replaced before they could be painted are dropped. At most one
+ * repaint request is queued at a time, so repaints happen at display rate
+ * no matter how fast frames arrive.
+ *
+ * Images are kept as a mip pyramid, each level half the size of the one
+ * before. A paint draws only the exposed rectangle, taken from the smallest
+ * level that still has at least the displayed resolution, so zooming out of
+ * large images and scrolling at high zoom both touch few pixels. The
+ * pyramid of a still image is built on the global thread pool, the image
+ * itself is painted until it is ready. Frames get the levels the current
+ * zoom needs, built in the thread submitting them.
+ *
+ * Images too large to decode at once are shown with showTiledImage(). Their
+ * tiles are painted from the level matching the zoom; tiles still being
+ * decoded are drawn from a cached coarser level, or as a placeholder.
+ *
+ * An optional overlay shows the frames painted per second, the average
+ * time from submitFrame() to the first paint of a frame and the number of
+ * dropped frames.
+ *
+ * Another image, i.e. a difference heatmap, can be drawn on top of the
+ * image with setOverlay().
  */
 class CRenderWidget : public QWidget
 {
 	Q_OBJECT
+public:
+	/**
+	 * @brief Counters of the frame pipeline
+	 */
+	struct SFrameStatistics
+	{
+		quint64 Produced = 0;///< frames passed to submitFrame()
+		quint64 Shown = 0;///< frames painted at least once
+		quint64 Dropped = 0;///< frames replaced by newer ones before painting
+	};
+
+	/**
+	 * @brief Levels are no smaller than this in either direction
+	 */
+	static constexpr int MinLevelSize = 64;
+
 private:
-	QPixmap m_Image;
+	/**
+	 * @brief Frame waiting in or taken from the triple buffer
+	 */
+	struct SFrame
+	{
+		QVector<QImage> Pyramid;
+		qint64 SubmitTime = 0;///< steady clock time of submitFrame() in ns
+	};
+
+	QVector<QImage> m_Pyramid;///< still image and its levels
+	QSize m_ImageSize;///< size the still image is displayed as
 	double m_ScaleFactor;
+	CTripleBuffer<SFrame> m_Frames;
+	bool m_ShowsFrames = false;///< paint m_Frames.front() instead of m_Pyramid
+	bool m_FramePainted = true;
+	std::atomic<bool> m_PresentQueued{false};
+	std::atomic<quint64> m_FramesProduced{0};
+	std::atomic<quint64> m_FramesDropped{0};
+	quint64 m_FramesShown = 0;
+	std::atomic<int> m_FrameLevels{1};///< levels submitFrame() builds
+	std::shared_ptr<RenderWidgetPyramidState> m_PyramidState;
+	CTiledImage* m_TiledImage = nullptr;
+	bool m_StatisticsOverlayVisible = false;
+	QString m_StatisticsText;///< overlay text of the last full window
+	QVector<QImage> m_Overlay;///< levels of the image drawn on top, see setOverlay()
+	qint64 m_WindowStart = 0;///< start of the statistics window in ns, 0 if none
+	quint64 m_WindowFrames = 0;
+	qint64 m_WindowLatency = 0;///< sum of the frame latencies in ns
 
 protected:
 	/**
@@ -35,6 +107,12 @@ protected:
 	 */
 	void paintEvent(QPaintEvent* PaintEvent);
 
+	/**
+	 * @brief Repaints the statistics overlay, which stays at the top left
+	 * of the visible area while the widget moves in its scroll area.
+	 */
+	void moveEvent(QMoveEvent* MoveEvent);
+
 	/**
 	 * @brief Change scale factor
 	 */
@@ -45,6 +123,75 @@ protected:
 	 */
 	void adjustWidgetSize();
 
+	/**
+	 * @brief Size of the image or frame being shown
+	 */
+	QSize imageSize() const;
+
+	/**
+	 * @brief The pyramid being shown, level 0 is the image itself
+	 */
+	const QVector<QImage>& currentPyramid() const;
+
+	/**
+	 * @brief Pyramid level with the least pixels not below the resolution
+	 * shown at the given scale factor.
+	 */
+	static int levelForScale(double ScaleFactor);
+
+	/**
+	 * @brief Paints the exposed rectangle from the tiles of m_TiledImage.
+	 */
+	void paintTiles(QPainter& Painter, const QRect& Exposed);
+
+	/**
+	 * @brief Area of a tile of m_TiledImage in widget coordinates
+	 */
+	QRect tileWidgetRect(int Level, int Column, int Row) const;
+
+	/**
+	 * @brief Stops showing the tiled image, if any.
+	 */
+	void releaseTiledImage();
+
+	/**
+	 * @brief Stops showing frames: drops a frame still waiting in the buffer
+	 * and restarts the statistics window.
+	 */
+	void releaseFrames();
+
+	/**
+	 * @brief Accounts the first paint of the front frame to the statistics
+	 * window, updating the overlay text once a second.
+	 */
+	void recordFramePainted();
+
+	/**
+	 * @brief Draws the statistics overlay.
+	 */
+	void paintStatisticsOverlay(QPainter& Painter);
+
+	/**
+	 * @brief Paints the exposed part of the overlay image
+	 */
+	void paintOverlay(QPainter& Painter, const QRect& Exposed);
+
+protected slots:
+	/**
+	 * @brief Takes the newest submitted frame and schedules a repaint.
+	 */
+	void presentFrame();
+
+	/**
+	 * @brief Takes the pyramid built for the current still image.
+	 */
+	void takePyramid();
+
+	/**
+	 * @brief Repaints the area of a decoded tile.
+	 */
+	void onTileReady(int Level, int Column, int Row);
+
 public:
 	/**
 	 * Constructor
@@ -57,6 +204,52 @@ public:
 	 */
 	virtual ~CRenderWidget();
 
+	/**
+	 * @brief Queues a frame for display.
+	 * Thread safe and non-blocking. Frames are converted to a format that
+	 * paints without conversion in the calling thread.
+	 */
+	void submitFrame(const QImage& Frame);
+
+	/**
+	 * @brief Shows a tiled image until another image or frame is shown.
+	 * The widget does not take ownership of the image.
+	 */
+	void showTiledImage(CTiledImage* Image);
+
+	/**
+	 * @brief Returns the counters of the frame pipeline.
+	 * Frames still waiting in the buffer are neither shown nor dropped yet.
+	 */
+	SFrameStatistics frameStatistics() const;
+
+	/**
+	 * @brief The still image or frame being shown, in the format it is
+	 * painted from. It may be a preview smaller than the displayed size.
+	 * Null while a tiled image is shown.
+	 */
+	QImage currentImage() const;
+
+	/**
+	 * @brief Shows or hides the frame statistics overlay.
+	 */
+	void setStatisticsOverlayVisible(bool Visible);
+	bool isStatisticsOverlayVisible() const;
+
+	/**
+	 * @brief Draws an image on top of the image shown, aligned to its top
+	 * left corner, with one image pixel per pixel of level 0. Further
+	 * levels are each half the size of the one before and are painted when
+	 * zoomed out, like the levels of the image. An empty vector removes the
+	 * overlay.
+	 */
+	void setOverlay(const QVector<QImage>& Levels);
+
+	/**
+	 * @brief Displayed pixels per image pixel
+	 */
+	double scaleFactor() const;
+
 signals:
 	/**
 	 * @brief Signalize change of captured image size.
@@ -67,8 +260,10 @@ signals:
 public slots:
 	/**
 	 * @brief Show new image in render widget.
+	 * @param[in] DisplaySize Size to display the image as, i.e. the full size
+	 * of the image a preview was decoded from. Defaults to the image size.
 	 */
-	void showImage(const QImage& Image);
+	void showImage(const QImage& Image, const QSize& DisplaySize = QSize());
 
 	/**
 	 * @brief Zoom into the scene.
@@ -101,6 +296,12 @@ public slots:
 	 */
 	void normalSize();
 
+	/**
+	 * @brief Displays the image with ScaleFactor displayed pixels per
+	 * image pixel.
+	 */
+	void setScaleFactor(double ScaleFactor);
+
 	/**
 	 * @brief Scales the wiget and its content image to the given TargetSize
 	 */
@@ -0,0 +1,265 @@
+//============================================================================
+/// \file   ThumbnailCache.cpp
+/// \brief  Implementation of CThumbnailCache
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ThumbnailCache.h"
+#include "DecodeQueue.h"
+#include "LruImageCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <atomic>
+
+
+namespace
+{
+/**
+ * Converts a thumbnail to a format QPainter draws without conversion.
+ */
+QImage paintableThumbnail(const QImage& Image)
+{
+	if (Image.format() == QImage::Format_RGB32
+	 || Image.format() == QImage::Format_ARGB32_Premultiplied)
+	{
+		return Image;
+	}
+	return Image.convertToFormat(Image.hasAlphaChannel()
+		? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+}
+} // namespace
+
+
+/**
+ * Private data of CThumbnailCache, shared with the workers so that the
+ * cache can go while they finish
+ */
+struct ThumbnailCachePrivate
+{
+	QMutex ThisMutex;///< guards _this, held while signals are emitted
+	CThumbnailCache* _this;///< null once the public object is gone
+	int MaxWorkers = 1;
+
+	mutable QMutex Mutex;///< guards the members below
+	CLruImageCache<SThumbnailKey> Cache{CThumbnailCache::DefaultMemoryBytes};
+	CDecodeQueue<SThumbnailKey> Queue{CThumbnailCache::MaxQueued};
+	QHash<QString, SThumbnailKey> FailedFiles;///< the version that failed
+	QString DiskDirectory;
+	std::atomic<bool> Stopping{false};
+
+	ThumbnailCachePrivate(CThumbnailCache* _public) : _this(_public) {}
+
+	/**
+	 * Worker thread loop of Queue, loads queued files until it is empty
+	 */
+	void runWorker();
+
+	/**
+	 * Reads the thumbnail from the disk cache or decodes and stores it
+	 */
+	static QImage loadThumbnail(const SThumbnailKey& File,
+		const QString& DiskDirectory);
+};
+
+
+//============================================================================
+void ThumbnailCachePrivate::runWorker()
+{
+	QMutexLocker Lock(&Mutex);
+	while (!Stopping && !Queue.isEmpty())
+	{
+		SThumbnailKey File = Queue.takeNext();
+		QString Directory = DiskDirectory;
+		Lock.unlock();
+		QImage Thumbnail = loadThumbnail(File, Directory);
+		Lock.relock();
+		Queue.finished(File);
+		if (Thumbnail.isNull())
+		{
+			FailedFiles.insert(File.FileName, File);
+		}
+		else
+		{
+			Cache.insert(File, Thumbnail);
+		}
+		Lock.unlock();
+		{
+			QMutexLocker ThisLock(&ThisMutex);
+			if (_this)
+			{
+				Q_EMIT _this->thumbnailReady(File.FileName);
+			}
+		}
+		Lock.relock();
+	}
+	Queue.workerFinished();
+}
+
+
+//============================================================================
+QImage ThumbnailCachePrivate::loadThumbnail(const SThumbnailKey& File,
+	const QString& DiskDirectory)
+{
+	const int Size = CThumbnailCache::ThumbnailSize;
+	const QString& FileName = File.FileName;
+	QString CacheFileName;
+	if (!DiskDirectory.isEmpty())
+	{
+		QByteArray Key = QString("%1|%2|%3").arg(FileName,
+			QString::number(File.LastModified), QString::number(Size)).toUtf8();
+		QString Hash = QString::fromLatin1(
+			QCryptographicHash::hash(Key, QCryptographicHash::Sha1).toHex());
+		// Two levels keep directories small for large collections
+		CacheFileName = DiskDirectory + QLatin1Char('/') + Hash.left(2)
+			+ QLatin1Char('/') + Hash + QLatin1String(".png");
+		QImage Cached(CacheFileName, "PNG");
+		if (!Cached.isNull())
+		{
+			return paintableThumbnail(Cached);
+		}
+	}
+
+	QImageReader Reader(FileName);
+	Reader.setAutoTransform(true);
+	QSize ImageSize = Reader.size();
+	QSize Box(Size, Size);
+	if (ImageSize.isValid()
+	 && (ImageSize.width() > Size || ImageSize.height() > Size))
+	{
+		// The box is square, so rotation by the auto transform does not
+		// matter
+		Reader.setScaledSize(ImageSize.scaled(Box, Qt::KeepAspectRatio));
+	}
+	QImage Thumbnail = Reader.read();
+	if (Thumbnail.isNull())
+	{
+		return Thumbnail;
+	}
+	if (Thumbnail.width() > Size || Thumbnail.height() > Size)
+	{
+		Thumbnail = Thumbnail.scaled(Box, Qt::KeepAspectRatio,
+			Qt::SmoothTransformation);
+	}
+
+	if (!CacheFileName.isEmpty()
+	 && QDir().mkpath(QFileInfo(CacheFileName).path()))
+	{
+		// QSaveFile never leaves a truncated thumbnail behind
+		QSaveFile CacheFile(CacheFileName);
+		if (CacheFile.open(QIODevice::WriteOnly) && Thumbnail.save(&CacheFile, "PNG"))
+		{
+			CacheFile.commit();
+		}
+	}
+	return paintableThumbnail(Thumbnail);
+}
+
+
+//============================================================================
+SThumbnailKey::SThumbnailKey(const QFileInfo& File)
+	: FileName(File.absoluteFilePath()),
+	  LastModified(File.lastModified().toMSecsSinceEpoch()),
+	  Size(File.size())
+{
+}
+
+
+//============================================================================
+CThumbnailCache::CThumbnailCache(QObject* Parent)
+	: QObject(Parent),
+	  d(std::make_shared<ThumbnailCachePrivate>(this))
+{
+	d->MaxWorkers = CDecodeQueue<SThumbnailKey>::defaultMaxWorkers();
+	QString CacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if (!CacheLocation.isEmpty())
+	{
+		d->DiskDirectory = CacheLocation + QLatin1String("/thumbnails");
+	}
+}
+
+
+//============================================================================
+CThumbnailCache::~CThumbnailCache()
+{
+	{
+		QMutexLocker Lock(&d->Mutex);
+		d->Stopping = true;
+		d->Queue.clear();
+	}
+	QMutexLocker ThisLock(&d->ThisMutex);
+	d->_this = nullptr;
+}
+
+
+//============================================================================
+QImage CThumbnailCache::thumbnail(const SThumbnailKey& File)
+{
+	QMutexLocker Lock(&d->Mutex);
+	QImage Thumbnail = d->Cache.find(File);
+	if (!Thumbnail.isNull() || d->Stopping || d->Queue.contains(File))
+	{
+		return Thumbnail;
+	}
+	auto Failed = d->FailedFiles.find(File.FileName);
+	if (Failed != d->FailedFiles.end())
+	{
+		if (Failed.value() == File)
+		{
+			return Thumbnail;
+		}
+		// The file changed since it failed
+		d->FailedFiles.erase(Failed);
+	}
+
+	d->Queue.push(File);
+	d->Queue.startWorkers(d, d->MaxWorkers);
+	return Thumbnail;
+}
+
+
+//============================================================================
+bool CThumbnailCache::hasFailed(const SThumbnailKey& File) const
+{
+	QMutexLocker Lock(&d->Mutex);
+	auto Failed = d->FailedFiles.constFind(File.FileName);
+	return Failed != d->FailedFiles.constEnd() && Failed.value() == File;
+}
+
+
+//============================================================================
+void CThumbnailCache::clearQueue()
+{
+	QMutexLocker Lock(&d->Mutex);
+	d->Queue.clear();
+}
+
+
+//============================================================================
+void CThumbnailCache::setDiskCacheDirectory(const QString& Path)
+{
+	QMutexLocker Lock(&d->Mutex);
+	d->DiskDirectory = Path;
+}
+
+
+//============================================================================
+QString CThumbnailCache::diskCacheDirectory() const
+{
+	QMutexLocker Lock(&d->Mutex);
+	return d->DiskDirectory;
+}
+
+//---------------------------------------------------------------------------
+// EOF ThumbnailCache.cpp
@@ -0,0 +1,136 @@
+#ifndef ThumbnailCacheH
+#define ThumbnailCacheH
+//============================================================================
+/// \file   ThumbnailCache.h
+/// \brief  Declaration of CThumbnailCache
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QString>
+
+#include <memory>
+
+class QFileInfo;
+struct ThumbnailCachePrivate;
+
+/**
+ * @brief A file as it was when it was listed. Thumbnails are looked up by
+ * the file's modification time and size too, so a file that changed gets
+ * a new thumbnail.
+ */
+struct SThumbnailKey
+{
+	QString FileName;
+	qint64 LastModified = 0;///< ms since epoch
+	qint64 Size = 0;
+
+	SThumbnailKey() = default;
+	explicit SThumbnailKey(const QFileInfo& File);
+
+	bool operator==(const SThumbnailKey& Other) const
+	{
+		return LastModified == Other.LastModified && Size == Other.Size
+			&& FileName == Other.FileName;
+	}
+};
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+inline size_t qHash(const SThumbnailKey& Key, size_t Seed = 0)
+#else
+inline uint qHash(const SThumbnailKey& Key, uint Seed = 0)
+#endif
+{
+	return qHash(Key.FileName, Seed) ^ qHash(Key.LastModified, Seed)
+		^ qHash(Key.Size, Seed);
+}
+
+/**
+ * @brief Thumbnails of image files, decoded in the background and kept in
+ * memory and on disk.
+ *
+ * thumbnail() never blocks: it returns a thumbnail from memory or a null
+ * image and queues the file in a CDecodeQueue, so whatever a view painted
+ * last, i.e. the visible rows, is loaded before rows scrolled past.
+ * Requests beyond MaxQueued are forgotten, oldest first, and asked for
+ * again when their rows are painted again.
+ *
+ * Workers first look for the thumbnail in the disk cache, where thumbnails
+ * are stored as PNG files named after a hash of the file path, its
+ * modification time and the thumbnail size. Otherwise they decode the file,
+ * letting the image handler scale while decoding where it can, and store
+ * the result. Files that fail to decode are not queued again until their
+ * modification time or size changes.
+ */
+class CThumbnailCache : public QObject
+{
+	Q_OBJECT
+public:
+	/**
+	 * @brief Thumbnails fit into a square of this many pixels
+	 */
+	static constexpr int ThumbnailSize = 128;
+
+	/**
+	 * @brief Thumbnails kept in memory, ~1000 thumbnails
+	 */
+	static constexpr qint64 DefaultMemoryBytes = qint64(64) * 1024 * 1024;
+
+	/**
+	 * @brief Files waiting for a worker
+	 */
+	static constexpr int MaxQueued = 512;
+
+	/**
+	 * @brief Creates a cache storing thumbnails in the "thumbnails"
+	 * directory of QStandardPaths::CacheLocation.
+	 */
+	explicit CThumbnailCache(QObject* Parent = nullptr);
+
+	/**
+	 * Does not wait for running workers, they drop their results
+	 */
+	virtual ~CThumbnailCache();
+
+	/**
+	 * @brief Returns the thumbnail of the file if it is in memory.
+	 * Otherwise returns a null image and queues the file, thumbnailReady()
+	 * is emitted when it is done.
+	 */
+	QImage thumbnail(const SThumbnailKey& File);
+
+	/**
+	 * @brief True if this version of the file could not be decoded
+	 */
+	bool hasFailed(const SThumbnailKey& File) const;
+
+	/**
+	 * @brief Forgets all queued files, i.e. when another directory is shown.
+	 */
+	void clearQueue();
+
+	/**
+	 * @brief Changes the directory thumbnails are stored in. An empty
+	 * path disables the disk cache.
+	 */
+	void setDiskCacheDirectory(const QString& Path);
+	QString diskCacheDirectory() const;
+
+signals:
+	/**
+	 * @brief Emitted from a worker thread when the thumbnail of a queued
+	 * file is in memory or the file failed to decode.
+	 */
+	void thumbnailReady(const QString& FileName);
+
+private:
+	std::shared_ptr<ThumbnailCachePrivate> d;
+	friend struct ThumbnailCachePrivate;
+}; // class CThumbnailCache
+
+//---------------------------------------------------------------------------
+#endif // ThumbnailCacheH
@@ -0,0 +1,321 @@
+//============================================================================
+/// \file   ThumbnailModel.cpp
+/// \brief  Implementation of CThumbnailModel
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "ThumbnailModel.h"
+#include "ThumbnailCache.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+
+/**
+ * Hands the result of a listing job to the model. The model pointer is reset
+ * when the model lists another directory or is destroyed, so a late job
+ * drops its result.
+ */
+struct ThumbnailListingState
+{
+	QMutex Mutex;
+	CThumbnailModel* Model;
+	std::atomic<bool> Canceled{false};
+	QVector<SThumbnailKey> Files;///< guarded by Mutex
+	bool Done = false;///< guarded by Mutex
+
+	explicit ThumbnailListingState(CThumbnailModel* _Model) : Model(_Model) {}
+};
+
+
+namespace
+{
+/**
+ * Lists and sorts the image files of a directory
+ */
+class CListingJob : public QRunnable
+{
+private:
+	std::shared_ptr<ThumbnailListingState> m_State;
+	QString m_Directory;
+
+public:
+	CListingJob(std::shared_ptr<ThumbnailListingState> State, const QString& Directory)
+		: m_State(std::move(State)), m_Directory(Directory) {}
+
+	void run() override
+	{
+		QStringList NameFilters;
+		for (const QByteArray& Format : QImageReader::supportedImageFormats())
+		{
+			NameFilters.append(QLatin1String("*.") + QString::fromLatin1(Format));
+		}
+
+		// Modification time and size are read here, off the GUI thread, to
+		// key the thumbnails
+		QVector<SThumbnailKey> Files;
+		QDirIterator It(m_Directory, NameFilters, QDir::Files | QDir::Readable);
+		while (It.hasNext() && !m_State->Canceled)
+		{
+			It.next();
+			Files.append(SThumbnailKey(It.fileInfo()));
+		}
+		if (m_State->Canceled)
+		{
+			return;
+		}
+		std::sort(Files.begin(), Files.end(), [](const SThumbnailKey& a, const SThumbnailKey& b)
+		{
+			return a.FileName.compare(b.FileName, Qt::CaseInsensitive) < 0;
+		});
+
+		QMutexLocker Lock(&m_State->Mutex);
+		if (!m_State->Model)
+		{
+			return;
+		}
+		m_State->Files = std::move(Files);
+		m_State->Done = true;
+		QMetaObject::invokeMethod(m_State->Model, "takeListedFiles", Qt::QueuedConnection);
+	}
+};
+} // namespace
+
+
+/**
+ * Private data of CThumbnailModel
+ */
+struct ThumbnailModelPrivate
+{
+	CThumbnailModel* _this;
+	CThumbnailCache* Thumbnails;
+	QString Directory;
+	QVector<SThumbnailKey> Files;
+	QHash<QString, int> RowByFile;
+	std::shared_ptr<ThumbnailListingState> Listing;
+	QPixmap Placeholder;
+
+	ThumbnailModelPrivate(CThumbnailModel* _public) : _this(_public) {}
+
+	/**
+	 * Drops the result of a running listing job
+	 */
+	void cancelListing();
+
+	/**
+	 * Returns the decoration of the file, converted to a pixmap once and
+	 * kept in QPixmapCache, so painting does not convert it every time.
+	 */
+	QPixmap thumbnailPixmap(const SThumbnailKey& File);
+};
+
+
+//============================================================================
+void ThumbnailModelPrivate::cancelListing()
+{
+	if (!Listing)
+	{
+		return;
+	}
+	Listing->Canceled = true;
+	QMutexLocker Lock(&Listing->Mutex);
+	Listing->Model = nullptr;
+	Lock.unlock();
+	Listing.reset();
+}
+
+
+//============================================================================
+QPixmap ThumbnailModelPrivate::thumbnailPixmap(const SThumbnailKey& File)
+{
+	// Keyed like the thumbnail cache, a changed file gets a new pixmap
+	QString Key = QString("thumbnail:%1|%2|%3").arg(File.FileName,
+		QString::number(File.LastModified), QString::number(File.Size));
+	QPixmap Pixmap;
+	if (QPixmapCache::find(Key, &Pixmap))
+	{
+		return Pixmap;
+	}
+	QImage Thumbnail = Thumbnails->thumbnail(File);
+	if (Thumbnail.isNull())
+	{
+		return Placeholder;
+	}
+	Pixmap = QPixmap::fromImage(Thumbnail);
+	QPixmapCache::insert(Key, Pixmap);
+	return Pixmap;
+}
+
+
+//============================================================================
+CThumbnailModel::CThumbnailModel(QObject* Parent)
+	: QAbstractListModel(Parent),
+	  d(new ThumbnailModelPrivate(this))
+{
+	d->Thumbnails = new CThumbnailCache(this);
+	connect(d->Thumbnails, &CThumbnailCache::thumbnailReady, this,
+		&CThumbnailModel::onThumbnailReady, Qt::QueuedConnection);
+
+	// Fills the cell while the thumbnail is decoded, so rows do not change
+	// their look from empty to image
+	const int Size = CThumbnailCache::ThumbnailSize;
+	d->Placeholder = QPixmap(Size, Size);
+	d->Placeholder.fill(Qt::transparent);
+	QPainter Painter(&d->Placeholder);
+	Painter.setPen(Qt::NoPen);
+	Painter.setBrush(QColor(128, 128, 128, 48));
+	Painter.drawRect(Size / 8, Size / 8, Size * 3 / 4, Size * 3 / 4);
+}
+
+
+//============================================================================
+CThumbnailModel::~CThumbnailModel()
+{
+	d->cancelListing();
+	delete d;
+}
+
+
+//============================================================================
+void CThumbnailModel::setDirectory(const QString& Path)
+{
+	d->cancelListing();
+	d->Thumbnails->clearQueue();
+	beginResetModel();
+	d->Directory = QDir(Path).absolutePath();
+	d->Files.clear();
+	d->RowByFile.clear();
+	endResetModel();
+
+	d->Listing = std::make_shared<ThumbnailListingState>(this);
+	QThreadPool::globalInstance()->start(new CListingJob(d->Listing, d->Directory));
+}
+
+
+//============================================================================
+QString CThumbnailModel::directory() const
+{
+	return d->Directory;
+}
+
+
+//============================================================================
+bool CThumbnailModel::isListing() const
+{
+	return d->Listing != nullptr;
+}
+
+
+//============================================================================
+QString CThumbnailModel::filePath(const QModelIndex& Index) const
+{
+	if (!Index.isValid() || Index.row() >= d->Files.size())
+	{
+		return QString();
+	}
+	return d->Files.at(Index.row()).FileName;
+}
+
+
+//============================================================================
+CThumbnailCache* CThumbnailModel::thumbnailCache() const
+{
+	return d->Thumbnails;
+}
+
+
+//============================================================================
+int CThumbnailModel::rowCount(const QModelIndex& Parent) const
+{
+	return Parent.isValid() ? 0 : d->Files.size();
+}
+
+
+//============================================================================
+QVariant CThumbnailModel::data(const QModelIndex& Index, int Role) const
+{
+	if (!Index.isValid() || Index.row() >= d->Files.size())
+	{
+		return QVariant();
+	}
+
+	const SThumbnailKey& File = d->Files.at(Index.row());
+	const QString& FileName = File.FileName;
+	switch (Role)
+	{
+	case Qt::DisplayRole: return QFileInfo(FileName).fileName();
+	case Qt::ToolTipRole:
+		return d->Thumbnails->hasFailed(File)
+			? tr("%1\nCannot be decoded").arg(QDir::toNativeSeparators(FileName))
+			: QDir::toNativeSeparators(FileName);
+	case Qt::DecorationRole: return d->thumbnailPixmap(File);
+	case FilePathRole: return FileName;
+	default: break;
+	}
+	return QVariant();
+}
+
+
+//============================================================================
+void CThumbnailModel::takeListedFiles()
+{
+	if (!d->Listing)
+	{
+		return;
+	}
+	QMutexLocker Lock(&d->Listing->Mutex);
+	if (!d->Listing->Done)
+	{
+		return;
+	}
+	QVector<SThumbnailKey> Files = std::move(d->Listing->Files);
+	Lock.unlock();
+	d->Listing.reset();
+
+	if (!Files.isEmpty())
+	{
+		beginInsertRows(QModelIndex(), 0, Files.size() - 1);
+		d->Files = std::move(Files);
+		d->RowByFile.reserve(d->Files.size());
+		for (int Row = 0; Row < d->Files.size(); ++Row)
+		{
+			d->RowByFile.insert(d->Files.at(Row).FileName, Row);
+		}
+		endInsertRows();
+	}
+	Q_EMIT listingFinished(d->Files.size());
+}
+
+
+//============================================================================
+void CThumbnailModel::onThumbnailReady(const QString& FileName)
+{
+	int Row = d->RowByFile.value(FileName, -1);
+	if (Row < 0)
+	{
+		return;
+	}
+	QModelIndex Index = index(Row);
+	Q_EMIT dataChanged(Index, Index, {Qt::DecorationRole, Qt::ToolTipRole});
+}
+
+//---------------------------------------------------------------------------
+// EOF ThumbnailModel.cpp
@@ -0,0 +1,75 @@
+#ifndef ThumbnailModelH
+#define ThumbnailModelH
+//============================================================================
+/// \file   ThumbnailModel.h
+/// \brief  Declaration of CThumbnailModel
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QAbstractListModel>
+
+class CThumbnailCache;
+struct ThumbnailModelPrivate;
+
+/**
+ * @brief List model of the image files in a directory with their thumbnails
+ * as decoration.
+ *
+ * The directory is listed and sorted on the global thread pool and the rows
+ * are inserted at once when listing is done. Thumbnails are only requested
+ * when a view asks for the decoration of a row, i.e. when the row is painted,
+ * so a directory of 100000 images only decodes the visible ones.
+ */
+class CThumbnailModel : public QAbstractListModel
+{
+	Q_OBJECT
+public:
+	enum eRole
+	{
+		FilePathRole = Qt::UserRole + 1
+	};
+
+	explicit CThumbnailModel(QObject* Parent = nullptr);
+	virtual ~CThumbnailModel();
+
+	/**
+	 * @brief Clears the model and starts listing the image files of Path.
+	 * listingFinished() is emitted when the rows are inserted.
+	 */
+	void setDirectory(const QString& Path);
+	QString directory() const;
+
+	/**
+	 * @brief True while the directory is listed
+	 */
+	bool isListing() const;
+
+	/**
+	 * @brief Absolute path of the file shown in row Index
+	 */
+	QString filePath(const QModelIndex& Index) const;
+
+	/**
+	 * @brief The cache loading the thumbnails
+	 */
+	CThumbnailCache* thumbnailCache() const;
+
+	int rowCount(const QModelIndex& Parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& Index, int Role = Qt::DisplayRole) const override;
+
+signals:
+	void listingFinished(int FileCount);
+
+private slots:
+	void takeListedFiles();
+	void onThumbnailReady(const QString& FileName);
+
+private:
+	ThumbnailModelPrivate* d;
+	friend struct ThumbnailModelPrivate;
+}; // class CThumbnailModel
+
+//---------------------------------------------------------------------------
+#endif // ThumbnailModelH
@@ -0,0 +1,570 @@
+//============================================================================
+/// \file   TiledImage.cpp
+/// \brief  Implementation of CTiledImage
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "TiledImage.h"
+#include "CancelableFile.h"
+#include "DecodeQueue.h"
+#include "LruImageCache.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QTemporaryFile>
+
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <vector>
+
+
+namespace
+{
+/// Requests beyond this many are forgotten, oldest first
+const int MaxQueuedTiles = 256;
+/// Rows of a level scaled at once while building the next level, even
+const int StripRows = 128;
+/// Without region decoding, no level larger than this is decoded; finer
+/// levels are scaled up from the first one that fits
+const qint64 MaxStorePixels = qint64(16384) * 16384;
+
+qint64 pixelCount(const QSize& Size)
+{
+	return qint64(Size.width()) * Size.height();
+}
+
+quint64 tileKey(int Level, int Column, int Row)
+{
+	return (quint64(Level) << 56) | (quint64(Column) << 28) | quint64(Row);
+}
+
+int keyLevel(quint64 Key)
+{
+	return int(Key >> 56);
+}
+
+int keyColumn(quint64 Key)
+{
+	return int((Key >> 28) & 0xfffffff);
+}
+
+int keyRow(quint64 Key)
+{
+	return int(Key & 0xfffffff);
+}
+
+/**
+ * Converts a tile to a format QPainter draws without conversion.
+ */
+QImage paintableTile(const QImage& Tile)
+{
+	if (Tile.format() == QImage::Format_RGB32
+	 || Tile.format() == QImage::Format_ARGB32_Premultiplied)
+	{
+		return Tile;
+	}
+	return Tile.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+/**
+ * Decoded level kept in a memory mapped temporary file
+ */
+struct SLevelStore
+{
+	std::unique_ptr<QTemporaryFile> File;
+	uchar* Data = nullptr;
+	int BytesPerLine = 0;
+	QImage Image;///< wraps Data
+};
+} // namespace
+
+
+/**
+ * Private data of CTiledImage, shared with the workers so that the public
+ * object can go while they finish
+ */
+struct TiledImagePrivate : public std::enable_shared_from_this<TiledImagePrivate>
+{
+	QMutex ThisMutex;///< guards _this, held while signals are emitted
+	CTiledImage* _this;///< null once the public object is gone
+	QString FileName;
+	QSize Size;
+	int LevelCount = 0;
+	QImage::Format NativeFormat = QImage::Format_Invalid;
+	bool RegionDecoding = false;///< the reader decodes clip rectangles
+	int FirstStoredLevel = 0;///< without region decoding, finer levels are scaled
+	int MaxWorkers = 1;
+
+	QMutex Mutex;///< guards the members below
+	CLruImageCache<quint64> Cache{CTiledImage::DefaultCacheBytes};
+	CDecodeQueue<quint64> Queue{MaxQueuedTiles};
+	QSet<quint64> FailedTiles;
+	bool StoreDecoding = false;
+	bool StoreReady = false;
+	bool LoadFailed = false;
+	std::atomic<bool> Stopping{false};
+	std::vector<SLevelStore> Levels;///< without region decoding, valid once StoreReady
+
+	TiledImagePrivate(CTiledImage* _public) : _this(_public) {}
+
+	QSize levelSize(int Level) const;
+	QRect tileRect(int Level, int Column, int Row) const;
+
+	/**
+	 * Queues a tile unless it is cached or already queued. Mutex must be
+	 * locked.
+	 */
+	void requestTile(quint64 Key);
+
+	/**
+	 * Starts workers for the queued tiles. Mutex must be locked.
+	 */
+	void startWorkers();
+
+	/**
+	 * Worker thread loop of Queue, decodes queued tiles until it is empty
+	 */
+	void runWorker();
+
+	/**
+	 * Decodes one tile from the file or copies it from the level store
+	 */
+	QImage loadTile(quint64 Key) const;
+
+	/**
+	 * Decodes the image once into the level stores
+	 */
+	bool decodeStore(QString* ErrorString);
+
+	/**
+	 * Creates a memory mapped image of the given size and format
+	 */
+	bool createStore(SLevelStore* Store, const QSize& Size,
+		QImage::Format Format, QString* ErrorString) const;
+};
+
+
+//============================================================================
+QSize TiledImagePrivate::levelSize(int Level) const
+{
+	int Round = (1 << Level) - 1;
+	return QSize((Size.width() + Round) >> Level, (Size.height() + Round) >> Level);
+}
+
+
+//============================================================================
+QRect TiledImagePrivate::tileRect(int Level, int Column, int Row) const
+{
+	const int TileSize = CTiledImage::TileSize;
+	return QRect(Column * TileSize, Row * TileSize, TileSize, TileSize)
+		& QRect(QPoint(0, 0), levelSize(Level));
+}
+
+
+//============================================================================
+void TiledImagePrivate::requestTile(quint64 Key)
+{
+	if (LoadFailed || Stopping || Queue.contains(Key)
+	 || FailedTiles.contains(Key) || Cache.contains(Key))
+	{
+		return;
+	}
+
+	Queue.push(Key);
+	startWorkers();
+}
+
+
+//============================================================================
+void TiledImagePrivate::startWorkers()
+{
+	// Tiles of the level stores can only be copied once they are decoded,
+	// which takes a single worker
+	Queue.startWorkers(shared_from_this(),
+		(RegionDecoding || StoreReady) ? MaxWorkers : 1);
+}
+
+
+//============================================================================
+void TiledImagePrivate::runWorker()
+{
+	QMutexLocker Lock(&Mutex);
+	if (!RegionDecoding && !StoreReady)
+	{
+		if (StoreDecoding)
+		{
+			Queue.workerFinished();
+			return;
+		}
+
+		StoreDecoding = true;
+		Lock.unlock();
+		QString ErrorString;
+		bool Decoded = decodeStore(&ErrorString);
+		Lock.relock();
+		StoreDecoding = false;
+		if (!Decoded)
+		{
+			LoadFailed = true;
+			Queue.clear();
+			Queue.workerFinished();
+			Lock.unlock();
+			QMutexLocker ThisLock(&ThisMutex);
+			if (_this)
+			{
+				qWarning() << "Cannot decode" << FileName << ":" << ErrorString;
+				Q_EMIT _this->loadFailed(ErrorString);
+			}
+			return;
+		}
+		StoreReady = true;
+		startWorkers();
+	}
+
+	while (!Stopping && !Queue.isEmpty())
+	{
+		quint64 Key = Queue.takeNext();
+		Lock.unlock();
+		QImage Tile = loadTile(Key);
+		Lock.relock();
+		Queue.finished(Key);
+		if (Tile.isNull())
+		{
+			FailedTiles.insert(Key);
+			continue;
+		}
+
+		Cache.insert(Key, Tile);
+		Lock.unlock();
+		{
+			QMutexLocker ThisLock(&ThisMutex);
+			if (_this)
+			{
+				Q_EMIT _this->tileReady(keyLevel(Key), keyColumn(Key), keyRow(Key));
+			}
+		}
+		Lock.relock();
+	}
+	Queue.workerFinished();
+}
+
+
+//============================================================================
+QImage TiledImagePrivate::loadTile(quint64 Key) const
+{
+	int Level = keyLevel(Key);
+	QRect Rect = tileRect(Level, keyColumn(Key), keyRow(Key));
+	if (!RegionDecoding)
+	{
+		if (Level >= FirstStoredLevel)
+		{
+			return paintableTile(Levels[Level].Image.copy(Rect));
+		}
+		// Scaled up from the part of the first stored level it covers
+		int Shift = FirstStoredLevel - Level;
+		int Round = (1 << Shift) - 1;
+		QPoint TopLeft(Rect.x() >> Shift, Rect.y() >> Shift);
+		QPoint BottomRight((Rect.x() + Rect.width() + Round) >> Shift,
+			(Rect.y() + Rect.height() + Round) >> Shift);
+		const QImage& Stored = Levels[FirstStoredLevel].Image;
+		QRect SourceRect = QRect(TopLeft, QSize(BottomRight.x() - TopLeft.x(),
+			BottomRight.y() - TopLeft.y())) & Stored.rect();
+		return paintableTile(Stored.copy(SourceRect).scaled(Rect.size(),
+			Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+	}
+
+	QRect SourceRect(Rect.x() << Level, Rect.y() << Level,
+		Rect.width() << Level, Rect.height() << Level);
+	CCancelableFile File(FileName, &Stopping);
+	if (!File.open(QIODevice::ReadOnly))
+	{
+		return QImage();
+	}
+	QImageReader Reader(&File);
+	Reader.setClipRect(SourceRect & QRect(QPoint(0, 0), Size));
+	Reader.setScaledSize(Rect.size());
+	QImage Tile = Reader.read();
+	if (Tile.isNull())
+	{
+		if (!Stopping)
+		{
+			qWarning() << "Cannot decode tile" << Rect << "of level" << Level
+				<< "of" << FileName << ":" << Reader.errorString();
+		}
+		return QImage();
+	}
+	return paintableTile(Tile);
+}
+
+
+//============================================================================
+bool TiledImagePrivate::createStore(SLevelStore* Store, const QSize& Size,
+	QImage::Format Format, QString* ErrorString) const
+{
+	Store->File.reset(new QTemporaryFile(QDir::tempPath()
+		+ QLatin1String("/adsdemo_tiles_XXXXXX")));
+	int Depth = QImage::toPixelFormat(Format).bitsPerPixel();
+	Store->BytesPerLine = ((Size.width() * Depth + 31) / 32) * 4;
+	qint64 Bytes = qint64(Store->BytesPerLine) * Size.height();
+	if (!Store->File->open() || !Store->File->resize(Bytes))
+	{
+		*ErrorString = Store->File->errorString();
+		return false;
+	}
+	Store->Data = Store->File->map(0, Bytes);
+	if (!Store->Data)
+	{
+		*ErrorString = Store->File->errorString();
+		return false;
+	}
+	Store->Image = QImage(Store->Data, Size.width(), Size.height(),
+		Store->BytesPerLine, Format);
+	return true;
+}
+
+
+//============================================================================
+bool TiledImagePrivate::decodeStore(QString* ErrorString)
+{
+	// Reads fail once the image is deleted, which ends the decoder
+	CCancelableFile File(FileName, &Stopping);
+	if (!File.open(QIODevice::ReadOnly))
+	{
+		*ErrorString = File.errorString();
+		return false;
+	}
+	QImageReader Reader(&File);
+
+	// Levels too large to decode are only supported by handlers that scale
+	// while decoding
+	int First = 0;
+	while (First < LevelCount - 1 && pixelCount(levelSize(First)) > MaxStorePixels)
+	{
+		++First;
+	}
+	if (First > 0)
+	{
+		if (!Reader.supportsOption(QImageIOHandler::ScaledSize))
+		{
+			*ErrorString = QStringLiteral("The image is too large to decode without tiling support in its format");
+			return false;
+		}
+		Reader.setScaledSize(levelSize(First));
+	}
+
+	std::vector<SLevelStore> Stores(LevelCount);
+	SLevelStore& FirstStore = Stores[First];
+	QImage::Format Format = (NativeFormat == QImage::Format_Invalid)
+		? QImage::Format_ARGB32 : NativeFormat;
+	if (!createStore(&FirstStore, levelSize(First), Format, ErrorString))
+	{
+		return false;
+	}
+
+	// Handlers decode into an image of matching size and format in place,
+	// so the pixels go straight to the mapped file
+	QImage Decoded = FirstStore.Image;
+	FirstStore.Image = QImage();
+	if (!Reader.read(&Decoded))
+	{
+		*ErrorString = Stopping ? QStringLiteral("Canceled") : Reader.errorString();
+		return false;
+	}
+	if (Decoded.constBits() != FirstStore.Data)
+	{
+		// The handler allocated the image itself, move it to the store
+		if (!createStore(&FirstStore, Decoded.size(), Decoded.format(), ErrorString))
+		{
+			return false;
+		}
+		for (int Row = 0; Row < Decoded.height(); ++Row)
+		{
+			memcpy(FirstStore.Data + qint64(Row) * FirstStore.BytesPerLine,
+				Decoded.constScanLine(Row),
+				qMin(FirstStore.BytesPerLine, Decoded.bytesPerLine()));
+		}
+		FirstStore.Image.setColorTable(Decoded.colorTable());
+		Decoded = QImage();
+	}
+	else
+	{
+		FirstStore.Image = Decoded;
+	}
+
+	for (int Level = First + 1; Level < LevelCount && !Stopping; ++Level)
+	{
+		const QImage& Source = Stores[Level - 1].Image;
+		QSize LevelSize = levelSize(Level);
+		SLevelStore& Store = Stores[Level];
+		if (!createStore(&Store, LevelSize,
+			QImage::Format_ARGB32_Premultiplied, ErrorString))
+		{
+			return false;
+		}
+
+		for (int y = 0; y < Source.height() && !Stopping; y += StripRows)
+		{
+			int Rows = qMin(StripRows, Source.height() - y);
+			QImage Strip = paintableTile(Source.copy(0, y, Source.width(), Rows))
+				.scaled(LevelSize.width(), (Rows + 1) / 2,
+					Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+			for (int Row = 0; Row < Strip.height(); ++Row)
+			{
+				memcpy(Store.Data + qint64(y / 2 + Row) * Store.BytesPerLine,
+					Strip.constScanLine(Row), LevelSize.width() * 4);
+			}
+		}
+	}
+	if (Stopping)
+	{
+		*ErrorString = QStringLiteral("Canceled");
+		return false;
+	}
+
+	Levels = std::move(Stores);
+	FirstStoredLevel = First;
+	return true;
+}
+
+
+//============================================================================
+CTiledImage::CTiledImage(QObject* Parent)
+	: QObject(Parent),
+	  d(std::make_shared<TiledImagePrivate>(this))
+{
+	d->MaxWorkers = CDecodeQueue<quint64>::defaultMaxWorkers();
+}
+
+
+//============================================================================
+CTiledImage::~CTiledImage()
+{
+	{
+		QMutexLocker Lock(&d->Mutex);
+		d->Stopping = true;
+		d->Queue.clear();
+	}
+	// Running workers keep the private data; their reads fail from now on
+	QMutexLocker ThisLock(&d->ThisMutex);
+	d->_this = nullptr;
+}
+
+
+//============================================================================
+bool CTiledImage::needsTiling(const QSize& ImageSize)
+{
+	return ImageSize.isValid()
+		&& qint64(ImageSize.width()) * ImageSize.height() > TilingThreshold;
+}
+
+
+//============================================================================
+bool CTiledImage::open(const QString& FileName, QString* ErrorString)
+{
+	QImageReader Reader(FileName);
+	QSize ImageSize = Reader.size();
+	if (!ImageSize.isValid())
+	{
+		if (ErrorString)
+		{
+			*ErrorString = Reader.errorString();
+		}
+		return false;
+	}
+
+	QMutexLocker Lock(&d->Mutex);
+	d->FileName = FileName;
+	d->Size = ImageSize;
+	d->NativeFormat = Reader.imageFormat();
+	d->RegionDecoding = Reader.supportsOption(QImageIOHandler::ClipRect);
+	d->LevelCount = 1;
+	while (levelSize(d->LevelCount - 1).width() > TileSize
+	    || levelSize(d->LevelCount - 1).height() > TileSize)
+	{
+		++d->LevelCount;
+	}
+
+	// The smallest level is the placeholder for every other tile
+	d->requestTile(tileKey(d->LevelCount - 1, 0, 0));
+	return true;
+}
+
+
+//============================================================================
+QSize CTiledImage::size() const
+{
+	return d->Size;
+}
+
+
+//============================================================================
+int CTiledImage::levelCount() const
+{
+	return d->LevelCount;
+}
+
+
+//============================================================================
+QSize CTiledImage::levelSize(int Level) const
+{
+	return d->levelSize(Level);
+}
+
+
+//============================================================================
+QRect CTiledImage::tileRect(int Level, int Column, int Row) const
+{
+	return d->tileRect(Level, Column, Row);
+}
+
+
+//============================================================================
+QImage CTiledImage::tile(int Level, int Column, int Row)
+{
+	if (Level < 0 || Level >= d->LevelCount || tileRect(Level, Column, Row).isEmpty())
+	{
+		return QImage();
+	}
+
+	quint64 Key = tileKey(Level, Column, Row);
+	QMutexLocker Lock(&d->Mutex);
+	QImage Tile = d->Cache.find(Key);
+	if (Tile.isNull())
+	{
+		d->requestTile(Key);
+	}
+	return Tile;
+}
+
+
+//============================================================================
+QImage CTiledImage::cachedTile(int Level, int Column, int Row) const
+{
+	if (Level < 0 || Level >= d->LevelCount || tileRect(Level, Column, Row).isEmpty())
+	{
+		return QImage();
+	}
+
+	QMutexLocker Lock(&d->Mutex);
+	return d->Cache.find(tileKey(Level, Column, Row));
+}
+
+
+//============================================================================
+void CTiledImage::setCacheLimit(qint64 Bytes)
+{
+	QMutexLocker Lock(&d->Mutex);
+	d->Cache.setLimit(Bytes);
+}
+
+//---------------------------------------------------------------------------
+// EOF TiledImage.cpp
@@ -0,0 +1,124 @@
+#ifndef TiledImageH
+#define TiledImageH
+//============================================================================
+/// \file   TiledImage.h
+/// \brief  Declaration of CTiledImage
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QObject>
+#include <QImage>
+#include <QRect>
+
+#include <memory>
+
+struct TiledImagePrivate;
+
+/**
+ * @brief Image too large to decode at once, read in tiles on demand.
+ *
+ * The image is a pyramid of levels, each half the size of the one before,
+ * cut into TileSize tiles. Formats whose reader can decode a clip rectangle
+ * decode each tile directly from the file, at the resolution of its level.
+ * Other formats are decoded once into memory mapped temporary files, one per
+ * level, and tiles are copied out of them. Levels too large for that are
+ * decoded scaled down, if the reader can, and their tiles scaled up from the
+ * first level that was decoded; otherwise loading fails.
+ *
+ * tile() never blocks: a tile that is not cached is queued for the worker
+ * threads and tileReady() is emitted once it is. The most recently
+ * requested tiles are decoded first, and requests that fall too far behind
+ * are forgotten, so panning does not wait for tiles that scrolled away.
+ * Decoded tiles are kept in an LRU cache bounded in bytes.
+ */
+class CTiledImage : public QObject
+{
+	Q_OBJECT
+public:
+	static constexpr int TileSize = 512;
+	/**
+	 * @brief Images with more pixels than this should be tiled
+	 */
+	static constexpr qint64 TilingThreshold = qint64(8192) * 8192;
+	static constexpr qint64 DefaultCacheBytes = qint64(256) * 1024 * 1024;
+
+	/**
+	 * Constructor
+	 */
+	explicit CTiledImage(QObject* Parent = nullptr);
+
+	/**
+	 * Destructor. Does not wait for the workers: reading the file fails for
+	 * them from now on, and they drop what they decoded.
+	 */
+	virtual ~CTiledImage();
+
+	/**
+	 * @brief Returns true if an image of the given size should be tiled.
+	 */
+	static bool needsTiling(const QSize& ImageSize);
+
+	/**
+	 * @brief Opens the image file and queues its smallest level.
+	 * Only the header is read here, decoding happens in worker threads.
+	 * Call it once per instance.
+	 */
+	bool open(const QString& FileName, QString* ErrorString = nullptr);
+
+	/**
+	 * @brief Size of the full resolution image
+	 */
+	QSize size() const;
+
+	/**
+	 * @brief Number of levels, the last one fits into a single tile
+	 */
+	int levelCount() const;
+
+	/**
+	 * @brief Size of the given level
+	 */
+	QSize levelSize(int Level) const;
+
+	/**
+	 * @brief Rectangle of a tile in the coordinates of its level
+	 */
+	QRect tileRect(int Level, int Column, int Row) const;
+
+	/**
+	 * @brief Returns the tile if it is cached, otherwise queues it and
+	 * returns a null image.
+	 */
+	QImage tile(int Level, int Column, int Row);
+
+	/**
+	 * @brief Returns the tile if it is cached, without queuing it.
+	 */
+	QImage cachedTile(int Level, int Column, int Row) const;
+
+	/**
+	 * @brief Changes the number of bytes the tile cache may use.
+	 */
+	void setCacheLimit(qint64 Bytes);
+
+signals:
+	/**
+	 * @brief A queued tile was decoded and is in the cache now.
+	 * Emitted from a worker thread.
+	 */
+	void tileReady(int Level, int Column, int Row);
+
+	/**
+	 * @brief The image could not be decoded. Emitted from a worker thread.
+	 */
+	void loadFailed(const QString& ErrorString);
+
+private:
+	std::shared_ptr<TiledImagePrivate> d;
+	friend struct TiledImagePrivate;
+}; // class CTiledImage
+
+//---------------------------------------------------------------------------
+#endif // TiledImageH
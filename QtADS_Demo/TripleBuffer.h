@@ -0,0 +1,99 @@
+#ifndef TripleBufferH
+#define TripleBufferH
+//============================================================================
+/// \file   TripleBuffer.h
+/// \brief  Declaration of CTripleBuffer
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <atomic>
+#include <utility>
+
+
+/**
+ * @brief Lock-free triple buffer passing the newest value from producers to
+ * one consumer.
+ *
+ * The producer writes into the back slot and swaps it with the middle slot,
+ * the consumer swaps the front slot with the middle slot when it holds a
+ * value it has not seen yet. Neither side ever waits for the other and the
+ * consumer always gets the newest value; values the consumer did not pick up
+ * in time are overwritten.
+ * write() may be called from any thread. If another thread is writing at
+ * the same time, the value is dropped instead of waiting for it.
+ * swapFront() and front() must only be called from the consumer thread.
+ */
+template <class T>
+class CTripleBuffer
+{
+public:
+	enum eWriteResult
+	{
+		Published,     ///< value is the newest, no unread value was replaced
+		ReplacedUnread,///< value is the newest, the unread one was dropped
+		Busy           ///< another producer was writing, value was dropped
+	};
+
+private:
+	enum
+	{
+		IndexMask = 0x3,
+		FreshBit = 0x4 ///< middle slot holds a value the consumer has not seen
+	};
+
+	T m_Slots[3];
+	std::atomic<int> m_Middle{1};
+	int m_Back = 0; ///< owned by the producer holding m_Writing
+	int m_Front = 2;///< owned by the consumer
+	std::atomic_flag m_Writing = ATOMIC_FLAG_INIT;
+
+public:
+	/**
+	 * @brief Publishes Value as the newest value.
+	 */
+	eWriteResult write(T Value)
+	{
+		if (m_Writing.test_and_set(std::memory_order_acquire))
+		{
+			return Busy;
+		}
+		m_Slots[m_Back] = std::move(Value);
+		int Previous = m_Middle.exchange(m_Back | FreshBit, std::memory_order_acq_rel);
+		m_Back = Previous & IndexMask;
+		m_Writing.clear(std::memory_order_release);
+		return (Previous & FreshBit) ? ReplacedUnread : Published;
+	}
+
+	/**
+	 * @brief Makes the newest value the front value.
+	 * Returns false and keeps the front value if nothing was written since
+	 * the last call.
+	 */
+	bool swapFront()
+	{
+		if (!(m_Middle.load(std::memory_order_acquire) & FreshBit))
+		{
+			return false;
+		}
+		m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+
+	/**
+	 * @brief The value taken by the last successful swapFront().
+	 */
+	T& front()
+	{
+		return m_Slots[m_Front];
+	}
+
+	const T& front() const
+	{
+		return m_Slots[m_Front];
+	}
+}; // class CTripleBuffer
+
+//---------------------------------------------------------------------------
+#endif // TripleBufferH
@@ -0,0 +1,652 @@
+//============================================================================
+/// \file   VideoFileSource.cpp
+/// \brief  Implementation of CVideoFileSource
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "VideoFileSource.h"
+#include "RenderWidget.h"
+#include "YuvConversion.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QList>
+#include <QRegularExpression>
+#include <QVector>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+#include <thread>
+
+
+namespace
+{
+/// Converted frames kept for reuse, the render widget holds up to four
+const int FramePoolSize = 6;
+/// Longest FRAME header line accepted in y4m files
+const int MaxFrameHeaderLength = 1024;
+
+int chromaSize(int LumaSize)
+{
+	return (LumaSize + 1) / 2;
+}
+
+qint64 frameBytes(const QSize& Size, CVideoFileSource::ePixelFormat Format)
+{
+	qint64 Pixels = qint64(Size.width()) * Size.height();
+	switch (Format)
+	{
+	case CVideoFileSource::Gray: return Pixels;
+	case CVideoFileSource::I420:
+	case CVideoFileSource::NV12:
+		return Pixels + 2 * qint64(chromaSize(Size.width())) * chromaSize(Size.height());
+	case CVideoFileSource::RGB24: return Pixels * 3;
+	case CVideoFileSource::RGB32: return Pixels * 4;
+	}
+	return 0;
+}
+} // namespace
+
+
+/**
+ * Private data of CVideoFileSource
+ */
+struct VideoFileSourcePrivate
+{
+	CVideoFileSource* _this;
+	QFile File;
+	const uchar* Data = nullptr;///< mapping of the whole file
+	QVector<qint64> FrameOffsets;
+	QSize FrameSize;
+	CVideoFileSource::ePixelFormat Format = CVideoFileSource::I420;
+	bool FullRange = false;
+	double FramesPerSecond = 25;
+	std::atomic<bool> RealTime{true};
+	std::atomic<bool> Looping{true};
+	std::atomic<bool> Running{false};
+	std::thread Worker;
+	std::mutex StopMutex;
+	std::condition_variable StopCondition;
+	bool StopRequested = false;///< guarded by StopMutex
+
+	VideoFileSourcePrivate(CVideoFileSource* _public) : _this(_public) {}
+
+	/**
+	 * Closes the file, playback must be stopped
+	 */
+	void close();
+
+	/**
+	 * Opens and maps the file
+	 */
+	bool map(const QString& FileName, QString* ErrorString);
+
+	/**
+	 * Parses the y4m stream header and indexes the frames
+	 */
+	bool parseY4m(QString* ErrorString);
+
+	/**
+	 * Converts the frame at Offset into Image, which must be a detached
+	 * RGB32 image of the frame size
+	 */
+	void convertFrame(qint64 Offset, QImage& Image) const;
+
+	/**
+	 * Returns a pooled image nobody else references anymore, or a new one
+	 */
+	QImage& frameImage(QVector<QImage>& Pool, QImage& Spare) const;
+
+	/**
+	 * Body of the worker thread
+	 */
+	void play(CRenderWidget* Target);
+
+	/**
+	 * Waits until Time or until stop is requested. Returns false if stop
+	 * was requested.
+	 */
+	bool waitUntil(std::chrono::steady_clock::time_point Time);
+};
+
+
+//============================================================================
+void VideoFileSourcePrivate::close()
+{
+	if (Data)
+	{
+		File.unmap(const_cast<uchar*>(Data));
+		Data = nullptr;
+	}
+	File.close();
+	FrameOffsets.clear();
+	FrameSize = QSize();
+}
+
+
+//============================================================================
+bool VideoFileSourcePrivate::map(const QString& FileName, QString* ErrorString)
+{
+	close();
+	File.setFileName(FileName);
+	if (!File.open(QIODevice::ReadOnly))
+	{
+		*ErrorString = File.errorString();
+		return false;
+	}
+	if (File.size() == 0)
+	{
+		*ErrorString = CVideoFileSource::tr("The file is empty");
+		return false;
+	}
+	Data = File.map(0, File.size());
+	if (!Data)
+	{
+		*ErrorString = File.errorString();
+		File.close();
+		return false;
+	}
+	return true;
+}
+
+
+//============================================================================
+bool VideoFileSourcePrivate::parseY4m(QString* ErrorString)
+{
+	const char* Begin = reinterpret_cast<const char*>(Data);
+	const qint64 Size = File.size();
+	const char* HeaderEnd = static_cast<const char*>(
+		memchr(Begin, '\n', size_t(qMin<qint64>(Size, MaxFrameHeaderLength))));
+	if (!HeaderEnd || strncmp(Begin, "YUV4MPEG2 ", 10) != 0)
+	{
+		*ErrorString = CVideoFileSource::tr("Not a YUV4MPEG2 file");
+		return false;
+	}
+
+	int Width = 0;
+	int Height = 0;
+	Format = CVideoFileSource::I420;
+	FullRange = false;
+	FramesPerSecond = 25;
+	const QList<QByteArray> Tokens = QByteArray(Begin + 10, int(HeaderEnd - Begin - 10)).split(' ');
+	for (const QByteArray& Token : Tokens)
+	{
+		if (Token.isEmpty())
+		{
+			continue;
+		}
+		QByteArray Value = Token.mid(1);
+		switch (Token.at(0))
+		{
+		case 'W': Width = Value.toInt(); break;
+		case 'H': Height = Value.toInt(); break;
+		case 'F':
+			{
+				QList<QByteArray> Rate = Value.split(':');
+				double Denominator = Rate.size() == 2 ? Rate.at(1).toDouble() : 0;
+				if (Denominator > 0 && Rate.at(0).toDouble() > 0)
+				{
+					FramesPerSecond = Rate.at(0).toDouble() / Denominator;
+				}
+			}
+			break;
+		case 'C':
+			if (Value == "mono")
+			{
+				Format = CVideoFileSource::Gray;
+			}
+			else if (!Value.startsWith("420") || Value == "420p10"
+				|| Value == "420p12" || Value == "420p16")
+			{
+				*ErrorString = CVideoFileSource::tr("Unsupported color space %1")
+					.arg(QString::fromLatin1(Value));
+				return false;
+			}
+			break;
+		case 'X':
+			if (Value == "COLORRANGE=FULL")
+			{
+				FullRange = true;
+			}
+			break;
+		default: break;
+		}
+	}
+	if (Width <= 0 || Height <= 0)
+	{
+		*ErrorString = CVideoFileSource::tr("Invalid frame size");
+		return false;
+	}
+	FrameSize = QSize(Width, Height);
+
+	// Every frame has its own header line, which may carry parameters
+	const qint64 FrameBytes = frameBytes(FrameSize, Format);
+	qint64 Position = HeaderEnd - Begin + 1;
+	while (Size - Position > 5 && strncmp(Begin + Position, "FRAME", 5) == 0)
+	{
+		const char* LineEnd = static_cast<const char*>(memchr(Begin + Position,
+			'\n', size_t(qMin<qint64>(Size - Position, MaxFrameHeaderLength))));
+		if (!LineEnd)
+		{
+			break;
+		}
+		qint64 Offset = LineEnd - Begin + 1;
+		if (Size - Offset < FrameBytes)
+		{
+			break;
+		}
+		FrameOffsets.append(Offset);
+		Position = Offset + FrameBytes;
+	}
+	if (FrameOffsets.isEmpty())
+	{
+		*ErrorString = CVideoFileSource::tr("The file contains no frames");
+		return false;
+	}
+	return true;
+}
+
+
+//============================================================================
+void VideoFileSourcePrivate::convertFrame(qint64 Offset, QImage& Image) const
+{
+	const uchar* Frame = Data + Offset;
+	const int Width = FrameSize.width();
+	const int Height = FrameSize.height();
+	uint32_t* Target = reinterpret_cast<uint32_t*>(Image.bits());
+	const ptrdiff_t TargetStride = Image.bytesPerLine();
+	const ptrdiff_t ChromaWidth = chromaSize(Width);
+	const ptrdiff_t LumaBytes = ptrdiff_t(Width) * Height;
+
+	switch (Format)
+	{
+	case CVideoFileSource::Gray:
+		convertGrayToRgb32(Frame, Width, Target, TargetStride, Width, Height,
+			FullRange);
+		break;
+
+	case CVideoFileSource::I420:
+		{
+			SYuv420Planes Planes;
+			Planes.Y = Frame;
+			Planes.U = Frame + LumaBytes;
+			Planes.V = Planes.U + ChromaWidth * chromaSize(Height);
+			Planes.YStride = Width;
+			Planes.ChromaStride = ChromaWidth;
+			Planes.ChromaStep = 1;
+			convertYuv420ToRgb32(Planes, Target, TargetStride, Width, Height,
+				FullRange);
+		}
+		break;
+
+	case CVideoFileSource::NV12:
+		{
+			SYuv420Planes Planes;
+			Planes.Y = Frame;
+			Planes.U = Frame + LumaBytes;
+			Planes.V = Planes.U + 1;
+			Planes.YStride = Width;
+			Planes.ChromaStride = 2 * ChromaWidth;
+			Planes.ChromaStep = 2;
+			convertYuv420ToRgb32(Planes, Target, TargetStride, Width, Height,
+				FullRange);
+		}
+		break;
+
+	case CVideoFileSource::RGB24:
+		for (int y = 0; y < Height; ++y)
+		{
+			const uchar* Pixel = Frame + ptrdiff_t(y) * Width * 3;
+			QRgb* Line = reinterpret_cast<QRgb*>(Image.scanLine(y));
+			for (int x = 0; x < Width; ++x, Pixel += 3)
+			{
+				Line[x] = qRgb(Pixel[0], Pixel[1], Pixel[2]);
+			}
+		}
+		break;
+
+	case CVideoFileSource::RGB32:
+		for (int y = 0; y < Height; ++y)
+		{
+			memcpy(Image.scanLine(y), Frame + ptrdiff_t(y) * Width * 4,
+				size_t(Width) * 4);
+		}
+		break;
+	}
+}
+
+
+//============================================================================
+QImage& VideoFileSourcePrivate::frameImage(QVector<QImage>& Pool,
+	QImage& Spare) const
+{
+	// Images still referenced by the render widget must not be written
+	for (QImage& Image : Pool)
+	{
+		if (Image.isDetached())
+		{
+			return Image;
+		}
+	}
+	if (Pool.size() < FramePoolSize)
+	{
+		Pool.append(QImage(FrameSize, QImage::Format_RGB32));
+		return Pool.last();
+	}
+	Spare = QImage(FrameSize, QImage::Format_RGB32);
+	return Spare;
+}
+
+
+//============================================================================
+bool VideoFileSourcePrivate::waitUntil(std::chrono::steady_clock::time_point Time)
+{
+	std::unique_lock<std::mutex> Lock(StopMutex);
+	return !StopCondition.wait_until(Lock, Time, [this]{ return StopRequested; });
+}
+
+
+//============================================================================
+void VideoFileSourcePrivate::play(CRenderWidget* Target)
+{
+	using Clock = std::chrono::steady_clock;
+	const Clock::duration FrameInterval = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / FramesPerSecond));
+	QVector<QImage> Pool;
+	QImage Spare;
+	Clock::time_point Due = Clock::now();
+	bool ReachedEnd = false;
+	int Frame = 0;
+	while (true)
+	{
+		if (Frame == FrameOffsets.size())
+		{
+			if (!Looping.load())
+			{
+				ReachedEnd = true;
+				break;
+			}
+			Frame = 0;
+		}
+
+		QImage& Image = frameImage(Pool, Spare);
+		convertFrame(FrameOffsets.at(Frame++), Image);
+
+		if (RealTime.load())
+		{
+			// More than a frame late, i.e. after a stall or when switching
+			// modes: restart the schedule instead of catching up in a burst
+			Clock::time_point Now = Clock::now();
+			if (Now - Due > FrameInterval)
+			{
+				Due = Now;
+			}
+			if (!waitUntil(Due))
+			{
+				break;
+			}
+			Due += FrameInterval;
+		}
+		else
+		{
+			std::lock_guard<std::mutex> Lock(StopMutex);
+			if (StopRequested)
+			{
+				break;
+			}
+		}
+		Target->submitFrame(Image);
+	}
+
+	Running.store(false);
+	if (ReachedEnd)
+	{
+		Q_EMIT _this->finished();
+	}
+}
+
+
+//============================================================================
+CVideoFileSource::CVideoFileSource(QObject* Parent)
+	: QObject(Parent),
+	  d(new VideoFileSourcePrivate(this))
+{
+}
+
+
+//============================================================================
+CVideoFileSource::~CVideoFileSource()
+{
+	stop();
+	d->close();
+	delete d;
+}
+
+
+//============================================================================
+bool CVideoFileSource::open(const QString& FileName, QString* ErrorString)
+{
+	QFileInfo Info(FileName);
+	QString Suffix = Info.suffix().toLower();
+	if (Suffix == QLatin1String("y4m"))
+	{
+		return openY4m(FileName, ErrorString);
+	}
+
+	ePixelFormat Format;
+	if (Suffix == QLatin1String("yuv") || Suffix == QLatin1String("i420")
+	 || Suffix == QLatin1String("iyuv"))
+	{
+		Format = I420;
+	}
+	else if (Suffix == QLatin1String("nv12"))
+	{
+		Format = NV12;
+	}
+	else if (Suffix == QLatin1String("gray") || Suffix == QLatin1String("y8"))
+	{
+		Format = Gray;
+	}
+	else if (Suffix == QLatin1String("rgb") || Suffix == QLatin1String("rgb24"))
+	{
+		Format = RGB24;
+	}
+	else if (Suffix == QLatin1String("rgb32") || Suffix == QLatin1String("bgra"))
+	{
+		Format = RGB32;
+	}
+	else
+	{
+		if (ErrorString)
+		{
+			*ErrorString = tr("Unknown video file type %1").arg(Suffix);
+		}
+		return false;
+	}
+
+	QString BaseName = Info.completeBaseName();
+	QRegularExpressionMatch Size = QRegularExpression(
+		QStringLiteral("(\\d+)x(\\d+)")).match(BaseName);
+	if (!Size.hasMatch())
+	{
+		if (ErrorString)
+		{
+			*ErrorString = tr("The file name does not contain the frame size, "
+				"i.e. video_640x480.yuv");
+		}
+		return false;
+	}
+	double FramesPerSecond = 25;
+	QRegularExpressionMatch Rate = QRegularExpression(
+		QStringLiteral("(\\d+(?:\\.\\d+)?)fps"),
+		QRegularExpression::CaseInsensitiveOption).match(BaseName);
+	if (Rate.hasMatch())
+	{
+		FramesPerSecond = Rate.captured(1).toDouble();
+	}
+	return openRaw(FileName, QSize(Size.captured(1).toInt(),
+		Size.captured(2).toInt()), Format, FramesPerSecond, ErrorString);
+}
+
+
+//============================================================================
+bool CVideoFileSource::openY4m(const QString& FileName, QString* ErrorString)
+{
+	stop();
+	QString Error;
+	if (!d->map(FileName, &Error) || !d->parseY4m(&Error))
+	{
+		d->close();
+		if (ErrorString)
+		{
+			*ErrorString = Error;
+		}
+		return false;
+	}
+	return true;
+}
+
+
+//============================================================================
+bool CVideoFileSource::openRaw(const QString& FileName, const QSize& FrameSize,
+	ePixelFormat Format, double FramesPerSecond, QString* ErrorString)
+{
+	stop();
+	d->close();
+	QString Error;
+	if (FrameSize.isEmpty() || FramesPerSecond <= 0)
+	{
+		Error = tr("Invalid frame size or frame rate");
+	}
+	else if (d->map(FileName, &Error))
+	{
+		qint64 FrameBytes = frameBytes(FrameSize, Format);
+		qint64 Count = d->File.size() / FrameBytes;
+		if (Count == 0)
+		{
+			Error = tr("The file is smaller than one frame");
+		}
+		for (qint64 i = 0; i < Count; ++i)
+		{
+			d->FrameOffsets.append(i * FrameBytes);
+		}
+	}
+
+	if (d->FrameOffsets.isEmpty())
+	{
+		d->close();
+		if (ErrorString)
+		{
+			*ErrorString = Error;
+		}
+		return false;
+	}
+	d->FrameSize = FrameSize;
+	d->Format = Format;
+	d->FullRange = false;
+	d->FramesPerSecond = FramesPerSecond;
+	return true;
+}
+
+
+//============================================================================
+QSize CVideoFileSource::frameSize() const
+{
+	return d->FrameSize;
+}
+
+
+//============================================================================
+double CVideoFileSource::framesPerSecond() const
+{
+	return d->FramesPerSecond;
+}
+
+
+//============================================================================
+int CVideoFileSource::frameCount() const
+{
+	return d->FrameOffsets.size();
+}
+
+
+//============================================================================
+void CVideoFileSource::setRealTime(bool RealTime)
+{
+	d->RealTime.store(RealTime);
+}
+
+
+//============================================================================
+bool CVideoFileSource::isRealTime() const
+{
+	return d->RealTime.load();
+}
+
+
+//============================================================================
+void CVideoFileSource::setLooping(bool Looping)
+{
+	d->Looping.store(Looping);
+}
+
+
+//============================================================================
+bool CVideoFileSource::isLooping() const
+{
+	return d->Looping.load();
+}
+
+
+//============================================================================
+bool CVideoFileSource::start(CRenderWidget* Target)
+{
+	stop();
+	if (d->FrameOffsets.isEmpty() || !Target)
+	{
+		return false;
+	}
+
+	d->StopRequested = false;
+	d->Running.store(true);
+	d->Worker = std::thread([this, Target]()
+	{
+		d->play(Target);
+	});
+	return true;
+}
+
+
+//============================================================================
+void CVideoFileSource::stop()
+{
+	if (!d->Worker.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(d->StopMutex);
+		d->StopRequested = true;
+	}
+	d->StopCondition.notify_all();
+	d->Worker.join();
+}
+
+
+//============================================================================
+bool CVideoFileSource::isRunning() const
+{
+	return d->Running.load();
+}
+
+//---------------------------------------------------------------------------
+// EOF VideoFileSource.cpp
@@ -0,0 +1,120 @@
+#ifndef VideoFileSourceH
+#define VideoFileSourceH
+//============================================================================
+/// \file   VideoFileSource.h
+/// \brief  Declaration of CVideoFileSource
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QObject>
+#include <QSize>
+#include <QString>
+
+struct VideoFileSourcePrivate;
+class CRenderWidget;
+
+/**
+ * @brief Plays uncompressed video files into a CRenderWidget, standing in
+ * for a video capture device.
+ *
+ * Supported are YUV4MPEG2 files (.y4m) with 4:2:0 or mono pixels and raw
+ * files holding frames of one of the ePixelFormat layouts back to back.
+ * The file is memory mapped and each frame is converted straight from the
+ * mapping into a reused RGB32 image on a worker thread, using the SIMD
+ * kernels of YuvConversion.h. Frames are submitted at the frame rate of
+ * the file or, in as-fast-as-possible mode, as fast as they convert; the
+ * render widget drops what it cannot display.
+ */
+class CVideoFileSource : public QObject
+{
+	Q_OBJECT
+public:
+	/**
+	 * @brief Pixel layouts of raw files
+	 */
+	enum ePixelFormat
+	{
+		Gray, ///< 8 bit luma only
+		I420, ///< planar YUV 4:2:0, Y plane, then U, then V
+		NV12, ///< Y plane, then interleaved U and V 4:2:0
+		RGB24,///< R, G, B bytes
+		RGB32 ///< 32 bit 0xffRRGGBB words as QImage::Format_RGB32
+	};
+
+	explicit CVideoFileSource(QObject* Parent = nullptr);
+	virtual ~CVideoFileSource();
+
+	/**
+	 * @brief Opens a .y4m file with openY4m(), any other file with
+	 * openRaw().
+	 * The parameters of raw files are taken from the file name: the frame
+	 * size from WIDTHxHEIGHT, the frame rate from an optional NNfps (25 if
+	 * missing) and the pixel format from the suffix: yuv, i420 or iyuv,
+	 * nv12, gray or y8, rgb or rgb24, rgb32 or bgra.
+	 * For example "foreman_352x288_30fps.yuv".
+	 */
+	bool open(const QString& FileName, QString* ErrorString = nullptr);
+
+	/**
+	 * @brief Opens a YUV4MPEG2 file.
+	 * Only 8 bit 4:2:0 and mono files are supported. XCOLORRANGE=FULL
+	 * selects full range conversion, limited range is the default.
+	 */
+	bool openY4m(const QString& FileName, QString* ErrorString = nullptr);
+
+	/**
+	 * @brief Opens a raw video file. Trailing bytes that do not make up a
+	 * whole frame are ignored. YUV frames use limited range.
+	 */
+	bool openRaw(const QString& FileName, const QSize& FrameSize,
+		ePixelFormat Format, double FramesPerSecond,
+		QString* ErrorString = nullptr);
+
+	QSize frameSize() const;
+	double framesPerSecond() const;
+	int frameCount() const;
+
+	/**
+	 * @brief Submits frames at the frame rate of the file if true, which is
+	 * the default, or as fast as possible. May be changed while playing.
+	 */
+	void setRealTime(bool RealTime);
+	bool isRealTime() const;
+
+	/**
+	 * @brief Restarts at the first frame at the end of the file if true,
+	 * which is the default.
+	 */
+	void setLooping(bool Looping);
+	bool isLooping() const;
+
+	/**
+	 * @brief Starts playing the open file into Target.
+	 * A running playback is stopped first. Target must stay alive until
+	 * playback is stopped.
+	 */
+	bool start(CRenderWidget* Target);
+
+	/**
+	 * @brief Stops playback and waits for the worker thread to finish.
+	 */
+	void stop();
+
+	bool isRunning() const;
+
+Q_SIGNALS:
+	/**
+	 * @brief Emitted when playback reached the end of a file that is not
+	 * looped. Not emitted by stop().
+	 */
+	void finished();
+
+private:
+	VideoFileSourcePrivate* d;
+	friend struct VideoFileSourcePrivate;
+}; // class CVideoFileSource
+
+//---------------------------------------------------------------------------
+#endif // VideoFileSourceH
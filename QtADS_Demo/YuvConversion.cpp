@@ -0,0 +1,193 @@
+//============================================================================
+/// \file   YuvConversion.cpp
+/// \brief  Implementation of the YUV to RGB conversion kernels
+//============================================================================
+
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "YuvConversion.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YUV_CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+/**
+ * BT.601 coefficients in 6 bit fixed point. All products fit into 16 bits;
+ * sums that do not, saturate, which only happens far outside 0..255.
+ */
+struct SCoefficients
+{
+	int YOffset;
+	int Y;
+	int RV;
+	int GU;
+	int GV;
+	int BU;
+};
+
+const SCoefficients LimitedRange = {16, 75, 102, 25, 52, 129};
+const SCoefficients FullRange = {0, 64, 90, 22, 46, 113};
+
+int saturate16(int Value)
+{
+	return Value < -32768 ? -32768 : (Value > 32767 ? 32767 : Value);
+}
+
+/**
+ * Rounds, scales and clamps a fixed point channel, as the SIMD path does
+ */
+uint32_t channel(int Sum)
+{
+	int Value = saturate16(saturate16(Sum) + 32) >> 6;
+	return uint32_t(Value < 0 ? 0 : (Value > 255 ? 255 : Value));
+}
+
+void convertRowScalar(const uint8_t* Y, const uint8_t* U, const uint8_t* V,
+	int ChromaStep, uint32_t* Target, int Begin, int Width,
+	const SCoefficients& C)
+{
+	for (int x = Begin; x < Width; ++x)
+	{
+		int Luma = (Y[x] - C.YOffset) * C.Y;
+		int D = U[(x / 2) * ChromaStep] - 128;
+		int E = V[(x / 2) * ChromaStep] - 128;
+		uint32_t R = channel(Luma + C.RV * E);
+		uint32_t G = channel(Luma - (C.GU * D + C.GV * E));
+		uint32_t B = channel(Luma + C.BU * D);
+		Target[x] = 0xff000000u | (R << 16) | (G << 8) | B;
+	}
+}
+
+#ifdef YUV_CONVERSION_SSE2
+inline __m128i finishChannel(__m128i Sum, __m128i Round)
+{
+	return _mm_srai_epi16(_mm_adds_epi16(Sum, Round), 6);
+}
+
+/**
+ * Converts 16 pixels per iteration and returns the number of pixels
+ * converted
+ */
+int convertRowSse2(const uint8_t* Y, const uint8_t* U, const uint8_t* V,
+	int ChromaStep, uint32_t* Target, int Width, const SCoefficients& C)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i YOffset = _mm_set1_epi16(short(C.YOffset));
+	const __m128i YFactor = _mm_set1_epi16(short(C.Y));
+	const __m128i RV = _mm_set1_epi16(short(C.RV));
+	const __m128i GU = _mm_set1_epi16(short(C.GU));
+	const __m128i GV = _mm_set1_epi16(short(C.GV));
+	const __m128i BU = _mm_set1_epi16(short(C.BU));
+	const __m128i ChromaBias = _mm_set1_epi16(128);
+	const __m128i Round = _mm_set1_epi16(32);
+	const __m128i LowBytes = _mm_set1_epi16(0x00ff);
+	const __m128i Alpha = _mm_set1_epi8(char(0xff));
+
+	int x = 0;
+	for (; x + 16 <= Width; x += 16)
+	{
+		// One chroma sample per pixel pair, 8 per iteration
+		__m128i D;
+		__m128i E;
+		if (ChromaStep == 2)
+		{
+			__m128i UV = _mm_loadu_si128(reinterpret_cast<const __m128i*>(U + x));
+			D = _mm_and_si128(UV, LowBytes);
+			E = _mm_srli_epi16(UV, 8);
+		}
+		else
+		{
+			D = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(U + x / 2)), Zero);
+			E = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(V + x / 2)), Zero);
+		}
+		D = _mm_sub_epi16(D, ChromaBias);
+		E = _mm_sub_epi16(E, ChromaBias);
+		__m128i RTerm = _mm_mullo_epi16(E, RV);
+		__m128i GTerm = _mm_add_epi16(_mm_mullo_epi16(D, GU), _mm_mullo_epi16(E, GV));
+		__m128i BTerm = _mm_mullo_epi16(D, BU);
+
+		__m128i Luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Y + x));
+		__m128i LumaLo = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(Luma, Zero), YOffset), YFactor);
+		__m128i LumaHi = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(Luma, Zero), YOffset), YFactor);
+
+		__m128i R = _mm_packus_epi16(
+			finishChannel(_mm_adds_epi16(LumaLo, _mm_unpacklo_epi16(RTerm, RTerm)), Round),
+			finishChannel(_mm_adds_epi16(LumaHi, _mm_unpackhi_epi16(RTerm, RTerm)), Round));
+		__m128i G = _mm_packus_epi16(
+			finishChannel(_mm_subs_epi16(LumaLo, _mm_unpacklo_epi16(GTerm, GTerm)), Round),
+			finishChannel(_mm_subs_epi16(LumaHi, _mm_unpackhi_epi16(GTerm, GTerm)), Round));
+		__m128i B = _mm_packus_epi16(
+			finishChannel(_mm_adds_epi16(LumaLo, _mm_unpacklo_epi16(BTerm, BTerm)), Round),
+			finishChannel(_mm_adds_epi16(LumaHi, _mm_unpackhi_epi16(BTerm, BTerm)), Round));
+
+		// Little endian 0xffRRGGBB is B, G, R, A in memory
+		__m128i BGLo = _mm_unpacklo_epi8(B, G);
+		__m128i BGHi = _mm_unpackhi_epi8(B, G);
+		__m128i RALo = _mm_unpacklo_epi8(R, Alpha);
+		__m128i RAHi = _mm_unpackhi_epi8(R, Alpha);
+		__m128i* Out = reinterpret_cast<__m128i*>(Target + x);
+		_mm_storeu_si128(Out, _mm_unpacklo_epi16(BGLo, RALo));
+		_mm_storeu_si128(Out + 1, _mm_unpackhi_epi16(BGLo, RALo));
+		_mm_storeu_si128(Out + 2, _mm_unpacklo_epi16(BGHi, RAHi));
+		_mm_storeu_si128(Out + 3, _mm_unpackhi_epi16(BGHi, RAHi));
+	}
+	return x;
+}
+#endif
+} // namespace
+
+
+//============================================================================
+void convertYuv420ToRgb32(const SYuv420Planes& Source, uint32_t* Target,
+	ptrdiff_t TargetStride, int Width, int Height, bool IsFullRange)
+{
+	const SCoefficients& C = IsFullRange ? FullRange : LimitedRange;
+	for (int Row = 0; Row < Height; ++Row)
+	{
+		const uint8_t* Y = Source.Y + Row * Source.YStride;
+		const uint8_t* U = Source.U + (Row / 2) * Source.ChromaStride;
+		const uint8_t* V = Source.V + (Row / 2) * Source.ChromaStride;
+		uint32_t* Line = reinterpret_cast<uint32_t*>(
+			reinterpret_cast<uint8_t*>(Target) + Row * TargetStride);
+		int Converted = 0;
+#ifdef YUV_CONVERSION_SSE2
+		Converted = convertRowSse2(Y, U, V, Source.ChromaStep, Line, Width, C);
+#endif
+		convertRowScalar(Y, U, V, Source.ChromaStep, Line, Converted, Width, C);
+	}
+}
+
+
+//============================================================================
+void convertGrayToRgb32(const uint8_t* Source, ptrdiff_t SourceStride,
+	uint32_t* Target, ptrdiff_t TargetStride, int Width, int Height,
+	bool IsFullRange)
+{
+	const SCoefficients& C = IsFullRange ? FullRange : LimitedRange;
+	uint32_t Lookup[256];
+	for (int Value = 0; Value < 256; ++Value)
+	{
+		uint32_t Gray = channel((Value - C.YOffset) * C.Y);
+		Lookup[Value] = 0xff000000u | (Gray << 16) | (Gray << 8) | Gray;
+	}
+
+	for (int Row = 0; Row < Height; ++Row)
+	{
+		const uint8_t* Y = Source + Row * SourceStride;
+		uint32_t* Line = reinterpret_cast<uint32_t*>(
+			reinterpret_cast<uint8_t*>(Target) + Row * TargetStride);
+		for (int x = 0; x < Width; ++x)
+		{
+			Line[x] = Lookup[Y[x]];
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// EOF YuvConversion.cpp
@@ -0,0 +1,54 @@
+#ifndef YuvConversionH
+#define YuvConversionH
+//============================================================================
+/// \file   YuvConversion.h
+/// \brief  Declaration of the YUV to RGB conversion kernels
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Planes of a YUV 4:2:0 image
+ *
+ * Planar images (I420) have U and V in separate planes with ChromaStep 1.
+ * Semi-planar images (NV12) have interleaved U and V samples: V points one
+ * byte behind U and ChromaStep is 2. Chroma planes have half the width and
+ * height of the luma plane, rounded up.
+ */
+struct SYuv420Planes
+{
+	const uint8_t* Y;
+	const uint8_t* U;
+	const uint8_t* V;
+	ptrdiff_t YStride;
+	ptrdiff_t ChromaStride;
+	int ChromaStep;
+};
+
+/**
+ * @brief Converts BT.601 YUV 4:2:0 to 32 bit 0xffRRGGBB pixels
+ * (QImage::Format_RGB32).
+ * @param[in] IsFullRange True for full range (JPEG) samples, false for
+ * limited range (16-235 luma, 16-240 chroma) video samples.
+ * All strides are in bytes.
+ *
+ * Uses SSE2 where available. The SIMD and the scalar path use the same
+ * 6 bit fixed point coefficients and produce identical pixels.
+ */
+void convertYuv420ToRgb32(const SYuv420Planes& Source, uint32_t* Target,
+	ptrdiff_t TargetStride, int Width, int Height, bool IsFullRange);
+
+/**
+ * @brief Converts 8 bit gray to 32 bit 0xffRRGGBB pixels.
+ */
+void convertGrayToRgb32(const uint8_t* Source, ptrdiff_t SourceStride,
+	uint32_t* Target, ptrdiff_t TargetStride, int Width, int Height,
+	bool IsFullRange);
+
+//---------------------------------------------------------------------------
+#endif // YuvConversionH
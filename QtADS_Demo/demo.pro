@@ -26,14 +26,40 @@ HEADERS += \
 	MainWindow.h \
 	StatusDialog.h \
 	ImageViewer.h \
-	RenderWidget.h
+	RenderWidget.h \
+	TripleBuffer.h \
+	TiledImage.h \
+	CancelableFile.h \
+	LruImageCache.h \
+	DecodeQueue.h \
+	ImageCache.h \
+	VideoFileSource.h \
+	YuvConversion.h \
+	ImageStatistics.h \
+	ImageInspector.h \
+	ThumbnailCache.h \
+	ThumbnailModel.h \
+	ImageBrowser.h \
+	ImageDiff.h \
+	ImageCompare.h
 
 SOURCES += \
 	main.cpp \
 	MainWindow.cpp \
 	StatusDialog.cpp \
 	ImageViewer.cpp \
-	RenderWidget.cpp
+	RenderWidget.cpp \
+	TiledImage.cpp \
+	ImageCache.cpp \
+	VideoFileSource.cpp \
+	YuvConversion.cpp \
+	ImageStatistics.cpp \
+	ImageInspector.cpp \
+	ThumbnailCache.cpp \
+	ThumbnailModel.cpp \
+	ImageBrowser.cpp \
+	ImageDiff.cpp \
+	ImageCompare.cpp
 
 FORMS += \
 	mainwindow.ui \
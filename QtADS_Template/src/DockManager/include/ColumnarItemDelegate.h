@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QStyledItemDelegate>
+
+namespace DockManager {
+
+/**
+ * @brief Lightweight read-only delegate for large table views.
+ *
+ * QStyledItemDelegate fills a full QStyleOptionViewItem per cell and asks
+ * the style to lay out icon, check box and text. This delegate only queries
+ * display text, alignment and background, and draws elided text with the
+ * painter directly. sizeHint() returns one height for every cell, so views
+ * never measure individual rows.
+ *
+ * Usage:
+ * @code
+ * view->setItemDelegate(new ColumnarItemDelegate(view));
+ * view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+ * @endcode
+ */
+class ColumnarItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit ColumnarItemDelegate(QObject* parent = nullptr);
+    ~ColumnarItemDelegate() override;
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+};
+
+} // namespace DockManager
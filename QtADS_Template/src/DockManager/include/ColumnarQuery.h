@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ColumnarTable.h"
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+namespace DockManager {
+
+/**
+ * @brief Row predicate for ColumnarTableModel::setFilter().
+ *
+ * Built from a user expression with parse(). An optional leading operator
+ * (=, !=, <, <=, >, >=) selects a comparison; without one, string columns
+ * match by case-insensitive substring and numeric columns by equality.
+ * Column -1 searches every string column for the substring.
+ */
+struct ColumnarFilter
+{
+    enum class Operator
+    {
+        Contains,
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual
+    };
+
+    int column = -1;
+    Operator op = Operator::Contains;
+    QString text;
+    double number = 0.0;
+    bool numberValid = false;
+
+    /**
+     * @brief Parse a filter expression for a column
+     * @param column Column index, or -1 for all string columns
+     * @param expression E.g. "main", ">= 100", "!= idle"
+     */
+    static ColumnarFilter parse(int column, const QString& expression);
+
+    /**
+     * @brief An empty expression matches every row
+     */
+    bool isActive() const { return !text.isEmpty(); }
+};
+
+/**
+ * @brief Sort key for ColumnarTableModel::sort(); column -1 keeps source order.
+ */
+struct ColumnarSort
+{
+    int column = -1;
+    Qt::SortOrder order = Qt::AscendingOrder;
+
+    bool isActive() const { return column >= 0; }
+};
+
+/**
+ * @brief Compute the visible rows of a table in display order.
+ *
+ * Filters, then sorts the surviving source row indices. Work is split across
+ * QThread::idealThreadCount() threads once the table is large enough:
+ * numeric columns use a stable LSD radix sort on order-preserving 64-bit
+ * keys, string columns a stable parallel merge sort; filters evaluate
+ * numeric comparisons and substring scans with SSE2 where available.
+ *
+ * Safe to call from any thread on a snapshot of the table. Polls cancelled
+ * between passes and returns false as soon as it is set.
+ *
+ * @param table Snapshot to query
+ * @param filter Row predicate, may be inactive
+ * @param sort Sort key, may be inactive
+ * @param cancelled Cancellation flag, set by the requester
+ * @param rows Receives source row indices in display order
+ * @return false if cancelled, leaving rows unspecified
+ */
+bool computeRowOrder(const ColumnarTable& table, const ColumnarFilter& filter, const ColumnarSort& sort,
+                     const std::atomic_bool& cancelled, QVector<int>* rows);
+
+} // namespace DockManager
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+#include <QVariant>
+#include <QVector>
+
+namespace DockManager {
+
+/**
+ * @brief Storage type of a ColumnarTable column.
+ */
+enum class ColumnType
+{
+    Int64,
+    Double,
+    String
+};
+
+/**
+ * @brief Column-oriented table storage used by ColumnarTableModel.
+ *
+ * Each column is one typed vector instead of a QVariant or item object per
+ * cell: numeric cells cost 8 bytes, string cells an 8 byte span into a
+ * per-column character pool. Consecutive equal strings share one span, so
+ * repetitive columns ("Running", "--", file names) stay close to 8 bytes a
+ * row.
+ *
+ * The table is a plain value type; build a batch off to the side (even on a
+ * worker thread) and hand it to the model in one call.
+ *
+ * Usage:
+ * @code
+ * ColumnarTable rows({ColumnType::String, ColumnType::Int64});
+ * rows.reserve(count);
+ * for (const auto& frame : frames) {
+ *     const int r = rows.appendRow();
+ *     rows.setString(r, 0, frame.function);
+ *     rows.setInt64(r, 1, frame.line);
+ * }
+ * model->setTable(std::move(rows));
+ * @endcode
+ */
+class ColumnarTable
+{
+public:
+    ColumnarTable() = default;
+    explicit ColumnarTable(const QVector<ColumnType>& types);
+
+    int columnCount() const { return m_columns.size(); }
+    int rowCount() const { return m_rowCount; }
+    ColumnType columnType(int column) const { return m_columns.at(column).type; }
+    QVector<ColumnType> columnTypes() const;
+
+    /**
+     * @brief Check that another table has the same column types
+     */
+    bool hasSameSchema(const ColumnarTable& other) const;
+
+    /**
+     * @brief Reserve space for rows in every column
+     */
+    void reserve(int rows);
+
+    /**
+     * @brief Remove all rows, keeping the columns
+     */
+    void clearRows();
+
+    /**
+     * @brief Append a row of default values (0, 0.0, empty string)
+     * @return Index of the new row
+     */
+    int appendRow();
+
+    /**
+     * @brief Grow or shrink to the given row count, new rows get default values
+     */
+    void resize(int rows);
+
+    void setInt64(int row, int column, qint64 value);
+    void setDouble(int row, int column, double value);
+    void setString(int row, int column, QStringView value);
+
+    /**
+     * @brief Set a cell from a variant, converting to the column type
+     */
+    void setValue(int row, int column, const QVariant& value);
+
+    qint64 int64At(int row, int column) const;
+    double doubleAt(int row, int column) const;
+
+    /**
+     * @brief Contiguous cells of a numeric column, rowCount() entries
+     */
+    const qint64* int64Data(int column) const { return m_columns.at(column).ints.constData(); }
+    const double* doubleData(int column) const { return m_columns.at(column).doubles.constData(); }
+
+    /**
+     * @brief View into the string pool, valid until the column is modified
+     */
+    QStringView stringViewAt(int row, int column) const;
+    QString stringAt(int row, int column) const { return stringViewAt(row, column).toString(); }
+
+    /**
+     * @brief Typed cell value (qlonglong, double or QString)
+     */
+    QVariant valueAt(int row, int column) const;
+
+    /**
+     * @brief Copy all rows of source into this table starting at firstRow
+     *
+     * The table grows as needed. Both tables must have the same schema.
+     */
+    void assignRows(int firstRow, const ColumnarTable& source);
+
+    /**
+     * @brief Approximate heap usage of the stored cells in bytes
+     */
+    qsizetype memoryUsage() const;
+
+private:
+    struct StringSpan
+    {
+        quint32 offset = 0;
+        quint32 length = 0;
+    };
+
+    struct Column
+    {
+        ColumnType type = ColumnType::String;
+        QVector<qint64> ints;
+        QVector<double> doubles;
+        QVector<StringSpan> spans;
+        QString pool;           // UTF-16 characters of all spans
+        StringSpan lastAppended;
+        qsizetype garbage = 0;  // pool characters no longer referenced (estimate)
+    };
+
+    void compactPool(Column& column);
+
+    QVector<Column> m_columns;
+    int m_rowCount = 0;
+};
+
+} // namespace DockManager
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ColumnarQuery.h"
+#include "ColumnarTable.h"
+
+#include <QAbstractTableModel>
+#include <QScopedPointer>
+#include <QStringList>
+
+#include <memory>
+
+namespace DockManager {
+
+/**
+ * @brief Read-only table model over a ColumnarTable.
+ *
+ * Replaces QTableWidget for table panels: cells are not objects, text is
+ * produced on demand in data(), and every bulk operation emits exactly one
+ * reset, insert or dataChanged notification regardless of its size.
+ *
+ * DisplayRole returns formatted text, EditRole the typed value (qlonglong,
+ * double or QString) so proxies and sorters compare numbers as numbers.
+ *
+ * Sorting and filtering happen in the model itself, without a
+ * QSortFilterProxyModel: sort() and setFilter() hand a snapshot of the
+ * columns to computeRowOrder() on the global thread pool and return at once.
+ * The resulting permutation replaces the current one in a single step on the
+ * GUI thread. Starting a new query cancels the one in flight, and changing
+ * the data re-runs the active query.
+ *
+ * Usage:
+ * @code
+ * auto* model = new ColumnarTableModel({"#", "Function", "Line"},
+ *     {ColumnType::Int64, ColumnType::String, ColumnType::Int64}, this);
+ * ColumnarTable rows = model->createTable();
+ * // ... fill rows ...
+ * model->setTable(std::move(rows));
+ * @endcode
+ */
+class ColumnarTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Construct a model with the given column headers and types
+     * @param headers One title per column
+     * @param types One storage type per column, same length as headers
+     * @param parent Parent object
+     */
+    ColumnarTableModel(const QStringList& headers, const QVector<ColumnType>& types,
+                       QObject* parent = nullptr);
+    ~ColumnarTableModel() override;
+
+    /**
+     * @brief Get the current contents
+     */
+    const ColumnarTable& table() const;
+
+    /**
+     * @brief Create an empty table with this model's schema, for building batches
+     */
+    ColumnarTable createTable() const;
+
+    // --- Bulk Updates ---
+
+    /**
+     * @brief Replace all rows (one model reset)
+     */
+    void setTable(ColumnarTable table);
+
+    /**
+     * @brief Append rows at the end (one rowsInserted)
+     */
+    void appendRows(const ColumnarTable& rows);
+
+    /**
+     * @brief Overwrite existing rows starting at firstRow (one dataChanged)
+     *
+     * Rows past the current end are appended.
+     */
+    void updateRows(int firstRow, const ColumnarTable& rows);
+
+    /**
+     * @brief Remove all rows (one model reset)
+     */
+    void clear();
+
+    // --- Sorting and Filtering ---
+
+    /**
+     * @brief Sort by a column in the background; column -1 restores source order
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * @brief Filter rows in the background
+     * @param column Column to test, or -1 for all string columns
+     * @param expression See ColumnarFilter::parse(); empty shows all rows
+     */
+    void setFilter(int column, const QString& expression);
+
+    /**
+     * @brief Check whether a sort or filter is still being computed
+     */
+    bool isQueryRunning() const;
+
+    /**
+     * @brief Map a model row to its row in table()
+     */
+    int sourceRow(int row) const;
+
+    // --- QAbstractTableModel ---
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    /**
+     * @brief Emitted when a sort or filter starts or its result is applied
+     */
+    void queryRunningChanged(bool running);
+
+private:
+    bool checkSchema(const ColumnarTable& rows, const char* operation) const;
+    bool hasActiveQuery() const;
+    void startQuery();
+    void cancelQuery();
+    void applyRowOrder(std::shared_ptr<const QVector<int>> rows);
+
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+} // namespace DockManager
@@ -29,3 +29,9 @@
 #include "WorkspaceManager.h"
 #include "DockToolBar.h"
 #include "CustomDockComponentsFactory.h"
+#include "ColumnarTable.h"
+#include "ColumnarQuery.h"
+#include "ColumnarTableModel.h"
+#include "ColumnarItemDelegate.h"
+#include "LazyTreeModel.h"
+#include "FileSystemIndex.h"
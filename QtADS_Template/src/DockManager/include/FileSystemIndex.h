@@ -0,0 +1,159 @@
+#pragma once
+
+#include "LazyTreeModel.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+namespace DockManager {
+
+/**
+ * @brief One directory entry in a FileSystemIndex.
+ */
+struct FileSystemEntry
+{
+    QString name;
+    bool isDir = false;      ///< Also set for symbolic links to directories
+    bool isSymLink = false;
+};
+
+/**
+ * @brief Shared, asynchronous index of a directory tree for explorer panels.
+ *
+ * There is one instance per root path (see shared()), so any number of
+ * panels showing the same tree share one crawl and one set of watches.
+ *
+ * Directories are listed when first asked for. Once ensureCrawled() is
+ * called, the index also crawls the tree breadth-first on several threads
+ * (getdents64 on Linux, QDir elsewhere) until about kCrawlBudget entries are
+ * known, without crossing into other file systems or following symbolic
+ * links. Only crawl workspace-sized roots: a drive root is meant to be
+ * listed one expanded directory at a time.
+ *
+ * Every listed directory is watched: inotify on Linux, QFileSystemWatcher
+ * elsewhere. The watches the crawl adds are capped at a share of the
+ * user's inotify limit (fs.inotify.max_user_watches), which other programs
+ * need too. Events are coalesced for a short interval, the affected
+ * directories are listed again off the GUI thread and the ones that really
+ * changed are reported in one directoriesChanged() per batch, so an event
+ * storm (a build, a checkout) costs a handful of model updates. Files
+ * written in place are reported through filesModified() (Linux only).
+ */
+class FileSystemIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Entries the initial crawl lists before leaving the rest to on-demand listing
+    static constexpr int kCrawlBudget = 200000;
+
+    /**
+     * @brief Get the index for a root path, creating it on first use
+     *
+     * Call on the GUI thread. The index lives as long as someone holds it.
+     */
+    static std::shared_ptr<FileSystemIndex> shared(const QString& rootPath);
+
+    ~FileSystemIndex() override;
+
+    /**
+     * @brief Absolute, cleaned root path
+     */
+    QString rootPath() const;
+
+    /**
+     * @brief Entries of a directory: directories first, then by name ignoring case
+     *
+     * Thread safe. A directory that is not known yet is listed on the calling
+     * thread, which is meant to be a worker thread (LazyTreeProvider).
+     * @param relativePath '/' separated path below the root; empty for the root itself
+     */
+    QVector<FileSystemEntry> entries(const QString& relativePath);
+
+    /**
+     * @brief Start the crawl of the whole tree, once
+     *
+     * Thread safe. Without it only the directories asked for through
+     * entries() are listed and watched.
+     */
+    void ensureCrawled();
+
+    /**
+     * @brief Check whether the initial crawl is still running
+     */
+    bool isCrawling() const;
+
+    /**
+     * @brief Number of directories listed so far
+     */
+    int directoryCount() const;
+
+signals:
+    /**
+     * @brief The initial crawl finished
+     */
+    void crawlFinished();
+
+    /**
+     * @brief Listed directories whose entries changed, relative to the root
+     */
+    void directoriesChanged(const QStringList& relativePaths);
+
+    /**
+     * @brief Files in watched directories that were written and closed, relative to the root
+     */
+    void filesModified(const QStringList& relativePaths);
+
+private:
+    explicit FileSystemIndex(const QString& rootPath);
+
+    void startCrawl();
+    void onEvents();
+    void flushChanges();
+    void onRelisted(const QStringList& changed);
+
+    // Shared with crawl and relist jobs, which may outlive the index
+    struct Private;
+    std::shared_ptr<Private> d;
+};
+
+/**
+ * @brief LazyTreeProvider over shared FileSystemIndex instances.
+ *
+ * A root path is crawled when the tree is first shown. An empty root lists
+ * the drives at the top level, each with its own index that lists and
+ * watches only the directories expanded below it. Call bindModel() once the
+ * model exists so file system changes reach it.
+ *
+ * Usage:
+ * @code
+ * auto provider = std::make_shared<FileSystemTreeProvider>(QDir::currentPath());
+ * auto* model = new LazyTreeModel(provider, {"Name"}, tree);
+ * provider->bindModel(model);
+ * @endcode
+ */
+class FileSystemTreeProvider : public LazyTreeProvider
+{
+public:
+    /**
+     * @brief Create the provider; call on the GUI thread
+     */
+    explicit FileSystemTreeProvider(const QString& rootPath);
+
+    QVector<LazyTreeItem> fetchChildren(const QStringList& path, const std::atomic_bool& cancelled) override;
+
+    /**
+     * @brief Reload the matching nodes of model when directories change
+     */
+    void bindModel(LazyTreeModel* model) const;
+
+private:
+    bool m_listDrives = false;
+    QStringList m_driveKeys;  ///< Top-level keys when listing drives, parallel to m_indexes
+    QVector<std::shared_ptr<FileSystemIndex>> m_indexes;
+};
+
+} // namespace DockManager
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QTreeView;
+
+namespace DockManager {
+
+/**
+ * @brief One child node as delivered by a LazyTreeProvider.
+ */
+struct LazyTreeItem
+{
+    QString key;          ///< Identifies the node among its siblings; defaults to columns[0]
+    QStringList columns;  ///< Display text per column
+    bool hasChildren = false;
+    QVector<LazyTreeItem> children;  ///< Preloaded children; when set, the provider is not asked
+};
+
+/**
+ * @brief Source of tree nodes for LazyTreeModel.
+ *
+ * fetchChildren() is always called on a worker thread, never on the GUI
+ * thread, and may be called for several parents concurrently. It must not
+ * touch widgets or QObjects living on the GUI thread.
+ */
+class LazyTreeProvider
+{
+public:
+    virtual ~LazyTreeProvider() = default;
+
+    /**
+     * @brief List the children of a node
+     * @param path Keys from the top level down to the parent; empty for top-level items
+     * @param cancelled Set when the result is no longer wanted; long listings should poll it
+     */
+    virtual QVector<LazyTreeItem> fetchChildren(const QStringList& path, const std::atomic_bool& cancelled) = 0;
+};
+
+/**
+ * @brief LazyTreeProvider wrapping a callable, for simple and static trees.
+ */
+class FunctionTreeProvider : public LazyTreeProvider
+{
+public:
+    using Function = std::function<QVector<LazyTreeItem>(const QStringList& path)>;
+
+    explicit FunctionTreeProvider(Function function);
+    QVector<LazyTreeItem> fetchChildren(const QStringList& path, const std::atomic_bool& cancelled) override;
+
+private:
+    Function m_function;
+};
+
+/**
+ * @brief Tree model that loads children on demand from a LazyTreeProvider.
+ *
+ * Nothing below the top level is fetched until a view asks for it through
+ * canFetchMore()/fetchMore(), i.e. when a node is expanded. Fetches run on
+ * the global thread pool and insert their rows in one batch when done.
+ *
+ * Nodes live in one contiguous arena: a 20 byte record per node for the
+ * structure, with display text and keys in a ColumnarTable. Siblings are
+ * stored adjacently, so parent/child/row lookups are index arithmetic and
+ * the model's internal ids are arena indices.
+ *
+ * Expansion state is tracked by key path, so refresh() rebuilds the tree
+ * from the provider and re-expands whatever was open before.
+ *
+ * When the source changes underneath (a directory gained files, say),
+ * reloadChildren() fetches one node again and applies only the difference:
+ * kept rows keep their expansion, removed and added rows go out and in as
+ * contiguous runs. Removed subtrees stay in the arena until they make up
+ * more than half of it; the arena is then compacted in one layout change.
+ *
+ * Producers that push results instead (search, diagnostics) pass a null
+ * provider and add nodes with appendChildren(); each call inserts its items,
+ * including preloaded subtrees, with one rowsInserted.
+ *
+ * Usage:
+ * @code
+ * auto* model = new LazyTreeModel(std::make_shared<MyProvider>(), {"Name"}, tree);
+ * tree->setModel(model);
+ * model->bindView(tree);
+ * @endcode
+ */
+class LazyTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Construct a model and start loading the top level
+     * @param provider Node source, shared with in-flight worker jobs; may be null
+     * @param headers One title per column
+     * @param parent Parent object
+     */
+    LazyTreeModel(std::shared_ptr<LazyTreeProvider> provider, const QStringList& headers,
+                  QObject* parent = nullptr);
+    ~LazyTreeModel() override;
+
+    /**
+     * @brief Reload the whole tree, keeping expanded nodes expanded
+     *
+     * Without a provider this empties the tree.
+     */
+    void refresh();
+
+    /**
+     * @brief Append items below parent (one rowsInserted)
+     *
+     * Intended for push-based trees; a node whose children have not been
+     * fetched yet is left alone and the call is ignored.
+     */
+    void appendChildren(const QModelIndex& parent, const QVector<LazyTreeItem>& items);
+
+    /**
+     * @brief Fetch the children of the node at path again and apply the changes
+     *
+     * Rows are matched by key. Nodes that were never expanded are left
+     * alone, they load fresh when first expanded. Kept rows must keep their
+     * relative order; if they do not, the whole tree is refreshed.
+     * @param path Keys from the top level down to the node; empty for the top level
+     */
+    void reloadChildren(const QStringList& path);
+
+    /**
+     * @brief Keep expansion state in sync with a view and restore it after refresh()
+     */
+    void bindView(QTreeView* view);
+
+    /**
+     * @brief Record whether a node is expanded (done by bindView())
+     */
+    void setExpanded(const QModelIndex& index, bool expanded);
+
+    /**
+     * @brief Key path from the top level down to index
+     */
+    QStringList pathForIndex(const QModelIndex& index) const;
+
+    /**
+     * @brief Check whether children of index are being fetched
+     */
+    bool isLoading(const QModelIndex& index) const;
+
+    // --- QAbstractItemModel ---
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    /**
+     * @brief A node that was expanded before refresh() has its children again
+     */
+    void expandRequested(const QModelIndex& index);
+
+    /**
+     * @brief Children of a node finished loading
+     */
+    void childrenLoaded(const QModelIndex& parent);
+
+private:
+    void startFetch(quint32 node, quint64 reloadTicket = 0);
+    quint32 storeItems(quint32 parent, quint32 firstRow, const QVector<LazyTreeItem>& items);
+    void onChildrenFetched(quint64 generation, quint32 node, const QVector<LazyTreeItem>& items);
+    void onChildrenReloaded(quint64 generation, quint32 node, quint64 ticket, const QVector<LazyTreeItem>& items);
+    void requestExpansion(quint32 node);
+    void compactArena();
+
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+} // namespace DockManager
@@ -0,0 +1,61 @@
+#include "ColumnarItemDelegate.h"
+
+#include <QPainter>
+
+namespace DockManager {
+
+namespace {
+
+constexpr int kHorizontalMargin = 4;
+constexpr int kVerticalMargin = 2;
+
+} // namespace
+
+ColumnarItemDelegate::ColumnarItemDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+ColumnarItemDelegate::~ColumnarItemDelegate() = default;
+
+void ColumnarItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                                 const QModelIndex& index) const
+{
+    const QPalette::ColorGroup group = (option.state & QStyle::State_Enabled)
+        ? ((option.state & QStyle::State_Active) ? QPalette::Active : QPalette::Inactive)
+        : QPalette::Disabled;
+    const bool selected = option.state & QStyle::State_Selected;
+
+    if (selected) {
+        painter->fillRect(option.rect, option.palette.brush(group, QPalette::Highlight));
+    } else {
+        const QVariant background = index.data(Qt::BackgroundRole);
+        if (background.isValid())
+            painter->fillRect(option.rect, background.value<QBrush>());
+    }
+
+    const QString text = index.data(Qt::DisplayRole).toString();
+    if (text.isEmpty())
+        return;
+
+    const QVariant alignment = index.data(Qt::TextAlignmentRole);
+    const int flags = alignment.isValid() ? alignment.toInt() : int(Qt::AlignLeft | Qt::AlignVCenter);
+    const QRect textRect = option.rect.adjusted(kHorizontalMargin, 0, -kHorizontalMargin, 0);
+
+    painter->save();
+    painter->setFont(option.font);
+    painter->setPen(option.palette.color(group, selected ? QPalette::HighlightedText : QPalette::Text));
+    painter->drawText(textRect, flags,
+                      option.fontMetrics.elidedText(text, Qt::ElideRight, textRect.width()));
+    painter->restore();
+}
+
+QSize ColumnarItemDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    // Width is only used by resizeColumnToContents(); height is uniform
+    const QString text = index.data(Qt::DisplayRole).toString();
+    return QSize(option.fontMetrics.horizontalAdvance(text) + 2 * kHorizontalMargin,
+                 option.fontMetrics.height() + 2 * kVerticalMargin);
+}
+
+} // namespace DockManager
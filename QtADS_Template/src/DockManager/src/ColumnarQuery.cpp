@@ -0,0 +1,513 @@
+#include "ColumnarQuery.h"
+
+#include <QThread>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COLUMNAR_QUERY_SSE2 1
+#endif
+
+namespace DockManager {
+
+namespace {
+
+// Below this many rows a single thread beats the cost of spawning workers
+constexpr int kParallelThreshold = 1 << 16;
+
+int threadCountFor(int rows)
+{
+    if (rows < kParallelThreshold)
+        return 1;
+    return qBound(1, QThread::idealThreadCount(), 16);
+}
+
+// Run fn(0) .. fn(count - 1) concurrently, fn(0) on the calling thread.
+// Plain threads rather than QThreadPool: the query itself already runs on
+// the global pool, and blocking a pool thread on tasks queued to the same
+// pool can deadlock.
+template <typename Fn>
+void parallelFor(int count, Fn fn)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(size_t(count > 1 ? count - 1 : 0));
+    for (int t = 1; t < count; ++t)
+        workers.emplace_back(fn, t);
+    fn(0);
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+// [begin, end) of chunk t when splitting n items into count chunks
+inline int chunkBegin(int n, int count, int t)
+{
+    return int(qint64(n) * t / count);
+}
+
+// ---------------------------------------------------------------------------
+// Filtering
+// ---------------------------------------------------------------------------
+template <typename T>
+bool compareNumber(T value, T operand, ColumnarFilter::Operator op)
+{
+    switch (op) {
+    case ColumnarFilter::Operator::Contains:
+    case ColumnarFilter::Operator::Equal:
+        return value == operand;
+    case ColumnarFilter::Operator::NotEqual:
+        return value != operand;
+    case ColumnarFilter::Operator::Less:
+        return value < operand;
+    case ColumnarFilter::Operator::LessEqual:
+        return value <= operand;
+    case ColumnarFilter::Operator::Greater:
+        return value > operand;
+    case ColumnarFilter::Operator::GreaterEqual:
+        return value >= operand;
+    }
+    return false;
+}
+
+// Writes one byte per row (0/1) for rows [begin, end) of an integer column.
+// Each operator gets its own branch-free loop, which compilers vectorize.
+void matchInt64(const qint64* values, int begin, int end, qint64 operand, ColumnarFilter::Operator op,
+                uchar* mask)
+{
+    using Op = ColumnarFilter::Operator;
+    switch (op) {
+    case Op::Contains:
+    case Op::Equal:
+        for (int i = begin; i < end; ++i)
+            mask[i] = values[i] == operand;
+        break;
+    case Op::NotEqual:
+        for (int i = begin; i < end; ++i)
+            mask[i] = values[i] != operand;
+        break;
+    case Op::Less:
+        for (int i = begin; i < end; ++i)
+            mask[i] = values[i] < operand;
+        break;
+    case Op::LessEqual:
+        for (int i = begin; i < end; ++i)
+            mask[i] = values[i] <= operand;
+        break;
+    case Op::Greater:
+        for (int i = begin; i < end; ++i)
+            mask[i] = values[i] > operand;
+        break;
+    case Op::GreaterEqual:
+        for (int i = begin; i < end; ++i)
+            mask[i] = values[i] >= operand;
+        break;
+    }
+}
+
+// matchInt64() for a double operand. Fractional operands are rounded so the
+// integer comparison selects the same rows as comparing as double:
+// v < 1.5 becomes v < 2, v > 1.5 becomes v > 1.
+void matchInt64(const qint64* values, int begin, int end, double operand, ColumnarFilter::Operator op,
+                uchar* mask)
+{
+    using Op = ColumnarFilter::Operator;
+    const bool ordering = op == Op::Less || op == Op::LessEqual || op == Op::Greater || op == Op::GreaterEqual;
+    const double rounded = (op == Op::Less || op == Op::GreaterEqual) ? std::ceil(operand) : std::floor(operand);
+
+    constexpr double kLimit = 9223372036854775808.0; // 2^63
+    const bool inRange = rounded >= -kLimit && rounded < kLimit;
+    if (inRange && (ordering || rounded == operand)) {
+        matchInt64(values, begin, end, qint64(rounded), op, mask);
+        return;
+    }
+
+    // No integer equals the operand, or it lies outside the qint64 range:
+    // every row compares the same way as 0 against a stand-in operand
+    const double standIn = rounded >= kLimit ? std::numeric_limits<double>::infinity()
+                         : rounded < -kLimit ? -std::numeric_limits<double>::infinity()
+                                             : std::numeric_limits<double>::quiet_NaN();
+    std::memset(mask + begin, compareNumber(0.0, standIn, op) ? 1 : 0, size_t(end - begin));
+}
+
+void matchDouble(const double* values, int begin, int end, double operand, ColumnarFilter::Operator op,
+                 uchar* mask)
+{
+    int i = begin;
+#if defined(COLUMNAR_QUERY_SSE2)
+    using Op = ColumnarFilter::Operator;
+    const __m128d x = _mm_set1_pd(operand);
+    for (; i + 2 <= end; i += 2) {
+        const __m128d v = _mm_loadu_pd(values + i);
+        __m128d m;
+        switch (op) {
+        case Op::NotEqual:
+            m = _mm_cmpneq_pd(v, x);
+            break;
+        case Op::Less:
+            m = _mm_cmplt_pd(v, x);
+            break;
+        case Op::LessEqual:
+            m = _mm_cmple_pd(v, x);
+            break;
+        case Op::Greater:
+            m = _mm_cmpgt_pd(v, x);
+            break;
+        case Op::GreaterEqual:
+            m = _mm_cmpge_pd(v, x);
+            break;
+        default:
+            m = _mm_cmpeq_pd(v, x);
+            break;
+        }
+        const int bits = _mm_movemask_pd(m);
+        mask[i] = uchar(bits & 1);
+        mask[i + 1] = uchar((bits >> 1) & 1);
+    }
+#endif
+    for (; i < end; ++i)
+        mask[i] = compareNumber(values[i], operand, op);
+}
+
+// Case-insensitive substring search. The first needle character is located
+// eight UTF-16 units at a time (lower and upper case variants), candidates
+// are then verified with a full comparison.
+class SubstringMatcher
+{
+public:
+    explicit SubstringMatcher(const QString& needle)
+        : m_needle(needle)
+        , m_lower(needle.isEmpty() ? 0 : needle.at(0).toLower().unicode())
+        , m_upper(needle.isEmpty() ? 0 : needle.at(0).toUpper().unicode())
+    {
+    }
+
+    bool matches(QStringView haystack) const
+    {
+        const qsizetype length = m_needle.size();
+        if (length == 0)
+            return true;
+        if (haystack.size() < length)
+            return false;
+
+        const char16_t* data = haystack.utf16();
+        const qsizetype lastStart = haystack.size() - length;
+        qsizetype i = 0;
+#if defined(COLUMNAR_QUERY_SSE2)
+        const __m128i lower = _mm_set1_epi16(short(m_lower));
+        const __m128i upper = _mm_set1_epi16(short(m_upper));
+        for (; i + 8 <= lastStart + 1; i += 8) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i hits = _mm_or_si128(_mm_cmpeq_epi16(chunk, lower), _mm_cmpeq_epi16(chunk, upper));
+            // Two mask bits per 16-bit lane
+            quint32 bits = quint32(_mm_movemask_epi8(hits));
+            while (bits) {
+                const int lane = qCountTrailingZeroBits(bits) / 2;
+                if (verify(data + i + lane))
+                    return true;
+                bits &= ~(3u << (lane * 2));
+            }
+        }
+#endif
+        for (; i <= lastStart; ++i) {
+            if ((data[i] == m_lower || data[i] == m_upper) && verify(data + i))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    bool verify(const char16_t* candidate) const
+    {
+        return QStringView(candidate, m_needle.size()).compare(m_needle, Qt::CaseInsensitive) == 0;
+    }
+
+    QString m_needle;
+    char16_t m_lower;
+    char16_t m_upper;
+};
+
+bool matchString(QStringView value, const ColumnarFilter& filter, const SubstringMatcher& matcher)
+{
+    if (filter.op == ColumnarFilter::Operator::Contains)
+        return matcher.matches(value);
+    const int order = value.compare(filter.text, Qt::CaseInsensitive);
+    return compareNumber(order, 0, filter.op);
+}
+
+void matchStrings(const ColumnarTable& table, int column, int begin, int end, const ColumnarFilter& filter,
+                  const SubstringMatcher& matcher, uchar* mask)
+{
+    // Runs of equal strings share their storage; reuse the previous verdict
+    const char16_t* previousData = nullptr;
+    qsizetype previousSize = -1;
+    uchar previous = 0;
+    for (int r = begin; r < end; ++r) {
+        const QStringView value = table.stringViewAt(r, column);
+        if (value.utf16() != previousData || value.size() != previousSize) {
+            previousData = value.utf16();
+            previousSize = value.size();
+            previous = matchString(value, filter, matcher);
+        }
+        mask[r] |= previous;
+    }
+}
+
+bool filterRows(const ColumnarTable& table, const ColumnarFilter& filter, int threads,
+                const std::atomic_bool& cancelled, QVector<int>* rows)
+{
+    const int n = table.rowCount();
+    std::vector<uchar> mask(size_t(n), 0);
+    const SubstringMatcher matcher(filter.text);
+
+    QVector<int> columns;
+    if (filter.column >= 0 && filter.column < table.columnCount()) {
+        columns.append(filter.column);
+    } else {
+        for (int c = 0; c < table.columnCount(); ++c) {
+            if (table.columnType(c) == ColumnType::String)
+                columns.append(c);
+        }
+    }
+
+    std::vector<std::vector<int>> parts(static_cast<size_t>(threads));
+    parallelFor(threads, [&](int t) {
+        const int begin = chunkBegin(n, threads, t);
+        const int end = chunkBegin(n, threads, t + 1);
+        for (int column : columns) {
+            if (cancelled.load(std::memory_order_relaxed))
+                return;
+            switch (table.columnType(column)) {
+            case ColumnType::Int64:
+                if (filter.numberValid)
+                    matchInt64(table.int64Data(column), begin, end, filter.number, filter.op, mask.data());
+                break;
+            case ColumnType::Double:
+                if (filter.numberValid)
+                    matchDouble(table.doubleData(column), begin, end, filter.number, filter.op, mask.data());
+                break;
+            case ColumnType::String:
+                matchStrings(table, column, begin, end, filter, matcher, mask.data());
+                break;
+            }
+        }
+        std::vector<int>& part = parts[size_t(t)];
+        for (int r = begin; r < end; ++r) {
+            if (mask[size_t(r)])
+                part.push_back(r);
+        }
+    });
+    if (cancelled.load())
+        return false;
+
+    rows->clear();
+    for (const std::vector<int>& part : parts)
+        rows->append(QVector<int>(part.cbegin(), part.cend()));
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Sorting
+// ---------------------------------------------------------------------------
+
+// Map numbers to unsigned keys whose unsigned order equals numeric order
+inline quint64 sortKey(qint64 value)
+{
+    return quint64(value) ^ (quint64(1) << 63);
+}
+
+inline quint64 sortKey(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & (quint64(1) << 63)) ? ~bits : bits | (quint64(1) << 63);
+}
+
+// Stable LSD radix sort of rows by 64-bit keys, 8 bits per pass. Each
+// thread histograms and scatters its own contiguous chunk, so the result is
+// identical to a sequential sort. Passes in which every key has the same
+// digit (the high bytes of small integers, typically) are skipped.
+bool radixSort(std::vector<quint64>& keys, QVector<int>& rows, int threads, const std::atomic_bool& cancelled)
+{
+    const int n = rows.size();
+    std::vector<quint64> keyBuffer(static_cast<size_t>(n));
+    std::vector<int> rowBuffer(static_cast<size_t>(n));
+    std::vector<int> rowData(rows.cbegin(), rows.cend());
+    std::vector<std::array<int, 256>> counts(static_cast<size_t>(threads));
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (cancelled.load(std::memory_order_relaxed))
+            return false;
+
+        parallelFor(threads, [&](int t) {
+            std::array<int, 256>& count = counts[size_t(t)];
+            count.fill(0);
+            for (int i = chunkBegin(n, threads, t), end = chunkBegin(n, threads, t + 1); i < end; ++i)
+                ++count[(keys[size_t(i)] >> shift) & 0xFF];
+        });
+
+        // Turn per-thread counts into per-thread start offsets, digit-major
+        // so equal digits keep their chunk order
+        int offset = 0;
+        bool trivial = false;
+        for (int digit = 0; digit < 256; ++digit) {
+            int total = 0;
+            for (int t = 0; t < threads; ++t) {
+                const int count = counts[size_t(t)][size_t(digit)];
+                counts[size_t(t)][size_t(digit)] = offset;
+                offset += count;
+                total += count;
+            }
+            if (total == n)
+                trivial = true;
+        }
+        if (trivial)
+            continue;
+
+        parallelFor(threads, [&](int t) {
+            std::array<int, 256>& next = counts[size_t(t)];
+            for (int i = chunkBegin(n, threads, t), end = chunkBegin(n, threads, t + 1); i < end; ++i) {
+                const int target = next[(keys[size_t(i)] >> shift) & 0xFF]++;
+                keyBuffer[size_t(target)] = keys[size_t(i)];
+                rowBuffer[size_t(target)] = rowData[size_t(i)];
+            }
+        });
+        keys.swap(keyBuffer);
+        rowData.swap(rowBuffer);
+    }
+
+    std::copy(rowData.cbegin(), rowData.cend(), rows.begin());
+    return true;
+}
+
+template <typename T>
+bool sortNumeric(const T* values, Qt::SortOrder order, QVector<int>& rows, int threads,
+                 const std::atomic_bool& cancelled)
+{
+    std::vector<quint64> keys(static_cast<size_t>(rows.size()));
+    const quint64 flip = order == Qt::DescendingOrder ? ~quint64(0) : 0;
+    parallelFor(threads, [&](int t) {
+        for (int i = chunkBegin(rows.size(), threads, t), end = chunkBegin(rows.size(), threads, t + 1); i < end; ++i)
+            keys[size_t(i)] = sortKey(values[rows.at(i)]) ^ flip;
+    });
+    return radixSort(keys, rows, threads, cancelled);
+}
+
+// Stable parallel merge sort: each thread sorts a chunk, then chunks are
+// merged pairwise in parallel until one run remains
+bool sortStrings(const ColumnarTable& table, int column, Qt::SortOrder order, QVector<int>& rows, int threads,
+                 const std::atomic_bool& cancelled)
+{
+    const auto less = [&table, column, order](int a, int b) {
+        const int result = table.stringViewAt(a, column).compare(table.stringViewAt(b, column), Qt::CaseInsensitive);
+        return order == Qt::AscendingOrder ? result < 0 : result > 0;
+    };
+
+    const int n = rows.size();
+    std::vector<int> runs;
+    for (int t = 0; t <= threads; ++t)
+        runs.push_back(chunkBegin(n, threads, t));
+
+    int* data = rows.data();
+    parallelFor(threads, [&](int t) {
+        std::stable_sort(data + runs[size_t(t)], data + runs[size_t(t) + 1], less);
+    });
+
+    std::vector<int> buffer(static_cast<size_t>(n));
+    int* source = data;
+    int* target = buffer.data();
+    while (runs.size() > 2) {
+        if (cancelled.load(std::memory_order_relaxed))
+            return false;
+
+        const int pairs = int(runs.size() - 1) / 2;
+        const bool oddRun = (runs.size() - 1) % 2 != 0;
+        parallelFor(pairs, [&](int p) {
+            const int begin = runs[size_t(2 * p)];
+            const int middle = runs[size_t(2 * p + 1)];
+            const int end = runs[size_t(2 * p + 2)];
+            std::merge(source + begin, source + middle, source + middle, source + end, target + begin, less);
+        });
+        if (oddRun) {
+            const int begin = runs[runs.size() - 2];
+            std::copy(source + begin, source + n, target + begin);
+        }
+
+        std::vector<int> merged;
+        for (size_t i = 0; i < runs.size(); i += 2)
+            merged.push_back(runs[i]);
+        if (merged.back() != n)
+            merged.push_back(n);
+        runs.swap(merged);
+        std::swap(source, target);
+    }
+    if (source != data)
+        std::copy(source, source + n, data);
+    return true;
+}
+
+} // namespace
+
+ColumnarFilter ColumnarFilter::parse(int column, const QString& expression)
+{
+    static const struct
+    {
+        const char* token;
+        Operator op;
+    } operators[] = {
+        // Two-character operators first so "<=" is not read as "<"
+        {"!=", Operator::NotEqual}, {"<=", Operator::LessEqual}, {">=", Operator::GreaterEqual},
+        {"=", Operator::Equal}, {"<", Operator::Less}, {">", Operator::Greater},
+    };
+
+    ColumnarFilter filter;
+    filter.column = column;
+    QString text = expression.trimmed();
+    for (const auto& candidate : operators) {
+        if (text.startsWith(QLatin1String(candidate.token))) {
+            filter.op = candidate.op;
+            text = text.mid(int(std::strlen(candidate.token))).trimmed();
+            break;
+        }
+    }
+    filter.text = text;
+    filter.number = text.toDouble(&filter.numberValid);
+    return filter;
+}
+
+bool computeRowOrder(const ColumnarTable& table, const ColumnarFilter& filter, const ColumnarSort& sort,
+                     const std::atomic_bool& cancelled, QVector<int>* rows)
+{
+    const int threads = threadCountFor(table.rowCount());
+
+    if (filter.isActive()) {
+        if (!filterRows(table, filter, threads, cancelled, rows))
+            return false;
+    } else {
+        rows->resize(table.rowCount());
+        std::iota(rows->begin(), rows->end(), 0);
+    }
+
+    if (!sort.isActive() || sort.column >= table.columnCount() || rows->size() < 2)
+        return !cancelled.load();
+
+    const int sortThreads = threadCountFor(rows->size());
+    switch (table.columnType(sort.column)) {
+    case ColumnType::Int64:
+        return sortNumeric(table.int64Data(sort.column), sort.order, *rows, sortThreads, cancelled);
+    case ColumnType::Double:
+        return sortNumeric(table.doubleData(sort.column), sort.order, *rows, sortThreads, cancelled);
+    case ColumnType::String:
+        return sortStrings(table, sort.column, sort.order, *rows, sortThreads, cancelled);
+    }
+    return false;
+}
+
+} // namespace DockManager
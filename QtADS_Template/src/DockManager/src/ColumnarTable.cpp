@@ -0,0 +1,244 @@
+#include "ColumnarTable.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <limits>
+
+namespace DockManager {
+
+namespace {
+
+// Compact a string pool once this many characters are unreferenced and they
+// make up more than half of it; small pools are not worth the pass.
+constexpr qsizetype kMinGarbageForCompaction = 4096;
+
+} // namespace
+
+ColumnarTable::ColumnarTable(const QVector<ColumnType>& types)
+{
+    m_columns.resize(types.size());
+    for (int c = 0; c < types.size(); ++c)
+        m_columns[c].type = types.at(c);
+}
+
+QVector<ColumnType> ColumnarTable::columnTypes() const
+{
+    QVector<ColumnType> types;
+    types.reserve(m_columns.size());
+    for (const Column& column : m_columns)
+        types.append(column.type);
+    return types;
+}
+
+bool ColumnarTable::hasSameSchema(const ColumnarTable& other) const
+{
+    if (m_columns.size() != other.m_columns.size())
+        return false;
+    for (int c = 0; c < m_columns.size(); ++c) {
+        if (m_columns.at(c).type != other.m_columns.at(c).type)
+            return false;
+    }
+    return true;
+}
+
+void ColumnarTable::reserve(int rows)
+{
+    for (Column& column : m_columns) {
+        switch (column.type) {
+        case ColumnType::Int64:
+            column.ints.reserve(rows);
+            break;
+        case ColumnType::Double:
+            column.doubles.reserve(rows);
+            break;
+        case ColumnType::String:
+            column.spans.reserve(rows);
+            break;
+        }
+    }
+}
+
+void ColumnarTable::clearRows()
+{
+    for (Column& column : m_columns) {
+        column.ints.clear();
+        column.doubles.clear();
+        column.spans.clear();
+        column.pool.clear();
+        column.lastAppended = {};
+        column.garbage = 0;
+    }
+    m_rowCount = 0;
+}
+
+int ColumnarTable::appendRow()
+{
+    resize(m_rowCount + 1);
+    return m_rowCount - 1;
+}
+
+void ColumnarTable::resize(int rows)
+{
+    for (Column& column : m_columns) {
+        switch (column.type) {
+        case ColumnType::Int64:
+            column.ints.resize(rows);
+            break;
+        case ColumnType::Double:
+            column.doubles.resize(rows);
+            break;
+        case ColumnType::String:
+            column.spans.resize(rows);
+            break;
+        }
+    }
+    m_rowCount = rows;
+}
+
+void ColumnarTable::setInt64(int row, int column, qint64 value)
+{
+    Q_ASSERT(m_columns.at(column).type == ColumnType::Int64);
+    m_columns[column].ints[row] = value;
+}
+
+void ColumnarTable::setDouble(int row, int column, double value)
+{
+    Q_ASSERT(m_columns.at(column).type == ColumnType::Double);
+    m_columns[column].doubles[row] = value;
+}
+
+void ColumnarTable::setString(int row, int column, QStringView value)
+{
+    Column& col = m_columns[column];
+    Q_ASSERT(col.type == ColumnType::String);
+
+    StringSpan& span = col.spans[row];
+    if (QStringView(col.pool).mid(span.offset, span.length) == value)
+        return;
+    // Appending a view of the pool to itself could reallocate under the view
+    if (value.data() >= col.pool.constData() && value.data() < col.pool.constData() + col.pool.size()) {
+        setString(row, column, value.toString());
+        return;
+    }
+    col.garbage += span.length;
+
+    // Rows are usually filled top to bottom, so comparing against the last
+    // string written catches runs of repeated values without a hash lookup
+    const StringSpan last = col.lastAppended;
+    if (QStringView(col.pool).mid(last.offset, last.length) == value) {
+        span = last;
+    } else {
+        Q_ASSERT(col.pool.size() + value.size() <= qsizetype(std::numeric_limits<quint32>::max()));
+        span.offset = quint32(col.pool.size());
+        span.length = quint32(value.size());
+        col.pool.append(value);
+        col.lastAppended = span;
+    }
+
+    if (col.garbage > kMinGarbageForCompaction && col.garbage * 2 > col.pool.size())
+        compactPool(col);
+}
+
+void ColumnarTable::setValue(int row, int column, const QVariant& value)
+{
+    switch (m_columns.at(column).type) {
+    case ColumnType::Int64:
+        setInt64(row, column, value.toLongLong());
+        break;
+    case ColumnType::Double:
+        setDouble(row, column, value.toDouble());
+        break;
+    case ColumnType::String:
+        setString(row, column, value.toString());
+        break;
+    }
+}
+
+qint64 ColumnarTable::int64At(int row, int column) const
+{
+    return m_columns.at(column).ints.at(row);
+}
+
+double ColumnarTable::doubleAt(int row, int column) const
+{
+    return m_columns.at(column).doubles.at(row);
+}
+
+QStringView ColumnarTable::stringViewAt(int row, int column) const
+{
+    const Column& col = m_columns.at(column);
+    const StringSpan span = col.spans.at(row);
+    return QStringView(col.pool).mid(span.offset, span.length);
+}
+
+QVariant ColumnarTable::valueAt(int row, int column) const
+{
+    switch (m_columns.at(column).type) {
+    case ColumnType::Int64:
+        return QVariant::fromValue(int64At(row, column));
+    case ColumnType::Double:
+        return doubleAt(row, column);
+    case ColumnType::String:
+        return stringAt(row, column);
+    }
+    return {};
+}
+
+void ColumnarTable::assignRows(int firstRow, const ColumnarTable& source)
+{
+    Q_ASSERT(hasSameSchema(source));
+    if (firstRow + source.rowCount() > m_rowCount)
+        resize(firstRow + source.rowCount());
+
+    for (int c = 0; c < m_columns.size(); ++c) {
+        Column& col = m_columns[c];
+        const Column& src = source.m_columns.at(c);
+        switch (col.type) {
+        case ColumnType::Int64:
+            std::copy(src.ints.cbegin(), src.ints.cend(), col.ints.begin() + firstRow);
+            break;
+        case ColumnType::Double:
+            std::copy(src.doubles.cbegin(), src.doubles.cend(), col.doubles.begin() + firstRow);
+            break;
+        case ColumnType::String:
+            for (int r = 0; r < source.rowCount(); ++r)
+                setString(firstRow + r, c, source.stringViewAt(r, c));
+            break;
+        }
+    }
+}
+
+qsizetype ColumnarTable::memoryUsage() const
+{
+    qsizetype bytes = 0;
+    for (const Column& column : m_columns) {
+        bytes += column.ints.capacity() * qsizetype(sizeof(qint64));
+        bytes += column.doubles.capacity() * qsizetype(sizeof(double));
+        bytes += column.spans.capacity() * qsizetype(sizeof(StringSpan));
+        bytes += column.pool.capacity() * qsizetype(sizeof(QChar));
+    }
+    return bytes;
+}
+
+void ColumnarTable::compactPool(Column& column)
+{
+    // Shared spans must stay shared, so remap by the old (offset, length)
+    QHash<quint64, StringSpan> remapped;
+    QString pool;
+    for (StringSpan& span : column.spans) {
+        const quint64 key = (quint64(span.offset) << 32) | span.length;
+        auto it = remapped.constFind(key);
+        if (it == remapped.constEnd()) {
+            const StringSpan moved{quint32(pool.size()), span.length};
+            pool.append(QStringView(column.pool).mid(span.offset, span.length));
+            it = remapped.insert(key, moved);
+        }
+        span = it.value();
+    }
+    column.pool = pool;
+    column.lastAppended = {};
+    column.garbage = 0;
+}
+
+} // namespace DockManager
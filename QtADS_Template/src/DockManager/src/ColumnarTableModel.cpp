@@ -0,0 +1,298 @@
+#include "ColumnarTableModel.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QPointer>
+#include <QThreadPool>
+
+#include <atomic>
+
+namespace DockManager {
+
+struct ColumnarTableModel::Private
+{
+    QStringList headers;
+    ColumnarTable table;
+
+    // Visible source rows in display order; null shows the table as is
+    std::shared_ptr<const QVector<int>> rowOrder;
+
+    ColumnarFilter filter;
+    ColumnarSort sort;
+    quint64 queryId = 0;
+    std::shared_ptr<std::atomic_bool> queryCancelled;  // set while a query runs
+};
+
+ColumnarTableModel::ColumnarTableModel(const QStringList& headers, const QVector<ColumnType>& types,
+                                       QObject* parent)
+    : QAbstractTableModel(parent)
+    , d(new Private)
+{
+    if (headers.size() != types.size())
+        qWarning() << "ColumnarTableModel: header count" << headers.size()
+                   << "does not match column count" << types.size();
+    d->headers = headers;
+    d->table = ColumnarTable(types);
+}
+
+ColumnarTableModel::~ColumnarTableModel()
+{
+    if (d->queryCancelled)
+        d->queryCancelled->store(true);
+}
+
+const ColumnarTable& ColumnarTableModel::table() const
+{
+    return d->table;
+}
+
+ColumnarTable ColumnarTableModel::createTable() const
+{
+    return ColumnarTable(d->table.columnTypes());
+}
+
+bool ColumnarTableModel::checkSchema(const ColumnarTable& rows, const char* operation) const
+{
+    if (rows.hasSameSchema(d->table))
+        return true;
+    qWarning() << "ColumnarTableModel:" << operation << "ignored, column types do not match the model";
+    return false;
+}
+
+void ColumnarTableModel::setTable(ColumnarTable table)
+{
+    if (!checkSchema(table, "setTable"))
+        return;
+
+    beginResetModel();
+    d->table = std::move(table);
+    d->rowOrder.reset();
+    endResetModel();
+
+    if (hasActiveQuery())
+        startQuery();
+}
+
+void ColumnarTableModel::appendRows(const ColumnarTable& rows)
+{
+    if (!checkSchema(rows, "appendRows") || rows.rowCount() == 0)
+        return;
+
+    const int first = d->table.rowCount();
+    if (d->rowOrder) {
+        // New rows become visible when the re-run query places them
+        d->table.assignRows(first, rows);
+        startQuery();
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), first, first + rows.rowCount() - 1);
+    d->table.assignRows(first, rows);
+    endInsertRows();
+
+    if (hasActiveQuery())
+        startQuery();
+}
+
+void ColumnarTableModel::updateRows(int firstRow, const ColumnarTable& rows)
+{
+    if (!checkSchema(rows, "updateRows") || rows.rowCount() == 0)
+        return;
+    if (firstRow < 0 || firstRow > d->table.rowCount()) {
+        qWarning() << "ColumnarTableModel: updateRows start" << firstRow << "out of range";
+        return;
+    }
+
+    if (d->rowOrder) {
+        // Updated rows are scattered over the permutation; repaint all of it
+        d->table.assignRows(firstRow, rows);
+        if (rowCount() > 0)
+            emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
+        startQuery();
+        return;
+    }
+
+    // Split into the overwritten part and the appended tail so that views
+    // get one notification of each kind at most
+    const int existing = qMin(rows.rowCount(), d->table.rowCount() - firstRow);
+    if (existing < rows.rowCount())
+        beginInsertRows(QModelIndex(), d->table.rowCount(), firstRow + rows.rowCount() - 1);
+    d->table.assignRows(firstRow, rows);
+    if (existing < rows.rowCount())
+        endInsertRows();
+
+    if (existing > 0)
+        emit dataChanged(index(firstRow, 0), index(firstRow + existing - 1, columnCount() - 1));
+
+    if (hasActiveQuery())
+        startQuery();
+}
+
+void ColumnarTableModel::clear()
+{
+    cancelQuery();
+    beginResetModel();
+    d->table.clearRows();
+    d->rowOrder.reset();
+    endResetModel();
+}
+
+void ColumnarTableModel::sort(int column, Qt::SortOrder order)
+{
+    d->sort.column = column;
+    d->sort.order = order;
+    startQuery();
+}
+
+void ColumnarTableModel::setFilter(int column, const QString& expression)
+{
+    d->filter = ColumnarFilter::parse(column, expression);
+    startQuery();
+}
+
+bool ColumnarTableModel::isQueryRunning() const
+{
+    return d->queryCancelled != nullptr;
+}
+
+int ColumnarTableModel::sourceRow(int row) const
+{
+    return d->rowOrder ? d->rowOrder->at(row) : row;
+}
+
+bool ColumnarTableModel::hasActiveQuery() const
+{
+    return d->filter.isActive() || d->sort.isActive();
+}
+
+void ColumnarTableModel::cancelQuery()
+{
+    ++d->queryId;
+    if (!d->queryCancelled)
+        return;
+    d->queryCancelled->store(true);
+    d->queryCancelled.reset();
+    emit queryRunningChanged(false);
+}
+
+void ColumnarTableModel::startQuery()
+{
+    cancelQuery();
+    if (!hasActiveQuery()) {
+        applyRowOrder(nullptr);
+        return;
+    }
+
+    const quint64 id = d->queryId;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    d->queryCancelled = cancelled;
+    emit queryRunningChanged(true);
+
+    // Copying the table only bumps the reference counts of its column
+    // vectors; later edits on this thread detach, the snapshot stays intact
+    const ColumnarTable snapshot = d->table;
+    const ColumnarFilter filter = d->filter;
+    const ColumnarSort sort = d->sort;
+
+    QPointer<ColumnarTableModel> guard(this);
+    QThreadPool::globalInstance()->start([guard, id, cancelled, snapshot, filter, sort]() {
+        auto rows = std::make_shared<QVector<int>>();
+        if (!computeRowOrder(snapshot, filter, sort, *cancelled, rows.get()))
+            return;
+        std::shared_ptr<const QVector<int>> result = std::move(rows);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, id, result]() {
+            if (!guard || guard->d->queryId != id)
+                return;
+            guard->d->queryCancelled.reset();
+            guard->applyRowOrder(result);
+            emit guard->queryRunningChanged(false);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ColumnarTableModel::applyRowOrder(std::shared_ptr<const QVector<int>> rows)
+{
+    if (!rows && !d->rowOrder)
+        return;
+
+    const int newCount = rows ? rows->size() : d->table.rowCount();
+    if (newCount != rowCount()) {
+        beginResetModel();
+        d->rowOrder = std::move(rows);
+        endResetModel();
+        return;
+    }
+
+    // Same row count: a pure reordering, which keeps selection and current
+    // index on the rows they were on
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList from = persistentIndexList();
+    if (!from.isEmpty()) {
+        QVector<int> newRowOf(d->table.rowCount(), -1);
+        for (int r = 0; r < newCount; ++r)
+            newRowOf[rows ? rows->at(r) : r] = r;
+
+        QModelIndexList to;
+        to.reserve(from.size());
+        for (const QModelIndex& old : from) {
+            const int row = newRowOf.value(sourceRow(old.row()), -1);
+            to.append(row < 0 ? QModelIndex() : index(row, old.column()));
+        }
+        changePersistentIndexList(from, to);
+    }
+    d->rowOrder = std::move(rows);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+int ColumnarTableModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return d->rowOrder ? d->rowOrder->size() : d->table.rowCount();
+}
+
+int ColumnarTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : d->table.columnCount();
+}
+
+QVariant ColumnarTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return {};
+
+    const int row = sourceRow(index.row());
+    const int column = index.column();
+    const ColumnType type = d->table.columnType(column);
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+        switch (type) {
+        case ColumnType::Int64:
+            return QString::number(d->table.int64At(row, column));
+        case ColumnType::Double:
+            return QString::number(d->table.doubleAt(row, column));
+        case ColumnType::String:
+            return d->table.stringAt(row, column);
+        }
+        return {};
+    case Qt::EditRole:
+        return d->table.valueAt(row, column);
+    case Qt::TextAlignmentRole:
+        if (type == ColumnType::String)
+            return int(Qt::AlignLeft | Qt::AlignVCenter);
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    default:
+        return {};
+    }
+}
+
+QVariant ColumnarTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < d->headers.size())
+        return d->headers.at(section);
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+} // namespace DockManager
@@ -0,0 +1,734 @@
+#include "FileSystemIndex.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QPointer>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(Q_OS_LINUX)
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <QFileSystemWatcher>
+#endif
+
+namespace DockManager {
+
+namespace {
+
+// Events are collected for this long before the directories are listed again
+constexpr int kCoalesceMs = 100;
+
+constexpr int kMaxCrawlThreads = 8;
+
+#if defined(Q_OS_LINUX)
+// The inotify limit is per user and shared with every other program, so the
+// initial crawl watches at most a quarter of it; directories listed on
+// demand (expanded in a view) are watched regardless
+int crawlWatchBudget()
+{
+    static const int budget = []() {
+        int limit = 8192;  // Kernel default before 5.11
+        QFile file(QStringLiteral("/proc/sys/fs/inotify/max_user_watches"));
+        if (file.open(QIODevice::ReadOnly)) {
+            bool ok = false;
+            const int value = file.readAll().trimmed().toInt(&ok);
+            if (ok && value > 0)
+                limit = value;
+        }
+        return qBound(256, limit / 4, 65536);
+    }();
+    return budget;
+}
+#endif
+
+#if !defined(Q_OS_LINUX)
+// QFileSystemWatcher keeps a handle per directory; keep that bounded
+constexpr int kMaxFallbackWatches = 4096;
+#endif
+
+struct Listing
+{
+    bool ok = false;
+    quint64 device = 0;  // 0 where unknown
+    QVector<FileSystemEntry> entries;
+};
+
+bool entryLess(const FileSystemEntry& a, const FileSystemEntry& b)
+{
+    if (a.isDir != b.isDir)
+        return a.isDir;
+    const int c = a.name.compare(b.name, Qt::CaseInsensitive);
+    return c != 0 ? c < 0 : a.name < b.name;
+}
+
+bool sameEntries(const QVector<FileSystemEntry>& a, const QVector<FileSystemEntry>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].name != b[i].name || a[i].isDir != b[i].isDir || a[i].isSymLink != b[i].isSymLink)
+            return false;
+    }
+    return true;
+}
+
+QString childPath(const QString& dir, const QString& name)
+{
+    return dir.isEmpty() ? name : dir + QLatin1Char('/') + name;
+}
+
+QString parentPath(const QString& path)
+{
+    const int slash = path.lastIndexOf(QLatin1Char('/'));
+    return slash < 0 ? QString() : path.left(slash);
+}
+
+// True if path is one of roots or lies below one of them
+bool isUnder(QString path, const QSet<QString>& roots)
+{
+    for (;;) {
+        if (roots.contains(path))
+            return true;
+        if (path.isEmpty())
+            return false;
+        path = parentPath(path);
+    }
+}
+
+#if defined(Q_OS_LINUX)
+
+// Fixed part of a getdents64 record; the name follows at kDirentNameOffset
+struct LinuxDirent64
+{
+    quint64 d_ino;
+    qint64 d_off;
+    quint16 d_reclen;
+    quint8 d_type;
+};
+constexpr size_t kDirentNameOffset = 19;
+
+// 32 KB per call: a few hundred entries per system call instead of one
+constexpr size_t kDirentBufferWords = 4096;
+
+Listing listDirectory(const QString& path)
+{
+    Listing listing;
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return listing;
+    struct stat dirStat;
+    if (::fstat(fd, &dirStat) == 0)
+        listing.device = quint64(dirStat.st_dev);
+
+    std::unique_ptr<quint64[]> buffer(new quint64[kDirentBufferWords]);
+    char* bytes = reinterpret_cast<char*>(buffer.get());
+    for (;;) {
+        const long n = ::syscall(SYS_getdents64, fd, bytes, kDirentBufferWords * sizeof(quint64));
+        if (n <= 0) {
+            listing.ok = n == 0;
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            const auto* record = reinterpret_cast<const LinuxDirent64*>(bytes + offset);
+            const char* name = bytes + offset + kDirentNameOffset;
+            offset += record->d_reclen;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+
+            FileSystemEntry entry;
+            entry.name = QFile::decodeName(name);
+            entry.isDir = record->d_type == DT_DIR;
+            entry.isSymLink = record->d_type == DT_LNK;
+            // Some file systems leave the type out, and links show their target's
+            struct stat st;
+            if (record->d_type == DT_UNKNOWN && ::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                entry.isDir = S_ISDIR(st.st_mode);
+                entry.isSymLink = S_ISLNK(st.st_mode);
+            }
+            if (entry.isSymLink && ::fstatat(fd, name, &st, 0) == 0)
+                entry.isDir = S_ISDIR(st.st_mode);
+            listing.entries.append(entry);
+        }
+    }
+    ::close(fd);
+
+    std::sort(listing.entries.begin(), listing.entries.end(), entryLess);
+    return listing;
+}
+
+#else
+
+Listing listDirectory(const QString& path)
+{
+    Listing listing;
+    QDir dir(path);
+    if (!dir.exists())
+        return listing;
+    listing.ok = true;
+    const QFileInfoList infos = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+                                                  QDir::NoSort);
+    listing.entries.reserve(infos.size());
+    for (const QFileInfo& info : infos)
+        listing.entries.append(FileSystemEntry{info.fileName(), info.isDir(), info.isSymLink()});
+    std::sort(listing.entries.begin(), listing.entries.end(), entryLess);
+    return listing;
+}
+
+#endif
+
+} // namespace
+
+struct FileSystemIndex::Private
+{
+    QString rootPath;
+    QPointer<FileSystemIndex> owner;
+
+    // Shared with worker threads; everything below lock is guarded by it
+    mutable QReadWriteLock lock;
+    QHash<QString, QVector<FileSystemEntry>> directories;  // relative path -> sorted entries
+#if defined(Q_OS_LINUX)
+    int inotifyFd = -1;
+    QHash<int, QString> watchDirs;  // watch descriptor -> relative path
+    QHash<QString, int> dirWatches;
+#endif
+
+    std::atomic_bool crawlStarted{false};
+    std::atomic_bool crawling{false};
+    std::atomic_bool shuttingDown{false};
+    std::atomic_bool watchLimitReached{false};
+    std::atomic_bool crawlBudgetReached{false};
+
+    // GUI thread only
+    QSet<QString> dirty;
+    QSet<QString> modifiedFiles;
+    bool relisting = false;
+    QTimer* flushTimer = nullptr;
+#if defined(Q_OS_LINUX)
+    QSocketNotifier* notifier = nullptr;
+#else
+    QFileSystemWatcher* watcher = nullptr;
+#endif
+
+    ~Private()
+    {
+#if defined(Q_OS_LINUX)
+        if (inotifyFd >= 0)
+            ::close(inotifyFd);
+#endif
+    }
+
+    QString absolutePath(const QString& relativePath) const
+    {
+        if (relativePath.isEmpty())
+            return rootPath;
+        return rootPath.endsWith(QLatin1Char('/')) ? rootPath + relativePath
+                                                   : rootPath + QLatin1Char('/') + relativePath;
+    }
+
+    QString relativePath(const QString& absolutePath) const
+    {
+        if (absolutePath.size() <= rootPath.size())
+            return QString();
+        return absolutePath.mid(rootPath.endsWith(QLatin1Char('/')) ? rootPath.size() : rootPath.size() + 1);
+    }
+
+    void markDirty(const QString& path)
+    {
+        dirty.insert(path);
+        if (!relisting && !flushTimer->isActive())
+            flushTimer->start();
+    }
+
+    void markModified(const QString& path)
+    {
+        modifiedFiles.insert(path);
+        if (!flushTimer->isActive())
+            flushTimer->start();
+    }
+
+    void watch(const QString& path, bool crawling);
+    void forget(const QSet<QString>& roots);
+    QVector<FileSystemEntry> load(const QString& path, quint64* device, bool crawling);
+    void crawl();
+    QStringList relist(const QStringList& paths);
+};
+
+void FileSystemIndex::Private::watch(const QString& path, bool crawling)
+{
+    if (watchLimitReached.load(std::memory_order_relaxed))
+        return;
+#if defined(Q_OS_LINUX)
+    if (inotifyFd < 0)
+        return;
+    if (crawling) {
+        QReadLocker locker(&lock);
+        if (watchDirs.size() >= crawlWatchBudget()) {
+            if (!crawlBudgetReached.exchange(true)) {
+                qWarning() << "FileSystemIndex: the crawl below" << rootPath << "watches the first"
+                           << crawlWatchBudget() << "directories only; others are watched once listed";
+            }
+            return;
+        }
+    }
+    // Added before the directory is listed, so nothing changes unseen
+    const int wd = ::inotify_add_watch(inotifyFd, QFile::encodeName(absolutePath(path)).constData(),
+                                       IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF
+                                           | IN_MOVE_SELF | IN_CLOSE_WRITE | IN_ONLYDIR);
+    if (wd < 0) {
+        if (errno == ENOSPC && !watchLimitReached.exchange(true)) {
+            qWarning() << "FileSystemIndex: inotify watch limit reached below" << rootPath
+                       << "- raise fs.inotify.max_user_watches for live updates everywhere";
+        }
+        return;
+    }
+    QWriteLocker locker(&lock);
+    watchDirs.insert(wd, path);
+    dirWatches.insert(path, wd);
+#else
+    Q_UNUSED(crawling);
+    // QFileSystemWatcher belongs to the GUI thread
+    QPointer<FileSystemIndex> guard = owner;
+    const QString absolute = absolutePath(path);
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, absolute]() {
+        if (!guard)
+            return;
+        Private* d = guard->d.get();
+        if (d->watcher->directories().size() >= kMaxFallbackWatches) {
+            if (!d->watchLimitReached.exchange(true))
+                qWarning() << "FileSystemIndex: watching the first" << kMaxFallbackWatches << "directories only";
+            return;
+        }
+        d->watcher->addPath(absolute);
+    }, Qt::QueuedConnection);
+#endif
+}
+
+void FileSystemIndex::Private::forget(const QSet<QString>& roots)
+{
+    if (roots.isEmpty())
+        return;
+    QWriteLocker locker(&lock);
+    for (auto it = directories.begin(); it != directories.end();) {
+        if (isUnder(it.key(), roots))
+            it = directories.erase(it);
+        else
+            ++it;
+    }
+#if defined(Q_OS_LINUX)
+    for (auto it = dirWatches.begin(); it != dirWatches.end();) {
+        if (!isUnder(it.key(), roots)) {
+            ++it;
+            continue;
+        }
+        // A renamed directory keeps its descriptor; only drop the path it is known by now
+        if (watchDirs.value(it.value()) == it.key()) {
+            ::inotify_rm_watch(inotifyFd, it.value());
+            watchDirs.remove(it.value());
+        }
+        it = dirWatches.erase(it);
+    }
+#endif
+}
+
+QVector<FileSystemEntry> FileSystemIndex::Private::load(const QString& path, quint64* device, bool crawling)
+{
+    {
+        QReadLocker locker(&lock);
+        const auto it = directories.constFind(path);
+        if (it != directories.constEnd())
+            return *it;
+    }
+
+    watch(path, crawling);
+    const Listing listing = listDirectory(absolutePath(path));
+    if (device)
+        *device = listing.device;
+
+    QWriteLocker locker(&lock);
+    // Another thread may have listed it meanwhile; the first one wins
+    const auto it = directories.constFind(path);
+    if (it != directories.constEnd())
+        return *it;
+    directories.insert(path, listing.entries);
+    return listing.entries;
+}
+
+void FileSystemIndex::Private::crawl()
+{
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<QString> queue{QString()};
+    int busy = 0;
+    qint64 listed = 0;
+    quint64 rootDevice = 0;
+
+    auto work = [&]() {
+        for (;;) {
+            QString path;
+            {
+                std::unique_lock<std::mutex> guard(mutex);
+                wake.wait(guard, [&]() { return !queue.empty() || busy == 0 || shuttingDown.load(); });
+                if (queue.empty() || shuttingDown.load()) {
+                    wake.notify_all();
+                    return;
+                }
+                path = std::move(queue.front());
+                queue.pop_front();
+                ++busy;
+            }
+
+            quint64 device = 0;
+            const QVector<FileSystemEntry> entries = load(path, &device, true);
+
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (path.isEmpty())
+                    rootDevice = device;
+                listed += entries.size();
+                // Stay on the root's file system (no /proc below /) and within budget;
+                // already known directories report no device and count as same
+                if ((device == 0 || device == rootDevice) && listed < kCrawlBudget) {
+                    for (const FileSystemEntry& entry : entries) {
+                        if (entry.isDir && !entry.isSymLink)
+                            queue.push_back(childPath(path, entry.name));
+                    }
+                }
+                --busy;
+            }
+            wake.notify_all();
+        }
+    };
+
+    const int threadCount = qBound(2, QThread::idealThreadCount(), kMaxCrawlThreads);
+    std::vector<std::thread> helpers;
+    helpers.reserve(size_t(threadCount) - 1);
+    for (int i = 1; i < threadCount; ++i)
+        helpers.emplace_back(work);
+    work();
+    for (auto& helper : helpers)
+        helper.join();
+}
+
+QStringList FileSystemIndex::Private::relist(const QStringList& paths)
+{
+    QStringList changed;
+    QSet<QString> removed;
+    for (const QString& path : paths) {
+        {
+            QReadLocker locker(&lock);
+            // Never listed: it is listed fresh when someone asks
+            if (!directories.contains(path))
+                continue;
+        }
+
+        // Re-arms the watch of a directory that was deleted and created again
+        watch(path, false);
+        const Listing listing = listDirectory(absolutePath(path));
+        if (!listing.ok) {
+            removed.insert(path);
+            changed.append(path);
+            continue;
+        }
+
+        QWriteLocker locker(&lock);
+        const auto it = directories.constFind(path);
+        if (it == directories.constEnd() || sameEntries(*it, listing.entries))
+            continue;
+
+        // Subdirectories that went away take their listings and watches along
+        QSet<QString> keptDirs;
+        for (const FileSystemEntry& entry : listing.entries) {
+            if (entry.isDir)
+                keptDirs.insert(entry.name);
+        }
+        for (const FileSystemEntry& entry : *it) {
+            if (entry.isDir && !keptDirs.contains(entry.name))
+                removed.insert(childPath(path, entry.name));
+        }
+        directories.insert(path, listing.entries);
+        changed.append(path);
+    }
+    forget(removed);
+    return changed;
+}
+
+std::shared_ptr<FileSystemIndex> FileSystemIndex::shared(const QString& rootPath)
+{
+    static QHash<QString, std::weak_ptr<FileSystemIndex>> instances;
+
+    const QString key = QDir::cleanPath(QFileInfo(rootPath).absoluteFilePath());
+    std::shared_ptr<FileSystemIndex> index = instances.value(key).lock();
+    if (index)
+        return index;
+
+    for (auto it = instances.begin(); it != instances.end();) {
+        if (it->expired())
+            it = instances.erase(it);
+        else
+            ++it;
+    }
+    // The last holder may be a worker job, so delete on the index's own thread
+    index = std::shared_ptr<FileSystemIndex>(new FileSystemIndex(key),
+                                             [](FileSystemIndex* p) { p->deleteLater(); });
+    instances.insert(key, index);
+    return index;
+}
+
+FileSystemIndex::FileSystemIndex(const QString& rootPath)
+    : d(std::make_shared<Private>())
+{
+    d->rootPath = rootPath;
+    d->owner = this;
+
+    d->flushTimer = new QTimer(this);
+    d->flushTimer->setSingleShot(true);
+    d->flushTimer->setInterval(kCoalesceMs);
+    connect(d->flushTimer, &QTimer::timeout, this, &FileSystemIndex::flushChanges);
+
+#if defined(Q_OS_LINUX)
+    d->inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (d->inotifyFd < 0) {
+        qWarning() << "FileSystemIndex: inotify unavailable:" << std::strerror(errno);
+    } else {
+        d->notifier = new QSocketNotifier(d->inotifyFd, QSocketNotifier::Read, this);
+        connect(d->notifier, &QSocketNotifier::activated, this, &FileSystemIndex::onEvents);
+    }
+#else
+    d->watcher = new QFileSystemWatcher(this);
+    connect(d->watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString& path) {
+        d->markDirty(d->relativePath(QDir::cleanPath(path)));
+    });
+#endif
+}
+
+FileSystemIndex::~FileSystemIndex()
+{
+    d->shuttingDown = true;
+#if defined(Q_OS_LINUX)
+    // The descriptor closes with Private, possibly after a running job ends
+    delete d->notifier;
+    d->notifier = nullptr;
+#endif
+}
+
+QString FileSystemIndex::rootPath() const
+{
+    return d->rootPath;
+}
+
+QVector<FileSystemEntry> FileSystemIndex::entries(const QString& relativePath)
+{
+    return d->load(relativePath, nullptr, false);
+}
+
+void FileSystemIndex::ensureCrawled()
+{
+    if (d->crawlStarted.exchange(true))
+        return;
+    if (QThread::currentThread() == thread()) {
+        startCrawl();
+        return;
+    }
+    QPointer<FileSystemIndex> guard = d->owner;
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [guard]() {
+        if (guard)
+            guard->startCrawl();
+    }, Qt::QueuedConnection);
+}
+
+bool FileSystemIndex::isCrawling() const
+{
+    return d->crawling.load();
+}
+
+int FileSystemIndex::directoryCount() const
+{
+    QReadLocker locker(&d->lock);
+    return d->directories.size();
+}
+
+void FileSystemIndex::startCrawl()
+{
+    d->crawling = true;
+    std::shared_ptr<Private> state = d;
+    QPointer<FileSystemIndex> guard(this);
+    QThreadPool::globalInstance()->start([state, guard]() {
+        state->crawl();
+        state->crawling = false;
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard]() {
+            if (guard)
+                emit guard->crawlFinished();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileSystemIndex::onEvents()
+{
+#if defined(Q_OS_LINUX)
+    alignas(struct inotify_event) char buffer[16384];
+    for (;;) {
+        const ssize_t n = ::read(d->inotifyFd, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;  // EAGAIN: drained
+        for (ssize_t offset = 0; offset < n;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += ssize_t(sizeof(struct inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; check every listed directory
+                QReadLocker locker(&d->lock);
+                for (auto it = d->directories.constBegin(); it != d->directories.constEnd(); ++it)
+                    d->markDirty(it.key());
+                continue;
+            }
+
+            QString path;
+            {
+                QReadLocker locker(&d->lock);
+                const auto it = d->watchDirs.constFind(event->wd);
+                if (it == d->watchDirs.constEnd())
+                    continue;
+                path = *it;
+            }
+            if (event->mask & IN_IGNORED) {
+                QWriteLocker locker(&d->lock);
+                d->watchDirs.remove(event->wd);
+                if (d->dirWatches.value(path, -1) == event->wd)
+                    d->dirWatches.remove(path);
+                continue;
+            }
+            if (event->mask & IN_CLOSE_WRITE) {
+                // Contents only; the listing stays the same
+                if (event->len > 0)
+                    d->markModified(childPath(path, QFile::decodeName(event->name)));
+                continue;
+            }
+            d->markDirty(path);
+            if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) && !path.isEmpty())
+                d->markDirty(parentPath(path));
+        }
+    }
+#endif
+}
+
+void FileSystemIndex::flushChanges()
+{
+    if (!d->modifiedFiles.isEmpty()) {
+        const QStringList files = d->modifiedFiles.values();
+        d->modifiedFiles.clear();
+        emit filesModified(files);
+    }
+    if (d->relisting || d->dirty.isEmpty())
+        return;
+    d->relisting = true;
+    const QStringList paths = d->dirty.values();
+    d->dirty.clear();
+
+    std::shared_ptr<Private> state = d;
+    QPointer<FileSystemIndex> guard(this);
+    QThreadPool::globalInstance()->start([state, guard, paths]() {
+        const QStringList changed = state->relist(paths);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, changed]() {
+            if (guard)
+                guard->onRelisted(changed);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileSystemIndex::onRelisted(const QStringList& changed)
+{
+    d->relisting = false;
+    if (!changed.isEmpty())
+        emit directoriesChanged(changed);
+    // Events that arrived while listing
+    if (!d->dirty.isEmpty() && !d->flushTimer->isActive())
+        d->flushTimer->start();
+}
+
+FileSystemTreeProvider::FileSystemTreeProvider(const QString& rootPath)
+    : m_listDrives(rootPath.isEmpty())
+{
+    if (!m_listDrives) {
+        m_indexes.append(FileSystemIndex::shared(rootPath));
+        return;
+    }
+    // Drives are never crawled, only the directories expanded below them are
+    // listed and watched
+    for (const QFileInfo& drive : QDir::drives()) {
+        m_driveKeys.append(drive.absoluteFilePath());
+        m_indexes.append(FileSystemIndex::shared(drive.absoluteFilePath()));
+    }
+}
+
+QVector<LazyTreeItem> FileSystemTreeProvider::fetchChildren(const QStringList& path, const std::atomic_bool& cancelled)
+{
+    QVector<LazyTreeItem> items;
+    if (m_listDrives && path.isEmpty()) {
+        for (const QString& key : m_driveKeys)
+            items.append(LazyTreeItem{key, {key}, true});
+        return items;
+    }
+
+    int indexNo = 0;
+    QStringList keys = path;
+    if (m_listDrives) {
+        indexNo = m_driveKeys.indexOf(keys.takeFirst());
+        if (indexNo < 0)
+            return items;
+    }
+
+    const std::shared_ptr<FileSystemIndex>& index = m_indexes.at(indexNo);
+    // A workspace root is small enough to crawl ahead of the user
+    if (!m_listDrives)
+        index->ensureCrawled();
+    const QVector<FileSystemEntry> entries = index->entries(keys.join(QLatin1Char('/')));
+    items.reserve(entries.size());
+    for (const FileSystemEntry& entry : entries) {
+        if (cancelled.load(std::memory_order_relaxed))
+            return {};
+        items.append(LazyTreeItem{entry.name, {entry.name}, entry.isDir});
+    }
+    return items;
+}
+
+void FileSystemTreeProvider::bindModel(LazyTreeModel* model) const
+{
+    for (int i = 0; i < m_indexes.size(); ++i) {
+        const QString driveKey = m_listDrives ? m_driveKeys.at(i) : QString();
+        QObject::connect(m_indexes.at(i).get(), &FileSystemIndex::directoriesChanged, model,
+                         [model, driveKey](const QStringList& relativePaths) {
+                             for (const QString& relativePath : relativePaths) {
+                                 QStringList keys = relativePath.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+                                 if (!driveKey.isEmpty())
+                                     keys.prepend(driveKey);
+                                 model->reloadChildren(keys);
+                             }
+                         });
+    }
+}
+
+} // namespace DockManager
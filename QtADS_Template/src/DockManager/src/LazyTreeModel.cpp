@@ -0,0 +1,641 @@
+#include "LazyTreeModel.h"
+#include "ColumnarTable.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QThreadPool>
+#include <QTreeView>
+
+#include <vector>
+
+namespace DockManager {
+
+namespace {
+
+enum class LoadState : quint8
+{
+    NotLoaded,
+    Loading,
+    Loaded
+};
+
+// Node 0 is the invisible root; its children are the top-level items
+constexpr quint32 kRoot = 0;
+
+// Joins keys into one expansion-state key; unlikely to appear in names
+constexpr QChar kPathSeparator(0x1F);
+
+// Removed nodes are freed once there are this many and they make up more
+// than half of the arena
+constexpr size_t kCompactThreshold = 4096;
+
+struct Node
+{
+    quint32 parent = kRoot;
+    quint32 row = 0;
+    quint32 firstChild = 0;   // children are adjacent in the arena, see childLists
+    quint32 childCount = 0;
+    LoadState state = LoadState::NotLoaded;
+    bool hasChildren = false;
+    bool removed = false;     // dropped by reloadChildren(); freed by the next compactArena()
+};
+
+QString itemKey(const LazyTreeItem& item)
+{
+    return item.key.isEmpty() ? item.columns.value(0) : item.key;
+}
+
+} // namespace
+
+FunctionTreeProvider::FunctionTreeProvider(Function function)
+    : m_function(std::move(function))
+{
+}
+
+QVector<LazyTreeItem> FunctionTreeProvider::fetchChildren(const QStringList& path, const std::atomic_bool& cancelled)
+{
+    Q_UNUSED(cancelled);
+    return m_function(path);
+}
+
+struct LazyTreeModel::Private
+{
+    std::shared_ptr<LazyTreeProvider> provider;
+    QStringList headers;
+
+    std::vector<Node> nodes;
+    ColumnarTable text;  // one row per node: a column per header, then the key
+    int keyColumn = 0;
+
+    // Children of nodes that grew through appendChildren() in blocks that
+    // are not adjacent in the arena; everyone else uses firstChild + row
+    QHash<quint32, std::vector<quint32>> childLists;
+
+    QSet<QString> expandedPaths;
+    quint64 generation = 0;
+    std::shared_ptr<std::atomic_bool> cancelled;
+
+    // Latest reloadChildren() request per node; older replies are dropped
+    QHash<quint32, quint64> reloadTickets;
+    quint64 lastTicket = 0;
+    // Nodes asked to reload while their first fetch was still running
+    QSet<quint32> staleFetches;
+
+    // Fetches of this generation that have not reported back; replies carry
+    // node ids, so the arena is only compacted when there are none
+    int pendingFetches = 0;
+    // Nodes removed by reloadChildren(), subtrees included
+    size_t garbage = 0;
+
+    QStringList path(quint32 node) const
+    {
+        QStringList keys;
+        for (; node != kRoot; node = nodes[node].parent)
+            keys.prepend(text.stringAt(int(node), keyColumn));
+        return keys;
+    }
+
+    QString pathKey(quint32 node) const
+    {
+        return path(node).join(kPathSeparator);
+    }
+
+    quint32 childAt(quint32 node, quint32 row) const
+    {
+        const auto it = childLists.constFind(node);
+        return it != childLists.constEnd() ? it->at(row) : nodes[node].firstChild + row;
+    }
+
+    std::vector<quint32> children(quint32 node) const
+    {
+        std::vector<quint32> ids(nodes[node].childCount);
+        for (quint32 r = 0; r < nodes[node].childCount; ++r)
+            ids[r] = childAt(node, r);
+        return ids;
+    }
+
+    // Store a changed child list, renumbering rows from firstRow on
+    void setChildren(quint32 node, const std::vector<quint32>& ids, size_t firstRow)
+    {
+        for (size_t r = firstRow; r < ids.size(); ++r)
+            nodes[ids[r]].row = quint32(r);
+        nodes[node].childCount = quint32(ids.size());
+        nodes[node].firstChild = ids.empty() ? 0 : ids.front();
+        childLists.insert(node, ids);
+    }
+
+    // node and all its loaded descendants
+    size_t subtreeSize(quint32 node) const
+    {
+        size_t size = 0;
+        std::vector<quint32> stack{node};
+        while (!stack.empty()) {
+            const quint32 next = stack.back();
+            stack.pop_back();
+            ++size;
+            for (quint32 r = 0; r < nodes[next].childCount; ++r)
+                stack.push_back(childAt(next, r));
+        }
+        return size;
+    }
+
+    bool isAttached(quint32 node) const
+    {
+        for (; node != kRoot; node = nodes[node].parent) {
+            if (nodes[node].removed)
+                return false;
+        }
+        return true;
+    }
+
+    // Node at a key path, or -1 when it is not loaded
+    qint64 findNode(const QStringList& keys) const
+    {
+        quint32 node = kRoot;
+        for (const QString& key : keys) {
+            if (nodes[node].state != LoadState::Loaded)
+                return -1;
+            const quint32 parent = node;
+            for (quint32 r = 0; r < nodes[parent].childCount && node == parent; ++r) {
+                const quint32 child = childAt(parent, r);
+                if (text.stringViewAt(int(child), keyColumn) == key)
+                    node = child;
+            }
+            if (node == parent)
+                return -1;
+        }
+        return node;
+    }
+};
+
+LazyTreeModel::LazyTreeModel(std::shared_ptr<LazyTreeProvider> provider, const QStringList& headers,
+                             QObject* parent)
+    : QAbstractItemModel(parent)
+    , d(new Private)
+{
+    d->provider = std::move(provider);
+    d->headers = headers;
+    d->keyColumn = headers.size();
+    d->text = ColumnarTable(QVector<ColumnType>(headers.size() + 1, ColumnType::String));
+    refresh();
+}
+
+LazyTreeModel::~LazyTreeModel()
+{
+    if (d->cancelled)
+        d->cancelled->store(true);
+}
+
+void LazyTreeModel::refresh()
+{
+    // Jobs of the previous generation are dropped when they report back
+    if (d->cancelled)
+        d->cancelled->store(true);
+    d->cancelled = std::make_shared<std::atomic_bool>(false);
+    ++d->generation;
+
+    beginResetModel();
+    d->nodes.clear();
+    d->childLists.clear();
+    d->reloadTickets.clear();
+    d->staleFetches.clear();
+    d->pendingFetches = 0;
+    d->garbage = 0;
+    Node root;
+    root.hasChildren = true;
+    if (!d->provider)
+        root.state = LoadState::Loaded;
+    d->nodes.push_back(root);
+    d->text.clearRows();
+    d->text.resize(1);
+    endResetModel();
+
+    if (d->provider)
+        startFetch(kRoot);
+}
+
+void LazyTreeModel::appendChildren(const QModelIndex& parent, const QVector<LazyTreeItem>& items)
+{
+    const quint32 node = parent.isValid() ? quint32(parent.internalId()) : kRoot;
+    if (items.isEmpty() || d->nodes[node].state != LoadState::Loaded)
+        return;
+
+    const quint32 oldCount = d->nodes[node].childCount;
+    const QModelIndex parentIndex = node == kRoot ? QModelIndex() : createIndex(int(d->nodes[node].row), 0, node);
+    beginInsertRows(parentIndex, int(oldCount), int(oldCount) + int(items.size()) - 1);
+    const quint32 first = storeItems(node, oldCount, items);
+
+    auto list = d->childLists.find(node);
+    if (list == d->childLists.end() && oldCount > 0 && d->nodes[node].firstChild + oldCount != first) {
+        // The existing block is followed by other nodes; switch to a list
+        std::vector<quint32> ids(oldCount);
+        for (quint32 r = 0; r < oldCount; ++r)
+            ids[r] = d->nodes[node].firstChild + r;
+        list = d->childLists.insert(node, std::move(ids));
+    }
+    if (list != d->childLists.end()) {
+        for (int r = 0; r < items.size(); ++r)
+            list->push_back(first + quint32(r));
+    } else if (oldCount == 0) {
+        d->nodes[node].firstChild = first;
+    }
+    d->nodes[node].childCount = oldCount + quint32(items.size());
+    d->nodes[node].hasChildren = true;
+    endInsertRows();
+    emit childrenLoaded(parentIndex);
+}
+
+void LazyTreeModel::reloadChildren(const QStringList& path)
+{
+    const qint64 found = d->findNode(path);
+    if (!d->provider || found < 0)
+        return;
+    const quint32 node = quint32(found);
+    switch (d->nodes[node].state) {
+    case LoadState::NotLoaded:
+        break;
+    case LoadState::Loading:
+        d->staleFetches.insert(node);
+        break;
+    case LoadState::Loaded:
+        d->reloadTickets.insert(node, ++d->lastTicket);
+        startFetch(node, d->lastTicket);
+        break;
+    }
+}
+
+void LazyTreeModel::bindView(QTreeView* view)
+{
+    connect(view, &QTreeView::expanded, this, [this](const QModelIndex& index) {
+        setExpanded(index, true);
+    });
+    connect(view, &QTreeView::collapsed, this, [this](const QModelIndex& index) {
+        setExpanded(index, false);
+    });
+    connect(this, &LazyTreeModel::expandRequested, view, &QTreeView::expand);
+}
+
+void LazyTreeModel::setExpanded(const QModelIndex& index, bool expanded)
+{
+    if (!index.isValid())
+        return;
+    const QString key = d->pathKey(quint32(index.internalId()));
+    if (expanded)
+        d->expandedPaths.insert(key);
+    else
+        d->expandedPaths.remove(key);
+}
+
+QStringList LazyTreeModel::pathForIndex(const QModelIndex& index) const
+{
+    return index.isValid() ? d->path(quint32(index.internalId())) : QStringList();
+}
+
+bool LazyTreeModel::isLoading(const QModelIndex& index) const
+{
+    const quint32 node = index.isValid() ? quint32(index.internalId()) : kRoot;
+    return d->nodes[node].state == LoadState::Loading;
+}
+
+void LazyTreeModel::startFetch(quint32 node, quint64 reloadTicket)
+{
+    if (reloadTicket == 0)
+        d->nodes[node].state = LoadState::Loading;
+    ++d->pendingFetches;
+
+    const quint64 generation = d->generation;
+    const QStringList path = d->path(node);
+    std::shared_ptr<LazyTreeProvider> provider = d->provider;
+    std::shared_ptr<std::atomic_bool> cancelled = d->cancelled;
+
+    QPointer<LazyTreeModel> guard(this);
+    QThreadPool::globalInstance()->start([guard, generation, node, reloadTicket, path, provider, cancelled]() {
+        const QVector<LazyTreeItem> items = provider->fetchChildren(path, *cancelled);
+        if (cancelled->load())
+            return;
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, generation, node, reloadTicket, items]() {
+            if (!guard)
+                return;
+            if (reloadTicket == 0)
+                guard->onChildrenFetched(generation, node, items);
+            else
+                guard->onChildrenReloaded(generation, node, reloadTicket, items);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LazyTreeModel::onChildrenFetched(quint64 generation, quint32 node, const QVector<LazyTreeItem>& items)
+{
+    if (generation != d->generation)
+        return;
+    --d->pendingFetches;
+    if (d->nodes[node].state != LoadState::Loading) {
+        compactArena();
+        return;
+    }
+
+    d->nodes[node].state = LoadState::Loaded;
+    if (!d->isAttached(node)) {
+        compactArena();
+        return;
+    }
+    const QModelIndex parentIndex = node == kRoot ? QModelIndex() : createIndex(int(d->nodes[node].row), 0, node);
+
+    if (items.isEmpty()) {
+        // Drop the expander of a node that turned out to be empty
+        d->nodes[node].hasChildren = false;
+        if (parentIndex.isValid())
+            emit dataChanged(parentIndex, parentIndex);
+    } else {
+        beginInsertRows(parentIndex, 0, int(items.size()) - 1);
+        const quint32 first = storeItems(node, 0, items);
+        d->nodes[node].firstChild = first;
+        d->nodes[node].childCount = quint32(items.size());
+        endInsertRows();
+    }
+    emit childrenLoaded(parentIndex);
+
+    // Re-open nodes that were expanded before the last refresh
+    for (quint32 r = 0; r < d->nodes[node].childCount; ++r)
+        requestExpansion(d->childAt(node, r));
+
+    if (d->staleFetches.remove(node))
+        reloadChildren(d->path(node));
+    compactArena();
+}
+
+void LazyTreeModel::onChildrenReloaded(quint64 generation, quint32 node, quint64 ticket,
+                                       const QVector<LazyTreeItem>& items)
+{
+    if (generation != d->generation)
+        return;
+    --d->pendingFetches;
+    const bool latest = d->reloadTickets.value(node) == ticket;
+    if (latest)
+        d->reloadTickets.remove(node);
+    if (!latest || !d->isAttached(node)) {
+        compactArena();
+        return;
+    }
+
+    QHash<QString, int> newRows;
+    newRows.reserve(items.size());
+    for (int i = 0; i < items.size(); ++i)
+        newRows.insert(itemKey(items.at(i)), i);
+
+    std::vector<quint32> ids = d->children(node);
+    std::vector<QString> keys(ids.size());
+    int lastRow = -1;
+    for (size_t r = 0; r < ids.size(); ++r) {
+        keys[r] = d->text.stringAt(int(ids[r]), d->keyColumn);
+        const int newRow = newRows.value(keys[r], -1);
+        if (newRow >= 0 && newRow < lastRow) {
+            // Kept rows moved relative to each other; not worth a move diff
+            refresh();
+            return;
+        }
+        lastRow = qMax(lastRow, newRow);
+    }
+
+    const QModelIndex parentIndex = node == kRoot ? QModelIndex() : createIndex(int(d->nodes[node].row), 0, node);
+
+    // Remove vanished rows, one contiguous run at a time from the end
+    for (int last = int(ids.size()) - 1; last >= 0; --last) {
+        if (newRows.contains(keys[size_t(last)]))
+            continue;
+        int first = last;
+        while (first > 0 && !newRows.contains(keys[size_t(first) - 1]))
+            --first;
+        beginRemoveRows(parentIndex, first, last);
+        for (int r = first; r <= last; ++r) {
+            d->nodes[ids[size_t(r)]].removed = true;
+            d->garbage += d->subtreeSize(ids[size_t(r)]);
+        }
+        ids.erase(ids.begin() + first, ids.begin() + last + 1);
+        keys.erase(keys.begin() + first, keys.begin() + last + 1);
+        d->setChildren(node, ids, size_t(first));
+        endRemoveRows();
+        last = first;
+    }
+
+    // Every remaining row is in items, in order; insert the new ones between them
+    size_t kept = 0;
+    for (int i = 0; i < items.size();) {
+        if (kept < keys.size() && keys[kept] == itemKey(items.at(i))) {
+            const quint32 child = ids[kept];
+            const LazyTreeItem& item = items.at(i);
+            bool changed = false;
+            for (int c = 0; c < d->keyColumn && c < item.columns.size(); ++c) {
+                if (d->text.stringViewAt(int(child), c) != item.columns.at(c)) {
+                    d->text.setString(int(child), c, item.columns.at(c));
+                    changed = true;
+                }
+            }
+            if (changed)
+                emit dataChanged(createIndex(int(kept), 0, child), createIndex(int(kept), d->keyColumn - 1, child));
+            ++kept;
+            ++i;
+            continue;
+        }
+
+        int end = i + 1;
+        while (end < items.size() && (kept >= keys.size() || keys[kept] != itemKey(items.at(end))))
+            ++end;
+        const QVector<LazyTreeItem> added = items.mid(i, end - i);
+        beginInsertRows(parentIndex, int(kept), int(kept) + int(added.size()) - 1);
+        const quint32 first = storeItems(node, quint32(kept), added);
+        for (int r = 0; r < added.size(); ++r) {
+            ids.insert(ids.begin() + qptrdiff(kept) + r, first + quint32(r));
+            keys.insert(keys.begin() + qptrdiff(kept) + r, itemKey(added.at(r)));
+        }
+        d->setChildren(node, ids, kept);
+        endInsertRows();
+        for (int r = 0; r < added.size(); ++r)
+            requestExpansion(first + quint32(r));
+        kept += size_t(added.size());
+        i = end;
+    }
+
+    const bool hasChildren = !ids.empty();
+    if (d->nodes[node].hasChildren != hasChildren) {
+        d->nodes[node].hasChildren = hasChildren;
+        if (parentIndex.isValid())
+            emit dataChanged(parentIndex, parentIndex);
+    }
+    emit childrenLoaded(parentIndex);
+    compactArena();
+}
+
+void LazyTreeModel::compactArena()
+{
+    if (d->pendingFetches > 0 || d->garbage < kCompactThreshold || d->garbage * 2 < d->nodes.size())
+        return;
+
+    // Copy the attached nodes breadth first, so every sibling list becomes
+    // one adjacent block again and childLists is no longer needed
+    constexpr quint32 kFreed = ~quint32(0);
+    std::vector<quint32> newIds(d->nodes.size(), kFreed);
+    std::vector<quint32> order{kRoot};
+    std::vector<Node> nodes;
+    nodes.reserve(d->nodes.size() - d->garbage);
+    newIds[kRoot] = kRoot;
+    nodes.push_back(d->nodes[kRoot]);
+    for (size_t i = 0; i < order.size(); ++i) {
+        const quint32 oldId = order[i];
+        const quint32 newId = newIds[oldId];
+        const quint32 count = d->nodes[oldId].childCount;
+        nodes[newId].firstChild = count ? quint32(nodes.size()) : 0;
+        for (quint32 r = 0; r < count; ++r) {
+            const quint32 child = d->childAt(oldId, r);
+            newIds[child] = quint32(nodes.size());
+            Node node = d->nodes[child];
+            node.parent = newId;
+            nodes.push_back(node);
+            order.push_back(child);
+        }
+    }
+
+    ColumnarTable text(QVector<ColumnType>(d->keyColumn + 1, ColumnType::String));
+    text.resize(int(nodes.size()));
+    for (size_t i = 1; i < order.size(); ++i) {
+        for (int c = 0; c <= d->keyColumn; ++c)
+            text.setString(int(newIds[order[i]]), c, d->text.stringViewAt(int(order[i]), c));
+    }
+
+    // Views hold internal ids in persistent indexes (expanded and selected
+    // rows); rows and parents stay the same, only the ids change
+    emit layoutAboutToBeChanged();
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (const QModelIndex& index : oldIndexes) {
+        const quint32 newId = newIds[quint32(index.internalId())];
+        newIndexes.append(newId == kFreed ? QModelIndex() : createIndex(index.row(), index.column(), quintptr(newId)));
+    }
+    d->nodes = std::move(nodes);
+    d->text = std::move(text);
+    d->childLists.clear();
+    d->garbage = 0;
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged();
+}
+
+void LazyTreeModel::requestExpansion(quint32 node)
+{
+    if (!d->expandedPaths.isEmpty() && d->nodes[node].hasChildren && d->expandedPaths.contains(d->pathKey(node)))
+        emit expandRequested(createIndex(int(d->nodes[node].row), 0, node));
+}
+
+quint32 LazyTreeModel::storeItems(quint32 parent, quint32 firstRow, const QVector<LazyTreeItem>& items)
+{
+    // Siblings first so they stay adjacent, then each preloaded subtree
+    const quint32 first = quint32(d->nodes.size());
+    d->nodes.reserve(d->nodes.size() + size_t(items.size()));
+    d->text.resize(int(first) + int(items.size()));
+    for (int r = 0; r < items.size(); ++r) {
+        const LazyTreeItem& item = items.at(r);
+        Node child;
+        child.parent = parent;
+        child.row = firstRow + quint32(r);
+        child.hasChildren = item.hasChildren || !item.children.isEmpty();
+        // Nothing to ask the provider for: preloaded, or a leaf
+        if (!child.hasChildren || !item.children.isEmpty())
+            child.state = LoadState::Loaded;
+        d->nodes.push_back(child);
+
+        const int textRow = int(first) + r;
+        for (int c = 0; c < d->keyColumn && c < item.columns.size(); ++c)
+            d->text.setString(textRow, c, item.columns.at(c));
+        d->text.setString(textRow, d->keyColumn, item.key.isEmpty() ? item.columns.value(0) : item.key);
+    }
+
+    for (int r = 0; r < items.size(); ++r) {
+        const QVector<LazyTreeItem>& children = items.at(r).children;
+        if (children.isEmpty())
+            continue;
+        const quint32 node = first + quint32(r);
+        const quint32 firstChild = storeItems(node, 0, children);
+        d->nodes[node].firstChild = firstChild;
+        d->nodes[node].childCount = quint32(children.size());
+    }
+    return first;
+}
+
+QModelIndex LazyTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+    const quint32 node = parent.isValid() ? quint32(parent.internalId()) : kRoot;
+    const Node& p = d->nodes[node];
+    if (p.state != LoadState::Loaded || row < 0 || quint32(row) >= p.childCount || column < 0
+        || column >= columnCount()) {
+        return {};
+    }
+    return createIndex(row, column, quintptr(d->childAt(node, quint32(row))));
+}
+
+QModelIndex LazyTreeModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid())
+        return {};
+    const quint32 parentNode = d->nodes[quint32(child.internalId())].parent;
+    if (parentNode == kRoot)
+        return {};
+    return createIndex(int(d->nodes[parentNode].row), 0, quintptr(parentNode));
+}
+
+int LazyTreeModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.column() > 0)
+        return 0;
+    const Node& node = d->nodes[parent.isValid() ? quint32(parent.internalId()) : kRoot];
+    return node.state == LoadState::Loaded ? int(node.childCount) : 0;
+}
+
+int LazyTreeModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return qMax(1, d->headers.size());
+}
+
+bool LazyTreeModel::hasChildren(const QModelIndex& parent) const
+{
+    if (parent.column() > 0)
+        return false;
+    const Node& node = d->nodes[parent.isValid() ? quint32(parent.internalId()) : kRoot];
+    if (node.state == LoadState::Loaded)
+        return node.childCount > 0;
+    return node.hasChildren;
+}
+
+bool LazyTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (parent.column() > 0)
+        return false;
+    const Node& node = d->nodes[parent.isValid() ? quint32(parent.internalId()) : kRoot];
+    return d->provider && node.hasChildren && node.state == LoadState::NotLoaded;
+}
+
+void LazyTreeModel::fetchMore(const QModelIndex& parent)
+{
+    if (canFetchMore(parent))
+        startFetch(parent.isValid() ? quint32(parent.internalId()) : kRoot);
+}
+
+QVariant LazyTreeModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.column() >= d->keyColumn)
+        return {};
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole)
+        return {};
+    return d->text.stringAt(int(index.internalId()), index.column());
+}
+
+QVariant LazyTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < d->headers.size())
+        return d->headers.at(section);
+    return QAbstractItemModel::headerData(section, orientation, role);
+}
+
+} // namespace DockManager
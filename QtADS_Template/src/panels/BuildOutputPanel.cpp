@@ -0,0 +1,625 @@
+#include "BuildOutputPanel.h"
+
+#include <ColumnarItemDelegate.h>
+#include <ColumnarTableModel.h>
+
+#include <QApplication>
+#include <QClipboard>
+#include <QDebug>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QProcess>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSignalBlocker>
+#include <QSplitter>
+#include <QTableView>
+#include <QThread>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <atomic>
+#include <climits>
+#include <mutex>
+
+#if !defined(Q_OS_WIN)
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr int TextMargin = 4;
+
+// How often the runner looks at the stop flag while the build is quiet
+constexpr int PollIntervalMs = 50;
+
+enum Column
+{
+    SeverityColumn,
+    FileColumn,
+    LineColumn,
+    CharacterColumn,
+    MessageColumn
+};
+
+QString severityText(BuildDiagnostic::Severity severity)
+{
+    switch (severity)
+    {
+    case BuildDiagnostic::Error:
+        return QObject::tr("Error");
+    case BuildDiagnostic::Warning:
+        return QObject::tr("Warning");
+    case BuildDiagnostic::Note:
+        return QObject::tr("Note");
+    }
+    return QString();
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// BuildLogView
+// ---------------------------------------------------------------------------
+BuildLogView::BuildLogView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , m_log(MaxLines, MaxBytes)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+}
+
+void BuildLogView::appendLines(QVector<BuildOutputLine> &&lines, qint64 skipped)
+{
+    m_log.skip(skipped);
+    for (BuildOutputLine &line : lines)
+        m_log.append(std::move(line));
+    updateScrollBars();
+    viewport()->update();
+}
+
+void BuildLogView::clear()
+{
+    m_log.clear();
+    m_topLine = 0;
+    m_following = true;
+    m_selectionAnchor = -1;
+    m_selectionEnd = -1;
+    updateScrollBars();
+    viewport()->update();
+}
+
+bool BuildLogView::showLine(qint64 outputLine)
+{
+    const qint64 first = qint64(m_log.droppedLines());
+    if (outputLine < first || outputLine >= first + m_log.lineCount())
+        return false;
+    m_following = false;
+    m_topLine = qMax(first, outputLine - visibleRows() / 2);
+    m_selectionAnchor = outputLine;
+    m_selectionEnd = outputLine;
+    updateScrollBars();
+    viewport()->update();
+    return true;
+}
+
+void BuildLogView::copy()
+{
+    const qint64 first = qint64(m_log.droppedLines());
+    const qint64 from = qMax(qMin(m_selectionAnchor, m_selectionEnd), first);
+    const qint64 to = qMin(qMax(m_selectionAnchor, m_selectionEnd), first + m_log.lineCount() - 1);
+    if (m_selectionAnchor < 0 || from > to)
+        return;
+    QString text;
+    for (qint64 line = from; line <= to; ++line)
+    {
+        text += m_log.line(line - first).text;
+        text += QLatin1Char('\n');
+    }
+    QApplication::clipboard()->setText(text);
+}
+
+int BuildLogView::lineHeight() const
+{
+    return fontMetrics().height();
+}
+
+int BuildLogView::charWidth() const
+{
+    return qMax(1, fontMetrics().horizontalAdvance(QLatin1Char('M')));
+}
+
+int BuildLogView::visibleRows() const
+{
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+void BuildLogView::updateScrollBars()
+{
+    const qint64 first = qint64(m_log.droppedLines());
+    const qint64 lastTop = first + qMax<qint64>(0, m_log.lineCount() - visibleRows());
+    m_topLine = m_following ? lastTop : qBound(first, m_topLine, lastTop);
+
+    // Without the blockers this would come back through scrollContentsBy()
+    {
+        QSignalBlocker blocker(verticalScrollBar());
+        verticalScrollBar()->setPageStep(visibleRows());
+        verticalScrollBar()->setRange(0, int(qMin<qint64>(lastTop - first, INT_MAX)));
+        verticalScrollBar()->setValue(int(qMin<qint64>(m_topLine - first, INT_MAX)));
+    }
+    const int columns = qMax(1, (viewport()->width() - TextMargin) / charWidth());
+    QSignalBlocker blocker(horizontalScrollBar());
+    horizontalScrollBar()->setPageStep(columns);
+    horizontalScrollBar()->setRange(0, qMax(0, m_log.longestLine() + 1 - columns));
+}
+
+qint64 BuildLogView::outputLineAt(const QPoint &pos) const
+{
+    if (m_log.lineCount() == 0)
+        return -1;
+    const qint64 first = qint64(m_log.droppedLines());
+    return qBound(first, m_topLine + qMax(0, pos.y()) / lineHeight(), first + m_log.lineCount() - 1);
+}
+
+void BuildLogView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void BuildLogView::scrollContentsBy(int, int)
+{
+    const QScrollBar *bar = verticalScrollBar();
+    m_topLine = qint64(m_log.droppedLines()) + bar->value();
+    m_following = bar->value() == bar->maximum();
+    viewport()->update();
+}
+
+void BuildLogView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    const QRect area = event->rect();
+    painter.fillRect(area, palette().base());
+
+    const int height = lineHeight();
+    const int width = charWidth();
+    const int ascent = fontMetrics().ascent();
+    const int firstColumn = horizontalScrollBar()->value();
+    const int columns = viewport()->width() / width + 2;
+    const qint64 first = qint64(m_log.droppedLines());
+    const qint64 selectionFrom = qMin(m_selectionAnchor, m_selectionEnd);
+    const qint64 selectionTo = qMax(m_selectionAnchor, m_selectionEnd);
+    const QFont baseFont = font();
+    QFont boldFont = baseFont;
+    boldFont.setBold(true);
+
+    const int firstRow = qMax(0, area.top() / height);
+    const int lastRow = area.bottom() / height;
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        const qint64 outputLine = m_topLine + row;
+        if (outputLine - first >= m_log.lineCount())
+            break;
+        const BuildOutputLine &line = m_log.line(outputLine - first);
+        const int y = row * height;
+        const bool selected = m_selectionAnchor >= 0 && outputLine >= selectionFrom && outputLine <= selectionTo;
+        if (selected)
+            painter.fillRect(QRect(0, y, viewport()->width(), height), palette().highlight());
+        const QColor defaultColor = palette().color(selected ? QPalette::HighlightedText : QPalette::Text);
+
+        // Default text between the spans, each span in its own colours
+        const int end = qMin(int(line.text.size()), firstColumn + columns);
+        const auto drawRun = [&](int from, int to, const TerminalCell *style)
+        {
+            from = qMax(from, firstColumn);
+            to = qMin(to, end);
+            if (from >= to)
+                return;
+            const int x = TextMargin + (from - firstColumn) * width;
+            QColor color = defaultColor;
+            if (style)
+            {
+                if (!(style->flags & TerminalCell::DefaultBackground) && !selected)
+                    painter.fillRect(QRect(x, y, (to - from) * width, height),
+                                     QColor::fromRgb(terminalPaletteColor(style->background)));
+                if (!(style->flags & TerminalCell::DefaultForeground))
+                    color = QColor::fromRgb(terminalPaletteColor(
+                        (style->flags & TerminalCell::Bold) && style->foreground < 8 ? style->foreground + 8
+                                                                                     : style->foreground));
+            }
+            painter.setFont(style && (style->flags & TerminalCell::Bold) ? boldFont : baseFont);
+            painter.setPen(color);
+            painter.drawText(x, y + ascent, line.text.mid(from, to - from));
+        };
+        int position = 0;
+        for (const BuildOutputSpan &span : line.spans)
+        {
+            if (span.start >= end)
+                break;
+            drawRun(position, span.start, nullptr);
+            drawRun(span.start, span.start + span.length, &span.style);
+            position = span.start + span.length;
+        }
+        drawRun(position, end, nullptr);
+    }
+}
+
+void BuildLogView::keyPressEvent(QKeyEvent *event)
+{
+    if (event == QKeySequence::Copy)
+        return copy();
+    if (event == QKeySequence::SelectAll)
+    {
+        if (m_log.lineCount() == 0)
+            return;
+        m_selectionAnchor = qint64(m_log.droppedLines());
+        m_selectionEnd = m_selectionAnchor + m_log.lineCount() - 1;
+        viewport()->update();
+        return;
+    }
+    switch (event->key())
+    {
+    case Qt::Key_Home:
+        verticalScrollBar()->setValue(0);
+        return;
+    case Qt::Key_End:
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        return;
+    default:
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void BuildLogView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    const qint64 line = outputLineAt(event->pos());
+    if (!(event->modifiers() & Qt::ShiftModifier) || m_selectionAnchor < 0)
+        m_selectionAnchor = line;
+    m_selectionEnd = line;
+    viewport()->update();
+}
+
+void BuildLogView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || m_selectionAnchor < 0)
+        return;
+    m_selectionEnd = outputLineAt(event->pos());
+    viewport()->update();
+}
+
+// ---------------------------------------------------------------------------
+// Session: what the runner thread shares with the panel. The runner keeps
+// it alive, so a stopped build winds down without the panel waiting.
+// ---------------------------------------------------------------------------
+struct BuildOutputPanel::Session
+{
+    std::mutex mutex;
+    QVector<BuildOutputLine> lines;       // guarded by mutex
+    QVector<BuildDiagnostic> diagnostics; // guarded by mutex
+    qint64 skippedLines = 0;              // guarded by mutex
+    // Diagnostics past MaxProblems in the whole build are only counted
+    int listedProblems = 0;               // guarded by mutex
+    int droppedProblems = 0;              // guarded by mutex, not yet taken
+    int droppedErrors = 0;                // guarded by mutex, not yet taken
+    int droppedWarnings = 0;              // guarded by mutex, not yet taken
+    std::atomic_bool frameRequested{false};
+    std::atomic_bool stopping{false};
+};
+
+BuildOutputPanel::BuildOutputPanel(const QString &workingDirectory, QWidget *parent)
+    : QWidget(parent)
+    , m_workingDirectory(workingDirectory)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+
+    auto *controls = new QHBoxLayout;
+    controls->setContentsMargins(0, 0, 0, 0);
+    m_commandEdit = new QLineEdit(QStringLiteral("cmake --build build"), this);
+    m_commandEdit->setPlaceholderText(tr("Build command"));
+    controls->addWidget(m_commandEdit, 1);
+    m_runButton = new QPushButton(tr("Build"), this);
+    controls->addWidget(m_runButton);
+    layout->addLayout(controls);
+
+    auto *splitter = new QSplitter(Qt::Vertical, this);
+    m_logView = new BuildLogView(splitter);
+    m_problemsView = new QTableView(splitter);
+    m_problemsModel = new DockManager::ColumnarTableModel(
+        {tr("Severity"), tr("File"), tr("Line"), tr("Column"), tr("Message")},
+        {DockManager::ColumnType::String, DockManager::ColumnType::String, DockManager::ColumnType::Int64,
+         DockManager::ColumnType::Int64, DockManager::ColumnType::String},
+        m_problemsView);
+    m_problemsView->setModel(m_problemsModel);
+    m_problemsView->setItemDelegate(new DockManager::ColumnarItemDelegate(m_problemsView));
+    m_problemsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_problemsView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_problemsView->verticalHeader()->setDefaultSectionSize(m_problemsView->fontMetrics().height() + 4);
+    m_problemsView->horizontalHeader()->setStretchLastSection(true);
+    m_problemsView->horizontalHeader()->resizeSection(FileColumn, 260);
+    m_problemsView->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    m_problemsView->setSortingEnabled(true);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 1);
+    layout->addWidget(splitter, 1);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setContentsMargins(4, 0, 4, 4);
+    layout->addWidget(m_statusLabel);
+
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setSingleShot(true);
+    connect(m_frameTimer, &QTimer::timeout, this, &BuildOutputPanel::updateFrame);
+    m_lastFrame.start();
+
+    connect(m_runButton, &QPushButton::clicked, this, [this]()
+    {
+        if (isRunning())
+            stopBuild();
+        else
+            startBuild();
+    });
+    connect(m_commandEdit, &QLineEdit::returnPressed, this, &BuildOutputPanel::startBuild);
+    connect(m_problemsView, &QTableView::activated, this, &BuildOutputPanel::showProblem);
+
+    updateStatus(tr("Ready;"));
+}
+
+BuildOutputPanel::~BuildOutputPanel()
+{
+    if (m_session)
+        m_session->stopping = true;
+}
+
+// ---------------------------------------------------------------------------
+// Build lifecycle
+// ---------------------------------------------------------------------------
+void BuildOutputPanel::startBuild()
+{
+    stopBuild();
+    const QString command = m_commandEdit->text().trimmed();
+    if (command.isEmpty())
+        return;
+
+    m_logView->clear();
+    m_problemsModel->clear();
+    m_problemLines.clear();
+    m_errorCount = 0;
+    m_warningCount = 0;
+    m_droppedProblems = 0;
+
+    auto shared = std::make_shared<Session>();
+    const quint64 generation = ++m_generation;
+    const QString directory = m_workingDirectory;
+    QPointer<BuildOutputPanel> guard(this);
+    // A QThread: QProcess needs its event dispatcher. It deletes itself
+    // when done, so stopping never waits for the build to end.
+    QThread *runner = QThread::create([guard, shared, generation, command, directory]()
+    {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::MergedChannels);
+        process.setWorkingDirectory(directory);
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        // Ninja and CMake keep their colours on a pipe
+        environment.insert(QStringLiteral("CLICOLOR_FORCE"), QStringLiteral("1"));
+        process.setProcessEnvironment(environment);
+#if defined(Q_OS_WIN)
+        process.start(QStringLiteral("cmd.exe"), {QStringLiteral("/c"), command});
+#else
+        // Its own process group, so stopping also ends the compilers it started
+        process.setChildProcessModifier([]() { ::setpgid(0, 0); });
+        process.start(QStringLiteral("/bin/sh"), {QStringLiteral("-c"), command});
+#endif
+        if (!process.waitForStarted())
+        {
+            const QString errorString = process.errorString();
+            QMetaObject::invokeMethod(qApp, [guard, generation, errorString]()
+            {
+                if (guard)
+                    guard->onBuildFinished(generation, -1, false, errorString);
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        BuildOutputParser parser;
+        const auto publish = [guard, shared, &parser]()
+        {
+            QVector<BuildOutputLine> lines = parser.takeLines();
+            QVector<BuildDiagnostic> diagnostics = parser.takeDiagnostics();
+            if (lines.isEmpty() && diagnostics.isEmpty())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                for (BuildOutputLine &line : lines)
+                    shared->lines.append(std::move(line));
+                for (BuildDiagnostic &diagnostic : diagnostics)
+                {
+                    if (shared->listedProblems < MaxProblems)
+                    {
+                        ++shared->listedProblems;
+                        shared->diagnostics.append(std::move(diagnostic));
+                        continue;
+                    }
+                    ++shared->droppedProblems;
+                    if (diagnostic.severity == BuildDiagnostic::Error)
+                        ++shared->droppedErrors;
+                    else if (diagnostic.severity == BuildDiagnostic::Warning)
+                        ++shared->droppedWarnings;
+                }
+                // While the GUI thread is busy, drop what the log could not
+                // keep anyway, a quarter of its size at a time
+                const qsizetype surplus = shared->lines.size() - BuildLogView::MaxLines;
+                if (surplus > BuildLogView::MaxLines / 4)
+                {
+                    shared->lines.erase(shared->lines.begin(), shared->lines.begin() + surplus);
+                    shared->skippedLines += surplus;
+                }
+            }
+            // One pending frame request at a time, however fast output comes
+            if (!shared->frameRequested.exchange(true))
+            {
+                QMetaObject::invokeMethod(qApp, [guard]()
+                {
+                    if (guard)
+                        guard->scheduleFrame();
+                }, Qt::QueuedConnection);
+            }
+        };
+
+        while (process.state() != QProcess::NotRunning || process.bytesAvailable() > 0)
+        {
+            if (shared->stopping)
+            {
+#if !defined(Q_OS_WIN)
+                if (process.processId() > 0)
+                    ::kill(-pid_t(process.processId()), SIGTERM);
+#endif
+                process.kill();
+                process.waitForFinished();
+                return;
+            }
+            if (process.bytesAvailable() == 0 && !process.waitForReadyRead(PollIntervalMs))
+                continue;
+            const QByteArray chunk = process.readAll();
+            parser.feed(chunk.constData(), chunk.size());
+            publish();
+        }
+        parser.finish();
+        publish();
+
+        const int exitCode = process.exitCode();
+        const bool crashed = process.exitStatus() == QProcess::CrashExit;
+        QMetaObject::invokeMethod(qApp, [guard, generation, exitCode, crashed]()
+        {
+            if (guard)
+                guard->onBuildFinished(generation, exitCode, crashed, QString());
+        }, Qt::QueuedConnection);
+    });
+    connect(runner, &QThread::finished, runner, &QObject::deleteLater);
+    runner->start();
+
+    m_session = std::move(shared);
+    m_runButton->setText(tr("Stop"));
+    m_elapsed.start();
+    updateStatus(tr("Building..."));
+}
+
+void BuildOutputPanel::stopBuild()
+{
+    if (!m_session)
+        return;
+    m_session->stopping = true;
+    updateFrame();
+    m_session.reset();
+    m_runButton->setText(tr("Build"));
+    updateStatus(tr("Build stopped;"));
+}
+
+void BuildOutputPanel::onBuildFinished(quint64 generation, int exitCode, bool crashed, const QString &errorString)
+{
+    if (generation != m_generation || !m_session)
+        return;
+    // The runner queued its last lines before it reported
+    updateFrame();
+    m_session.reset();
+    m_runButton->setText(tr("Build"));
+
+    if (!errorString.isEmpty())
+    {
+        qWarning() << "BuildOutputPanel: cannot start the build:" << errorString;
+        updateStatus(tr("Cannot start the build: %1;").arg(errorString));
+        return;
+    }
+    const QString seconds = QString::number(m_elapsed.elapsed() / 1000.0, 'f', 1);
+    if (crashed)
+        updateStatus(tr("Build crashed after %1 s;").arg(seconds));
+    else if (exitCode != 0)
+        updateStatus(tr("Build failed with exit code %1 in %2 s;").arg(exitCode).arg(seconds));
+    else
+        updateStatus(tr("Build succeeded in %1 s;").arg(seconds));
+}
+
+// ---------------------------------------------------------------------------
+// Frames
+// ---------------------------------------------------------------------------
+void BuildOutputPanel::scheduleFrame()
+{
+    if (m_frameTimer->isActive())
+        return;
+    m_frameTimer->start(int(qMax<qint64>(0, FrameIntervalMs - m_lastFrame.elapsed())));
+}
+
+void BuildOutputPanel::updateFrame()
+{
+    if (!m_session)
+        return;
+    m_session->frameRequested = false;
+    m_lastFrame.restart();
+
+    QVector<BuildOutputLine> lines;
+    QVector<BuildDiagnostic> diagnostics;
+    qint64 skipped = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_session->mutex);
+        lines.swap(m_session->lines);
+        diagnostics.swap(m_session->diagnostics);
+        skipped = m_session->skippedLines;
+        m_session->skippedLines = 0;
+        m_droppedProblems += m_session->droppedProblems;
+        m_errorCount += m_session->droppedErrors;
+        m_warningCount += m_session->droppedWarnings;
+        m_session->droppedProblems = 0;
+        m_session->droppedErrors = 0;
+        m_session->droppedWarnings = 0;
+    }
+    if (!lines.isEmpty() || skipped > 0)
+        m_logView->appendLines(std::move(lines), skipped);
+
+    if (!diagnostics.isEmpty())
+    {
+        // One rowsInserted for the whole batch
+        DockManager::ColumnarTable rows = m_problemsModel->createTable();
+        for (const BuildDiagnostic &diagnostic : std::as_const(diagnostics))
+        {
+            const int r = rows.appendRow();
+            rows.setString(r, SeverityColumn, severityText(diagnostic.severity));
+            rows.setString(r, FileColumn, diagnostic.file);
+            rows.setInt64(r, LineColumn, diagnostic.line);
+            rows.setInt64(r, CharacterColumn, diagnostic.column);
+            rows.setString(r, MessageColumn, diagnostic.message);
+            m_problemLines.append(diagnostic.outputLine);
+            if (diagnostic.severity == BuildDiagnostic::Error)
+                ++m_errorCount;
+            else if (diagnostic.severity == BuildDiagnostic::Warning)
+                ++m_warningCount;
+        }
+        m_problemsModel->appendRows(rows);
+    }
+    updateStatus(tr("Building..."));
+}
+
+void BuildOutputPanel::showProblem(const QModelIndex &index)
+{
+    const int row = m_problemsModel->sourceRow(index.row());
+    if (row >= 0 && row < m_problemLines.size() && m_logView->showLine(m_problemLines.at(row)))
+        m_logView->setFocus();
+}
+
+void BuildOutputPanel::updateStatus(const QString &prefix)
+{
+    QString text = tr("%1 %2 errors, %3 warnings").arg(prefix).arg(m_errorCount).arg(m_warningCount);
+    if (m_droppedProblems > 0)
+        text += tr(" (%1 not listed)").arg(m_droppedProblems);
+    m_statusLabel->setText(text);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "BuildOutputParser.h"
+
+#include <QAbstractScrollArea>
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <memory>
+
+namespace DockManager
+{
+class ColumnarTableModel;
+}
+
+class QLabel;
+class QLineEdit;
+class QModelIndex;
+class QPushButton;
+class QTableView;
+class QTimer;
+
+// ---------------------------------------------------------------------------
+// Read-only log over a BuildLog that paints only the lines in the viewport,
+// in the colours of their spans. New lines keep the view at the bottom
+// unless it was scrolled up. Whole lines can be selected with the mouse and
+// copied.
+// ---------------------------------------------------------------------------
+class BuildLogView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 MaxLines = 500000;
+    static constexpr qint64 MaxBytes = 64 * 1024 * 1024;
+
+    explicit BuildLogView(QWidget *parent = nullptr);
+
+    void appendLines(QVector<BuildOutputLine> &&lines, qint64 skipped);
+    void clear();
+    // Scrolls to and selects a line counted from the start of the build;
+    // false if it was dropped
+    bool showLine(qint64 outputLine);
+    void copy();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    int lineHeight() const;
+    int charWidth() const;
+    int visibleRows() const;
+    void updateScrollBars();
+    qint64 outputLineAt(const QPoint &pos) const;
+
+    BuildLog m_log;
+    qint64 m_topLine = 0; // first visible line, counted from the start of the build
+    bool m_following = true;
+    qint64 m_selectionAnchor = -1; // output lines, -1 without selection
+    qint64 m_selectionEnd = -1;
+};
+
+// ---------------------------------------------------------------------------
+// Runs a build command and shows its output and diagnostics.
+//
+// The command runs through the shell in the working directory with stdout
+// and stderr merged. A runner thread reads the output, parses it with a
+// BuildOutputParser and queues the lines and diagnostics under a mutex; the
+// GUI thread takes them at most once per FrameIntervalMs, so a parallel
+// build writing megabytes per second costs it one append per frame. Output
+// the log would drop anyway is dropped before it reaches the GUI thread;
+// problems past MaxProblems are counted but not listed. Stopping leaves the
+// runner to kill the build and end on its own. Double-clicking a problem
+// shows the output line that reported it.
+// ---------------------------------------------------------------------------
+class BuildOutputPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FrameIntervalMs = 16;
+    static constexpr int MaxProblems = 100000;
+
+    explicit BuildOutputPanel(const QString &workingDirectory, QWidget *parent = nullptr);
+    ~BuildOutputPanel() override;
+
+    void startBuild();
+    void stopBuild();
+    bool isRunning() const { return m_session != nullptr; }
+
+private:
+    struct Session;
+
+    void scheduleFrame();
+    void updateFrame();
+    void onBuildFinished(quint64 generation, int exitCode, bool crashed, const QString &errorString);
+    void showProblem(const QModelIndex &index);
+    void updateStatus(const QString &prefix);
+
+    QString m_workingDirectory;
+    QLineEdit *m_commandEdit = nullptr;
+    QPushButton *m_runButton = nullptr;
+    BuildLogView *m_logView = nullptr;
+    QTableView *m_problemsView = nullptr;
+    DockManager::ColumnarTableModel *m_problemsModel = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    QTimer *m_frameTimer = nullptr;
+    QElapsedTimer m_lastFrame;
+    QElapsedTimer m_elapsed;
+
+    std::shared_ptr<Session> m_session;
+    quint64 m_generation = 0;
+    QVector<qint64> m_problemLines; // output line of each problem row in the table
+    int m_errorCount = 0;
+    int m_warningCount = 0;
+    int m_droppedProblems = 0; // diagnostics past MaxProblems
+};
@@ -0,0 +1,409 @@
+#include "BuildOutputParser.h"
+
+#include <algorithm>
+
+namespace
+{
+bool isDefaultStyle(const TerminalCell &pen)
+{
+    return pen.sameStyle(TerminalCell());
+}
+
+bool isDigit(QChar ch)
+{
+    return ch >= QLatin1Char('0') && ch <= QLatin1Char('9');
+}
+
+// Removes ":<number>" from the end of text
+bool takeTrailingNumber(QStringView *text, int *value)
+{
+    qsizetype begin = text->size();
+    while (begin > 0 && isDigit(text->at(begin - 1)))
+        --begin;
+    const qsizetype digits = text->size() - begin;
+    if (digits == 0 || digits > 9 || begin < 2 || text->at(begin - 1) != QLatin1Char(':'))
+        return false;
+    *value = text->mid(begin).toInt();
+    *text = text->left(begin - 1);
+    return true;
+}
+
+QString limitedMessage(QStringView text)
+{
+    return text.trimmed().left(BuildOutputParser::MaxMessageLength).toString();
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// BuildOutputParser
+// ---------------------------------------------------------------------------
+void BuildOutputParser::feed(const char *data, qint64 size)
+{
+    m_parser.feed(data, size, *this);
+}
+
+void BuildOutputParser::finish()
+{
+    if (!m_line.text.isEmpty())
+        endLine();
+    flushCMakeDiagnostic();
+}
+
+QVector<BuildOutputLine> BuildOutputParser::takeLines()
+{
+    QVector<BuildOutputLine> lines;
+    lines.swap(m_lines);
+    return lines;
+}
+
+QVector<BuildDiagnostic> BuildOutputParser::takeDiagnostics()
+{
+    QVector<BuildDiagnostic> diagnostics;
+    diagnostics.swap(m_diagnostics);
+    return diagnostics;
+}
+
+void BuildOutputParser::print(const char *text, qint64 size)
+{
+    beginText();
+    const qint64 room = MaxLineLength - m_line.text.size();
+    if (room <= 0)
+        return;
+    const int start = int(m_line.text.size());
+    m_line.text.append(QLatin1String(text, int(qMin(size, room))));
+    appendStyled(start);
+}
+
+void BuildOutputParser::printCodePoint(char32_t codePoint)
+{
+    beginText();
+    if (m_line.text.size() + 2 > MaxLineLength)
+        return;
+    const int start = int(m_line.text.size());
+    if (codePoint < 0x10000)
+        m_line.text.append(QChar(char16_t(codePoint)));
+    else
+        m_line.text.append(QString::fromUcs4(&codePoint, 1));
+    appendStyled(start);
+}
+
+void BuildOutputParser::execute(char control)
+{
+    switch (control)
+    {
+    case '\n':
+        endLine();
+        break;
+    case '\r':
+        m_carriageReturn = true;
+        break;
+    case '\t':
+    {
+        beginText();
+        const int start = int(m_line.text.size());
+        const int spaces = TabWidth - start % TabWidth;
+        if (start + spaces <= MaxLineLength)
+        {
+            m_line.text.append(QString(spaces, QLatin1Char(' ')));
+            appendStyled(start);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void BuildOutputParser::escDispatch(const VtParser &, char final)
+{
+    if (final == 'c')
+        m_pen = TerminalCell();
+}
+
+void BuildOutputParser::csiDispatch(const VtParser &parser, char final)
+{
+    // Only colours matter; cursor movement and erasing have no meaning in a log
+    if (final == 'm' && parser.privateMarker() == 0 && parser.intermediate() == 0)
+        applyGraphicsRendition(parser, &m_pen);
+}
+
+void BuildOutputParser::oscDispatch(const QByteArray &)
+{
+    // Titles and the hyperlinks GCC puts around option names are dropped
+}
+
+void BuildOutputParser::beginText()
+{
+    // Text after a lone carriage return redraws the line
+    if (!m_carriageReturn)
+        return;
+    m_carriageReturn = false;
+    m_line.text.clear();
+    m_line.spans.clear();
+}
+
+void BuildOutputParser::appendStyled(int start)
+{
+    const int length = int(m_line.text.size()) - start;
+    if (length <= 0 || isDefaultStyle(m_pen))
+        return;
+    if (!m_line.spans.isEmpty())
+    {
+        BuildOutputSpan &last = m_line.spans.last();
+        if (last.start + last.length == start && last.style.sameStyle(m_pen))
+        {
+            last.length += length;
+            return;
+        }
+    }
+    BuildOutputSpan span;
+    span.start = start;
+    span.length = length;
+    span.style = m_pen;
+    m_line.spans.append(span);
+}
+
+void BuildOutputParser::endLine()
+{
+    m_carriageReturn = false;
+    matchLine(m_line.text);
+    m_lines.append(std::move(m_line));
+    m_line = BuildOutputLine();
+    ++m_lineCount;
+}
+
+// ---------------------------------------------------------------------------
+// Diagnostics
+// ---------------------------------------------------------------------------
+void BuildOutputParser::matchLine(const QString &text)
+{
+    if (m_cmakePending)
+    {
+        // The message is indented and may contain blank lines
+        const QStringView trimmed = QStringView(text).trimmed();
+        if (trimmed.isEmpty())
+            return;
+        if (text.startsWith(QLatin1Char(' ')))
+        {
+            QString &message = m_cmakeDiagnostic.message;
+            if (message.size() < MaxMessageLength)
+            {
+                if (!message.isEmpty())
+                    message += QLatin1Char(' ');
+                message += trimmed.left(MaxMessageLength - message.size());
+            }
+            return;
+        }
+        flushCMakeDiagnostic();
+    }
+
+    if (matchCMakeHeader(text))
+        return;
+    BuildDiagnostic diagnostic;
+    if (matchCompilerDiagnostic(text, &diagnostic))
+    {
+        diagnostic.outputLine = m_lineCount;
+        m_diagnostics.append(diagnostic);
+    }
+}
+
+bool BuildOutputParser::matchCompilerDiagnostic(QStringView text, BuildDiagnostic *diagnostic)
+{
+    // "<location>: <severity>: <message>" where the location is
+    // "file:line:column", "file:line" or, for the driver and linker, a tool
+    // name; the severity must follow the first ": "
+    const qsizetype separator = text.indexOf(QLatin1String(": "));
+    if (separator <= 0)
+        return false;
+    static const struct
+    {
+        QLatin1String marker;
+        BuildDiagnostic::Severity severity;
+    } Severities[] = {
+        {QLatin1String("error: "), BuildDiagnostic::Error},
+        {QLatin1String("fatal error: "), BuildDiagnostic::Error},
+        {QLatin1String("warning: "), BuildDiagnostic::Warning},
+        {QLatin1String("note: "), BuildDiagnostic::Note},
+    };
+    const QStringView rest = text.mid(separator + 2);
+    qsizetype markerLength = 0;
+    for (const auto &entry : Severities)
+    {
+        if (rest.startsWith(entry.marker))
+        {
+            diagnostic->severity = entry.severity;
+            markerLength = entry.marker.size();
+            break;
+        }
+    }
+    if (markerLength == 0)
+        return false;
+
+    QStringView location = text.left(separator);
+    const QString message = limitedMessage(rest.mid(markerLength));
+    int last = 0;
+    int beforeLast = 0;
+    if (takeTrailingNumber(&location, &last))
+    {
+        if (takeTrailingNumber(&location, &beforeLast))
+        {
+            diagnostic->line = beforeLast;
+            diagnostic->column = last;
+        }
+        else
+        {
+            diagnostic->line = last;
+            diagnostic->column = 0;
+        }
+        diagnostic->file = location.toString();
+        diagnostic->message = message;
+        return true;
+    }
+
+    // "collect2: error: ld returned 1 exit status"
+    if (location.contains(QLatin1Char(' ')))
+        return false;
+    diagnostic->file.clear();
+    diagnostic->line = 0;
+    diagnostic->column = 0;
+    diagnostic->message = location.toString() + QLatin1String(": ") + message;
+    return true;
+}
+
+bool BuildOutputParser::matchCMakeHeader(QStringView text)
+{
+    BuildDiagnostic diagnostic;
+    qsizetype prefixLength = 0;
+    if (text.startsWith(QLatin1String("CMake Error")))
+    {
+        diagnostic.severity = BuildDiagnostic::Error;
+        prefixLength = 11;
+    }
+    else if (text.startsWith(QLatin1String("CMake Warning")))
+    {
+        diagnostic.severity = BuildDiagnostic::Warning;
+        prefixLength = 13;
+    }
+    else if (text.startsWith(QLatin1String("CMake Deprecation Warning")))
+    {
+        diagnostic.severity = BuildDiagnostic::Warning;
+        prefixLength = 25;
+    }
+    else
+    {
+        return false;
+    }
+    diagnostic.outputLine = m_lineCount;
+
+    const QStringView header = text.trimmed();
+    if (!header.endsWith(QLatin1Char(':')))
+    {
+        // "CMake Error: <message>" on one line
+        const qsizetype separator = header.indexOf(QLatin1String(": "), prefixLength);
+        if (separator < 0)
+            return false;
+        diagnostic.message = limitedMessage(header.mid(separator + 2));
+        m_diagnostics.append(diagnostic);
+        return true;
+    }
+
+    // "CMake Error at <file>:<line> (<command>):", "CMake Warning (dev) in
+    // <file>:" and the like; the message follows on indented lines
+    QStringView location = header.mid(prefixLength, header.size() - prefixLength - 1);
+    qsizetype at = location.indexOf(QLatin1String(" at "));
+    if (at < 0)
+        at = location.indexOf(QLatin1String(" in "));
+    if (at >= 0)
+    {
+        location = location.mid(at + 4);
+        const qsizetype command = location.lastIndexOf(QLatin1String(" ("));
+        if (command > 0)
+            location = location.left(command);
+        int line = 0;
+        if (takeTrailingNumber(&location, &line))
+            diagnostic.line = line;
+        diagnostic.file = location.toString();
+    }
+    m_cmakeDiagnostic = diagnostic;
+    m_cmakePending = true;
+    return true;
+}
+
+void BuildOutputParser::flushCMakeDiagnostic()
+{
+    if (!m_cmakePending)
+        return;
+    m_cmakePending = false;
+    m_diagnostics.append(m_cmakeDiagnostic);
+    m_cmakeDiagnostic = BuildDiagnostic();
+}
+
+// ---------------------------------------------------------------------------
+// BuildLog
+// ---------------------------------------------------------------------------
+BuildLog::BuildLog(qint64 maxLines, qint64 maxBytes)
+    : m_maxLines(qMax<qint64>(1, maxLines))
+    , m_maxBytes(maxBytes)
+{
+}
+
+void BuildLog::append(BuildOutputLine &&line)
+{
+    const qint64 bytes = lineBytes(line);
+    while (m_count > 0 && (m_count == m_maxLines || m_bytes + bytes > m_maxBytes))
+        dropOldest();
+    m_bytes += bytes;
+    m_longestLine = qMax(m_longestLine, int(line.text.size()));
+
+    if (m_count == qint64(m_lines.size()))
+    {
+        // Grow, with the ring unrolled so the new slot follows the last line
+        if (m_first != 0)
+        {
+            std::rotate(m_lines.begin(), m_lines.begin() + m_first, m_lines.end());
+            m_first = 0;
+        }
+        m_lines.push_back(std::move(line));
+    }
+    else
+    {
+        m_lines[size_t((m_first + m_count) % qint64(m_lines.size()))] = std::move(line);
+    }
+    ++m_count;
+}
+
+void BuildLog::skip(qint64 count)
+{
+    m_droppedLines += quint64(qMax<qint64>(0, count));
+}
+
+void BuildLog::clear()
+{
+    std::vector<BuildOutputLine>().swap(m_lines);
+    m_first = 0;
+    m_count = 0;
+    m_bytes = 0;
+    m_droppedLines = 0;
+    m_longestLine = 0;
+}
+
+const BuildOutputLine &BuildLog::line(qint64 index) const
+{
+    return m_lines[size_t((m_first + index) % qint64(m_lines.size()))];
+}
+
+qint64 BuildLog::lineBytes(const BuildOutputLine &line)
+{
+    return qint64(sizeof(BuildOutputLine)) + line.text.size() * qint64(sizeof(QChar))
+           + line.spans.size() * qint64(sizeof(BuildOutputSpan));
+}
+
+void BuildLog::dropOldest()
+{
+    BuildOutputLine &oldest = m_lines[size_t(m_first)];
+    m_bytes -= lineBytes(oldest);
+    oldest = BuildOutputLine();
+    m_first = (m_first + 1) % qint64(m_lines.size());
+    --m_count;
+    ++m_droppedLines;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "TerminalEmulator.h"
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+#include <vector>
+
+// A run of styled text in a BuildOutputLine. Only the colour and flag
+// fields of style are used.
+struct BuildOutputSpan
+{
+    int start = 0; // in QChars of the line
+    int length = 0;
+    TerminalCell style;
+};
+
+// One line of build output with escape sequences removed; text outside
+// the spans has the default style
+struct BuildOutputLine
+{
+    QString text;
+    QVector<BuildOutputSpan> spans;
+};
+
+// An error, warning or note found in build output
+struct BuildDiagnostic
+{
+    enum Severity
+    {
+        Error,
+        Warning,
+        Note
+    };
+
+    Severity severity = Error;
+    QString file; // as printed; empty for tool messages such as "collect2: error: ..."
+    int line = 0; // 1-based, 0 if unknown
+    int column = 0;
+    QString message;
+    qint64 outputLine = 0; // of the line that reported it, counted from the start of the build
+};
+
+// ---------------------------------------------------------------------------
+// Streaming parser for the merged stdout and stderr of a build. Splits the
+// bytes into lines, applies colour escapes through a VtParser and matches
+// each finished line against GCC/Clang ("file:line:column: error: ...") and
+// CMake ("CMake Error at file:line (command):" plus its indented message)
+// diagnostics. Input may be split anywhere across feed() calls.
+//
+// A carriage return not followed by a line feed starts the line over, so
+// progress lines redrawn in place end up as their last state. Tabs expand
+// to TabWidth; lines are cut at MaxLineLength characters.
+// ---------------------------------------------------------------------------
+class BuildOutputParser : private VtHandler
+{
+public:
+    static constexpr int TabWidth = 8;
+    static constexpr int MaxLineLength = 16 * 1024;
+    static constexpr int MaxMessageLength = 1024;
+
+    void feed(const char *data, qint64 size);
+    // Ends the last line even without a line feed
+    void finish();
+
+    // Finished lines and diagnostics since the last call; cleared by it
+    QVector<BuildOutputLine> takeLines();
+    QVector<BuildDiagnostic> takeDiagnostics();
+
+    qint64 lineCount() const { return m_lineCount; } // finished lines so far
+
+    // Diagnostic reported on one GCC or Clang output line, if any
+    static bool matchCompilerDiagnostic(QStringView text, BuildDiagnostic *diagnostic);
+
+private:
+    void print(const char *text, qint64 size) override;
+    void printCodePoint(char32_t codePoint) override;
+    void execute(char control) override;
+    void escDispatch(const VtParser &parser, char final) override;
+    void csiDispatch(const VtParser &parser, char final) override;
+    void oscDispatch(const QByteArray &data) override;
+
+    void beginText();
+    void appendStyled(int start);
+    void endLine();
+    void matchLine(const QString &text);
+    bool matchCMakeHeader(QStringView text);
+    void flushCMakeDiagnostic();
+
+    VtParser m_parser;
+    TerminalCell m_pen;
+    BuildOutputLine m_line;
+    bool m_carriageReturn = false;
+    qint64 m_lineCount = 0;
+    QVector<BuildOutputLine> m_lines;
+    QVector<BuildDiagnostic> m_diagnostics;
+
+    // A CMake diagnostic collects the indented lines that follow it
+    bool m_cmakePending = false;
+    BuildDiagnostic m_cmakeDiagnostic;
+};
+
+// ---------------------------------------------------------------------------
+// Build output lines in a ring of at most maxLines lines and about maxBytes
+// of text; appending past either limit drops the oldest lines. Storage
+// grows on demand up to the limits. Line indexes count from the oldest line
+// kept; droppedLines() converts them to and from build output line numbers.
+// ---------------------------------------------------------------------------
+class BuildLog
+{
+public:
+    BuildLog(qint64 maxLines, qint64 maxBytes);
+
+    void append(BuildOutputLine &&line);
+    // Counts lines that were never appended as dropped
+    void skip(qint64 count);
+    void clear();
+
+    qint64 lineCount() const { return m_count; }
+    quint64 droppedLines() const { return m_droppedLines; } // since the last clear()
+    const BuildOutputLine &line(qint64 index) const;
+    int longestLine() const { return m_longestLine; } // in QChars, since the last clear()
+
+private:
+    static qint64 lineBytes(const BuildOutputLine &line);
+    void dropOldest();
+
+    qint64 m_maxLines = 0;
+    qint64 m_maxBytes = 0;
+    std::vector<BuildOutputLine> m_lines; // ring from m_first
+    qint64 m_first = 0;
+    qint64 m_count = 0;
+    qint64 m_bytes = 0;
+    quint64 m_droppedLines = 0;
+    int m_longestLine = 0;
+};
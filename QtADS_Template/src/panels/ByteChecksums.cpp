@@ -0,0 +1,515 @@
+#include "ByteChecksums.h"
+
+#include <QCryptographicHash>
+#include <QStringList>
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CHECKSUMS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CHECKSUMS_ARM_CRC 1
+#include <arm_acle.h>
+#endif
+
+// GCC/Clang need per-function target attributes to emit SSE4.2/SHA code
+// without raising the baseline of the whole binary; MSVC always allows them.
+#if defined(CHECKSUMS_X86) && !defined(_MSC_VER)
+#define CHECKSUMS_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define CHECKSUMS_TARGET_SHA __attribute__((target("sha,sse4.1,ssse3")))
+#else
+#define CHECKSUMS_TARGET_SSE42
+#define CHECKSUMS_TARGET_SHA
+#endif
+
+namespace
+{
+// ---------------------------------------------------------------------------
+// Runtime CPU feature detection
+// ---------------------------------------------------------------------------
+struct CpuFeatures
+{
+    bool sse42 = false;
+    bool sha = false;
+};
+
+CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features;
+#if defined(CHECKSUMS_X86)
+    bool ssse3 = false;
+    bool sse41 = false;
+#if defined(_MSC_VER)
+    int regs[4] = {};
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    ssse3 = (regs[2] & (1 << 9)) != 0;
+    sse41 = (regs[2] & (1 << 19)) != 0;
+    features.sse42 = (regs[2] & (1 << 20)) != 0;
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(regs, 7, 0);
+        features.sha = (regs[1] & (1 << 29)) != 0;
+    }
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        ssse3 = (ecx & (1u << 9)) != 0;
+        sse41 = (ecx & (1u << 19)) != 0;
+        features.sse42 = (ecx & (1u << 20)) != 0;
+    }
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        features.sha = (ebx & (1u << 29)) != 0;
+#endif
+    features.sha = features.sha && ssse3 && sse41;
+#endif
+    return features;
+}
+
+const CpuFeatures &cpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+// ---------------------------------------------------------------------------
+// Table driven CRC (slicing-by-8), used for CRC32 and as CRC32C fallback
+// ---------------------------------------------------------------------------
+using CrcTables = std::array<std::array<quint32, 256>, 8>;
+
+constexpr CrcTables makeCrcTables(quint32 polynomial)
+{
+    CrcTables tables{};
+    for (quint32 i = 0; i < 256; ++i)
+    {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+        tables[0][i] = crc;
+    }
+    for (quint32 i = 0; i < 256; ++i)
+    {
+        for (std::size_t slice = 1; slice < 8; ++slice)
+        {
+            const quint32 previous = tables[slice - 1][i];
+            tables[slice][i] = (previous >> 8) ^ tables[0][previous & 0xff];
+        }
+    }
+    return tables;
+}
+
+constexpr CrcTables kCrc32Tables = makeCrcTables(0xEDB88320u);
+constexpr CrcTables kCrc32cTables = makeCrcTables(0x82F63B78u);
+
+quint32 crcSlicingBy8(const CrcTables &t, quint32 crc, const uchar *p, qsizetype n)
+{
+    while (n >= 8)
+    {
+        const quint32 lo = qFromLittleEndian<quint32>(p) ^ crc;
+        const quint32 hi = qFromLittleEndian<quint32>(p + 4);
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+              ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n-- > 0)
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(CHECKSUMS_X86)
+CHECKSUMS_TARGET_SSE42 quint32 crc32cSse42(quint32 crc, const uchar *p, qsizetype n)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    quint64 crc64 = crc;
+    while (n >= 8)
+    {
+        quint64 value;
+        std::memcpy(&value, p, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        p += 8;
+        n -= 8;
+    }
+    crc = static_cast<quint32>(crc64);
+#endif
+    while (n >= 4)
+    {
+        quint32 value;
+        std::memcpy(&value, p, sizeof(value));
+        crc = _mm_crc32_u32(crc, value);
+        p += 4;
+        n -= 4;
+    }
+    while (n-- > 0)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+#if defined(CHECKSUMS_ARM_CRC)
+quint32 crc32Armv8(quint32 crc, const uchar *p, qsizetype n, bool castagnoli)
+{
+    while (n >= 8)
+    {
+        quint64 value;
+        std::memcpy(&value, p, sizeof(value));
+        crc = castagnoli ? __crc32cd(crc, value) : __crc32d(crc, value);
+        p += 8;
+        n -= 8;
+    }
+    while (n-- > 0)
+        crc = castagnoli ? __crc32cb(crc, *p++) : __crc32b(crc, *p++);
+    return crc;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Adler-32 with deferred modulo (same NMAX bound as zlib)
+// ---------------------------------------------------------------------------
+quint32 adler32Update(quint32 adler, const uchar *p, qsizetype n)
+{
+    constexpr quint32 Base = 65521;
+    constexpr qsizetype NMax = 5552;
+
+    quint32 a = adler & 0xffff;
+    quint32 b = adler >> 16;
+    while (n > 0)
+    {
+        qsizetype block = qMin(n, NMax);
+        n -= block;
+        while (block >= 8)
+        {
+            a += p[0]; b += a;
+            a += p[1]; b += a;
+            a += p[2]; b += a;
+            a += p[3]; b += a;
+            a += p[4]; b += a;
+            a += p[5]; b += a;
+            a += p[6]; b += a;
+            a += p[7]; b += a;
+            p += 8;
+            block -= 8;
+        }
+        while (block-- > 0)
+        {
+            a += *p++;
+            b += a;
+        }
+        a %= Base;
+        b %= Base;
+    }
+    return (b << 16) | a;
+}
+
+// ---------------------------------------------------------------------------
+// SHA-NI block functions
+// ---------------------------------------------------------------------------
+#if defined(CHECKSUMS_X86)
+alignas(16) const quint32 kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+CHECKSUMS_TARGET_SHA void sha256BlocksShaNi(quint32 *state, const uchar *data, qsizetype blocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+    // Rearrange H0..H7 into the ABEF/CDGH register layout SHA256RNDS2 expects
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks-- > 0)
+    {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+
+        __m128i w[4];
+        for (int i = 0; i < 4; ++i)
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), byteSwap);
+
+        for (int group = 0; group < 16; ++group)
+        {
+            if (group >= 4)
+            {
+                // W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16], four words at a time
+                __m128i next = _mm_sha256msg1_epu32(w[group % 4], w[(group + 1) % 4]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(w[(group + 3) % 4], w[(group + 2) % 4], 4));
+                w[group % 4] = _mm_sha256msg2_epu32(next, w[(group + 3) % 4]);
+            }
+            __m128i msg = _mm_add_epi32(w[group % 4],
+                                        _mm_load_si128(reinterpret_cast<const __m128i *>(kSha256K + 4 * group)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+}
+
+// One group of four SHA-1 rounds. The round function selector must be an
+// immediate, hence the template instead of a loop.
+template <int G>
+CHECKSUMS_TARGET_SHA inline void sha1Group(__m128i &abcd, __m128i &e0, __m128i &e1, __m128i (&w)[4])
+{
+    __m128i &eIn = (G % 2 == 0) ? e0 : e1;
+    __m128i &eOut = (G % 2 == 0) ? e1 : e0;
+
+    if constexpr (G == 0)
+        eIn = _mm_add_epi32(eIn, w[0]);
+    else
+        eIn = _mm_sha1nexte_epu32(eIn, w[G % 4]);
+    eOut = abcd;
+    if constexpr (G >= 3 && G <= 18)
+        w[(G + 1) % 4] = _mm_sha1msg2_epu32(w[(G + 1) % 4], w[G % 4]);
+    abcd = _mm_sha1rnds4_epu32(abcd, eIn, G / 5);
+    if constexpr (G >= 1 && G <= 16)
+        w[(G + 3) % 4] = _mm_sha1msg1_epu32(w[(G + 3) % 4], w[G % 4]);
+    if constexpr (G >= 2 && G <= 17)
+        w[(G + 2) % 4] = _mm_xor_si128(w[(G + 2) % 4], w[G % 4]);
+}
+
+template <int... G>
+CHECKSUMS_TARGET_SHA inline void sha1Rounds(__m128i &abcd, __m128i &e0, __m128i &e1, __m128i (&w)[4],
+                                            std::integer_sequence<int, G...>)
+{
+    (sha1Group<G>(abcd, e0, e1, w), ...);
+}
+
+CHECKSUMS_TARGET_SHA void sha1BlocksShaNi(quint32 *state, const uchar *data, qsizetype blocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+    while (blocks-- > 0)
+    {
+        const __m128i abcdSave = abcd;
+        const __m128i e0Save = e0;
+        __m128i e1;
+
+        __m128i w[4];
+        for (int i = 0; i < 4; ++i)
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), byteSwap);
+
+        sha1Rounds(abcd, e0, e1, w, std::make_integer_sequence<int, 20>{});
+
+        e0 = _mm_sha1nexte_epu32(e0, e0Save);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+        data += 64;
+    }
+
+    abcd = _mm_shuffle_epi32(abcd, 0x1B);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state), abcd);
+    state[4] = static_cast<quint32>(_mm_extract_epi32(e0, 3));
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Merkle-Damgard framing around a hardware block function
+// ---------------------------------------------------------------------------
+class BlockHasher
+{
+public:
+    using BlockFunction = void (*)(quint32 *state, const uchar *data, qsizetype blocks);
+
+    BlockHasher(BlockFunction blockFunction, std::initializer_list<quint32> initialState)
+        : m_blockFunction(blockFunction)
+        , m_words(static_cast<int>(initialState.size()))
+    {
+        std::copy(initialState.begin(), initialState.end(), m_state.begin());
+    }
+
+    void addData(const uchar *data, qsizetype length)
+    {
+        m_totalBytes += static_cast<quint64>(length);
+        if (m_buffered > 0)
+        {
+            const qsizetype take = qMin(length, qsizetype(64) - m_buffered);
+            std::memcpy(m_buffer + m_buffered, data, static_cast<size_t>(take));
+            m_buffered += take;
+            data += take;
+            length -= take;
+            if (m_buffered < 64)
+                return;
+            m_blockFunction(m_state.data(), m_buffer, 1);
+            m_buffered = 0;
+        }
+        const qsizetype blocks = length / 64;
+        if (blocks > 0)
+        {
+            m_blockFunction(m_state.data(), data, blocks);
+            data += blocks * 64;
+            length -= blocks * 64;
+        }
+        if (length > 0)
+        {
+            std::memcpy(m_buffer, data, static_cast<size_t>(length));
+            m_buffered = length;
+        }
+    }
+
+    QByteArray result()
+    {
+        const quint64 bitLength = m_totalBytes * 8;
+        uchar padding[72] = {0x80};
+        const qsizetype padLength = (m_buffered < 56 ? 56 : 120) - m_buffered;
+        qToBigEndian(bitLength, padding + padLength);
+        const quint64 savedTotal = m_totalBytes;
+        addData(padding, padLength + 8);
+        m_totalBytes = savedTotal;
+
+        QByteArray digest(m_words * 4, Qt::Uninitialized);
+        for (int i = 0; i < m_words; ++i)
+            qToBigEndian(m_state[static_cast<std::size_t>(i)], digest.data() + 4 * i);
+        return digest;
+    }
+
+private:
+    BlockFunction m_blockFunction;
+    std::array<quint32, 8> m_state{};
+    int m_words;
+    uchar m_buffer[64] = {};
+    qsizetype m_buffered = 0;
+    quint64 m_totalBytes = 0;
+};
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ChecksumAccumulator
+// ---------------------------------------------------------------------------
+struct ChecksumAccumulator::Private
+{
+    quint32 crc32 = 0xFFFFFFFFu;
+    quint32 crc32c = 0xFFFFFFFFu;
+    quint32 adler32 = 1;
+
+    std::unique_ptr<BlockHasher> sha1;
+    std::unique_ptr<BlockHasher> sha256;
+    std::unique_ptr<QCryptographicHash> sha1Fallback;
+    std::unique_ptr<QCryptographicHash> sha256Fallback;
+};
+
+ChecksumAccumulator::ChecksumAccumulator()
+    : d(new Private)
+{
+#if defined(CHECKSUMS_X86)
+    if (cpuFeatures().sha)
+    {
+        d->sha1.reset(new BlockHasher(sha1BlocksShaNi,
+                                      {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0}));
+        d->sha256.reset(new BlockHasher(sha256BlocksShaNi,
+                                        {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}));
+        return;
+    }
+#endif
+    d->sha1Fallback.reset(new QCryptographicHash(QCryptographicHash::Sha1));
+    d->sha256Fallback.reset(new QCryptographicHash(QCryptographicHash::Sha256));
+}
+
+ChecksumAccumulator::~ChecksumAccumulator() = default;
+
+void ChecksumAccumulator::addData(const uchar *data, qsizetype length)
+{
+    if (length <= 0)
+        return;
+
+#if defined(CHECKSUMS_ARM_CRC)
+    d->crc32 = crc32Armv8(d->crc32, data, length, false);
+    d->crc32c = crc32Armv8(d->crc32c, data, length, true);
+#else
+    d->crc32 = crcSlicingBy8(kCrc32Tables, d->crc32, data, length);
+#if defined(CHECKSUMS_X86)
+    if (cpuFeatures().sse42)
+        d->crc32c = crc32cSse42(d->crc32c, data, length);
+    else
+#endif
+        d->crc32c = crcSlicingBy8(kCrc32cTables, d->crc32c, data, length);
+#endif
+
+    d->adler32 = adler32Update(d->adler32, data, length);
+
+    if (d->sha1)
+    {
+        d->sha1->addData(data, length);
+        d->sha256->addData(data, length);
+    }
+    else
+    {
+        const QByteArray chunk = QByteArray::fromRawData(reinterpret_cast<const char *>(data), length);
+        d->sha1Fallback->addData(chunk);
+        d->sha256Fallback->addData(chunk);
+    }
+}
+
+void ChecksumAccumulator::addData(const QByteArray &data)
+{
+    addData(reinterpret_cast<const uchar *>(data.constData()), data.size());
+}
+
+ByteChecksums ChecksumAccumulator::result()
+{
+    ByteChecksums sums;
+    sums.crc32 = ~d->crc32;
+    sums.crc32c = ~d->crc32c;
+    sums.adler32 = d->adler32;
+    if (d->sha1)
+    {
+        sums.sha1 = d->sha1->result();
+        sums.sha256 = d->sha256->result();
+    }
+    else
+    {
+        sums.sha1 = d->sha1Fallback->result();
+        sums.sha256 = d->sha256Fallback->result();
+    }
+    return sums;
+}
+
+QString ChecksumAccumulator::hardwareSummary()
+{
+    QStringList paths;
+#if defined(CHECKSUMS_ARM_CRC)
+    paths << QStringLiteral("ARMv8 CRC32/CRC32C");
+#elif defined(CHECKSUMS_X86)
+    if (cpuFeatures().sse42)
+        paths << QStringLiteral("SSE4.2 CRC32C");
+    if (cpuFeatures().sha)
+        paths << QStringLiteral("SHA-NI");
+#endif
+    return paths.isEmpty() ? QStringLiteral("software") : paths.join(QStringLiteral(", "));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include <memory>
+
+// ---------------------------------------------------------------------------
+// Digests computed over a byte range by ChecksumAccumulator.
+// CRC values follow the usual conventions (reflected, final XOR applied), so
+// they match zlib's crc32(), iSCSI CRC32C and zlib's adler32().
+// ---------------------------------------------------------------------------
+struct ByteChecksums
+{
+    quint32 crc32 = 0;
+    quint32 crc32c = 0;
+    quint32 adler32 = 1;
+    QByteArray sha1;
+    QByteArray sha256;
+};
+
+// ---------------------------------------------------------------------------
+// Streaming accumulator for CRC32, CRC32C, Adler-32, SHA-1 and SHA-256.
+//
+// All five digests are updated from the same chunk while it is hot in cache,
+// so callers feed the data exactly once. Hardware paths are selected at
+// runtime: SSE4.2 / ARMv8 CRC instructions for CRC32C (and CRC32 on ARM),
+// SHA-NI for SHA-1 and SHA-256. Without them the accumulator falls back to
+// slicing-by-8 tables and QCryptographicHash.
+//
+// Not thread-safe; use one accumulator per job.
+// ---------------------------------------------------------------------------
+class ChecksumAccumulator
+{
+public:
+    ChecksumAccumulator();
+    ~ChecksumAccumulator();
+
+    ChecksumAccumulator(const ChecksumAccumulator &) = delete;
+    ChecksumAccumulator &operator=(const ChecksumAccumulator &) = delete;
+
+    void addData(const uchar *data, qsizetype length);
+    void addData(const QByteArray &data);
+
+    // Finalizes the digests. The accumulator must not be fed afterwards.
+    ByteChecksums result();
+
+    // Human readable list of the hardware paths in use, e.g. "SSE4.2 CRC32C, SHA-NI"
+    static QString hardwareSummary();
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
@@ -0,0 +1,269 @@
+#include "ClassViewPanel.h"
+
+#include <FileSystemIndex.h>
+#include <LazyTreeModel.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QTreeView>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+// Editors save in bursts; rebuild once they settle
+constexpr int BuildDelayMs = 500;
+
+constexpr int MaxMatches = 500;
+
+bool isScope(SymbolKind kind)
+{
+    return kind == SymbolKind::Namespace || kind == SymbolKind::Class || kind == SymbolKind::Struct;
+}
+
+QString kindText(SymbolKind kind)
+{
+    switch (kind)
+    {
+    case SymbolKind::Namespace:
+        return QStringLiteral("namespace");
+    case SymbolKind::Class:
+        return QStringLiteral("class");
+    case SymbolKind::Struct:
+        return QStringLiteral("struct");
+    case SymbolKind::Enum:
+        return QStringLiteral("enum");
+    case SymbolKind::Function:
+        return QStringLiteral("function");
+    case SymbolKind::Signal:
+        return QStringLiteral("signal");
+    case SymbolKind::Slot:
+        return QStringLiteral("slot");
+    }
+    return QString();
+}
+
+QString displayName(const SymbolIndex::Entry &entry, bool qualified)
+{
+    QString name = qualified && !entry.scope.isEmpty() ? entry.scope + QStringLiteral("::") + entry.name : entry.name;
+    if (!isScope(entry.kind) && entry.kind != SymbolKind::Enum)
+        name += QStringLiteral("()");
+    return name;
+}
+} // namespace
+
+struct ClassViewPanel::State
+{
+    std::mutex mutex;
+    std::shared_ptr<const SymbolIndex> index;
+    QString filter;
+};
+
+ClassViewPanel::ClassViewPanel(const QString &rootPath, QWidget *parent)
+    : QWidget(parent)
+    , m_rootPath(QDir::cleanPath(rootPath))
+    , m_indexPath(SymbolIndex::defaultPath(rootPath))
+    , m_state(std::make_shared<State>())
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+
+    m_filterEdit = new QLineEdit(this);
+    m_filterEdit->setPlaceholderText(tr("Go to symbol..."));
+    m_filterEdit->setClearButtonEnabled(true);
+    layout->addWidget(m_filterEdit);
+
+    // Keys are symbol names, so a node's path joined with "::" is its scope
+    std::shared_ptr<State> state = m_state;
+    const QString root = m_rootPath;
+    auto provider = std::make_shared<DockManager::FunctionTreeProvider>(
+        [state, root](const QStringList &path)
+        {
+            std::shared_ptr<const SymbolIndex> index;
+            QString filter;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                index = state->index;
+                filter = state->filter;
+            }
+            QVector<DockManager::LazyTreeItem> items;
+            if (!index || (!filter.isEmpty() && !path.isEmpty()))
+                return items;
+
+            const QDir rootDir(root);
+            const auto location = [&rootDir](const SymbolIndex::Entry &entry)
+            {
+                return rootDir.relativeFilePath(entry.filePath) + QLatin1Char(':') + QString::number(entry.line);
+            };
+
+            if (!filter.isEmpty())
+            {
+                for (const SymbolIndex::Entry &entry : index->find(filter, MaxMatches))
+                {
+                    const QString text = displayName(entry, true);
+                    items.append(DockManager::LazyTreeItem{text + QLatin1Char('@') + location(entry),
+                                                           {text, kindText(entry.kind), location(entry)},
+                                                           false});
+                }
+                return items;
+            }
+
+            const QString scope = path.join(QStringLiteral("::"));
+            QVector<SymbolIndex::Entry> members = index->members(scope);
+            std::stable_partition(members.begin(), members.end(),
+                                  [](const SymbolIndex::Entry &entry) { return entry.kind <= SymbolKind::Enum; });
+            for (const SymbolIndex::Entry &entry : std::as_const(members))
+            {
+                const bool expandable =
+                    isScope(entry.kind)
+                    && index->hasMembers(scope.isEmpty() ? entry.name : scope + QStringLiteral("::") + entry.name);
+                items.append(DockManager::LazyTreeItem{entry.name,
+                                                       {displayName(entry, false), kindText(entry.kind),
+                                                        location(entry)},
+                                                       expandable});
+            }
+            return items;
+        });
+
+    m_tree = new QTreeView(this);
+    m_tree->setUniformRowHeights(true);
+    m_model = new DockManager::LazyTreeModel(provider, {tr("Symbol"), tr("Kind"), tr("Location")}, m_tree);
+    m_tree->setModel(m_model);
+    m_model->bindView(m_tree);
+    layout->addWidget(m_tree, 1);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setContentsMargins(4, 0, 4, 4);
+    layout->addWidget(m_statusLabel);
+
+    m_buildTimer = new QTimer(this);
+    m_buildTimer->setSingleShot(true);
+    m_buildTimer->setInterval(BuildDelayMs);
+    connect(m_buildTimer, &QTimer::timeout, this, &ClassViewPanel::startBuild);
+
+    connect(m_filterEdit, &QLineEdit::textChanged, this, [this](const QString &text)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->filter = text.trimmed();
+        }
+        m_model->refresh();
+    });
+
+    // Shares the crawl and watches of explorer panels on the same root
+    m_fileIndex = DockManager::FileSystemIndex::shared(m_rootPath);
+    connect(m_fileIndex.get(), &DockManager::FileSystemIndex::directoriesChanged, this,
+            &ClassViewPanel::scheduleBuild);
+    connect(m_fileIndex.get(), &DockManager::FileSystemIndex::filesModified, this, [this](const QStringList &paths)
+    {
+        if (std::any_of(paths.cbegin(), paths.cend(), isSymbolSourceFile))
+            scheduleBuild();
+    });
+    m_fileIndex->ensureCrawled();
+
+    // Only maps the file; the tree is there before anything is parsed
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->index = SymbolIndex::open(m_indexPath);
+    }
+    m_model->refresh();
+    startBuild();
+}
+
+ClassViewPanel::~ClassViewPanel()
+{
+    if (m_cancelled)
+        m_cancelled->store(true);
+}
+
+// ---------------------------------------------------------------------------
+// Index builds
+// ---------------------------------------------------------------------------
+void ClassViewPanel::startBuild()
+{
+    if (m_cancelled)
+    {
+        // One build at a time; they share the index slots
+        m_buildPending = true;
+        return;
+    }
+    m_buildPending = false;
+
+    std::shared_ptr<const SymbolIndex> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        previous = m_state->index;
+    }
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_cancelled = cancelled;
+    m_elapsed.start();
+    updateStatus(tr("(indexing...)"));
+
+    const QString rootPath = m_rootPath;
+    const QString indexPath = m_indexPath;
+    QPointer<ClassViewPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, rootPath, indexPath, previous, cancelled]()
+    {
+        SymbolIndexStats stats;
+        const bool completed = buildSymbolIndex(rootPath, indexPath, previous.get(), *cancelled, &stats);
+
+        QMetaObject::invokeMethod(qApp, [guard, completed, stats]()
+        {
+            if (guard)
+                guard->onBuildFinished(completed, stats);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ClassViewPanel::onBuildFinished(bool completed, const SymbolIndexStats &stats)
+{
+    m_cancelled.reset();
+    std::shared_ptr<const SymbolIndex> index = completed ? SymbolIndex::open(m_indexPath) : nullptr;
+    if (index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->index = index;
+        }
+        m_model->refresh();
+        updateStatus(tr("(%1 files parsed, %2 unchanged, in %3 ms)")
+                         .arg(stats.filesParsed)
+                         .arg(stats.filesReused)
+                         .arg(m_elapsed.elapsed()));
+    }
+    else
+    {
+        updateStatus();
+    }
+
+    if (m_buildPending)
+        scheduleBuild();
+}
+
+void ClassViewPanel::scheduleBuild()
+{
+    if (m_cancelled)
+        m_buildPending = true;
+    else
+        m_buildTimer->start();
+}
+
+void ClassViewPanel::updateStatus(const QString &suffix)
+{
+    std::shared_ptr<const SymbolIndex> index;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        index = m_state->index;
+    }
+    const QString counts = index ? tr("%1 symbols in %2 files").arg(index->symbolCount()).arg(index->fileCount())
+                                 : tr("No symbol index yet");
+    m_statusLabel->setText(suffix.isEmpty() ? counts : counts + QLatin1Char(' ') + suffix);
+}
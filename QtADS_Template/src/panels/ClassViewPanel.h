@@ -0,0 +1,61 @@
+#pragma once
+
+#include "SymbolIndex.h"
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+namespace DockManager
+{
+class FileSystemIndex;
+class LazyTreeModel;
+}
+
+class QLabel;
+class QLineEdit;
+class QTimer;
+class QTreeView;
+
+// ---------------------------------------------------------------------------
+// Namespaces, classes and their members from the project's symbol index.
+//
+// The last index is memory-mapped at once, so the tree is filled without
+// parsing anything; an incremental rebuild then runs on the thread pool and
+// swaps the new index in. Change events of the shared FileSystemIndex
+// schedule further rebuilds. The tree loads scopes lazily straight from the
+// index, and the filter box lists symbols by name prefix instead
+// (go-to-symbol).
+// ---------------------------------------------------------------------------
+class ClassViewPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ClassViewPanel(const QString &rootPath, QWidget *parent = nullptr);
+    ~ClassViewPanel() override;
+
+private:
+    struct State;
+
+    void startBuild();
+    void onBuildFinished(bool completed, const SymbolIndexStats &stats);
+    void scheduleBuild();
+    void updateStatus(const QString &suffix = QString());
+
+    QString m_rootPath;
+    QString m_indexPath;
+    QLineEdit *m_filterEdit = nullptr;
+    QTreeView *m_tree = nullptr;
+    DockManager::LazyTreeModel *m_model = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    QTimer *m_buildTimer = nullptr;
+
+    std::shared_ptr<State> m_state; // shared with the tree provider
+    std::shared_ptr<DockManager::FileSystemIndex> m_fileIndex;
+    std::shared_ptr<std::atomic_bool> m_cancelled; // set while a build runs
+    bool m_buildPending = false;
+    QElapsedTimer m_elapsed;
+};
@@ -0,0 +1,695 @@
+#include "ContentSearch.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONTENT_SEARCH_SSE2 1
+#endif
+
+namespace
+{
+// Directories that hold version control metadata, never searched
+const char *const VcsDirectories[] = {".git", ".hg", ".svn"};
+
+// Directories with more files than this are split into several tasks so
+// that idle workers can steal part of them
+constexpr int FilesPerTask = 64;
+
+// A NUL byte in the first block marks a file as binary
+constexpr qsizetype BinaryProbeBytes = 8192;
+
+constexpr int MaxLineTextLength = 240;
+
+bool isAsciiLetter(uchar c)
+{
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+uchar foldAscii(uchar c)
+{
+    return (c >= 'A' && c <= 'Z') ? uchar(c | 0x20) : c;
+}
+
+// Glob match of [p, pEnd) against [s, sEnd); "*" and "?" stop at '/'
+bool globMatch(const char *p, const char *pEnd, const char *s, const char *sEnd)
+{
+    while (p < pEnd)
+    {
+        const char c = *p;
+        if (c == '*')
+        {
+            if (p + 1 < pEnd && p[1] == '*')
+            {
+                p += 2;
+                // "**/" also matches no directory at all
+                if (p < pEnd && *p == '/' && globMatch(p + 1, pEnd, s, sEnd))
+                    return true;
+                for (const char *t = s; t <= sEnd; ++t)
+                {
+                    if (globMatch(p, pEnd, t, sEnd))
+                        return true;
+                }
+                return false;
+            }
+            ++p;
+            for (const char *t = s;; ++t)
+            {
+                if (globMatch(p, pEnd, t, sEnd))
+                    return true;
+                if (t == sEnd || *t == '/')
+                    return false;
+            }
+        }
+        if (s == sEnd)
+            return false;
+        if (c == '?')
+        {
+            if (*s == '/')
+                return false;
+            ++p;
+            ++s;
+            continue;
+        }
+        if (c == '[')
+        {
+            const char *q = p + 1;
+            const bool negated = q < pEnd && (*q == '!' || *q == '^');
+            if (negated)
+                ++q;
+            bool matched = false;
+            const char *classStart = q;
+            while (q < pEnd && (*q != ']' || q == classStart))
+            {
+                if (q + 2 < pEnd && q[1] == '-' && q[2] != ']')
+                {
+                    matched |= uchar(*s) >= uchar(q[0]) && uchar(*s) <= uchar(q[2]);
+                    q += 3;
+                }
+                else
+                {
+                    matched |= *s == *q;
+                    ++q;
+                }
+            }
+            if (q < pEnd)
+            {
+                if (matched == negated || *s == '/')
+                    return false;
+                p = q + 1;
+                ++s;
+                continue;
+            }
+            // No closing bracket: a literal '['
+        }
+        if (c == '\\' && p + 1 < pEnd)
+            ++p;
+        if (*p != *s)
+            return false;
+        ++p;
+        ++s;
+    }
+    return s == sEnd;
+}
+
+struct WalkTask
+{
+    QString path;                              // directory to list, if files is empty
+    QStringList files;                         // otherwise, files to search
+    std::shared_ptr<const IgnoreRules> rules;
+};
+
+struct WorkQueue
+{
+    std::mutex mutex;
+    std::deque<WalkTask> tasks;
+};
+
+struct Matcher
+{
+    QByteArray literal;       // prefilter, may be empty
+    bool caseSensitive = false;
+    bool useRegex = false;    // otherwise a hit is simply an occurrence of literal
+    QRegularExpression regex;
+    int maxHits = 0;
+};
+
+QString lineText(const char *begin, const char *end)
+{
+    QString text = QString::fromUtf8(begin, int(end - begin)).trimmed();
+    if (text.size() > MaxLineTextLength)
+    {
+        text.truncate(MaxLineTextLength);
+        text += QChar(0x2026);
+    }
+    return text;
+}
+
+// Appends hits of one mapped file to result; returns false if there are none
+bool searchBuffer(const Matcher &matcher, const char *data, qsizetype size, SearchFileResult *result)
+{
+    if (std::memchr(data, 0, size_t(qMin(size, BinaryProbeBytes))))
+        return false;
+
+    qsizetype pos = 0;
+    if (!matcher.literal.isEmpty())
+    {
+        pos = findLiteral(data, size, matcher.literal, matcher.caseSensitive);
+        if (pos < 0)
+            return false;
+    }
+
+    // Line numbers are counted lazily, only up to lines that are reported
+    int lineNumber = 1;
+    qsizetype counted = 0;
+
+    while (pos >= 0 && pos < size && result->hits.size() < matcher.maxHits)
+    {
+        qsizetype lineStart = pos;
+        while (lineStart > counted && data[lineStart - 1] != '\n')
+            --lineStart;
+        const void *newline = std::memchr(data + pos, '\n', size_t(size - pos));
+        const qsizetype lineEnd = newline ? static_cast<const char *>(newline) - data : size;
+
+        lineNumber += int(std::count(data + counted, data + lineStart, '\n'));
+        counted = lineStart;
+
+        SearchHit hit;
+        if (matcher.useRegex)
+        {
+            const QString line = QString::fromUtf8(data + lineStart, int(lineEnd - lineStart));
+            const QRegularExpressionMatch match = matcher.regex.match(line);
+            if (match.hasMatch())
+                hit.column = int(match.capturedStart()) + 1;
+        }
+        else
+        {
+            hit.column = QString::fromUtf8(data + lineStart, int(pos - lineStart)).size() + 1;
+        }
+        if (hit.column > 0)
+        {
+            hit.line = lineNumber;
+            hit.text = lineText(data + lineStart, data + lineEnd);
+            result->hits.append(hit);
+        }
+
+        // Next candidate line
+        pos = lineEnd + 1;
+        if (pos >= size)
+            break;
+        if (!matcher.literal.isEmpty())
+        {
+            const qsizetype next = findLiteral(data + pos, size - pos, matcher.literal, matcher.caseSensitive);
+            pos = next < 0 ? -1 : pos + next;
+        }
+    }
+    return !result->hits.isEmpty();
+}
+
+// Appends hits of one file to result; returns false if there are none
+bool searchFile(const Matcher &matcher, const QString &path, SearchFileResult *result, qint64 *bytesRead)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 size = file.size();
+    if (size <= 0)
+        return false;
+    *bytesRead = size;
+
+    result->path = path;
+    uchar *mapped = file.map(0, size);
+    if (mapped)
+    {
+        const bool found = searchBuffer(matcher, reinterpret_cast<const char *>(mapped), qsizetype(size), result);
+        file.unmap(mapped);
+        return found;
+    }
+    const QByteArray contents = file.readAll();
+    return searchBuffer(matcher, contents.constData(), contents.size(), result);
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// IgnoreRules
+// ---------------------------------------------------------------------------
+std::shared_ptr<const IgnoreRules> IgnoreRules::load(const std::shared_ptr<const IgnoreRules> &parent,
+                                                     const QString &dirPath)
+{
+    QByteArray text;
+    for (const char *name : {".gitignore", ".ignore"})
+    {
+        QFile file(dirPath + QLatin1Char('/') + QLatin1String(name));
+        if (file.open(QIODevice::ReadOnly))
+            text += file.readAll() + '\n';
+    }
+    if (text.isEmpty())
+        return parent;
+    return fromText(parent, dirPath, text);
+}
+
+std::shared_ptr<const IgnoreRules> IgnoreRules::fromText(const std::shared_ptr<const IgnoreRules> &parent,
+                                                         const QString &dirPath, const QByteArray &text)
+{
+    auto rules = std::make_shared<IgnoreRules>();
+    rules->m_parent = parent;
+    rules->m_baseDir = QDir::cleanPath(dirPath).toUtf8();
+    if (!rules->m_baseDir.endsWith('/'))
+        rules->m_baseDir += '/';
+
+    for (QByteArray line : text.split('\n'))
+    {
+        if (line.endsWith('\r'))
+            line.chop(1);
+        // Trailing spaces are ignored unless escaped
+        while (line.endsWith(' ') && !line.endsWith("\\ "))
+            line.chop(1);
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        Rule rule;
+        if (line.startsWith('!'))
+        {
+            rule.negated = true;
+            line.remove(0, 1);
+        }
+        else if (line.startsWith("\\!") || line.startsWith("\\#"))
+        {
+            line.remove(0, 1);
+        }
+        if (line.endsWith('/'))
+        {
+            rule.directoryOnly = true;
+            line.chop(1);
+        }
+        rule.anchored = line.contains('/');
+        if (line.startsWith('/'))
+            line.remove(0, 1);
+        if (line.isEmpty())
+            continue;
+        rule.pattern = line;
+        rules->m_rules.push_back(rule);
+    }
+    if (rules->m_rules.empty())
+        return parent;
+    return rules;
+}
+
+bool IgnoreRules::isIgnored(const QString &path, bool isDir) const
+{
+    const QByteArray utf8 = path.toUtf8();
+    return verdict(utf8, utf8.lastIndexOf('/') + 1, isDir) > 0;
+}
+
+int IgnoreRules::verdict(const QByteArray &path, qsizetype nameStart, bool isDir) const
+{
+    // Outer directories first; within a file, the last matching rule wins
+    int result = m_parent ? m_parent->verdict(path, nameStart, isDir) : 0;
+    if (!path.startsWith(m_baseDir))
+        return result;
+
+    const char *relative = path.constData() + m_baseDir.size();
+    const char *name = path.constData() + nameStart;
+    const char *end = path.constData() + path.size();
+    for (const Rule &rule : m_rules)
+    {
+        if (rule.directoryOnly && !isDir)
+            continue;
+        const char *subject = rule.anchored ? relative : name;
+        const char *patternBegin = rule.pattern.constData();
+        if (globMatch(patternBegin, patternBegin + rule.pattern.size(), subject, end))
+            result = rule.negated ? -1 : 1;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Literal prefilter
+// ---------------------------------------------------------------------------
+QByteArray requiredLiteral(const QString &pattern, bool regex, bool caseSensitive)
+{
+    QString literal;
+    if (!regex)
+    {
+        literal = pattern;
+    }
+    else if (!pattern.contains(QLatin1String("(?")))
+    {
+        // Longest run of plain characters outside groups and classes. Group
+        // contents may be optional or alternated, so they never contribute.
+        QString run;
+        int depth = 0;
+        bool inClass = false;
+        const auto flush = [&]() {
+            if (run.size() > literal.size())
+                literal = run;
+            run.clear();
+        };
+        for (int i = 0; i < pattern.size(); ++i)
+        {
+            const QChar c = pattern.at(i);
+            if (inClass)
+            {
+                if (c == QLatin1Char('\\'))
+                    ++i;
+                else if (c == QLatin1Char(']'))
+                    inClass = false;
+                continue;
+            }
+            if (c == QLatin1Char('|') && depth == 0)
+                return {};
+            switch (c.unicode())
+            {
+            case '(':
+                flush();
+                ++depth;
+                continue;
+            case ')':
+                --depth;
+                continue;
+            case '[':
+                flush();
+                inClass = true;
+                continue;
+            default:
+                break;
+            }
+            if (depth > 0)
+            {
+                if (c == QLatin1Char('\\'))
+                    ++i;
+                continue;
+            }
+            switch (c.unicode())
+            {
+            case '{':
+                // Skip the repeat count, e.g. "a{2,3}"
+                while (i + 1 < pattern.size() && pattern.at(i) != QLatin1Char('}'))
+                    ++i;
+                Q_FALLTHROUGH();
+            case '*':
+            case '?':
+                // The previous character may be absent
+                run.chop(1);
+                flush();
+                break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+                flush();
+                break;
+            case '\\':
+                if (i + 1 < pattern.size() && !pattern.at(i + 1).isLetterOrNumber())
+                    run += pattern.at(++i);
+                else
+                {
+                    flush();
+                    ++i;
+                }
+                break;
+            default:
+                run += c;
+                break;
+            }
+        }
+        flush();
+    }
+
+    QByteArray bytes = literal.toUtf8();
+    if (!caseSensitive)
+    {
+        for (const char c : bytes)
+        {
+            if (uchar(c) >= 0x80)
+                return {};
+        }
+        bytes = bytes.toLower();
+    }
+    return bytes;
+}
+
+qsizetype findLiteral(const char *data, qsizetype size, const QByteArray &needle, bool caseSensitive)
+{
+    const qsizetype length = needle.size();
+    if (length == 0)
+        return 0;
+    if (length > size)
+        return -1;
+
+    const auto *bytes = reinterpret_cast<const uchar *>(data);
+    const auto *pattern = reinterpret_cast<const uchar *>(needle.constData());
+    const uchar first = pattern[0];
+    const uchar last = pattern[length - 1];
+
+    const auto middleMatches = [&](qsizetype at) {
+        if (caseSensitive)
+            return std::memcmp(bytes + at + 1, pattern + 1, size_t(qMax<qsizetype>(0, length - 2))) == 0;
+        for (qsizetype j = 1; j < length - 1; ++j)
+        {
+            if (foldAscii(bytes[at + j]) != pattern[j])
+                return false;
+        }
+        return true;
+    };
+
+    qsizetype i = 0;
+#if defined(CONTENT_SEARCH_SSE2)
+    // Setting bit 5 maps 'A'-'Z' onto 'a'-'z' and nothing else onto a letter
+    const __m128i firstFold = _mm_set1_epi8(char(!caseSensitive && isAsciiLetter(first) ? 0x20 : 0));
+    const __m128i lastFold = _mm_set1_epi8(char(!caseSensitive && isAsciiLetter(last) ? 0x20 : 0));
+    const __m128i firstBytes = _mm_set1_epi8(char(first));
+    const __m128i lastBytes = _mm_set1_epi8(char(last));
+    for (; i + length - 1 + 16 <= size; i += 16)
+    {
+        const __m128i blockFirst =
+            _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i)), firstFold);
+        const __m128i blockLast =
+            _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i + length - 1)), lastFold);
+        quint32 mask = quint32(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, firstBytes), _mm_cmpeq_epi8(blockLast, lastBytes))));
+        while (mask)
+        {
+            const qsizetype at = i + qCountTrailingZeroBits(mask);
+            if (middleMatches(at))
+                return at;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i + length <= size; ++i)
+    {
+        const uchar a = caseSensitive ? bytes[i] : foldAscii(bytes[i]);
+        const uchar b = caseSensitive ? bytes[i + length - 1] : foldAscii(bytes[i + length - 1]);
+        if (a == first && b == last && middleMatches(i))
+            return i;
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Parallel walk
+// ---------------------------------------------------------------------------
+bool walkFiles(const QString &rootPath, int threadCount, const std::atomic_bool &cancelled,
+               const std::function<void(const QString &)> &onFile, qint64 *directoryCount,
+               const std::function<void(const QString &)> &onDirectory)
+{
+    if (threadCount <= 0)
+        threadCount = int(qMax(1u, std::thread::hardware_concurrency()));
+    std::vector<WorkQueue> queues(size_t(threadCount));
+    // Tasks queued or running; the walk is over when this drops to zero
+    std::atomic<qint64> pending{1};
+    queues[0].tasks.push_back(WalkTask{QDir::cleanPath(rootPath), {}, nullptr});
+
+    std::atomic<qint64> directories{0};
+
+    const auto push = [&](int worker, WalkTask &&task) {
+        pending.fetch_add(1);
+        std::lock_guard<std::mutex> lock(queues[size_t(worker)].mutex);
+        queues[size_t(worker)].tasks.push_back(std::move(task));
+    };
+
+    const auto take = [&](int worker, WalkTask *task) {
+        {
+            WorkQueue &own = queues[size_t(worker)];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                *task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (int k = 1; k < threadCount; ++k)
+        {
+            WorkQueue &victim = queues[size_t((worker + k) % threadCount)];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                *task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    };
+
+    const auto listDirectory = [&](int worker, const WalkTask &task) {
+        directories.fetch_add(1, std::memory_order_relaxed);
+        if (onDirectory)
+            onDirectory(task.path);
+        const std::shared_ptr<const IgnoreRules> rules = IgnoreRules::load(task.rules, task.path);
+
+        QStringList dirFiles;
+        QDirIterator it(task.path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks);
+        while (it.hasNext() && !cancelled.load(std::memory_order_relaxed))
+        {
+            const QString path = it.next();
+            const QFileInfo info = it.fileInfo();
+            const bool isDir = info.isDir();
+            if (isDir && isVcsDirectory(info.fileName()))
+                continue;
+            if (rules && rules->isIgnored(path, isDir))
+                continue;
+
+            if (isDir)
+            {
+                push(worker, WalkTask{path, {}, rules});
+                continue;
+            }
+            dirFiles.append(path);
+            if (dirFiles.size() == FilesPerTask)
+            {
+                push(worker, WalkTask{task.path, dirFiles, rules});
+                dirFiles.clear();
+            }
+        }
+        for (const QString &path : std::as_const(dirFiles))
+        {
+            if (cancelled.load(std::memory_order_relaxed))
+                break;
+            onFile(path);
+        }
+    };
+
+    const auto work = [&](int worker) {
+        int idleRounds = 0;
+        WalkTask task;
+        while (!cancelled.load(std::memory_order_relaxed))
+        {
+            if (!take(worker, &task))
+            {
+                if (pending.load() == 0)
+                    return;
+                // Others are still listing; their subdirectories will show up
+                if (++idleRounds < 64)
+                    std::this_thread::yield();
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            idleRounds = 0;
+            if (task.files.isEmpty())
+                listDirectory(worker, task);
+            else
+            {
+                for (const QString &path : std::as_const(task.files))
+                {
+                    if (cancelled.load(std::memory_order_relaxed))
+                        break;
+                    onFile(path);
+                }
+            }
+            // Only after this task's children were queued
+            pending.fetch_sub(1);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(size_t(threadCount - 1));
+    for (int t = 1; t < threadCount; ++t)
+        threads.emplace_back(work, t);
+    work(0);
+    for (auto &thread : threads)
+        thread.join();
+
+    if (directoryCount)
+        *directoryCount = directories.load();
+    return !cancelled.load();
+}
+
+bool isVcsDirectory(const QString &name)
+{
+    return std::any_of(std::begin(VcsDirectories), std::end(VcsDirectories),
+                       [&](const char *vcs) { return name == QLatin1String(vcs); });
+}
+
+bool searchTree(const SearchOptions &options, const std::atomic_bool &cancelled,
+                const std::function<void(SearchFileResult &&)> &onFile, SearchStats *stats)
+{
+    if (options.pattern.isEmpty())
+        return false;
+
+    Matcher matcher;
+    matcher.caseSensitive = options.caseSensitive;
+    matcher.maxHits = qMax(1, options.maxHitsPerFile);
+    matcher.literal = requiredLiteral(options.pattern, options.regex, options.caseSensitive);
+    // Case-insensitive non-ASCII text has no byte literal; let the regex fold it
+    matcher.useRegex = options.regex || matcher.literal.isEmpty();
+    if (matcher.useRegex)
+    {
+        const QString source = options.regex ? options.pattern : QRegularExpression::escape(options.pattern);
+        matcher.regex = QRegularExpression(source, options.caseSensitive
+                                                       ? QRegularExpression::NoPatternOption
+                                                       : QRegularExpression::CaseInsensitiveOption);
+        if (!matcher.regex.isValid())
+        {
+            qWarning() << "searchTree: invalid pattern" << options.pattern << matcher.regex.errorString();
+            return false;
+        }
+        matcher.regex.optimize();
+    }
+
+    std::atomic<qint64> files{0}, bytes{0}, matchedFiles{0}, hits{0};
+    qint64 directories = 0;
+    const auto searchPath = [&](const QString &path) {
+        SearchFileResult result;
+        qint64 size = 0;
+        const bool found = searchFile(matcher, path, &result, &size);
+        if (size > 0)
+        {
+            files.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        if (!found)
+            return;
+        matchedFiles.fetch_add(1, std::memory_order_relaxed);
+        hits.fetch_add(result.hits.size(), std::memory_order_relaxed);
+        onFile(std::move(result));
+    };
+    const bool finished = walkFiles(options.rootPath, options.threadCount, cancelled, searchPath, &directories);
+
+    if (stats)
+    {
+        stats->directoriesScanned = directories;
+        stats->filesScanned = files.load();
+        stats->bytesScanned = bytes.load();
+        stats->filesMatched = matchedFiles.load();
+        stats->hits = hits.load();
+    }
+    return finished;
+}
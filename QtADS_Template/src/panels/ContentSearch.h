@@ -0,0 +1,136 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Search request and results
+// ---------------------------------------------------------------------------
+struct SearchOptions
+{
+    QString rootPath;
+    QString pattern;
+    bool regex = false;          // pattern is a QRegularExpression, otherwise plain text
+    bool caseSensitive = false;
+    int maxHitsPerFile = 1000;
+    int threadCount = 0;         // 0 = one per hardware thread
+};
+
+struct SearchHit
+{
+    int line = 0;   // 1-based
+    int column = 0; // 1-based, in UTF-16 code units
+    QString text;   // the matching line, trimmed and shortened
+};
+
+struct SearchFileResult
+{
+    QString path;
+    QVector<SearchHit> hits;
+};
+
+struct SearchStats
+{
+    qint64 directoriesScanned = 0;
+    qint64 filesScanned = 0;
+    qint64 bytesScanned = 0;
+    qint64 filesMatched = 0;
+    qint64 hits = 0;
+};
+
+// ---------------------------------------------------------------------------
+// .gitignore / .ignore rules of one directory, layered over its parent's.
+//
+// Supports the usual syntax: comments, "!" negation, trailing "/" for
+// directories only, patterns with a slash anchored to the directory of the
+// ignore file, and "*", "?", "**" and [...] wildcards. Instances are
+// immutable and shared between the directories they apply to.
+// ---------------------------------------------------------------------------
+class IgnoreRules
+{
+public:
+    // Rules for dirPath: its ignore files over parent's rules. Returns
+    // parent itself when dirPath has no ignore files.
+    static std::shared_ptr<const IgnoreRules> load(const std::shared_ptr<const IgnoreRules> &parent,
+                                                   const QString &dirPath);
+
+    // Same as load() with the contents of the ignore file given directly
+    static std::shared_ptr<const IgnoreRules> fromText(const std::shared_ptr<const IgnoreRules> &parent,
+                                                       const QString &dirPath, const QByteArray &text);
+
+    // path must lie below the directory the rules were loaded for
+    bool isIgnored(const QString &path, bool isDir) const;
+
+private:
+    struct Rule
+    {
+        QByteArray pattern;
+        bool negated = false;
+        bool directoryOnly = false;
+        bool anchored = false; // matched against the relative path, not the file name
+    };
+
+    // 1 = ignored, -1 = re-included, 0 = no rule matched
+    int verdict(const QByteArray &path, qsizetype nameStart, bool isDir) const;
+
+    std::shared_ptr<const IgnoreRules> m_parent;
+    QByteArray m_baseDir; // UTF-8, with trailing '/'
+    std::vector<Rule> m_rules;
+};
+
+// ---------------------------------------------------------------------------
+// Literal text every match of the pattern must contain, used to skip files
+// before running the regular expression. Empty if none can be derived (for
+// example with top-level alternation). Case-insensitive searches get a
+// lower-cased literal, or none if it is not ASCII.
+// ---------------------------------------------------------------------------
+QByteArray requiredLiteral(const QString &pattern, bool regex, bool caseSensitive);
+
+// ---------------------------------------------------------------------------
+// Offset of the first occurrence of needle in data, or -1. Without
+// caseSensitive, needle must be lower-case and ASCII letters in data match
+// either case. Uses SSE2 on x86: candidates are positions where both the
+// first and the last byte of the needle match, 16 at a time.
+// ---------------------------------------------------------------------------
+qsizetype findLiteral(const char *data, qsizetype size, const QByteArray &needle, bool caseSensitive);
+
+// ---------------------------------------------------------------------------
+// Calls onFile for every file below rootPath.
+//
+// Directories are walked in parallel by a work-stealing pool of std::threads:
+// each worker pops from the back of its own deque, so it descends depth-first
+// through the subtree it is in, and idle workers steal from the front of
+// other deques, taking the shallowest (largest) pending work. Ignored paths,
+// symlinks and VCS directories are skipped.
+//
+// Blocks until done. onFile and onDirectory, which is called for every
+// directory walked (the root included), are called concurrently from the
+// worker threads; threadCount 0 means one per hardware thread. Returns false
+// if cancelled.
+// ---------------------------------------------------------------------------
+bool walkFiles(const QString &rootPath, int threadCount, const std::atomic_bool &cancelled,
+               const std::function<void(const QString &path)> &onFile, qint64 *directoryCount = nullptr,
+               const std::function<void(const QString &path)> &onDirectory = {});
+
+// True for the version control directories walkFiles() skips (".git" etc.)
+bool isVcsDirectory(const QString &name);
+
+// ---------------------------------------------------------------------------
+// Searches all files below options.rootPath and calls onFile for every file
+// with at least one hit, as soon as that file is done.
+//
+// Files come from walkFiles(), are memory-mapped and checked with
+// findLiteral() before any line is decoded or matched.
+//
+// Blocks until done. onFile is called concurrently from the worker threads.
+// Returns false if the pattern is invalid or the search was cancelled.
+// ---------------------------------------------------------------------------
+bool searchTree(const SearchOptions &options, const std::atomic_bool &cancelled,
+                const std::function<void(SearchFileResult &&)> &onFile, SearchStats *stats = nullptr);
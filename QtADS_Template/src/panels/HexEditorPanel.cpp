@@ -0,0 +1,563 @@
+#include "HexEditorPanel.h"
+
+#include <QAction>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QHeaderView>
+#include <QItemSelectionModel>
+#include <QLabel>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPointer>
+#include <QProgressBar>
+#include <QSplitter>
+#include <QTableView>
+#include <QTableWidget>
+#include <QThreadPool>
+#include <QTimer>
+#include <QToolBar>
+#include <QVBoxLayout>
+#include <QtEndian>
+
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+// ---------------------------------------------------------------------------
+// HexDocument
+// ---------------------------------------------------------------------------
+std::shared_ptr<HexDocument> HexDocument::open(const QString &fileName, QString *errorString)
+{
+    std::shared_ptr<HexDocument> document(new HexDocument);
+    document->m_fileName = fileName;
+    document->m_file = std::make_unique<QFile>(fileName);
+    if (!document->m_file->open(QIODevice::ReadOnly))
+    {
+        if (errorString)
+            *errorString = document->m_file->errorString();
+        return nullptr;
+    }
+
+    document->m_size = document->m_file->size();
+    if (document->m_size > 0)
+    {
+        document->m_data = document->m_file->map(0, document->m_size);
+        if (!document->m_data)
+        {
+            // Sequential devices and some file systems cannot be mapped
+            document->m_buffer = document->m_file->readAll();
+            document->m_size = document->m_buffer.size();
+            document->m_data = reinterpret_cast<const uchar *>(document->m_buffer.constData());
+        }
+    }
+    return document;
+}
+
+// Closing the QFile also releases the mapping
+HexDocument::~HexDocument() = default;
+
+// ---------------------------------------------------------------------------
+// HexTableModel
+// ---------------------------------------------------------------------------
+HexTableModel::HexTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void HexTableModel::setDocument(std::shared_ptr<HexDocument> document)
+{
+    beginResetModel();
+    m_document = std::move(document);
+    endResetModel();
+}
+
+qint64 HexTableModel::offsetAt(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.column() == OffsetColumn || index.column() == AsciiColumn)
+        return -1;
+    return qint64(index.row()) * BytesPerRow + index.column() - 1;
+}
+
+int HexTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !m_document)
+        return 0;
+    // Views count rows in int; bytes past ~32 GiB are not addressable
+    const qint64 rows = (m_document->size() + BytesPerRow - 1) / BytesPerRow;
+    return int(qMin<qint64>(rows, std::numeric_limits<int>::max()));
+}
+
+int HexTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : AsciiColumn + 1;
+}
+
+QVariant HexTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || !m_document)
+        return {};
+
+    if (role == Qt::TextAlignmentRole)
+        return index.column() == AsciiColumn ? int(Qt::AlignLeft | Qt::AlignVCenter) : int(Qt::AlignCenter);
+
+    if (role != Qt::DisplayRole)
+        return {};
+
+    const qint64 rowStart = qint64(index.row()) * BytesPerRow;
+    const qint64 size = m_document->size();
+
+    if (index.column() == OffsetColumn)
+        return QStringLiteral("%1").arg(rowStart, 8, 16, QLatin1Char('0')).toUpper();
+
+    if (index.column() == AsciiColumn)
+    {
+        const qint64 count = qMin<qint64>(BytesPerRow, size - rowStart);
+        QString text(int(count), QLatin1Char('.'));
+        for (int i = 0; i < count; ++i)
+        {
+            const uchar c = m_document->data()[rowStart + i];
+            if (c >= 0x20 && c < 0x7f)
+                text[i] = QLatin1Char(char(c));
+        }
+        return text;
+    }
+
+    const qint64 offset = rowStart + index.column() - 1;
+    if (offset >= size)
+        return {};
+    return QStringLiteral("%1").arg(uint(m_document->data()[offset]), 2, 16, QLatin1Char('0')).toUpper();
+}
+
+QVariant HexTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    if (section == OffsetColumn)
+        return tr("Offset");
+    if (section == AsciiColumn)
+        return tr("ASCII");
+    return QStringLiteral("%1").arg(section - 1, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+// ---------------------------------------------------------------------------
+// Data inspector decoding
+// ---------------------------------------------------------------------------
+namespace
+{
+struct InspectorType
+{
+    const char *name;
+    int size;
+    QString (*decode)(const uchar *bytes, bool bigEndian);
+};
+
+template <typename T>
+QString decodeInteger(const uchar *bytes, bool bigEndian)
+{
+    const T value = bigEndian ? qFromBigEndian<T>(bytes) : qFromLittleEndian<T>(bytes);
+    return QString::number(value);
+}
+
+QString decodeFloat32(const uchar *bytes, bool bigEndian)
+{
+    const quint32 bits = bigEndian ? qFromBigEndian<quint32>(bytes) : qFromLittleEndian<quint32>(bytes);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return QString::number(double(value), 'g', 9);
+}
+
+QString decodeFloat64(const uchar *bytes, bool bigEndian)
+{
+    const quint64 bits = bigEndian ? qFromBigEndian<quint64>(bytes) : qFromLittleEndian<quint64>(bytes);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return QString::number(value, 'g', 17);
+}
+
+const InspectorType kInspectorTypes[] = {
+    {"int8", 1, decodeInteger<qint8>},
+    {"uint8", 1, decodeInteger<quint8>},
+    {"int16", 2, decodeInteger<qint16>},
+    {"uint16", 2, decodeInteger<quint16>},
+    {"int32", 4, decodeInteger<qint32>},
+    {"uint32", 4, decodeInteger<quint32>},
+    {"int64", 8, decodeInteger<qint64>},
+    {"uint64", 8, decodeInteger<quint64>},
+    {"float32", 4, decodeFloat32},
+    {"float64", 8, decodeFloat64},
+};
+
+// ---------------------------------------------------------------------------
+// Table view whose selection is always one linear byte span, like the
+// selection of a text editor. QTableView would select the rectangle between
+// anchor and cursor, which covers bytes of every row the user never picked.
+// ---------------------------------------------------------------------------
+class HexTableView : public QTableView
+{
+public:
+    using QTableView::QTableView;
+
+protected:
+    void setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command) override
+    {
+        // rect runs from the anchor to the cursor and is not normalized
+        const qint64 anchor = byteAt(indexAt(rect.topLeft()));
+        const qint64 cursor = byteAt(indexAt(rect.bottomRight()));
+        if (anchor < 0 || cursor < 0)
+        {
+            QTableView::setSelection(rect, command);
+            return;
+        }
+        selectionModel()->select(linearSelection(qMin(anchor, cursor), qMax(anchor, cursor)),
+                                 QItemSelectionModel::ClearAndSelect);
+    }
+
+private:
+    // Offset and ASCII cells stand for the first and the last byte of their row
+    qint64 byteAt(const QModelIndex &index) const
+    {
+        if (!index.isValid())
+            return -1;
+        const int column = qBound(0, index.column() - 1, HexTableModel::BytesPerRow - 1);
+        return qint64(index.row()) * HexTableModel::BytesPerRow + column;
+    }
+
+    QItemSelection linearSelection(qint64 first, qint64 last) const
+    {
+        constexpr int BytesPerRow = HexTableModel::BytesPerRow;
+        const int firstRow = int(first / BytesPerRow);
+        const int lastRow = int(last / BytesPerRow);
+        auto cell = [this](int row, qint64 byte) { return model()->index(row, int(byte % BytesPerRow) + 1); };
+
+        QItemSelection selection;
+        if (firstRow == lastRow)
+        {
+            selection.select(cell(firstRow, first), cell(lastRow, last));
+            return selection;
+        }
+        selection.select(cell(firstRow, first), cell(firstRow, BytesPerRow - 1));
+        if (lastRow - firstRow > 1)
+            selection.select(cell(firstRow + 1, 0), cell(lastRow - 1, BytesPerRow - 1));
+        selection.select(cell(lastRow, 0), cell(lastRow, last));
+        return selection;
+    }
+};
+
+const char *const kChecksumNames[] = {"CRC32", "CRC32C", "Adler-32", "SHA-1", "SHA-256"};
+
+QTableWidget *makeSideTable(QWidget *parent, const QStringList &headers, int rows)
+{
+    auto *table = new QTableWidget(rows, headers.size(), parent);
+    table->setHorizontalHeaderLabels(headers);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->verticalHeader()->hide();
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < headers.size(); ++c)
+            table->setItem(r, c, new QTableWidgetItem());
+    }
+    return table;
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// HexEditorPanel
+// ---------------------------------------------------------------------------
+HexEditorPanel::HexEditorPanel(QWidget *parent)
+    : QWidget(parent)
+    , m_model(new HexTableModel(this))
+    , m_checksumCache(256)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+
+    auto *toolBar = new QToolBar(this);
+    auto *openAction = toolBar->addAction(tr("Open..."));
+    connect(openAction, &QAction::triggered, this, &HexEditorPanel::onOpenClicked);
+    m_fileLabel = new QLabel(tr("No file"), toolBar);
+    toolBar->addWidget(m_fileLabel);
+    layout->addWidget(toolBar);
+
+    auto *splitter = new QSplitter(Qt::Horizontal, this);
+    layout->addWidget(splitter, 1);
+
+    const QFont fixedFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    const QFontMetrics metrics(fixedFont);
+
+    m_view = new HexTableView(splitter);
+    m_view->setModel(m_model);
+    // One contiguous span; Ctrl+click would add disjoint ranges the
+    // checksum cannot represent
+    m_view->setSelectionMode(QAbstractItemView::ContiguousSelection);
+    m_view->setFont(fixedFont);
+    m_view->verticalHeader()->hide();
+    // Fixed section sizes keep layout O(1) regardless of the row count
+    m_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_view->verticalHeader()->setDefaultSectionSize(metrics.height() + 4);
+    m_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_view->horizontalHeader()->setDefaultSectionSize(metrics.horizontalAdvance(QStringLiteral("000")));
+    m_view->horizontalHeader()->resizeSection(HexTableModel::OffsetColumn,
+                                              metrics.horizontalAdvance(QStringLiteral("000000000000")));
+    m_view->horizontalHeader()->setStretchLastSection(true);
+    splitter->addWidget(m_view);
+
+    auto *side = new QWidget(splitter);
+    auto *sideLayout = new QVBoxLayout(side);
+    sideLayout->setContentsMargins(4, 4, 4, 4);
+
+    m_rangeLabel = new QLabel(tr("No selection"), side);
+    sideLayout->addWidget(m_rangeLabel);
+
+    m_progress = new QProgressBar(side);
+    m_progress->setRange(0, 100);
+    m_progress->hide();
+    sideLayout->addWidget(m_progress);
+
+    m_checksumTable = makeSideTable(side, {tr("Algorithm"), tr("Value")}, int(std::size(kChecksumNames)));
+    for (int r = 0; r < int(std::size(kChecksumNames)); ++r)
+        m_checksumTable->item(r, 0)->setText(QString::fromLatin1(kChecksumNames[r]));
+    sideLayout->addWidget(m_checksumTable);
+
+    auto *hardwareLabel = new QLabel(tr("Acceleration: %1").arg(ChecksumAccumulator::hardwareSummary()), side);
+    hardwareLabel->setEnabled(false);
+    sideLayout->addWidget(hardwareLabel);
+
+    m_inspectorTable = makeSideTable(side, {tr("Type"), tr("Little Endian"), tr("Big Endian")},
+                                     int(std::size(kInspectorTypes)));
+    for (int r = 0; r < int(std::size(kInspectorTypes)); ++r)
+        m_inspectorTable->item(r, 0)->setText(QString::fromLatin1(kInspectorTypes[r].name));
+    sideLayout->addWidget(m_inspectorTable, 1);
+
+    splitter->addWidget(side);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 1);
+
+    // Debounce so dragging a selection does not start a job per mouse move
+    m_selectionTimer = new QTimer(this);
+    m_selectionTimer->setSingleShot(true);
+    m_selectionTimer->setInterval(120);
+    connect(m_selectionTimer, &QTimer::timeout, this, &HexEditorPanel::startChecksumJob);
+
+    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &HexEditorPanel::onSelectionChanged);
+    connect(m_view->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &HexEditorPanel::onCurrentChanged);
+}
+
+HexEditorPanel::~HexEditorPanel()
+{
+    cancelChecksumJob();
+}
+
+bool HexEditorPanel::openFile(const QString &fileName)
+{
+    QString error;
+    auto document = HexDocument::open(fileName, &error);
+    if (!document)
+    {
+        QMessageBox::warning(this, tr("Hex Editor"), tr("Cannot open %1: %2").arg(fileName, error));
+        return false;
+    }
+
+    cancelChecksumJob();
+    m_checksumCache.clear();
+    ++m_generation;
+    m_pendingRange = {-1, -1};
+    m_model->setDocument(std::move(document));
+    m_fileLabel->setText(tr("%1 (%2)").arg(QFileInfo(fileName).fileName(),
+                                            QLocale().formattedDataSize(m_model->document()->size())));
+    onSelectionChanged();
+    onCurrentChanged(QModelIndex());
+    return true;
+}
+
+void HexEditorPanel::onOpenClicked()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Open Binary File"));
+    if (!fileName.isEmpty())
+        openFile(fileName);
+}
+
+HexEditorPanel::ByteRange HexEditorPanel::selectedRange() const
+{
+    const auto document = m_model->document();
+    if (!document || document->size() == 0)
+        return {-1, -1};
+
+    // HexTableView keeps the selection one linear span, so its bounds are
+    // exactly the selected bytes. Work on selection ranges, never on
+    // selectedIndexes(), which would materialize one index per selected cell
+    qint64 first = -1;
+    qint64 last = -1;
+    for (const QItemSelectionRange &range : m_view->selectionModel()->selection())
+    {
+        const int left = range.left() == HexTableModel::OffsetColumn ? 0 : qMin(range.left() - 1, 15);
+        const int right = (range.right() == HexTableModel::OffsetColumn || range.right() == HexTableModel::AsciiColumn)
+                              ? 15
+                              : range.right() - 1;
+        const qint64 begin = qint64(range.top()) * HexTableModel::BytesPerRow + left;
+        const qint64 end = qint64(range.bottom()) * HexTableModel::BytesPerRow + right;
+        first = first < 0 ? begin : qMin(first, begin);
+        last = qMax(last, end);
+    }
+    if (first < 0)
+        return {-1, -1};
+    return {first, qMin(last, document->size() - 1)};
+}
+
+void HexEditorPanel::onSelectionChanged()
+{
+    m_pendingRange = selectedRange();
+    if (m_pendingRange.first < 0)
+    {
+        m_rangeLabel->setText(tr("No selection"));
+        m_selectionTimer->stop();
+        cancelChecksumJob();
+        showChecksums(nullptr);
+        return;
+    }
+
+    const qint64 length = m_pendingRange.second - m_pendingRange.first + 1;
+    m_rangeLabel->setText(tr("Selection: 0x%1 - 0x%2 (%3 bytes)")
+                              .arg(m_pendingRange.first, 0, 16)
+                              .arg(m_pendingRange.second, 0, 16)
+                              .arg(length));
+
+    if (const ByteChecksums *cached = m_checksumCache.object(m_pendingRange))
+    {
+        m_selectionTimer->stop();
+        cancelChecksumJob();
+        showChecksums(cached);
+        return;
+    }
+    showChecksums(nullptr);
+    m_selectionTimer->start();
+}
+
+void HexEditorPanel::onCurrentChanged(const QModelIndex &current)
+{
+    const auto document = m_model->document();
+    const qint64 offset = m_model->offsetAt(current);
+    const qint64 available = (document && offset >= 0) ? document->size() - offset : 0;
+
+    for (int r = 0; r < int(std::size(kInspectorTypes)); ++r)
+    {
+        const InspectorType &type = kInspectorTypes[r];
+        const bool valid = available >= type.size;
+        const uchar *bytes = valid ? document->data() + offset : nullptr;
+        m_inspectorTable->item(r, 1)->setText(valid ? type.decode(bytes, false) : QString());
+        m_inspectorTable->item(r, 2)->setText(valid ? type.decode(bytes, true) : QString());
+    }
+}
+
+void HexEditorPanel::startChecksumJob()
+{
+    const ByteRange range = m_pendingRange;
+    auto document = m_model->document();
+    if (!document || range.first < 0)
+        return;
+
+    if (const ByteChecksums *cached = m_checksumCache.object(range))
+    {
+        showChecksums(cached);
+        return;
+    }
+
+    cancelChecksumJob();
+    const quint64 jobId = ++m_jobId;
+    const quint64 generation = m_generation;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_jobCancelled = cancelled;
+    m_progress->setValue(0);
+    m_progress->show();
+
+    QPointer<HexEditorPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, document, range, jobId, generation, cancelled]()
+    {
+        // 1 MiB chunks stay in L2 while all five digests consume them
+        constexpr qint64 ChunkSize = 1 << 20;
+        const qint64 total = range.second - range.first + 1;
+        ChecksumAccumulator accumulator;
+        int lastPercent = 0;
+
+        for (qint64 done = 0; done < total;)
+        {
+            if (cancelled->load(std::memory_order_relaxed))
+                return;
+            const qint64 length = qMin(ChunkSize, total - done);
+            accumulator.addData(document->data() + range.first + done, length);
+            done += length;
+
+            const int percent = int(done * 100 / total);
+            if (percent != lastPercent)
+            {
+                lastPercent = percent;
+                QMetaObject::invokeMethod(qApp, [guard, jobId, percent]()
+                {
+                    if (guard)
+                        guard->onChecksumProgress(jobId, percent);
+                }, Qt::QueuedConnection);
+            }
+        }
+
+        const ByteChecksums sums = accumulator.result();
+        QMetaObject::invokeMethod(qApp, [guard, jobId, generation, range, sums]()
+        {
+            if (guard)
+                guard->onChecksumsReady(jobId, generation, range, sums);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void HexEditorPanel::cancelChecksumJob()
+{
+    if (m_jobCancelled)
+        m_jobCancelled->store(true);
+    m_jobCancelled.reset();
+    m_progress->hide();
+}
+
+void HexEditorPanel::onChecksumProgress(quint64 jobId, int percent)
+{
+    if (jobId == m_jobId && m_jobCancelled)
+        m_progress->setValue(percent);
+}
+
+void HexEditorPanel::onChecksumsReady(quint64 jobId, quint64 generation, ByteRange range,
+                                      const ByteChecksums &sums)
+{
+    // A job for the previous document may have posted before openFile()
+    // cancelled it; its range means nothing in this one
+    if (generation != m_generation)
+        return;
+
+    // Results of superseded jobs for this document are still worth caching
+    m_checksumCache.insert(range, new ByteChecksums(sums));
+    if (jobId != m_jobId)
+        return;
+
+    m_jobCancelled.reset();
+    m_progress->hide();
+    if (range == m_pendingRange)
+        showChecksums(&sums);
+}
+
+void HexEditorPanel::showChecksums(const ByteChecksums *sums)
+{
+    auto hex32 = [](quint32 value)
+    { return QStringLiteral("%1").arg(value, 8, 16, QLatin1Char('0')).toUpper(); };
+
+    const QStringList values = sums ? QStringList{hex32(sums->crc32), hex32(sums->crc32c), hex32(sums->adler32),
+                                                  QString::fromLatin1(sums->sha1.toHex()),
+                                                  QString::fromLatin1(sums->sha256.toHex())}
+                                    : QStringList{};
+    for (int r = 0; r < m_checksumTable->rowCount(); ++r)
+        m_checksumTable->item(r, 1)->setText(values.value(r));
+}
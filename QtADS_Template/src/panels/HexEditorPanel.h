@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ByteChecksums.h"
+
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QPair>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+class QFile;
+class QLabel;
+class QProgressBar;
+class QTableView;
+class QTableWidget;
+class QTimer;
+
+// ---------------------------------------------------------------------------
+// Read-only byte source for the hex editor. Files are memory mapped when the
+// platform allows it, so background jobs can stream from the mapping without
+// copying. Shared between the model and in-flight checksum jobs, which keep
+// the mapping alive until they finish.
+// ---------------------------------------------------------------------------
+class HexDocument
+{
+public:
+    static std::shared_ptr<HexDocument> open(const QString &fileName, QString *errorString = nullptr);
+    ~HexDocument();
+
+    QString fileName() const { return m_fileName; }
+    const uchar *data() const { return m_data; }
+    qint64 size() const { return m_size; }
+
+private:
+    HexDocument() = default;
+
+    QString m_fileName;
+    std::unique_ptr<QFile> m_file;
+    QByteArray m_buffer;      // used when mapping is not possible
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Virtual table model: offset column, 16 byte columns and an ASCII column.
+// Nothing is materialized per cell, so multi-GB dumps are fine.
+// ---------------------------------------------------------------------------
+class HexTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int BytesPerRow = 16;
+    static constexpr int OffsetColumn = 0;
+    static constexpr int AsciiColumn = BytesPerRow + 1;
+
+    explicit HexTableModel(QObject *parent = nullptr);
+
+    void setDocument(std::shared_ptr<HexDocument> document);
+    std::shared_ptr<HexDocument> document() const { return m_document; }
+
+    // Byte offset of a byte cell, or -1 for the offset/ASCII columns
+    qint64 offsetAt(const QModelIndex &index) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    std::shared_ptr<HexDocument> m_document;
+};
+
+// ---------------------------------------------------------------------------
+// Hex editor panel with a checksum and data-inspector side pane.
+//
+// Selecting a range starts a background job that streams the range through
+// ChecksumAccumulator on the global thread pool. Results are cached per
+// (begin, end) range, so reselecting a range shows its digests immediately.
+// The inspector decodes the bytes under the cursor as every integer and
+// float width in little and big endian.
+// ---------------------------------------------------------------------------
+class HexEditorPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HexEditorPanel(QWidget *parent = nullptr);
+    ~HexEditorPanel() override;
+
+    bool openFile(const QString &fileName);
+
+private:
+    using ByteRange = QPair<qint64, qint64>; // [first, last], inclusive
+
+    void onOpenClicked();
+    void onSelectionChanged();
+    void onCurrentChanged(const QModelIndex &current);
+    void startChecksumJob();
+    void cancelChecksumJob();
+    void showChecksums(const ByteChecksums *sums);
+    void onChecksumsReady(quint64 jobId, quint64 generation, ByteRange range, const ByteChecksums &sums);
+    void onChecksumProgress(quint64 jobId, int percent);
+    ByteRange selectedRange() const;
+
+    HexTableModel *m_model = nullptr;
+    QTableView *m_view = nullptr;
+    QLabel *m_fileLabel = nullptr;
+    QLabel *m_rangeLabel = nullptr;
+    QProgressBar *m_progress = nullptr;
+    QTableWidget *m_checksumTable = nullptr;
+    QTableWidget *m_inspectorTable = nullptr;
+    QTimer *m_selectionTimer = nullptr;
+
+    QCache<ByteRange, ByteChecksums> m_checksumCache;
+    ByteRange m_pendingRange{-1, -1};
+    quint64 m_jobId = 0;
+    quint64 m_generation = 0; // of the open document, bumped by openFile()
+    std::shared_ptr<std::atomic_bool> m_jobCancelled;
+};
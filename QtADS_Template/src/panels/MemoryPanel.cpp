@@ -0,0 +1,470 @@
+#include "MemoryPanel.h"
+#include "ProcessMemoryReader.h"
+
+#include <QColor>
+#include <QComboBox>
+#include <QCoreApplication>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPointer>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSpinBox>
+#include <QTableView>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <cstring>
+
+namespace
+{
+// 1024 pages = 4 MiB with 4 KiB pages, several screens of scrollback
+constexpr int DefaultCachePages = 1024;
+constexpr int DefaultIntervalMs = 250;
+
+bool isChanged(const QByteArray &changedBits, quint64 byteInPage)
+{
+    if (changedBits.isEmpty())
+        return false;
+    return (uchar(changedBits.at(int(byteInPage / 8))) >> (byteInPage % 8)) & 1u;
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// MemoryTableModel
+// ---------------------------------------------------------------------------
+MemoryTableModel::MemoryTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_pageSize(ProcessMemoryReader::pageSize())
+    , m_pages(DefaultCachePages)
+{
+}
+
+void MemoryTableModel::setBaseAddress(quint64 address)
+{
+    // Keep the whole window inside the 64-bit address space
+    const quint64 windowBytes = quint64(WindowRows) * BytesPerRow;
+    address &= ~quint64(BytesPerRow - 1);
+    if (address > ~quint64(0) - windowBytes + 1)
+        address = ~quint64(0) - windowBytes + 1;
+    if (address == m_baseAddress)
+        return;
+
+    beginResetModel();
+    m_baseAddress = address;
+    endResetModel();
+}
+
+void MemoryTableModel::clearCache()
+{
+    beginResetModel();
+    m_pages.clear();
+    endResetModel();
+}
+
+const MemoryTableModel::CachedPage *MemoryTableModel::page(quint64 address) const
+{
+    return m_pages.object(address & ~(m_pageSize - 1));
+}
+
+QByteArray MemoryTableModel::cachedBytes(quint64 pageAddress) const
+{
+    const CachedPage *cached = m_pages.object(pageAddress);
+    return (cached && cached->readable) ? cached->bytes : QByteArray();
+}
+
+void MemoryTableModel::applyUpdates(const QVector<MemoryPageUpdate> &updates)
+{
+    // Inclusive bound; the window may end exactly at the top of the address space
+    const quint64 windowLast = rowAddress(WindowRows - 1) + (BytesPerRow - 1);
+    for (const MemoryPageUpdate &update : updates)
+    {
+        // Skip repainting pages that were already shown and stayed the same
+        const CachedPage *previous = m_pages.object(update.address);
+        const bool unchanged = previous && previous->readable == update.readable && update.changedCount == 0
+                               && previous->changedBits.isEmpty() && previous->bytes == update.bytes;
+
+        auto *cached = new CachedPage;
+        cached->readable = update.readable;
+        cached->bytes = update.bytes;
+        if (update.changedCount > 0)
+            cached->changedBits = update.changedBits;
+        m_pages.insert(update.address, cached, 1);
+
+        if (unchanged)
+            continue;
+        const quint64 first = qMax(update.address, m_baseAddress);
+        const quint64 last = qMin(update.address + (m_pageSize - 1), windowLast);
+        if (first > last)
+            continue;
+        const int firstRow = int((first - m_baseAddress) / BytesPerRow);
+        const int lastRow = int((last - m_baseAddress) / BytesPerRow);
+        emit dataChanged(index(firstRow, 1), index(lastRow, BytesPerRow));
+    }
+}
+
+int MemoryTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : WindowRows;
+}
+
+int MemoryTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : BytesPerRow + 1;
+}
+
+QVariant MemoryTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return {};
+
+    if (role == Qt::TextAlignmentRole)
+        return int(Qt::AlignCenter);
+
+    const quint64 rowStart = rowAddress(index.row());
+    if (index.column() == 0)
+    {
+        if (role != Qt::DisplayRole)
+            return {};
+        return QStringLiteral("%1").arg(rowStart, 16, 16, QLatin1Char('0')).toUpper();
+    }
+
+    const quint64 address = rowStart + quint64(index.column() - 1);
+    const CachedPage *cached = page(address);
+    if (!cached)
+        return {};
+    const quint64 byteInPage = address & (m_pageSize - 1);
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        if (!cached->readable)
+            return QStringLiteral("??");
+        return QStringLiteral("%1").arg(uint(uchar(cached->bytes.at(int(byteInPage)))), 2, 16, QLatin1Char('0')).toUpper();
+    case Qt::BackgroundRole:
+        if (isChanged(cached->changedBits, byteInPage))
+            return QColor(255, 170, 0, 110);
+        return {};
+    case Qt::ForegroundRole:
+        if (!cached->readable)
+            return QColor(Qt::gray);
+        return {};
+    default:
+        return {};
+    }
+}
+
+QVariant MemoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    if (section == 0)
+        return tr("Address");
+    return QStringLiteral("%1").arg(section - 1, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+// ---------------------------------------------------------------------------
+// MemoryPanel
+// ---------------------------------------------------------------------------
+MemoryPanel::MemoryPanel(QWidget *parent)
+    : QWidget(parent)
+    , m_model(new MemoryTableModel(this))
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+
+    auto *controls = new QHBoxLayout;
+    controls->setContentsMargins(4, 4, 4, 0);
+    controls->addWidget(new QLabel(tr("PID:"), this));
+    m_pidEdit = new QLineEdit(QString::number(QCoreApplication::applicationPid()), this);
+    m_pidEdit->setMaximumWidth(80);
+    controls->addWidget(m_pidEdit);
+    auto *attachButton = new QPushButton(tr("Attach"), this);
+    controls->addWidget(attachButton);
+
+    m_regionCombo = new QComboBox(this);
+    m_regionCombo->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    m_regionCombo->setMinimumContentsLength(24);
+    controls->addWidget(m_regionCombo, 1);
+
+    m_addressEdit = new QLineEdit(this);
+    m_addressEdit->setPlaceholderText(tr("Go to address (hex)"));
+    m_addressEdit->setMaximumWidth(160);
+    controls->addWidget(m_addressEdit);
+
+    m_intervalSpin = new QSpinBox(this);
+    m_intervalSpin->setRange(0, 10000);
+    m_intervalSpin->setSingleStep(50);
+    m_intervalSpin->setSuffix(tr(" ms"));
+    m_intervalSpin->setSpecialValueText(tr("Paused"));
+    m_intervalSpin->setValue(DefaultIntervalMs);
+    controls->addWidget(m_intervalSpin);
+    layout->addLayout(controls);
+
+    const QFont fixedFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    const QFontMetrics metrics(fixedFont);
+
+    m_view = new QTableView(this);
+    m_view->setModel(m_model);
+    m_view->setFont(fixedFont);
+    m_view->verticalHeader()->hide();
+    m_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_view->verticalHeader()->setDefaultSectionSize(metrics.height() + 4);
+    m_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_view->horizontalHeader()->setDefaultSectionSize(metrics.horizontalAdvance(QStringLiteral("000")));
+    m_view->horizontalHeader()->resizeSection(0, metrics.horizontalAdvance(QStringLiteral("00000000000000000")));
+    m_view->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(m_view, 1);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setContentsMargins(4, 0, 4, 4);
+    layout->addWidget(m_statusLabel);
+
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(DefaultIntervalMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &MemoryPanel::schedulePoll);
+
+    connect(attachButton, &QPushButton::clicked, this, &MemoryPanel::onAttachClicked);
+    connect(m_pidEdit, &QLineEdit::returnPressed, this, &MemoryPanel::onAttachClicked);
+    connect(m_addressEdit, &QLineEdit::returnPressed, this, &MemoryPanel::onGoToAddress);
+    connect(m_regionCombo, QOverload<int>::of(&QComboBox::activated), this, &MemoryPanel::onRegionActivated);
+    connect(m_intervalSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &MemoryPanel::onRefreshIntervalChanged);
+    // Pages scrolled into view are fetched right away, not on the next tick
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged, this, &MemoryPanel::schedulePoll);
+
+    // Our own process is always readable, which makes a useful default
+    attach(QCoreApplication::applicationPid());
+}
+
+MemoryPanel::~MemoryPanel() = default;
+
+void MemoryPanel::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    onRefreshIntervalChanged(m_intervalSpin->value());
+    // The cached pages are as old as the time the panel was hidden
+    schedulePoll();
+}
+
+void MemoryPanel::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_pollTimer->stop();
+}
+
+bool MemoryPanel::attach(qint64 pid)
+{
+    detach();
+
+    auto reader = std::make_shared<const ProcessMemoryReader>(pid);
+    if (!reader->isValid())
+    {
+        m_statusLabel->setText(tr("Cannot attach to %1: %2").arg(pid).arg(reader->errorString()));
+        return false;
+    }
+    m_reader = std::move(reader);
+    m_pidEdit->setText(QString::number(pid));
+
+    int firstReadable = -1;
+    const QVector<MemoryRegion> regions = m_reader->regions();
+    for (const MemoryRegion &region : regions)
+    {
+        if (firstReadable < 0 && region.isReadable())
+            firstReadable = m_regionCombo->count();
+        m_regionCombo->addItem(QStringLiteral("%1-%2 %3 %4")
+                                   .arg(region.start, 0, 16)
+                                   .arg(region.end, 0, 16)
+                                   .arg(region.permissions, region.name),
+                               QVariant::fromValue(region.start));
+    }
+    if (firstReadable >= 0)
+    {
+        m_regionCombo->setCurrentIndex(firstReadable);
+        onRegionActivated(firstReadable);
+    }
+
+    m_statusLabel->setText(tr("Attached to %1, %2 regions").arg(pid).arg(regions.size()));
+    onRefreshIntervalChanged(m_intervalSpin->value());
+    schedulePoll();
+    return true;
+}
+
+void MemoryPanel::detach()
+{
+    ++m_generation;
+    m_pollTimer->stop();
+    m_pollInFlight = false;
+    m_pollPending = false;
+    m_reader.reset();
+    m_regionCombo->clear();
+    m_model->clearCache();
+}
+
+void MemoryPanel::onAttachClicked()
+{
+    bool ok = false;
+    const qint64 pid = m_pidEdit->text().trimmed().toLongLong(&ok);
+    if (!ok)
+    {
+        m_statusLabel->setText(tr("Invalid PID"));
+        return;
+    }
+    attach(pid);
+}
+
+void MemoryPanel::onGoToAddress()
+{
+    QString text = m_addressEdit->text().trimmed();
+    if (text.startsWith(QLatin1String("0x"), Qt::CaseInsensitive))
+        text.remove(0, 2);
+    bool ok = false;
+    const quint64 address = text.toULongLong(&ok, 16);
+    if (!ok)
+    {
+        m_statusLabel->setText(tr("Invalid address"));
+        return;
+    }
+
+    // Start the window on the page boundary so the target lands near the top
+    m_model->setBaseAddress(address & ~(ProcessMemoryReader::pageSize() - 1));
+    const int row = int((address - m_model->baseAddress()) / MemoryTableModel::BytesPerRow);
+    m_view->scrollTo(m_model->index(row, 1), QAbstractItemView::PositionAtTop);
+    m_view->setCurrentIndex(m_model->index(row, int(address % MemoryTableModel::BytesPerRow) + 1));
+    schedulePoll();
+}
+
+void MemoryPanel::onRegionActivated(int index)
+{
+    if (index < 0)
+        return;
+    m_model->setBaseAddress(m_regionCombo->itemData(index).toULongLong());
+    m_view->scrollToTop();
+    schedulePoll();
+}
+
+void MemoryPanel::onRefreshIntervalChanged(int milliseconds)
+{
+    if (milliseconds <= 0 || !m_reader || !isVisible())
+    {
+        m_pollTimer->stop();
+        return;
+    }
+    m_pollTimer->start(milliseconds);
+}
+
+QVector<quint64> MemoryPanel::visiblePages() const
+{
+    QVector<quint64> pages;
+    const int top = m_view->rowAt(0);
+    if (top < 0)
+        return pages;
+    int bottom = m_view->rowAt(m_view->viewport()->height() - 1);
+    if (bottom < 0)
+        bottom = m_model->rowCount() - 1;
+
+    const quint64 pageSize = ProcessMemoryReader::pageSize();
+    const quint64 first = m_model->rowAddress(top) & ~(pageSize - 1);
+    const quint64 last = m_model->rowAddress(bottom) + MemoryTableModel::BytesPerRow - 1;
+    for (quint64 page = first; page <= last && page >= first; page += pageSize)
+        pages.append(page);
+    return pages;
+}
+
+void MemoryPanel::schedulePoll()
+{
+    if (m_pollInFlight)
+    {
+        // Coalesce: one more poll after the current one, however many ticks
+        m_pollPending = true;
+        return;
+    }
+    poll();
+}
+
+void MemoryPanel::poll()
+{
+    if (!m_reader)
+        return;
+    const QVector<quint64> pages = visiblePages();
+    if (pages.isEmpty())
+        return;
+
+    // The worker diffs against copies of the cached pages; QByteArray is
+    // implicitly shared, so this only bumps reference counts
+    QVector<QByteArray> baselines;
+    baselines.reserve(pages.size());
+    for (quint64 page : pages)
+        baselines.append(m_model->cachedBytes(page));
+
+    m_pollInFlight = true;
+    m_pollPending = false;
+    const quint64 generation = m_generation;
+    auto reader = m_reader;
+
+    QPointer<MemoryPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, reader, pages, baselines, generation]()
+    {
+        const qsizetype pageSize = qsizetype(ProcessMemoryReader::pageSize());
+        QVector<MemoryPageUpdate> updates;
+        updates.reserve(pages.size());
+
+        for (int i = 0; i < pages.size(); ++i)
+        {
+            MemoryPageUpdate update;
+            update.address = pages[i];
+            update.bytes.resize(pageSize);
+            update.readable = reader->readPage(update.address, reinterpret_cast<uchar *>(update.bytes.data()));
+            if (!update.readable)
+            {
+                update.bytes.clear();
+            }
+            else if (baselines[i].size() == pageSize)
+            {
+                update.changedBits.resize((pageSize + 7) / 8);
+                update.changedCount = diffBytes(reinterpret_cast<const uchar *>(baselines[i].constData()),
+                                                reinterpret_cast<const uchar *>(update.bytes.constData()), pageSize,
+                                                reinterpret_cast<uchar *>(update.changedBits.data()));
+                if (update.changedCount == 0)
+                    update.changedBits.clear();
+            }
+            updates.append(update);
+        }
+
+        QMetaObject::invokeMethod(qApp, [guard, generation, updates]()
+        {
+            if (guard)
+                guard->onPollFinished(generation, updates);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MemoryPanel::onPollFinished(quint64 generation, const QVector<MemoryPageUpdate> &updates)
+{
+    if (generation != m_generation)
+        return;
+    m_pollInFlight = false;
+
+    m_model->applyUpdates(updates);
+
+    int unreadable = 0;
+    int changed = 0;
+    for (const MemoryPageUpdate &update : updates)
+    {
+        unreadable += update.readable ? 0 : 1;
+        changed += update.changedCount;
+    }
+    m_statusLabel->setText(tr("PID %1: %2 pages polled, %3 unreadable, %4 bytes changed")
+                               .arg(m_reader->pid())
+                               .arg(updates.size())
+                               .arg(unreadable)
+                               .arg(changed));
+
+    if (m_pollPending)
+        poll();
+}
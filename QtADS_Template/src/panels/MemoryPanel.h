@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QCache>
+#include <QVector>
+#include <QWidget>
+
+#include <memory>
+
+class ProcessMemoryReader;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QSpinBox;
+class QTableView;
+class QTimer;
+
+// ---------------------------------------------------------------------------
+// Result of reading one page on the poll thread
+// ---------------------------------------------------------------------------
+struct MemoryPageUpdate
+{
+    quint64 address = 0;
+    bool readable = false;
+    QByteArray bytes;       // pageSize() bytes when readable
+    QByteArray changedBits; // one bit per byte, set if it differs from the previous poll
+    int changedCount = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Table model over a 1 MiB window of a process address space, 16 bytes per
+// row. Bytes come from a page-granular LRU cache that is filled by
+// MemoryPanel's poller; pages not yet fetched show blank, unmapped pages "??".
+// ---------------------------------------------------------------------------
+class MemoryTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int BytesPerRow = 16;
+    static constexpr int WindowRows = 65536;
+
+    explicit MemoryTableModel(QObject *parent = nullptr);
+
+    void setBaseAddress(quint64 address);
+    quint64 baseAddress() const { return m_baseAddress; }
+    quint64 rowAddress(int row) const { return m_baseAddress + quint64(row) * BytesPerRow; }
+
+    void clearCache();
+
+    // Previous contents of a cached page, used as the diff baseline
+    QByteArray cachedBytes(quint64 pageAddress) const;
+    void applyUpdates(const QVector<MemoryPageUpdate> &updates);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    struct CachedPage
+    {
+        bool readable = false;
+        QByteArray bytes;
+        QByteArray changedBits;
+    };
+
+    const CachedPage *page(quint64 address) const;
+
+    quint64 m_baseAddress = 0;
+    quint64 m_pageSize;
+    // QCache::object() refreshes the LRU order, hence mutable
+    mutable QCache<quint64, CachedPage> m_pages;
+};
+
+// ---------------------------------------------------------------------------
+// Debug panel showing live memory of a local process.
+//
+// A timer polls only the pages covering the visible rows. Each poll runs on
+// the global thread pool (never more than one at a time), reads the pages
+// through ProcessMemoryReader, diffs them against the cached copy and posts
+// the result back; changed bytes are highlighted until the next poll.
+// ---------------------------------------------------------------------------
+class MemoryPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryPanel(QWidget *parent = nullptr);
+    ~MemoryPanel() override;
+
+    bool attach(qint64 pid);
+    void detach();
+
+protected:
+    // Polling stops while the dock is hidden and resumes when it is shown
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void onAttachClicked();
+    void onGoToAddress();
+    void onRegionActivated(int index);
+    void onRefreshIntervalChanged(int milliseconds);
+    void schedulePoll();
+    void poll();
+    void onPollFinished(quint64 generation, const QVector<MemoryPageUpdate> &updates);
+    QVector<quint64> visiblePages() const;
+
+    MemoryTableModel *m_model = nullptr;
+    QTableView *m_view = nullptr;
+    QLineEdit *m_pidEdit = nullptr;
+    QLineEdit *m_addressEdit = nullptr;
+    QComboBox *m_regionCombo = nullptr;
+    QSpinBox *m_intervalSpin = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    QTimer *m_pollTimer = nullptr;
+
+    std::shared_ptr<const ProcessMemoryReader> m_reader;
+    bool m_pollInFlight = false;
+    bool m_pollPending = false;
+    quint64 m_generation = 0; // bumped on attach/detach to drop stale polls
+};
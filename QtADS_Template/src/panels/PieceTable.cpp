@@ -0,0 +1,744 @@
+#include "PieceTable.h"
+
+#include <QFile>
+#include <QIODevice>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PIECE_TABLE_SSE2 1
+#endif
+
+namespace
+{
+// Saving writes at most this much per call
+constexpr qint64 WriteChunkBytes = 1024 * 1024;
+
+// An estimated line start is moved to the next '\n' within this distance
+constexpr qint64 EstimateSnapBytes = 64 * 1024;
+
+qint64 blocksOf(qint64 size)
+{
+    return (size + LineBlockSize - 1) / LineBlockSize;
+}
+
+// Offset of the (n+1)-th '\n' in [data, data + size); there must be one
+const char *nthBreak(const char *data, qint64 size, qint64 n)
+{
+    const char *end = data + size;
+    const char *p = data;
+    for (;;)
+    {
+        p = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        if (n-- == 0)
+            return p;
+        ++p;
+    }
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TextSource
+// ---------------------------------------------------------------------------
+std::shared_ptr<TextSource> TextSource::open(const QString &fileName, QString *errorString)
+{
+    std::shared_ptr<TextSource> source(new TextSource);
+    source->m_fileName = fileName;
+    source->m_file = std::make_unique<QFile>(fileName);
+    if (!source->m_file->open(QIODevice::ReadOnly))
+    {
+        if (errorString)
+            *errorString = source->m_file->errorString();
+        return nullptr;
+    }
+
+    source->m_size = source->m_file->size();
+    if (source->m_size > 0)
+    {
+        source->m_data = reinterpret_cast<const char *>(source->m_file->map(0, source->m_size));
+        if (!source->m_data)
+        {
+            // Sequential devices and some file systems cannot be mapped
+            source->m_buffer = source->m_file->readAll();
+            source->m_size = source->m_buffer.size();
+            source->m_data = source->m_buffer.constData();
+        }
+    }
+    return source;
+}
+
+std::shared_ptr<TextSource> TextSource::fromData(const QByteArray &data)
+{
+    std::shared_ptr<TextSource> source(new TextSource);
+    source->m_buffer = data;
+    source->m_data = source->m_buffer.constData();
+    source->m_size = source->m_buffer.size();
+    return source;
+}
+
+// Closing the QFile also releases the mapping
+TextSource::~TextSource() = default;
+
+// ---------------------------------------------------------------------------
+// Line breaks
+// ---------------------------------------------------------------------------
+qint64 countLineBreaks(const char *data, qint64 size)
+{
+    qint64 count = 0;
+    qint64 i = 0;
+#if defined(PIECE_TABLE_SSE2)
+    const __m128i newline = _mm_set1_epi8('\n');
+    const auto matches = [&newline](const char *p) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        return quint64(quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline))));
+    };
+    for (; i + 64 <= size; i += 64)
+    {
+        const quint64 mask = matches(data + i) | matches(data + i + 16) << 16 | matches(data + i + 32) << 32
+                             | matches(data + i + 48) << 48;
+        count += qPopulationCount(mask);
+    }
+#endif
+    return count + std::count(data + i, data + size, '\n');
+}
+
+std::vector<quint32> indexLineBlocks(const TextSource &source, const std::atomic_bool &cancelled)
+{
+    std::vector<quint32> counts;
+    counts.reserve(size_t((source.size() + LineBlockSize - 1) / LineBlockSize));
+    for (qint64 offset = 0; offset < source.size(); offset += LineBlockSize)
+    {
+        if (cancelled.load(std::memory_order_relaxed))
+            return {};
+        const qint64 length = qMin(LineBlockSize, source.size() - offset);
+        counts.push_back(quint32(countLineBreaks(source.data() + offset, length)));
+    }
+    return counts;
+}
+
+// ---------------------------------------------------------------------------
+// LineIndex
+// ---------------------------------------------------------------------------
+LineIndex::LineIndex(std::shared_ptr<TextSource> source)
+    : m_source(std::move(source))
+    , m_blockCount(blocksOf(m_source->size()))
+    , m_breaks(new qint64[size_t(m_blockCount) + 1])
+{
+    m_breaks[0] = 0;
+}
+
+double LineIndex::breaksPerByte() const
+{
+    const qint64 indexed = indexedBlocks();
+    const qint64 indexedBytes = qMin(m_source->size(), indexed * LineBlockSize);
+    return m_breaks[size_t(indexed)] > 0 ? double(m_breaks[size_t(indexed)]) / double(indexedBytes) : 1.0 / 80;
+}
+
+bool LineIndex::indexTo(qint64 blocks, const std::atomic_bool *cancelled)
+{
+    blocks = qMin(blocks, m_blockCount);
+    // One block per turn, so a query on the GUI thread never waits for more
+    while (indexedBlocks() < blocks)
+    {
+        if (cancelled && cancelled->load(std::memory_order_relaxed))
+            return false;
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        const qint64 block = m_indexed.load(std::memory_order_relaxed);
+        if (block >= blocks)
+            break;
+        const qint64 offset = block * LineBlockSize;
+        const qint64 length = qMin(LineBlockSize, m_source->size() - offset);
+        m_breaks[size_t(block) + 1] = m_breaks[size_t(block)] + countLineBreaks(m_source->data() + offset, length);
+        m_indexed.store(block + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+bool LineIndex::assign(const std::vector<quint32> &counts)
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (qint64(counts.size()) != m_blockCount || m_indexed.load(std::memory_order_relaxed) != 0)
+        return false;
+    for (size_t i = 0; i < counts.size(); ++i)
+        m_breaks[i + 1] = m_breaks[i] + counts[i];
+    m_indexed.store(m_blockCount, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// PieceTable
+// ---------------------------------------------------------------------------
+PieceTable::PieceTable(std::shared_ptr<TextSource> original)
+    : m_original(original ? std::move(original) : TextSource::fromData(QByteArray()))
+    , m_size(m_original->size())
+{
+    m_lineIndex = std::make_shared<LineIndex>(m_original);
+    if (m_size > 0)
+        m_pieces.push_back(Piece{false, 0, m_size, -1});
+}
+
+PieceTable PieceTable::snapshot() const
+{
+    PieceTable copy;
+    copy.m_original = m_original;
+    copy.m_lineIndex = m_lineIndex;
+    copy.m_added = m_added;
+    copy.m_pieces = m_pieces;
+    copy.m_size = m_size;
+    return copy;
+}
+
+const char *PieceTable::pieceData(const Piece &piece) const
+{
+    return (piece.added ? m_added.constData() : m_original->data()) + piece.start;
+}
+
+QByteArray PieceTable::read(qint64 offset, qint64 length) const
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    length = qBound<qint64>(0, length, m_size - offset);
+    QByteArray bytes;
+    bytes.reserve(length);
+    qint64 position = 0;
+    for (const Piece &piece : m_pieces)
+    {
+        if (bytes.size() == length)
+            break;
+        const qint64 end = position + piece.length;
+        if (end > offset)
+        {
+            const qint64 from = qMax(offset, position) - position;
+            bytes.append(pieceData(piece) + from, qMin(piece.length - from, length - bytes.size()));
+        }
+        position = end;
+    }
+    return bytes;
+}
+
+bool PieceTable::writeTo(QIODevice *device) const
+{
+    for (const Piece &piece : m_pieces)
+    {
+        for (qint64 done = 0; done < piece.length;)
+        {
+            const qint64 written = device->write(pieceData(piece) + done, qMin(WriteChunkBytes, piece.length - done));
+            if (written <= 0)
+                return false;
+            done += written;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Original line index
+// ---------------------------------------------------------------------------
+
+// False if that would take more than the budget
+bool PieceTable::indexBlocks(qint64 blockCount)
+{
+    const qint64 missing = blockCount - m_lineIndex->indexedBlocks();
+    if (missing <= 0)
+        return true;
+    if (m_indexBudget >= 0 && missing > m_indexBudget)
+        return false;
+    m_lineIndex->indexTo(blockCount);
+    return true;
+}
+
+void PieceTable::setLineBlocks(const std::vector<quint32> &counts)
+{
+    auto index = std::make_shared<LineIndex>(m_original);
+    if (index->assign(counts))
+        m_lineIndex = std::move(index);
+}
+
+// Past the budget, the part beyond the indexed blocks is estimated from
+// their line density and *exact is cleared
+qint64 PieceTable::originalBreaksBefore(qint64 offset, bool *exact)
+{
+    const qint64 block = offset / LineBlockSize;
+    if (!indexBlocks(block))
+    {
+        if (exact)
+            *exact = false;
+        const qint64 indexed = m_lineIndex->indexedBlocks();
+        return m_lineIndex->breaksBefore(indexed)
+               + qint64(double(offset - indexed * LineBlockSize) * m_lineIndex->breaksPerByte());
+    }
+    const qint64 blockStart = block * LineBlockSize;
+    return m_lineIndex->breaksBefore(block) + countLineBreaks(m_original->data() + blockStart, offset - blockStart);
+}
+
+// Offset of break n (0-based) of the original, or -1 if it is not before
+// limit. Indexes no further than the block holding limit, and no more
+// blocks than the budget; past that the offset is estimated.
+qint64 PieceTable::originalBreakOffset(qint64 n, qint64 limit)
+{
+    const LineIndex &index = *m_lineIndex;
+    qint64 spent = 0;
+    while (index.breaksBefore(index.indexedBlocks()) <= n)
+    {
+        const qint64 indexed = index.indexedBlocks();
+        if (indexed >= index.blockCount() || indexed * LineBlockSize >= limit)
+            return -1;
+        if (m_indexBudget >= 0 && spent++ >= m_indexBudget)
+            return estimatedBreakOffset(n, limit);
+        m_lineIndex->indexTo(indexed + 1);
+    }
+
+    // Last block with fewer than n breaks before it
+    qint64 low = 0;
+    qint64 high = index.indexedBlocks();
+    while (low < high)
+    {
+        const qint64 middle = (low + high + 1) / 2;
+        if (index.breaksBefore(middle) <= n)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    const qint64 block = low;
+    const qint64 blockStart = block * LineBlockSize;
+    const char *data = m_original->data();
+    const char *at = nthBreak(data + blockStart, qMin(LineBlockSize, m_original->size() - blockStart),
+                              n - index.breaksBefore(block));
+    const qint64 offset = at - data;
+    return offset < limit ? offset : -1;
+}
+
+// Where break n of the original would be if the rest had the line density
+// of the indexed part, moved to the next real '\n' if there is one close by
+qint64 PieceTable::estimatedBreakOffset(qint64 n, qint64 limit) const
+{
+    const LineIndex &index = *m_lineIndex;
+    const qint64 indexed = index.indexedBlocks();
+    const qint64 indexedEnd = qMin(m_original->size(), indexed * LineBlockSize);
+    const qint64 guess = indexedEnd + qint64(double(n - index.breaksBefore(indexed)) / index.breaksPerByte());
+    if (guess >= limit)
+        return -1;
+    const char *data = m_original->data();
+    const auto *at =
+        static_cast<const char *>(std::memchr(data + guess, '\n', size_t(qMin(limit, guess + EstimateSnapBytes) - guess)));
+    return at ? at - data : guess;
+}
+
+bool PieceTable::linesExactBefore(qint64 offset) const
+{
+    const qint64 indexed = m_lineIndex->indexedBlocks();
+    qint64 position = 0;
+    for (const Piece &piece : m_pieces)
+    {
+        if (position >= offset)
+            break;
+        const qint64 within = qMin(piece.length, offset - position);
+        const bool counted = within == piece.length && piece.breaks >= 0;
+        if (!piece.added && !counted && (piece.start + within) / LineBlockSize > indexed)
+            return false;
+        position += piece.length;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Lines
+// ---------------------------------------------------------------------------
+// Estimated counts are returned but not kept
+qint64 PieceTable::pieceBreaks(Piece &piece)
+{
+    if (piece.breaks >= 0)
+        return piece.breaks;
+    if (piece.added)
+    {
+        piece.breaks = countLineBreaks(pieceData(piece), piece.length);
+        return piece.breaks;
+    }
+    bool exact = true;
+    const qint64 breaks =
+        qMax<qint64>(0, originalBreaksBefore(piece.start + piece.length, &exact) - originalBreaksBefore(piece.start, &exact));
+    if (exact)
+        piece.breaks = breaks;
+    return breaks;
+}
+
+// Exact even past the index budget: pieces an edit moves are counted
+// byte by byte where the index does not reach, which costs no more than
+// the edit itself
+qint64 PieceTable::editedPieceBreaks(Piece &piece)
+{
+    if (piece.breaks < 0 && !piece.added
+        && (piece.start + piece.length) / LineBlockSize > m_lineIndex->indexedBlocks())
+        piece.breaks = countLineBreaks(pieceData(piece), piece.length);
+    return pieceBreaks(piece);
+}
+
+// Document offset of break n (0-based), or -1
+qint64 PieceTable::breakOffset(qint64 n)
+{
+    qint64 before = 0;
+    qint64 position = 0;
+    for (Piece &piece : m_pieces)
+    {
+        if (!piece.added)
+        {
+            // Probe first, so a large piece is indexed only up to the break
+            const qint64 at =
+                originalBreakOffset(originalBreaksBefore(piece.start) + n - before, piece.start + piece.length);
+            if (at >= 0)
+                return position + at - piece.start;
+        }
+        else if (n < before + pieceBreaks(piece))
+        {
+            return position + (nthBreak(pieceData(piece), piece.length, n - before) - pieceData(piece));
+        }
+        before += pieceBreaks(piece);
+        position += piece.length;
+    }
+    return -1;
+}
+
+qint64 PieceTable::lineCount()
+{
+    qint64 breaks = 0;
+    for (Piece &piece : m_pieces)
+        breaks += pieceBreaks(piece);
+    return breaks + 1;
+}
+
+bool PieceTable::isLineCountKnown() const
+{
+    return m_lineIndex->isComplete()
+           || std::all_of(m_pieces.begin(), m_pieces.end(), [](const Piece &piece) { return piece.breaks >= 0; });
+}
+
+qint64 PieceTable::estimatedLineCount() const
+{
+    qint64 knownBreaks = 0;
+    qint64 unknownBytes = 0;
+    for (const Piece &piece : m_pieces)
+    {
+        if (piece.breaks >= 0)
+            knownBreaks += piece.breaks;
+        else
+            unknownBytes += piece.length;
+    }
+    // Extrapolate from the indexed part of the original
+    return knownBreaks + qint64(double(unknownBytes) * m_lineIndex->breaksPerByte()) + 1;
+}
+
+qint64 PieceTable::lineStart(qint64 line)
+{
+    if (line <= 0)
+        return line == 0 ? 0 : -1;
+    const qint64 at = breakOffset(line - 1);
+    return at < 0 ? -1 : at + 1;
+}
+
+qint64 PieceTable::lineEnd(qint64 line)
+{
+    if (line < 0)
+        return -1;
+    const qint64 at = breakOffset(line);
+    if (at >= 0)
+        return at;
+    return lineStart(line) < 0 ? -1 : m_size;
+}
+
+qint64 PieceTable::lineStartAt(qint64 offset, qint64 maxBytes) const
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    const qint64 limit = qMax<qint64>(0, offset - maxBytes);
+
+    // The piece holding the byte before offset, then backwards from there
+    size_t i = 0;
+    qint64 position = 0;
+    while (i < m_pieces.size() && position + m_pieces[i].length < offset)
+    {
+        position += m_pieces[i].length;
+        ++i;
+    }
+    for (qint64 to = offset; to > limit && i < m_pieces.size();)
+    {
+        const char *data = pieceData(m_pieces[i]);
+        const qint64 from = qMax(position, limit);
+        for (qint64 k = to - position; k > from - position; --k)
+        {
+            if (data[k - 1] == '\n')
+                return position + k;
+        }
+        to = from;
+        if (i == 0)
+            break;
+        --i;
+        position -= m_pieces[i].length;
+    }
+    return limit;
+}
+
+qint64 PieceTable::lineEndAt(qint64 offset, qint64 maxBytes) const
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    const qint64 limit = qMin(m_size, offset + maxBytes);
+    qint64 position = 0;
+    for (const Piece &piece : m_pieces)
+    {
+        if (position >= limit)
+            break;
+        const qint64 end = position + piece.length;
+        if (end > offset)
+        {
+            const qint64 from = qMax(offset, position);
+            const char *data = pieceData(piece);
+            const auto *at = static_cast<const char *>(
+                std::memchr(data + (from - position), '\n', size_t(qMin(end, limit) - from)));
+            if (at)
+                return position + (at - data);
+        }
+        position = end;
+    }
+    return limit == m_size ? m_size : -1;
+}
+
+qint64 PieceTable::lineOfOffset(qint64 offset)
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    qint64 line = 0;
+    qint64 position = 0;
+    for (Piece &piece : m_pieces)
+    {
+        if (offset < position + piece.length)
+        {
+            const qint64 within = offset - position;
+            return line + (piece.added ? countLineBreaks(pieceData(piece), within)
+                                       : originalBreaksBefore(piece.start + within)
+                                             - originalBreaksBefore(piece.start));
+        }
+        line += pieceBreaks(piece);
+        position += piece.length;
+    }
+    return line;
+}
+
+qint64 PieceTable::knownLineOfOffset(qint64 offset, bool *exact)
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    *exact = true;
+    qint64 line = 0;
+    qint64 position = 0;
+    for (Piece &piece : m_pieces)
+    {
+        const qint64 within = qMin(piece.length, offset - position);
+        if (within <= 0)
+            break;
+        if (piece.added || (within == piece.length && piece.breaks >= 0))
+        {
+            line += within == piece.length ? pieceBreaks(piece) : countLineBreaks(pieceData(piece), within);
+        }
+        else
+        {
+            // Up to where the index reaches, if the budget does not take it
+            // to offset
+            qint64 end = piece.start + within;
+            if (!indexBlocks(end / LineBlockSize))
+            {
+                *exact = false;
+                end = qMin(end, m_lineIndex->indexedBlocks() * LineBlockSize);
+                if (end <= piece.start)
+                    return line;
+            }
+            const qint64 breaks = originalBreaksBefore(end) - originalBreaksBefore(piece.start);
+            if (!*exact)
+                return line + breaks;
+            if (within == piece.length)
+                piece.breaks = breaks;
+            line += breaks;
+        }
+        position += piece.length;
+    }
+    return line;
+}
+
+// ---------------------------------------------------------------------------
+// Editing
+// ---------------------------------------------------------------------------
+size_t PieceTable::splitAt(qint64 offset)
+{
+    qint64 position = 0;
+    for (size_t i = 0; i < m_pieces.size(); ++i)
+    {
+        if (position == offset)
+            return i;
+        const Piece piece = m_pieces[i];
+        if (offset < position + piece.length)
+        {
+            const qint64 head = offset - position;
+            m_pieces[i] = Piece{piece.added, piece.start, head, -1};
+            m_pieces.insert(m_pieces.begin() + qptrdiff(i) + 1,
+                            Piece{piece.added, piece.start + head, piece.length - head, -1});
+            return i + 1;
+        }
+        position += piece.length;
+    }
+    return m_pieces.size();
+}
+
+// Replaces [offset, offset + length) with pieces and returns what was there
+std::vector<PieceTable::Piece> PieceTable::splice(qint64 offset, qint64 length, const std::vector<Piece> &pieces)
+{
+    const size_t first = splitAt(offset);
+    const size_t last = splitAt(offset + length);
+    std::vector<Piece> removed(m_pieces.begin() + qptrdiff(first), m_pieces.begin() + qptrdiff(last));
+    m_pieces.erase(m_pieces.begin() + qptrdiff(first), m_pieces.begin() + qptrdiff(last));
+    m_pieces.insert(m_pieces.begin() + qptrdiff(first), pieces.begin(), pieces.end());
+
+    ++m_editCount;
+    m_lastChange = Change{offset, 0, 0};
+    for (Piece &piece : removed)
+        m_lastChange.removedBreaks += editedPieceBreaks(piece);
+    m_size -= length;
+    for (size_t i = first; i < first + pieces.size(); ++i)
+    {
+        m_lastChange.insertedBreaks += editedPieceBreaks(m_pieces[i]);
+        m_size += m_pieces[i].length;
+    }
+    return removed;
+}
+
+void PieceTable::pushEdit(Edit edit)
+{
+    // The saved state was undone and is now overwritten
+    if (m_cleanDepth > qint64(m_undo.size()))
+        m_cleanDepth = -1;
+    m_undo.push_back(std::move(edit));
+    m_redo.clear();
+}
+
+void PieceTable::insert(qint64 offset, const QByteArray &text)
+{
+    if (text.isEmpty())
+        return;
+    offset = qBound<qint64>(0, offset, m_size);
+    const qint64 length = text.size();
+    const qint64 breaks = countLineBreaks(text.constData(), length);
+
+    // Typing right after the last insert grows its piece and its record;
+    // a line break ends the group
+    if (!m_undo.empty())
+    {
+        Edit &last = m_undo.back();
+        if (last.open && last.removed.empty() && last.inserted.size() == 1)
+        {
+            Piece &typed = last.inserted.front();
+            if (typed.added && typed.start + typed.length == m_added.size() && last.offset + typed.length == offset)
+            {
+                qint64 position = 0;
+                for (Piece &piece : m_pieces)
+                {
+                    position += piece.length;
+                    if (position < offset)
+                        continue;
+                    if (position == offset && piece.added && piece.start == typed.start)
+                    {
+                        m_added.append(text);
+                        piece.length += length;
+                        piece.breaks = pieceBreaks(piece) + breaks;
+                        typed = piece;
+                        last.open = breaks == 0;
+                        m_size += length;
+                        ++m_editCount;
+                        m_lastChange = Change{offset, 0, breaks};
+                        m_redo.clear();
+                        return;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    const Piece piece{true, qint64(m_added.size()), length, breaks};
+    m_added.append(text);
+    splice(offset, 0, {piece});
+    pushEdit(Edit{offset, {}, {piece}, breaks == 0});
+}
+
+void PieceTable::remove(qint64 offset, qint64 length)
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    length = qBound<qint64>(0, length, m_size - offset);
+    if (length == 0)
+        return;
+    std::vector<Piece> removed = splice(offset, length, {});
+
+    // Repeated Backspace or Delete at one spot is one record
+    if (!m_undo.empty())
+    {
+        Edit &last = m_undo.back();
+        if (last.open && last.inserted.empty() && (offset + length == last.offset || offset == last.offset))
+        {
+            const auto at = offset == last.offset ? last.removed.end() : last.removed.begin();
+            last.removed.insert(at, removed.begin(), removed.end());
+            last.offset = offset;
+            m_redo.clear();
+            return;
+        }
+    }
+    pushEdit(Edit{offset, std::move(removed), {}, true});
+}
+
+void PieceTable::breakUndoGroup()
+{
+    if (!m_undo.empty())
+        m_undo.back().open = false;
+}
+
+qint64 PieceTable::undo()
+{
+    if (m_undo.empty())
+        return -1;
+    Edit edit = std::move(m_undo.back());
+    m_undo.pop_back();
+    edit.open = false;
+
+    qint64 insertedLength = 0;
+    for (const Piece &piece : edit.inserted)
+        insertedLength += piece.length;
+    const qint64 sizeBefore = m_size;
+    splice(edit.offset, insertedLength, edit.removed);
+    const qint64 caret = edit.offset + (m_size - sizeBefore) + insertedLength;
+    m_redo.push_back(std::move(edit));
+    return caret;
+}
+
+qint64 PieceTable::redo()
+{
+    if (m_redo.empty())
+        return -1;
+    Edit edit = std::move(m_redo.back());
+    m_redo.pop_back();
+
+    qint64 removedLength = 0;
+    for (const Piece &piece : edit.removed)
+        removedLength += piece.length;
+    const qint64 sizeBefore = m_size;
+    splice(edit.offset, removedLength, edit.inserted);
+    const qint64 caret = edit.offset + (m_size - sizeBefore) + removedLength;
+    m_undo.push_back(std::move(edit));
+    return caret;
+}
+
+void PieceTable::setUnmodified()
+{
+    breakUndoGroup();
+    m_cleanDepth = qint64(m_undo.size());
+}
+
+void PieceTable::setSaved(quint64 editCount)
+{
+    if (editCount == m_editCount)
+        setUnmodified();
+    else
+        m_cleanDepth = -1; // somewhere in the history, but where is not tracked
+}
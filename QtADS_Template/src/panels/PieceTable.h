@@ -0,0 +1,226 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class QFile;
+class QIODevice;
+
+// ---------------------------------------------------------------------------
+// Read-only original text of a document. Files are memory mapped when the
+// platform allows it, so opening costs nothing up front. Shared between the
+// buffer and in-flight line indexing jobs, which keep the mapping alive
+// until they finish.
+// ---------------------------------------------------------------------------
+class TextSource
+{
+public:
+    static std::shared_ptr<TextSource> open(const QString &fileName, QString *errorString = nullptr);
+    static std::shared_ptr<TextSource> fromData(const QByteArray &data);
+    ~TextSource();
+
+    QString fileName() const { return m_fileName; }
+    const char *data() const { return m_data; }
+    qint64 size() const { return m_size; }
+
+private:
+    TextSource() = default;
+
+    QString m_fileName;
+    std::unique_ptr<QFile> m_file;
+    QByteArray m_buffer; // used when mapping is not possible
+    const char *m_data = nullptr;
+    qint64 m_size = 0;
+};
+
+// The original is indexed in blocks of this many bytes
+constexpr qint64 LineBlockSize = 64 * 1024;
+
+// ---------------------------------------------------------------------------
+// Number of '\n' bytes in data. Uses SSE2 on x86, 64 bytes per iteration.
+// ---------------------------------------------------------------------------
+qint64 countLineBreaks(const char *data, qint64 size);
+
+// ---------------------------------------------------------------------------
+// Line breaks per LineBlockSize block of source, for
+// PieceTable::setLineBlocks(). Meant for a worker thread; returns an empty
+// vector if cancelled.
+// ---------------------------------------------------------------------------
+std::vector<quint32> indexLineBlocks(const TextSource &source, const std::atomic_bool &cancelled);
+
+// ---------------------------------------------------------------------------
+// Line breaks before each LineBlockSize block of a source, indexed from the
+// front. One instance is shared by a PieceTable, its snapshots and a
+// background job calling indexTo(): blocks are published one at a time, so
+// every reader uses the job's progress as soon as it is made. Reads never
+// lock; writers take turns block by block. 8 bytes per block.
+// ---------------------------------------------------------------------------
+class LineIndex
+{
+public:
+    explicit LineIndex(std::shared_ptr<TextSource> source);
+
+    qint64 blockCount() const { return m_blockCount; }
+    qint64 indexedBlocks() const { return m_indexed.load(std::memory_order_acquire); }
+    bool isComplete() const { return indexedBlocks() == m_blockCount; }
+
+    // block must not be past indexedBlocks()
+    qint64 breaksBefore(qint64 block) const { return m_breaks[size_t(block)]; }
+
+    // Of the indexed part; 1/80 before anything is indexed
+    double breaksPerByte() const;
+
+    // Indexes until at least blocks are done. Returns false if cancelled.
+    bool indexTo(qint64 blocks, const std::atomic_bool *cancelled = nullptr);
+
+    // All counts at once, from indexLineBlocks(); only before anything is indexed
+    bool assign(const std::vector<quint32> &counts);
+
+private:
+    std::shared_ptr<TextSource> m_source;
+    qint64 m_blockCount = 0;
+    std::unique_ptr<qint64[]> m_breaks; // before each block, plus the total
+    std::atomic<qint64> m_indexed{0};
+    std::mutex m_writeMutex;
+};
+
+// ---------------------------------------------------------------------------
+// Editable text as a piece table over the original and an append-only add
+// buffer. Offsets are in bytes of UTF-8 text; lines end at '\n'.
+//
+// Edits only split and splice the piece list, so they cost the same in a
+// 2 GB file as in a small one. Undo records keep the pieces an edit removed
+// and inserted, not the text: undo and redo splice them back. Typing and
+// repeated deletes at one spot extend the last record instead of adding
+// new ones, until breakUndoGroup().
+//
+// Lines are found through a LineIndex of the original, extended from the
+// front as far as a query needs, by a background job sharing it, or all at
+// once by setLineBlocks(). Added text is counted when it is inserted. Line
+// queries fill these caches and are therefore not const.
+//
+// On the GUI thread, setIndexBudget() bounds what one query indexes itself:
+// past that, line numbers and line starts beyond the indexed part are
+// estimated from its line density until the background job gets there.
+// lineStartAt() and lineEndAt() need no index at all.
+// ---------------------------------------------------------------------------
+class PieceTable
+{
+public:
+    // Lines the last insert, remove, undo or redo replaced: the line of
+    // offset, then removedBreaks lines after it by insertedBreaks new ones
+    struct Change
+    {
+        qint64 offset = 0;
+        qint64 removedBreaks = 0;
+        qint64 insertedBreaks = 0;
+    };
+
+    explicit PieceTable(std::shared_ptr<TextSource> original = nullptr);
+
+    // Same text and shared line index without the undo history and the
+    // index budget, for worker threads
+    PieceTable snapshot() const;
+
+    std::shared_ptr<TextSource> original() const { return m_original; }
+    qint64 size() const { return m_size; }
+    int pieceCount() const { return int(m_pieces.size()); }
+    QByteArray read(qint64 offset, qint64 length) const;
+    bool writeTo(QIODevice *device) const;
+
+    // Lines
+    qint64 lineCount();
+    bool isLineCountKnown() const;
+    qint64 estimatedLineCount() const; // without indexing anything
+    qint64 lineStart(qint64 line);     // -1 past the last line
+    qint64 lineEnd(qint64 line);       // offset of its '\n', or size(); -1 past the last line
+    qint64 lineOfOffset(qint64 offset);
+    // lineOfOffset() if it is exact within the index budget; otherwise the
+    // last line known to start before offset, with *exact cleared
+    qint64 knownLineOfOffset(qint64 offset, bool *exact);
+    void setLineBlocks(const std::vector<quint32> &counts);
+    std::shared_ptr<LineIndex> lineIndex() const { return m_lineIndex; }
+
+    // Most blocks one line query indexes on the calling thread; -1, the
+    // default, for exact answers whatever they cost
+    void setIndexBudget(qint64 blocks) { m_indexBudget = blocks; }
+    // True if lineOfOffset() is exact, not estimated, up to offset
+    bool linesExactBefore(qint64 offset) const;
+
+    // Line around offset by scanning the text, without the line index:
+    // lineStartAt() looks back at most maxBytes and returns offset - maxBytes
+    // if it finds no '\n'; lineEndAt() returns the offset of the next '\n',
+    // size() at the end of the text, or -1 if neither is within maxBytes
+    qint64 lineStartAt(qint64 offset, qint64 maxBytes) const;
+    qint64 lineEndAt(qint64 offset, qint64 maxBytes) const;
+
+    // Editing
+    void insert(qint64 offset, const QByteArray &text);
+    void remove(qint64 offset, qint64 length);
+    void breakUndoGroup();
+    bool canUndo() const { return !m_undo.empty(); }
+    bool canRedo() const { return !m_redo.empty(); }
+    qint64 undo(); // offset after the restored text, or -1
+    qint64 redo(); // offset after the reapplied text, or -1
+    const Change &lastChange() const { return m_lastChange; }
+
+    bool isModified() const { return qint64(m_undo.size()) != m_cleanDepth; }
+    void setUnmodified();
+
+    // Grows with every change of the text
+    quint64 editCount() const { return m_editCount; }
+    // The text as of editCount was saved: unmodified if it has not changed since
+    void setSaved(quint64 editCount);
+
+private:
+    struct Piece
+    {
+        bool added = false;
+        qint64 start = 0;
+        qint64 length = 0;
+        qint64 breaks = -1; // '\n' count, -1 until needed
+    };
+
+    struct Edit
+    {
+        qint64 offset = 0;
+        std::vector<Piece> removed;
+        std::vector<Piece> inserted;
+        bool open = true; // typing may still extend it
+    };
+
+    const char *pieceData(const Piece &piece) const;
+    qint64 pieceBreaks(Piece &piece);
+    qint64 editedPieceBreaks(Piece &piece);
+    qint64 breakOffset(qint64 n);
+
+    // Original line index
+    bool indexBlocks(qint64 blockCount);
+    qint64 originalBreaksBefore(qint64 offset, bool *exact = nullptr);
+    qint64 originalBreakOffset(qint64 n, qint64 limit);
+    qint64 estimatedBreakOffset(qint64 n, qint64 limit) const;
+
+    size_t splitAt(qint64 offset);
+    std::vector<Piece> splice(qint64 offset, qint64 length, const std::vector<Piece> &pieces);
+    void pushEdit(Edit edit);
+
+    std::shared_ptr<TextSource> m_original;
+    QByteArray m_added;
+    std::vector<Piece> m_pieces;
+    qint64 m_size = 0;
+
+    std::shared_ptr<LineIndex> m_lineIndex;
+    qint64 m_indexBudget = -1;
+
+    std::vector<Edit> m_undo;
+    std::vector<Edit> m_redo;
+    Change m_lastChange;
+    qint64 m_cleanDepth = 0; // undo depth of the saved state, -1 if unreachable
+    quint64 m_editCount = 0;
+};
@@ -0,0 +1,162 @@
+#include "ProcessMemoryReader.h"
+
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MEMORY_DIFF_SSE2 1
+#endif
+
+ProcessMemoryReader::ProcessMemoryReader(qint64 pid)
+    : m_pid(pid)
+{
+#if defined(Q_OS_LINUX)
+    if (pid <= 0)
+    {
+        m_errorString = QStringLiteral("Invalid process id");
+        return;
+    }
+    if (::kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH)
+    {
+        m_errorString = QStringLiteral("No such process");
+        return;
+    }
+
+    // Keep /proc/<pid>/mem open as the fallback path; failing to open it is
+    // only fatal if process_vm_readv() does not work either.
+    const QByteArray memPath = QStringLiteral("/proc/%1/mem").arg(pid).toLocal8Bit();
+    m_memFd = ::open(memPath.constData(), O_RDONLY | O_CLOEXEC);
+    const int openErrno = errno;
+
+    uchar probe = 0;
+    iovec local{&probe, 1};
+    iovec remote{nullptr, 1};
+    const bool syscallUsable = ::process_vm_readv(static_cast<pid_t>(pid), &local, 1, &remote, 1, 0) >= 0
+                               || (errno != ENOSYS && errno != EPERM);
+    if (!syscallUsable && m_memFd < 0)
+    {
+        m_errorString = QString::fromLocal8Bit(std::strerror(openErrno));
+        return;
+    }
+    m_valid = true;
+#else
+    m_errorString = QStringLiteral("Reading process memory is only supported on Linux");
+#endif
+}
+
+ProcessMemoryReader::~ProcessMemoryReader()
+{
+#if defined(Q_OS_LINUX)
+    if (m_memFd >= 0)
+        ::close(m_memFd);
+#endif
+}
+
+quint64 ProcessMemoryReader::pageSize()
+{
+#if defined(Q_OS_LINUX)
+    static const quint64 size = quint64(::sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+bool ProcessMemoryReader::readPage(quint64 pageAddress, uchar *buffer) const
+{
+#if defined(Q_OS_LINUX)
+    if (!m_valid)
+        return false;
+
+    const size_t size = size_t(pageSize());
+    iovec local{buffer, size};
+    iovec remote{reinterpret_cast<void *>(quintptr(pageAddress)), size};
+    const ssize_t n = ::process_vm_readv(static_cast<pid_t>(m_pid), &local, 1, &remote, 1, 0);
+    if (n == ssize_t(size))
+        return true;
+    // EFAULT/partial read means an unmapped or guard page; only retry through
+    // /proc for errors that say the syscall itself is unusable
+    if (n >= 0 || (errno != ENOSYS && errno != EPERM) || m_memFd < 0)
+        return false;
+
+    return ::pread(m_memFd, buffer, size, off_t(pageAddress)) == ssize_t(size);
+#else
+    Q_UNUSED(pageAddress);
+    Q_UNUSED(buffer);
+    return false;
+#endif
+}
+
+QVector<MemoryRegion> ProcessMemoryReader::regions() const
+{
+    QVector<MemoryRegion> result;
+    QFile maps(QStringLiteral("/proc/%1/maps").arg(m_pid));
+    if (!maps.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+
+    // Format: start-end perms offset dev inode [path]
+    QTextStream stream(&maps);
+    QString line;
+    while (stream.readLineInto(&line))
+    {
+        const QStringList fields = line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        if (fields.size() < 5)
+            continue;
+        const int dash = fields[0].indexOf(QLatin1Char('-'));
+        if (dash < 0)
+            continue;
+
+        MemoryRegion region;
+        region.start = fields[0].left(dash).toULongLong(nullptr, 16);
+        region.end = fields[0].mid(dash + 1).toULongLong(nullptr, 16);
+        region.permissions = fields[1];
+        region.name = fields.mid(5).join(QLatin1Char(' '));
+        result.append(region);
+    }
+    return result;
+}
+
+int diffBytes(const uchar *previous, const uchar *current, qsizetype length, uchar *changedBits)
+{
+    std::memset(changedBits, 0, size_t((length + 7) / 8));
+    if (std::memcmp(previous, current, size_t(length)) == 0)
+        return 0;
+
+    int changed = 0;
+    qsizetype i = 0;
+#if defined(MEMORY_DIFF_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current + i));
+        const quint32 mask = ~quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & 0xFFFFu;
+        if (!mask)
+            continue;
+        changedBits[i / 8] = uchar(mask & 0xFF);
+        changedBits[i / 8 + 1] = uchar(mask >> 8);
+        changed += qPopulationCount(mask);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        if (previous[i] != current[i])
+        {
+            changedBits[i / 8] |= uchar(1u << (i % 8));
+            ++changed;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// ---------------------------------------------------------------------------
+// One mapping from /proc/<pid>/maps
+// ---------------------------------------------------------------------------
+struct MemoryRegion
+{
+    quint64 start = 0;
+    quint64 end = 0;
+    QString permissions; // e.g. "r-xp"
+    QString name;        // backing file, [heap], [stack], ...
+
+    bool isReadable() const { return permissions.startsWith(QLatin1Char('r')); }
+};
+
+// ---------------------------------------------------------------------------
+// Page-granular reader for the memory of another local process.
+//
+// Reads go through process_vm_readv(), falling back to pread() on
+// /proc/<pid>/mem when the syscall is unavailable. Both need ptrace access
+// to the target (same user and a permissive ptrace_scope, or CAP_SYS_PTRACE).
+// The reader holds no mutable state after construction, so one instance may
+// be used from several threads. Only Linux is supported; on other platforms
+// isValid() is always false.
+// ---------------------------------------------------------------------------
+class ProcessMemoryReader
+{
+public:
+    explicit ProcessMemoryReader(qint64 pid);
+    ~ProcessMemoryReader();
+
+    ProcessMemoryReader(const ProcessMemoryReader &) = delete;
+    ProcessMemoryReader &operator=(const ProcessMemoryReader &) = delete;
+
+    bool isValid() const { return m_valid; }
+    QString errorString() const { return m_errorString; }
+    qint64 pid() const { return m_pid; }
+
+    static quint64 pageSize();
+
+    // Reads the page starting at pageAddress into buffer (pageSize() bytes).
+    // Returns false if any part of the page is unmapped or unreadable.
+    bool readPage(quint64 pageAddress, uchar *buffer) const;
+
+    // Current mappings of the target, re-read on every call
+    QVector<MemoryRegion> regions() const;
+
+private:
+    qint64 m_pid = 0;
+    int m_memFd = -1;
+    bool m_valid = false;
+    QString m_errorString;
+};
+
+// ---------------------------------------------------------------------------
+// Compares two buffers and sets bit i of changedBits (LSB first) for every
+// byte i that differs. changedBits must hold (length + 7) / 8 bytes.
+// Uses SSE2 compares on x86. Returns the number of changed bytes.
+// ---------------------------------------------------------------------------
+int diffBytes(const uchar *previous, const uchar *current, qsizetype length, uchar *changedBits);
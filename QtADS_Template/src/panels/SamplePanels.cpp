@@ -1,10 +1,24 @@
 #include "SamplePanels.h"
+#include "BuildOutputPanel.h"
+#include "ClassViewPanel.h"
+#include "HexEditorPanel.h"
+#include "MemoryPanel.h"
+#include "SearchResultsPanel.h"
+#include "TerminalPanel.h"
+#include "TextEditorPanel.h"
+#include "TodoListPanel.h"
 #include <PanelRegistry.h>
+#include <ColumnarTableModel.h>
+#include <ColumnarItemDelegate.h>
+#include <LazyTreeModel.h>
+#include <FileSystemIndex.h>
 
 #include <QLabel>
+#include <QLineEdit>
 #include <QTextEdit>
-#include <QTreeWidget>
-#include <QTableWidget>
+#include <QTreeView>
+#include <QDir>
+#include <QTableView>
 #include <QListWidget>
 #include <QVBoxLayout>
 #include <QHeaderView>
@@ -13,38 +27,107 @@
 #include <QFontDatabase>
 
 // ---------------------------------------------------------------------------
-// Helper: creates a QTreeWidget with sample items to represent tree-based panels
+// Helper: creates a lazily populated tree view over a provider. The provider
+// runs on worker threads and children load when a node is first expanded.
+// ---------------------------------------------------------------------------
+static QTreeView *makeLazyTreeView(QWidget *parent, std::shared_ptr<DockManager::LazyTreeProvider> provider,
+                                   const QStringList &headers)
+{
+    auto *tree = new QTreeView(parent);
+    tree->setUniformRowHeights(true);
+    auto *model = new DockManager::LazyTreeModel(std::move(provider), headers, tree);
+    tree->setModel(model);
+    model->bindView(tree);
+    return tree;
+}
+
+// ---------------------------------------------------------------------------
+// Helper: creates a tree with sample items to represent tree-based panels
 // ---------------------------------------------------------------------------
 static QWidget *makeTreePanel(QWidget *parent, const QString &title,
                               const QStringList &topItems,
                               const QStringList &childItems)
 {
-    auto *tree = new QTreeWidget(parent);
-    tree->setHeaderLabel(title);
-    for (const auto &top : topItems)
-    {
-        auto *item = new QTreeWidgetItem(tree, {top});
-        for (const auto &child : childItems)
-            new QTreeWidgetItem(item, {child});
-        item->setExpanded(true);
-    }
+    auto provider = std::make_shared<DockManager::FunctionTreeProvider>(
+        [topItems, childItems](const QStringList &path)
+        {
+            QVector<DockManager::LazyTreeItem> items;
+            for (const auto &text : path.isEmpty() ? topItems : childItems)
+                items.append(DockManager::LazyTreeItem{QString(), {text}, path.isEmpty()});
+            return items;
+        });
+    auto *tree = makeLazyTreeView(parent, std::move(provider), {title});
+
+    // Top-level items start expanded, as before
+    auto *model = static_cast<DockManager::LazyTreeModel *>(tree->model());
+    QObject::connect(model, &DockManager::LazyTreeModel::childrenLoaded, tree,
+                     [tree, model](const QModelIndex &parentIndex)
+                     {
+                         if (parentIndex.isValid())
+                             return;
+                         for (int row = 0; row < model->rowCount(); ++row)
+                             tree->expand(model->index(row, 0));
+                     });
     return tree;
 }
 
 // ---------------------------------------------------------------------------
-// Helper: creates a QTableWidget with sample columns
+// Helper: creates a file system tree. Panels over the same root share one
+// FileSystemIndex, so one crawl and one watcher set, and file system changes
+// arrive as batched row inserts and removals. An empty root lists the drives.
+// ---------------------------------------------------------------------------
+static QTreeView *makeFileSystemTreeView(QWidget *parent, const QString &rootPath, const QString &title)
+{
+    auto provider = std::make_shared<DockManager::FileSystemTreeProvider>(rootPath);
+    auto *tree = makeLazyTreeView(parent, provider, {title});
+    provider->bindModel(static_cast<DockManager::LazyTreeModel *>(tree->model()));
+    return tree;
+}
+
+// ---------------------------------------------------------------------------
+// Helper: creates a filterable table view over a columnar model with sample
+// columns. Cells are plain column storage, not QTableWidgetItems, and rows
+// have a fixed height so the view never measures them. Sorting and
+// filtering run in the model's background queries.
 // ---------------------------------------------------------------------------
 static QWidget *makeTablePanel(QWidget *parent, const QStringList &headers, int rows)
 {
-    auto *table = new QTableWidget(rows, headers.size(), parent);
-    table->setHorizontalHeaderLabels(headers);
-    table->horizontalHeader()->setStretchLastSection(true);
+    auto *panel = new QWidget(parent);
+    auto *layout = new QVBoxLayout(panel);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+
+    auto *filterEdit = new QLineEdit(panel);
+    filterEdit->setPlaceholderText("Filter (text, or = != < <= > >= value)");
+    filterEdit->setClearButtonEnabled(true);
+    layout->addWidget(filterEdit);
+
+    auto *view = new QTableView(panel);
+    layout->addWidget(view);
+    auto *model = new DockManager::ColumnarTableModel(
+        headers, QVector<DockManager::ColumnType>(headers.size(), DockManager::ColumnType::String), view);
+
+    DockManager::ColumnarTable table = model->createTable();
+    table.resize(rows);
     for (int r = 0; r < rows; ++r)
     {
         for (int c = 0; c < headers.size(); ++c)
-            table->setItem(r, c, new QTableWidgetItem(QString("--")));
+            table.setString(r, c, u"--");
     }
-    return table;
+    model->setTable(std::move(table));
+
+    view->setModel(model);
+    view->setItemDelegate(new DockManager::ColumnarItemDelegate(view));
+    view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    view->verticalHeader()->setDefaultSectionSize(view->fontMetrics().height() + 4);
+    view->horizontalHeader()->setStretchLastSection(true);
+    // Start unsorted; header clicks then call model->sort()
+    view->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    view->setSortingEnabled(true);
+
+    QObject::connect(filterEdit, &QLineEdit::textChanged, model,
+                     [model](const QString &text) { model->setFilter(-1, text); });
+    return panel;
 }
 
 // ---------------------------------------------------------------------------
@@ -80,27 +163,21 @@ void registerSamplePanels()
                        ads::LeftDockWidgetArea,
                        [](QWidget *p)
                        {
-                           return makeTreePanel(p, "Project",
-                                                {"src", "include", "tests", "resources"},
-                                                {"main.cpp", "widget.cpp", "utils.h"});
+                           return makeFileSystemTreeView(p, QDir::currentPath(), "Project");
                        }});
 
     reg.registerPanel({"file_browser", "File Browser", "Explorer",
                        ads::LeftDockWidgetArea,
                        [](QWidget *p)
                        {
-                           return makeTreePanel(p, "File System",
-                                                {"C:/", "Documents", "Projects"},
-                                                {"folder_a", "folder_b", "file.txt"});
+                           return makeFileSystemTreeView(p, QString(), "File System");
                        }});
 
     reg.registerPanel({"class_view", "Class View", "Explorer",
                        ads::LeftDockWidgetArea,
                        [](QWidget *p)
                        {
-                           return makeTreePanel(p, "Classes",
-                                                {"MainWindow", "PanelRegistry", "DockManager"},
-                                                {"method()", "signal()", "slot()"});
+                           return new ClassViewPanel(QDir::currentPath(), p);
                        }});
 
     // ===== Editor =====
@@ -108,30 +185,26 @@ void registerSamplePanels()
                        ads::CenterDockWidgetArea,
                        [](QWidget *p)
                        {
-                           auto *edit = new QTextEdit(p);
-                           edit->setPlaceholderText("// Write your code here...\n#include <iostream>\n\nint main() {\n    return 0;\n}");
-                           edit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
-                           return static_cast<QWidget *>(edit);
+                           auto *editor = new TextEditorPanel(p);
+                           editor->view()->setPlaceholderText("// Write your code here...\n#include <iostream>\n\nint main() {\n    return 0;\n}");
+                           editor->view()->setLineNumbersVisible(true);
+                           editor->view()->setSyntaxHighlighting(true);
+                           return static_cast<QWidget *>(editor);
                        }});
 
     reg.registerPanel({"text_editor", "Text Editor", "Editor",
                        ads::CenterDockWidgetArea,
                        [](QWidget *p)
                        {
-                           auto *edit = new QTextEdit(p);
-                           edit->setPlaceholderText("Plain text editor...");
-                           return static_cast<QWidget *>(edit);
+                           auto *editor = new TextEditorPanel(p);
+                           editor->view()->setPlaceholderText("Plain text editor...");
+                           return static_cast<QWidget *>(editor);
                        }});
 
     reg.registerPanel({"hex_editor", "Hex Editor", "Editor",
                        ads::CenterDockWidgetArea,
                        [](QWidget *p)
-                       {
-                           return makeTablePanel(p,
-                                                 {"Offset", "00", "01", "02", "03", "04", "05", "06", "07",
-                                                  "08", "09", "0A", "0B", "0C", "0D", "0E", "0F", "ASCII"},
-                                                 16);
-                       }});
+                       { return new HexEditorPanel(p); }});
 
     // ===== Output =====
     reg.registerPanel({"console_output", "Console", "Output",
@@ -142,7 +215,7 @@ void registerSamplePanels()
     reg.registerPanel({"build_output", "Build Output", "Output",
                        ads::BottomDockWidgetArea,
                        [](QWidget *p)
-                       { return makeOutputPanel(p, "Build output will appear here..."); }});
+                       { return new BuildOutputPanel(QDir::currentPath(), p); }});
 
     reg.registerPanel({"debug_output", "Debug Output", "Output",
                        ads::BottomDockWidgetArea,
@@ -157,12 +230,7 @@ void registerSamplePanels()
     reg.registerPanel({"terminal", "Terminal", "Output",
                        ads::BottomDockWidgetArea,
                        [](QWidget *p)
-                       {
-                           auto *edit = new QPlainTextEdit(p);
-                           edit->setPlaceholderText("$ ");
-                           edit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
-                           return static_cast<QWidget *>(edit);
-                       }});
+                       { return new TerminalPanel(p); }});
 
     // ===== Properties =====
     reg.registerPanel({"properties", "Properties", "Properties",
@@ -239,12 +307,7 @@ void registerSamplePanels()
     reg.registerPanel({"memory", "Memory", "Debug",
                        ads::BottomDockWidgetArea,
                        [](QWidget *p)
-                       {
-                           return makeTablePanel(p,
-                                                 {"Address", "00", "01", "02", "03", "04", "05", "06", "07",
-                                                  "08", "09", "0A", "0B", "0C", "0D", "0E", "0F"},
-                                                 16);
-                       }});
+                       { return new MemoryPanel(p); }});
 
     reg.registerPanel({"registers", "Registers", "Debug",
                        ads::RightDockWidgetArea,
@@ -258,9 +321,7 @@ void registerSamplePanels()
                        ads::BottomDockWidgetArea,
                        [](QWidget *p)
                        {
-                           return makeTreePanel(p, "Search Results",
-                                                {"main.cpp (3 hits)", "widget.cpp (1 hit)"},
-                                                {"Line 12: match", "Line 45: match"});
+                           return new SearchResultsPanel(p);
                        }});
 
     reg.registerPanel({"bookmarks", "Bookmarks", "Tools",
@@ -276,6 +337,6 @@ void registerSamplePanels()
                        ads::BottomDockWidgetArea,
                        [](QWidget *p)
                        {
-                           return makeTablePanel(p, {"File", "Line", "TODO Comment"}, 5);
+                           return new TodoListPanel(QDir::currentPath(), p);
                        }});
 }
@@ -0,0 +1,226 @@
+#include "SearchResultsPanel.h"
+
+#include <LazyTreeModel.h>
+
+#include <QCheckBox>
+#include <QCoreApplication>
+#include <QDir>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPointer>
+#include <QPushButton>
+#include <QThreadPool>
+#include <QTimer>
+#include <QTreeView>
+#include <QVBoxLayout>
+
+#include <mutex>
+
+namespace
+{
+// About two frames: often enough that first hits show up at once, rare
+// enough that a flood of matches is inserted in a few large batches
+constexpr int FlushIntervalMs = 30;
+} // namespace
+
+struct SearchResultsPanel::PendingResults
+{
+    std::mutex mutex;
+    QVector<SearchFileResult> files;
+};
+
+SearchResultsPanel::SearchResultsPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+
+    auto *controls = new QHBoxLayout;
+    controls->setContentsMargins(4, 4, 4, 0);
+    m_patternEdit = new QLineEdit(this);
+    m_patternEdit->setPlaceholderText(tr("Search in files"));
+    m_patternEdit->setClearButtonEnabled(true);
+    controls->addWidget(m_patternEdit, 2);
+    m_regexCheck = new QCheckBox(tr("Regex"), this);
+    controls->addWidget(m_regexCheck);
+    m_caseCheck = new QCheckBox(tr("Match case"), this);
+    controls->addWidget(m_caseCheck);
+    m_rootEdit = new QLineEdit(QDir::currentPath(), this);
+    m_rootEdit->setToolTip(tr("Folder to search"));
+    controls->addWidget(m_rootEdit, 1);
+    m_searchButton = new QPushButton(tr("Search"), this);
+    controls->addWidget(m_searchButton);
+    layout->addLayout(controls);
+
+    m_view = new QTreeView(this);
+    m_view->setUniformRowHeights(true);
+    m_model = new DockManager::LazyTreeModel(nullptr, {tr("Location"), tr("Text")}, m_view);
+    m_view->setModel(m_model);
+    m_view->header()->resizeSection(0, 280);
+    layout->addWidget(m_view, 1);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setContentsMargins(4, 0, 4, 4);
+    layout->addWidget(m_statusLabel);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(FlushIntervalMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &SearchResultsPanel::flushResults);
+
+    connect(m_patternEdit, &QLineEdit::returnPressed, this, &SearchResultsPanel::startSearch);
+    connect(m_rootEdit, &QLineEdit::returnPressed, this, &SearchResultsPanel::startSearch);
+    connect(m_searchButton, &QPushButton::clicked, this, [this]()
+    {
+        if (m_cancelled)
+            stopSearch();
+        else
+            startSearch();
+    });
+}
+
+SearchResultsPanel::~SearchResultsPanel()
+{
+    if (m_cancelled)
+        m_cancelled->store(true);
+}
+
+// ---------------------------------------------------------------------------
+// Search lifecycle
+// ---------------------------------------------------------------------------
+void SearchResultsPanel::startSearch()
+{
+    stopSearch();
+    m_model->refresh();
+    m_fileCount = 0;
+    m_hitCount = 0;
+    m_firstHitMs = -1;
+
+    SearchOptions options;
+    options.pattern = m_patternEdit->text();
+    options.regex = m_regexCheck->isChecked();
+    options.caseSensitive = m_caseCheck->isChecked();
+    options.rootPath = QDir::cleanPath(m_rootEdit->text());
+    if (options.pattern.isEmpty())
+    {
+        m_statusLabel->clear();
+        return;
+    }
+    m_rootPath = options.rootPath;
+
+    const quint64 generation = ++m_generation;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    auto pending = std::make_shared<PendingResults>();
+    m_cancelled = cancelled;
+    m_pending = pending;
+    m_elapsed.start();
+    m_flushTimer->start();
+    m_searchButton->setText(tr("Stop"));
+    updateStatus();
+
+    // searchTree() blocks while its own worker threads walk the tree
+    QPointer<SearchResultsPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, generation, options, cancelled, pending]()
+    {
+        const auto collect = [pending](SearchFileResult &&result)
+        {
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->files.append(std::move(result));
+        };
+        SearchStats stats;
+        const bool completed = searchTree(options, *cancelled, collect, &stats);
+
+        QMetaObject::invokeMethod(qApp, [guard, generation, completed, stats]()
+        {
+            if (guard)
+                guard->onSearchFinished(generation, completed, stats);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SearchResultsPanel::stopSearch()
+{
+    if (!m_cancelled)
+        return;
+    m_cancelled->store(true);
+    m_cancelled.reset();
+    // Keep what was found so far
+    flushResults();
+    m_pending.reset();
+    m_flushTimer->stop();
+    m_searchButton->setText(tr("Search"));
+    m_statusLabel->setText(tr("Stopped: %1 matches in %2 files").arg(m_hitCount).arg(m_fileCount));
+}
+
+void SearchResultsPanel::flushResults()
+{
+    if (!m_pending)
+        return;
+    QVector<SearchFileResult> files;
+    {
+        std::lock_guard<std::mutex> lock(m_pending->mutex);
+        files.swap(m_pending->files);
+    }
+    if (files.isEmpty())
+        return;
+
+    const QDir root(m_rootPath);
+    QVector<DockManager::LazyTreeItem> items;
+    items.reserve(files.size());
+    for (const SearchFileResult &file : std::as_const(files))
+    {
+        DockManager::LazyTreeItem item;
+        item.key = file.path;
+        item.columns = {root.relativeFilePath(file.path), tr("%n match(es)", nullptr, int(file.hits.size()))};
+        item.children.reserve(file.hits.size());
+        for (const SearchHit &hit : file.hits)
+        {
+            const QString location = QStringLiteral("%1:%2").arg(hit.line).arg(hit.column);
+            item.children.append(
+                DockManager::LazyTreeItem{location, {tr("Line %1").arg(hit.line), hit.text}, false, {}});
+        }
+        m_hitCount += file.hits.size();
+        items.append(std::move(item));
+    }
+    m_fileCount += files.size();
+    if (m_firstHitMs < 0)
+        m_firstHitMs = m_elapsed.elapsed();
+
+    // One rowsInserted for the whole batch
+    m_model->appendChildren(QModelIndex(), items);
+    if (m_cancelled)
+        updateStatus();
+}
+
+void SearchResultsPanel::onSearchFinished(quint64 generation, bool completed, const SearchStats &stats)
+{
+    if (generation != m_generation || !m_cancelled)
+        return;
+    m_cancelled.reset();
+    flushResults();
+    m_flushTimer->stop();
+    m_searchButton->setText(tr("Search"));
+
+    // A search stopped by the user never gets here, so this is a bad pattern
+    if (!completed)
+    {
+        m_statusLabel->setText(tr("Invalid search pattern"));
+        return;
+    }
+    QString status = tr("%1 matches in %2 files; searched %3 files (%4 MB) in %5 ms")
+                         .arg(m_hitCount)
+                         .arg(m_fileCount)
+                         .arg(stats.filesScanned)
+                         .arg(double(stats.bytesScanned) / (1024.0 * 1024.0), 0, 'f', 1)
+                         .arg(m_elapsed.elapsed());
+    if (m_firstHitMs >= 0)
+        status += tr(", first hit after %1 ms").arg(m_firstHitMs);
+    m_statusLabel->setText(status);
+}
+
+void SearchResultsPanel::updateStatus()
+{
+    m_statusLabel->setText(tr("Searching... %1 matches in %2 files").arg(m_hitCount).arg(m_fileCount));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ContentSearch.h"
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+namespace DockManager
+{
+class LazyTreeModel;
+}
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTimer;
+class QTreeView;
+
+// ---------------------------------------------------------------------------
+// Project-wide content search. searchTree() runs on the thread pool and
+// hands finished files to a pending list; a timer moves them into the tree
+// in batches, one file per top-level row with its hits below, so results
+// appear while the walk is still going.
+// ---------------------------------------------------------------------------
+class SearchResultsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SearchResultsPanel(QWidget *parent = nullptr);
+    ~SearchResultsPanel() override;
+
+private:
+    struct PendingResults;
+
+    void startSearch();
+    void stopSearch();
+    void flushResults();
+    void onSearchFinished(quint64 generation, bool completed, const SearchStats &stats);
+    void updateStatus();
+
+    QLineEdit *m_patternEdit = nullptr;
+    QLineEdit *m_rootEdit = nullptr;
+    QCheckBox *m_regexCheck = nullptr;
+    QCheckBox *m_caseCheck = nullptr;
+    QPushButton *m_searchButton = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    QTreeView *m_view = nullptr;
+    DockManager::LazyTreeModel *m_model = nullptr;
+    QTimer *m_flushTimer = nullptr;
+
+    std::shared_ptr<PendingResults> m_pending;
+    std::shared_ptr<std::atomic_bool> m_cancelled; // set while a search runs
+    quint64 m_generation = 0;
+    QString m_rootPath;
+
+    QElapsedTimer m_elapsed;
+    qint64 m_firstHitMs = -1;
+    qint64 m_fileCount = 0;
+    qint64 m_hitCount = 0;
+};
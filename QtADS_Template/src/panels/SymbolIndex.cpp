@@ -0,0 +1,1239 @@
+#include "SymbolIndex.h"
+#include "ContentSearch.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+// Bumped whenever the file layout or the lexer rules change
+constexpr quint32 IndexMagic = 0x58444953; // "SIDX"
+constexpr quint32 IndexVersion = 1;
+
+// Generated sources beyond this size are not worth lexing
+constexpr qint64 MaxSourceBytes = 16 * 1024 * 1024;
+
+// Statements longer than this are initializer tables, not declarations
+constexpr size_t MaxStatementTokens = 256;
+
+const char *const SourceSuffixes[] = {"h",   "hh",  "hpp", "hxx", "h++", "c",   "cc", "cpp",
+                                      "cxx", "c++", "inl", "ipp", "tpp", "ixx", "m",  "mm"};
+
+// ---------------------------------------------------------------------------
+// Lexer
+// ---------------------------------------------------------------------------
+enum class TokenType : quint8
+{
+    Identifier,
+    Punct,
+    Literal
+};
+
+struct Token
+{
+    const char *text = nullptr;
+    int length = 0;
+    int line = 0;
+    TokenType type = TokenType::Punct;
+
+    bool is(char c) const { return type == TokenType::Punct && length == 1 && *text == c; }
+    bool is(const char *word) const
+    {
+        return type == TokenType::Identifier && std::strncmp(text, word, size_t(length)) == 0 && word[length] == 0;
+    }
+    bool isScopeOperator() const { return type == TokenType::Punct && length == 2; }
+    QByteArray bytes() const { return QByteArray(text, length); }
+};
+
+bool isIdentifierStart(uchar c)
+{
+    return c == '_' || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c >= 0x80;
+}
+
+bool isIdentifierByte(uchar c)
+{
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+class Lexer
+{
+public:
+    Lexer(const char *data, qsizetype size)
+        : m_p(data)
+        , m_end(data + size)
+    {
+    }
+
+    bool next(Token *token)
+    {
+        while (m_p < m_end)
+        {
+            const uchar c = uchar(*m_p);
+            if (c == '\n')
+            {
+                ++m_line;
+                m_lineStart = true;
+                ++m_p;
+                continue;
+            }
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v')
+            {
+                ++m_p;
+                continue;
+            }
+            if (c == '/' && m_p + 1 < m_end && m_p[1] == '/')
+            {
+                skipLine();
+                continue;
+            }
+            if (c == '/' && m_p + 1 < m_end && m_p[1] == '*')
+            {
+                skipBlockComment();
+                continue;
+            }
+            if (c == '#' && m_lineStart)
+            {
+                skipDirective();
+                continue;
+            }
+
+            m_lineStart = false;
+            token->text = m_p;
+            token->line = m_line;
+            if (isIdentifierStart(c))
+            {
+                const char *begin = m_p;
+                while (m_p < m_end && isIdentifierByte(uchar(*m_p)))
+                    ++m_p;
+                if (m_p < m_end && (*m_p == '"' || *m_p == '\'') && isLiteralPrefix(begin, m_p))
+                {
+                    if (*m_p == '"' && m_p[-1] == 'R')
+                        skipRawString();
+                    else
+                        skipQuoted(*m_p);
+                    return finish(token, TokenType::Literal);
+                }
+                return finish(token, TokenType::Identifier);
+            }
+            if ((c >= '0' && c <= '9') || (c == '.' && m_p + 1 < m_end && m_p[1] >= '0' && m_p[1] <= '9'))
+            {
+                skipNumber();
+                return finish(token, TokenType::Literal);
+            }
+            if (c == '"' || c == '\'')
+            {
+                skipQuoted(char(c));
+                return finish(token, TokenType::Literal);
+            }
+            m_p += (c == ':' && m_p + 1 < m_end && m_p[1] == ':') ? 2 : 1;
+            return finish(token, TokenType::Punct);
+        }
+        return false;
+    }
+
+private:
+    bool finish(Token *token, TokenType type)
+    {
+        token->length = int(m_p - token->text);
+        token->type = type;
+        return true;
+    }
+
+    static bool isLiteralPrefix(const char *begin, const char *end)
+    {
+        const QByteArray prefix = QByteArray::fromRawData(begin, int(end - begin));
+        return prefix == "L" || prefix == "u" || prefix == "U" || prefix == "u8" || prefix == "R"
+               || prefix == "LR" || prefix == "uR" || prefix == "UR" || prefix == "u8R";
+    }
+
+    void skipLine()
+    {
+        const void *newline = std::memchr(m_p, '\n', size_t(m_end - m_p));
+        m_p = newline ? static_cast<const char *>(newline) : m_end;
+    }
+
+    void skipBlockComment()
+    {
+        for (m_p += 2; m_p < m_end; ++m_p)
+        {
+            if (*m_p == '\n')
+                ++m_line;
+            else if (*m_p == '*' && m_p + 1 < m_end && m_p[1] == '/')
+            {
+                m_p += 2;
+                return;
+            }
+        }
+    }
+
+    // Up to the end of the line, following backslash continuations
+    void skipDirective()
+    {
+        while (m_p < m_end)
+        {
+            if (*m_p == '\n')
+            {
+                const char *last = m_p - 1;
+                if (*last == '\r')
+                    --last;
+                if (*last != '\\')
+                    return;
+                ++m_line;
+                ++m_p;
+            }
+            else if (*m_p == '/' && m_p + 1 < m_end && m_p[1] == '*')
+                skipBlockComment();
+            else if (*m_p == '/' && m_p + 1 < m_end && m_p[1] == '/')
+                skipLine();
+            else
+                ++m_p;
+        }
+    }
+
+    // Unterminated literals end at the line end
+    void skipQuoted(char quote)
+    {
+        for (++m_p; m_p < m_end && *m_p != '\n'; ++m_p)
+        {
+            if (*m_p == '\\')
+                ++m_p;
+            else if (*m_p == quote)
+            {
+                ++m_p;
+                return;
+            }
+        }
+    }
+
+    // R"delimiter( ... )delimiter"
+    void skipRawString()
+    {
+        const char *open = m_p + 1;
+        const char *paren = open;
+        while (paren < m_end && *paren != '(' && paren - open <= 16)
+            ++paren;
+        if (paren >= m_end || *paren != '(')
+        {
+            skipQuoted('"');
+            return;
+        }
+        QByteArray terminator = ")";
+        terminator.append(open, int(paren - open));
+        terminator.append('"');
+        for (m_p = paren + 1; m_p < m_end; ++m_p)
+        {
+            if (*m_p == '\n')
+                ++m_line;
+            else if (*m_p == ')' && m_end - m_p >= terminator.size()
+                     && std::memcmp(m_p, terminator.constData(), size_t(terminator.size())) == 0)
+            {
+                m_p += terminator.size();
+                return;
+            }
+        }
+    }
+
+    // Digits, suffixes, separators and exponents: 0x1F, 1'000, 1.5e-3f
+    void skipNumber()
+    {
+        for (++m_p; m_p < m_end; ++m_p)
+        {
+            const uchar c = uchar(*m_p);
+            if (isIdentifierByte(c) || c == '.' || c == '\'')
+                continue;
+            if ((c == '+' || c == '-') && ((m_p[-1] | 0x20) == 'e' || (m_p[-1] | 0x20) == 'p'))
+                continue;
+            return;
+        }
+    }
+
+    const char *m_p;
+    const char *m_end;
+    int m_line = 1;
+    bool m_lineStart = true;
+};
+
+// ---------------------------------------------------------------------------
+// Declarations
+// ---------------------------------------------------------------------------
+const char *const NotFunctionNames[] = {
+    "if",       "for",      "while",    "switch",   "catch",  "return",   "sizeof",        "alignof",
+    "decltype", "typeid",   "noexcept", "throw",    "new",    "delete",   "static_assert", "void",
+    "int",      "char",     "bool",     "short",    "long",   "float",    "double",        "unsigned",
+    "signed",   "auto",     "const",    "volatile", "requires", "defined", "explicit",     "operator"};
+
+const char *const NotDeclarationStarts[] = {"typedef", "using", "friend", "return", "static_assert",
+                                            "goto",    "case",  "default"};
+
+const char *const AccessWords[] = {"public", "protected", "private", "signals", "slots", "Q_SIGNALS", "Q_SLOTS"};
+
+// Expand to nothing, or to attributes, for the purpose of finding names
+bool isIgnoredMacro(const Token &token)
+{
+    if (token.type != TokenType::Identifier)
+        return false;
+    if (token.length > 2 && token.text[0] == 'Q' && token.text[1] == '_')
+        return !token.is("Q_SIGNALS") && !token.is("Q_SLOTS");
+    return token.is("__attribute__") || token.is("__declspec") || token.is("alignas");
+}
+
+bool isOneOf(const Token &token, const char *const *words, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (token.is(words[i]))
+            return true;
+    }
+    return false;
+}
+
+template <size_t N>
+bool isOneOf(const Token &token, const char *const (&words)[N])
+{
+    return isOneOf(token, words, N);
+}
+
+// ALL_CAPS names followed by arguments are macro invocations
+bool isMacroName(const QByteArray &name)
+{
+    if (name.size() < 2)
+        return false;
+    for (const char c : name)
+    {
+        if (!(c == '_' || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+            return false;
+    }
+    return true;
+}
+
+QByteArray joinScope(const QByteArray &outer, const QByteArray &inner)
+{
+    if (outer.isEmpty())
+        return inner;
+    if (inner.isEmpty())
+        return outer;
+    return outer + "::" + inner;
+}
+
+class SymbolExtractor
+{
+public:
+    QVector<Symbol> run(const char *data, qsizetype size)
+    {
+        Lexer lexer(data, size);
+        m_scopes.push_back(Scope{Scope::Namespace, QByteArray(), SymbolKind::Function});
+
+        Token token;
+        int macroDepth = 0;     // inside the arguments of an ignored macro
+        int attributeDepth = 0; // inside [[...]]
+        bool afterMacro = false;
+        while (lexer.next(&token))
+        {
+            if (m_scopes.back().type == Scope::Block)
+            {
+                // Function bodies and initializers: only braces matter
+                if (token.is('{'))
+                    m_scopes.push_back(Scope{Scope::Block, QByteArray(), SymbolKind::Function});
+                else if (token.is('}'))
+                    m_scopes.pop_back();
+                continue;
+            }
+
+            const bool structural = token.is('{') || token.is('}') || token.is(';');
+            if ((macroDepth > 0 || attributeDepth > 0) && structural)
+                macroDepth = attributeDepth = 0;
+            if (macroDepth > 0)
+            {
+                macroDepth += token.is('(') ? 1 : token.is(')') ? -1 : 0;
+                continue;
+            }
+            if (attributeDepth > 0)
+            {
+                attributeDepth += token.is('[') ? 1 : token.is(']') ? -1 : 0;
+                continue;
+            }
+            if (afterMacro)
+            {
+                afterMacro = false;
+                if (token.is('('))
+                {
+                    macroDepth = 1;
+                    continue;
+                }
+            }
+            if (isIgnoredMacro(token))
+            {
+                afterMacro = true;
+                continue;
+            }
+            if (token.is('[') && !m_statement.empty() && m_statement.back().is('['))
+            {
+                m_statement.pop_back();
+                attributeDepth = 2;
+                continue;
+            }
+
+            if (token.is('{'))
+            {
+                openBrace();
+                resetStatement();
+            }
+            else if (token.is('}'))
+            {
+                if (m_scopes.size() > 1)
+                    m_scopes.pop_back();
+                resetStatement();
+            }
+            else if (token.is(';'))
+            {
+                if (!m_overflow)
+                    declaration();
+                resetStatement();
+            }
+            else if (token.is(':') && m_scopes.back().type == Scope::Class && isAccessLabel())
+            {
+                m_scopes.back().section = sectionKind();
+                resetStatement();
+            }
+            else if (m_statement.size() < MaxStatementTokens)
+                m_statement.push_back(token);
+            else
+                m_overflow = true;
+        }
+        return std::move(m_symbols);
+    }
+
+private:
+    struct Scope
+    {
+        enum Type
+        {
+            Namespace,
+            Class,
+            Block
+        } type;
+        QByteArray name;     // qualified
+        SymbolKind section;  // kind of functions declared here
+    };
+
+    void resetStatement()
+    {
+        m_statement.clear();
+        m_overflow = false;
+    }
+
+    void add(SymbolKind kind, const QByteArray &name, const QByteArray &scope, int line)
+    {
+        m_symbols.append(Symbol{kind, QString::fromUtf8(name), QString::fromUtf8(scope), line});
+    }
+
+    // First token after template<...> headers
+    size_t declarationStart() const
+    {
+        size_t i = 0;
+        while (i < m_statement.size() && m_statement[i].is("template"))
+        {
+            ++i;
+            int angles = 0;
+            int parens = 0;
+            for (; i < m_statement.size(); ++i)
+            {
+                const Token &token = m_statement[i];
+                parens += token.is('(') ? 1 : token.is(')') ? -1 : 0;
+                if (parens > 0)
+                    continue;
+                if (token.is('<'))
+                    ++angles;
+                else if (token.is('>') && --angles == 0)
+                {
+                    ++i;
+                    break;
+                }
+            }
+        }
+        return i;
+    }
+
+    bool isAccessLabel() const
+    {
+        if (m_statement.empty())
+            return false;
+        for (const Token &token : m_statement)
+        {
+            if (!isOneOf(token, AccessWords))
+                return false;
+        }
+        return true;
+    }
+
+    SymbolKind sectionKind() const
+    {
+        for (const Token &token : m_statement)
+        {
+            if (token.is("signals") || token.is("Q_SIGNALS"))
+                return SymbolKind::Signal;
+            if (token.is("slots") || token.is("Q_SLOTS"))
+                return SymbolKind::Slot;
+        }
+        return SymbolKind::Function;
+    }
+
+    void openBrace()
+    {
+        const Scope &scope = m_scopes.back();
+        const size_t start = declarationStart();
+        if (m_overflow || start >= m_statement.size())
+        {
+            m_scopes.push_back(Scope{Scope::Block, QByteArray(), SymbolKind::Function});
+            return;
+        }
+
+        size_t i = start;
+        if (m_statement[i].is("inline") && i + 1 < m_statement.size())
+            ++i;
+        if (m_statement[i].is("namespace"))
+        {
+            // "namespace a::b {" opens both; anonymous ones are transparent.
+            // Attribute macros may follow the name.
+            QByteArray name = scope.name;
+            for (++i; i < m_statement.size() && m_statement[i].type == TokenType::Identifier; i += 2)
+            {
+                const Token &token = m_statement[i];
+                add(SymbolKind::Namespace, token.bytes(), name, token.line);
+                name = joinScope(name, token.bytes());
+                if (i + 1 >= m_statement.size() || !m_statement[i + 1].isScopeOperator())
+                    break;
+            }
+            m_scopes.push_back(Scope{Scope::Namespace, name, SymbolKind::Function});
+            return;
+        }
+        if (m_statement[i].is("extern") && m_statement.size() - i <= 2)
+        {
+            // extern "C" {
+            m_scopes.push_back(Scope{Scope::Namespace, scope.name, SymbolKind::Function});
+            return;
+        }
+        if (classDefinition(start))
+            return;
+
+        declaration();
+        m_scopes.push_back(Scope{Scope::Block, QByteArray(), SymbolKind::Function});
+    }
+
+    // class/struct/union/enum heads; false if the statement is none of them
+    bool classDefinition(size_t start)
+    {
+        size_t keyword = m_statement.size();
+        for (size_t i = start; i < m_statement.size(); ++i)
+        {
+            const Token &token = m_statement[i];
+            if (token.is('(') || token.is('='))
+                return false; // "struct Foo *make() {" or an initializer
+            if (token.is("class") || token.is("struct") || token.is("union") || token.is("enum"))
+            {
+                keyword = i;
+                break;
+            }
+        }
+        if (keyword == m_statement.size())
+            return false;
+
+        const bool isEnum = m_statement[keyword].is("enum");
+        SymbolKind kind = m_statement[keyword].is("class") ? SymbolKind::Class : SymbolKind::Struct;
+        size_t i = keyword + 1;
+        if (isEnum)
+        {
+            kind = SymbolKind::Enum;
+            if (i < m_statement.size() && (m_statement[i].is("class") || m_statement[i].is("struct")))
+                ++i;
+        }
+
+        // The name is the last identifier before the base clause: export
+        // macros come first, and "Foo<int>" specializations carry arguments
+        int nameIndex = -1;
+        int angles = 0;
+        for (; i < m_statement.size(); ++i)
+        {
+            const Token &token = m_statement[i];
+            if (token.is('<'))
+                ++angles;
+            else if (token.is('>'))
+                --angles;
+            else if (angles > 0)
+                continue;
+            else if (token.is('('))
+                return false; // "struct Foo *make() {"
+            else if (token.is(':'))
+                break;
+            else if (token.type == TokenType::Identifier && !token.is("final"))
+                nameIndex = int(i);
+        }
+
+        const Scope &scope = m_scopes.back();
+        if (nameIndex < 0)
+        {
+            // Anonymous: members belong to the enclosing scope
+            m_scopes.push_back(isEnum ? Scope{Scope::Block, QByteArray(), SymbolKind::Function}
+                                      : Scope{Scope::Class, scope.name, SymbolKind::Function});
+            return true;
+        }
+
+        const Token &name = m_statement[size_t(nameIndex)];
+        const QByteArray outer = joinScope(scope.name, qualifierBefore(size_t(nameIndex)));
+        add(kind, name.bytes(), outer, name.line);
+        m_scopes.push_back(isEnum ? Scope{Scope::Block, QByteArray(), SymbolKind::Function}
+                                  : Scope{Scope::Class, joinScope(outer, name.bytes()), SymbolKind::Function});
+        return true;
+    }
+
+    // "a::Foo<T>::" in front of a name, without template arguments
+    QByteArray qualifierBefore(size_t nameIndex) const
+    {
+        QByteArray qualifier;
+        int i = int(nameIndex) - 1;
+        while (i >= 1 && m_statement[size_t(i)].isScopeOperator())
+        {
+            --i;
+            if (m_statement[size_t(i)].is('>'))
+            {
+                int angles = 0;
+                for (; i >= 0; --i)
+                {
+                    if (m_statement[size_t(i)].is('>'))
+                        ++angles;
+                    else if (m_statement[size_t(i)].is('<') && --angles == 0)
+                        break;
+                }
+                --i;
+            }
+            if (i < 0 || m_statement[size_t(i)].type != TokenType::Identifier)
+                break;
+            const QByteArray part = m_statement[size_t(i)].bytes();
+            qualifier = qualifier.isEmpty() ? part : part + "::" + qualifier;
+            --i;
+        }
+        return qualifier;
+    }
+
+    // Function declarations and definitions. Reports nothing for variables,
+    // initializers, control statements and other shapes.
+    void declaration()
+    {
+        const Scope &scope = m_scopes.back();
+        const size_t size = m_statement.size();
+        size_t start = declarationStart();
+        if (start >= size || isOneOf(m_statement[start], NotDeclarationStarts))
+            return;
+
+        while (start < size)
+        {
+            // The first "(" that is not part of an operator name opens the
+            // parameters; an "=" before it makes this a variable
+            size_t paren = start;
+            size_t operatorIndex = size;
+            for (; paren < size; ++paren)
+            {
+                const Token &token = m_statement[paren];
+                if (token.is("operator"))
+                {
+                    operatorIndex = paren++;
+                    if (paren + 1 < size && m_statement[paren].is('(') && m_statement[paren + 1].is(')'))
+                        paren += 2;
+                    while (paren < size && !m_statement[paren].is('('))
+                        ++paren;
+                    break;
+                }
+                if (token.is('(') || token.is('='))
+                    break;
+            }
+            if (paren >= size || m_statement[paren].is('='))
+                return;
+
+            QByteArray name;
+            size_t nameIndex = operatorIndex;
+            if (operatorIndex < size)
+            {
+                name = "operator";
+                for (size_t i = operatorIndex + 1; i < paren; ++i)
+                {
+                    if (m_statement[i].type == TokenType::Identifier)
+                        name += ' ';
+                    name += m_statement[i].bytes();
+                }
+            }
+            else
+            {
+                if (paren == start)
+                    return;
+                const Token &token = m_statement[paren - 1];
+                if (token.type != TokenType::Identifier || isOneOf(token, NotFunctionNames))
+                    return;
+                nameIndex = paren - 1;
+                name = token.bytes();
+                if (nameIndex > start && m_statement[nameIndex - 1].is('~'))
+                {
+                    --nameIndex;
+                    name.prepend('~');
+                }
+            }
+
+            // Outside classes a function has a return type or a qualifier,
+            // and "NAME(...)" in front is a macro either way; the
+            // declaration may still follow it
+            const QByteArray qualifier = qualifierBefore(nameIndex);
+            if (qualifier.isEmpty() && nameIndex == start && (scope.type != Scope::Class || isMacroName(name)))
+            {
+                int parens = 0;
+                for (; paren < size; ++paren)
+                {
+                    parens += m_statement[paren].is('(') ? 1 : m_statement[paren].is(')') ? -1 : 0;
+                    if (parens == 0)
+                        break;
+                }
+                start = paren + 1;
+                continue;
+            }
+
+            const SymbolKind kind = scope.type == Scope::Class ? scope.section : SymbolKind::Function;
+            add(kind, name, joinScope(scope.name, qualifier), m_statement[nameIndex].line);
+            return;
+        }
+    }
+
+    std::vector<Scope> m_scopes;
+    std::vector<Token> m_statement;
+    bool m_overflow = false;
+    QVector<Symbol> m_symbols;
+};
+
+// ---------------------------------------------------------------------------
+// Index file
+// ---------------------------------------------------------------------------
+QString slotPath(const QString &basePath, quint32 slot)
+{
+    return basePath + QStringLiteral(".%1.idx").arg(slot);
+}
+
+// ASCII case-insensitive three-way comparison; with prefix, a is cut to b's length
+int compareFolded(const char *a, int aLength, const char *b, int bLength, bool prefix = false)
+{
+    if (prefix)
+        aLength = qMin(aLength, bLength);
+    const int length = qMin(aLength, bLength);
+    for (int i = 0; i < length; ++i)
+    {
+        uchar x = uchar(a[i]);
+        uchar y = uchar(b[i]);
+        x = (x >= 'A' && x <= 'Z') ? uchar(x | 0x20) : x;
+        y = (y >= 'A' && y <= 'Z') ? uchar(y | 0x20) : y;
+        if (x != y)
+            return x < y ? -1 : 1;
+    }
+    return aLength == bLength ? 0 : (aLength < bLength ? -1 : 1);
+}
+
+int compareBytes(const char *a, int aLength, const char *b, int bLength)
+{
+    const int result = std::memcmp(a, b, size_t(qMin(aLength, bLength)));
+    if (result != 0)
+        return result;
+    return aLength == bLength ? 0 : (aLength < bLength ? -1 : 1);
+}
+
+int compareBytes(const QByteArray &a, const QByteArray &b)
+{
+    return compareBytes(a.constData(), a.size(), b.constData(), b.size());
+}
+
+struct IndexedFile
+{
+    QByteArray path; // UTF-8
+    FileStamp stamp;
+    quint64 hash = 0;
+    QVector<Symbol> symbols;
+};
+
+class StringPool
+{
+public:
+    quint32 add(const QByteArray &text)
+    {
+        const auto it = m_offsets.constFind(text);
+        if (it != m_offsets.constEnd())
+            return *it;
+        const quint32 offset = quint32(m_data.size());
+        m_data += text;
+        m_offsets.insert(text, offset);
+        return offset;
+    }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    QByteArray m_data;
+    QHash<QByteArray, quint32> m_offsets;
+};
+
+void align(QByteArray &buffer)
+{
+    buffer.append(int((8 - buffer.size() % 8) % 8), '\0');
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// File layout, native byte order; a cache, not an exchange format. Sections
+// start on 8-byte boundaries.
+// ---------------------------------------------------------------------------
+struct SymbolIndex::Header
+{
+    quint32 magic;
+    quint32 version;
+    quint32 generation;
+    quint32 fileCount;
+    quint32 symbolCount;
+    quint32 stringBytes;
+    quint64 filesOffset;
+    quint64 symbolsOffset;
+    quint64 byNameOffset;
+    quint64 byScopeOffset;
+    quint64 stringsOffset;
+};
+
+struct SymbolIndex::FileRecord
+{
+    quint64 inode;
+    qint64 modified;
+    qint64 size;
+    quint64 hash;
+    quint32 pathOffset;
+    quint32 pathLength;
+    quint32 firstSymbol;
+    quint32 symbolCount;
+};
+
+struct SymbolIndex::SymbolRecord
+{
+    quint32 nameOffset;
+    quint32 nameLength;
+    quint32 scopeOffset;
+    quint32 scopeLength;
+    quint32 file;
+    quint32 line;
+    quint32 kind;
+};
+
+// ---------------------------------------------------------------------------
+// Extraction
+// ---------------------------------------------------------------------------
+QVector<Symbol> extractSymbols(const char *data, qsizetype size)
+{
+    return SymbolExtractor().run(data, size);
+}
+
+quint64 contentHash(const char *data, qsizetype size)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        hash ^= uchar(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool isSymbolSourceFile(const QString &path)
+{
+    const int dot = path.lastIndexOf(QLatin1Char('.'));
+    if (dot < 0 || path.indexOf(QLatin1Char('/'), dot) >= 0)
+        return false;
+    const QStringView suffix = QStringView(path).mid(dot + 1);
+    for (const char *candidate : SourceSuffixes)
+    {
+        if (suffix.compare(QLatin1String(candidate), Qt::CaseInsensitive) == 0)
+            return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// SymbolIndex
+// ---------------------------------------------------------------------------
+SymbolIndex::~SymbolIndex()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+}
+
+QString SymbolIndex::defaultPath(const QString &rootPath)
+{
+    const QByteArray key = QCryptographicHash::hash(QDir::cleanPath(rootPath).toUtf8(), QCryptographicHash::Sha1);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/symbol-index/")
+           + QString::fromLatin1(key.toHex().left(16));
+}
+
+std::shared_ptr<const SymbolIndex> SymbolIndex::open(const QString &basePath)
+{
+    std::shared_ptr<SymbolIndex> newest;
+    for (quint32 slot = 0; slot < 2; ++slot)
+    {
+        std::shared_ptr<SymbolIndex> index(new SymbolIndex);
+        if (index->attach(slotPath(basePath, slot)) && (!newest || index->generation() > newest->generation()))
+            newest = std::move(index);
+    }
+    return newest;
+}
+
+bool SymbolIndex::attach(const QString &filePath)
+{
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < qint64(sizeof(Header)))
+        return false;
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data)
+        return false;
+
+    const auto *header = reinterpret_cast<const Header *>(m_data);
+    if (header->magic != IndexMagic || header->version != IndexVersion)
+        return false;
+    const auto fits = [this](quint64 offset, quint64 count, quint64 size) {
+        return offset % 8 == 0 && offset <= quint64(m_size) && count * size <= quint64(m_size) - offset;
+    };
+    if (!fits(header->filesOffset, header->fileCount, sizeof(FileRecord))
+        || !fits(header->symbolsOffset, header->symbolCount, sizeof(SymbolRecord))
+        || !fits(header->byNameOffset, header->symbolCount, sizeof(quint32))
+        || !fits(header->byScopeOffset, header->symbolCount, sizeof(quint32))
+        || !fits(header->stringsOffset, header->stringBytes, 1))
+        return false;
+
+    m_header = header;
+    m_files = reinterpret_cast<const FileRecord *>(m_data + header->filesOffset);
+    m_symbols = reinterpret_cast<const SymbolRecord *>(m_data + header->symbolsOffset);
+    m_byName = reinterpret_cast<const quint32 *>(m_data + header->byNameOffset);
+    m_byScope = reinterpret_cast<const quint32 *>(m_data + header->byScopeOffset);
+    return true;
+}
+
+quint32 SymbolIndex::generation() const
+{
+    return m_header->generation;
+}
+
+int SymbolIndex::fileCount() const
+{
+    return int(m_header->fileCount);
+}
+
+int SymbolIndex::symbolCount() const
+{
+    return int(m_header->symbolCount);
+}
+
+// Points into the mapping; valid while the index lives
+QByteArray SymbolIndex::bytes(quint32 offset, quint32 length) const
+{
+    if (quint64(offset) + length > m_header->stringBytes)
+        return QByteArray();
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(m_data + m_header->stringsOffset + offset),
+                                   int(length));
+}
+
+const SymbolIndex::SymbolRecord *SymbolIndex::symbolAt(quint32 id) const
+{
+    return id < m_header->symbolCount ? m_symbols + id : nullptr;
+}
+
+SymbolIndex::Entry SymbolIndex::entry(const SymbolRecord &record) const
+{
+    Entry entry;
+    entry.kind = SymbolKind(record.kind);
+    entry.name = QString::fromUtf8(bytes(record.nameOffset, record.nameLength));
+    entry.scope = QString::fromUtf8(bytes(record.scopeOffset, record.scopeLength));
+    entry.line = int(record.line);
+    if (record.file < m_header->fileCount)
+    {
+        const FileRecord &file = m_files[record.file];
+        entry.filePath = QString::fromUtf8(bytes(file.pathOffset, file.pathLength));
+    }
+    return entry;
+}
+
+QVector<SymbolIndex::Entry> SymbolIndex::find(const QString &prefix, int limit) const
+{
+    const QByteArray key = prefix.toUtf8();
+    const auto nameLess = [this](quint32 id, const QByteArray &value) {
+        const SymbolRecord *record = symbolAt(id);
+        const QByteArray name = record ? bytes(record->nameOffset, record->nameLength) : QByteArray();
+        return compareFolded(name.constData(), name.size(), value.constData(), value.size()) < 0;
+    };
+
+    QVector<Entry> entries;
+    const quint32 *end = m_byName + m_header->symbolCount;
+    for (const quint32 *it = std::lower_bound(m_byName, end, key, nameLess); it != end && entries.size() < limit;
+         ++it)
+    {
+        const SymbolRecord *record = symbolAt(*it);
+        if (!record)
+            break;
+        const QByteArray name = bytes(record->nameOffset, record->nameLength);
+        if (compareFolded(name.constData(), name.size(), key.constData(), key.size(), true) != 0)
+            break;
+        entries.append(entry(*record));
+    }
+    return entries;
+}
+
+QVector<SymbolIndex::Entry> SymbolIndex::members(const QString &scope) const
+{
+    const QByteArray key = scope.toUtf8();
+    const auto scopeLess = [this](quint32 id, const QByteArray &value) {
+        const SymbolRecord *record = symbolAt(id);
+        return record && compareBytes(bytes(record->scopeOffset, record->scopeLength), value) < 0;
+    };
+
+    QVector<Entry> entries;
+    const SymbolRecord *previous = nullptr;
+    const quint32 *end = m_byScope + m_header->symbolCount;
+    for (const quint32 *it = std::lower_bound(m_byScope, end, key, scopeLess); it != end; ++it)
+    {
+        const SymbolRecord *record = symbolAt(*it);
+        if (!record || compareBytes(bytes(record->scopeOffset, record->scopeLength), key) != 0)
+            break;
+        // Equal names share one pool offset
+        if (previous && previous->nameOffset == record->nameOffset && previous->nameLength == record->nameLength)
+            continue;
+        entries.append(entry(*record));
+        previous = record;
+    }
+    return entries;
+}
+
+bool SymbolIndex::hasMembers(const QString &scope) const
+{
+    const QByteArray key = scope.toUtf8();
+    const auto scopeLess = [this](quint32 id, const QByteArray &value) {
+        const SymbolRecord *record = symbolAt(id);
+        return record && compareBytes(bytes(record->scopeOffset, record->scopeLength), value) < 0;
+    };
+    const quint32 *end = m_byScope + m_header->symbolCount;
+    const quint32 *it = std::lower_bound(m_byScope, end, key, scopeLess);
+    const SymbolRecord *record = it != end ? symbolAt(*it) : nullptr;
+    return record && compareBytes(bytes(record->scopeOffset, record->scopeLength), key) == 0;
+}
+
+bool SymbolIndex::fileSymbols(const QString &path, FileStamp *stamp, quint64 *hash, QVector<Symbol> *symbols) const
+{
+    const QByteArray key = path.toUtf8();
+    const FileRecord *end = m_files + m_header->fileCount;
+    const auto pathLess = [this](const FileRecord &record, const QByteArray &value) {
+        return compareBytes(bytes(record.pathOffset, record.pathLength), value) < 0;
+    };
+    const FileRecord *file = std::lower_bound(m_files, end, key, pathLess);
+    if (file == end || compareBytes(bytes(file->pathOffset, file->pathLength), key) != 0)
+        return false;
+    if (quint64(file->firstSymbol) + file->symbolCount > m_header->symbolCount)
+        return false;
+
+    stamp->inode = file->inode;
+    stamp->modified = file->modified;
+    stamp->size = file->size;
+    *hash = file->hash;
+    symbols->clear();
+    symbols->reserve(int(file->symbolCount));
+    for (quint32 id = file->firstSymbol; id < file->firstSymbol + file->symbolCount; ++id)
+    {
+        const SymbolRecord &record = m_symbols[id];
+        symbols->append(Symbol{SymbolKind(record.kind), QString::fromUtf8(bytes(record.nameOffset, record.nameLength)),
+                               QString::fromUtf8(bytes(record.scopeOffset, record.scopeLength)), int(record.line)});
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Building
+// ---------------------------------------------------------------------------
+class SymbolIndexWriter
+{
+public:
+    static bool write(const QString &filePath, quint32 generation, std::vector<IndexedFile> &files);
+};
+
+bool SymbolIndexWriter::write(const QString &filePath, quint32 generation, std::vector<IndexedFile> &files)
+{
+    std::sort(files.begin(), files.end(),
+              [](const IndexedFile &a, const IndexedFile &b) { return compareBytes(a.path, b.path) < 0; });
+
+    struct Pending
+    {
+        QByteArray name;
+        QByteArray scope;
+        quint32 file;
+        quint32 line;
+        quint32 kind;
+    };
+    std::vector<Pending> symbols;
+    for (quint32 f = 0; f < quint32(files.size()); ++f)
+    {
+        for (const Symbol &symbol : std::as_const(files[f].symbols))
+            symbols.push_back(Pending{symbol.name.toUtf8(), symbol.scope.toUtf8(), f, quint32(symbol.line),
+                                      quint32(symbol.kind)});
+    }
+
+    StringPool pool;
+    std::vector<SymbolIndex::FileRecord> fileRecords;
+    fileRecords.reserve(files.size());
+    quint32 firstSymbol = 0;
+    for (const IndexedFile &file : files)
+    {
+        const quint32 count = quint32(file.symbols.size());
+        fileRecords.push_back({file.stamp.inode, file.stamp.modified, file.stamp.size, file.hash,
+                               pool.add(file.path), quint32(file.path.size()), firstSymbol, count});
+        firstSymbol += count;
+    }
+    std::vector<SymbolIndex::SymbolRecord> symbolRecords;
+    symbolRecords.reserve(symbols.size());
+    for (const Pending &symbol : symbols)
+    {
+        symbolRecords.push_back({pool.add(symbol.name), quint32(symbol.name.size()), pool.add(symbol.scope),
+                                 quint32(symbol.scope.size()), symbol.file, symbol.line, symbol.kind});
+    }
+
+    std::vector<quint32> byName(symbols.size());
+    std::vector<quint32> byScope(symbols.size());
+    for (quint32 id = 0; id < quint32(symbols.size()); ++id)
+        byName[id] = byScope[id] = id;
+    std::sort(byName.begin(), byName.end(), [&symbols](quint32 a, quint32 b) {
+        const QByteArray &x = symbols[a].name;
+        const QByteArray &y = symbols[b].name;
+        const int folded = compareFolded(x.constData(), x.size(), y.constData(), y.size());
+        if (folded != 0)
+            return folded < 0;
+        const int exact = compareBytes(x, y);
+        return exact != 0 ? exact < 0 : a < b;
+    });
+    // By scope and name, so repeated declarations are adjacent; signals and
+    // slots before the plain out-of-line definitions of the same names
+    std::sort(byScope.begin(), byScope.end(), [&symbols](quint32 a, quint32 b) {
+        const Pending &x = symbols[a];
+        const Pending &y = symbols[b];
+        if (const int scope = compareBytes(x.scope, y.scope))
+            return scope < 0;
+        if (const int name = compareBytes(x.name, y.name))
+            return name < 0;
+        if (x.kind != y.kind)
+            return x.kind > y.kind;
+        return a < b;
+    });
+
+    SymbolIndex::Header header = {};
+    header.magic = IndexMagic;
+    header.version = IndexVersion;
+    header.generation = generation;
+    header.fileCount = quint32(fileRecords.size());
+    header.symbolCount = quint32(symbolRecords.size());
+    header.stringBytes = quint32(pool.data().size());
+
+    QByteArray buffer(int(sizeof(header)), '\0');
+    align(buffer);
+    header.filesOffset = quint64(buffer.size());
+    buffer.append(reinterpret_cast<const char *>(fileRecords.data()),
+                  int(fileRecords.size() * sizeof(SymbolIndex::FileRecord)));
+    align(buffer);
+    header.symbolsOffset = quint64(buffer.size());
+    buffer.append(reinterpret_cast<const char *>(symbolRecords.data()),
+                  int(symbolRecords.size() * sizeof(SymbolIndex::SymbolRecord)));
+    align(buffer);
+    header.byNameOffset = quint64(buffer.size());
+    buffer.append(reinterpret_cast<const char *>(byName.data()), int(byName.size() * sizeof(quint32)));
+    align(buffer);
+    header.byScopeOffset = quint64(buffer.size());
+    buffer.append(reinterpret_cast<const char *>(byScope.data()), int(byScope.size() * sizeof(quint32)));
+    align(buffer);
+    header.stringsOffset = quint64(buffer.size());
+    buffer.append(pool.data());
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    QDir().mkpath(QFileInfo(filePath).path());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(buffer) != buffer.size())
+        return false;
+    return file.commit();
+}
+
+bool buildSymbolIndex(const QString &rootPath, const QString &basePath, const SymbolIndex *previous,
+                      const std::atomic_bool &cancelled, SymbolIndexStats *stats)
+{
+    std::mutex mutex;
+    std::vector<IndexedFile> files;
+    std::atomic<qint64> filesParsed{0}, filesReused{0}, symbolCount{0};
+
+    const auto indexPath = [&](const QString &path) {
+        if (!isSymbolSourceFile(path))
+            return;
+        IndexedFile file;
+        file.path = path.toUtf8();
+        file.stamp = FileStamp::of(path);
+
+        FileStamp oldStamp;
+        quint64 oldHash = 0;
+        QVector<Symbol> oldSymbols;
+        const bool known = previous && previous->fileSymbols(path, &oldStamp, &oldHash, &oldSymbols);
+        if (known && file.stamp.size >= 0 && oldStamp == file.stamp)
+        {
+            file.hash = oldHash;
+            file.symbols = std::move(oldSymbols);
+            filesReused.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            QFile source(path);
+            if (!source.open(QIODevice::ReadOnly) || source.size() > MaxSourceBytes)
+                return;
+            const qint64 size = source.size();
+            uchar *mapped = size > 0 ? source.map(0, size) : nullptr;
+            const QByteArray contents = mapped || size == 0 ? QByteArray() : source.readAll();
+            const char *data = mapped ? reinterpret_cast<const char *>(mapped) : contents.constData();
+            const qsizetype length = mapped ? qsizetype(size) : contents.size();
+
+            // A touched but unchanged file keeps its symbols
+            file.hash = contentHash(data, length);
+            if (known && oldHash == file.hash)
+            {
+                file.symbols = std::move(oldSymbols);
+                filesReused.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                file.symbols = extractSymbols(data, length);
+                filesParsed.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (mapped)
+                source.unmap(mapped);
+        }
+        symbolCount.fetch_add(file.symbols.size(), std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        files.push_back(std::move(file));
+    };
+    if (!walkFiles(rootPath, 0, cancelled, indexPath))
+        return false;
+
+    const quint32 generation = previous ? previous->generation() + 1 : 1;
+    if (!SymbolIndexWriter::write(slotPath(basePath, generation % 2), generation, files))
+        return false;
+    if (stats)
+    {
+        stats->filesParsed = filesParsed.load();
+        stats->filesReused = filesReused.load();
+        stats->symbols = symbolCount.load();
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "TodoScanner.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+// ---------------------------------------------------------------------------
+// Symbols found in C/C++ sources
+// ---------------------------------------------------------------------------
+enum class SymbolKind : quint8
+{
+    Namespace,
+    Class,
+    Struct,
+    Enum,
+    Function,
+    Signal,
+    Slot
+};
+
+struct Symbol
+{
+    SymbolKind kind = SymbolKind::Function;
+    QString name;  // unqualified; "~Foo" and "operator==" for those
+    QString scope; // enclosing namespaces and classes, "a::Foo"; empty at file scope
+    int line = 0;  // 1-based
+};
+
+struct SymbolIndexStats
+{
+    qint64 filesParsed = 0; // new or changed content
+    qint64 filesReused = 0; // same stamp or same content hash as in the previous index
+    qint64 symbols = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Namespaces, classes, structs, enums and functions of one C/C++ source.
+//
+// A hand-written lexer, not a parser: comments, string and character
+// literals and preprocessor lines are skipped, braces are tracked, and
+// declarations at namespace and class scope are recognised by their shape.
+// Function bodies are only brace-matched. Functions declared in a Qt
+// "signals:" or "slots:" section are reported as Signal or Slot; Q_ macros
+// such as Q_OBJECT, Q_PROPERTY(...) or Q_INVOKABLE are ignored. Out-of-line
+// definitions ("void Foo::bar() {") get the qualifier as part of their scope.
+// ---------------------------------------------------------------------------
+QVector<Symbol> extractSymbols(const char *data, qsizetype size);
+
+// 64-bit FNV-1a of a file's contents, the key under which its symbols are kept
+quint64 contentHash(const char *data, qsizetype size);
+
+// ---------------------------------------------------------------------------
+// Read-only view of an index file written by buildSymbolIndex().
+//
+// The file is memory-mapped and queried in place: symbols are fixed-size
+// records over a UTF-8 string pool, with two permutations sorted by name
+// (case-insensitive) and by scope, so lookups are binary searches and
+// opening an index reads nothing but its header. Instances are immutable
+// and may be queried from any thread.
+//
+// Indexes are written to two slots next to basePath in turn, so a new one
+// never replaces a file that is still mapped; open() picks the newer slot.
+// ---------------------------------------------------------------------------
+class SymbolIndex
+{
+public:
+    struct Entry
+    {
+        SymbolKind kind = SymbolKind::Function;
+        QString name;
+        QString scope;
+        QString filePath;
+        int line = 0;
+    };
+
+    ~SymbolIndex();
+
+    // Index file base path for a project root in the user's cache directory
+    static QString defaultPath(const QString &rootPath);
+
+    // Newest valid index at basePath, or null if there is none
+    static std::shared_ptr<const SymbolIndex> open(const QString &basePath);
+
+    quint32 generation() const;
+    int fileCount() const;
+    int symbolCount() const;
+
+    // Symbols whose name starts with prefix, ignoring ASCII case, by name
+    QVector<Entry> find(const QString &prefix, int limit) const;
+
+    // Symbols directly inside scope ("" for file scope), by name. A name is
+    // reported once: a namespace opened in many files, a member declared and
+    // defined, overloads.
+    QVector<Entry> members(const QString &scope) const;
+    bool hasMembers(const QString &scope) const;
+
+    // Entry of path as stored by the last build; false if it was not indexed
+    bool fileSymbols(const QString &path, FileStamp *stamp, quint64 *hash, QVector<Symbol> *symbols) const;
+
+private:
+    friend class SymbolIndexWriter;
+
+    struct Header;
+    struct FileRecord;
+    struct SymbolRecord;
+
+    SymbolIndex() = default;
+    bool attach(const QString &filePath);
+
+    QByteArray bytes(quint32 offset, quint32 length) const;
+    const SymbolRecord *symbolAt(quint32 id) const;
+    Entry entry(const SymbolRecord &record) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    const Header *m_header = nullptr;
+    const FileRecord *m_files = nullptr;
+    const SymbolRecord *m_symbols = nullptr;
+    const quint32 *m_byName = nullptr;
+    const quint32 *m_byScope = nullptr;
+};
+
+// ---------------------------------------------------------------------------
+// Indexes every C/C++ source below rootPath (see walkFiles()) and writes the
+// result next to basePath, in the slot previous is not using.
+//
+// Files whose stamp matches previous are not opened; files whose content
+// hash matches are not lexed. Everything else goes through extractSymbols()
+// on the walker threads.
+//
+// Blocks until done. Returns false if cancelled or the file could not be
+// written.
+// ---------------------------------------------------------------------------
+bool buildSymbolIndex(const QString &rootPath, const QString &basePath, const SymbolIndex *previous,
+                      const std::atomic_bool &cancelled, SymbolIndexStats *stats = nullptr);
+
+// Whether path has a C/C++ source or header suffix
+bool isSymbolSourceFile(const QString &path);
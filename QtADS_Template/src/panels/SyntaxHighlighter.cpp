@@ -0,0 +1,622 @@
+#include "SyntaxHighlighter.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+// One job lexes at most this much, so edits never wait long for a slot
+constexpr qint64 BatchLines = 8192;
+constexpr qint64 BatchBytes = 1024 * 1024;
+
+// Spans are kept for this many lines around the visible ones
+constexpr qint64 CacheMargin = 256;
+
+// Sorted for binary search
+const char *const Keywords[] = {
+    "alignas", "alignof", "auto", "bool", "break", "case", "catch", "char", "char16_t", "char32_t", "char8_t",
+    "class", "co_await", "co_return", "co_yield", "concept", "const", "const_cast", "consteval", "constexpr",
+    "constinit", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "emit",
+    "enum", "explicit", "export", "extern", "false", "float", "for", "foreach", "forever", "friend", "goto",
+    "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "nullptr", "operator",
+    "override", "private", "protected", "public", "register", "reinterpret_cast", "requires", "return",
+    "short", "signals", "signed", "sizeof", "slots", "static", "static_assert", "static_cast", "struct",
+    "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
+    "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while",
+};
+
+// strcmp of keyword against the word [word, word + length)
+int compareWord(const char *keyword, const char *word, qint64 length)
+{
+    const int order = std::strncmp(keyword, word, size_t(length));
+    if (order != 0)
+        return order;
+    return keyword[length] == '\0' ? 0 : 1;
+}
+
+bool isKeyword(const char *word, qint64 length)
+{
+    const auto it = std::lower_bound(std::begin(Keywords), std::end(Keywords), word,
+                                     [length](const char *keyword, const char *w) {
+                                         return compareWord(keyword, w, length) < 0;
+                                     });
+    return it != std::end(Keywords) && compareWord(*it, word, length) == 0;
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isIdentifierStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || uchar(c) >= 0x80;
+}
+
+bool isIdentifierChar(char c)
+{
+    return isIdentifierStart(c) || isDigit(c);
+}
+
+// End of "*/" searched from from, or -1
+qint64 commentEnd(const char *data, qint64 size, qint64 from)
+{
+    for (qint64 i = from; i + 1 < size; ++i)
+    {
+        if (data[i] == '*' && data[i + 1] == '/')
+            return i + 2;
+    }
+    return -1;
+}
+
+// End of a quoted literal whose body starts at from
+qint64 quotedEnd(const char *data, qint64 size, qint64 from, char quote, bool *closed)
+{
+    for (qint64 i = from; i < size; ++i)
+    {
+        if (data[i] == '\\')
+        {
+            ++i;
+        }
+        else if (data[i] == quote)
+        {
+            *closed = true;
+            return i + 1;
+        }
+    }
+    *closed = false;
+    return size;
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Lexing
+// ---------------------------------------------------------------------------
+LineState highlightLine(const char *data, qint64 size, LineState state, QVector<HighlightSpan> *spans)
+{
+    const auto add = [spans](qint64 start, qint64 end, HighlightFormat format) {
+        if (spans && end > start)
+            spans->append(HighlightSpan{quint32(start), quint32(end - start), format});
+    };
+
+    if (size > 0 && data[size - 1] == '\r')
+        --size;
+    const bool continued = size > 0 && data[size - 1] == '\\';
+    qint64 i = 0;
+
+    if (state == LineState::BlockComment)
+    {
+        i = commentEnd(data, size, 0);
+        if (i < 0)
+        {
+            add(0, size, HighlightFormat::Comment);
+            return LineState::BlockComment;
+        }
+        add(0, i, HighlightFormat::Comment);
+    }
+    else if (state == LineState::String)
+    {
+        bool closed = false;
+        i = quotedEnd(data, size, 0, '"', &closed);
+        add(0, i, HighlightFormat::String);
+        if (!closed)
+            return continued ? LineState::String : LineState::Normal;
+    }
+
+    // '#' first on a line that does not continue a directive
+    qint64 directive = -1;
+    if (state == LineState::Normal)
+    {
+        qint64 j = 0;
+        while (j < size && (data[j] == ' ' || data[j] == '\t'))
+            ++j;
+        if (j < size && data[j] == '#')
+            directive = j;
+    }
+    const bool preprocessor = directive >= 0 || state == LineState::Preprocessor;
+    bool include = false;
+
+    while (i < size)
+    {
+        const char c = data[i];
+        const char next = i + 1 < size ? data[i + 1] : '\0';
+        if (c == '/' && next == '/')
+        {
+            add(i, size, HighlightFormat::Comment);
+            break;
+        }
+        if (c == '/' && next == '*')
+        {
+            const qint64 end = commentEnd(data, size, i + 2);
+            add(i, end < 0 ? size : end, HighlightFormat::Comment);
+            if (end < 0)
+                return LineState::BlockComment;
+            i = end;
+        }
+        else if (c == '"' || c == '\'')
+        {
+            bool closed = false;
+            const qint64 end = quotedEnd(data, size, i + 1, c, &closed);
+            add(i, end, HighlightFormat::String);
+            if (!closed && c == '"' && continued)
+                return LineState::String;
+            i = end;
+        }
+        else if (c == '<' && include)
+        {
+            const char *close = static_cast<const char *>(std::memchr(data + i, '>', size_t(size - i)));
+            const qint64 end = close ? close - data + 1 : size;
+            add(i, end, HighlightFormat::String);
+            i = end;
+        }
+        else if (i == directive)
+        {
+            qint64 end = i + 1;
+            while (end < size && (data[end] == ' ' || data[end] == '\t'))
+                ++end;
+            const qint64 name = end;
+            while (end < size && isIdentifierChar(data[end]))
+                ++end;
+            include = end - name == 7 && std::memcmp(data + name, "include", 7) == 0;
+            add(i, end, HighlightFormat::Preprocessor);
+            i = end;
+        }
+        else if (isDigit(c) || (c == '.' && isDigit(next)))
+        {
+            // Digits, separators, suffixes and exponents alike: 0x1fULL, 1'000, 1e-9f
+            qint64 end = i + 1;
+            while (end < size)
+            {
+                const char d = data[end];
+                const char previous = data[end - 1];
+                const bool exponentSign = (d == '+' || d == '-')
+                                          && (previous == 'e' || previous == 'E' || previous == 'p' || previous == 'P');
+                if (!isIdentifierChar(d) && d != '.' && d != '\'' && !exponentSign)
+                    break;
+                ++end;
+            }
+            add(i, end, HighlightFormat::Number);
+            i = end;
+        }
+        else if (isIdentifierStart(c))
+        {
+            qint64 end = i + 1;
+            while (end < size && isIdentifierChar(data[end]))
+                ++end;
+            if (isKeyword(data + i, end - i))
+                add(i, end, HighlightFormat::Keyword);
+            i = end;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    return preprocessor && continued ? LineState::Preprocessor : LineState::Normal;
+}
+
+bool highlightLines(PieceTable &buffer, qint64 firstLine, LineState state, qint64 maxLines, qint64 maxBytes,
+                    std::vector<LineState> &nextStates, std::vector<QVector<HighlightSpan>> *spans,
+                    const std::atomic_bool &cancelled)
+{
+    const qint64 offset = buffer.lineStart(firstLine);
+    if (offset < 0)
+        return false;
+
+    // One read for the whole batch; a line cut by it waits for the next one
+    const QByteArray chunk = buffer.read(offset, maxBytes);
+    const bool chunkEndsText = offset + chunk.size() == buffer.size();
+    const char *data = chunk.constData();
+    qint64 position = 0;
+    for (qint64 done = 0; done < maxLines; ++done)
+    {
+        if (cancelled.load(std::memory_order_relaxed))
+            return true;
+
+        const char *newline =
+            static_cast<const char *>(std::memchr(data + position, '\n', size_t(chunk.size() - position)));
+        if (!newline && !chunkEndsText && done > 0)
+            break;
+        const qint64 end = newline ? newline - data : chunk.size();
+
+        QVector<HighlightSpan> lineSpans;
+        state = highlightLine(data + position, end - position, state, spans ? &lineSpans : nullptr);
+        nextStates.push_back(state);
+        if (spans)
+            spans->push_back(std::move(lineSpans));
+
+        if (!newline)
+            return !chunkEndsText;
+        position = end + 1;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// LineStateBuffer
+// ---------------------------------------------------------------------------
+void LineStateBuffer::append(LineState state)
+{
+    replace(size(), 0, 1);
+    set(size() - 1, state);
+}
+
+void LineStateBuffer::resize(qint64 size)
+{
+    const qint64 current = this->size();
+    if (size < current)
+        replace(size, current - size, 0);
+    else
+        replace(current, 0, size - current);
+}
+
+void LineStateBuffer::replace(qint64 line, qint64 removed, qint64 inserted)
+{
+    moveGap(line);
+    m_gapEnd += qMin(removed, qint64(m_data.size()) - m_gapEnd);
+    reserveGap(inserted);
+    std::fill_n(m_data.begin() + qptrdiff(m_gapStart), size_t(inserted), LineState::Normal);
+    m_gapStart += inserted;
+}
+
+void LineStateBuffer::moveGap(qint64 to)
+{
+    const auto data = m_data.begin();
+    if (to < m_gapStart)
+        std::move_backward(data + qptrdiff(to), data + qptrdiff(m_gapStart), data + qptrdiff(m_gapEnd));
+    else if (to > m_gapStart)
+        std::move(data + qptrdiff(m_gapEnd), data + qptrdiff(m_gapEnd + to - m_gapStart), data + qptrdiff(m_gapStart));
+    m_gapEnd += to - m_gapStart;
+    m_gapStart = to;
+}
+
+void LineStateBuffer::reserveGap(qint64 size)
+{
+    const qint64 gap = m_gapEnd - m_gapStart;
+    if (gap >= size)
+        return;
+    // Growing by half at least keeps appending amortized O(1)
+    const qint64 grow = qMax(size - gap, qMax<qint64>(64, qint64(m_data.size()) / 2));
+    m_data.insert(m_data.begin() + qptrdiff(m_gapEnd), size_t(grow), LineState::Normal);
+    m_gapEnd += grow;
+}
+
+// ---------------------------------------------------------------------------
+// SyntaxHighlighter
+// ---------------------------------------------------------------------------
+struct SyntaxHighlighter::Batch
+{
+    quint64 generation = 0;
+
+    // Visible pass: spans of the lines from visibleFirst, the first lexed
+    // from visibleState, and the state after each
+    qint64 visibleFirst = -1;
+    LineState visibleState = LineState::Normal;
+    std::vector<LineState> visibleNext;
+    std::vector<QVector<HighlightSpan>> visibleSpans;
+    bool visibleEnded = false;
+
+    // Background pass: states of the lines after backgroundFirst
+    qint64 backgroundFirst = -1;
+    std::vector<LineState> backgroundNext;
+    bool backgroundEnded = false;
+};
+
+SyntaxHighlighter::SyntaxHighlighter(PieceTable *buffer, QObject *parent)
+    : QObject(parent)
+    , m_buffer(buffer)
+{
+    // Edits arrive one by one; start one job after all of them
+    m_jobTimer = new QTimer(this);
+    m_jobTimer->setSingleShot(true);
+    m_jobTimer->setInterval(0);
+    connect(m_jobTimer, &QTimer::timeout, this, &SyntaxHighlighter::startJob);
+}
+
+SyntaxHighlighter::~SyntaxHighlighter()
+{
+    cancelJob();
+}
+
+void SyntaxHighlighter::reset()
+{
+    cancelJob();
+    m_states = LineStateBuffer();
+    m_validLines = 1;
+    m_convergeLine = -1;
+    m_knownLines = 0;
+    m_lineCount = -1;
+    m_lines.clear();
+    scheduleJob();
+}
+
+void SyntaxHighlighter::linesChanged(qint64 line, qint64 removedLines, qint64 insertedLines)
+{
+    // Anything lexed from the old text is void
+    cancelJob();
+    const qint64 delta = insertedLines - removedLines;
+    const qint64 editEnd = line + removedLines; // last old line the edit touched
+
+    // The edited line keeps the state it starts in; removed lines lose
+    // theirs and inserted lines get placeholders
+    if (line + 1 < m_states.size())
+        m_states.replace(line + 1, removedLines, insertedLines);
+
+    // Old states after the edit may turn out right again
+    const qint64 oldStart = m_convergeLine >= 0 ? m_convergeLine : 0;
+    const qint64 oldEnd = m_convergeLine >= 0 ? qMax(m_knownLines, m_validLines) : m_validLines;
+    const qint64 convergeLine = qMax(line + insertedLines + 1, oldStart > editEnd ? oldStart + delta : 0);
+    const qint64 knownLines = oldEnd > editEnd + 1 ? oldEnd + delta : 0;
+    m_validLines = qMin(m_validLines, line + 1);
+    if (knownLines > convergeLine)
+    {
+        m_convergeLine = convergeLine;
+        m_knownLines = knownLines;
+    }
+    else
+    {
+        m_convergeLine = -1;
+        m_knownLines = 0;
+    }
+    if (m_lineCount >= 0)
+        m_lineCount += delta;
+
+    // Lines after the edit move; the edited line shows its old spans until
+    // it is lexed again
+    QHash<qint64, CachedLine> lines;
+    for (auto it = m_lines.cbegin(); it != m_lines.cend(); ++it)
+    {
+        if (it.key() < line)
+        {
+            lines.insert(it.key(), it.value());
+        }
+        else if (it.key() == line)
+        {
+            CachedLine cached = it.value();
+            cached.stale = true;
+            lines.insert(line, cached);
+        }
+        else if (it.key() > editEnd)
+        {
+            lines.insert(it.key() + delta, it.value());
+        }
+    }
+    m_lines.swap(lines);
+    scheduleJob();
+}
+
+void SyntaxHighlighter::linesChangedAfter(qint64 line)
+{
+    cancelJob();
+    if (line + 1 < m_states.size())
+        m_states.resize(line + 1);
+    m_validLines = qMin(m_validLines, line + 1);
+    m_convergeLine = -1;
+    m_knownLines = 0;
+    m_lineCount = -1;
+
+    for (auto it = m_lines.begin(); it != m_lines.end();)
+    {
+        if (it.key() > line)
+        {
+            it = m_lines.erase(it);
+        }
+        else
+        {
+            if (it.key() == line)
+                it.value().stale = true;
+            ++it;
+        }
+    }
+    scheduleJob();
+}
+
+void SyntaxHighlighter::setVisibleLines(qint64 first, qint64 count)
+{
+    if (first == m_visibleFirst && count == m_visibleCount)
+        return;
+    m_visibleFirst = first;
+    m_visibleCount = count;
+    scheduleJob();
+}
+
+const QVector<HighlightSpan> *SyntaxHighlighter::lineSpans(qint64 line) const
+{
+    const auto it = m_lines.constFind(line);
+    return it == m_lines.cend() ? nullptr : &it.value().spans;
+}
+
+LineState SyntaxHighlighter::expectedState(qint64 line) const
+{
+    if (line < m_validLines)
+        return m_states.at(line);
+    const auto previous = m_lines.constFind(line - 1);
+    if (previous != m_lines.cend() && !previous.value().stale)
+        return previous.value().nextState;
+    return line < m_states.size() ? m_states.at(line) : LineState::Normal;
+}
+
+qint64 SyntaxHighlighter::firstLineToLex() const
+{
+    qint64 end = m_visibleFirst + m_visibleCount;
+    if (m_lineCount >= 0)
+        end = qMin(end, m_lineCount);
+    for (qint64 line = m_visibleFirst; line < end; ++line)
+    {
+        const auto it = m_lines.constFind(line);
+        if (it == m_lines.cend() || it.value().stale || it.value().state != expectedState(line))
+            return line;
+    }
+    return -1;
+}
+
+qint64 SyntaxHighlighter::backgroundTarget() const
+{
+    // Exact states for the visible lines, and for the old states after an
+    // edit until they are confirmed
+    qint64 target = m_visibleFirst + m_visibleCount;
+    if (m_convergeLine >= 0)
+        target = qMax(target, m_knownLines);
+    if (m_lineCount >= 0)
+        target = qMin(target, m_lineCount);
+    return target;
+}
+
+void SyntaxHighlighter::scheduleJob()
+{
+    // A running job schedules the next one when its batch is applied
+    if (!m_cancelled)
+        m_jobTimer->start();
+}
+
+void SyntaxHighlighter::cancelJob()
+{
+    if (m_cancelled)
+        m_cancelled->store(true);
+    m_cancelled.reset();
+    ++m_generation;
+}
+
+void SyntaxHighlighter::startJob()
+{
+    if (m_cancelled)
+        return;
+    const qint64 visibleFirst = firstLineToLex();
+    const bool background = m_validLines < backgroundTarget();
+    if (visibleFirst < 0 && !background)
+        return;
+
+    auto batch = std::make_shared<Batch>();
+    batch->generation = m_generation;
+    if (visibleFirst >= 0)
+    {
+        batch->visibleFirst = visibleFirst;
+        batch->visibleState = expectedState(visibleFirst);
+    }
+    if (background)
+        batch->backgroundFirst = m_validLines - 1;
+    const LineState backgroundState = background ? m_states.at(m_validLines - 1) : LineState::Normal;
+    const qint64 visibleCount = m_visibleFirst + m_visibleCount - visibleFirst;
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_cancelled = cancelled;
+    auto snapshot = std::make_shared<PieceTable>(m_buffer->snapshot());
+    QPointer<SyntaxHighlighter> guard(this);
+    QThreadPool::globalInstance()->start([guard, batch, snapshot, cancelled, backgroundState, visibleCount]() {
+        // Visible lines first: they decide what the user sees next
+        if (batch->visibleFirst >= 0)
+        {
+            batch->visibleEnded = !highlightLines(*snapshot, batch->visibleFirst, batch->visibleState, visibleCount,
+                                                  BatchBytes, batch->visibleNext, &batch->visibleSpans, *cancelled);
+        }
+        if (batch->backgroundFirst >= 0)
+        {
+            batch->backgroundEnded = !highlightLines(*snapshot, batch->backgroundFirst, backgroundState, BatchLines,
+                                                     BatchBytes, batch->backgroundNext, nullptr, *cancelled);
+        }
+        if (cancelled->load())
+            return;
+
+        QMetaObject::invokeMethod(qApp, [guard, batch]() {
+            if (guard)
+                guard->applyBatch(*batch);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SyntaxHighlighter::applyBatch(Batch &batch)
+{
+    if (batch.generation != m_generation)
+        return;
+    m_cancelled.reset();
+
+    if (batch.backgroundFirst >= 0)
+    {
+        qint64 line = batch.backgroundFirst;
+        for (const LineState state : batch.backgroundNext)
+        {
+            ++line;
+            LineState previous = state;
+            if (line < m_states.size())
+            {
+                previous = m_states.at(line);
+                m_states.set(line, state);
+            }
+            else
+            {
+                m_states.append(state);
+            }
+            m_validLines = line + 1;
+
+            if (m_convergeLine >= 0 && line >= m_convergeLine && line < m_knownLines && previous == state)
+            {
+                // Starts as before the edit, so do all lines after it
+                m_validLines = m_knownLines;
+                m_convergeLine = -1;
+                break;
+            }
+        }
+        if (m_convergeLine >= 0 && m_validLines >= m_knownLines)
+            m_convergeLine = -1;
+        if (batch.backgroundEnded)
+        {
+            // The last state is the one after the last line
+            m_lineCount = batch.backgroundFirst + qint64(batch.backgroundNext.size());
+            m_states.resize(m_lineCount + 1);
+            m_validLines = qMin(m_validLines, m_lineCount + 1);
+        }
+    }
+
+    if (batch.visibleFirst >= 0)
+    {
+        LineState state = batch.visibleState;
+        for (size_t i = 0; i < batch.visibleSpans.size(); ++i)
+        {
+            CachedLine &cached = m_lines[batch.visibleFirst + qint64(i)];
+            cached.state = state;
+            cached.nextState = batch.visibleNext[i];
+            cached.stale = false;
+            cached.spans = std::move(batch.visibleSpans[i]);
+            state = cached.nextState;
+        }
+        if (batch.visibleEnded)
+            m_lineCount = batch.visibleFirst + qint64(batch.visibleSpans.size());
+    }
+
+    for (auto it = m_lines.begin(); it != m_lines.end();)
+    {
+        if (it.key() < m_visibleFirst - CacheMargin || it.key() >= m_visibleFirst + m_visibleCount + CacheMargin)
+            it = m_lines.erase(it);
+        else
+            ++it;
+    }
+
+    emit linesHighlighted(m_visibleFirst, m_visibleCount);
+    scheduleJob();
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "PieceTable.h"
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+// ---------------------------------------------------------------------------
+// C/C++ lexing, one line at a time
+// ---------------------------------------------------------------------------
+enum class HighlightFormat : quint8
+{
+    Keyword,
+    Number,
+    String,
+    Comment,
+    Preprocessor
+};
+
+struct HighlightSpan
+{
+    quint32 start = 0; // byte offset in the line
+    quint32 length = 0;
+    HighlightFormat format = HighlightFormat::Keyword;
+};
+
+// What a line inherits from the lines before it
+enum class LineState : quint8
+{
+    Normal,
+    BlockComment,
+    String,      // continued with a trailing backslash
+    Preprocessor // continued with a trailing backslash
+};
+
+// Lexes one line (without its '\n') that starts in state; appends its
+// spans if spans is not null and returns the state the next line starts in
+LineState highlightLine(const char *data, qint64 size, LineState state, QVector<HighlightSpan> *spans);
+
+// Lexes lines of buffer from firstLine, which starts in state, until
+// maxLines lines or about maxBytes are done or the text ends. Appends the
+// start state of each following line to nextStates and, if spans is not
+// null, the spans of each lexed line. Returns false once the text ended.
+// Lines longer than maxBytes are cut there.
+bool highlightLines(PieceTable &buffer, qint64 firstLine, LineState state, qint64 maxLines, qint64 maxBytes,
+                    std::vector<LineState> &nextStates, std::vector<QVector<HighlightSpan>> *spans,
+                    const std::atomic_bool &cancelled);
+
+// ---------------------------------------------------------------------------
+// Start states of lines in a gap buffer. An edit replaces the lines at one
+// spot; the gap stays there, so the next edit close by, as in typing, only
+// moves the states between the two.
+// ---------------------------------------------------------------------------
+class LineStateBuffer
+{
+public:
+    qint64 size() const { return qint64(m_data.size()) - (m_gapEnd - m_gapStart); }
+    LineState at(qint64 line) const { return m_data[index(line)]; }
+    void set(qint64 line, LineState state) { m_data[index(line)] = state; }
+    void append(LineState state);
+    void resize(qint64 size); // new lines start Normal
+    // Replaces removed lines from line by inserted Normal ones
+    void replace(qint64 line, qint64 removed, qint64 inserted);
+
+private:
+    size_t index(qint64 line) const { return size_t(line < m_gapStart ? line : line + m_gapEnd - m_gapStart); }
+    void moveGap(qint64 to);
+    void reserveGap(qint64 size);
+
+    std::vector<LineState> m_data{LineState::Normal};
+    qint64 m_gapStart = 1;
+    qint64 m_gapEnd = 1;
+};
+
+// ---------------------------------------------------------------------------
+// Incremental background highlighter for a TextView's buffer.
+//
+// The state each line starts in is kept for every line lexed so far; those
+// of the first validLines lines are known to be right. An edit keeps the
+// states before it and shifts the ones after it. Work then runs on the
+// thread pool against PieceTable::snapshot(), one batch per job:
+//
+// 1. The visible lines, if any lack spans, from the best state known for
+//    the first of them, so what is on screen is coloured at once.
+// 2. Re-lexing from the first line that is not valid, until a line again
+//    starts in the state it had before the edit (the states after it are
+//    then right as well), or the visible lines are covered.
+//
+// Batches are applied on the GUI thread; spans lexed from a state that
+// turned out wrong are redone by the next job. Spans are only cached near
+// the visible lines.
+// ---------------------------------------------------------------------------
+class SyntaxHighlighter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SyntaxHighlighter(PieceTable *buffer, QObject *parent = nullptr);
+    ~SyntaxHighlighter() override;
+
+    // The buffer was replaced
+    void reset();
+    // After an edit, see PieceTable::Change
+    void linesChanged(qint64 line, qint64 removedLines, qint64 insertedLines);
+    // After an edit somewhere after the start of line, when it is not known
+    // which lines it replaced
+    void linesChangedAfter(qint64 line);
+    void setVisibleLines(qint64 first, qint64 count);
+
+    // Spans of line, possibly of its text before the last edit; null if not
+    // lexed yet
+    const QVector<HighlightSpan> *lineSpans(qint64 line) const;
+
+    qint64 validLines() const { return m_validLines; }
+    bool isBusy() const { return bool(m_cancelled); }
+
+signals:
+    void linesHighlighted(qint64 first, qint64 count);
+
+private:
+    struct CachedLine
+    {
+        LineState state = LineState::Normal;     // state it was lexed from
+        LineState nextState = LineState::Normal; // state the next line starts in
+        bool stale = false;                      // the line was edited since
+        QVector<HighlightSpan> spans;
+    };
+    struct Batch;
+
+    LineState expectedState(qint64 line) const;
+    qint64 firstLineToLex() const; // first visible line without current spans, or -1
+    qint64 backgroundTarget() const;
+    void scheduleJob();
+    void startJob();
+    void cancelJob();
+    void applyBatch(Batch &batch);
+
+    PieceTable *m_buffer = nullptr;
+    QTimer *m_jobTimer = nullptr;
+    std::shared_ptr<std::atomic_bool> m_cancelled; // set while a job runs
+    quint64 m_generation = 0;
+
+    LineStateBuffer m_states;
+    qint64 m_validLines = 1;
+    // States of [m_convergeLine, m_knownLines) were right before an edit
+    // above them; -1 when no edit is pending
+    qint64 m_convergeLine = -1;
+    qint64 m_knownLines = 0;
+    qint64 m_lineCount = -1;    // -1 until a job reached the end
+
+    QHash<qint64, CachedLine> m_lines;
+    qint64 m_visibleFirst = 0;
+    qint64 m_visibleCount = 0;
+};
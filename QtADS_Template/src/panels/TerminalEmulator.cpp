@@ -0,0 +1,1043 @@
+#include "TerminalEmulator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// ---------------------------------------------------------------------------
+// Parser transition table
+// ---------------------------------------------------------------------------
+enum Action : quint8
+{
+    NoAction,
+    Print,
+    Execute,
+    Clear,
+    Collect,
+    Param,
+    EscDispatch,
+    CsiDispatch,
+    OscPut,
+    OscEnd
+};
+
+// Each entry is the action in the high nibble and the next state in the low
+// one, for every state and byte
+struct ParserTable
+{
+    quint8 entries[VtParser::StateCount][256];
+
+    ParserTable()
+    {
+        for (int state = 0; state < VtParser::StateCount; ++state)
+            set(VtParser::State(state), 0x00, 0xff, NoAction, VtParser::State(state));
+
+        // C0 controls run in every state but the string ones
+        for (int state = VtParser::Ground; state <= VtParser::CsiIgnore; ++state)
+        {
+            const auto s = VtParser::State(state);
+            set(s, 0x00, 0x17, Execute, s);
+            set(s, 0x19, 0x19, Execute, s);
+            set(s, 0x1c, 0x1f, Execute, s);
+        }
+
+        set(VtParser::Ground, 0x20, 0x7e, Print, VtParser::Ground);
+        set(VtParser::Ground, 0x80, 0xff, Print, VtParser::Ground);
+
+        set(VtParser::Escape, 0x20, 0x2f, Collect, VtParser::EscapeIntermediate);
+        set(VtParser::Escape, 0x30, 0x7e, EscDispatch, VtParser::Ground);
+        set(VtParser::Escape, '[', '[', Clear, VtParser::CsiEntry);
+        set(VtParser::Escape, ']', ']', Clear, VtParser::OscString);
+        for (const char c : {'P', 'X', '^', '_'})
+            set(VtParser::Escape, c, c, NoAction, VtParser::IgnoreString);
+        set(VtParser::Escape, 0x80, 0xff, NoAction, VtParser::Ground);
+
+        set(VtParser::EscapeIntermediate, 0x20, 0x2f, Collect, VtParser::EscapeIntermediate);
+        set(VtParser::EscapeIntermediate, 0x30, 0x7e, EscDispatch, VtParser::Ground);
+
+        set(VtParser::CsiEntry, 0x20, 0x2f, Collect, VtParser::CsiIntermediate);
+        set(VtParser::CsiEntry, 0x30, 0x3b, Param, VtParser::CsiParam);
+        set(VtParser::CsiEntry, 0x3c, 0x3f, Collect, VtParser::CsiParam);
+        set(VtParser::CsiEntry, 0x40, 0x7e, CsiDispatch, VtParser::Ground);
+
+        set(VtParser::CsiParam, 0x20, 0x2f, Collect, VtParser::CsiIntermediate);
+        set(VtParser::CsiParam, 0x30, 0x3b, Param, VtParser::CsiParam);
+        set(VtParser::CsiParam, 0x3c, 0x3f, NoAction, VtParser::CsiIgnore);
+        set(VtParser::CsiParam, 0x40, 0x7e, CsiDispatch, VtParser::Ground);
+
+        set(VtParser::CsiIntermediate, 0x20, 0x2f, Collect, VtParser::CsiIntermediate);
+        set(VtParser::CsiIntermediate, 0x30, 0x3f, NoAction, VtParser::CsiIgnore);
+        set(VtParser::CsiIntermediate, 0x40, 0x7e, CsiDispatch, VtParser::Ground);
+
+        set(VtParser::CsiIgnore, 0x40, 0x7e, NoAction, VtParser::Ground);
+
+        // Strings end at BEL as well as at ST (ESC \)
+        set(VtParser::OscString, 0x20, 0xff, OscPut, VtParser::OscString);
+        set(VtParser::OscString, 0x07, 0x07, OscEnd, VtParser::Ground);
+        set(VtParser::IgnoreString, 0x07, 0x07, NoAction, VtParser::Ground);
+
+        // Anywhere: CAN and SUB abort, ESC starts over
+        for (int state = 0; state < VtParser::StateCount; ++state)
+        {
+            const auto s = VtParser::State(state);
+            const bool osc = s == VtParser::OscString;
+            const bool string = osc || s == VtParser::IgnoreString;
+            set(s, 0x18, 0x18, string ? NoAction : Execute, VtParser::Ground);
+            set(s, 0x1a, 0x1a, string ? NoAction : Execute, VtParser::Ground);
+            set(s, 0x1b, 0x1b, osc ? OscEnd : Clear, VtParser::Escape);
+        }
+    }
+
+    void set(VtParser::State state, int first, int last, Action action, VtParser::State next)
+    {
+        for (int byte = first; byte <= last; ++byte)
+            entries[state][byte] = quint8(action << 4 | next);
+    }
+};
+
+const ParserTable &parserTable()
+{
+    static const ParserTable table;
+    return table;
+}
+
+constexpr char32_t ReplacementCharacter = 0xfffd;
+constexpr int MaxParamValue = 65535;
+
+// Scrollback budget per line slot; shorter lines run out of slots first,
+// longer ones out of cells
+constexpr qint64 AverageLineCells = 32;
+
+bool isBlank(const TerminalCell &cell)
+{
+    return cell.ch == U' ' && cell.flags == (TerminalCell::DefaultForeground | TerminalCell::DefaultBackground);
+}
+
+int colorLevel(int value)
+{
+    return value < 48 ? 0 : value < 115 ? 1 : (value - 35) / 40;
+}
+
+// Nearest xterm palette index of a 24-bit colour
+quint8 paletteIndex(int red, int green, int blue)
+{
+    red = qBound(0, red, 255);
+    green = qBound(0, green, 255);
+    blue = qBound(0, blue, 255);
+    if (red == green && green == blue)
+    {
+        if (red < 8)
+            return 16;
+        if (red > 238)
+            return 231;
+        return quint8(232 + (red - 8) / 10);
+    }
+    return quint8(16 + 36 * colorLevel(red) + 6 * colorLevel(green) + colorLevel(blue));
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// VtParser
+// ---------------------------------------------------------------------------
+void VtParser::feed(const char *data, qint64 size, VtHandler &handler)
+{
+    const ParserTable &table = parserTable();
+    qint64 i = 0;
+    while (i < size)
+    {
+        const uchar byte = uchar(data[i]);
+        if (m_utf8Pending > 0 && byte < 0x80)
+        {
+            m_utf8Pending = 0;
+            handler.printCodePoint(ReplacementCharacter);
+        }
+
+        // Fast path: plain text goes to the handler as one run
+        if (m_state == Ground && byte >= 0x20 && byte < 0x7f)
+        {
+            qint64 end = i + 1;
+            while (end < size && uchar(data[end]) >= 0x20 && uchar(data[end]) < 0x7f)
+                ++end;
+            handler.print(data + i, end - i);
+            i = end;
+            continue;
+        }
+
+        const quint8 entry = table.entries[m_state][byte];
+        switch (Action(entry >> 4))
+        {
+        case NoAction:
+            break;
+        case Print:
+            printUtf8(byte, handler);
+            break;
+        case Execute:
+            handler.execute(char(byte));
+            break;
+        case Clear:
+            clear();
+            break;
+        case Collect:
+            if (byte >= 0x3c)
+                m_marker = char(byte);
+            else
+                m_intermediate = char(byte);
+            break;
+        case Param:
+            if (m_paramCount == 0)
+            {
+                m_params[0] = 0;
+                m_paramCount = 1;
+            }
+            if (byte == ';' || byte == ':')
+            {
+                if (m_paramCount < MaxParams)
+                    m_params[m_paramCount++] = 0;
+            }
+            else
+            {
+                int &value = m_params[m_paramCount - 1];
+                value = qMin(value * 10 + (byte - '0'), MaxParamValue);
+            }
+            break;
+        case EscDispatch:
+            handler.escDispatch(*this, char(byte));
+            break;
+        case CsiDispatch:
+            handler.csiDispatch(*this, char(byte));
+            break;
+        case OscPut:
+            if (m_osc.size() < MaxOscBytes)
+                m_osc.append(char(byte));
+            break;
+        case OscEnd:
+            handler.oscDispatch(m_osc);
+            clear();
+            break;
+        }
+        m_state = State(entry & 0x0f);
+        ++i;
+    }
+}
+
+void VtParser::reset()
+{
+    m_state = Ground;
+    m_utf8Pending = 0;
+    clear();
+}
+
+int VtParser::param(int index, int defaultValue) const
+{
+    if (index >= m_paramCount || m_params[index] == 0)
+        return defaultValue;
+    return m_params[index];
+}
+
+void VtParser::clear()
+{
+    m_paramCount = 0;
+    m_marker = 0;
+    m_intermediate = 0;
+    m_osc.clear();
+}
+
+void VtParser::printUtf8(uchar byte, VtHandler &handler)
+{
+    if (m_utf8Pending > 0)
+    {
+        if ((byte & 0xc0) == 0x80)
+        {
+            m_codePoint = m_codePoint << 6 | (byte & 0x3f);
+            if (--m_utf8Pending == 0)
+                handler.printCodePoint(m_codePoint);
+            return;
+        }
+        // A lead byte cut the sequence short
+        m_utf8Pending = 0;
+        handler.printCodePoint(ReplacementCharacter);
+    }
+
+    if ((byte & 0xe0) == 0xc0)
+    {
+        m_codePoint = byte & 0x1f;
+        m_utf8Pending = 1;
+    }
+    else if ((byte & 0xf0) == 0xe0)
+    {
+        m_codePoint = byte & 0x0f;
+        m_utf8Pending = 2;
+    }
+    else if ((byte & 0xf8) == 0xf0)
+    {
+        m_codePoint = byte & 0x07;
+        m_utf8Pending = 3;
+    }
+    else
+    {
+        handler.printCodePoint(ReplacementCharacter);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TerminalScrollback
+// ---------------------------------------------------------------------------
+TerminalScrollback::TerminalScrollback(qint64 maxBytes)
+{
+    const qint64 lineBytes = qint64(sizeof(Line) + AverageLineCells * sizeof(TerminalCell));
+    m_lineCapacity = qMax<qint64>(1, maxBytes / lineBytes);
+    m_cellCapacity = qMax<qint64>(AverageLineCells, m_lineCapacity * AverageLineCells);
+}
+
+void TerminalScrollback::push(const TerminalCell *cells, int count, bool wrapped)
+{
+    count = int(qMin<qint64>(count, m_cellCapacity));
+    const qint64 extent = qMax(count, 1);
+
+    if (m_lineCount == m_lineCapacity)
+        dropOldest();
+
+    // Lines are never split at the end of the ring; the lines between m_head
+    // and the end are the oldest, so they go before the front is reused
+    if (m_head + extent > m_cellCapacity)
+    {
+        while (m_lineCount > 0 && lineAt(0).start >= m_head)
+            dropOldest();
+        m_head = 0;
+    }
+    while (m_lineCount > 0)
+    {
+        const Line &oldest = lineAt(0);
+        if (oldest.start >= m_head + extent || oldest.start + qMax(oldest.length, 1) <= m_head)
+            break;
+        dropOldest();
+    }
+
+    if (m_head + extent > qint64(m_cells.size()))
+        m_cells.resize(size_t(qMin(m_cellCapacity, qMax(qint64(m_cells.size()) * 2, m_head + extent))));
+    std::copy(cells, cells + count, m_cells.begin() + m_head);
+
+    const Line line{m_head, count, wrapped};
+    if (qint64(m_lines.size()) < m_lineCapacity)
+        m_lines.push_back(line);
+    else
+        m_lines[size_t((m_firstLine + m_lineCount) % m_lineCapacity)] = line;
+    ++m_lineCount;
+    m_head += extent;
+}
+
+void TerminalScrollback::clear()
+{
+    std::vector<TerminalCell>().swap(m_cells);
+    std::vector<Line>().swap(m_lines);
+    m_droppedLines += quint64(m_lineCount);
+    m_firstLine = 0;
+    m_lineCount = 0;
+    m_head = 0;
+}
+
+const TerminalCell *TerminalScrollback::line(qint64 index, int *length) const
+{
+    const Line &line = lineAt(index);
+    *length = line.length;
+    return m_cells.data() + line.start;
+}
+
+bool TerminalScrollback::isWrapped(qint64 index) const
+{
+    return lineAt(index).wrapped;
+}
+
+const TerminalScrollback::Line &TerminalScrollback::lineAt(qint64 index) const
+{
+    return m_lines[size_t((m_firstLine + index) % m_lineCapacity)];
+}
+
+void TerminalScrollback::dropOldest()
+{
+    if (++m_firstLine == m_lineCapacity)
+        m_firstLine = 0;
+    --m_lineCount;
+    ++m_droppedLines;
+}
+
+// ---------------------------------------------------------------------------
+// TerminalScreen
+// ---------------------------------------------------------------------------
+TerminalScreen::TerminalScreen(int rows, int columns, qint64 scrollbackBytes)
+    : m_scrollback(scrollbackBytes)
+{
+    resize(rows, columns);
+}
+
+void TerminalScreen::feed(const char *data, qint64 size)
+{
+    m_parser.feed(data, size, *this);
+}
+
+void TerminalScreen::resize(int rows, int columns)
+{
+    rows = qMax(1, rows);
+    columns = qMax(1, columns);
+    if (rows == m_rows && columns == m_columns)
+        return;
+
+    // Keep the cursor on screen by moving the lines above it out
+    const int excess = m_cursorRow - rows + 1;
+    if (excess > 0)
+    {
+        for (int row = 0; row < excess && !m_alternate; ++row)
+            pushToScrollback(line(row));
+        normalizeLines();
+        m_lines.erase(m_lines.begin(), m_lines.begin() + excess);
+        m_cursorRow -= excess;
+    }
+
+    normalizeLines();
+    for (std::vector<ScreenLine> *lines : {&m_lines, &m_otherLines})
+    {
+        if (lines->empty() && lines == &m_otherLines)
+            continue;
+        lines->resize(size_t(rows));
+        for (ScreenLine &line : *lines)
+            line.cells.resize(size_t(columns));
+    }
+
+    m_rows = rows;
+    m_columns = columns;
+    m_cursorColumn = qMin(m_cursorColumn, columns - 1);
+    m_saved.row = qMin(m_saved.row, rows - 1);
+    m_saved.column = qMin(m_saved.column, columns - 1);
+    m_scrollTop = 0;
+    m_scrollBottom = rows - 1;
+    m_dirty.assign(size_t(rows), DirtySpan());
+    markAllDirty();
+}
+
+QByteArray TerminalScreen::takeResponse()
+{
+    QByteArray response;
+    response.swap(m_response);
+    return response;
+}
+
+TerminalScreen::DirtySpan TerminalScreen::dirtySpan(int row) const
+{
+    return m_allDirty ? DirtySpan{0, m_columns} : m_dirty[size_t(row)];
+}
+
+void TerminalScreen::clearDirty()
+{
+    std::fill(m_dirty.begin(), m_dirty.end(), DirtySpan());
+    m_allDirty = false;
+    m_scrolledLines = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Text and controls
+// ---------------------------------------------------------------------------
+void TerminalScreen::print(const char *text, qint64 size)
+{
+    while (size > 0)
+    {
+        wrapIfPending();
+        const int count = int(qMin<qint64>(size, m_columns - m_cursorColumn));
+        TerminalCell *cells = line(m_cursorRow).cells.data() + m_cursorColumn;
+        for (int i = 0; i < count; ++i)
+        {
+            cells[i] = m_pen;
+            cells[i].ch = char32_t(uchar(text[i]));
+        }
+        markDirty(m_cursorRow, m_cursorColumn, m_cursorColumn + count);
+        m_cursorColumn += count;
+        text += count;
+        size -= count;
+    }
+}
+
+void TerminalScreen::printCodePoint(char32_t codePoint)
+{
+    wrapIfPending();
+    TerminalCell &cell = line(m_cursorRow).cells[size_t(m_cursorColumn)];
+    cell = m_pen;
+    cell.ch = codePoint;
+    markDirty(m_cursorRow, m_cursorColumn, m_cursorColumn + 1);
+    ++m_cursorColumn;
+}
+
+// A cursor past the last column wraps before the next character
+void TerminalScreen::wrapIfPending()
+{
+    if (m_cursorColumn < m_columns)
+        return;
+    if (m_autoWrap)
+    {
+        line(m_cursorRow).wrapped = true;
+        m_cursorColumn = 0;
+        lineFeed();
+    }
+    else
+    {
+        m_cursorColumn = m_columns - 1;
+    }
+}
+
+void TerminalScreen::execute(char control)
+{
+    const int column = cursorColumn();
+    switch (control)
+    {
+    case '\b':
+        m_cursorColumn = qMax(0, column - 1);
+        break;
+    case '\t':
+        m_cursorColumn = qMin(m_columns - 1, (column / 8 + 1) * 8);
+        break;
+    case '\n':
+    case '\v':
+    case '\f':
+        m_cursorColumn = column;
+        lineFeed();
+        break;
+    case '\r':
+        m_cursorColumn = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::lineFeed()
+{
+    if (m_cursorRow != m_scrollBottom)
+    {
+        m_cursorRow = qMin(m_cursorRow + 1, m_rows - 1);
+        return;
+    }
+    // Lines leaving the top of the main screen go to the scrollback
+    if (m_scrollTop == 0 && !m_alternate)
+        pushToScrollback(line(0));
+    scrollUp(m_scrollTop, m_scrollBottom, 1);
+}
+
+void TerminalScreen::pushToScrollback(const ScreenLine &line)
+{
+    // Trailing blanks are not stored
+    int count = int(line.cells.size());
+    while (count > 0 && isBlank(line.cells[size_t(count - 1)]))
+        --count;
+    m_scrollback.push(line.cells.data(), count, line.wrapped);
+    ++m_scrolledLines;
+}
+
+void TerminalScreen::scrollUp(int top, int bottom, int count)
+{
+    count = qMin(count, bottom - top + 1);
+    if (count <= 0)
+        return;
+    if (top == 0 && bottom == m_rows - 1)
+    {
+        // The whole screen: move the ring instead of the lines
+        m_topLine = (m_topLine + count) % m_rows;
+        markAllDirty();
+    }
+    else
+    {
+        for (int row = top; row + count <= bottom; ++row)
+            std::swap(line(row), line(row + count));
+        for (int row = top; row <= bottom; ++row)
+            markDirty(row, 0, m_columns);
+    }
+    eraseLines(bottom - count + 1, bottom);
+}
+
+void TerminalScreen::scrollDown(int top, int bottom, int count)
+{
+    count = qMin(count, bottom - top + 1);
+    if (count <= 0)
+        return;
+    for (int row = bottom; row - count >= top; --row)
+        std::swap(line(row), line(row - count));
+    eraseLines(top, top + count - 1);
+    for (int row = top; row <= bottom; ++row)
+        markDirty(row, 0, m_columns);
+}
+
+void TerminalScreen::eraseCells(int row, int first, int last)
+{
+    first = qBound(0, first, m_columns);
+    last = qBound(first, last, m_columns);
+    ScreenLine &erased = line(row);
+    std::fill(erased.cells.begin() + first, erased.cells.begin() + last, blank());
+    if (last == m_columns)
+        erased.wrapped = false;
+    markDirty(row, first, last);
+}
+
+void TerminalScreen::eraseLines(int first, int last)
+{
+    for (int row = qMax(0, first); row <= qMin(last, m_rows - 1); ++row)
+        eraseCells(row, 0, m_columns);
+}
+
+void TerminalScreen::moveCursor(int row, int column)
+{
+    m_cursorRow = qBound(0, row, m_rows - 1);
+    m_cursorColumn = qBound(0, column, m_columns - 1);
+}
+
+// ---------------------------------------------------------------------------
+// Escape sequences
+// ---------------------------------------------------------------------------
+void TerminalScreen::escDispatch(const VtParser &parser, char final)
+{
+    // Character set designations and the like are not supported
+    if (parser.intermediate() != 0)
+        return;
+
+    switch (final)
+    {
+    case '7':
+        saveCursor();
+        break;
+    case '8':
+        restoreCursor();
+        break;
+    case 'D':
+        m_cursorColumn = cursorColumn();
+        lineFeed();
+        break;
+    case 'E':
+        m_cursorColumn = 0;
+        lineFeed();
+        break;
+    case 'M':
+        m_cursorColumn = cursorColumn();
+        if (m_cursorRow == m_scrollTop)
+            scrollDown(m_scrollTop, m_scrollBottom, 1);
+        else
+            m_cursorRow = qMax(0, m_cursorRow - 1);
+        break;
+    case 'c':
+        fullReset();
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::csiDispatch(const VtParser &parser, char final)
+{
+    if (parser.privateMarker() == '?' && parser.intermediate() == 0)
+    {
+        if (final == 'h' || final == 'l')
+            setMode(parser, final == 'h');
+        return;
+    }
+    if (parser.privateMarker() != 0 || parser.intermediate() != 0)
+    {
+        if (parser.privateMarker() == '>' && final == 'c')
+            m_response += "\x1b[>0;10;1c";
+        return;
+    }
+
+    const int row = m_cursorRow;
+    const int column = cursorColumn();
+    const int count = parser.param(0, 1);
+    switch (final)
+    {
+    case 'A':
+        moveCursor(row - count, column);
+        break;
+    case 'B':
+    case 'e':
+        moveCursor(row + count, column);
+        break;
+    case 'C':
+    case 'a':
+        moveCursor(row, column + count);
+        break;
+    case 'D':
+        moveCursor(row, column - count);
+        break;
+    case 'E':
+        moveCursor(row + count, 0);
+        break;
+    case 'F':
+        moveCursor(row - count, 0);
+        break;
+    case 'G':
+    case '`':
+        moveCursor(row, count - 1);
+        break;
+    case 'd':
+        moveCursor(count - 1, column);
+        break;
+    case 'H':
+    case 'f':
+        moveCursor(parser.param(0, 1) - 1, parser.param(1, 1) - 1);
+        break;
+    case 'J':
+        switch (parser.param(0, 0))
+        {
+        case 0:
+            eraseCells(row, column, m_columns);
+            eraseLines(row + 1, m_rows - 1);
+            break;
+        case 1:
+            eraseLines(0, row - 1);
+            eraseCells(row, 0, column + 1);
+            break;
+        case 2:
+            eraseLines(0, m_rows - 1);
+            break;
+        case 3:
+            m_scrollback.clear();
+            markAllDirty();
+            break;
+        default:
+            break;
+        }
+        break;
+    case 'K':
+        switch (parser.param(0, 0))
+        {
+        case 0:
+            eraseCells(row, column, m_columns);
+            break;
+        case 1:
+            eraseCells(row, 0, column + 1);
+            break;
+        case 2:
+            eraseCells(row, 0, m_columns);
+            break;
+        default:
+            break;
+        }
+        break;
+    case 'L':
+    case 'M':
+        if (row >= m_scrollTop && row <= m_scrollBottom)
+        {
+            if (final == 'L')
+                scrollDown(row, m_scrollBottom, count);
+            else
+                scrollUp(row, m_scrollBottom, count);
+            m_cursorColumn = 0;
+        }
+        break;
+    case 'P':
+    case '@':
+    {
+        std::vector<TerminalCell> &cells = line(row).cells;
+        const int shift = qMin(count, m_columns - column);
+        if (final == 'P')
+        {
+            std::copy(cells.begin() + column + shift, cells.end(), cells.begin() + column);
+            std::fill(cells.end() - shift, cells.end(), blank());
+        }
+        else
+        {
+            std::copy_backward(cells.begin() + column, cells.end() - shift, cells.end());
+            std::fill(cells.begin() + column, cells.begin() + column + shift, blank());
+        }
+        m_cursorColumn = column;
+        markDirty(row, column, m_columns);
+        break;
+    }
+    case 'X':
+        eraseCells(row, column, column + count);
+        break;
+    case 'S':
+        scrollUp(m_scrollTop, m_scrollBottom, count);
+        break;
+    case 'T':
+        scrollDown(m_scrollTop, m_scrollBottom, count);
+        break;
+    case 'm':
+        applyGraphicsRendition(parser, &m_pen);
+        break;
+    case 'r':
+    {
+        const int top = parser.param(0, 1) - 1;
+        const int bottom = parser.param(1, m_rows) - 1;
+        if (top < bottom && bottom < m_rows)
+        {
+            m_scrollTop = top;
+            m_scrollBottom = bottom;
+        }
+        moveCursor(0, 0);
+        break;
+    }
+    case 's':
+        saveCursor();
+        break;
+    case 'u':
+        restoreCursor();
+        break;
+    case 'n':
+        if (parser.param(0, 0) == 5)
+            m_response += "\x1b[0n";
+        else if (parser.param(0, 0) == 6)
+            m_response += "\x1b[" + QByteArray::number(row + 1) + ';' + QByteArray::number(column + 1) + 'R';
+        break;
+    case 'c':
+        if (parser.param(0, 0) == 0)
+            m_response += "\x1b[?1;2c";
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::oscDispatch(const QByteArray &data)
+{
+    // 0 and 2 set the window title
+    const int separator = data.indexOf(';');
+    const QByteArray command = data.left(separator);
+    if (separator > 0 && (command == "0" || command == "2"))
+        m_title = QString::fromUtf8(data.mid(separator + 1));
+}
+
+void TerminalScreen::setMode(const VtParser &parser, bool enabled)
+{
+    for (int i = 0; i < qMax(1, parser.paramCount()); ++i)
+    {
+        switch (parser.param(i, 0))
+        {
+        case 1:
+            m_applicationCursorKeys = enabled;
+            break;
+        case 7:
+            m_autoWrap = enabled;
+            break;
+        case 25:
+            m_cursorVisible = enabled;
+            break;
+        case 47:
+        case 1047:
+            switchScreen(enabled);
+            break;
+        case 1049:
+            if (enabled)
+            {
+                saveCursor();
+                switchScreen(true);
+            }
+            else
+            {
+                switchScreen(false);
+                restoreCursor();
+            }
+            break;
+        case 2004:
+            m_bracketedPaste = enabled;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Screens, cursor and reset
+// ---------------------------------------------------------------------------
+void TerminalScreen::switchScreen(bool alternate)
+{
+    if (alternate == m_alternate)
+        return;
+    m_alternate = alternate;
+    normalizeLines();
+    m_lines.swap(m_otherLines);
+    if (alternate)
+    {
+        m_lines.assign(size_t(m_rows), ScreenLine{std::vector<TerminalCell>(size_t(m_columns)), false});
+    }
+    else
+    {
+        m_otherLines.clear();
+    }
+    markAllDirty();
+}
+
+void TerminalScreen::saveCursor()
+{
+    m_saved.row = m_cursorRow;
+    m_saved.column = cursorColumn();
+    m_saved.pen = m_pen;
+}
+
+void TerminalScreen::restoreCursor()
+{
+    moveCursor(m_saved.row, m_saved.column);
+    m_pen = m_saved.pen;
+}
+
+void TerminalScreen::fullReset()
+{
+    switchScreen(false);
+    m_pen = TerminalCell();
+    eraseLines(0, m_rows - 1);
+    moveCursor(0, 0);
+    m_saved = SavedCursor();
+    m_scrollTop = 0;
+    m_scrollBottom = m_rows - 1;
+    m_autoWrap = true;
+    m_cursorVisible = true;
+    m_applicationCursorKeys = false;
+    m_bracketedPaste = false;
+    m_title.clear();
+}
+
+void TerminalScreen::markDirty(int row, int first, int last)
+{
+    if (m_allDirty)
+        return;
+    DirtySpan &span = m_dirty[size_t(row)];
+    if (span.first >= span.last)
+    {
+        span = DirtySpan{first, last};
+    }
+    else
+    {
+        span.first = qMin(span.first, first);
+        span.last = qMax(span.last, last);
+    }
+}
+
+void TerminalScreen::markAllDirty()
+{
+    m_allDirty = true;
+}
+
+// Physical order again, before the lines are resized or swapped
+void TerminalScreen::normalizeLines()
+{
+    std::rotate(m_lines.begin(), m_lines.begin() + m_topLine, m_lines.end());
+    m_topLine = 0;
+}
+
+TerminalCell TerminalScreen::blank() const
+{
+    // Erased cells take the current background
+    TerminalCell cell;
+    cell.background = m_pen.background;
+    cell.flags = TerminalCell::DefaultForeground | (m_pen.flags & TerminalCell::DefaultBackground);
+    return cell;
+}
+
+// ---------------------------------------------------------------------------
+// Graphics rendition
+// ---------------------------------------------------------------------------
+void applyGraphicsRendition(const VtParser &parser, TerminalCell *pen)
+{
+    const int count = qMax(1, parser.paramCount());
+    for (int i = 0; i < count; ++i)
+    {
+        const int code = parser.param(i, 0);
+        if (code == 0)
+        {
+            *pen = TerminalCell();
+        }
+        else if (code == 38 || code == 48)
+        {
+            // 38;5;index or 38;2;red;green;blue
+            quint8 color = 0;
+            if (parser.param(i + 1, 0) == 5)
+            {
+                color = quint8(qMin(parser.param(i + 2, 0), 255));
+                i += 2;
+            }
+            else if (parser.param(i + 1, 0) == 2)
+            {
+                color = paletteIndex(parser.param(i + 2, 0), parser.param(i + 3, 0), parser.param(i + 4, 0));
+                i += 4;
+            }
+            else
+            {
+                break;
+            }
+            if (code == 38)
+            {
+                pen->foreground = color;
+                pen->flags &= ~TerminalCell::DefaultForeground;
+            }
+            else
+            {
+                pen->background = color;
+                pen->flags &= ~TerminalCell::DefaultBackground;
+            }
+        }
+        else if ((code >= 30 && code <= 37) || (code >= 90 && code <= 97))
+        {
+            pen->foreground = quint8(code >= 90 ? code - 90 + 8 : code - 30);
+            pen->flags &= ~TerminalCell::DefaultForeground;
+        }
+        else if ((code >= 40 && code <= 47) || (code >= 100 && code <= 107))
+        {
+            pen->background = quint8(code >= 100 ? code - 100 + 8 : code - 40);
+            pen->flags &= ~TerminalCell::DefaultBackground;
+        }
+        else
+        {
+            switch (code)
+            {
+            case 1:
+                pen->flags |= TerminalCell::Bold;
+                break;
+            case 3:
+                pen->flags |= TerminalCell::Italic;
+                break;
+            case 4:
+                pen->flags |= TerminalCell::Underline;
+                break;
+            case 7:
+                pen->flags |= TerminalCell::Inverse;
+                break;
+            case 22:
+                pen->flags &= ~TerminalCell::Bold;
+                break;
+            case 23:
+                pen->flags &= ~TerminalCell::Italic;
+                break;
+            case 24:
+                pen->flags &= ~TerminalCell::Underline;
+                break;
+            case 27:
+                pen->flags &= ~TerminalCell::Inverse;
+                break;
+            case 39:
+                pen->flags |= TerminalCell::DefaultForeground;
+                break;
+            case 49:
+                pen->flags |= TerminalCell::DefaultBackground;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Palette
+// ---------------------------------------------------------------------------
+quint32 terminalPaletteColor(int index)
+{
+    static const quint32 Standard[16] = {
+        0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+        0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff,
+    };
+    index = qBound(0, index, 255);
+    if (index < 16)
+        return Standard[index];
+    if (index >= 232)
+    {
+        const quint32 gray = quint32(8 + 10 * (index - 232));
+        return gray << 16 | gray << 8 | gray;
+    }
+    static const quint32 Levels[6] = {0, 95, 135, 175, 215, 255};
+    const int cube = index - 16;
+    return Levels[cube / 36] << 16 | Levels[cube / 6 % 6] << 8 | Levels[cube % 6];
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// One character cell of the terminal grid, 8 bytes. Colours are indexes
+// into the xterm 256-colour palette unless the Default flag is set.
+// ---------------------------------------------------------------------------
+struct TerminalCell
+{
+    enum Flag : quint8
+    {
+        Bold = 0x01,
+        Italic = 0x02,
+        Underline = 0x04,
+        Inverse = 0x08,
+        DefaultForeground = 0x10,
+        DefaultBackground = 0x20
+    };
+
+    char32_t ch = U' ';
+    quint8 foreground = 7;
+    quint8 background = 0;
+    quint8 flags = DefaultForeground | DefaultBackground;
+
+    bool sameStyle(const TerminalCell &other) const
+    {
+        return foreground == other.foreground && background == other.background && flags == other.flags;
+    }
+};
+
+class VtParser;
+
+// Receives what VtParser recognises
+class VtHandler
+{
+public:
+    virtual ~VtHandler() = default;
+
+    virtual void print(const char *text, qint64 size) = 0; // printable ASCII run
+    virtual void printCodePoint(char32_t codePoint) = 0;
+    virtual void execute(char control) = 0;
+    virtual void escDispatch(const VtParser &parser, char final) = 0;
+    virtual void csiDispatch(const VtParser &parser, char final) = 0;
+    virtual void oscDispatch(const QByteArray &data) = 0;
+};
+
+// ---------------------------------------------------------------------------
+// VT100/xterm escape sequence parser after the DEC state machine: one table
+// lookup per byte gives the action and the next state. Runs of printable
+// ASCII in the ground state skip the table and reach the handler in one
+// call. Text is UTF-8; DCS, SOS, PM and APC strings are ignored. Sequences
+// may be split across feed() calls.
+// ---------------------------------------------------------------------------
+class VtParser
+{
+public:
+    static constexpr int MaxParams = 16;
+    static constexpr int MaxOscBytes = 4096;
+
+    void feed(const char *data, qint64 size, VtHandler &handler);
+    void reset();
+
+    // Valid during a dispatch
+    int paramCount() const { return m_paramCount; }
+    int param(int index, int defaultValue) const; // defaultValue if missing or 0
+    char privateMarker() const { return m_marker; }      // '?', '>', ... or 0
+    char intermediate() const { return m_intermediate; } // last of 0x20-0x2f or 0
+
+    enum State : quint8
+    {
+        Ground,
+        Escape,
+        EscapeIntermediate,
+        CsiEntry,
+        CsiParam,
+        CsiIntermediate,
+        CsiIgnore,
+        OscString,
+        IgnoreString,
+        StateCount
+    };
+
+private:
+    void clear();
+    void printUtf8(uchar byte, VtHandler &handler);
+
+    State m_state = Ground;
+    int m_params[MaxParams] = {};
+    int m_paramCount = 0;
+    char m_marker = 0;
+    char m_intermediate = 0;
+    QByteArray m_osc;
+    char32_t m_codePoint = 0;
+    int m_utf8Pending = 0; // continuation bytes still expected
+};
+
+// ---------------------------------------------------------------------------
+// Lines scrolled off the top of the screen, kept in one ring of cells with
+// a fixed memory cap. Each line takes its cells up to the last non-blank
+// one, at least one; the oldest lines are dropped to make room. Storage
+// grows on demand up to the cap.
+// ---------------------------------------------------------------------------
+class TerminalScrollback
+{
+public:
+    explicit TerminalScrollback(qint64 maxBytes);
+
+    void push(const TerminalCell *cells, int count, bool wrapped);
+    void clear();
+
+    qint64 lineCount() const { return m_lineCount; }
+    quint64 droppedLines() const { return m_droppedLines; } // since construction
+    // Cells of line (0 is the oldest) and their number
+    const TerminalCell *line(qint64 index, int *length) const;
+    bool isWrapped(qint64 index) const;
+
+private:
+    struct Line
+    {
+        qint64 start = 0;
+        int length = 0;
+        bool wrapped = false;
+    };
+
+    const Line &lineAt(qint64 index) const;
+    void dropOldest();
+
+    qint64 m_cellCapacity = 0;
+    qint64 m_lineCapacity = 0;
+    std::vector<TerminalCell> m_cells;
+    std::vector<Line> m_lines; // ring from m_firstLine
+    qint64 m_firstLine = 0;
+    qint64 m_lineCount = 0;
+    qint64 m_head = 0; // next free cell
+    quint64 m_droppedLines = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Terminal state driven by a VtParser: the cell grid, cursor, scroll region,
+// modes, alternate screen and scrollback.
+//
+// Tracks which columns of each row changed since clearDirty() so a view
+// repaints only those. Not thread safe; the terminal panel feeds it on its
+// reader thread under a mutex and copies dirty rows out on the GUI thread.
+// ---------------------------------------------------------------------------
+class TerminalScreen : private VtHandler
+{
+public:
+    struct DirtySpan
+    {
+        int first = 0;
+        int last = 0; // exclusive; nothing is dirty when first >= last
+    };
+
+    TerminalScreen(int rows, int columns, qint64 scrollbackBytes);
+
+    void feed(const char *data, qint64 size);
+    void resize(int rows, int columns);
+
+    int rows() const { return m_rows; }
+    int columns() const { return m_columns; }
+    int cursorRow() const { return m_cursorRow; }
+    int cursorColumn() const { return qMin(m_cursorColumn, m_columns - 1); }
+    bool isCursorVisible() const { return m_cursorVisible; }
+    bool isAlternateScreen() const { return m_alternate; }
+    bool applicationCursorKeys() const { return m_applicationCursorKeys; }
+    bool bracketedPaste() const { return m_bracketedPaste; }
+    QString title() const { return m_title; }
+
+    // columns() cells of a screen row
+    const TerminalCell *row(int row) const { return line(row).cells.data(); }
+    const TerminalScrollback &scrollback() const { return m_scrollback; }
+
+    // Bytes to send back to the program (status reports); cleared by the call
+    QByteArray takeResponse();
+
+    DirtySpan dirtySpan(int row) const;
+    // Lines moved into the scrollback since clearDirty()
+    qint64 scrolledLines() const { return m_scrolledLines; }
+    void clearDirty();
+
+private:
+    struct ScreenLine
+    {
+        std::vector<TerminalCell> cells;
+        bool wrapped = false; // continues on the next row
+    };
+
+    // Screen rows are a ring from m_topLine, so scrolling the whole screen
+    // moves no lines
+    ScreenLine &line(int row) { return m_lines[size_t(ringIndex(row))]; }
+    const ScreenLine &line(int row) const { return m_lines[size_t(ringIndex(row))]; }
+    int ringIndex(int row) const { return m_topLine + row < m_rows ? m_topLine + row : m_topLine + row - m_rows; }
+    void normalizeLines();
+
+    void print(const char *text, qint64 size) override;
+    void printCodePoint(char32_t codePoint) override;
+    void execute(char control) override;
+    void escDispatch(const VtParser &parser, char final) override;
+    void csiDispatch(const VtParser &parser, char final) override;
+    void oscDispatch(const QByteArray &data) override;
+
+    void wrapIfPending();
+    void lineFeed();
+    void pushToScrollback(const ScreenLine &line);
+    void scrollUp(int top, int bottom, int count);
+    void scrollDown(int top, int bottom, int count);
+    void eraseCells(int row, int first, int last);
+    void eraseLines(int first, int last);
+    void moveCursor(int row, int column);
+    void setMode(const VtParser &parser, bool enabled);
+    void switchScreen(bool alternate);
+    void saveCursor();
+    void restoreCursor();
+    void fullReset();
+    void markDirty(int row, int first, int last);
+    void markAllDirty();
+    TerminalCell blank() const;
+
+    VtParser m_parser;
+    TerminalScrollback m_scrollback;
+    int m_rows = 0;
+    int m_columns = 0;
+    std::vector<ScreenLine> m_lines;
+    int m_topLine = 0;
+    std::vector<ScreenLine> m_otherLines; // the inactive one of main and alternate
+    std::vector<DirtySpan> m_dirty;
+    bool m_allDirty = false;
+    qint64 m_scrolledLines = 0;
+
+    int m_cursorRow = 0;
+    int m_cursorColumn = 0; // m_columns while a wrap is pending
+    TerminalCell m_pen;     // style of new cells
+    int m_scrollTop = 0;
+    int m_scrollBottom = 0; // inclusive
+    struct SavedCursor
+    {
+        int row = 0;
+        int column = 0;
+        TerminalCell pen;
+    } m_saved;
+
+    bool m_autoWrap = true;
+    bool m_cursorVisible = true;
+    bool m_alternate = false;
+    bool m_applicationCursorKeys = false;
+    bool m_bracketedPaste = false;
+    QString m_title;
+    QByteArray m_response;
+};
+
+// Applies the SGR sequence (CSI ... m) in parser to pen
+void applyGraphicsRendition(const VtParser &parser, TerminalCell *pen);
+
+// RGB of an xterm 256-colour palette index
+quint32 terminalPaletteColor(int index);
@@ -0,0 +1,794 @@
+#include "TerminalPanel.h"
+
+#include <QApplication>
+#include <QByteArrayList>
+#include <QClipboard>
+#include <QDebug>
+#include <QFontDatabase>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QScrollBar>
+#include <QSignalBlocker>
+#include <QTimer>
+
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <thread>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(Q_OS_LINUX)
+constexpr int ReadChunkBytes = 64 * 1024;
+
+// How long the shell gets to go after a hangup, and again after SIGKILL
+constexpr int ReapGraceMs = 100;
+constexpr int ReapPollMs = 5;
+
+void setWindowSize(int fd, int rows, int columns)
+{
+    winsize size{};
+    size.ws_row = ushort(rows);
+    size.ws_col = ushort(columns);
+    ::ioctl(fd, TIOCSWINSZ, &size);
+}
+
+// Forks $SHELL on a new pseudo terminal and returns the master side, or -1
+int spawnShell(int rows, int columns, pid_t *pid, QString *errorString)
+{
+    // Non-blocking, so neither input the shell does not read nor output
+    // nobody drains can stall the thread serving the terminal
+    const int master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0
+        || ::fcntl(master, F_SETFL, ::fcntl(master, F_GETFL) | O_NONBLOCK) != 0)
+    {
+        *errorString = QString::fromLocal8Bit(std::strerror(errno));
+        if (master >= 0)
+            ::close(master);
+        return -1;
+    }
+    const QByteArray slaveName = ::ptsname(master);
+    setWindowSize(master, rows, columns);
+
+    // Everything the child uses is prepared before fork(); only
+    // async-signal-safe calls may run between fork() and exec
+    QByteArray shell = qgetenv("SHELL");
+    if (shell.isEmpty())
+        shell = "/bin/sh";
+    QByteArrayList environment;
+    for (char **variable = environ; *variable; ++variable)
+    {
+        if (std::strncmp(*variable, "TERM=", 5) != 0 && std::strncmp(*variable, "COLUMNS=", 8) != 0
+            && std::strncmp(*variable, "LINES=", 6) != 0)
+            environment.append(*variable);
+    }
+    environment.append("TERM=xterm-256color");
+    std::vector<char *> envp;
+    for (QByteArray &variable : environment)
+        envp.push_back(variable.data());
+    envp.push_back(nullptr);
+    char *argv[] = {shell.data(), nullptr};
+
+    const pid_t child = ::fork();
+    if (child < 0)
+    {
+        *errorString = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(master);
+        return -1;
+    }
+    if (child == 0)
+    {
+        ::setsid();
+        const int slave = ::open(slaveName.constData(), O_RDWR);
+        if (slave < 0)
+            ::_exit(127);
+        ::ioctl(slave, TIOCSCTTY, 0);
+        ::dup2(slave, STDIN_FILENO);
+        ::dup2(slave, STDOUT_FILENO);
+        ::dup2(slave, STDERR_FILENO);
+        if (slave > STDERR_FILENO)
+            ::close(slave);
+        sigset_t none;
+        ::sigemptyset(&none);
+        ::sigprocmask(SIG_SETMASK, &none, nullptr);
+        ::signal(SIGPIPE, SIG_DFL);
+        ::execve(shell.constData(), argv, envp.data());
+        ::_exit(127);
+    }
+    *pid = child;
+    return master;
+}
+
+// 1 once pid is reaped, 0 if it still runs after milliseconds, -1 on errors
+int waitForExit(pid_t pid, int milliseconds, int *status)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (;;)
+    {
+        const pid_t result = ::waitpid(pid, status, WNOHANG);
+        if (result > 0)
+            return 1;
+        if (result < 0 && errno != EINTR)
+            return -1;
+        if (timer.elapsed() >= milliseconds)
+            return 0;
+        ::usleep(ReapPollMs * 1000);
+    }
+}
+
+// Exit code of the shell, or -1. Call it after closing the master: the
+// shell gets graceMs to exit, then SIGHUP and SIGKILL, each with
+// ReapGraceMs to take effect. A shell stuck even then is left to a
+// detached thread to collect, so this never blocks for long.
+int reap(pid_t pid, int graceMs)
+{
+    int status = 0;
+    int reaped = waitForExit(pid, graceMs, &status);
+    for (const int signalNumber : {SIGHUP, SIGKILL})
+    {
+        if (reaped != 0)
+            break;
+        ::kill(pid, signalNumber);
+        reaped = waitForExit(pid, ReapGraceMs, &status);
+    }
+    if (reaped == 0)
+    {
+        std::thread([pid]()
+        {
+            int status = 0;
+            while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+        }).detach();
+    }
+    if (reaped <= 0)
+        return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+#endif
+
+void copyLine(const TerminalScreen &screen, qint64 line, int first, int last, std::vector<TerminalCell> &row)
+{
+    const TerminalScrollback &scrollback = screen.scrollback();
+    const qint64 history = scrollback.lineCount();
+    if (line >= history)
+    {
+        const TerminalCell *cells = screen.row(int(line - history));
+        std::copy(cells + first, cells + last, row.begin() + first);
+        return;
+    }
+    // Scrollback lines keep no trailing blanks and may be wider than the grid
+    int length = 0;
+    const TerminalCell *cells = scrollback.line(line, &length);
+    const int stored = qBound(first, length, last);
+    std::copy(cells + first, cells + stored, row.begin() + first);
+    std::fill(row.begin() + stored, row.begin() + last, TerminalCell());
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Session: the shell, its terminal and the I/O thread
+// ---------------------------------------------------------------------------
+struct TerminalPanel::Session
+{
+    Session(int rows, int columns)
+        : screen(rows, columns, ScrollbackBytes)
+    {
+    }
+
+    // Queues bytes for the shell; the I/O thread writes them as it reads them
+    void send(const QByteArray &bytes);
+    void wake();
+
+    std::mutex mutex;
+    TerminalScreen screen; // guarded by mutex
+    std::mutex inputMutex;
+    QByteArray input;      // guarded by inputMutex
+    std::atomic_bool frameRequested{false};
+    std::atomic_bool stopping{false};
+    std::thread reader;
+    int masterFd = -1;
+    int wakeFds[2] = {-1, -1};
+    qint64 pid = -1;
+};
+
+void TerminalPanel::Session::send(const QByteArray &bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        input += bytes;
+    }
+    wake();
+}
+
+void TerminalPanel::Session::wake()
+{
+#if defined(Q_OS_LINUX)
+    // A full pipe already holds a wake-up
+    const ssize_t woken = ::write(wakeFds[1], "x", 1);
+    Q_UNUSED(woken);
+#endif
+}
+
+TerminalPanel::TerminalPanel(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    viewport()->setCursor(Qt::IBeamCursor);
+    viewport()->setAutoFillBackground(false);
+
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setSingleShot(true);
+    connect(m_frameTimer, &QTimer::timeout, this, &TerminalPanel::updateFrame);
+    m_lastFrame.start();
+}
+
+TerminalPanel::~TerminalPanel()
+{
+    stopShell();
+}
+
+// ---------------------------------------------------------------------------
+// Shell lifecycle
+// ---------------------------------------------------------------------------
+bool TerminalPanel::startShell()
+{
+    stopShell();
+    m_started = true;
+#if defined(Q_OS_LINUX)
+    auto session = std::make_unique<Session>(gridRows(), gridColumns());
+    pid_t pid = -1;
+    QString errorString;
+    session->masterFd = spawnShell(gridRows(), gridColumns(), &pid, &errorString);
+    if (session->masterFd >= 0 && ::pipe2(session->wakeFds, O_CLOEXEC | O_NONBLOCK) != 0)
+    {
+        errorString = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(session->masterFd);
+        session->masterFd = -1;
+        reap(pid, 0);
+    }
+    if (session->masterFd < 0)
+    {
+        qWarning() << "TerminalPanel: cannot start the shell:" << errorString;
+        m_message = tr("Cannot start the shell: %1").arg(errorString);
+        viewport()->update();
+        return false;
+    }
+    session->pid = pid;
+
+    const quint64 generation = ++m_generation;
+    QPointer<TerminalPanel> guard(this);
+    Session *shared = session.get();
+    session->reader = std::thread([guard, shared, generation]()
+    {
+        // Reads output and writes queued input and terminal responses as
+        // the shell takes them; the master is non-blocking, so a shell that
+        // stops reading holds up neither its output nor the GUI
+        std::vector<char> buffer(ReadChunkBytes);
+        QByteArray output;
+        qint64 written = 0;
+        pollfd fds[2] = {{shared->masterFd, POLLIN, 0}, {shared->wakeFds[0], POLLIN, 0}};
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(shared->inputMutex);
+                output += shared->input;
+                shared->input.clear();
+            }
+            fds[0].events = written < output.size() ? POLLIN | POLLOUT : POLLIN;
+            if (::poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            if (fds[1].revents != 0)
+            {
+                char drained[64];
+                while (::read(shared->wakeFds[0], drained, sizeof(drained)) > 0)
+                {
+                }
+                if (shared->stopping)
+                    break;
+            }
+            if (fds[0].revents & POLLOUT)
+            {
+                const ssize_t n = ::write(shared->masterFd, output.constData() + written, size_t(output.size() - written));
+                if (n > 0)
+                    written += n;
+                if (written == output.size())
+                {
+                    output.clear();
+                    written = 0;
+                }
+            }
+            if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            const ssize_t n = ::read(shared->masterFd, buffer.data(), buffer.size());
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            // EIO once the shell and everything it started closed the terminal
+            if (n <= 0)
+                break;
+
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->screen.feed(buffer.data(), n);
+                output += shared->screen.takeResponse();
+            }
+            // One pending frame request at a time, however fast output comes
+            if (!shared->frameRequested.exchange(true))
+            {
+                QMetaObject::invokeMethod(qApp, [guard]()
+                {
+                    if (guard)
+                        guard->scheduleFrame();
+                }, Qt::QueuedConnection);
+            }
+        }
+        if (!shared->stopping)
+        {
+            QMetaObject::invokeMethod(qApp, [guard, generation]()
+            {
+                if (guard)
+                    guard->onShellExited(generation);
+            }, Qt::QueuedConnection);
+        }
+    });
+
+    m_session = std::move(session);
+    m_message.clear();
+    m_following = true;
+    m_fullRepaint = true;
+    m_droppedLines = 0;
+    updateFrame();
+    return true;
+#else
+    m_message = tr("The terminal needs a Linux pseudo terminal");
+    viewport()->update();
+    return false;
+#endif
+}
+
+void TerminalPanel::stopShell()
+{
+    if (!m_session)
+        return;
+#if defined(Q_OS_LINUX)
+    m_session->stopping = true;
+    m_session->wake();
+    if (m_session->reader.joinable())
+        m_session->reader.join();
+    // Closing the master hangs up the terminal before reap() escalates
+    ::close(m_session->masterFd);
+    reap(pid_t(m_session->pid), 0);
+    ::close(m_session->wakeFds[0]);
+    ::close(m_session->wakeFds[1]);
+#endif
+    m_session.reset();
+}
+
+void TerminalPanel::onShellExited(quint64 generation)
+{
+    if (generation != m_generation || !m_session)
+        return;
+#if defined(Q_OS_LINUX)
+    if (m_session->reader.joinable())
+        m_session->reader.join();
+    // The terminal is closed, so the shell is on its way out
+    ::close(m_session->masterFd);
+    const int exitCode = reap(pid_t(m_session->pid), ReapGraceMs);
+    {
+        // Leave the last screen up with a note under it
+        std::lock_guard<std::mutex> lock(m_session->mutex);
+        const QByteArray note = "\r\n\x1b[0m[" + tr("Process exited with code %1; press Enter to restart").arg(exitCode).toUtf8() + "]";
+        m_session->screen.feed(note.constData(), note.size());
+    }
+    updateFrame();
+    ::close(m_session->wakeFds[0]);
+    ::close(m_session->wakeFds[1]);
+#endif
+    m_session.reset();
+}
+
+void TerminalPanel::showEvent(QShowEvent *event)
+{
+    QAbstractScrollArea::showEvent(event);
+    if (!m_started)
+        startShell();
+}
+
+// ---------------------------------------------------------------------------
+// Frames
+// ---------------------------------------------------------------------------
+void TerminalPanel::scheduleFrame()
+{
+    if (m_frameTimer->isActive())
+        return;
+    m_frameTimer->start(int(qMax<qint64>(0, FrameIntervalMs - m_lastFrame.elapsed())));
+}
+
+void TerminalPanel::updateFrame()
+{
+    if (!m_session)
+        return;
+    m_session->frameRequested = false;
+    m_lastFrame.restart();
+
+    const int height = lineHeight();
+    const int width = charWidth();
+    const int oldCursorRow = m_cursorRow;
+    const int oldCursorColumn = m_cursorColumn;
+    std::vector<QRect> dirty;
+    qint64 history = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_session->mutex);
+        TerminalScreen &screen = m_session->screen;
+        const TerminalScrollback &scrollback = screen.scrollback();
+        history = scrollback.lineCount();
+
+        // Dropped scrollback lines shift the ones after them; keep the view
+        // on the same text
+        const qint64 dropped = qint64(scrollback.droppedLines() - m_droppedLines);
+        m_droppedLines = scrollback.droppedLines();
+        m_topLine = m_following ? history : qBound<qint64>(0, m_topLine - dropped, history);
+
+        const int rows = screen.rows();
+        const int columns = screen.columns();
+        if (int(m_rows.size()) != rows || m_rows.empty() || int(m_rows.front().size()) != columns)
+        {
+            m_rows.assign(size_t(rows), std::vector<TerminalCell>(size_t(columns)));
+            m_fullRepaint = true;
+        }
+        // Only the rows of a screen that stayed in place can be patched
+        const bool full = m_fullRepaint || !m_following || screen.scrolledLines() > 0 || dropped > 0;
+        for (int row = 0; row < rows; ++row)
+        {
+            const TerminalScreen::DirtySpan span = full ? TerminalScreen::DirtySpan{0, columns}
+                                                        : screen.dirtySpan(row);
+            if (span.first >= span.last)
+                continue;
+            copyLine(screen, m_topLine + row, span.first, span.last, m_rows[size_t(row)]);
+            if (!full)
+                dirty.push_back(QRect(span.first * width, row * height, (span.last - span.first) * width, height));
+        }
+
+        const qint64 cursorLine = history + screen.cursorRow() - m_topLine;
+        m_cursorRow = screen.isCursorVisible() && cursorLine < rows ? int(cursorLine) : -1;
+        m_cursorColumn = screen.cursorColumn();
+        m_applicationCursorKeys = screen.applicationCursorKeys();
+        m_bracketedPaste = screen.bracketedPaste();
+        screen.clearDirty();
+
+        if (full)
+        {
+            dirty.assign(1, viewport()->rect());
+            m_fullRepaint = false;
+        }
+    }
+
+    {
+        // Without the blocker this would come back through scrollContentsBy()
+        QSignalBlocker blocker(verticalScrollBar());
+        verticalScrollBar()->setRange(0, int(qMin<qint64>(history, INT_MAX)));
+        verticalScrollBar()->setPageStep(int(m_rows.size()));
+        verticalScrollBar()->setValue(int(qMin<qint64>(m_topLine, INT_MAX)));
+    }
+
+    if (oldCursorRow >= 0)
+        dirty.push_back(QRect(oldCursorColumn * width, oldCursorRow * height, width, height));
+    if (m_cursorRow >= 0)
+        dirty.push_back(QRect(m_cursorColumn * width, m_cursorRow * height, width, height));
+    for (const QRect &rect : dirty)
+        viewport()->update(rect);
+}
+
+// ---------------------------------------------------------------------------
+// Geometry and painting
+// ---------------------------------------------------------------------------
+int TerminalPanel::lineHeight() const
+{
+    return fontMetrics().height();
+}
+
+int TerminalPanel::charWidth() const
+{
+    return qMax(1, fontMetrics().horizontalAdvance(QLatin1Char('M')));
+}
+
+int TerminalPanel::gridRows() const
+{
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+int TerminalPanel::gridColumns() const
+{
+    return qMax(1, viewport()->width() / charWidth());
+}
+
+void TerminalPanel::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    if (!m_session)
+        return;
+    const int rows = gridRows();
+    const int columns = gridColumns();
+    {
+        std::lock_guard<std::mutex> lock(m_session->mutex);
+        m_session->screen.resize(rows, columns);
+    }
+#if defined(Q_OS_LINUX)
+    // The kernel sends SIGWINCH to the shell
+    setWindowSize(m_session->masterFd, rows, columns);
+#endif
+    m_fullRepaint = true;
+    updateFrame();
+}
+
+void TerminalPanel::scrollContentsBy(int, int)
+{
+    const QScrollBar *bar = verticalScrollBar();
+    m_topLine = bar->value();
+    m_following = bar->value() == bar->maximum();
+    m_fullRepaint = true;
+    updateFrame();
+}
+
+void TerminalPanel::cellColors(const TerminalCell &cell, QColor *foreground, QColor *background) const
+{
+    if (cell.flags & TerminalCell::DefaultForeground)
+        *foreground = palette().color(QPalette::Text);
+    else
+        // Bold brightens the eight basic colours, as xterm does
+        *foreground = QColor::fromRgb(terminalPaletteColor(
+            (cell.flags & TerminalCell::Bold) && cell.foreground < 8 ? cell.foreground + 8 : cell.foreground));
+    if (cell.flags & TerminalCell::DefaultBackground)
+        *background = palette().color(QPalette::Base);
+    else
+        *background = QColor::fromRgb(terminalPaletteColor(cell.background));
+    if (cell.flags & TerminalCell::Inverse)
+        std::swap(*foreground, *background);
+}
+
+void TerminalPanel::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    const QRect area = event->rect();
+    painter.fillRect(area, palette().base());
+
+    if (!m_message.isEmpty())
+    {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(viewport()->rect().adjusted(4, 4, -4, -4), Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap,
+                         m_message);
+        return;
+    }
+    if (m_rows.empty())
+        return;
+
+    // Only the cells under the update rectangle, in runs of one style
+    const int height = lineHeight();
+    const int width = charWidth();
+    const int ascent = fontMetrics().ascent();
+    const int columns = int(m_rows.front().size());
+    const int firstRow = qMax(0, area.top() / height);
+    const int lastRow = qMin(int(m_rows.size()) - 1, area.bottom() / height);
+    const int firstColumn = qMax(0, area.left() / width);
+    const int lastColumn = qMin(columns - 1, area.right() / width);
+    const QFont baseFont = font();
+    quint8 fontFlags = 0;
+    QString text;
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        const std::vector<TerminalCell> &cells = m_rows[size_t(row)];
+        int column = firstColumn;
+        while (column <= lastColumn)
+        {
+            int end = column + 1;
+            while (end <= lastColumn && cells[size_t(end)].sameStyle(cells[size_t(column)]))
+                ++end;
+            const TerminalCell &style = cells[size_t(column)];
+            QColor foreground;
+            QColor background;
+            cellColors(style, &foreground, &background);
+            const QRect runRect(column * width, row * height, (end - column) * width, height);
+            if (background != palette().color(QPalette::Base))
+                painter.fillRect(runRect, background);
+
+            text.clear();
+            bool blank = true;
+            for (int i = column; i < end; ++i)
+            {
+                const char32_t ch = cells[size_t(i)].ch;
+                blank = blank && ch == U' ';
+                if (ch < 0x10000)
+                    text.append(QChar(char16_t(ch)));
+                else
+                    text.append(QString::fromUcs4(&ch, 1));
+            }
+            const quint8 flags = style.flags & (TerminalCell::Bold | TerminalCell::Italic | TerminalCell::Underline);
+            if (!blank || (flags & TerminalCell::Underline))
+            {
+                if (flags != fontFlags)
+                {
+                    QFont runFont = baseFont;
+                    runFont.setBold(flags & TerminalCell::Bold);
+                    runFont.setItalic(flags & TerminalCell::Italic);
+                    runFont.setUnderline(flags & TerminalCell::Underline);
+                    painter.setFont(runFont);
+                    fontFlags = flags;
+                }
+                painter.setPen(foreground);
+                painter.drawText(column * width, row * height + ascent, text);
+            }
+            column = end;
+        }
+    }
+
+    if (m_cursorRow >= firstRow && m_cursorRow <= lastRow)
+    {
+        const QRect cursor(m_cursorColumn * width, m_cursorRow * height, width, height);
+        if (hasFocus())
+        {
+            painter.setCompositionMode(QPainter::RasterOp_SourceXorDestination);
+            painter.fillRect(cursor, Qt::white);
+        }
+        else
+        {
+            painter.setPen(palette().color(QPalette::Text));
+            painter.drawRect(cursor.adjusted(0, 0, -1, -1));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Input
+// ---------------------------------------------------------------------------
+bool TerminalPanel::focusNextPrevChild(bool)
+{
+    // Tab goes to the shell
+    return false;
+}
+
+void TerminalPanel::sendBytes(const QByteArray &bytes)
+{
+    if (!m_session || bytes.isEmpty())
+        return;
+    m_session->send(bytes);
+    // Typing brings the view back to the prompt
+    if (!m_following)
+    {
+        m_following = true;
+        m_fullRepaint = true;
+        updateFrame();
+    }
+}
+
+void TerminalPanel::paste()
+{
+    QByteArray text = QApplication::clipboard()->text().toUtf8();
+    if (text.isEmpty())
+        return;
+    text.replace("\r\n", "\r");
+    text.replace('\n', '\r');
+    if (m_bracketedPaste)
+        text = "\x1b[200~" + text + "\x1b[201~";
+    sendBytes(text);
+}
+
+void TerminalPanel::keyPressEvent(QKeyEvent *event)
+{
+    if (!m_session)
+    {
+        if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter)
+            startShell();
+        return;
+    }
+
+    const Qt::KeyboardModifiers modifiers = event->modifiers();
+    const bool shift = modifiers & Qt::ShiftModifier;
+    const bool control = modifiers & Qt::ControlModifier;
+    if ((control && shift && event->key() == Qt::Key_V) || (shift && event->key() == Qt::Key_Insert))
+        return paste();
+    if (shift && (event->key() == Qt::Key_PageUp || event->key() == Qt::Key_PageDown))
+    {
+        const int page = verticalScrollBar()->pageStep();
+        verticalScrollBar()->setValue(verticalScrollBar()->value() + (event->key() == Qt::Key_PageUp ? -page : page));
+        return;
+    }
+
+    const char *cursorPrefix = m_applicationCursorKeys ? "\x1bO" : "\x1b[";
+    QByteArray bytes;
+    switch (event->key())
+    {
+    case Qt::Key_Up:
+        bytes = QByteArray(cursorPrefix) + 'A';
+        break;
+    case Qt::Key_Down:
+        bytes = QByteArray(cursorPrefix) + 'B';
+        break;
+    case Qt::Key_Right:
+        bytes = QByteArray(cursorPrefix) + 'C';
+        break;
+    case Qt::Key_Left:
+        bytes = QByteArray(cursorPrefix) + 'D';
+        break;
+    case Qt::Key_Home:
+        bytes = QByteArray(cursorPrefix) + 'H';
+        break;
+    case Qt::Key_End:
+        bytes = QByteArray(cursorPrefix) + 'F';
+        break;
+    case Qt::Key_Insert:
+        bytes = "\x1b[2~";
+        break;
+    case Qt::Key_Delete:
+        bytes = "\x1b[3~";
+        break;
+    case Qt::Key_PageUp:
+        bytes = "\x1b[5~";
+        break;
+    case Qt::Key_PageDown:
+        bytes = "\x1b[6~";
+        break;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        bytes = "\r";
+        break;
+    case Qt::Key_Backspace:
+        bytes = "\x7f";
+        break;
+    case Qt::Key_Tab:
+        bytes = "\t";
+        break;
+    case Qt::Key_Backtab:
+        bytes = "\x1b[Z";
+        break;
+    case Qt::Key_Escape:
+        bytes = "\x1b";
+        break;
+    default:
+        if (event->key() >= Qt::Key_F1 && event->key() <= Qt::Key_F4)
+        {
+            bytes = "\x1bO";
+            bytes += char('P' + (event->key() - Qt::Key_F1));
+        }
+        else if (event->key() >= Qt::Key_F5 && event->key() <= Qt::Key_F12)
+        {
+            static const int Codes[] = {15, 17, 18, 19, 20, 21, 23, 24};
+            bytes = "\x1b[" + QByteArray::number(Codes[event->key() - Qt::Key_F5]) + '~';
+        }
+        else if (control && event->key() >= Qt::Key_A && event->key() <= Qt::Key_Z)
+        {
+            bytes = QByteArray(1, char(event->key() - Qt::Key_A + 1));
+        }
+        else
+        {
+            bytes = event->text().toUtf8();
+        }
+        if (!bytes.isEmpty() && (modifiers & Qt::AltModifier))
+            bytes.prepend('\x1b');
+        break;
+    }
+
+    if (bytes.isEmpty())
+        return QAbstractScrollArea::keyPressEvent(event);
+    sendBytes(bytes);
+}
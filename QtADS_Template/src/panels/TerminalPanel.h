@@ -0,0 +1,82 @@
+#pragma once
+
+#include "TerminalEmulator.h"
+
+#include <QAbstractScrollArea>
+#include <QElapsedTimer>
+
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+// ---------------------------------------------------------------------------
+// Terminal running the user's shell on a pseudo terminal.
+//
+// An I/O thread drains the non-blocking PTY and feeds a TerminalScreen under
+// a mutex. It also writes the keys and pastes the GUI queues for it, as fast
+// as the shell reads them. A program flooding output (cat of a huge file)
+// costs the GUI thread only its frames: at most one per FrameIntervalMs,
+// which copies the dirty rows out under the lock and repaints just their
+// cells. The scroll bar covers the scrollback; new output keeps the view at
+// the bottom unless it was scrolled up. The shell starts when the panel is
+// first shown and again on Enter after it exited; a shell that does not go
+// on hangup is killed after a short wait. Only Linux is supported; elsewhere
+// the panel shows a notice.
+// ---------------------------------------------------------------------------
+class TerminalPanel : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FrameIntervalMs = 16;
+    static constexpr qint64 ScrollbackBytes = 16 * 1024 * 1024;
+
+    explicit TerminalPanel(QWidget *parent = nullptr);
+    ~TerminalPanel() override;
+
+    bool startShell();
+    bool isRunning() const { return m_session != nullptr; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    bool focusNextPrevChild(bool next) override;
+
+private:
+    struct Session;
+
+    void stopShell();
+    void onShellExited(quint64 generation);
+    void scheduleFrame();
+    void updateFrame();
+    void sendBytes(const QByteArray &bytes);
+    void paste();
+
+    int lineHeight() const;
+    int charWidth() const;
+    int gridRows() const;
+    int gridColumns() const;
+    void cellColors(const TerminalCell &cell, QColor *foreground, QColor *background) const;
+
+    std::unique_ptr<Session> m_session;
+    quint64 m_generation = 0;
+    bool m_started = false;
+    QString m_message; // shown when no shell can run
+    QTimer *m_frameTimer = nullptr;
+    QElapsedTimer m_lastFrame;
+
+    // GUI copy of the visible rows, refreshed by updateFrame()
+    std::vector<std::vector<TerminalCell>> m_rows;
+    qint64 m_topLine = 0;        // first visible line, scrollback included
+    quint64 m_droppedLines = 0;  // of the scrollback, when last copied
+    bool m_following = true;     // the view sticks to the bottom
+    bool m_fullRepaint = true;
+    int m_cursorRow = -1;        // in m_rows, -1 if not visible
+    int m_cursorColumn = 0;
+    bool m_applicationCursorKeys = false;
+    bool m_bracketedPaste = false;
+};
@@ -0,0 +1,911 @@
+#include "TextEditorPanel.h"
+#include "SyntaxHighlighter.h"
+
+#include <QAction>
+#include <QApplication>
+#include <QClipboard>
+#include <QDebug>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QInputMethodEvent>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLocale>
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QSaveFile>
+#include <QScrollBar>
+#include <QThreadPool>
+#include <QToolBar>
+#include <QVBoxLayout>
+
+#include <climits>
+
+namespace
+{
+constexpr int TextMargin = 4;
+
+// Copying more than this would only stall the clipboard
+constexpr qint64 MaxClipboardBytes = 64 * 1024 * 1024;
+
+// Enter copies at most this much leading whitespace
+constexpr qint64 MaxIndentBytes = 256;
+
+// The view hears from the line indexing job this often (256 MB)
+constexpr qint64 IndexProgressBlocks = 4096;
+
+bool isContinuationByte(char c)
+{
+    return (uchar(c) & 0xC0) == 0x80;
+}
+
+// Screen columns taken by the first count bytes of a painted slice
+int displayColumn(const QByteArray &bytes, qint64 count)
+{
+    int column = 0;
+    for (qint64 i = 0; i < count && i < bytes.size(); ++i)
+    {
+        if (bytes[i] == '\t')
+            column += TextView::TabWidth - column % TextView::TabWidth;
+        else if (!isContinuationByte(bytes[i]))
+            ++column;
+    }
+    return column;
+}
+
+// A run of a slice as painted from column: tabs expanded, control bytes
+// blanked
+QString displayText(const QByteArray &bytes, int column)
+{
+    QByteArray expanded;
+    expanded.reserve(bytes.size());
+    qint64 i = 0;
+    // Slices may start inside a UTF-8 sequence
+    while (i < bytes.size() && isContinuationByte(bytes[i]))
+        ++i;
+    for (; i < bytes.size(); ++i)
+    {
+        const uchar c = uchar(bytes[i]);
+        if (c == '\t')
+        {
+            const int spaces = TextView::TabWidth - column % TextView::TabWidth;
+            expanded.append(spaces, ' ');
+            column += spaces;
+        }
+        else
+        {
+            expanded.append(c < 0x20 ? ' ' : char(c));
+            if (!isContinuationByte(char(c)))
+                ++column;
+        }
+    }
+    return QString::fromUtf8(expanded);
+}
+
+QColor formatColor(HighlightFormat format)
+{
+    switch (format)
+    {
+    case HighlightFormat::Keyword:
+        return QColor(0x56, 0x9c, 0xd6);
+    case HighlightFormat::Number:
+        return QColor(0xb5, 0xce, 0xa8);
+    case HighlightFormat::String:
+        return QColor(0xce, 0x91, 0x78);
+    case HighlightFormat::Comment:
+        return QColor(0x6a, 0x99, 0x55);
+    case HighlightFormat::Preprocessor:
+        return QColor(0xc5, 0x86, 0xc0);
+    }
+    return QColor();
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TextView
+// ---------------------------------------------------------------------------
+TextView::TextView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+    setAttribute(Qt::WA_InputMethodEnabled);
+    viewport()->setCursor(Qt::IBeamCursor);
+    updateScrollBars();
+}
+
+TextView::~TextView()
+{
+    cancelLineIndexing();
+}
+
+void TextView::setSource(std::shared_ptr<TextSource> source)
+{
+    cancelLineIndexing();
+    m_buffer = PieceTable(std::move(source));
+    m_buffer.setIndexBudget(IndexBudgetBlocks);
+    m_cursor = 0;
+    m_anchor = 0;
+    m_preferredColumn = -1;
+    m_longestLine = 0;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    startLineIndexing();
+    if (m_highlighter)
+        m_highlighter->reset();
+    updateScrollBars();
+    viewport()->update();
+    emit cursorPositionChanged(1, 1);
+    emit modificationChanged(false);
+}
+
+void TextView::setLineNumbersVisible(bool visible)
+{
+    m_lineNumbers = visible;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void TextView::setSyntaxHighlighting(bool enabled)
+{
+    if (enabled == (m_highlighter != nullptr))
+        return;
+    if (enabled)
+    {
+        m_highlighter = new SyntaxHighlighter(&m_buffer, this);
+        connect(m_highlighter, &SyntaxHighlighter::linesHighlighted, viewport(), [this]()
+        {
+            viewport()->update();
+        });
+    }
+    else
+    {
+        delete m_highlighter;
+        m_highlighter = nullptr;
+    }
+    viewport()->update();
+}
+
+void TextView::setPlaceholderText(const QString &text)
+{
+    m_placeholderText = text;
+    viewport()->update();
+}
+
+// ---------------------------------------------------------------------------
+// Line indexing
+// ---------------------------------------------------------------------------
+void TextView::startLineIndexing()
+{
+    std::shared_ptr<LineIndex> index = m_buffer.lineIndex();
+    if (index->isComplete())
+        return;
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_indexCancelled = cancelled;
+    QPointer<TextView> guard(this);
+    QThreadPool::globalInstance()->start([guard, index, cancelled]()
+    {
+        // The buffer reads the index as it grows; the view only needs to
+        // know when to refresh its estimates
+        while (!index->isComplete())
+        {
+            if (!index->indexTo(index->indexedBlocks() + IndexProgressBlocks, cancelled.get()))
+                return;
+            const bool complete = index->isComplete();
+            QMetaObject::invokeMethod(qApp, [guard, index, cancelled, complete]()
+            {
+                if (guard && !cancelled->load() && guard->m_buffer.lineIndex() == index)
+                    guard->onLinesIndexed(complete);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void TextView::cancelLineIndexing()
+{
+    if (m_indexCancelled)
+        m_indexCancelled->store(true);
+    m_indexCancelled.reset();
+}
+
+void TextView::onLinesIndexed(bool complete)
+{
+    if (complete)
+        m_indexCancelled.reset();
+    updateScrollBars();
+    viewport()->update();
+    if (complete)
+        emit linesIndexed();
+}
+
+// ---------------------------------------------------------------------------
+// Geometry
+// ---------------------------------------------------------------------------
+int TextView::lineHeight() const
+{
+    return fontMetrics().height();
+}
+
+int TextView::charWidth() const
+{
+    return qMax(1, fontMetrics().horizontalAdvance(QLatin1Char('M')));
+}
+
+int TextView::gutterWidth() const
+{
+    if (!m_lineNumbers)
+        return 0;
+    return charWidth() * (int(QString::number(m_scrollLines).size()) + 1) + TextMargin;
+}
+
+int TextView::visibleRows() const
+{
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+int TextView::visibleColumns() const
+{
+    return qMax(1, (viewport()->width() - gutterWidth() - TextMargin) / charWidth());
+}
+
+void TextView::updateScrollBars()
+{
+    // The estimate must still reach the cursor
+    m_scrollLines = m_buffer.isLineCountKnown()
+                        ? m_buffer.lineCount()
+                        : qMax(m_buffer.estimatedLineCount(), m_buffer.lineOfOffset(m_cursor) + 1);
+
+    const int rows = visibleRows();
+    verticalScrollBar()->setPageStep(rows);
+    verticalScrollBar()->setRange(0, int(qBound<qint64>(0, m_scrollLines - rows, INT_MAX)));
+
+    const int columns = visibleColumns();
+    horizontalScrollBar()->setPageStep(columns);
+    horizontalScrollBar()->setRange(0, int(qBound<qint64>(0, m_longestLine + 1 - columns, INT_MAX)));
+}
+
+void TextView::ensureCursorVisible()
+{
+    const qint64 line = m_buffer.lineOfOffset(m_cursor);
+    const qint64 column = m_cursor - m_buffer.lineStartAt(m_cursor, MaxLineBytes);
+    m_longestLine = qMax(m_longestLine, column);
+    updateScrollBars();
+
+    QScrollBar *vertical = verticalScrollBar();
+    const int rows = visibleRows();
+    if (line < vertical->value())
+        vertical->setValue(int(qMin<qint64>(line, INT_MAX)));
+    else if (line >= vertical->value() + rows)
+        vertical->setValue(int(qMin<qint64>(line - rows + 1, INT_MAX)));
+
+    QScrollBar *horizontal = horizontalScrollBar();
+    const int columns = visibleColumns();
+    if (column < horizontal->value())
+        horizontal->setValue(int(qMin<qint64>(column, INT_MAX)));
+    else if (column >= horizontal->value() + columns)
+        horizontal->setValue(int(qMin<qint64>(column - columns + 1, INT_MAX)));
+}
+
+qint64 TextView::offsetAt(const QPoint &pos)
+{
+    // Row by row from the first visible line, as painted
+    const int row = qMax(0, pos.y()) / lineHeight();
+    qint64 start = m_buffer.lineStart(verticalScrollBar()->value());
+    qint64 end = -1;
+    for (int r = 0; start >= 0; ++r)
+    {
+        qint64 next = -1;
+        end = rowEnd(start, &next);
+        if (r == row)
+            break;
+        start = next;
+    }
+    if (start < 0)
+        return m_buffer.size();
+    const qint64 from = qMin(start + horizontalScrollBar()->value(), end);
+    const QByteArray bytes = m_buffer.read(from, qint64(visibleColumns() + 1) * 4);
+
+    // Nearest gap between characters
+    const int width = charWidth();
+    const int target = qMax(0, pos.x() - gutterWidth() - TextMargin + width / 2) / width;
+    qint64 i = 0;
+    while (i < bytes.size() && from + i < end)
+    {
+        qint64 next = i + 1;
+        while (next < bytes.size() && isContinuationByte(bytes[next]))
+            ++next;
+        if (displayColumn(bytes, next) > target)
+            break;
+        i = next;
+    }
+    return qMin(from + i, end);
+}
+
+// End of the row starting at start: its '\n' or the end of the text, or
+// MaxLineBytes on for a longer line. next is the start of the next row, -1
+// after the last.
+qint64 TextView::rowEnd(qint64 start, qint64 *next) const
+{
+    const qint64 end = m_buffer.lineEndAt(start, MaxLineBytes);
+    if (end < 0)
+    {
+        *next = start + MaxLineBytes;
+        return *next;
+    }
+    *next = end < m_buffer.size() ? end + 1 : -1;
+    return end;
+}
+
+// ---------------------------------------------------------------------------
+// Painting
+// ---------------------------------------------------------------------------
+void TextView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+
+    const int height = lineHeight();
+    const int width = charWidth();
+    const int ascent = fontMetrics().ascent();
+    const int gutter = gutterWidth();
+    const int left = gutter + TextMargin;
+    const qint64 hOffset = horizontalScrollBar()->value();
+    const qint64 sliceBytes = qint64(visibleColumns() + 1) * 4;
+    const qint64 selectionStart = qMin(m_cursor, m_anchor);
+    const qint64 selectionEnd = qMax(m_cursor, m_anchor);
+    const QRect textArea(gutter, 0, viewport()->width() - gutter, viewport()->height());
+
+    if (m_lineNumbers)
+        painter.fillRect(QRect(0, 0, gutter, viewport()->height()), palette().window());
+
+    if (m_buffer.size() == 0 && !m_placeholderText.isEmpty())
+    {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(textArea.adjusted(TextMargin, 0, 0, 0), Qt::AlignLeft | Qt::AlignTop, m_placeholderText);
+    }
+
+    // Walk line by line from the first visible one; only these are read.
+    // Its start may be an estimate, its line then has no colours yet.
+    const qint64 firstLine = verticalScrollBar()->value();
+    const int rows = viewport()->height() / height + 1;
+    if (m_highlighter)
+        m_highlighter->setVisibleLines(firstLine, rows);
+    const qint64 longestBefore = m_longestLine;
+    qint64 start = m_buffer.lineStart(firstLine);
+    const bool exactLines = start >= 0 && m_buffer.linesExactBefore(start);
+    for (int row = 0; row < rows && start >= 0; ++row)
+    {
+        const qint64 line = firstLine + row;
+        qint64 next = -1;
+        const qint64 end = rowEnd(start, &next);
+        const int y = row * height;
+        m_longestLine = qMax(m_longestLine, end - start);
+
+        const qint64 from = qMin(start + hOffset, end);
+        const QByteArray bytes = m_buffer.read(from, qMin(sliceBytes, end - from));
+        const qint64 to = from + bytes.size();
+
+        painter.setClipRect(textArea);
+        if (selectionStart < selectionEnd && selectionStart <= end && selectionEnd > start)
+        {
+            const int x0 = displayColumn(bytes, qBound(from, selectionStart, to) - from);
+            int x1 = displayColumn(bytes, qBound(from, selectionEnd, to) - from);
+            if (selectionEnd > end)
+                ++x1; // the line break is selected too
+            painter.fillRect(QRect(left + x0 * width, y, (x1 - x0) * width, height), palette().highlight());
+        }
+
+        // Plain text up to each span, then the span in its colour; spans
+        // are in line offsets and may stick out of the slice
+        const QColor textColor = palette().color(QPalette::Text);
+        const QVector<HighlightSpan> *spans = m_highlighter && exactLines ? m_highlighter->lineSpans(line) : nullptr;
+        const auto drawRun = [&](qint64 begin, qint64 runEnd, const QColor &color)
+        {
+            if (begin >= runEnd)
+                return;
+            const int column = displayColumn(bytes, begin);
+            painter.setPen(color);
+            painter.drawText(left + column * width, y + ascent, displayText(bytes.mid(begin, runEnd - begin), column));
+        };
+        qint64 done = 0;
+        if (spans)
+        {
+            for (const HighlightSpan &span : *spans)
+            {
+                const qint64 spanBegin = qBound<qint64>(done, start + span.start - from, bytes.size());
+                const qint64 spanEnd = qBound<qint64>(spanBegin, start + span.start + span.length - from, bytes.size());
+                drawRun(done, spanBegin, textColor);
+                drawRun(spanBegin, spanEnd, formatColor(span.format));
+                done = spanEnd;
+            }
+        }
+        drawRun(done, bytes.size(), textColor);
+
+        if (hasFocus() && m_cursor >= from && m_cursor <= to && m_cursor <= end)
+            painter.fillRect(QRect(left + displayColumn(bytes, m_cursor - from) * width, y, 2, height),
+                             palette().text());
+
+        if (m_lineNumbers)
+        {
+            painter.setClipping(false);
+            painter.setPen(palette().color(QPalette::PlaceholderText));
+            painter.drawText(QRect(0, y, gutter - TextMargin, height), Qt::AlignRight | Qt::AlignVCenter,
+                             QString::number(line + 1));
+        }
+
+        start = next;
+    }
+
+    if (m_longestLine != longestBefore)
+    {
+        horizontalScrollBar()->setRange(
+            0, int(qBound<qint64>(0, m_longestLine + 1 - visibleColumns(), INT_MAX)));
+    }
+}
+
+void TextView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void TextView::scrollContentsBy(int, int)
+{
+    // Scroll bars count lines and byte columns, not pixels
+    viewport()->update();
+}
+
+void TextView::focusInEvent(QFocusEvent *event)
+{
+    QAbstractScrollArea::focusInEvent(event);
+    viewport()->update();
+}
+
+void TextView::focusOutEvent(QFocusEvent *event)
+{
+    QAbstractScrollArea::focusOutEvent(event);
+    viewport()->update();
+}
+
+bool TextView::focusNextPrevChild(bool)
+{
+    // Tab is text here
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Cursor movement
+// ---------------------------------------------------------------------------
+qint64 TextView::previousCharacter(qint64 offset) const
+{
+    if (offset <= 0)
+        return 0;
+    const qint64 from = qMax<qint64>(0, offset - 4);
+    const QByteArray bytes = m_buffer.read(from, offset - from);
+    qint64 i = bytes.size() - 1;
+    while (i > 0 && isContinuationByte(bytes[i]))
+        --i;
+    return from + i;
+}
+
+qint64 TextView::nextCharacter(qint64 offset) const
+{
+    if (offset >= m_buffer.size())
+        return m_buffer.size();
+    const QByteArray bytes = m_buffer.read(offset, 4);
+    qint64 i = 1;
+    while (i < bytes.size() && isContinuationByte(bytes[i]))
+        ++i;
+    return offset + i;
+}
+
+qint64 TextView::verticalMove(qint64 lines)
+{
+    // Line by line from the cursor, without the line index
+    qint64 start = m_buffer.lineStartAt(m_cursor, MaxLineBytes);
+    if (m_preferredColumn < 0)
+        m_preferredColumn = m_cursor - start;
+
+    for (; lines < 0 && start > 0; ++lines)
+        start = m_buffer.lineStartAt(start - 1, MaxLineBytes);
+    qint64 next = -1;
+    for (; lines > 0; --lines)
+    {
+        rowEnd(start, &next);
+        if (next < 0)
+            return m_buffer.size();
+        start = next;
+    }
+    const qint64 end = rowEnd(start, &next);
+    const qint64 offset = qMin(start + m_preferredColumn, end);
+    // Never land inside a UTF-8 sequence
+    return offset < end ? previousCharacter(offset + 1) : offset;
+}
+
+void TextView::moveCursor(qint64 offset, bool keepAnchor)
+{
+    m_cursor = qBound<qint64>(0, offset, m_buffer.size());
+    if (!keepAnchor)
+        m_anchor = m_cursor;
+    // Typing somewhere else starts a new undo step
+    m_buffer.breakUndoGroup();
+    ensureCursorVisible();
+    viewport()->update();
+
+    const qint64 line = m_buffer.lineOfOffset(m_cursor);
+    emit cursorPositionChanged(line + 1, m_cursor - m_buffer.lineStartAt(m_cursor, MaxLineBytes) + 1);
+}
+
+void TextView::selectAll()
+{
+    m_anchor = 0;
+    moveCursor(m_buffer.size(), true);
+}
+
+// ---------------------------------------------------------------------------
+// Editing
+// ---------------------------------------------------------------------------
+void TextView::afterEdit(bool wasModified)
+{
+    m_preferredColumn = -1;
+    ensureCursorVisible();
+    viewport()->update();
+
+    const qint64 line = m_buffer.lineOfOffset(m_cursor);
+    emit cursorPositionChanged(line + 1, m_cursor - m_buffer.lineStartAt(m_cursor, MaxLineBytes) + 1);
+    if (wasModified != m_buffer.isModified())
+        emit modificationChanged(m_buffer.isModified());
+}
+
+// Moves the highlighter's line states along with the edit. Past the part
+// of the file indexed so far the line of the edit is not known; the states
+// after the last known line are then lexed again.
+void TextView::bufferChanged()
+{
+    if (!m_highlighter)
+        return;
+    const PieceTable::Change &change = m_buffer.lastChange();
+    bool exact = true;
+    const qint64 line = m_buffer.knownLineOfOffset(change.offset, &exact);
+    if (exact)
+        m_highlighter->linesChanged(line, change.removedBreaks, change.insertedBreaks);
+    else
+        m_highlighter->linesChangedAfter(line);
+}
+
+void TextView::removeSelection()
+{
+    const qint64 from = qMin(m_cursor, m_anchor);
+    m_buffer.remove(from, qAbs(m_cursor - m_anchor));
+    bufferChanged();
+    m_cursor = from;
+    m_anchor = from;
+}
+
+void TextView::insertText(const QByteArray &text)
+{
+    const bool wasModified = m_buffer.isModified();
+    if (hasSelection())
+    {
+        m_buffer.breakUndoGroup();
+        removeSelection();
+    }
+    m_buffer.insert(m_cursor, text);
+    bufferChanged();
+    m_cursor += text.size();
+    m_anchor = m_cursor;
+    afterEdit(wasModified);
+}
+
+void TextView::undo()
+{
+    const bool wasModified = m_buffer.isModified();
+    const qint64 caret = m_buffer.undo();
+    if (caret < 0)
+        return;
+    bufferChanged();
+    m_cursor = caret;
+    m_anchor = caret;
+    afterEdit(wasModified);
+}
+
+void TextView::redo()
+{
+    const bool wasModified = m_buffer.isModified();
+    const qint64 caret = m_buffer.redo();
+    if (caret < 0)
+        return;
+    bufferChanged();
+    m_cursor = caret;
+    m_anchor = caret;
+    afterEdit(wasModified);
+}
+
+void TextView::copy()
+{
+    const qint64 length = qAbs(m_cursor - m_anchor);
+    if (length == 0)
+        return;
+    if (length > MaxClipboardBytes)
+    {
+        qWarning() << "TextView: selection of" << length << "bytes is too large for the clipboard";
+        return;
+    }
+    QApplication::clipboard()->setText(QString::fromUtf8(m_buffer.read(qMin(m_cursor, m_anchor), length)));
+}
+
+void TextView::cut()
+{
+    const qint64 length = qAbs(m_cursor - m_anchor);
+    if (length == 0 || length > MaxClipboardBytes)
+    {
+        copy();
+        return;
+    }
+    copy();
+    const bool wasModified = m_buffer.isModified();
+    m_buffer.breakUndoGroup();
+    removeSelection();
+    m_buffer.breakUndoGroup();
+    afterEdit(wasModified);
+}
+
+void TextView::paste()
+{
+    const QByteArray text = QApplication::clipboard()->text().toUtf8();
+    if (text.isEmpty())
+        return;
+    // A paste is its own undo step, even without line breaks
+    m_buffer.breakUndoGroup();
+    insertText(text);
+    m_buffer.breakUndoGroup();
+}
+
+void TextView::keyPressEvent(QKeyEvent *event)
+{
+    if (event == QKeySequence::Undo)
+        return undo();
+    if (event == QKeySequence::Redo)
+        return redo();
+    if (event == QKeySequence::Copy)
+        return copy();
+    if (event == QKeySequence::Cut)
+        return cut();
+    if (event == QKeySequence::Paste)
+        return paste();
+    if (event == QKeySequence::SelectAll)
+        return selectAll();
+
+    const bool shift = event->modifiers().testFlag(Qt::ShiftModifier);
+    const bool control = event->modifiers().testFlag(Qt::ControlModifier);
+    switch (event->key())
+    {
+    case Qt::Key_Up:
+        return moveCursor(verticalMove(-1), shift);
+    case Qt::Key_Down:
+        return moveCursor(verticalMove(1), shift);
+    case Qt::Key_PageUp:
+        return moveCursor(verticalMove(-visibleRows()), shift);
+    case Qt::Key_PageDown:
+        return moveCursor(verticalMove(visibleRows()), shift);
+    default:
+        break;
+    }
+
+    m_preferredColumn = -1;
+    switch (event->key())
+    {
+    case Qt::Key_Left:
+        return moveCursor(hasSelection() && !shift ? qMin(m_cursor, m_anchor) : previousCharacter(m_cursor), shift);
+    case Qt::Key_Right:
+        return moveCursor(hasSelection() && !shift ? qMax(m_cursor, m_anchor) : nextCharacter(m_cursor), shift);
+    case Qt::Key_Home:
+        return moveCursor(control ? 0 : m_buffer.lineStartAt(m_cursor, MaxLineBytes), shift);
+    case Qt::Key_End:
+    {
+        qint64 next = -1;
+        return moveCursor(control ? m_buffer.size() : rowEnd(m_cursor, &next), shift);
+    }
+    case Qt::Key_Backspace:
+    case Qt::Key_Delete:
+    {
+        const bool wasModified = m_buffer.isModified();
+        if (hasSelection())
+        {
+            m_buffer.breakUndoGroup();
+            removeSelection();
+        }
+        else
+        {
+            const bool backspace = event->key() == Qt::Key_Backspace;
+            const qint64 from = backspace ? previousCharacter(m_cursor) : m_cursor;
+            const qint64 to = backspace ? m_cursor : nextCharacter(m_cursor);
+            if (from == to)
+                return;
+            m_buffer.remove(from, to - from);
+            bufferChanged();
+            m_cursor = from;
+            m_anchor = from;
+        }
+        return afterEdit(wasModified);
+    }
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+    {
+        // Carry the indentation of the current line over
+        const qint64 start = m_buffer.lineStartAt(qMin(m_cursor, m_anchor), MaxLineBytes);
+        const QByteArray head = m_buffer.read(start, qMin(qMin(m_cursor, m_anchor) - start, MaxIndentBytes));
+        int indent = 0;
+        while (indent < head.size() && (head[indent] == ' ' || head[indent] == '\t'))
+            ++indent;
+        return insertText('\n' + head.left(indent));
+    }
+    case Qt::Key_Tab:
+        return insertText(QByteArrayLiteral("\t"));
+    default:
+        break;
+    }
+
+    const QString text = event->text();
+    if (!text.isEmpty() && text.at(0).isPrint() && !control)
+        return insertText(text.toUtf8());
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void TextView::inputMethodEvent(QInputMethodEvent *event)
+{
+    if (!event->commitString().isEmpty())
+        insertText(event->commitString().toUtf8());
+    event->accept();
+}
+
+void TextView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return QAbstractScrollArea::mousePressEvent(event);
+    m_preferredColumn = -1;
+    moveCursor(offsetAt(event->position().toPoint()), event->modifiers().testFlag(Qt::ShiftModifier));
+}
+
+void TextView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons().testFlag(Qt::LeftButton))
+        moveCursor(offsetAt(event->position().toPoint()), true);
+}
+
+// ---------------------------------------------------------------------------
+// TextEditorPanel
+// ---------------------------------------------------------------------------
+TextEditorPanel::TextEditorPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+
+    auto *toolBar = new QToolBar(this);
+    auto *openAction = toolBar->addAction(tr("Open..."));
+    connect(openAction, &QAction::triggered, this, &TextEditorPanel::onOpenClicked);
+    auto *saveAction = toolBar->addAction(tr("Save"));
+    saveAction->setShortcut(QKeySequence::Save);
+    saveAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(saveAction, &QAction::triggered, this, &TextEditorPanel::onSaveClicked);
+    m_fileLabel = new QLabel(toolBar);
+    toolBar->addWidget(m_fileLabel);
+    layout->addWidget(toolBar);
+
+    m_view = new TextView(this);
+    layout->addWidget(m_view, 1);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setContentsMargins(4, 2, 4, 2);
+    layout->addWidget(m_statusLabel);
+
+    connect(m_view, &TextView::cursorPositionChanged, this, &TextEditorPanel::updateStatus);
+    connect(m_view, &TextView::modificationChanged, this, &TextEditorPanel::updateFileLabel);
+    connect(m_view, &TextView::linesIndexed, this, &TextEditorPanel::updateFileLabel);
+
+    updateFileLabel();
+    updateStatus(1, 1);
+}
+
+bool TextEditorPanel::openFile(const QString &fileName)
+{
+    if (m_view->buffer().isModified()
+        && QMessageBox::question(this, tr("Editor"), tr("Discard unsaved changes?")) != QMessageBox::Yes)
+        return false;
+
+    QString error;
+    std::shared_ptr<TextSource> source = TextSource::open(fileName, &error);
+    if (!source)
+    {
+        QMessageBox::warning(this, tr("Editor"), tr("Cannot open %1: %2").arg(fileName, error));
+        return false;
+    }
+
+    m_fileName = fileName;
+    m_view->setSource(std::move(source));
+    updateFileLabel();
+    return true;
+}
+
+void TextEditorPanel::saveFile(const QString &fileName)
+{
+    // One save at a time
+    if (m_saving)
+        return;
+    PieceTable &buffer = m_view->buffer();
+    // Typing from here on is a change after the saved text
+    buffer.breakUndoGroup();
+    auto snapshot = std::make_shared<PieceTable>(buffer.snapshot());
+    const quint64 editCount = buffer.editCount();
+    m_saving = true;
+    updateFileLabel();
+
+    // Written next to the file and renamed over it, so the mapped original
+    // stays intact while the pieces are streamed out
+    QPointer<TextEditorPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, snapshot, editCount, fileName]()
+    {
+        QSaveFile file(fileName);
+        QString error;
+        if (!file.open(QIODevice::WriteOnly) || !snapshot->writeTo(&file) || !file.commit())
+            error = file.errorString();
+
+        QMetaObject::invokeMethod(qApp, [guard, snapshot, editCount, fileName, error]()
+        {
+            if (guard)
+                guard->onSaveFinished(snapshot->original(), editCount, fileName, error);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TextEditorPanel::onSaveFinished(const std::shared_ptr<TextSource> &original, quint64 editCount,
+                                     const QString &fileName, const QString &error)
+{
+    m_saving = false;
+    if (!error.isEmpty())
+        QMessageBox::warning(this, tr("Editor"), tr("Cannot save %1: %2").arg(fileName, error));
+    // Unless another file was opened meanwhile
+    else if (m_view->buffer().original() == original)
+    {
+        m_fileName = fileName;
+        m_view->buffer().setSaved(editCount);
+    }
+    updateFileLabel();
+}
+
+void TextEditorPanel::onOpenClicked()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"));
+    if (!fileName.isEmpty())
+        openFile(fileName);
+}
+
+void TextEditorPanel::onSaveClicked()
+{
+    const QString fileName = m_fileName.isEmpty() ? QFileDialog::getSaveFileName(this, tr("Save File")) : m_fileName;
+    if (!fileName.isEmpty())
+        saveFile(fileName);
+}
+
+void TextEditorPanel::updateFileLabel()
+{
+    PieceTable &buffer = m_view->buffer();
+    QString name = m_fileName.isEmpty() ? tr("Untitled") : QFileInfo(m_fileName).fileName();
+    if (buffer.isModified())
+        name += QStringLiteral(" *");
+    if (m_saving)
+        name += tr(", saving...");
+    const QString lines = buffer.isLineCountKnown() ? tr("%1 lines").arg(buffer.lineCount()) : tr("counting lines...");
+    m_fileLabel->setText(tr("%1 (%2, %3)").arg(name, QLocale().formattedDataSize(buffer.size()), lines));
+}
+
+void TextEditorPanel::updateStatus(qint64 line, qint64 column)
+{
+    m_statusLabel->setText(tr("Ln %1, Col %2").arg(line).arg(column));
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "PieceTable.h"
+
+#include <QAbstractScrollArea>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+class QLabel;
+class SyntaxHighlighter;
+
+// ---------------------------------------------------------------------------
+// Monospace text view over a PieceTable that lays out and paints only the
+// lines in the viewport, so its cost does not depend on the document size.
+//
+// The vertical scroll bar counts lines. A background job indexes the
+// original and publishes its progress as it goes; until it is done the bar
+// uses PieceTable::estimatedLineCount(), and lines past the indexed part are
+// found by estimate, since a query on this thread indexes at most
+// IndexBudgetBlocks itself. Painting and cursor movement scan from there
+// line by line. Columns are byte offsets into the line; tabs expand to the
+// next multiple of TabWidth within the painted slice, and lines longer than
+// MaxLineBytes continue on the next row. With syntax highlighting on, exact
+// lines are coloured as SyntaxHighlighter batches arrive.
+// ---------------------------------------------------------------------------
+class TextView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr int TabWidth = 4;
+    static constexpr qint64 IndexBudgetBlocks = 256; // 16 MB of the original
+    static constexpr qint64 MaxLineBytes = 1024 * 1024;
+
+    explicit TextView(QWidget *parent = nullptr);
+    ~TextView() override;
+
+    void setSource(std::shared_ptr<TextSource> source);
+    PieceTable &buffer() { return m_buffer; }
+
+    void setLineNumbersVisible(bool visible);
+    void setSyntaxHighlighting(bool enabled);
+    void setPlaceholderText(const QString &text);
+
+    void undo();
+    void redo();
+    void copy();
+    void cut();
+    void paste();
+    void selectAll();
+
+signals:
+    void cursorPositionChanged(qint64 line, qint64 column); // 1-based
+    void modificationChanged(bool modified);
+    void linesIndexed();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void inputMethodEvent(QInputMethodEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void focusInEvent(QFocusEvent *event) override;
+    void focusOutEvent(QFocusEvent *event) override;
+    bool focusNextPrevChild(bool next) override;
+
+private:
+    void startLineIndexing();
+    void cancelLineIndexing();
+    void onLinesIndexed(bool complete);
+
+    // Geometry
+    int lineHeight() const;
+    int charWidth() const;
+    int gutterWidth() const;
+    int visibleRows() const;
+    int visibleColumns() const;
+    void updateScrollBars();
+    void ensureCursorVisible();
+    qint64 offsetAt(const QPoint &pos);
+    qint64 rowEnd(qint64 start, qint64 *next) const;
+
+    // Cursor and editing
+    qint64 previousCharacter(qint64 offset) const;
+    qint64 nextCharacter(qint64 offset) const;
+    qint64 verticalMove(qint64 lines);
+    void moveCursor(qint64 offset, bool keepAnchor);
+    bool hasSelection() const { return m_anchor != m_cursor; }
+    void removeSelection();
+    void insertText(const QByteArray &text);
+    void bufferChanged();
+    void afterEdit(bool wasModified);
+
+    PieceTable m_buffer;
+    SyntaxHighlighter *m_highlighter = nullptr;
+    std::shared_ptr<std::atomic_bool> m_indexCancelled; // set while indexing runs
+    QString m_placeholderText;
+    bool m_lineNumbers = false;
+
+    qint64 m_cursor = 0;
+    qint64 m_anchor = 0;
+    qint64 m_preferredColumn = -1; // kept across Up/Down
+    qint64 m_longestLine = 0;      // of the lines painted so far, for the horizontal range
+    qint64 m_scrollLines = 1;      // exact or estimated line count
+};
+
+// ---------------------------------------------------------------------------
+// Editor panel: TextView with Open/Save and a line/column status line.
+// Opening maps the file and shows it at once, however large it is; saving
+// streams a snapshot of the pieces into a QSaveFile on a worker thread, so
+// editing goes on meanwhile.
+// ---------------------------------------------------------------------------
+class TextEditorPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TextEditorPanel(QWidget *parent = nullptr);
+
+    TextView *view() const { return m_view; }
+    bool openFile(const QString &fileName);
+    void saveFile(const QString &fileName);
+
+private:
+    void onOpenClicked();
+    void onSaveClicked();
+    void onSaveFinished(const std::shared_ptr<TextSource> &original, quint64 editCount, const QString &fileName,
+                        const QString &error);
+    void updateFileLabel();
+    void updateStatus(qint64 line, qint64 column);
+
+    TextView *m_view = nullptr;
+    QLabel *m_fileLabel = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    QString m_fileName;
+    bool m_saving = false;
+};
@@ -0,0 +1,413 @@
+#include "TodoListPanel.h"
+#include "ContentSearch.h"
+
+#include <ColumnarItemDelegate.h>
+#include <ColumnarTableModel.h>
+#include <FileSystemIndex.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPointer>
+#include <QPushButton>
+#include <QTableView>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+// Same cadence as the search panel: first markers show up at once, a large
+// project is inserted in a few big batches
+constexpr int FlushIntervalMs = 30;
+
+// Saves and checkouts come as bursts of events; rescan once they settle
+constexpr int RescanDelayMs = 300;
+
+enum Column
+{
+    FileColumn,
+    LineColumn,
+    TextColumn
+};
+} // namespace
+
+struct TodoListPanel::PendingResults
+{
+    std::mutex mutex;
+    QVector<TodoFileResult> files;
+};
+
+TodoListPanel::TodoListPanel(const QString &rootPath, QWidget *parent)
+    : QWidget(parent)
+    , m_rootPath(QDir::cleanPath(rootPath))
+    , m_cache(std::make_shared<TodoCache>())
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+
+    auto *controls = new QHBoxLayout;
+    controls->setContentsMargins(0, 0, 0, 0);
+    m_filterEdit = new QLineEdit(this);
+    m_filterEdit->setPlaceholderText(tr("Filter (text, or = != < <= > >= value)"));
+    m_filterEdit->setClearButtonEnabled(true);
+    controls->addWidget(m_filterEdit, 1);
+    m_rescanButton = new QPushButton(tr("Rescan"), this);
+    controls->addWidget(m_rescanButton);
+    layout->addLayout(controls);
+
+    m_view = new QTableView(this);
+    m_model = new DockManager::ColumnarTableModel(
+        {tr("File"), tr("Line"), tr("TODO Comment")},
+        {DockManager::ColumnType::String, DockManager::ColumnType::Int64, DockManager::ColumnType::String}, m_view);
+    m_view->setModel(m_model);
+    m_view->setItemDelegate(new DockManager::ColumnarItemDelegate(m_view));
+    m_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_view->verticalHeader()->setDefaultSectionSize(m_view->fontMetrics().height() + 4);
+    m_view->horizontalHeader()->setStretchLastSection(true);
+    m_view->horizontalHeader()->resizeSection(FileColumn, 260);
+    m_view->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    m_view->setSortingEnabled(true);
+    layout->addWidget(m_view, 1);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setContentsMargins(4, 0, 4, 4);
+    layout->addWidget(m_statusLabel);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(FlushIntervalMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &TodoListPanel::flushResults);
+
+    m_rescanTimer = new QTimer(this);
+    m_rescanTimer->setSingleShot(true);
+    m_rescanTimer->setInterval(RescanDelayMs);
+    connect(m_rescanTimer, &QTimer::timeout, this, &TodoListPanel::rescanChanges);
+
+    connect(m_filterEdit, &QLineEdit::textChanged, m_model, [this](const QString &text)
+    {
+        m_model->setFilter(-1, text);
+    });
+    connect(m_rescanButton, &QPushButton::clicked, this, &TodoListPanel::startScan);
+
+    // Shares the watches of explorer panels on the same root; scans add the
+    // directories they walk, so ignored trees are never watched for this panel
+    m_index = DockManager::FileSystemIndex::shared(m_rootPath);
+    connect(m_index.get(), &DockManager::FileSystemIndex::directoriesChanged, this,
+            [this](const QStringList &paths)
+    {
+        const bool relevant = std::any_of(paths.cbegin(), paths.cend(),
+                                          [this](const QString &path) { return !isIgnored(path, true); });
+        if (!relevant)
+            return;
+        // An ignore file may have been added or removed
+        m_ignoreRules.clear();
+        m_fullScanPending = true;
+        scheduleRescan();
+    });
+    connect(m_index.get(), &DockManager::FileSystemIndex::filesModified, this, [this](const QStringList &paths)
+    {
+        const QDir root(m_rootPath);
+        bool changed = false;
+        for (const QString &path : paths)
+        {
+            if (isIgnored(path, false))
+                continue;
+            changed = true;
+            const QString name = path.mid(path.lastIndexOf(QLatin1Char('/')) + 1);
+            if (name == QLatin1String(".gitignore") || name == QLatin1String(".ignore"))
+            {
+                m_ignoreRules.clear();
+                m_fullScanPending = true;
+            }
+            else
+            {
+                m_modifiedFiles.insert(root.filePath(path));
+            }
+        }
+        if (changed)
+            scheduleRescan();
+    });
+
+    startScan();
+}
+
+TodoListPanel::~TodoListPanel()
+{
+    if (m_cancelled)
+        m_cancelled->store(true);
+}
+
+// ---------------------------------------------------------------------------
+// Full scans
+// ---------------------------------------------------------------------------
+void TodoListPanel::startScan()
+{
+    m_rescanTimer->stop();
+    if (m_jobRunning)
+    {
+        // Cancel a running scan and start over once the job has returned
+        if (m_cancelled)
+            m_cancelled->store(true);
+        m_fullScanPending = true;
+        return;
+    }
+    m_fullScanPending = false;
+    m_modifiedFiles.clear();
+
+    // Only the first scan fills the table live; later ones swap it when done
+    m_streaming = m_markers.isEmpty() && m_model->rowCount() == 0;
+    m_scanMarkers.clear();
+
+    m_jobRunning = true;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    auto pending = std::make_shared<PendingResults>();
+    m_cancelled = cancelled;
+    m_pending = pending;
+    m_elapsed.start();
+    m_flushTimer->start();
+    updateStatus(tr("Scanning..."));
+
+    const QString rootPath = m_rootPath;
+    const QString cachePath = TodoCache::defaultPath(rootPath);
+    const bool loadCache = !m_cacheLoaded;
+    m_cacheLoaded = true;
+    std::shared_ptr<TodoCache> cache = m_cache;
+    std::shared_ptr<DockManager::FileSystemIndex> index = m_index;
+
+    // scanTodos() blocks while its own worker threads walk the tree. No other
+    // job runs meanwhile, so the cache is loaded before anyone reads it.
+    QPointer<TodoListPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, rootPath, cachePath, loadCache, cache, index, cancelled,
+                                          pending]()
+    {
+        if (loadCache)
+            cache->load(cachePath);
+        const auto collect = [pending](TodoFileResult &&result)
+        {
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->files.append(std::move(result));
+        };
+        TodoScanStats stats;
+        QStringList directories;
+        const bool completed = scanTodos(rootPath, *cache, *cancelled, collect, &stats, &directories);
+        if (completed)
+        {
+            cache->save(cachePath);
+            // Lists and watches each directory once; known ones are a lookup
+            const QDir root(index->rootPath());
+            for (const QString &directory : std::as_const(directories))
+            {
+                if (cancelled->load())
+                    break;
+                const QString relativePath = root.relativeFilePath(directory);
+                index->entries(relativePath == QLatin1String(".") ? QString() : relativePath);
+            }
+        }
+
+        QMetaObject::invokeMethod(qApp, [guard, completed, stats]()
+        {
+            if (guard)
+                guard->onScanFinished(completed, stats);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TodoListPanel::flushResults()
+{
+    if (!m_pending)
+        return;
+    QVector<TodoFileResult> files;
+    {
+        std::lock_guard<std::mutex> lock(m_pending->mutex);
+        files.swap(m_pending->files);
+    }
+    if (files.isEmpty())
+        return;
+
+    for (const TodoFileResult &file : std::as_const(files))
+        m_scanMarkers.insert(file.path, file.markers);
+    if (!m_streaming)
+        return;
+
+    // One rowsInserted for the whole batch
+    const QDir root(m_rootPath);
+    DockManager::ColumnarTable rows = m_model->createTable();
+    for (const TodoFileResult &file : std::as_const(files))
+    {
+        const QString relativePath = root.relativeFilePath(file.path);
+        for (const TodoMarker &marker : file.markers)
+        {
+            const int r = rows.appendRow();
+            rows.setString(r, FileColumn, relativePath);
+            rows.setInt64(r, LineColumn, marker.line);
+            rows.setString(r, TextColumn, marker.text);
+        }
+    }
+    m_model->appendRows(rows);
+    updateStatus(tr("Scanning..."));
+}
+
+void TodoListPanel::onScanFinished(bool completed, const TodoScanStats &stats)
+{
+    m_jobRunning = false;
+    m_cancelled.reset();
+    flushResults();
+    m_pending.reset();
+    m_flushTimer->stop();
+    if (!completed)
+    {
+        // Cancelled by startScan(), which is waiting for this job
+        if (m_fullScanPending)
+            startScan();
+        return;
+    }
+
+    m_markers.swap(m_scanMarkers);
+    m_scanMarkers.clear();
+    if (!m_streaming)
+        rebuildTable();
+    m_streaming = false;
+
+    updateStatus(tr("Read %1 files, %2 unchanged from cache, in %3 ms;")
+                     .arg(stats.filesRead)
+                     .arg(stats.filesCached)
+                     .arg(m_elapsed.elapsed()));
+
+    // Changes that came in while scanning
+    if (m_fullScanPending || !m_modifiedFiles.isEmpty())
+        scheduleRescan();
+}
+
+// ---------------------------------------------------------------------------
+// Incremental rescans
+// ---------------------------------------------------------------------------
+bool TodoListPanel::isIgnored(const QString &relativePath, bool isDir)
+{
+    // Same rules as walkFiles(), applied from the root down; the ignore files
+    // of a directory are read once
+    const QStringList names = relativePath.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    QString directory;
+    std::shared_ptr<const IgnoreRules> rules;
+    for (int i = 0; i < names.size(); ++i)
+    {
+        auto it = m_ignoreRules.constFind(directory);
+        if (it == m_ignoreRules.constEnd())
+        {
+            const QString absolutePath = directory.isEmpty() ? m_rootPath : m_rootPath + QLatin1Char('/') + directory;
+            it = m_ignoreRules.insert(directory, IgnoreRules::load(rules, absolutePath));
+        }
+        rules = *it;
+
+        const bool last = i == names.size() - 1;
+        const bool nameIsDir = !last || isDir;
+        directory = directory.isEmpty() ? names.at(i) : directory + QLatin1Char('/') + names.at(i);
+        if (nameIsDir && isVcsDirectory(names.at(i)))
+            return true;
+        if (rules && rules->isIgnored(m_rootPath + QLatin1Char('/') + directory, nameIsDir))
+            return true;
+    }
+    return false;
+}
+
+void TodoListPanel::scheduleRescan()
+{
+    // The running job picks them up when it is done
+    if (!m_jobRunning)
+        m_rescanTimer->start();
+}
+
+void TodoListPanel::rescanChanges()
+{
+    if (m_jobRunning)
+        return;
+    if (m_fullScanPending)
+    {
+        // Unchanged files come from the cache, so this stats rather than reads
+        startScan();
+        return;
+    }
+    if (m_modifiedFiles.isEmpty())
+        return;
+
+    const QStringList paths(m_modifiedFiles.cbegin(), m_modifiedFiles.cend());
+    m_modifiedFiles.clear();
+    m_jobRunning = true;
+    const QString cachePath = TodoCache::defaultPath(m_rootPath);
+    std::shared_ptr<TodoCache> cache = m_cache;
+
+    QPointer<TodoListPanel> guard(this);
+    QThreadPool::globalInstance()->start([guard, paths, cachePath, cache]()
+    {
+        QVector<TodoFileResult> results;
+        TodoScanStats stats;
+        rescanTodoFiles(paths, *cache, [&results](TodoFileResult &&result) { results.append(std::move(result)); },
+                        &stats);
+        if (stats.filesRead > 0)
+            cache->save(cachePath);
+
+        QMetaObject::invokeMethod(qApp, [guard, results, stats]()
+        {
+            if (guard)
+                guard->onFilesRescanned(results, stats);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void TodoListPanel::onFilesRescanned(const QVector<TodoFileResult> &results, const TodoScanStats &stats)
+{
+    m_jobRunning = false;
+    if (stats.filesRead > 0)
+    {
+        for (const TodoFileResult &file : results)
+        {
+            if (file.markers.isEmpty())
+                m_markers.remove(file.path);
+            else
+                m_markers.insert(file.path, file.markers);
+        }
+        rebuildTable();
+        updateStatus(tr("Updated %n changed file(s);", nullptr, int(stats.filesRead)));
+    }
+
+    // Changes that came in while rescanning
+    if (m_fullScanPending || !m_modifiedFiles.isEmpty())
+        scheduleRescan();
+}
+
+void TodoListPanel::rebuildTable()
+{
+    QStringList paths = m_markers.keys();
+    std::sort(paths.begin(), paths.end());
+
+    const QDir root(m_rootPath);
+    DockManager::ColumnarTable rows = m_model->createTable();
+    for (const QString &path : std::as_const(paths))
+    {
+        const QString relativePath = root.relativeFilePath(path);
+        for (const TodoMarker &marker : m_markers.value(path))
+        {
+            const int r = rows.appendRow();
+            rows.setString(r, FileColumn, relativePath);
+            rows.setInt64(r, LineColumn, marker.line);
+            rows.setString(r, TextColumn, marker.text);
+        }
+    }
+    // One reset; the active sort and filter are applied again in the background
+    m_model->setTable(std::move(rows));
+}
+
+void TodoListPanel::updateStatus(const QString &prefix)
+{
+    const QHash<QString, QVector<TodoMarker>> &shown = m_streaming ? m_scanMarkers : m_markers;
+    qint64 markerCount = 0;
+    for (const QVector<TodoMarker> &markers : shown)
+        markerCount += markers.size();
+    m_statusLabel->setText(tr("%1 %2 markers in %3 files").arg(prefix).arg(markerCount).arg(shown.size()));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "TodoScanner.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+namespace DockManager
+{
+class ColumnarTableModel;
+class FileSystemIndex;
+}
+
+class IgnoreRules;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTableView;
+class QTimer;
+
+// ---------------------------------------------------------------------------
+// TODO, FIXME and HACK markers of a project. scanTodos() runs on the thread
+// pool; during the first scan a timer appends finished files to the table in
+// batches. Results are cached per file (TodoCache) and saved, so restarts and
+// rescans only read files that changed. Change events of the shared
+// FileSystemIndex trigger those rescans: files written in place are rescanned
+// on their own, added or removed files start an incremental full scan.
+// Events for ignored paths (build output, .git) are dropped, only the
+// directories a scan walked are watched, and one scan or rescan job runs at
+// a time, later changes are picked up when it is done.
+// ---------------------------------------------------------------------------
+class TodoListPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TodoListPanel(const QString &rootPath, QWidget *parent = nullptr);
+    ~TodoListPanel() override;
+
+private:
+    struct PendingResults;
+
+    void startScan();
+    void flushResults();
+    void onScanFinished(bool completed, const TodoScanStats &stats);
+    bool isIgnored(const QString &relativePath, bool isDir);
+    void scheduleRescan();
+    void rescanChanges();
+    void onFilesRescanned(const QVector<TodoFileResult> &results, const TodoScanStats &stats);
+    void rebuildTable();
+    void updateStatus(const QString &prefix);
+
+    QString m_rootPath;
+    QLineEdit *m_filterEdit = nullptr;
+    QPushButton *m_rescanButton = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    QTableView *m_view = nullptr;
+    DockManager::ColumnarTableModel *m_model = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QTimer *m_rescanTimer = nullptr;
+
+    std::shared_ptr<TodoCache> m_cache;
+    std::shared_ptr<DockManager::FileSystemIndex> m_index;
+    std::shared_ptr<PendingResults> m_pending;
+    std::shared_ptr<std::atomic_bool> m_cancelled; // set while a scan runs
+    bool m_jobRunning = false;      // a scan or rescan is on the thread pool
+    bool m_cacheLoaded = false;
+    bool m_streaming = false;       // rows are appended while the scan runs
+    bool m_fullScanPending = false; // files were added or removed
+    QSet<QString> m_modifiedFiles;  // absolute paths written since the last rescan
+    QHash<QString, std::shared_ptr<const IgnoreRules>> m_ignoreRules; // by relative directory
+
+    QHash<QString, QVector<TodoMarker>> m_markers;     // by absolute path, as shown
+    QHash<QString, QVector<TodoMarker>> m_scanMarkers; // collected by the running scan
+    QElapsedTimer m_elapsed;
+};
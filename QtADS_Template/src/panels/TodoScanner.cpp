@@ -0,0 +1,376 @@
+#include "TodoScanner.h"
+#include "ContentSearch.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TODO_SCANNER_SSE2 1
+#endif
+
+namespace
+{
+struct Keyword
+{
+    const char *text;
+    qsizetype length;
+};
+
+const Keyword Keywords[] = {{"TODO", 4}, {"FIXME", 5}, {"HACK", 4}};
+
+// A NUL byte in the first block marks a file as binary
+constexpr qsizetype BinaryProbeBytes = 8192;
+
+constexpr int MaxMarkerTextLength = 240;
+
+// Bumped whenever the file layout or the marker rules change
+constexpr quint32 CacheMagic = 0x54444f43; // "TDOC"
+constexpr quint32 CacheVersion = 1;
+
+bool isWordByte(uchar c)
+{
+    return c == '_' || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c >= 0x80;
+}
+
+// Length of the keyword starting at data[at], or 0
+qsizetype keywordAt(const char *data, qsizetype size, qsizetype at)
+{
+    if (at > 0 && isWordByte(uchar(data[at - 1])))
+        return 0;
+    for (const Keyword &keyword : Keywords)
+    {
+        const qsizetype end = at + keyword.length;
+        if (end <= size && std::memcmp(data + at, keyword.text, size_t(keyword.length)) == 0
+            && (end == size || !isWordByte(uchar(data[end]))))
+            return keyword.length;
+    }
+    return 0;
+}
+
+QString markerText(const char *begin, const char *end)
+{
+    QString text = QString::fromUtf8(begin, int(end - begin)).trimmed();
+    // Block comments closed on the same line
+    if (text.endsWith(QLatin1String("*/")))
+        text = text.chopped(2).trimmed();
+    if (text.size() > MaxMarkerTextLength)
+    {
+        text.truncate(MaxMarkerTextLength);
+        text += QChar(0x2026);
+    }
+    return text;
+}
+
+QVector<TodoMarker> scanFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    const qint64 size = file.size();
+    if (size <= 0)
+        return {};
+    uchar *mapped = file.map(0, size);
+    if (mapped)
+    {
+        const QVector<TodoMarker> markers = findTodoMarkers(reinterpret_cast<const char *>(mapped), qsizetype(size));
+        file.unmap(mapped);
+        return markers;
+    }
+    const QByteArray contents = file.readAll();
+    return findTodoMarkers(contents.constData(), contents.size());
+}
+
+// Markers of one file, from the cache if its stamp still matches
+QVector<TodoMarker> markersOf(const QString &path, TodoCache &cache, bool *cached)
+{
+    const FileStamp stamp = FileStamp::of(path);
+    QVector<TodoMarker> markers;
+    *cached = cache.lookup(path, stamp, &markers);
+    if (*cached)
+        return markers;
+    markers = scanFile(path);
+    cache.store(path, stamp, markers);
+    return markers;
+}
+} // namespace
+
+// ---------------------------------------------------------------------------
+// FileStamp
+// ---------------------------------------------------------------------------
+FileStamp FileStamp::of(const QString &path)
+{
+    FileStamp stamp;
+#if defined(Q_OS_LINUX)
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+        return stamp;
+    stamp.inode = quint64(st.st_ino);
+    stamp.modified = qint64(st.st_mtim.tv_sec) * 1000000000 + qint64(st.st_mtim.tv_nsec);
+    stamp.size = qint64(st.st_size);
+#else
+    const QFileInfo info(path);
+    if (!info.exists())
+        return stamp;
+    stamp.modified = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    stamp.size = info.size();
+#endif
+    return stamp;
+}
+
+// ---------------------------------------------------------------------------
+// Marker search
+// ---------------------------------------------------------------------------
+QVector<TodoMarker> findTodoMarkers(const char *data, qsizetype size)
+{
+    QVector<TodoMarker> markers;
+    if (std::memchr(data, 0, size_t(qMin(size, BinaryProbeBytes))))
+        return markers;
+
+    // Line numbers are counted lazily, only up to lines with a marker
+    int lineNumber = 1;
+    qsizetype counted = 0;
+    qsizetype nextLine = 0; // candidates before this are on a reported line
+
+    const auto candidate = [&](qsizetype at) {
+        if (at < nextLine || keywordAt(data, size, at) == 0)
+            return;
+        qsizetype lineStart = at;
+        while (lineStart > counted && data[lineStart - 1] != '\n')
+            --lineStart;
+        const void *newline = std::memchr(data + at, '\n', size_t(size - at));
+        const qsizetype lineEnd = newline ? static_cast<const char *>(newline) - data : size;
+        lineNumber += int(std::count(data + counted, data + lineStart, '\n'));
+        counted = lineStart;
+
+        markers.append(TodoMarker{lineNumber, markerText(data + at, data + lineEnd)});
+        nextLine = lineEnd + 1;
+    };
+
+    qsizetype i = 0;
+#if defined(TODO_SCANNER_SSE2)
+    // T..O, H..K and F...E: first byte and last byte of each keyword
+    const __m128i t = _mm_set1_epi8('T');
+    const __m128i o = _mm_set1_epi8('O');
+    const __m128i h = _mm_set1_epi8('H');
+    const __m128i k = _mm_set1_epi8('K');
+    const __m128i f = _mm_set1_epi8('F');
+    const __m128i e = _mm_set1_epi8('E');
+    for (; i + 4 + 16 <= size; i += 16)
+    {
+        const __m128i at0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i at3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 3));
+        const __m128i at4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 4));
+        const __m128i todo = _mm_and_si128(_mm_cmpeq_epi8(at0, t), _mm_cmpeq_epi8(at3, o));
+        const __m128i hack = _mm_and_si128(_mm_cmpeq_epi8(at0, h), _mm_cmpeq_epi8(at3, k));
+        const __m128i fixme = _mm_and_si128(_mm_cmpeq_epi8(at0, f), _mm_cmpeq_epi8(at4, e));
+        quint32 mask = quint32(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(todo, hack), fixme)));
+        while (mask)
+        {
+            candidate(i + qCountTrailingZeroBits(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        const char c = data[i];
+        if (c == 'T' || c == 'H' || c == 'F')
+            candidate(i);
+    }
+    return markers;
+}
+
+// ---------------------------------------------------------------------------
+// TodoCache
+// ---------------------------------------------------------------------------
+QString TodoCache::defaultPath(const QString &rootPath)
+{
+    const QByteArray key = QCryptographicHash::hash(QDir::cleanPath(rootPath).toUtf8(), QCryptographicHash::Sha1);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/todo-cache/")
+           + QString::fromLatin1(key.toHex().left(16)) + QStringLiteral(".dat");
+}
+
+bool TodoCache::load(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheVersion || count < 0)
+        return false;
+
+    QHash<QString, Entry> entries;
+    entries.reserve(count);
+    for (qint32 n = 0; n < count && in.status() == QDataStream::Ok; ++n)
+    {
+        QString path;
+        Entry entry;
+        qint32 markerCount = 0;
+        in >> path >> entry.stamp.inode >> entry.stamp.modified >> entry.stamp.size >> markerCount;
+        for (qint32 m = 0; m < markerCount && in.status() == QDataStream::Ok; ++m)
+        {
+            TodoMarker marker;
+            qint32 line = 0;
+            in >> line >> marker.text;
+            marker.line = line;
+            entry.markers.append(marker);
+        }
+        entries.insert(path, entry);
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.swap(entries);
+    return true;
+}
+
+bool TodoCache::save(const QString &filePath) const
+{
+    QDir().mkpath(QFileInfo(filePath).path());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out(&file);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out << CacheMagic << CacheVersion << qint32(m_entries.size());
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        {
+            out << it.key() << it->stamp.inode << it->stamp.modified << it->stamp.size
+                << qint32(it->markers.size());
+            for (const TodoMarker &marker : it->markers)
+                out << qint32(marker.line) << marker.text;
+        }
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+bool TodoCache::lookup(const QString &path, const FileStamp &stamp, QVector<TodoMarker> *markers) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_entries.constFind(path);
+    if (it == m_entries.constEnd() || it->stamp != stamp || stamp.size < 0)
+        return false;
+    *markers = it->markers;
+    return true;
+}
+
+void TodoCache::store(const QString &path, const FileStamp &stamp, const QVector<TodoMarker> &markers)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (stamp.size < 0)
+        m_entries.remove(path);
+    else
+        m_entries.insert(path, Entry{stamp, markers});
+}
+
+bool TodoCache::contains(const QString &path) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.contains(path);
+}
+
+void TodoCache::retain(const QSet<QString> &keep)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (keep.contains(it.key()))
+            ++it;
+        else
+            it = m_entries.erase(it);
+    }
+}
+
+int TodoCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+// ---------------------------------------------------------------------------
+// Scans
+// ---------------------------------------------------------------------------
+bool scanTodos(const QString &rootPath, TodoCache &cache, const std::atomic_bool &cancelled,
+               const std::function<void(TodoFileResult &&)> &onFile, TodoScanStats *stats,
+               QStringList *directories)
+{
+    std::mutex seenMutex;
+    QSet<QString> seen;
+    QStringList walked;
+    std::atomic<qint64> filesRead{0}, filesCached{0}, markerCount{0};
+
+    const auto scanPath = [&](const QString &path) {
+        bool cached = false;
+        TodoFileResult result;
+        result.path = path;
+        result.markers = markersOf(path, cache, &cached);
+        (cached ? filesCached : filesRead).fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            seen.insert(path);
+        }
+        if (result.markers.isEmpty())
+            return;
+        markerCount.fetch_add(result.markers.size(), std::memory_order_relaxed);
+        onFile(std::move(result));
+    };
+    const auto onDirectory = [&](const QString &path) {
+        std::lock_guard<std::mutex> lock(seenMutex);
+        walked.append(path);
+    };
+    const bool completed = walkFiles(rootPath, 0, cancelled, scanPath, nullptr,
+                                     directories ? std::function<void(const QString &)>(onDirectory) : nullptr);
+
+    // Only a full walk knows which files are gone
+    if (completed)
+        cache.retain(seen);
+    if (stats)
+    {
+        stats->filesRead = filesRead.load();
+        stats->filesCached = filesCached.load();
+        stats->markers = markerCount.load();
+    }
+    if (directories)
+        directories->swap(walked);
+    return completed;
+}
+
+void rescanTodoFiles(const QStringList &paths, TodoCache &cache,
+                     const std::function<void(TodoFileResult &&)> &onFile, TodoScanStats *stats)
+{
+    for (const QString &path : paths)
+    {
+        if (!cache.contains(path))
+            continue;
+        bool cached = false;
+        TodoFileResult result;
+        result.path = path;
+        result.markers = markersOf(path, cache, &cached);
+        if (stats)
+        {
+            ++(cached ? stats->filesCached : stats->filesRead);
+            stats->markers += result.markers.size();
+        }
+        onFile(std::move(result));
+    }
+}
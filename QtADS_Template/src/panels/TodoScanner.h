@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+// ---------------------------------------------------------------------------
+// Scan results
+// ---------------------------------------------------------------------------
+struct TodoMarker
+{
+    int line = 0;   // 1-based
+    QString text;   // from the keyword to the end of the line, trimmed
+};
+
+struct TodoFileResult
+{
+    QString path;
+    QVector<TodoMarker> markers; // empty when the file has none (any more)
+};
+
+struct TodoScanStats
+{
+    qint64 filesRead = 0;   // searched because they were new or changed
+    qint64 filesCached = 0; // answered from the cache
+    qint64 markers = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Identity of one version of a file. A cached result stays valid while the
+// inode, modification time and size are all unchanged.
+// ---------------------------------------------------------------------------
+struct FileStamp
+{
+    quint64 inode = 0;    // 0 where the platform does not report one
+    qint64 modified = 0;  // nanoseconds since the epoch
+    qint64 size = -1;     // -1 if the file does not exist
+
+    static FileStamp of(const QString &path);
+
+    bool operator==(const FileStamp &other) const
+    {
+        return inode == other.inode && modified == other.modified && size == other.size;
+    }
+    bool operator!=(const FileStamp &other) const { return !(*this == other); }
+};
+
+// ---------------------------------------------------------------------------
+// TODO, FIXME and HACK markers in a buffer. Keywords are upper case and must
+// stand alone as words ("TODO:", "FIXME(alice)", but not "TODOS" or
+// "MY_TODO"); at most one marker is reported per line. Binary data has none.
+//
+// Uses SSE2 on x86: candidates are positions where a keyword's first byte and
+// a later byte at the right distance both match, for all three keywords and
+// 16 positions at a time, so ordinary text is skipped without branching.
+// ---------------------------------------------------------------------------
+QVector<TodoMarker> findTodoMarkers(const char *data, qsizetype size);
+
+// ---------------------------------------------------------------------------
+// Per-file scan results keyed on FileStamp. Shared by the scan threads and
+// saved between sessions, so a restart reads only files that changed.
+// ---------------------------------------------------------------------------
+class TodoCache
+{
+public:
+    // Cache file for a project root in the user's cache directory
+    static QString defaultPath(const QString &rootPath);
+
+    bool load(const QString &filePath);
+    bool save(const QString &filePath) const;
+
+    // The remaining members are thread safe
+    bool lookup(const QString &path, const FileStamp &stamp, QVector<TodoMarker> *markers) const;
+    void store(const QString &path, const FileStamp &stamp, const QVector<TodoMarker> &markers);
+    bool contains(const QString &path) const;
+
+    // Drops every entry not in keep
+    void retain(const QSet<QString> &keep);
+
+    int size() const;
+
+private:
+    struct Entry
+    {
+        FileStamp stamp;
+        QVector<TodoMarker> markers;
+    };
+
+    mutable std::mutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+// ---------------------------------------------------------------------------
+// Scans every file below rootPath (see walkFiles()) and calls onFile for
+// each file that has markers, from the worker threads. Files whose stamp
+// matches the cache are not opened. Entries of files that no longer exist
+// are dropped from the cache when the walk completes. directories, if given,
+// receives every directory walked, i.e. not ignored.
+//
+// Blocks until done. Returns false if cancelled.
+// ---------------------------------------------------------------------------
+bool scanTodos(const QString &rootPath, TodoCache &cache, const std::atomic_bool &cancelled,
+               const std::function<void(TodoFileResult &&)> &onFile, TodoScanStats *stats = nullptr,
+               QStringList *directories = nullptr);
+
+// ---------------------------------------------------------------------------
+// Rescans the given files, which changed on disk, and calls onFile for every
+// one of them, with or without markers, on the calling thread. Files the
+// cache does not know (ignored or not scanned yet) are skipped.
+// ---------------------------------------------------------------------------
+void rescanTodoFiles(const QStringList &paths, TodoCache &cache,
+                     const std::function<void(TodoFileResult &&)> &onFile, TodoScanStats *stats = nullptr);
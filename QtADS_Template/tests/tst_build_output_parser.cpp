@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include "BuildOutputParser.h"
+
+#include <cstring>
+
+namespace {
+
+void feed(BuildOutputParser &parser, const char *text)
+{
+    parser.feed(text, qint64(std::strlen(text)));
+}
+
+BuildOutputLine textLine(const QString &text)
+{
+    BuildOutputLine line;
+    line.text = text;
+    return line;
+}
+
+} // namespace
+
+TEST(BuildOutputParserTest, SplitsLinesAndColours) {
+    BuildOutputParser parser;
+    feed(parser, "plain\r\n\x1b[1m\x1b[31mred\x1b[0m text\tx\n[1/3] a\r[2/3] b\r[3/3] c\nlast");
+    QVector<BuildOutputLine> lines = parser.takeLines();
+    ASSERT_EQ(lines.size(), 3);
+    EXPECT_EQ(lines[0].text, QString("plain"));
+    EXPECT_TRUE(lines[0].spans.isEmpty());
+
+    EXPECT_EQ(lines[1].text, QString("red text        x"));
+    ASSERT_EQ(lines[1].spans.size(), 1);
+    EXPECT_EQ(lines[1].spans[0].start, 0);
+    EXPECT_EQ(lines[1].spans[0].length, 3);
+    EXPECT_EQ(lines[1].spans[0].style.foreground, 1);
+    EXPECT_TRUE(lines[1].spans[0].style.flags & TerminalCell::Bold);
+
+    // Progress redrawn with carriage returns keeps its last state
+    EXPECT_EQ(lines[2].text, QString("[3/3] c"));
+
+    // The unterminated line waits for more output or finish()
+    EXPECT_TRUE(parser.takeLines().isEmpty());
+    parser.finish();
+    lines = parser.takeLines();
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(lines[0].text, QString("last"));
+    EXPECT_EQ(parser.lineCount(), 4);
+}
+
+TEST(BuildOutputParserTest, CompilerDiagnostics) {
+    BuildOutputParser parser;
+    feed(parser, "[1/2] Building CXX object CMakeFiles/app.dir/main.cpp.o\n"
+                 "../src/main.cpp: In function 'int main()':\n"
+                 "\x1b[01m\x1b[K../src/main.cpp:12:5:\x1b[m\x1b[K \x1b[01;31m\x1b[Kerror: \x1b[m\x1b[K'foo' was not declared\n"
+                 "C:/src/util.h:7: warning: unused variable 'x'\n"
+                 "main.cpp:3:1: note: declared here\n"
+                 "collect2: error: ld returned 1 exit status\n"
+                 "make[2]: *** [app] Error 1\n"
+                 "/usr/bin/ld: main.o: in function `main':\n");
+
+    const QVector<BuildDiagnostic> diagnostics = parser.takeDiagnostics();
+    ASSERT_EQ(diagnostics.size(), 4);
+    EXPECT_EQ(diagnostics[0].severity, BuildDiagnostic::Error);
+    EXPECT_EQ(diagnostics[0].file, QString("../src/main.cpp"));
+    EXPECT_EQ(diagnostics[0].line, 12);
+    EXPECT_EQ(diagnostics[0].column, 5);
+    EXPECT_EQ(diagnostics[0].message, QString("'foo' was not declared"));
+    EXPECT_EQ(diagnostics[0].outputLine, 2);
+
+    EXPECT_EQ(diagnostics[1].severity, BuildDiagnostic::Warning);
+    EXPECT_EQ(diagnostics[1].file, QString("C:/src/util.h"));
+    EXPECT_EQ(diagnostics[1].line, 7);
+    EXPECT_EQ(diagnostics[1].column, 0);
+
+    EXPECT_EQ(diagnostics[2].severity, BuildDiagnostic::Note);
+    EXPECT_EQ(diagnostics[2].line, 3);
+
+    EXPECT_TRUE(diagnostics[3].file.isEmpty());
+    EXPECT_EQ(diagnostics[3].message, QString("collect2: ld returned 1 exit status"));
+}
+
+TEST(BuildOutputParserTest, CMakeDiagnostics) {
+    BuildOutputParser parser;
+    feed(parser, "-- Configuring done\n"
+                 "CMake Error at src/CMakeLists.txt:42 (add_executable):\n"
+                 "  Cannot find source file:\n"
+                 "\n"
+                 "    missing.cpp\n"
+                 "\n"
+                 "CMake Warning (dev) in CMakeLists.txt:\n"
+                 "  Policy CMP0071 is not set.\n"
+                 "This warning is for project developers.\n"
+                 "CMake Error: The source directory does not exist.\n"
+                 "CMake Deprecation Warning at CMakeLists.txt:1 (cmake_minimum_required):\n"
+                 "  Compatibility with CMake < 3.5 will be removed.\n");
+    QVector<BuildDiagnostic> diagnostics = parser.takeDiagnostics();
+    ASSERT_EQ(diagnostics.size(), 3);
+    EXPECT_EQ(diagnostics[0].severity, BuildDiagnostic::Error);
+    EXPECT_EQ(diagnostics[0].file, QString("src/CMakeLists.txt"));
+    EXPECT_EQ(diagnostics[0].line, 42);
+    EXPECT_EQ(diagnostics[0].message, QString("Cannot find source file: missing.cpp"));
+    EXPECT_EQ(diagnostics[0].outputLine, 1);
+
+    EXPECT_EQ(diagnostics[1].severity, BuildDiagnostic::Warning);
+    EXPECT_EQ(diagnostics[1].file, QString("CMakeLists.txt"));
+    EXPECT_EQ(diagnostics[1].line, 0);
+    EXPECT_EQ(diagnostics[1].message, QString("Policy CMP0071 is not set."));
+
+    EXPECT_TRUE(diagnostics[2].file.isEmpty());
+    EXPECT_EQ(diagnostics[2].message, QString("The source directory does not exist."));
+
+    // The last message has no line after it
+    parser.finish();
+    diagnostics = parser.takeDiagnostics();
+    ASSERT_EQ(diagnostics.size(), 1);
+    EXPECT_EQ(diagnostics[0].severity, BuildDiagnostic::Warning);
+    EXPECT_EQ(diagnostics[0].line, 1);
+    EXPECT_EQ(diagnostics[0].message, QString("Compatibility with CMake < 3.5 will be removed."));
+}
+
+TEST(BuildOutputParserTest, SplitFeedsMatchWholeFeed) {
+    const char *stream = "\x1b[32mok\x1b[0m\r\n"
+                         "a.cpp:1:2: warning: caf\xc3\xa9\n"
+                         "CMake Error at x.txt:9 (foo):\n  bad\n"
+                         "\x1b]8;;https://gcc.gnu.org\x07-Wall\x1b]8;;\x07\n";
+    BuildOutputParser whole;
+    BuildOutputParser split;
+    feed(whole, stream);
+    for (size_t i = 0; i < std::strlen(stream); ++i)
+        split.feed(stream + i, 1);
+    whole.finish();
+    split.finish();
+
+    const QVector<BuildOutputLine> wholeLines = whole.takeLines();
+    const QVector<BuildOutputLine> splitLines = split.takeLines();
+    ASSERT_EQ(wholeLines.size(), 5);
+    ASSERT_EQ(splitLines.size(), wholeLines.size());
+    for (int i = 0; i < wholeLines.size(); ++i) {
+        EXPECT_EQ(splitLines[i].text, wholeLines[i].text);
+        EXPECT_EQ(splitLines[i].spans.size(), wholeLines[i].spans.size());
+    }
+    EXPECT_EQ(wholeLines[4].text, QString("-Wall"));
+    EXPECT_EQ(whole.takeDiagnostics().size(), 2);
+    const QVector<BuildDiagnostic> diagnostics = split.takeDiagnostics();
+    ASSERT_EQ(diagnostics.size(), 2);
+    EXPECT_EQ(diagnostics[0].message, QString::fromUtf8("caf\xc3\xa9"));
+    EXPECT_EQ(diagnostics[1].message, QString("bad"));
+}
+
+TEST(BuildLogTest, DropsOldestLines) {
+    BuildLog log(3, 1 << 20);
+    for (int i = 0; i < 5; ++i)
+        log.append(textLine(QString::number(i)));
+    ASSERT_EQ(log.lineCount(), 3);
+    EXPECT_EQ(log.droppedLines(), 2u);
+    EXPECT_EQ(log.line(0).text, QString("2"));
+    EXPECT_EQ(log.line(2).text, QString("4"));
+
+    log.skip(10);
+    log.append(textLine(QString("next")));
+    EXPECT_EQ(log.droppedLines(), 13u);
+    EXPECT_EQ(log.line(2).text, QString("next"));
+
+    log.clear();
+    EXPECT_EQ(log.lineCount(), 0);
+    EXPECT_EQ(log.droppedLines(), 0u);
+}
+
+TEST(BuildLogTest, ByteLimit) {
+    const QString text(100, QLatin1Char('x'));
+    BuildLog log(1000, 2000);
+    for (int i = 0; i < 100; ++i)
+        log.append(textLine(text + QString::number(i)));
+    // Each line takes over 200 bytes, so fewer than ten fit
+    EXPECT_GT(log.lineCount(), 0);
+    EXPECT_LT(log.lineCount(), 10);
+    EXPECT_EQ(qint64(log.droppedLines()) + log.lineCount(), 100);
+    EXPECT_EQ(log.line(log.lineCount() - 1).text, text + QString::number(99));
+    EXPECT_EQ(log.longestLine(), 102);
+
+    // Small lines after big ones grow the ring once it has wrapped
+    BuildLog growing(100, 4000);
+    const QString big(400, QLatin1Char('y'));
+    for (int i = 0; i < 6; ++i)
+        growing.append(textLine(big));
+    for (int i = 0; i < 20; ++i)
+        growing.append(textLine(QString::number(i)));
+    ASSERT_GE(growing.lineCount(), 20);
+    for (int i = 0; i < 20; ++i)
+        EXPECT_EQ(growing.line(growing.lineCount() - 20 + i).text, QString::number(i));
+}
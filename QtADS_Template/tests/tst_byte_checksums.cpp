@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <QByteArray>
+
+#include "ByteChecksums.h"
+
+namespace {
+
+const QByteArray kFox("The quick brown fox jumps over the lazy dog");
+
+ByteChecksums checksumsInChunks(const QByteArray &data, qsizetype chunkSize)
+{
+    ChecksumAccumulator accumulator;
+    for (qsizetype offset = 0; offset < data.size(); offset += chunkSize)
+        accumulator.addData(data.mid(offset, chunkSize));
+    return accumulator.result();
+}
+
+} // namespace
+
+TEST(ByteChecksumsTest, KnownVectors) {
+    ChecksumAccumulator accumulator;
+    accumulator.addData(kFox);
+    const ByteChecksums sums = accumulator.result();
+
+    EXPECT_EQ(sums.crc32, 0x414FA339u);
+    EXPECT_EQ(sums.crc32c, 0x22620404u);
+    EXPECT_EQ(sums.adler32, 0x5BDC0FDAu);
+    EXPECT_EQ(sums.sha1.toHex(), QByteArray("2fd4e1c67a2d28fced849ee1bb76e7391b93eb12"));
+    EXPECT_EQ(sums.sha256.toHex(),
+              QByteArray("d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592"));
+}
+
+TEST(ByteChecksumsTest, EmptyInput) {
+    ChecksumAccumulator accumulator;
+    const ByteChecksums sums = accumulator.result();
+
+    EXPECT_EQ(sums.crc32, 0u);
+    EXPECT_EQ(sums.adler32, 1u);
+    EXPECT_EQ(sums.sha256.toHex(),
+              QByteArray("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+}
+
+TEST(ByteChecksumsTest, ChunkingDoesNotChangeResult) {
+    QByteArray data(1 << 20, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); ++i)
+        data[i] = char(i * 131 + 7);
+
+    const ByteChecksums whole = checksumsInChunks(data, data.size());
+    for (qsizetype chunk : {1, 63, 64, 65, 4097}) {
+        const ByteChecksums split = checksumsInChunks(data, chunk);
+        EXPECT_EQ(split.crc32, whole.crc32) << "chunk " << chunk;
+        EXPECT_EQ(split.crc32c, whole.crc32c) << "chunk " << chunk;
+        EXPECT_EQ(split.adler32, whole.adler32) << "chunk " << chunk;
+        EXPECT_EQ(split.sha1, whole.sha1) << "chunk " << chunk;
+        EXPECT_EQ(split.sha256, whole.sha256) << "chunk " << chunk;
+    }
+}
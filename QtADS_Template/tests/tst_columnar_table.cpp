@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <QSignalSpy>
+
+#include "ColumnarTableModel.h"
+
+#include <algorithm>
+#include <numeric>
+
+using DockManager::ColumnarTable;
+using DockManager::ColumnarTableModel;
+using DockManager::ColumnType;
+
+namespace {
+
+const QVector<ColumnType> kTypes{ColumnType::Int64, ColumnType::Double, ColumnType::String};
+
+ColumnarTable makeRows(int count, int firstId = 0)
+{
+    ColumnarTable rows(kTypes);
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int r = rows.appendRow();
+        rows.setInt64(r, 0, firstId + i);
+        rows.setDouble(r, 1, (firstId + i) * 0.5);
+        rows.setString(r, 2, QStringLiteral("row %1").arg(firstId + i));
+    }
+    return rows;
+}
+
+} // namespace
+
+TEST(ColumnarTableTest, StoresTypedCells) {
+    const ColumnarTable rows = makeRows(3);
+
+    ASSERT_EQ(rows.rowCount(), 3);
+    EXPECT_EQ(rows.int64At(2, 0), 2);
+    EXPECT_DOUBLE_EQ(rows.doubleAt(2, 1), 1.0);
+    EXPECT_EQ(rows.stringAt(2, 2), QStringLiteral("row 2"));
+    EXPECT_EQ(rows.valueAt(1, 0).toLongLong(), 1);
+}
+
+TEST(ColumnarTableTest, OverwritingStringsKeepsOtherRows) {
+    ColumnarTable rows = makeRows(10000);
+    for (int round = 0; round < 8; ++round) {
+        for (int r = 0; r < rows.rowCount(); ++r)
+            rows.setString(r, 2, QStringLiteral("value %1/%2").arg(round).arg(r));
+    }
+
+    EXPECT_EQ(rows.stringAt(0, 2), QStringLiteral("value 7/0"));
+    EXPECT_EQ(rows.stringAt(9999, 2), QStringLiteral("value 7/9999"));
+    // Replaced strings are compacted away instead of accumulating
+    EXPECT_LT(rows.memoryUsage(), qsizetype(10000) * 128);
+}
+
+TEST(ColumnarTableTest, RepeatedStringsShareStorage) {
+    ColumnarTable rows({ColumnType::String});
+    rows.resize(100000);
+    for (int r = 0; r < rows.rowCount(); ++r)
+        rows.setString(r, 0, u"Running");
+
+    EXPECT_EQ(rows.stringAt(54321, 0), QStringLiteral("Running"));
+    // 8 byte span per row plus a single copy of the text
+    EXPECT_LT(rows.memoryUsage(), qsizetype(100000) * 8 + 1024);
+}
+
+TEST(ColumnarTableModelTest, BulkOperationsEmitSingleNotifications) {
+    ColumnarTableModel model({"Id", "Half", "Name"}, kTypes);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy insertSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy changeSpy(&model, &QAbstractItemModel::dataChanged);
+
+    model.setTable(makeRows(1000));
+    model.appendRows(makeRows(500, 1000));
+    model.updateRows(1400, makeRows(200, 5000));
+
+    EXPECT_EQ(resetSpy.count(), 1);
+    EXPECT_EQ(insertSpy.count(), 2);
+    EXPECT_EQ(changeSpy.count(), 1);
+    EXPECT_EQ(model.rowCount(), 1600);
+    EXPECT_EQ(model.data(model.index(1400, 0)).toString(), QStringLiteral("5000"));
+    EXPECT_EQ(model.data(model.index(1599, 2)).toString(), QStringLiteral("row 5199"));
+    EXPECT_EQ(model.data(model.index(10, 1), Qt::EditRole).toDouble(), 5.0);
+}
+
+TEST(ColumnarTableModelTest, RejectsMismatchedSchema) {
+    ColumnarTableModel model({"Id", "Half", "Name"}, kTypes);
+    model.setTable(makeRows(5));
+    model.appendRows(ColumnarTable({ColumnType::String}));
+
+    EXPECT_EQ(model.rowCount(), 5);
+}
+
+TEST(ColumnarQueryTest, SortMatchesStableSort) {
+    // Large enough to take the multi-threaded paths
+    const int count = 150000;
+    ColumnarTable rows(kTypes);
+    rows.resize(count);
+    const char *const words[] = {"delta", "Alpha", "charlie", "bravo", "alpha"};
+    quint32 seed = 12345;
+    for (int r = 0; r < count; ++r) {
+        seed = seed * 1664525u + 1013904223u;
+        rows.setInt64(r, 0, qint64(seed % 20000) - 10000);
+        rows.setDouble(r, 1, double(seed % 977) / 3.0 - 100.0);
+        rows.setString(r, 2, QString::fromLatin1(words[seed % 5]));
+    }
+
+    const std::atomic_bool cancelled(false);
+    for (int column = 0; column < 3; ++column) {
+        for (Qt::SortOrder order : {Qt::AscendingOrder, Qt::DescendingOrder}) {
+            QVector<int> result;
+            ASSERT_TRUE(DockManager::computeRowOrder(rows, {}, {column, order}, cancelled, &result));
+
+            QVector<int> expected(count);
+            std::iota(expected.begin(), expected.end(), 0);
+            std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) {
+                const QVariant va = rows.valueAt(a, column);
+                const QVariant vb = rows.valueAt(b, column);
+                const int cmp = column == 2 ? va.toString().compare(vb.toString(), Qt::CaseInsensitive)
+                                            : (va.toDouble() < vb.toDouble() ? -1 : va.toDouble() > vb.toDouble());
+                return order == Qt::AscendingOrder ? cmp < 0 : cmp > 0;
+            });
+            EXPECT_EQ(result, expected) << "column " << column << " order " << order;
+        }
+    }
+}
+
+TEST(ColumnarQueryTest, FilterExpressions) {
+    const ColumnarTable rows = makeRows(1000);
+    const std::atomic_bool cancelled(false);
+    auto visibleRows = [&](int column, const QString &expression) {
+        QVector<int> result;
+        DockManager::computeRowOrder(rows, DockManager::ColumnarFilter::parse(column, expression), {},
+                                     cancelled, &result);
+        return result.size();
+    };
+
+    EXPECT_EQ(visibleRows(0, ">= 900"), 100);
+    EXPECT_EQ(visibleRows(0, "42"), 1);
+    EXPECT_EQ(visibleRows(1, "< 10"), 20);
+    EXPECT_EQ(visibleRows(2, "ROW 99"), 11);   // "row 99" and "row 990".."row 999"
+    EXPECT_EQ(visibleRows(-1, "= row 5"), 1);
+    EXPECT_EQ(visibleRows(-1, ""), 1000);
+}
+
+TEST(ColumnarQueryTest, FractionalOperandsOnIntegerColumns) {
+    const ColumnarTable rows = makeRows(1000);
+    const std::atomic_bool cancelled(false);
+    auto visibleRows = [&](const QString &expression) {
+        QVector<int> result;
+        DockManager::computeRowOrder(rows, DockManager::ColumnarFilter::parse(0, expression), {},
+                                     cancelled, &result);
+        return result.size();
+    };
+
+    EXPECT_EQ(visibleRows("< 1.5"), 2);      // 0 and 1
+    EXPECT_EQ(visibleRows("<= 1.5"), 2);
+    EXPECT_EQ(visibleRows("> 997.5"), 2);    // 998 and 999
+    EXPECT_EQ(visibleRows(">= 997.5"), 2);
+    EXPECT_EQ(visibleRows("< -0.5"), 0);
+    EXPECT_EQ(visibleRows("> -0.5"), 1000);
+    EXPECT_EQ(visibleRows("= 1.5"), 0);
+    EXPECT_EQ(visibleRows("!= 1.5"), 1000);
+    EXPECT_EQ(visibleRows("< 1e30"), 1000);
+    EXPECT_EQ(visibleRows("> 1e30"), 0);
+}
+
+TEST(ColumnarQueryTest, CancelledQueryReturnsFalse) {
+    const ColumnarTable rows = makeRows(100);
+    const std::atomic_bool cancelled(true);
+    QVector<int> result;
+    EXPECT_FALSE(DockManager::computeRowOrder(rows, {}, {0, Qt::AscendingOrder}, cancelled, &result));
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QTemporaryDir>
+
+#include "ContentSearch.h"
+#include "TestFiles.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+QVector<SearchFileResult> runSearch(const SearchOptions &options)
+{
+    std::mutex mutex;
+    QVector<SearchFileResult> results;
+    std::atomic_bool cancelled{false};
+    searchTree(options, cancelled, [&](SearchFileResult &&result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.append(std::move(result));
+    });
+    std::sort(results.begin(), results.end(),
+              [](const SearchFileResult &a, const SearchFileResult &b) { return a.path < b.path; });
+    return results;
+}
+
+} // namespace
+
+TEST(ContentSearchTest, FindLiteral) {
+    const QByteArray text("The quick brown fox jumps over the lazy dog, THE END");
+
+    EXPECT_EQ(findLiteral(text.constData(), text.size(), "the", true), 31);
+    EXPECT_EQ(findLiteral(text.constData(), text.size(), "the", false), 0);
+    EXPECT_EQ(findLiteral(text.constData(), text.size(), "the end", false), 45);
+    EXPECT_EQ(findLiteral(text.constData(), text.size(), "cat", false), -1);
+    EXPECT_EQ(findLiteral(text.constData(), 3, "quick", true), -1);
+}
+
+TEST(ContentSearchTest, RequiredLiteral) {
+    EXPECT_EQ(requiredLiteral("Hello World", false, true), QByteArray("Hello World"));
+    EXPECT_EQ(requiredLiteral("Hello", false, false), QByteArray("hello"));
+    EXPECT_EQ(requiredLiteral("foo\\.bar\\w+", true, true), QByteArray("foo.bar"));
+    EXPECT_EQ(requiredLiteral("ab*cdef", true, true), QByteArray("cdef"));
+    EXPECT_EQ(requiredLiteral("x{2}longest", true, true), QByteArray("longest"));
+    EXPECT_TRUE(requiredLiteral("foo|bar", true, true).isEmpty());
+    EXPECT_TRUE(requiredLiteral("\\d+", true, true).isEmpty());
+}
+
+TEST(ContentSearchTest, IgnoreRules) {
+    const auto root = IgnoreRules::fromText(nullptr, "/repo",
+                                            "# build output\n*.o\nbuild/\n/docs/*.pdf\n!keep.o\n");
+    ASSERT_NE(root, nullptr);
+    EXPECT_TRUE(root->isIgnored("/repo/a.o", false));
+    EXPECT_TRUE(root->isIgnored("/repo/src/deep/b.o", false));
+    EXPECT_FALSE(root->isIgnored("/repo/keep.o", false));
+    EXPECT_TRUE(root->isIgnored("/repo/build", true));
+    EXPECT_FALSE(root->isIgnored("/repo/build", false));
+    EXPECT_TRUE(root->isIgnored("/repo/docs/manual.pdf", false));
+    EXPECT_FALSE(root->isIgnored("/repo/src/docs/manual.pdf", false));
+
+    // Nested rules apply below their directory and can re-include
+    const auto nested = IgnoreRules::fromText(root, "/repo/src", "!*.o\ngenerated/**\n");
+    EXPECT_FALSE(nested->isIgnored("/repo/src/c.o", false));
+    EXPECT_TRUE(nested->isIgnored("/repo/src/generated/x/y.cpp", false));
+    EXPECT_TRUE(root->isIgnored("/repo/src/c.o", false));
+
+    EXPECT_EQ(IgnoreRules::fromText(root, "/repo/lib", "# nothing\n\n"), root);
+}
+
+TEST(ContentSearchTest, SearchTreeHonorsIgnoreFiles) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    writeFile(dir.filePath(".gitignore"), "ignored/\n*.log\n");
+    writeFile(dir.filePath("main.cpp"), "int main()\n{\n    // TODO: needle here\n    return 0; // Needle\n}\n");
+    writeFile(dir.filePath("src/util.cpp"), "void needle();\n");
+    writeFile(dir.filePath("src/none.cpp"), "void haystack();\n");
+    writeFile(dir.filePath("ignored/skip.cpp"), "needle\n");
+    writeFile(dir.filePath("run.log"), "needle\n");
+    writeFile(dir.filePath(".git/config"), "needle\n");
+    writeFile(dir.filePath("binary.bin"), QByteArray("needle\0\1\2", 9));
+
+    SearchOptions options;
+    options.rootPath = dir.path();
+    options.pattern = "needle";
+    options.threadCount = 3;
+
+    QVector<SearchFileResult> results = runSearch(options);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_TRUE(results[0].path.endsWith("main.cpp"));
+    ASSERT_EQ(results[0].hits.size(), 2);
+    EXPECT_EQ(results[0].hits[0].line, 3);
+    EXPECT_EQ(results[0].hits[0].column, 14);
+    EXPECT_EQ(results[0].hits[0].text, QString("// TODO: needle here"));
+    EXPECT_EQ(results[0].hits[1].line, 4);
+    EXPECT_TRUE(results[1].path.endsWith("src/util.cpp"));
+
+    options.caseSensitive = true;
+    options.pattern = "Needle";
+    results = runSearch(options);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].hits.size(), 1);
+
+    options.regex = true;
+    options.caseSensitive = false;
+    options.pattern = "void \\w+\\(\\)";
+    results = runSearch(options);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0].hits[0].column, 1);
+}
+
+TEST(ContentSearchTest, InvalidPatternFails) {
+    SearchOptions options;
+    options.rootPath = QDir::tempPath();
+    options.pattern = "(unclosed";
+    options.regex = true;
+    std::atomic_bool cancelled{false};
+    EXPECT_FALSE(searchTree(options, cancelled, [](SearchFileResult &&) {}));
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "FileSystemIndex.h"
+
+using DockManager::FileSystemEntry;
+using DockManager::FileSystemIndex;
+
+namespace {
+
+bool touch(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly);
+}
+
+// root/a/b/c with a few files
+bool makeTree(const QTemporaryDir &dir)
+{
+    const QString root = dir.path();
+    return QDir(root).mkpath(QStringLiteral("a/b/c"))
+        && touch(root + QStringLiteral("/c.txt"))
+        && touch(root + QStringLiteral("/B.txt"))
+        && touch(root + QStringLiteral("/a/b/file.cpp"));
+}
+
+QStringList names(const QVector<FileSystemEntry> &entries)
+{
+    QStringList result;
+    for (const FileSystemEntry &entry : entries)
+        result.append(entry.name);
+    return result;
+}
+
+// Waits until a directoriesChanged batch names path
+bool waitForChange(QSignalSpy &spy, const QString &path)
+{
+    for (int i = 0; i < 50; ++i) {
+        for (const QList<QVariant> &arguments : spy) {
+            if (arguments.at(0).toStringList().contains(path))
+                return true;
+        }
+        spy.wait(100);
+    }
+    return false;
+}
+
+} // namespace
+
+TEST(FileSystemIndexTest, SharedPerCleanedRoot) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    auto index = FileSystemIndex::shared(dir.path());
+    EXPECT_EQ(FileSystemIndex::shared(dir.path() + QStringLiteral("/a/..")), index);
+    EXPECT_EQ(index->rootPath(), QDir::cleanPath(dir.path()));
+}
+
+TEST(FileSystemIndexTest, ListsOnlyTheDirectoriesAskedFor) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ASSERT_TRUE(makeTree(dir));
+    auto index = FileSystemIndex::shared(dir.path());
+
+    const QVector<FileSystemEntry> entries = index->entries(QString());
+    EXPECT_EQ(names(entries), (QStringList{QStringLiteral("a"), QStringLiteral("B.txt"), QStringLiteral("c.txt")}));
+    ASSERT_EQ(entries.size(), 3);
+    EXPECT_TRUE(entries.at(0).isDir);
+    EXPECT_FALSE(entries.at(1).isDir);
+
+    // Asking for entries never starts a crawl of the tree
+    QTest::qWait(200);
+    EXPECT_FALSE(index->isCrawling());
+    EXPECT_EQ(index->directoryCount(), 1);
+
+    EXPECT_EQ(names(index->entries(QStringLiteral("a/b"))),
+              (QStringList{QStringLiteral("c"), QStringLiteral("file.cpp")}));
+    EXPECT_EQ(index->directoryCount(), 2);
+}
+
+TEST(FileSystemIndexTest, EnsureCrawledListsTheWholeTree) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ASSERT_TRUE(makeTree(dir));
+    auto index = FileSystemIndex::shared(dir.path());
+
+    QSignalSpy finished(index.get(), &FileSystemIndex::crawlFinished);
+    index->ensureCrawled();
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_FALSE(index->isCrawling());
+    EXPECT_EQ(index->directoryCount(), 4);
+
+    // Only once
+    index->ensureCrawled();
+    EXPECT_FALSE(finished.wait(200));
+}
+
+TEST(FileSystemIndexTest, ReportsChangedDirectories) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ASSERT_TRUE(makeTree(dir));
+    auto index = FileSystemIndex::shared(dir.path());
+    index->entries(QString());
+    index->entries(QStringLiteral("a"));
+    index->entries(QStringLiteral("a/b"));
+
+    QSignalSpy changed(index.get(), &FileSystemIndex::directoriesChanged);
+    ASSERT_TRUE(touch(dir.filePath(QStringLiteral("a/new.txt"))));
+    ASSERT_TRUE(waitForChange(changed, QStringLiteral("a")));
+    EXPECT_EQ(names(index->entries(QStringLiteral("a"))),
+              (QStringList{QStringLiteral("b"), QStringLiteral("new.txt")}));
+
+    // A removed directory takes its listing along
+    changed.clear();
+    ASSERT_TRUE(QDir(dir.filePath(QStringLiteral("a/b"))).removeRecursively());
+    ASSERT_TRUE(waitForChange(changed, QStringLiteral("a")));
+    EXPECT_EQ(names(index->entries(QStringLiteral("a"))), QStringList{QStringLiteral("new.txt")});
+    EXPECT_EQ(index->directoryCount(), 2);
+}
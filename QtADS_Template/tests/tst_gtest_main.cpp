@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <QCoreApplication>
 #include <QString>
 
 TEST(SimpleQtTest, StringCheck) {
@@ -8,6 +9,9 @@ TEST(SimpleQtTest, StringCheck) {
 }
 
 int main(int argc, char **argv) {
+    // Models that load on the thread pool post their results through the
+    // event loop
+    QCoreApplication app(argc, argv);
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
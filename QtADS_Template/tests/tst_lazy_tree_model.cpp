@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPersistentModelIndex>
+#include <QSignalSpy>
+
+#include "LazyTreeModel.h"
+
+#include <memory>
+
+using DockManager::FunctionTreeProvider;
+using DockManager::LazyTreeItem;
+using DockManager::LazyTreeModel;
+
+namespace {
+
+// Children per key path; the provider reads it on worker threads, tests
+// change it between reloads
+struct TreeSource
+{
+    QMutex mutex;
+    QHash<QStringList, QStringList> children;
+
+    void set(const QStringList &path, const QStringList &names)
+    {
+        QMutexLocker lock(&mutex);
+        children.insert(path, names);
+    }
+};
+
+std::shared_ptr<FunctionTreeProvider> providerFor(std::shared_ptr<TreeSource> source)
+{
+    return std::make_shared<FunctionTreeProvider>([source](const QStringList &path) {
+        QMutexLocker lock(&source->mutex);
+        QVector<LazyTreeItem> items;
+        for (const QString &name : source->children.value(path)) {
+            LazyTreeItem item;
+            item.columns = QStringList{name};
+            item.hasChildren = source->children.contains(path + QStringList{name});
+            items.append(item);
+        }
+        return items;
+    });
+}
+
+QStringList numbered(const QString &prefix, int count)
+{
+    QStringList names;
+    names.reserve(count);
+    for (int i = 0; i < count; ++i)
+        names.append(QStringLiteral("%1%2").arg(prefix).arg(i, 5, 10, QLatin1Char('0')));
+    return names;
+}
+
+QStringList childNames(const LazyTreeModel &model, const QModelIndex &parent = QModelIndex())
+{
+    QStringList names;
+    for (int r = 0; r < model.rowCount(parent); ++r)
+        names.append(model.index(r, 0, parent).data().toString());
+    return names;
+}
+
+// Waits for the next fetch or reload to be applied
+bool waitForChildren(LazyTreeModel &model)
+{
+    QSignalSpy spy(&model, &LazyTreeModel::childrenLoaded);
+    return spy.wait(5000);
+}
+
+} // namespace
+
+TEST(LazyTreeModelTest, ChurnFreesRemovedNodesAndKeepsPersistentIndexes) {
+    auto source = std::make_shared<TreeSource>();
+    source->set({}, QStringList{QStringLiteral("keep")} + numbered(QStringLiteral("a"), 10000));
+    LazyTreeModel model(providerFor(source), {QStringLiteral("Name")});
+    ASSERT_TRUE(waitForChildren(model));
+
+    const QPersistentModelIndex keep(model.index(0, 0));
+    // Each round removes 10000 rows, enough to compact the arena
+    for (const QString &prefix : {QStringLiteral("b"), QStringLiteral("c"), QStringLiteral("d")}) {
+        const QStringList names = QStringList{QStringLiteral("keep")} + numbered(prefix, 10000);
+        source->set({}, names);
+        model.reloadChildren({});
+        ASSERT_TRUE(waitForChildren(model)) << prefix.toStdString();
+
+        EXPECT_EQ(childNames(model), names) << prefix.toStdString();
+        ASSERT_TRUE(keep.isValid());
+        EXPECT_EQ(keep.row(), 0);
+        EXPECT_EQ(keep.data().toString(), QStringLiteral("keep"));
+        EXPECT_EQ(model.parent(model.index(5000, 0)), QModelIndex());
+    }
+}
+
+TEST(LazyTreeModelTest, ReloadAppliesChangesAsContiguousRuns) {
+    auto source = std::make_shared<TreeSource>();
+    source->set({}, {QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c"), QStringLiteral("d"),
+                     QStringLiteral("e")});
+    LazyTreeModel model(providerFor(source), {QStringLiteral("Name")});
+    ASSERT_TRUE(waitForChildren(model));
+
+    const QPersistentModelIndex a(model.index(0, 0));
+    const QPersistentModelIndex b(model.index(1, 0));
+    const QPersistentModelIndex e(model.index(4, 0));
+    QSignalSpy removed(&model, &LazyTreeModel::rowsRemoved);
+    QSignalSpy inserted(&model, &LazyTreeModel::rowsInserted);
+
+    const QStringList names{QStringLiteral("a"), QStringLiteral("x"), QStringLiteral("y"), QStringLiteral("c"),
+                            QStringLiteral("e"), QStringLiteral("z")};
+    source->set({}, names);
+    model.reloadChildren({});
+    ASSERT_TRUE(waitForChildren(model));
+
+    EXPECT_EQ(childNames(model), names);
+    // b and d go out one run each, x y and z come in as two runs
+    EXPECT_EQ(removed.count(), 2);
+    ASSERT_EQ(inserted.count(), 2);
+    EXPECT_EQ(inserted.at(0).at(1).toInt(), 1);
+    EXPECT_EQ(inserted.at(0).at(2).toInt(), 2);
+    EXPECT_EQ(a.row(), 0);
+    EXPECT_FALSE(b.isValid());
+    EXPECT_EQ(e.row(), 4);
+    EXPECT_EQ(e.data().toString(), QStringLiteral("e"));
+}
+
+TEST(LazyTreeModelTest, ReloadOfNestedNodeLeavesTheRestAlone) {
+    auto source = std::make_shared<TreeSource>();
+    source->set({}, {QStringLiteral("dir"), QStringLiteral("other")});
+    source->set({QStringLiteral("dir")}, {QStringLiteral("1"), QStringLiteral("2")});
+    source->set({QStringLiteral("other")}, {QStringLiteral("3")});
+    LazyTreeModel model(providerFor(source), {QStringLiteral("Name")});
+    ASSERT_TRUE(waitForChildren(model));
+
+    const QModelIndex dir = model.index(0, 0);
+    ASSERT_TRUE(model.canFetchMore(dir));
+    model.fetchMore(dir);
+    ASSERT_TRUE(waitForChildren(model));
+    const QPersistentModelIndex one(model.index(0, 0, dir));
+
+    source->set({QStringLiteral("dir")}, {QStringLiteral("1"), QStringLiteral("4")});
+    model.reloadChildren({QStringLiteral("dir")});
+    ASSERT_TRUE(waitForChildren(model));
+    EXPECT_EQ(childNames(model, dir), (QStringList{QStringLiteral("1"), QStringLiteral("4")}));
+    EXPECT_EQ(childNames(model), (QStringList{QStringLiteral("dir"), QStringLiteral("other")}));
+    ASSERT_TRUE(one.isValid());
+    EXPECT_EQ(one.parent(), QModelIndex(dir));
+
+    // Never expanded: nothing to reload, it loads fresh when expanded
+    QSignalSpy loaded(&model, &LazyTreeModel::childrenLoaded);
+    model.reloadChildren({QStringLiteral("other")});
+    EXPECT_FALSE(loaded.wait(200));
+    EXPECT_EQ(model.rowCount(model.index(1, 0)), 0);
+}
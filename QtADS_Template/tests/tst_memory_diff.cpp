@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <QByteArray>
+
+#include "ProcessMemoryReader.h"
+
+namespace {
+
+QByteArray pattern(qsizetype length)
+{
+    QByteArray data(length, Qt::Uninitialized);
+    for (qsizetype i = 0; i < length; ++i)
+        data[i] = char(i * 37 + 11);
+    return data;
+}
+
+// Runs diffBytes and returns the changed-bits mask, one byte per 8 inputs
+QByteArray changedBits(const QByteArray &previous, const QByteArray &current, int *changed)
+{
+    QByteArray bits((previous.size() + 7) / 8, char(0xAA));
+    *changed = diffBytes(reinterpret_cast<const uchar *>(previous.constData()),
+                         reinterpret_cast<const uchar *>(current.constData()), previous.size(),
+                         reinterpret_cast<uchar *>(bits.data()));
+    return bits;
+}
+
+bool isChanged(const QByteArray &bits, qsizetype i)
+{
+    return (uchar(bits[i / 8]) >> (i % 8)) & 1;
+}
+
+} // namespace
+
+TEST(MemoryDiffTest, EqualBuffers) {
+    const QByteArray data = pattern(4096);
+    int changed = -1;
+    const QByteArray bits = changedBits(data, data, &changed);
+
+    EXPECT_EQ(changed, 0);
+    EXPECT_EQ(bits, QByteArray(bits.size(), 0));
+}
+
+TEST(MemoryDiffTest, ChangesAtEitherEnd) {
+    const QByteArray previous = pattern(4096);
+    QByteArray current = previous;
+    current[0] = char(~current[0]);
+    current[4095] = char(~current[4095]);
+
+    int changed = 0;
+    const QByteArray bits = changedBits(previous, current, &changed);
+
+    EXPECT_EQ(changed, 2);
+    EXPECT_TRUE(isChanged(bits, 0));
+    EXPECT_TRUE(isChanged(bits, 4095));
+    for (qsizetype i = 1; i < 4095; ++i)
+        ASSERT_FALSE(isChanged(bits, i)) << "byte " << i;
+}
+
+// Lengths around the 16 byte vector width exercise the scalar tail
+TEST(MemoryDiffTest, LengthsAroundVectorWidth) {
+    for (qsizetype length : {1, 7, 15, 16, 17, 31, 33, 100}) {
+        const QByteArray previous = pattern(length);
+        QByteArray current = previous;
+        for (qsizetype i = 0; i < length; i += 3)
+            current[i] = char(current[i] ^ 0x5A);
+
+        int changed = 0;
+        const QByteArray bits = changedBits(previous, current, &changed);
+
+        EXPECT_EQ(changed, int((length + 2) / 3)) << "length " << length;
+        EXPECT_EQ(bits.size(), (length + 7) / 8);
+        for (qsizetype i = 0; i < length; ++i)
+            ASSERT_EQ(isChanged(bits, i), i % 3 == 0) << "length " << length << " byte " << i;
+        // Padding bits past the end stay clear
+        for (qsizetype i = length; i < bits.size() * 8; ++i)
+            ASSERT_FALSE(isChanged(bits, i)) << "length " << length << " bit " << i;
+    }
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "PieceTable.h"
+
+#include <algorithm>
+
+namespace {
+
+QByteArray contents(const PieceTable &table)
+{
+    return table.read(0, table.size());
+}
+
+} // namespace
+
+TEST(PieceTableTest, CountLineBreaks) {
+    QByteArray text(1000, 'x');
+    for (int i = 3; i < text.size(); i += 7)
+        text[i] = '\n';
+    // Every start offset exercises the vector loop and the scalar tail
+    for (int start = 0; start < 70; ++start)
+        EXPECT_EQ(countLineBreaks(text.constData() + start, text.size() - start),
+                  std::count(text.cbegin() + start, text.cend(), '\n'));
+}
+
+TEST(PieceTableTest, EditUndoRedo) {
+    PieceTable table(TextSource::fromData("hello world\n"));
+    EXPECT_FALSE(table.isModified());
+
+    // Typing coalesces into one piece and one undo step
+    table.insert(5, ",");
+    table.insert(6, " dear");
+    EXPECT_EQ(contents(table), QByteArray("hello, dear world\n"));
+    EXPECT_EQ(table.pieceCount(), 3);
+
+    table.remove(0, 1);
+    table.insert(0, "J");
+    EXPECT_EQ(contents(table), QByteArray("Jello, dear world\n"));
+    EXPECT_TRUE(table.isModified());
+
+    EXPECT_EQ(table.undo(), 0);
+    EXPECT_EQ(table.undo(), 1);
+    EXPECT_EQ(contents(table), QByteArray("hello, dear world\n"));
+    EXPECT_EQ(table.undo(), 5);
+    EXPECT_EQ(contents(table), QByteArray("hello world\n"));
+    EXPECT_FALSE(table.isModified());
+    EXPECT_FALSE(table.canUndo());
+
+    EXPECT_EQ(table.redo(), 11);
+    EXPECT_EQ(contents(table), QByteArray("hello, dear world\n"));
+    table.setUnmodified();
+    EXPECT_FALSE(table.isModified());
+
+    // A new edit drops the redo history
+    table.insert(table.size(), "!");
+    EXPECT_FALSE(table.canRedo());
+    EXPECT_TRUE(table.isModified());
+
+    // Repeated Backspace is one step
+    table.remove(4, 1);
+    table.remove(3, 1);
+    table.remove(2, 1);
+    EXPECT_EQ(contents(table), QByteArray("he, dear world\n!"));
+    EXPECT_EQ(table.undo(), 5);
+    EXPECT_EQ(contents(table), QByteArray("hello, dear world\n!"));
+
+    QBuffer device;
+    ASSERT_TRUE(device.open(QIODevice::WriteOnly));
+    ASSERT_TRUE(table.writeTo(&device));
+    EXPECT_EQ(device.data(), contents(table));
+}
+
+TEST(PieceTableTest, LinesAcrossEdits) {
+    PieceTable table(TextSource::fromData("one\ntwo\nthree"));
+    EXPECT_EQ(table.lineCount(), 3);
+    EXPECT_EQ(table.lineStart(2), 8);
+    EXPECT_EQ(table.lineEnd(1), 7);
+    EXPECT_EQ(table.lineEnd(2), 13);
+    EXPECT_EQ(table.lineStart(3), -1);
+
+    table.insert(5, "\nnew\n");
+    EXPECT_EQ(contents(table), QByteArray("one\nt\nnew\nwo\nthree"));
+    EXPECT_EQ(table.lineCount(), 5);
+    EXPECT_EQ(table.lineStart(2), 6);
+    EXPECT_EQ(table.lineEnd(2), 9);
+    EXPECT_EQ(table.lineOfOffset(10), 3);
+    EXPECT_EQ(table.lineOfOffset(table.size()), 4);
+
+    table.remove(3, 1);
+    EXPECT_EQ(table.lineCount(), 4);
+    EXPECT_EQ(table.lineStart(1), 5);
+}
+
+TEST(PieceTableTest, LazyLineIndex) {
+    // Lines of 99 bytes plus '\n' across many index blocks
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const int lines = 20000;
+    QByteArray text;
+    for (int i = 0; i < lines; ++i)
+        text += QByteArray(99, char('a' + i % 26)) + '\n';
+    QFile file(dir.filePath("big.log"));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(text);
+    file.close();
+
+    std::shared_ptr<TextSource> source = TextSource::open(file.fileName());
+    ASSERT_NE(source, nullptr);
+    PieceTable table(source);
+    EXPECT_FALSE(table.isLineCountKnown());
+    EXPECT_NEAR(table.estimatedLineCount(), text.size() / 80, 2);
+
+    // Only the blocks in front of line 10 are indexed
+    EXPECT_EQ(table.lineStart(10), 1000);
+    EXPECT_FALSE(table.isLineCountKnown());
+    EXPECT_NEAR(table.estimatedLineCount(), lines, lines / 100);
+
+    EXPECT_EQ(table.lineStart(lines - 1), qint64(lines - 1) * 100);
+    EXPECT_EQ(table.lineOfOffset(123456), 1234);
+
+    PieceTable indexed(source);
+    std::atomic_bool cancelled{false};
+    indexed.setLineBlocks(indexLineBlocks(*source, cancelled));
+    EXPECT_TRUE(indexed.isLineCountKnown());
+    EXPECT_EQ(indexed.lineCount(), lines + 1);
+    EXPECT_EQ(indexed.lineEnd(lines), text.size());
+
+    cancelled = true;
+    EXPECT_TRUE(indexLineBlocks(*source, cancelled).empty());
+}
+
+TEST(PieceTableTest, IndexBudgetEstimatesUntilIndexed) {
+    QByteArray text;
+    const int lines = 20000;
+    for (int i = 0; i < lines; ++i)
+        text += QByteArray(99, 'x') + '\n';
+    std::shared_ptr<TextSource> source = TextSource::fromData(text);
+
+    PieceTable table(source);
+    table.setIndexBudget(1);
+    const PieceTable before = table.snapshot();
+
+    // Past the budget the start is estimated, but lands on a real line start
+    const qint64 start = table.lineStart(lines - 1);
+    EXPECT_EQ(start % 100, 0);
+    EXPECT_NEAR(start, qint64(lines - 1) * 100, 100 * 50);
+    EXPECT_LE(table.lineIndex()->indexedBlocks(), 2);
+    EXPECT_FALSE(table.linesExactBefore(start));
+    EXPECT_TRUE(table.linesExactBefore(1000));
+    EXPECT_FALSE(table.isLineCountKnown());
+
+    // A background job fills the shared index; every copy answers exactly
+    std::atomic_bool cancelled{false};
+    ASSERT_TRUE(table.lineIndex()->indexTo(table.lineIndex()->blockCount(), &cancelled));
+    EXPECT_EQ(table.lineStart(lines - 1), qint64(lines - 1) * 100);
+    EXPECT_EQ(table.lineOfOffset(123456), 1234);
+    EXPECT_TRUE(table.linesExactBefore(table.size()));
+    EXPECT_TRUE(before.isLineCountKnown());
+}
+
+TEST(PieceTableTest, LineAroundOffsetWithoutIndex) {
+    PieceTable table(TextSource::fromData("one\ntwo\nthree"));
+    table.insert(5, "\nnew\n");
+    ASSERT_EQ(contents(table), QByteArray("one\nt\nnew\nwo\nthree"));
+
+    EXPECT_EQ(table.lineStartAt(0, 100), 0);
+    EXPECT_EQ(table.lineStartAt(3, 100), 0);
+    EXPECT_EQ(table.lineStartAt(4, 100), 4);
+    EXPECT_EQ(table.lineStartAt(8, 100), 6);  // inside the inserted piece
+    EXPECT_EQ(table.lineStartAt(11, 100), 10);
+    EXPECT_EQ(table.lineStartAt(table.size(), 100), 13);
+    EXPECT_EQ(table.lineStartAt(table.size(), 2), table.size() - 2);
+
+    EXPECT_EQ(table.lineEndAt(0, 100), 3);
+    EXPECT_EQ(table.lineEndAt(4, 100), 5);
+    EXPECT_EQ(table.lineEndAt(10, 100), 12);
+    EXPECT_EQ(table.lineEndAt(13, 100), table.size());
+    EXPECT_EQ(table.lineEndAt(13, 2), -1);
+}
+
+TEST(PieceTableTest, EditsPastTheBudgetCountTheirLines) {
+    QByteArray text;
+    const int lines = 20000;
+    for (int i = 0; i < lines; ++i)
+        text += QByteArray(99, 'x') + '\n';
+
+    PieceTable table(TextSource::fromData(text));
+    table.setIndexBudget(1);
+
+    // What an edit replaced is counted exactly, however far the index got
+    table.remove(1900000, 250);
+    EXPECT_EQ(table.lastChange().removedBreaks, 2);
+    table.undo();
+    EXPECT_EQ(table.lastChange().insertedBreaks, 2);
+
+    // The line of the edit is not known; the last known one is before it
+    bool exact = true;
+    const qint64 known = table.knownLineOfOffset(1900000, &exact);
+    EXPECT_FALSE(exact);
+    EXPECT_EQ(known, table.lineIndex()->indexedBlocks() * LineBlockSize / 100);
+    EXPECT_EQ(table.knownLineOfOffset(1000, &exact), 10);
+    EXPECT_TRUE(exact);
+
+    std::atomic_bool cancelled{false};
+    ASSERT_TRUE(table.lineIndex()->indexTo(table.lineIndex()->blockCount(), &cancelled));
+    EXPECT_EQ(table.knownLineOfOffset(1900000, &exact), 19000);
+    EXPECT_TRUE(exact);
+}
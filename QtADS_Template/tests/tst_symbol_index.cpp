@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+
+#include "SymbolIndex.h"
+#include "TestFiles.h"
+
+namespace {
+
+QStringList describe(const QVector<Symbol> &symbols)
+{
+    QStringList lines;
+    for (const Symbol &symbol : symbols)
+    {
+        const QString qualified = symbol.scope.isEmpty() ? symbol.name : symbol.scope + "::" + symbol.name;
+        lines.append(QString("%1 %2:%3").arg(int(symbol.kind)).arg(qualified).arg(symbol.line));
+    }
+    return lines;
+}
+
+} // namespace
+
+TEST(SymbolIndexTest, ExtractSymbols) {
+    const QByteArray source(
+        "// class Commented { void no(); };\n"
+        "namespace app::ui {\n"
+        "class Q_DECL_EXPORT Widget : public QObject\n"
+        "{\n"
+        "    Q_OBJECT\n"
+        "    Q_PROPERTY(int value READ value NOTIFY valueChanged)\n"
+        "public:\n"
+        "    explicit Widget(QObject *parent = nullptr);\n"
+        "    bool operator==(const Widget &other) const;\n"
+        "    const char *text = \"struct Fake { void g(); }\";\n"
+        "signals:\n"
+        "    void valueChanged(int v);\n"
+        "public slots:\n"
+        "    void reset() { if (m_value) { m_value = {0}; } }\n"
+        "private:\n"
+        "    enum class Mode : int { A, B };\n"
+        "};\n"
+        "}\n"
+        "#define BLOCK { \\\n"
+        "    }\n"
+        "int variable = compute(1);\n"
+        "void app::ui::Widget::reset() {}\n");
+
+    const QStringList expected = {
+        QString("%1 app:2").arg(int(SymbolKind::Namespace)),
+        QString("%1 app::ui:2").arg(int(SymbolKind::Namespace)),
+        QString("%1 app::ui::Widget:3").arg(int(SymbolKind::Class)),
+        QString("%1 app::ui::Widget::Widget:8").arg(int(SymbolKind::Function)),
+        QString("%1 app::ui::Widget::operator==:9").arg(int(SymbolKind::Function)),
+        QString("%1 app::ui::Widget::valueChanged:12").arg(int(SymbolKind::Signal)),
+        QString("%1 app::ui::Widget::reset:14").arg(int(SymbolKind::Slot)),
+        QString("%1 app::ui::Widget::Mode:16").arg(int(SymbolKind::Enum)),
+        QString("%1 app::ui::Widget::reset:22").arg(int(SymbolKind::Function)),
+    };
+    EXPECT_EQ(describe(extractSymbols(source.constData(), source.size())), expected);
+}
+
+TEST(SymbolIndexTest, BuildAndQueryIndex) {
+    QTemporaryDir dir;
+    QTemporaryDir cacheDir;
+    ASSERT_TRUE(dir.isValid());
+    ASSERT_TRUE(cacheDir.isValid());
+    writeFile(dir.filePath("widget.h"), "namespace app {\nclass Widget {\npublic:\n    void show();\n"
+                                        "signals:\n    void shown();\n};\n}\n");
+    writeFile(dir.filePath("src/widget.cpp"), "namespace app {\nvoid Widget::show() {}\nvoid helper() {}\n}\n");
+    writeFile(dir.filePath("notes.txt"), "class NotCode {};\n");
+
+    const QString basePath = cacheDir.filePath("symbols");
+    EXPECT_EQ(SymbolIndex::open(basePath), nullptr);
+
+    std::atomic_bool cancelled{false};
+    SymbolIndexStats stats;
+    ASSERT_TRUE(buildSymbolIndex(dir.path(), basePath, nullptr, cancelled, &stats));
+    EXPECT_EQ(stats.filesParsed, 2);
+    EXPECT_EQ(stats.filesReused, 0);
+
+    const std::shared_ptr<const SymbolIndex> index = SymbolIndex::open(basePath);
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->fileCount(), 2);
+    EXPECT_EQ(index->symbolCount(), 7);
+
+    // Declaration and definition of show() are one member
+    const QVector<SymbolIndex::Entry> members = index->members("app::Widget");
+    ASSERT_EQ(members.size(), 2);
+    EXPECT_EQ(members[0].name, QString("show"));
+    EXPECT_EQ(members[1].name, QString("shown"));
+    EXPECT_EQ(members[1].kind, SymbolKind::Signal);
+    EXPECT_TRUE(members[1].filePath.endsWith("widget.h"));
+    EXPECT_EQ(members[1].line, 6);
+    EXPECT_TRUE(index->hasMembers("app"));
+    EXPECT_FALSE(index->hasMembers("app::helper"));
+
+    const QVector<SymbolIndex::Entry> matches = index->find("SH", 10);
+    ASSERT_EQ(matches.size(), 3);
+    EXPECT_EQ(matches[2].name, QString("shown"));
+
+    // Only the changed file is lexed again; the old index stays readable
+    writeFile(dir.filePath("src/widget.cpp"), "namespace app {\nvoid Widget::show() {}\nvoid helper2() {}\n}\n");
+    ASSERT_TRUE(buildSymbolIndex(dir.path(), basePath, index.get(), cancelled, &stats));
+    EXPECT_EQ(stats.filesParsed, 1);
+    EXPECT_EQ(stats.filesReused, 1);
+
+    const std::shared_ptr<const SymbolIndex> rebuilt = SymbolIndex::open(basePath);
+    ASSERT_NE(rebuilt, nullptr);
+    EXPECT_GT(rebuilt->generation(), index->generation());
+    ASSERT_EQ(rebuilt->find("helper", 10).size(), 1);
+    EXPECT_EQ(rebuilt->find("helper", 10)[0].name, QString("helper2"));
+    EXPECT_EQ(index->find("helper", 10)[0].name, QString("helper"));
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include "SyntaxHighlighter.h"
+
+#include <cstring>
+
+namespace {
+
+struct Lexed
+{
+    LineState next;
+    QVector<HighlightSpan> spans;
+};
+
+Lexed lex(const char *line, LineState state = LineState::Normal)
+{
+    Lexed lexed;
+    lexed.next = highlightLine(line, qint64(std::strlen(line)), state, &lexed.spans);
+    return lexed;
+}
+
+void expectSpan(const HighlightSpan &span, quint32 start, quint32 length, HighlightFormat format)
+{
+    EXPECT_EQ(span.start, start);
+    EXPECT_EQ(span.length, length);
+    EXPECT_EQ(span.format, format);
+}
+
+} // namespace
+
+TEST(SyntaxHighlighterTest, HighlightLine) {
+    Lexed lexed = lex("int x = 42; // answer");
+    EXPECT_EQ(lexed.next, LineState::Normal);
+    ASSERT_EQ(lexed.spans.size(), 3);
+    expectSpan(lexed.spans[0], 0, 3, HighlightFormat::Keyword);
+    expectSpan(lexed.spans[1], 8, 2, HighlightFormat::Number);
+    expectSpan(lexed.spans[2], 12, 9, HighlightFormat::Comment);
+
+    // Keywords only match whole words
+    EXPECT_TRUE(lex("integer = returned;").spans.isEmpty());
+
+    lexed = lex("s = \"a \\\" /* b\";");
+    ASSERT_EQ(lexed.spans.size(), 1);
+    expectSpan(lexed.spans[0], 4, 11, HighlightFormat::String);
+
+    lexed = lex("#include <vector>");
+    EXPECT_EQ(lexed.next, LineState::Normal);
+    ASSERT_FALSE(lexed.spans.isEmpty());
+    EXPECT_EQ(lexed.spans[0].format, HighlightFormat::Preprocessor);
+}
+
+TEST(SyntaxHighlighterTest, StatesCarryAcrossLines) {
+    EXPECT_EQ(lex("a /* open").next, LineState::BlockComment);
+
+    Lexed lexed = lex("still */ return", LineState::BlockComment);
+    EXPECT_EQ(lexed.next, LineState::Normal);
+    ASSERT_EQ(lexed.spans.size(), 2);
+    expectSpan(lexed.spans[0], 0, 8, HighlightFormat::Comment);
+    expectSpan(lexed.spans[1], 9, 6, HighlightFormat::Keyword);
+
+    EXPECT_EQ(lex("#define MAX(a, b) \\").next, LineState::Preprocessor);
+    EXPECT_EQ(lex("    ((a) > (b))", LineState::Preprocessor).next, LineState::Normal);
+    EXPECT_EQ(lex("\"two \\").next, LineState::String);
+}
+
+TEST(SyntaxHighlighterTest, HighlightLines) {
+    PieceTable buffer(TextSource::fromData("int a;\n/* one\ntwo */\nreturn;"));
+    std::atomic_bool cancelled{false};
+    std::vector<LineState> states;
+    std::vector<QVector<HighlightSpan>> spans;
+
+    // Stops after maxLines with more text to go
+    EXPECT_TRUE(highlightLines(buffer, 0, LineState::Normal, 2, 1 << 20, states, &spans, cancelled));
+    ASSERT_EQ(states.size(), 2u);
+    EXPECT_EQ(states[0], LineState::Normal);
+    EXPECT_EQ(states[1], LineState::BlockComment);
+
+    EXPECT_FALSE(highlightLines(buffer, 2, states.back(), 10, 1 << 20, states, &spans, cancelled));
+    ASSERT_EQ(states.size(), 4u);
+    EXPECT_EQ(states[2], LineState::Normal);
+    ASSERT_EQ(spans.size(), 4u);
+    ASSERT_EQ(spans[3].size(), 1);
+    expectSpan(spans[3][0], 0, 6, HighlightFormat::Keyword);
+
+    // The snapshot keeps the text it was taken with
+    PieceTable snapshot = buffer.snapshot();
+    buffer.insert(0, "/*\n");
+    const PieceTable::Change &change = buffer.lastChange();
+    EXPECT_EQ(change.offset, 0);
+    EXPECT_EQ(change.removedBreaks, 0);
+    EXPECT_EQ(change.insertedBreaks, 1);
+    EXPECT_EQ(snapshot.read(0, snapshot.size()), QByteArray("int a;\n/* one\ntwo */\nreturn;"));
+    EXPECT_FALSE(snapshot.canUndo());
+
+    buffer.undo();
+    EXPECT_EQ(buffer.lastChange().removedBreaks, 1);
+    EXPECT_EQ(buffer.lastChange().insertedBreaks, 0);
+}
+
+TEST(SyntaxHighlighterTest, LineStateBuffer) {
+    LineStateBuffer buffer;
+    std::vector<LineState> expected{LineState::Normal};
+    const auto check = [&]() {
+        ASSERT_EQ(buffer.size(), qint64(expected.size()));
+        for (size_t i = 0; i < expected.size(); ++i)
+            ASSERT_EQ(buffer.at(qint64(i)), expected[i]) << i;
+    };
+
+    for (int i = 0; i < 200; ++i)
+    {
+        const LineState state = LineState(i % 4);
+        buffer.append(state);
+        expected.push_back(state);
+    }
+    check();
+
+    // Edits here and there, as typing and pasting do
+    quint32 seed = 1;
+    for (int i = 0; i < 500; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        const qint64 line = 1 + qint64(seed >> 8) % qint64(expected.size());
+        const qint64 removed = qint64(seed >> 4) % 5;
+        const qint64 inserted = qint64(seed >> 12) % 4;
+        buffer.replace(line, removed, inserted);
+        const auto first = expected.begin() + qptrdiff(qMin<qint64>(line, qint64(expected.size())));
+        expected.erase(first, first + qptrdiff(qMin<qint64>(removed, qint64(expected.end() - first))));
+        expected.insert(expected.begin() + qptrdiff(qMin<qint64>(line, qint64(expected.size()))), size_t(inserted),
+                        LineState::Normal);
+        if (i % 7 == 0)
+        {
+            buffer.set(line - 1, LineState::BlockComment);
+            expected[size_t(line - 1)] = LineState::BlockComment;
+        }
+    }
+    check();
+
+    buffer.resize(10);
+    expected.resize(10);
+    check();
+    buffer.resize(300);
+    expected.resize(300, LineState::Normal);
+    check();
+}
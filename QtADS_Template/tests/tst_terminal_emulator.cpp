@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "TerminalEmulator.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+void feed(TerminalScreen &screen, const char *text)
+{
+    screen.feed(text, qint64(std::strlen(text)));
+}
+
+// Row text without trailing blanks; non-ASCII as '#'
+std::string rowText(const TerminalScreen &screen, int row)
+{
+    std::string text;
+    for (int column = 0; column < screen.columns(); ++column)
+    {
+        const char32_t ch = screen.row(row)[column].ch;
+        text += ch < 0x80 ? char(ch) : '#';
+    }
+    while (!text.empty() && text.back() == ' ')
+        text.pop_back();
+    return text;
+}
+
+std::string scrollbackText(const TerminalScreen &screen, qint64 line)
+{
+    int length = 0;
+    const TerminalCell *cells = screen.scrollback().line(line, &length);
+    std::string text;
+    for (int i = 0; i < length; ++i)
+        text += char(cells[i].ch);
+    return text;
+}
+
+} // namespace
+
+TEST(TerminalEmulatorTest, TextWrapsAndScrolls) {
+    TerminalScreen screen(3, 10, 1 << 20);
+    feed(screen, "hello\r\nworld");
+    EXPECT_EQ(rowText(screen, 0), "hello");
+    EXPECT_EQ(rowText(screen, 1), "world");
+    EXPECT_EQ(screen.cursorRow(), 1);
+    EXPECT_EQ(screen.cursorColumn(), 5);
+
+    // Twelve more characters wrap once; the next line scrolls "hello" out
+    feed(screen, "0123456789ab\r\nend");
+    EXPECT_EQ(rowText(screen, 0), "world01234");
+    EXPECT_EQ(rowText(screen, 1), "56789ab");
+    EXPECT_EQ(rowText(screen, 2), "end");
+    ASSERT_EQ(screen.scrollback().lineCount(), 1);
+    EXPECT_EQ(scrollbackText(screen, 0), "hello");
+    EXPECT_EQ(screen.scrolledLines(), 1);
+
+    // A scroll region keeps its lines out of the scrollback
+    feed(screen, "\x1b[2;3r\x1b[3;1Ha\nb\nc");
+    EXPECT_EQ(screen.scrollback().lineCount(), 1);
+    EXPECT_EQ(rowText(screen, 0), "world01234");
+    EXPECT_EQ(rowText(screen, 1), " b");
+    EXPECT_EQ(rowText(screen, 2), "  c");
+}
+
+TEST(TerminalEmulatorTest, CursorEraseAndAttributes) {
+    TerminalScreen screen(5, 10, 1 << 20);
+    feed(screen, "abcdef\x1b[3G\x1b[K");
+    EXPECT_EQ(rowText(screen, 0), "ab");
+    feed(screen, "\rabcdef\x1b[2G\x1b[2P");
+    EXPECT_EQ(rowText(screen, 0), "adef");
+    feed(screen, "\x1b[2@");
+    EXPECT_EQ(rowText(screen, 0), "a  def");
+
+    feed(screen, "\x1b[2;3HA\x1b[31;1mB\x1b[38;5;200mC\x1b[38;2;255;0;0;44mD\x1b[0mE");
+    const TerminalCell *row = screen.row(1);
+    EXPECT_EQ(row[2].ch, U'A');
+    EXPECT_EQ(row[3].foreground, 1);
+    EXPECT_TRUE(row[3].flags & TerminalCell::Bold);
+    EXPECT_FALSE(row[3].flags & TerminalCell::DefaultForeground);
+    EXPECT_EQ(row[4].foreground, 200);
+    EXPECT_EQ(row[5].foreground, 196);
+    EXPECT_EQ(row[5].background, 4);
+    EXPECT_TRUE(row[6].sameStyle(TerminalCell()));
+
+    // Status reports are queued for the program
+    feed(screen, "\x1b[3;4H\x1b[6n");
+    EXPECT_EQ(screen.takeResponse(), QByteArray("\x1b[3;4R"));
+    EXPECT_TRUE(screen.takeResponse().isEmpty());
+}
+
+TEST(TerminalEmulatorTest, SplitFeedsMatchWholeFeed) {
+    const char *stream = "\x1b]0;title\x07"
+                         "ab\xc3\xa9"
+                         "cd\x1b[1;31mxx\x1b[2;4Hyy\x1b[?25l\x1b[10;1Hzz\r\n\r\n\r\n\r\n\r\nw\x1b[Jq\xe2\x82\xac";
+    TerminalScreen whole(4, 8, 1 << 20);
+    TerminalScreen split(4, 8, 1 << 20);
+    whole.feed(stream, qint64(std::strlen(stream)));
+    for (size_t i = 0; i < std::strlen(stream); ++i)
+        split.feed(stream + i, 1);
+
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int column = 0; column < 8; ++column)
+        {
+            EXPECT_EQ(whole.row(row)[column].ch, split.row(row)[column].ch);
+            EXPECT_TRUE(whole.row(row)[column].sameStyle(split.row(row)[column]));
+        }
+    }
+    EXPECT_EQ(split.title(), QString("title"));
+    EXPECT_FALSE(split.isCursorVisible());
+    EXPECT_EQ(whole.scrollback().lineCount(), split.scrollback().lineCount());
+
+    // UTF-8, and a sequence cut short by ASCII
+    TerminalScreen text(2, 8, 1 << 20);
+    feed(text, "\xc3\xa9\xe2\x82\xac\xe2\x82x");
+    EXPECT_EQ(text.row(0)[0].ch, char32_t(0xe9));
+    EXPECT_EQ(text.row(0)[1].ch, char32_t(0x20ac));
+    EXPECT_EQ(text.row(0)[2].ch, char32_t(0xfffd));
+    EXPECT_EQ(text.row(0)[3].ch, U'x');
+}
+
+TEST(TerminalEmulatorTest, AlternateScreen) {
+    TerminalScreen screen(3, 10, 1 << 20);
+    feed(screen, "main\x1b[?1049h\x1b[2J\x1b[Halt\r\n\r\n\r\n\r\nx");
+    EXPECT_TRUE(screen.isAlternateScreen());
+    EXPECT_EQ(screen.scrollback().lineCount(), 0);
+    feed(screen, "\x1b[?1049l");
+    EXPECT_FALSE(screen.isAlternateScreen());
+    EXPECT_EQ(rowText(screen, 0), "main");
+    EXPECT_EQ(screen.cursorColumn(), 4);
+}
+
+TEST(TerminalEmulatorTest, ScrollbackMemoryCap) {
+    TerminalScrollback scrollback(64 * 1024);
+    TerminalCell cells[200];
+    std::vector<int> lengths;
+    for (int i = 0; i < 20000; ++i)
+    {
+        const int length = (i * 37) % 200;
+        cells[0].ch = U'0' + i % 10;
+        scrollback.push(cells, length, false);
+        lengths.push_back(length);
+    }
+
+    // The newest lines are kept within the cap, the rest dropped
+    const qint64 kept = scrollback.lineCount();
+    EXPECT_GT(kept, 0);
+    EXPECT_EQ(kept + qint64(scrollback.droppedLines()), 20000);
+    qint64 storedCells = 0;
+    for (qint64 line = 0; line < kept; ++line)
+    {
+        const qint64 pushed = 20000 - kept + line;
+        int length = 0;
+        const TerminalCell *stored = scrollback.line(line, &length);
+        ASSERT_EQ(length, lengths[size_t(pushed)]);
+        if (length > 0)
+            EXPECT_EQ(stored[0].ch, char32_t(U'0' + pushed % 10));
+        storedCells += length;
+    }
+    EXPECT_LE(storedCells * qint64(sizeof(TerminalCell)), 64 * 1024);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "TodoScanner.h"
+#include "TestFiles.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+QVector<TodoFileResult> runScan(const QString &rootPath, TodoCache &cache, TodoScanStats *stats)
+{
+    std::mutex mutex;
+    QVector<TodoFileResult> results;
+    std::atomic_bool cancelled{false};
+    scanTodos(rootPath, cache, cancelled, [&](TodoFileResult &&result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.append(std::move(result));
+    }, stats);
+    std::sort(results.begin(), results.end(),
+              [](const TodoFileResult &a, const TodoFileResult &b) { return a.path < b.path; });
+    return results;
+}
+
+} // namespace
+
+TEST(TodoScannerTest, FindMarkers) {
+    const QByteArray text("int x; // TODO: fix this\n"
+                          "MY_TODO and TODOS are not markers\n"
+                          "/* FIXME(bob) later */\n"
+                          "HACK HACK only once per line\n"
+                          "  TODO");
+
+    const QVector<TodoMarker> markers = findTodoMarkers(text.constData(), text.size());
+    ASSERT_EQ(markers.size(), 4);
+    EXPECT_EQ(markers[0].line, 1);
+    EXPECT_EQ(markers[0].text, QString("TODO: fix this"));
+    EXPECT_EQ(markers[1].line, 3);
+    EXPECT_EQ(markers[1].text, QString("FIXME(bob) later"));
+    EXPECT_EQ(markers[2].line, 4);
+    EXPECT_EQ(markers[3].line, 5);
+    EXPECT_EQ(markers[3].text, QString("TODO"));
+
+    EXPECT_TRUE(findTodoMarkers("TODO\0binary", 11).isEmpty());
+}
+
+TEST(TodoScannerTest, FindMarkersAcrossBlocks) {
+    // Keywords straddling the 16 byte blocks of the vector loop
+    for (int offset = 0; offset < 40; ++offset) {
+        const QByteArray text = QByteArray(offset, ' ') + "FIXME" + QByteArray(20, ' ');
+        const QVector<TodoMarker> markers = findTodoMarkers(text.constData(), text.size());
+        ASSERT_EQ(markers.size(), 1) << offset;
+        EXPECT_EQ(markers[0].text, QString("FIXME"));
+    }
+}
+
+TEST(TodoScannerTest, CacheSkipsUnchangedFiles) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    writeFile(dir.filePath("a.cpp"), "// TODO: one\n");
+    writeFile(dir.filePath("src/b.cpp"), "int b;\n// HACK: two\n");
+    writeFile(dir.filePath("src/c.cpp"), "int c;\n");
+
+    TodoCache cache;
+    TodoScanStats stats;
+    QVector<TodoFileResult> results = runScan(dir.path(), cache, &stats);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(stats.filesRead, 3);
+    EXPECT_EQ(stats.filesCached, 0);
+    EXPECT_EQ(results[1].markers[0].line, 2);
+
+    // Round trip through the cache file, as after a restart
+    QTemporaryDir cacheDir;
+    ASSERT_TRUE(cacheDir.isValid());
+    const QString cachePath = cacheDir.filePath("todo.dat");
+    ASSERT_TRUE(cache.save(cachePath));
+    TodoCache restored;
+    ASSERT_TRUE(restored.load(cachePath));
+    EXPECT_EQ(restored.size(), 3);
+
+    writeFile(dir.filePath("src/c.cpp"), "int c; // FIXME: new\n");
+    QFile::remove(dir.filePath("a.cpp"));
+    stats = TodoScanStats();
+    results = runScan(dir.path(), restored, &stats);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(stats.filesRead, 1);
+    EXPECT_EQ(stats.filesCached, 1);
+    EXPECT_TRUE(results[1].path.endsWith("src/c.cpp"));
+    EXPECT_FALSE(restored.contains(dir.filePath("a.cpp")));
+
+    // Modified files are rescanned on their own, with or without markers
+    writeFile(dir.filePath("src/b.cpp"), "int b;\n");
+    QVector<TodoFileResult> rescanned;
+    rescanTodoFiles({dir.filePath("src/b.cpp"), dir.filePath("unknown.cpp")}, restored,
+                    [&](TodoFileResult &&result) { rescanned.append(std::move(result)); });
+    ASSERT_EQ(rescanned.size(), 1);
+    EXPECT_TRUE(rescanned[0].markers.isEmpty());
+}
+
+TEST(TodoScannerTest, ReportsWalkedDirectories) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    writeFile(dir.filePath(".gitignore"), "build/\n");
+    writeFile(dir.filePath("src/a.cpp"), "// TODO: one\n");
+    writeFile(dir.filePath("build/gen/b.cpp"), "// TODO: generated\n");
+    writeFile(dir.filePath(".git/objects/c"), "TODO\n");
+
+    TodoCache cache;
+    std::atomic_bool cancelled{false};
+    QStringList directories;
+    int files = 0;
+    ASSERT_TRUE(scanTodos(dir.path(), cache, cancelled, [&](TodoFileResult &&) { ++files; }, nullptr,
+                          &directories));
+    EXPECT_EQ(files, 1);
+
+    // Ignored and version control directories are neither scanned nor reported
+    const QDir root(dir.path());
+    QStringList relativePaths;
+    for (const QString &directory : std::as_const(directories))
+        relativePaths.append(root.relativeFilePath(directory));
+    relativePaths.sort();
+    EXPECT_EQ(relativePaths, (QStringList{".", "src"}));
+}
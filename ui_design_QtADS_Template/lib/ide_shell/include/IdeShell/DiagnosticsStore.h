@@ -0,0 +1,143 @@
+#ifndef DIAGNOSTICSSTORE_H
+#define DIAGNOSTICSSTORE_H
+
+#include <QAbstractItemModel>
+#include <QMultiHash>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+namespace ide_shell
+{
+// One problem reported by a build or a linter
+struct Diagnostic
+{
+    enum Severity
+    {
+        Error,
+        Warning,
+        Info,
+        SeverityCount
+    };
+
+    Severity severity = Error;
+    QString file;
+    int line = 0; // 1-based, 0 if unknown
+    int column = 0;
+    QString code; // such as "-Wunused-variable" or "C4996"; may be empty
+    QString message;
+};
+
+// Problems of a workspace, fed by any number of sources (builds, linters)
+// and shown as a tree of files with their diagnostics.
+//
+// Records are deduplicated by a hash of (file, line, column, code,
+// message): a record reported again, by the same or another source, only
+// remembers that source too. Each file has its own bucket, so forgetting
+// what a source said about a file before it is rebuilt finds its records
+// with one lookup, and only that file's rows change.
+//
+// The store is the model itself and data() formats rows on demand. A batch
+// of records costs one rowsInserted per file it touches and one for the
+// files it adds, so a full rebuild reporting tens of thousands of warnings
+// stays cheap for the view. Files are listed in the order they were first
+// reported.
+class DiagnosticsStore : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        FileColumn,
+        LineColumn,
+        MessageColumn,
+        ColumnCount
+    };
+
+    enum Role
+    {
+        SeverityRole = Qt::UserRole + 1, // Diagnostic::Severity, diagnostic rows only
+        FileRole,
+        LineRole,
+        ColumnRole
+    };
+
+    explicit DiagnosticsStore(QObject *parent = nullptr);
+    ~DiagnosticsStore() override;
+
+    void addDiagnostics(const QString &source, const QVector<Diagnostic> &diagnostics);
+    // Forgets what source reported for file; records other sources also
+    // reported stay
+    void clearFile(const QString &source, const QString &file);
+    void clearSource(const QString &source);
+    void clear();
+
+    int fileCount() const { return int(m_files.size()); }
+    int diagnosticCount() const;
+    int count(Diagnostic::Severity severity) const { return m_counts[severity]; }
+    // nullptr for file rows
+    const Diagnostic *diagnostic(const QModelIndex &index) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    void countsChanged();
+
+private:
+    // Bit per source index: the first 64 inline, words for more only once
+    // that many sources reported
+    class SourceSet
+    {
+    public:
+        explicit SourceSet(int source) { insert(source); }
+        void insert(int source);
+        void remove(int source);
+        bool contains(int source) const;
+        bool isEmpty() const;
+
+    private:
+        quint64 m_first = 0;
+        std::vector<quint64> m_more;
+    };
+
+    struct Entry
+    {
+        Diagnostic diagnostic;
+        size_t hash = 0;
+        SourceSet sources;
+    };
+
+    struct FileBucket
+    {
+        QString file;
+        int row = 0;
+        std::vector<Entry> entries;
+        QMultiHash<size_t, int> entryByHash;
+        int counts[Diagnostic::SeverityCount] = {};
+    };
+
+    static size_t hashOf(const Diagnostic &diagnostic);
+    static bool sameRecord(const Diagnostic &a, const Diagnostic &b);
+    int sourceIndex(const QString &source);
+    int findEntry(const FileBucket &bucket, const Diagnostic &diagnostic, size_t hash) const;
+    void appendEntry(FileBucket *bucket, const Diagnostic &diagnostic, size_t hash, int source);
+    void removeSource(FileBucket *bucket, int source);
+    void removeFile(int row);
+    QString sourcesText(const SourceSet &sources) const;
+
+    std::vector<std::unique_ptr<FileBucket>> m_files; // in row order
+    QHash<QString, FileBucket *> m_fileBuckets;
+    QStringList m_sources; // source index -> name
+    int m_counts[Diagnostic::SeverityCount] = {};
+};
+} // namespace ide_shell
+
+#endif // DIAGNOSTICSSTORE_H
@@ -0,0 +1,120 @@
+#ifndef FILEINDEX_H
+#define FILEINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+namespace ide_shell
+{
+class IndexSnapshot;
+
+struct FileMatch
+{
+    QString path; // relative to the root, '/' separated
+    int score = 0;
+};
+
+// Quick-open index of every file path below a root directory.
+//
+// Paths are kept in an immutable trigram index (posting lists of path ids
+// per case-folded byte trigram) that is written to the cache directory and
+// memory-mapped, so a later session can answer queries before its first
+// crawl finishes. A background crawl verifies the tree on every
+// setRootPath() and rebuilds the file only when something changed.
+//
+// Changes are picked up from inotify on Linux (QFileSystemWatcher plus a
+// re-crawl elsewhere) and kept in a small overlay on top of the mapped
+// index until the next rebuild. Directories moved into the tree are crawled
+// on the thread pool; events from directories whose watches a running crawl
+// has not handed over yet are buffered and replayed when it finishes.
+//
+// find() matches every space-separated word of the query as a
+// case-insensitive substring of the path and ranks file-name hits, word
+// starts and short paths first.
+class FileIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileIndex(QObject *parent = nullptr);
+    ~FileIndex() override;
+
+    void setRootPath(const QString &path);
+    QString rootPath() const;
+
+    int fileCount() const;
+    bool isIndexing() const;
+
+    QVector<FileMatch> find(const QString &query, int limit = 50) const;
+
+    static QString cacheFilePath(const QString &rootPath);
+
+signals:
+    void indexChanged();
+    void indexingChanged(bool indexing);
+
+private:
+    struct WatchEvent
+    {
+        int wd;
+        quint32 mask;
+        QByteArray name;
+    };
+
+    void startCrawl();
+    void onCrawlFinished(quint64 generation, std::shared_ptr<const IndexSnapshot> snapshot,
+                         const QHash<int, QByteArray> &watches, const QStringList &directories);
+    void onChangeTimeout();
+    void adoptSnapshot(std::shared_ptr<const IndexSnapshot> snapshot);
+    void stopWatching();
+    void readInotifyEvents();
+    void handleEvent(const WatchEvent &event);
+    void replayBufferedEvents();
+    void addWatches(const QHash<int, QByteArray> &watches);
+    void forgetWatch(int wd);
+    void onDirectoryCrawled(quint64 generation, const QVector<QByteArray> &paths,
+                            const QHash<int, QByteArray> &watches);
+    void addPath(const QByteArray &relativePath);
+    void removePath(const QByteArray &relativePath);
+    void addDirectory(const QByteArray &relativePath);
+    void removeDirectory(const QByteArray &relativePath);
+
+    QString m_rootPath;
+    std::shared_ptr<const IndexSnapshot> m_snapshot;
+
+    // Changes since m_snapshot was built
+    QSet<QByteArray> m_addedPaths;
+    QSet<QByteArray> m_removedPaths;
+    std::vector<bool> m_removedIds;
+
+    quint64 m_generation = 0;
+    std::shared_ptr<std::atomic_bool> m_cancelled; // set while a crawl runs
+    std::shared_ptr<std::atomic_bool> m_directoryCrawlsCancelled; // per root
+    int m_directoryCrawls = 0;
+    bool m_rescanPending = false;
+    bool m_fallbackDirty = false;
+
+    int m_inotifyFd = -1;
+    QSocketNotifier *m_inotifyNotifier = nullptr;
+    QHash<int, QByteArray> m_watchDirs; // watch descriptor -> relative directory
+    QMap<QByteArray, int> m_dirWatches; // the same, by directory for prefix ranges
+    QVector<WatchEvent> m_bufferedEvents; // from watches a crawl has not handed over
+    QFileSystemWatcher *m_fallbackWatcher = nullptr;
+    QTimer *m_changeTimer = nullptr;
+};
+} // namespace ide_shell
+
+#endif // FILEINDEX_H
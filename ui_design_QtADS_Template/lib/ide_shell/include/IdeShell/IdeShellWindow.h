@@ -12,6 +12,9 @@ class QWidget;
 
 namespace ide_shell
 {
+class FileIndex;
+class QuickOpenPopup;
+
 class IdeShellWindow : public QMainWindow
 {
     Q_OBJECT
@@ -24,6 +27,13 @@ public:
     void setWorkspaceWidget(QWidget *widget);
     void setStatusText(const QString &leftText, const QString &rightText);
 
+    // Indexes the files below path for quick open in the title bar search box
+    void setProjectRoot(const QString &path);
+    FileIndex *fileIndex() const;
+
+signals:
+    void fileOpenRequested(const QString &filePath);
+
 protected:
     QWidget *createWelcomePanel() const;
     bool eventFilter(QObject *watched, QEvent *event) override;
@@ -37,6 +47,9 @@ private:
     QWidget *m_dragRegion = nullptr;
     QWidget *m_workspaceHost = nullptr;
     QToolButton *m_maximizeButton = nullptr;
+    QLineEdit *m_searchBox = nullptr;
+    FileIndex *m_fileIndex = nullptr;
+    QuickOpenPopup *m_quickOpen = nullptr;
     QLabel *m_leftStatusLabel = nullptr;
     QLabel *m_rightStatusLabel = nullptr;
     bool m_dragActive = false;
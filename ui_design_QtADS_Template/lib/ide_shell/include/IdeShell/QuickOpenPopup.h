@@ -0,0 +1,51 @@
+#ifndef QUICKOPENPOPUP_H
+#define QUICKOPENPOPUP_H
+
+#include <QFrame>
+#include <QPointer>
+
+class QLabel;
+class QLineEdit;
+class QListWidget;
+
+namespace ide_shell
+{
+class FileIndex;
+
+// Result list shown below a search box while typing. The box keeps the
+// keyboard focus: the popup never activates, and Up/Down/PageUp/PageDown,
+// Enter and Escape typed into the box are handled here. The popup is a
+// window of its own, so it follows moves and resizes of the box's window.
+class QuickOpenPopup : public QFrame
+{
+    Q_OBJECT
+
+public:
+    QuickOpenPopup(QLineEdit *searchBox, FileIndex *index, QWidget *parent = nullptr);
+    ~QuickOpenPopup() override;
+
+signals:
+    // Absolute path of the chosen file
+    void fileActivated(const QString &filePath);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void updateResults();
+    void moveSelection(int delta);
+    void activateCurrent();
+    void placeBelowSearchBox();
+    // Watches the window the box is in now; it changes when the box is
+    // reparented
+    void watchSearchBoxWindow();
+
+    QLineEdit *m_searchBox = nullptr;
+    QPointer<QWidget> m_searchBoxWindow;
+    FileIndex *m_index = nullptr;
+    QListWidget *m_list = nullptr;
+    QLabel *m_footer = nullptr;
+};
+} // namespace ide_shell
+
+#endif // QUICKOPENPOPUP_H
@@ -0,0 +1,452 @@
+#include "IdeShell/DiagnosticsStore.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QHash>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+const QColor SeverityColors[] = {QColor(0xc4, 0x2b, 0x1c), QColor(0xb0, 0x6d, 0x00), QColor(0x1a, 0x73, 0xc8)};
+
+QString severityText(ide_shell::Diagnostic::Severity severity)
+{
+    switch (severity)
+    {
+    case ide_shell::Diagnostic::Error:
+        return ide_shell::DiagnosticsStore::tr("Error");
+    case ide_shell::Diagnostic::Warning:
+        return ide_shell::DiagnosticsStore::tr("Warning");
+    default:
+        return ide_shell::DiagnosticsStore::tr("Info");
+    }
+}
+} // namespace
+
+namespace ide_shell
+{
+DiagnosticsStore::DiagnosticsStore(QObject *parent)
+    : QAbstractItemModel(parent)
+{
+}
+
+DiagnosticsStore::~DiagnosticsStore() = default;
+
+void DiagnosticsStore::addDiagnostics(const QString &source, const QVector<Diagnostic> &diagnostics)
+{
+    if (diagnostics.isEmpty())
+        return;
+    const int sourceId = sourceIndex(source);
+
+    // Group by file, keeping the order files were reported in
+    struct Group
+    {
+        QString file;
+        QVector<const Diagnostic *> records;
+    };
+    std::vector<Group> groups;
+    QHash<QString, int> groupOfFile;
+    for (const Diagnostic &diagnostic : diagnostics)
+    {
+        auto it = groupOfFile.constFind(diagnostic.file);
+        if (it == groupOfFile.constEnd())
+        {
+            it = groupOfFile.insert(diagnostic.file, int(groups.size()));
+            groups.push_back({diagnostic.file, {}});
+        }
+        groups[size_t(it.value())].records.append(&diagnostic);
+    }
+
+    // Known files get one insert under their row each; new files are
+    // filled aside and inserted together
+    std::vector<std::unique_ptr<FileBucket>> addedFiles;
+    for (const Group &group : groups)
+    {
+        FileBucket *bucket = m_fileBuckets.value(group.file);
+        if (!bucket)
+        {
+            auto added = std::make_unique<FileBucket>();
+            added->file = group.file;
+            added->row = int(m_files.size() + addedFiles.size());
+            for (const Diagnostic *diagnostic : group.records)
+            {
+                const size_t hash = hashOf(*diagnostic);
+                const int existing = findEntry(*added, *diagnostic, hash);
+                if (existing >= 0)
+                    added->entries[size_t(existing)].sources.insert(sourceId);
+                else
+                    appendEntry(added.get(), *diagnostic, hash, sourceId);
+            }
+            addedFiles.push_back(std::move(added));
+            continue;
+        }
+
+        QVector<const Diagnostic *> fresh;
+        QMultiHash<size_t, const Diagnostic *> freshByHash;
+        for (const Diagnostic *diagnostic : group.records)
+        {
+            const size_t hash = hashOf(*diagnostic);
+            const int existing = findEntry(*bucket, *diagnostic, hash);
+            if (existing >= 0)
+            {
+                bucket->entries[size_t(existing)].sources.insert(sourceId);
+                continue;
+            }
+            bool duplicate = false;
+            for (auto it = freshByHash.constFind(hash); it != freshByHash.constEnd() && it.key() == hash; ++it)
+                duplicate = duplicate || sameRecord(*it.value(), *diagnostic);
+            if (duplicate)
+                continue;
+            freshByHash.insert(hash, diagnostic);
+            fresh.append(diagnostic);
+        }
+        if (fresh.isEmpty())
+            continue;
+
+        const QModelIndex parent = index(bucket->row, 0);
+        const int first = int(bucket->entries.size());
+        beginInsertRows(parent, first, first + int(fresh.size()) - 1);
+        for (const Diagnostic *diagnostic : std::as_const(fresh))
+        {
+            appendEntry(bucket, *diagnostic, hashOf(*diagnostic), sourceId);
+            // Counted here; new files add theirs when they are inserted
+            ++m_counts[diagnostic->severity];
+        }
+        endInsertRows();
+        emit dataChanged(parent, index(bucket->row, ColumnCount - 1));
+    }
+
+    if (!addedFiles.empty())
+    {
+        const int first = int(m_files.size());
+        beginInsertRows(QModelIndex(), first, first + int(addedFiles.size()) - 1);
+        for (std::unique_ptr<FileBucket> &bucket : addedFiles)
+        {
+            for (int severity = 0; severity < Diagnostic::SeverityCount; ++severity)
+                m_counts[severity] += bucket->counts[severity];
+            m_fileBuckets.insert(bucket->file, bucket.get());
+            m_files.push_back(std::move(bucket));
+        }
+        endInsertRows();
+    }
+    emit countsChanged();
+}
+
+void DiagnosticsStore::clearFile(const QString &source, const QString &file)
+{
+    FileBucket *bucket = m_fileBuckets.value(file);
+    if (!bucket || !m_sources.contains(source))
+        return;
+    removeSource(bucket, sourceIndex(source));
+    emit countsChanged();
+}
+
+void DiagnosticsStore::clearSource(const QString &source)
+{
+    if (!m_sources.contains(source))
+        return;
+    const int sourceId = sourceIndex(source);
+    // Backwards, so removed files do not move the rows still to visit
+    for (int row = fileCount() - 1; row >= 0; --row)
+        removeSource(m_files[size_t(row)].get(), sourceId);
+    emit countsChanged();
+}
+
+void DiagnosticsStore::clear()
+{
+    beginResetModel();
+    m_files.clear();
+    m_fileBuckets.clear();
+    m_sources.clear();
+    std::fill(std::begin(m_counts), std::end(m_counts), 0);
+    endResetModel();
+    emit countsChanged();
+}
+
+int DiagnosticsStore::diagnosticCount() const
+{
+    int total = 0;
+    for (int count : m_counts)
+        total += count;
+    return total;
+}
+
+const Diagnostic *DiagnosticsStore::diagnostic(const QModelIndex &index) const
+{
+    const auto *bucket = static_cast<const FileBucket *>(index.internalPointer());
+    if (!index.isValid() || !bucket)
+        return nullptr;
+    return &bucket->entries[size_t(index.row())].diagnostic;
+}
+
+// ---------------------------------------------------------------------------
+// Buckets
+// ---------------------------------------------------------------------------
+void DiagnosticsStore::SourceSet::insert(int source)
+{
+    if (source < 64)
+    {
+        m_first |= quint64(1) << source;
+        return;
+    }
+    const size_t word = size_t(source / 64 - 1);
+    if (word >= m_more.size())
+        m_more.resize(word + 1, 0);
+    m_more[word] |= quint64(1) << (source % 64);
+}
+
+void DiagnosticsStore::SourceSet::remove(int source)
+{
+    if (source < 64)
+        m_first &= ~(quint64(1) << source);
+    else if (size_t(source / 64 - 1) < m_more.size())
+        m_more[size_t(source / 64 - 1)] &= ~(quint64(1) << (source % 64));
+}
+
+bool DiagnosticsStore::SourceSet::contains(int source) const
+{
+    if (source < 64)
+        return m_first & (quint64(1) << source);
+    const size_t word = size_t(source / 64 - 1);
+    return word < m_more.size() && (m_more[word] & (quint64(1) << (source % 64)));
+}
+
+bool DiagnosticsStore::SourceSet::isEmpty() const
+{
+    return m_first == 0 && std::all_of(m_more.cbegin(), m_more.cend(), [](quint64 word) { return word == 0; });
+}
+
+size_t DiagnosticsStore::hashOf(const Diagnostic &diagnostic)
+{
+    return qHashMulti(0, diagnostic.file, diagnostic.line, diagnostic.column, diagnostic.code, diagnostic.message);
+}
+
+bool DiagnosticsStore::sameRecord(const Diagnostic &a, const Diagnostic &b)
+{
+    return a.line == b.line && a.column == b.column && a.file == b.file && a.code == b.code && a.message == b.message;
+}
+
+int DiagnosticsStore::sourceIndex(const QString &source)
+{
+    int index = int(m_sources.indexOf(source));
+    if (index < 0)
+    {
+        index = int(m_sources.size());
+        m_sources.append(source);
+    }
+    return index;
+}
+
+int DiagnosticsStore::findEntry(const FileBucket &bucket, const Diagnostic &diagnostic, size_t hash) const
+{
+    for (auto it = bucket.entryByHash.constFind(hash); it != bucket.entryByHash.constEnd() && it.key() == hash; ++it)
+    {
+        if (sameRecord(bucket.entries[size_t(it.value())].diagnostic, diagnostic))
+            return it.value();
+    }
+    return -1;
+}
+
+void DiagnosticsStore::appendEntry(FileBucket *bucket, const Diagnostic &diagnostic, size_t hash, int source)
+{
+    bucket->entryByHash.insert(hash, int(bucket->entries.size()));
+    bucket->entries.push_back({diagnostic, hash, SourceSet(source)});
+    ++bucket->counts[diagnostic.severity];
+}
+
+void DiagnosticsStore::removeSource(FileBucket *bucket, int source)
+{
+    bool anyLeft = false;
+    for (Entry &entry : bucket->entries)
+    {
+        entry.sources.remove(source);
+        anyLeft = anyLeft || !entry.sources.isEmpty();
+    }
+    if (!anyLeft)
+    {
+        removeFile(bucket->row);
+        return;
+    }
+
+    // Records other sources still report stay; the rest go in runs
+    const QModelIndex parent = index(bucket->row, 0);
+    bool removed = false;
+    int last = int(bucket->entries.size()) - 1;
+    while (last >= 0)
+    {
+        if (!bucket->entries[size_t(last)].sources.isEmpty())
+        {
+            --last;
+            continue;
+        }
+        int first = last;
+        while (first > 0 && bucket->entries[size_t(first - 1)].sources.isEmpty())
+            --first;
+        beginRemoveRows(parent, first, last);
+        for (int i = first; i <= last; ++i)
+        {
+            const Diagnostic::Severity severity = bucket->entries[size_t(i)].diagnostic.severity;
+            --bucket->counts[severity];
+            --m_counts[severity];
+        }
+        bucket->entries.erase(bucket->entries.begin() + first, bucket->entries.begin() + last + 1);
+        endRemoveRows();
+        removed = true;
+        last = first - 1;
+    }
+    if (!removed)
+        return;
+
+    bucket->entryByHash.clear();
+    for (int i = 0; i < int(bucket->entries.size()); ++i)
+        bucket->entryByHash.insert(bucket->entries[size_t(i)].hash, i);
+    emit dataChanged(parent, index(bucket->row, ColumnCount - 1));
+}
+
+void DiagnosticsStore::removeFile(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    const FileBucket *bucket = m_files[size_t(row)].get();
+    for (int severity = 0; severity < Diagnostic::SeverityCount; ++severity)
+        m_counts[severity] -= bucket->counts[severity];
+    m_fileBuckets.remove(bucket->file);
+    m_files.erase(m_files.begin() + row);
+    for (size_t i = size_t(row); i < m_files.size(); ++i)
+        m_files[i]->row = int(i);
+    endRemoveRows();
+}
+
+QString DiagnosticsStore::sourcesText(const SourceSet &sources) const
+{
+    QStringList names;
+    for (int i = 0; i < int(m_sources.size()); ++i)
+    {
+        if (sources.contains(i))
+            names.append(m_sources.at(i));
+    }
+    return names.join(QStringLiteral(", "));
+}
+
+// ---------------------------------------------------------------------------
+// Model
+// ---------------------------------------------------------------------------
+QModelIndex DiagnosticsStore::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column < 0 || column >= ColumnCount)
+        return QModelIndex();
+    if (!parent.isValid())
+        return row < fileCount() ? createIndex(row, column) : QModelIndex();
+    // File rows have no internal pointer; diagnostic rows point at their file
+    if (parent.internalPointer() || parent.row() >= fileCount())
+        return QModelIndex();
+    const FileBucket *bucket = m_files[size_t(parent.row())].get();
+    if (row >= int(bucket->entries.size()))
+        return QModelIndex();
+    return createIndex(row, column, bucket);
+}
+
+QModelIndex DiagnosticsStore::parent(const QModelIndex &child) const
+{
+    const auto *bucket = static_cast<const FileBucket *>(child.internalPointer());
+    if (!child.isValid() || !bucket)
+        return QModelIndex();
+    return createIndex(bucket->row, 0);
+}
+
+int DiagnosticsStore::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return fileCount();
+    if (parent.internalPointer() || parent.column() != 0)
+        return 0;
+    return int(m_files[size_t(parent.row())]->entries.size());
+}
+
+int DiagnosticsStore::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+QVariant DiagnosticsStore::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const auto *bucket = static_cast<const FileBucket *>(index.internalPointer());
+    if (!bucket)
+    {
+        const FileBucket &file = *m_files[size_t(index.row())];
+        switch (role)
+        {
+        case Qt::DisplayRole:
+            if (index.column() == FileColumn)
+                return file.file;
+            if (index.column() == MessageColumn)
+                return tr("%n problem(s)", nullptr, int(file.entries.size()));
+            return QVariant();
+        case Qt::ToolTipRole:
+        case FileRole:
+            return file.file;
+        default:
+            return QVariant();
+        }
+    }
+
+    const Entry &entry = bucket->entries[size_t(index.row())];
+    const Diagnostic &diagnostic = entry.diagnostic;
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        switch (index.column())
+        {
+        case FileColumn:
+            return severityText(diagnostic.severity);
+        case LineColumn:
+            if (diagnostic.line <= 0)
+                return QVariant();
+            return diagnostic.column > 0 ? QStringLiteral("%1:%2").arg(diagnostic.line).arg(diagnostic.column)
+                                         : QString::number(diagnostic.line);
+        case MessageColumn:
+            return diagnostic.code.isEmpty() ? diagnostic.message
+                                             : QStringLiteral("%1 [%2]").arg(diagnostic.message, diagnostic.code);
+        default:
+            return QVariant();
+        }
+    case Qt::ForegroundRole:
+        if (index.column() == FileColumn)
+            return QBrush(SeverityColors[diagnostic.severity]);
+        return QVariant();
+    case Qt::ToolTipRole:
+        return tr("%1\nReported by %2").arg(diagnostic.message, sourcesText(entry.sources));
+    case SeverityRole:
+        return int(diagnostic.severity);
+    case FileRole:
+        return diagnostic.file;
+    case LineRole:
+        return diagnostic.line;
+    case ColumnRole:
+        return diagnostic.column;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant DiagnosticsStore::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section)
+    {
+    case FileColumn:
+        return tr("File");
+    case LineColumn:
+        return tr("Line");
+    case MessageColumn:
+        return tr("Message");
+    default:
+        return QVariant();
+    }
+}
+} // namespace ide_shell
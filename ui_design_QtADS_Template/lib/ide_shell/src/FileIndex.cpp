@@ -0,0 +1,1157 @@
+#include "IdeShell/FileIndex.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char IndexMagic[8] = {'Q', 'O', 'P', 'E', 'N', 'I', 'D', 'X'};
+constexpr quint32 IndexVersion = 2;
+
+// Trigrams are three case-folded bytes, so 2^24 possible keys
+constexpr quint32 TrigramSpace = 1u << 24;
+
+// Per-query work limits; candidates come shortest path first, so the
+// best matches are almost always among the first ones verified
+constexpr int ScanBudget = 100000;
+constexpr int MatchBudget = 2000;
+
+// The overlay is folded into a rebuilt index once it gets this large
+constexpr int OverlayRebuildMinimum = 4096;
+
+constexpr int ChangeDelayMs = 150;
+// Events buffered while crawls run; past this a full crawl is cheaper
+constexpr int MaxBufferedEvents = 65536;
+constexpr int FallbackRescanDelayMs = 1000;
+constexpr int MaxFallbackWatches = 4096;
+
+const char *const SkippedDirectories[] = {".git", ".hg", ".svn"};
+
+struct IndexHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 pathCount;
+    quint32 trigramCount;
+    quint32 rootSize;
+    quint64 rootOffset;
+    quint64 blobOffset;        // relative paths, UTF-8, back to back
+    quint64 blobSize;
+    quint64 pathOffsetsOffset; // quint32[pathCount + 1] into the blob
+    quint64 trigramsOffset;    // TrigramEntry[trigramCount + 1], sorted by key
+    quint64 postingsOffset;    // quint32 path ids, ascending within a trigram
+    quint64 postingCount;
+    quint64 sortedIdsOffset;   // quint32[pathCount], ids in byte order of their paths
+    quint64 fileSize;
+};
+
+struct TrigramEntry
+{
+    quint32 key;
+    quint32 first; // postings of this key end where the next entry's begin
+};
+
+#if defined(Q_OS_LINUX)
+constexpr quint32 WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+#endif
+
+uchar fold(uchar c)
+{
+    return (c >= 'A' && c <= 'Z') ? uchar(c | 0x20) : c;
+}
+
+quint32 trigramKey(const char *p)
+{
+    return quint32(fold(uchar(p[0]))) << 16 | quint32(fold(uchar(p[1]))) << 8 | fold(uchar(p[2]));
+}
+
+quint64 align8(quint64 value)
+{
+    return (value + 7) & ~quint64(7);
+}
+
+bool isSkippedDirectory(const QByteArray &name)
+{
+    return std::any_of(std::begin(SkippedDirectories), std::end(SkippedDirectories),
+                       [&](const char *skipped) { return name == skipped; });
+}
+
+// Shorter paths first, so that ids in ascending order are roughly best-first
+bool pathLess(const QByteArray &a, const QByteArray &b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size();
+    return a < b;
+}
+
+void distinctTrigrams(const char *data, qsizetype size, std::vector<quint32> *trigrams)
+{
+    trigrams->clear();
+    for (qsizetype i = 0; i + 3 <= size; ++i)
+        trigrams->push_back(trigramKey(data + i));
+    std::sort(trigrams->begin(), trigrams->end());
+    trigrams->erase(std::unique(trigrams->begin(), trigrams->end()), trigrams->end());
+}
+
+// Byte order, in which all paths below a directory are adjacent
+int compareBytes(const char *a, qsizetype sizeA, const char *b, qsizetype sizeB)
+{
+    const int order = std::memcmp(a, b, size_t(qMin(sizeA, sizeB)));
+    if (order != 0)
+        return order;
+    return sizeA < sizeB ? -1 : (sizeA > sizeB ? 1 : 0);
+}
+
+// Case-insensitive search; token is already lower-case
+qsizetype findFolded(const char *data, qsizetype size, const QByteArray &token)
+{
+    const qsizetype length = token.size();
+    for (qsizetype i = 0; i + length <= size; ++i)
+    {
+        qsizetype j = 0;
+        while (j < length && fold(uchar(data[i + j])) == uchar(token.at(j)))
+            ++j;
+        if (j == length)
+            return i;
+    }
+    return -1;
+}
+
+bool isWordSeparator(char c)
+{
+    return c == '.' || c == '_' || c == '-' || c == ' ';
+}
+
+// Every token must occur in the path. Hits in the file name, at its start
+// or at a word start score higher; shorter paths win ties.
+bool scorePath(const char *path, qsizetype size, const QVector<QByteArray> &tokens, int *score)
+{
+    qsizetype nameStart = size;
+    while (nameStart > 0 && path[nameStart - 1] != '/')
+        --nameStart;
+    const qsizetype nameSize = size - nameStart;
+
+    int total = 0;
+    for (const QByteArray &token : tokens)
+    {
+        const qsizetype inName = findFolded(path + nameStart, nameSize, token);
+        if (inName >= 0)
+        {
+            total += 100;
+            if (inName == 0)
+                total += 60;
+            else if (isWordSeparator(path[nameStart + inName - 1]))
+                total += 30;
+            if (tokens.size() == 1 && token.size() == nameSize)
+                total += 200;
+            continue;
+        }
+        const qsizetype inPath = findFolded(path, size, token);
+        if (inPath < 0)
+            return false;
+        total += (inPath == 0 || path[inPath - 1] == '/') ? 20 : 10;
+    }
+    *score = total * 8 - int(qMin<qsizetype>(size, 4096));
+    return true;
+}
+
+// First element >= value in a sorted range, probing 1, 2, 4, ... ahead
+const quint32 *gallop(const quint32 *begin, const quint32 *end, quint32 value)
+{
+    if (begin == end || *begin >= value)
+        return begin;
+    const quint32 *low = begin;
+    qsizetype step = 1;
+    while (step < end - low && low[step] < value)
+    {
+        low += step;
+        step *= 2;
+    }
+    return std::lower_bound(low + 1, low + qMin<qsizetype>(step + 1, end - low), value);
+}
+
+struct CrawlResult
+{
+    QVector<QByteArray> paths;         // relative to the root
+    QHash<int, QByteArray> watches;    // inotify watch descriptor -> relative directory
+    QStringList directories;           // absolute, for the fallback watcher
+};
+
+// Lists all files below root/start (start is relative, may be empty) and
+// registers an inotify watch per directory if inotifyFd is valid
+CrawlResult crawlTree(const QString &root, const QByteArray &start, int inotifyFd, bool listDirectories,
+                      const std::atomic_bool &cancelled)
+{
+    CrawlResult result;
+    std::vector<QByteArray> pending{start};
+    bool warnedAboutWatches = false;
+    while (!pending.empty() && !cancelled.load(std::memory_order_relaxed))
+    {
+        const QByteArray relative = std::move(pending.back());
+        pending.pop_back();
+        const QString absolute = relative.isEmpty() ? root : root + QLatin1Char('/') + QString::fromUtf8(relative);
+
+#if defined(Q_OS_LINUX)
+        if (inotifyFd >= 0)
+        {
+            const int wd = ::inotify_add_watch(inotifyFd, QFile::encodeName(absolute).constData(), WatchMask);
+            if (wd >= 0)
+            {
+                result.watches.insert(wd, relative);
+            }
+            else if (errno == ENOSPC && !warnedAboutWatches)
+            {
+                qWarning() << "FileIndex: inotify watch limit reached, some directories are not watched"
+                           << "(see fs.inotify.max_user_watches)";
+                warnedAboutWatches = true;
+            }
+        }
+#else
+        Q_UNUSED(inotifyFd);
+        Q_UNUSED(warnedAboutWatches);
+#endif
+        if (listDirectories)
+            result.directories.append(absolute);
+
+        QDirIterator it(absolute, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks);
+        while (it.hasNext())
+        {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QByteArray name = info.fileName().toUtf8();
+            const QByteArray path = relative.isEmpty() ? name : relative + '/' + name;
+            if (!info.isDir())
+                result.paths.append(path);
+            else if (!isSkippedDirectory(name))
+                pending.push_back(path);
+        }
+    }
+    return result;
+}
+} // namespace
+
+namespace ide_shell
+{
+// ---------------------------------------------------------------------------
+// Immutable trigram index over a sorted path list, either memory-mapped
+// from the cache file or held in a buffer after a build.
+// ---------------------------------------------------------------------------
+class IndexSnapshot
+{
+public:
+    static std::shared_ptr<IndexSnapshot> load(const QString &filePath, const QByteArray &rootPath);
+    static std::shared_ptr<IndexSnapshot> build(const QVector<QByteArray> &paths, const QByteArray &rootPath,
+                                                const std::atomic_bool &cancelled);
+
+    bool save(const QString &filePath) const;
+
+    int pathCount() const { return int(m_header->pathCount); }
+
+    const char *pathData(int id, qsizetype *size) const
+    {
+        *size = qsizetype(m_offsets[id + 1] - m_offsets[id]);
+        return m_blob + m_offsets[id];
+    }
+
+    QByteArray pathAt(int id) const
+    {
+        qsizetype size = 0;
+        const char *data = pathData(id, &size);
+        return QByteArray(data, size);
+    }
+
+    int indexOf(const QByteArray &path) const;
+    // Ids of all paths starting with prefix, in O(log n + matches)
+    QVector<int> idsWithPrefix(const QByteArray &prefix) const;
+    bool hasSamePaths(const QVector<QByteArray> &paths) const;
+
+    // Scores of up to MatchBudget matching paths, as (score, id)
+    QVector<std::pair<int, int>> match(const QVector<QByteArray> &tokens, const std::vector<bool> &removed) const;
+
+private:
+    bool attach(const uchar *data, quint64 size, const QByteArray &rootPath);
+
+    QFile m_file;
+    std::vector<quint64> m_buffer; // when not mapped; quint64 keeps the sections aligned
+    quint64 m_size = 0;
+    const IndexHeader *m_header = nullptr;
+    const char *m_blob = nullptr;
+    const quint32 *m_offsets = nullptr;
+    const TrigramEntry *m_trigrams = nullptr;
+    const quint32 *m_postings = nullptr;
+    const quint32 *m_sortedIds = nullptr;
+};
+
+std::shared_ptr<IndexSnapshot> IndexSnapshot::load(const QString &filePath, const QByteArray &rootPath)
+{
+    auto snapshot = std::make_shared<IndexSnapshot>();
+    snapshot->m_file.setFileName(filePath);
+    if (!snapshot->m_file.open(QIODevice::ReadOnly))
+        return nullptr;
+    const qint64 size = snapshot->m_file.size();
+    const uchar *data = size > 0 ? snapshot->m_file.map(0, size) : nullptr;
+    if (!data || !snapshot->attach(data, quint64(size), rootPath))
+    {
+        if (data)
+            qWarning() << "FileIndex: ignoring invalid or outdated index" << filePath;
+        return nullptr;
+    }
+    return snapshot;
+}
+
+bool IndexSnapshot::attach(const uchar *data, quint64 size, const QByteArray &rootPath)
+{
+    if (size < sizeof(IndexHeader) || quintptr(data) % 8 != 0)
+        return false;
+    const auto *header = reinterpret_cast<const IndexHeader *>(data);
+    if (std::memcmp(header->magic, IndexMagic, sizeof(IndexMagic)) != 0 || header->version != IndexVersion
+        || header->fileSize != size)
+        return false;
+
+    const auto fits = [size](quint64 offset, quint64 bytes, quint64 alignment) {
+        return offset % alignment == 0 && offset <= size && bytes <= size - offset;
+    };
+    if (!fits(header->rootOffset, header->rootSize, 1) || !fits(header->blobOffset, header->blobSize, 1)
+        || !fits(header->pathOffsetsOffset, (quint64(header->pathCount) + 1) * sizeof(quint32), sizeof(quint32))
+        || !fits(header->trigramsOffset, (quint64(header->trigramCount) + 1) * sizeof(TrigramEntry), sizeof(quint32))
+        || !fits(header->postingsOffset, header->postingCount * sizeof(quint32), sizeof(quint32))
+        || !fits(header->sortedIdsOffset, quint64(header->pathCount) * sizeof(quint32), sizeof(quint32)))
+        return false;
+
+    const QByteArray storedRoot = QByteArray::fromRawData(reinterpret_cast<const char *>(data) + header->rootOffset,
+                                                          qsizetype(header->rootSize));
+    if (storedRoot != rootPath)
+        return false;
+
+    const auto *offsets = reinterpret_cast<const quint32 *>(data + header->pathOffsetsOffset);
+    const auto *trigrams = reinterpret_cast<const TrigramEntry *>(data + header->trigramsOffset);
+    if (offsets[0] != 0 || offsets[header->pathCount] != header->blobSize
+        || trigrams[header->trigramCount].first != header->postingCount)
+        return false;
+    for (quint32 i = 0; i < header->pathCount; ++i)
+    {
+        if (offsets[i] > offsets[i + 1])
+            return false;
+    }
+    for (quint32 i = 0; i < header->trigramCount; ++i)
+    {
+        if (trigrams[i].first > trigrams[i + 1].first || trigrams[i].key >= trigrams[i + 1].key)
+            return false;
+    }
+    const auto *sortedIds = reinterpret_cast<const quint32 *>(data + header->sortedIdsOffset);
+    for (quint32 i = 0; i < header->pathCount; ++i)
+    {
+        if (sortedIds[i] >= header->pathCount)
+            return false;
+    }
+
+    m_size = size;
+    m_header = header;
+    m_blob = reinterpret_cast<const char *>(data) + header->blobOffset;
+    m_offsets = offsets;
+    m_trigrams = trigrams;
+    m_postings = reinterpret_cast<const quint32 *>(data + header->postingsOffset);
+    m_sortedIds = sortedIds;
+    return true;
+}
+
+std::shared_ptr<IndexSnapshot> IndexSnapshot::build(const QVector<QByteArray> &paths, const QByteArray &rootPath,
+                                                    const std::atomic_bool &cancelled)
+{
+    quint64 blobSize = 0;
+    for (const QByteArray &path : paths)
+        blobSize += quint64(path.size());
+    if (blobSize > 0xFFFFFFFFu)
+    {
+        qWarning() << "FileIndex: too many paths to index" << paths.size();
+        return nullptr;
+    }
+
+    // Pass 1: posting list length per trigram. calloc leaves untouched pages
+    // of the 64 MiB table unbacked, so small trees stay cheap.
+    std::unique_ptr<quint32, decltype(&std::free)> counts(
+        static_cast<quint32 *>(std::calloc(TrigramSpace, sizeof(quint32))), &std::free);
+    if (!counts)
+        return nullptr;
+    std::vector<quint32> trigrams;
+    quint64 postingCount = 0;
+    for (int id = 0; id < paths.size(); ++id)
+    {
+        if (id % 4096 == 0 && cancelled.load(std::memory_order_relaxed))
+            return nullptr;
+        distinctTrigrams(paths[id].constData(), paths[id].size(), &trigrams);
+        for (const quint32 key : trigrams)
+            ++counts.get()[key];
+        postingCount += trigrams.size();
+    }
+    if (postingCount > 0xFFFFFFFFu)
+    {
+        qWarning() << "FileIndex: too many paths to index" << paths.size();
+        return nullptr;
+    }
+    quint32 trigramCount = 0;
+    for (quint32 key = 0; key < TrigramSpace; ++key)
+        trigramCount += counts.get()[key] != 0;
+
+    // Layout, every section 8-byte aligned
+    IndexHeader header = {};
+    std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+    header.version = IndexVersion;
+    header.pathCount = quint32(paths.size());
+    header.trigramCount = trigramCount;
+    header.rootSize = quint32(rootPath.size());
+    header.rootOffset = sizeof(IndexHeader);
+    header.blobOffset = align8(header.rootOffset + header.rootSize);
+    header.blobSize = blobSize;
+    header.pathOffsetsOffset = align8(header.blobOffset + blobSize);
+    header.trigramsOffset = align8(header.pathOffsetsOffset + (quint64(paths.size()) + 1) * sizeof(quint32));
+    header.postingsOffset = align8(header.trigramsOffset + (quint64(trigramCount) + 1) * sizeof(TrigramEntry));
+    header.postingCount = postingCount;
+    header.sortedIdsOffset = align8(header.postingsOffset + postingCount * sizeof(quint32));
+    header.fileSize = align8(header.sortedIdsOffset + quint64(paths.size()) * sizeof(quint32));
+
+    auto snapshot = std::make_shared<IndexSnapshot>();
+    snapshot->m_buffer.assign(size_t(header.fileSize / sizeof(quint64)), 0);
+    char *data = reinterpret_cast<char *>(snapshot->m_buffer.data());
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + header.rootOffset, rootPath.constData(), size_t(rootPath.size()));
+
+    auto *offsets = reinterpret_cast<quint32 *>(data + header.pathOffsetsOffset);
+    quint32 blobPosition = 0;
+    for (int id = 0; id < paths.size(); ++id)
+    {
+        offsets[id] = blobPosition;
+        std::memcpy(data + header.blobOffset + blobPosition, paths[id].constData(), size_t(paths[id].size()));
+        blobPosition += quint32(paths[id].size());
+    }
+    offsets[paths.size()] = blobPosition;
+
+    // The counts become write cursors into the postings
+    auto *entries = reinterpret_cast<TrigramEntry *>(data + header.trigramsOffset);
+    quint32 entry = 0;
+    quint32 running = 0;
+    for (quint32 key = 0; key < TrigramSpace; ++key)
+    {
+        const quint32 count = counts.get()[key];
+        if (!count)
+            continue;
+        entries[entry++] = TrigramEntry{key, running};
+        counts.get()[key] = running;
+        running += count;
+    }
+    entries[entry] = TrigramEntry{TrigramSpace, running};
+
+    // Pass 2: ids are visited in ascending order, so every list comes out sorted
+    auto *postings = reinterpret_cast<quint32 *>(data + header.postingsOffset);
+    for (int id = 0; id < paths.size(); ++id)
+    {
+        if (id % 4096 == 0 && cancelled.load(std::memory_order_relaxed))
+            return nullptr;
+        distinctTrigrams(paths[id].constData(), paths[id].size(), &trigrams);
+        for (const quint32 key : trigrams)
+            postings[counts.get()[key]++] = quint32(id);
+    }
+
+    auto *sortedIds = reinterpret_cast<quint32 *>(data + header.sortedIdsOffset);
+    std::iota(sortedIds, sortedIds + paths.size(), 0u);
+    std::sort(sortedIds, sortedIds + paths.size(), [&paths](quint32 a, quint32 b) {
+        return compareBytes(paths[int(a)].constData(), paths[int(a)].size(), paths[int(b)].constData(),
+                            paths[int(b)].size()) < 0;
+    });
+
+    if (!snapshot->attach(reinterpret_cast<const uchar *>(data), header.fileSize, rootPath))
+        return nullptr;
+    return snapshot;
+}
+
+bool IndexSnapshot::save(const QString &filePath) const
+{
+    if (m_buffer.empty())
+        return false;
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    const qint64 size = qint64(m_size);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char *>(m_buffer.data()), size) != size || !file.commit())
+    {
+        qWarning() << "FileIndex: could not write" << filePath << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+int IndexSnapshot::indexOf(const QByteArray &path) const
+{
+    // Same order as pathLess(): by length, then bytes
+    int low = 0;
+    int high = pathCount();
+    while (low < high)
+    {
+        const int mid = low + (high - low) / 2;
+        qsizetype size = 0;
+        const char *data = pathData(mid, &size);
+        int order = size < path.size() ? -1 : (size > path.size() ? 1 : 0);
+        if (order == 0)
+            order = std::memcmp(data, path.constData(), size_t(size));
+        if (order == 0)
+            return mid;
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return -1;
+}
+
+QVector<int> IndexSnapshot::idsWithPrefix(const QByteArray &prefix) const
+{
+    QVector<int> ids;
+    const quint32 *end = m_sortedIds + pathCount();
+    const quint32 *it = std::lower_bound(m_sortedIds, end, prefix, [this](quint32 id, const QByteArray &value) {
+        qsizetype size = 0;
+        const char *data = pathData(int(id), &size);
+        return compareBytes(data, size, value.constData(), value.size()) < 0;
+    });
+    for (; it != end; ++it)
+    {
+        qsizetype size = 0;
+        const char *data = pathData(int(*it), &size);
+        if (size < prefix.size() || std::memcmp(data, prefix.constData(), size_t(prefix.size())) != 0)
+            break;
+        ids.append(int(*it));
+    }
+    return ids;
+}
+
+bool IndexSnapshot::hasSamePaths(const QVector<QByteArray> &paths) const
+{
+    if (paths.size() != pathCount())
+        return false;
+    for (int id = 0; id < paths.size(); ++id)
+    {
+        qsizetype size = 0;
+        const char *data = pathData(id, &size);
+        if (size != paths[id].size() || std::memcmp(data, paths[id].constData(), size_t(size)) != 0)
+            return false;
+    }
+    return true;
+}
+
+QVector<std::pair<int, int>> IndexSnapshot::match(const QVector<QByteArray> &tokens,
+                                                  const std::vector<bool> &removed) const
+{
+    QVector<std::pair<int, int>> matches;
+
+    // Posting lists of all trigrams of all tokens; a path must be in each
+    std::vector<std::pair<const quint32 *, const quint32 *>> lists;
+    for (const QByteArray &token : tokens)
+    {
+        for (qsizetype i = 0; i + 3 <= token.size(); ++i)
+        {
+            const quint32 key = trigramKey(token.constData() + i);
+            const TrigramEntry *end = m_trigrams + m_header->trigramCount;
+            const TrigramEntry *entry = std::lower_bound(
+                m_trigrams, end, key, [](const TrigramEntry &e, quint32 k) { return e.key < k; });
+            if (entry == end || entry->key != key)
+                return matches;
+            lists.emplace_back(m_postings + entry->first, m_postings + entry[1].first);
+        }
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto &a, const auto &b) {
+        const auto sizeA = a.second - a.first;
+        const auto sizeB = b.second - b.first;
+        return sizeA != sizeB ? sizeA < sizeB : a.first < b.first;
+    });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    int scanned = 0;
+    const auto consider = [&](quint32 id) {
+        ++scanned;
+        if (id >= m_header->pathCount || (id < removed.size() && removed[id]))
+            return;
+        qsizetype size = 0;
+        const char *path = pathData(int(id), &size);
+        int score = 0;
+        if (scorePath(path, size, tokens, &score))
+            matches.append({score, int(id)});
+    };
+
+    if (lists.empty())
+    {
+        // Only short tokens: no trigram to narrow down with
+        for (quint32 id = 0; id < m_header->pathCount && scanned < ScanBudget && matches.size() < MatchBudget; ++id)
+            consider(id);
+        return matches;
+    }
+
+    // Intersect, driven by the shortest list
+    std::vector<const quint32 *> cursors(lists.size());
+    for (size_t l = 0; l < lists.size(); ++l)
+        cursors[l] = lists[l].first;
+    for (const quint32 *it = lists[0].first; it != lists[0].second; ++it)
+    {
+        const quint32 id = *it;
+        bool inAll = true;
+        for (size_t l = 1; l < lists.size() && inAll; ++l)
+        {
+            cursors[l] = gallop(cursors[l], lists[l].second, id);
+            inAll = cursors[l] != lists[l].second && *cursors[l] == id;
+        }
+        if (!inAll)
+            continue;
+        consider(id);
+        if (scanned >= ScanBudget || matches.size() >= MatchBudget)
+            break;
+    }
+    return matches;
+}
+
+// ---------------------------------------------------------------------------
+// FileIndex
+// ---------------------------------------------------------------------------
+FileIndex::FileIndex(QObject *parent)
+    : QObject(parent)
+{
+    m_changeTimer = new QTimer(this);
+    m_changeTimer->setSingleShot(true);
+    connect(m_changeTimer, &QTimer::timeout, this, &FileIndex::onChangeTimeout);
+}
+
+FileIndex::~FileIndex()
+{
+    if (m_cancelled)
+        m_cancelled->store(true);
+    if (m_directoryCrawlsCancelled)
+        m_directoryCrawlsCancelled->store(true);
+    stopWatching();
+}
+
+void FileIndex::setRootPath(const QString &path)
+{
+    const QString root = path.isEmpty() ? QString() : QDir::cleanPath(QDir(path).absolutePath());
+    if (root == m_rootPath)
+        return;
+
+    if (m_cancelled)
+    {
+        m_cancelled->store(true);
+        m_cancelled.reset();
+        emit indexingChanged(false);
+    }
+    if (m_directoryCrawlsCancelled)
+        m_directoryCrawlsCancelled->store(true);
+    m_directoryCrawlsCancelled = std::make_shared<std::atomic_bool>(false);
+    m_directoryCrawls = 0;
+    ++m_generation;
+    stopWatching();
+    m_rescanPending = false;
+    m_fallbackDirty = false;
+    m_addedPaths.clear();
+    m_removedPaths.clear();
+    m_removedIds.clear();
+    m_snapshot.reset();
+    m_rootPath = root;
+
+    if (!m_rootPath.isEmpty())
+    {
+        // Answer queries from the last session's index until the crawl is done
+        m_snapshot = IndexSnapshot::load(cacheFilePath(m_rootPath), m_rootPath.toUtf8());
+        if (m_snapshot)
+            m_removedIds.assign(size_t(m_snapshot->pathCount()), false);
+
+#if defined(Q_OS_LINUX)
+        m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotifyFd >= 0)
+        {
+            m_inotifyNotifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+            connect(m_inotifyNotifier, &QSocketNotifier::activated, this, &FileIndex::readInotifyEvents);
+        }
+        else
+        {
+            qWarning() << "FileIndex: inotify unavailable, using QFileSystemWatcher";
+        }
+#endif
+        if (m_inotifyFd < 0)
+        {
+            m_fallbackWatcher = new QFileSystemWatcher(this);
+            connect(m_fallbackWatcher, &QFileSystemWatcher::directoryChanged, this, [this]()
+            {
+                m_fallbackDirty = true;
+                m_changeTimer->start(FallbackRescanDelayMs);
+            });
+        }
+        startCrawl();
+    }
+    emit indexChanged();
+}
+
+QString FileIndex::rootPath() const
+{
+    return m_rootPath;
+}
+
+int FileIndex::fileCount() const
+{
+    const int indexed = m_snapshot ? m_snapshot->pathCount() : 0;
+    return indexed - m_removedPaths.size() + m_addedPaths.size();
+}
+
+bool FileIndex::isIndexing() const
+{
+    return m_cancelled != nullptr;
+}
+
+QString FileIndex::cacheFilePath(const QString &rootPath)
+{
+    const QByteArray hash = QCryptographicHash::hash(rootPath.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/quick-open/")
+           + QString::fromLatin1(hash) + QStringLiteral(".idx");
+}
+
+QVector<FileMatch> FileIndex::find(const QString &query, int limit) const
+{
+    QVector<FileMatch> result;
+    QVector<QByteArray> tokens;
+    for (const QString &word : query.split(QLatin1Char(' '), Qt::SkipEmptyParts))
+        tokens.append(QDir::fromNativeSeparators(word).toUtf8().toLower());
+    if (tokens.isEmpty() || limit <= 0)
+        return result;
+
+    if (m_snapshot)
+    {
+        QVector<std::pair<int, int>> matches = m_snapshot->match(tokens, m_removedIds);
+        const auto better = [](const std::pair<int, int> &a, const std::pair<int, int> &b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        const int keep = qMin(limit, int(matches.size()));
+        std::partial_sort(matches.begin(), matches.begin() + keep, matches.end(), better);
+        result.reserve(keep + m_addedPaths.size());
+        for (int i = 0; i < keep; ++i)
+            result.append(FileMatch{QString::fromUtf8(m_snapshot->pathAt(matches[i].second)), matches[i].first});
+    }
+
+    for (const QByteArray &path : m_addedPaths)
+    {
+        int score = 0;
+        if (scorePath(path.constData(), path.size(), tokens, &score))
+            result.append(FileMatch{QString::fromUtf8(path), score});
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+                     [](const FileMatch &a, const FileMatch &b) { return a.score > b.score; });
+    if (result.size() > limit)
+        result.resize(limit);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Crawling
+// ---------------------------------------------------------------------------
+void FileIndex::startCrawl()
+{
+    if (m_rootPath.isEmpty())
+        return;
+    if (m_cancelled)
+    {
+        m_rescanPending = true;
+        return;
+    }
+    m_rescanPending = false;
+    m_fallbackDirty = false;
+
+    const quint64 generation = m_generation;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_cancelled = cancelled;
+    emit indexingChanged(true);
+
+    // The crawl gets its own descriptor for the same inotify instance, so
+    // it stays valid if the root changes and the original is closed
+    int inotifyFd = -1;
+#if defined(Q_OS_LINUX)
+    if (m_inotifyFd >= 0)
+        inotifyFd = ::fcntl(m_inotifyFd, F_DUPFD_CLOEXEC, 0);
+#endif
+    const bool listDirectories = m_fallbackWatcher != nullptr;
+    const QString root = m_rootPath;
+    const QString cachePath = cacheFilePath(root);
+    std::shared_ptr<const IndexSnapshot> previous = m_snapshot;
+
+    QPointer<FileIndex> guard(this);
+    QThreadPool::globalInstance()->start([guard, generation, cancelled, inotifyFd, listDirectories, root, cachePath,
+                                          previous]()
+    {
+        CrawlResult crawl = crawlTree(root, QByteArray(), inotifyFd, listDirectories, *cancelled);
+#if defined(Q_OS_LINUX)
+        if (inotifyFd >= 0)
+            ::close(inotifyFd);
+#endif
+        if (cancelled->load())
+            return;
+
+        std::sort(crawl.paths.begin(), crawl.paths.end(), pathLess);
+        std::shared_ptr<const IndexSnapshot> snapshot;
+        if (!previous || !previous->hasSamePaths(crawl.paths))
+        {
+            const QByteArray rootUtf8 = root.toUtf8();
+            std::shared_ptr<IndexSnapshot> built = IndexSnapshot::build(crawl.paths, rootUtf8, *cancelled);
+            if (built && built->save(cachePath))
+            {
+                // Prefer the mapped file over the heap copy
+                if (std::shared_ptr<IndexSnapshot> mapped = IndexSnapshot::load(cachePath, rootUtf8))
+                    built = std::move(mapped);
+            }
+            snapshot = std::move(built);
+        }
+
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, generation, snapshot, crawl]()
+        {
+            if (guard)
+                guard->onCrawlFinished(generation, snapshot, crawl.watches, crawl.directories);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileIndex::onCrawlFinished(quint64 generation, std::shared_ptr<const IndexSnapshot> snapshot,
+                                const QHash<int, QByteArray> &watches, const QStringList &directories)
+{
+    if (generation != m_generation || !m_cancelled)
+        return;
+    m_cancelled.reset();
+
+    addWatches(watches);
+    if (m_fallbackWatcher)
+    {
+        const QStringList watched = m_fallbackWatcher->directories();
+        if (!watched.isEmpty())
+            m_fallbackWatcher->removePaths(watched);
+        if (directories.size() > MaxFallbackWatches)
+            qWarning() << "FileIndex: watching only the first" << MaxFallbackWatches << "of" << directories.size()
+                       << "directories";
+        const QStringList toWatch = directories.mid(0, MaxFallbackWatches);
+        if (!toWatch.isEmpty())
+            m_fallbackWatcher->addPaths(toWatch);
+    }
+
+    if (snapshot)
+        adoptSnapshot(std::move(snapshot));
+    replayBufferedEvents();
+    emit indexingChanged(false);
+
+    if (m_rescanPending)
+        startCrawl();
+}
+
+void FileIndex::adoptSnapshot(std::shared_ptr<const IndexSnapshot> snapshot)
+{
+    m_snapshot = std::move(snapshot);
+    m_removedIds.assign(size_t(m_snapshot->pathCount()), false);
+
+    // Changes seen while crawling may or may not be in the new index
+    for (auto it = m_addedPaths.begin(); it != m_addedPaths.end();)
+    {
+        if (m_snapshot->indexOf(*it) >= 0)
+            it = m_addedPaths.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = m_removedPaths.begin(); it != m_removedPaths.end();)
+    {
+        const int id = m_snapshot->indexOf(*it);
+        if (id < 0)
+        {
+            it = m_removedPaths.erase(it);
+            continue;
+        }
+        m_removedIds[size_t(id)] = true;
+        ++it;
+    }
+    emit indexChanged();
+}
+
+// ---------------------------------------------------------------------------
+// Change tracking
+// ---------------------------------------------------------------------------
+void FileIndex::stopWatching()
+{
+    m_changeTimer->stop();
+    delete m_inotifyNotifier;
+    m_inotifyNotifier = nullptr;
+#if defined(Q_OS_LINUX)
+    if (m_inotifyFd >= 0)
+        ::close(m_inotifyFd);
+#endif
+    m_inotifyFd = -1;
+    m_watchDirs.clear();
+    m_dirWatches.clear();
+    m_bufferedEvents.clear();
+    delete m_fallbackWatcher;
+    m_fallbackWatcher = nullptr;
+}
+
+void FileIndex::readInotifyEvents()
+{
+#if defined(Q_OS_LINUX)
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool overflowed = false;
+    for (;;)
+    {
+        const ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        for (const char *p = buffer; p < buffer + length;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflowed = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED)
+            {
+                forgetWatch(event->wd);
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+
+            WatchEvent watchEvent{event->wd, event->mask, QFile::decodeName(event->name).toUtf8()};
+            if (m_watchDirs.contains(event->wd))
+            {
+                handleEvent(watchEvent);
+            }
+            else if (m_cancelled || m_directoryCrawls > 0)
+            {
+                // From a watch that a running crawl has not handed over yet
+                if (m_bufferedEvents.size() < MaxBufferedEvents)
+                    m_bufferedEvents.append(std::move(watchEvent));
+                else
+                    overflowed = true;
+            }
+        }
+    }
+    // Events were lost; only a full crawl can tell what changed
+    if (overflowed)
+        startCrawl();
+#endif
+}
+
+void FileIndex::handleEvent(const WatchEvent &event)
+{
+#if defined(Q_OS_LINUX)
+    const auto dir = m_watchDirs.constFind(event.wd);
+    if (dir == m_watchDirs.constEnd())
+        return;
+
+    const QByteArray relative = dir->isEmpty() ? event.name : *dir + '/' + event.name;
+    const bool isDir = event.mask & IN_ISDIR;
+    if (isDir && isSkippedDirectory(event.name))
+        return;
+    if (event.mask & (IN_CREATE | IN_MOVED_TO))
+    {
+        if (isDir)
+            addDirectory(relative);
+        else
+            addPath(relative);
+    }
+    else if (event.mask & (IN_DELETE | IN_MOVED_FROM))
+    {
+        if (isDir)
+            removeDirectory(relative);
+        else
+            removePath(relative);
+    }
+#else
+    Q_UNUSED(event);
+#endif
+}
+
+void FileIndex::replayBufferedEvents()
+{
+    QVector<WatchEvent> events;
+    events.swap(m_bufferedEvents);
+    for (const WatchEvent &event : events)
+    {
+        if (m_watchDirs.contains(event.wd))
+            handleEvent(event);
+        else if (m_cancelled || m_directoryCrawls > 0)
+            m_bufferedEvents.append(event);
+    }
+}
+
+void FileIndex::addWatches(const QHash<int, QByteArray> &watches)
+{
+    if (m_inotifyFd < 0)
+        return;
+    for (auto it = watches.constBegin(); it != watches.constEnd(); ++it)
+    {
+        // A directory renamed within the tree keeps its watch descriptor
+        forgetWatch(it.key());
+        m_watchDirs.insert(it.key(), it.value());
+        m_dirWatches.insert(it.value(), it.key());
+    }
+}
+
+void FileIndex::forgetWatch(int wd)
+{
+    const auto it = m_watchDirs.find(wd);
+    if (it == m_watchDirs.end())
+        return;
+    const auto dir = m_dirWatches.find(*it);
+    if (dir != m_dirWatches.end() && *dir == wd)
+        m_dirWatches.erase(dir);
+    m_watchDirs.erase(it);
+}
+
+void FileIndex::addPath(const QByteArray &relativePath)
+{
+    if (m_removedPaths.remove(relativePath))
+    {
+        m_removedIds[size_t(m_snapshot->indexOf(relativePath))] = false;
+    }
+    else if (!m_snapshot || m_snapshot->indexOf(relativePath) < 0)
+    {
+        m_addedPaths.insert(relativePath);
+    }
+    m_changeTimer->start(ChangeDelayMs);
+}
+
+void FileIndex::removePath(const QByteArray &relativePath)
+{
+    if (!m_addedPaths.remove(relativePath) && m_snapshot)
+    {
+        const int id = m_snapshot->indexOf(relativePath);
+        if (id >= 0 && !m_removedIds[size_t(id)])
+        {
+            m_removedIds[size_t(id)] = true;
+            m_removedPaths.insert(relativePath);
+        }
+    }
+    m_changeTimer->start(ChangeDelayMs);
+}
+
+void FileIndex::addDirectory(const QByteArray &relativePath)
+{
+    // A directory moved in from elsewhere arrives with its contents. They
+    // are listed on the thread pool; events from the new watches are
+    // buffered until onDirectoryCrawled() hands the watches over.
+    int inotifyFd = -1;
+#if defined(Q_OS_LINUX)
+    if (m_inotifyFd >= 0)
+        inotifyFd = ::fcntl(m_inotifyFd, F_DUPFD_CLOEXEC, 0);
+#endif
+    ++m_directoryCrawls;
+    const quint64 generation = m_generation;
+    const QString root = m_rootPath;
+    std::shared_ptr<std::atomic_bool> cancelled = m_directoryCrawlsCancelled;
+
+    QPointer<FileIndex> guard(this);
+    QThreadPool::globalInstance()->start([guard, generation, cancelled, inotifyFd, root, relativePath]()
+    {
+        const CrawlResult crawl = crawlTree(root, relativePath, inotifyFd, false, *cancelled);
+#if defined(Q_OS_LINUX)
+        if (inotifyFd >= 0)
+            ::close(inotifyFd);
+#endif
+        if (cancelled->load())
+            return;
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, generation, crawl]()
+        {
+            if (guard)
+                guard->onDirectoryCrawled(generation, crawl.paths, crawl.watches);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileIndex::onDirectoryCrawled(quint64 generation, const QVector<QByteArray> &paths,
+                                   const QHash<int, QByteArray> &watches)
+{
+    if (generation != m_generation)
+        return;
+    --m_directoryCrawls;
+    addWatches(watches);
+    for (const QByteArray &path : paths)
+        addPath(path);
+    replayBufferedEvents();
+    m_changeTimer->start(ChangeDelayMs);
+}
+
+void FileIndex::removeDirectory(const QByteArray &relativePath)
+{
+    const QByteArray prefix = relativePath + '/';
+    if (m_snapshot)
+    {
+        for (const int id : m_snapshot->idsWithPrefix(prefix))
+        {
+            if (m_removedIds[size_t(id)])
+                continue;
+            m_removedIds[size_t(id)] = true;
+            m_removedPaths.insert(m_snapshot->pathAt(id));
+        }
+    }
+    for (auto it = m_addedPaths.begin(); it != m_addedPaths.end();)
+    {
+        if (it->startsWith(prefix))
+            it = m_addedPaths.erase(it);
+        else
+            ++it;
+    }
+
+    // Watches of a moved-away directory would report under the old name
+    QVector<int> watches;
+    const auto self = m_dirWatches.constFind(relativePath);
+    if (self != m_dirWatches.constEnd())
+        watches.append(*self);
+    for (auto it = m_dirWatches.lowerBound(prefix); it != m_dirWatches.end() && it.key().startsWith(prefix); ++it)
+        watches.append(*it);
+    for (const int wd : watches)
+    {
+#if defined(Q_OS_LINUX)
+        ::inotify_rm_watch(m_inotifyFd, wd);
+#endif
+        forgetWatch(wd);
+    }
+    m_changeTimer->start(ChangeDelayMs);
+}
+
+void FileIndex::onChangeTimeout()
+{
+    if (m_fallbackDirty)
+    {
+        startCrawl();
+        return;
+    }
+    emit indexChanged();
+
+    // Fold a large overlay back into the mapped index
+    const int indexed = m_snapshot ? m_snapshot->pathCount() : 0;
+    if (m_addedPaths.size() + m_removedPaths.size() > qMax(OverlayRebuildMinimum, indexed / 8))
+        startCrawl();
+}
+} // namespace ide_shell
@@ -1,5 +1,8 @@
 #include "IdeShell/IdeShellWindow.h"
 
+#include "IdeShell/FileIndex.h"
+#include "IdeShell/QuickOpenPopup.h"
+
 #include <QAbstractButton>
 #include <QEvent>
 #include <QHBoxLayout>
@@ -8,6 +11,7 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QShortcut>
 #include <QStringList>
 #include <QToolButton>
 #include <QVBoxLayout>
@@ -199,6 +203,16 @@ void IdeShellWindow::setStatusText(const QString &leftText, const QString &right
         m_rightStatusLabel->setText(rightText);
 }
 
+void IdeShellWindow::setProjectRoot(const QString &path)
+{
+    m_fileIndex->setRootPath(path);
+}
+
+FileIndex *IdeShellWindow::fileIndex() const
+{
+    return m_fileIndex;
+}
+
 QWidget *IdeShellWindow::createWelcomePanel() const
 {
     auto *welcome = new QWidget();
@@ -337,12 +351,23 @@ void IdeShellWindow::buildShell()
 
     topLayout->addSpacing(8);
 
-    auto *searchBox = new QLineEdit();
-    searchBox->setObjectName("searchBox");
-    searchBox->setPlaceholderText("Search");
-    searchBox->setFixedHeight(28);
-    searchBox->setFixedWidth(390);
-    topLayout->addWidget(searchBox);
+    m_searchBox = new QLineEdit();
+    m_searchBox->setObjectName("searchBox");
+    m_searchBox->setPlaceholderText("Search files (Ctrl+P)");
+    m_searchBox->setFixedHeight(28);
+    m_searchBox->setFixedWidth(390);
+    topLayout->addWidget(m_searchBox);
+
+    m_fileIndex = new FileIndex(this);
+    m_quickOpen = new QuickOpenPopup(m_searchBox, m_fileIndex, this);
+    connect(m_quickOpen, &QuickOpenPopup::fileActivated, this, &IdeShellWindow::fileOpenRequested);
+
+    auto *quickOpenShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_P), this);
+    connect(quickOpenShortcut, &QShortcut::activated, this, [this]()
+            {
+                m_searchBox->setFocus(Qt::ShortcutFocusReason);
+                m_searchBox->selectAll();
+            });
 
     topLayout->addStretch();
 
@@ -501,6 +526,35 @@ void IdeShellWindow::applyShellStyle()
             color: #6e5f82;
         }
 
+        #quickOpenPopup {
+            background: #ffffff;
+            border: 1px solid #b4a5c7;
+        }
+
+        QListWidget#quickOpenList {
+            background: #ffffff;
+            border: none;
+            color: #434852;
+            font: 9.5pt "Segoe UI";
+        }
+
+        QListWidget#quickOpenList::item {
+            padding: 3px 8px;
+        }
+
+        QListWidget#quickOpenList::item:selected {
+            background: #d8d7e7;
+            color: #3d3349;
+        }
+
+        QLabel#quickOpenFooter {
+            background: #f3f3f7;
+            border-top: 1px solid #dddde7;
+            color: #818694;
+            font: 8.5pt "Segoe UI";
+            padding: 2px 8px;
+        }
+
         QToolButton#windowButton {
             border: none;
             background: transparent;
@@ -583,7 +637,7 @@ void IdeShellWindow::applyShellStyle()
 
         QListWidget#panelList,
         QWidget#panelWidget,
-        QTreeWidget#problemsTree,
+        QTreeView#problemsTree,
         QPlainTextEdit#terminalView {
             background: #ffffff;
             border: none;
@@ -600,7 +654,7 @@ void IdeShellWindow::applyShellStyle()
             color: #434852;
         }
 
-        QTreeWidget#problemsTree::item {
+        QTreeView#problemsTree::item {
             padding: 2px 4px;
         }
 
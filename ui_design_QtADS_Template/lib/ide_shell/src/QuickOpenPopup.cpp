@@ -0,0 +1,229 @@
+#include "IdeShell/QuickOpenPopup.h"
+
+#include "IdeShell/FileIndex.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+namespace
+{
+constexpr int MaxResults = 50;
+constexpr int VisibleRows = 12;
+constexpr int MinimumWidth = 520;
+} // namespace
+
+namespace ide_shell
+{
+QuickOpenPopup::QuickOpenPopup(QLineEdit *searchBox, FileIndex *index, QWidget *parent)
+    : QFrame(parent, Qt::Tool | Qt::FramelessWindowHint | Qt::WindowDoesNotAcceptFocus)
+    , m_searchBox(searchBox)
+    , m_index(index)
+{
+    setObjectName("quickOpenPopup");
+    setAttribute(Qt::WA_ShowWithoutActivating);
+    setFocusPolicy(Qt::NoFocus);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(1, 1, 1, 1);
+    layout->setSpacing(0);
+
+    m_list = new QListWidget();
+    m_list->setObjectName("quickOpenList");
+    m_list->setFocusPolicy(Qt::NoFocus);
+    m_list->setUniformItemSizes(true);
+    m_list->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    layout->addWidget(m_list);
+
+    m_footer = new QLabel();
+    m_footer->setObjectName("quickOpenFooter");
+    layout->addWidget(m_footer);
+
+    connect(m_list, &QListWidget::itemClicked, this, &QuickOpenPopup::activateCurrent);
+    connect(m_searchBox, &QLineEdit::textEdited, this, &QuickOpenPopup::updateResults);
+    connect(m_index, &FileIndex::indexChanged, this, [this]()
+            {
+                if (isVisible())
+                    updateResults();
+            });
+    connect(m_index, &FileIndex::indexingChanged, this, [this]()
+            {
+                if (isVisible())
+                    updateResults();
+            });
+
+    m_searchBox->installEventFilter(this);
+    watchSearchBoxWindow();
+    hide();
+}
+
+QuickOpenPopup::~QuickOpenPopup() = default;
+
+bool QuickOpenPopup::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_searchBoxWindow && watched != m_searchBox)
+    {
+        switch (event->type())
+        {
+        case QEvent::Move:
+        case QEvent::Resize:
+            if (isVisible())
+                placeBelowSearchBox();
+            break;
+        case QEvent::Hide:
+            hide();
+            break;
+        default:
+            break;
+        }
+        return QFrame::eventFilter(watched, event);
+    }
+    if (watched == m_searchBox)
+    {
+        switch (event->type())
+        {
+        case QEvent::KeyPress:
+        {
+            auto *keyEvent = static_cast<QKeyEvent *>(event);
+            switch (keyEvent->key())
+            {
+            case Qt::Key_Down:
+                if (!isVisible())
+                    updateResults();
+                moveSelection(1);
+                return true;
+            case Qt::Key_Up:
+                moveSelection(-1);
+                return true;
+            case Qt::Key_PageDown:
+                moveSelection(VisibleRows);
+                return true;
+            case Qt::Key_PageUp:
+                moveSelection(-VisibleRows);
+                return true;
+            case Qt::Key_Return:
+            case Qt::Key_Enter:
+                if (isVisible())
+                {
+                    activateCurrent();
+                    return true;
+                }
+                break;
+            case Qt::Key_Escape:
+                if (isVisible())
+                {
+                    hide();
+                    return true;
+                }
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+        case QEvent::FocusOut:
+            // Clicking a result also moves the focus; let the click land first
+            if (!underMouse())
+                hide();
+            break;
+        case QEvent::Move:
+        case QEvent::Resize:
+            if (isVisible())
+                placeBelowSearchBox();
+            break;
+        case QEvent::ParentChange:
+            watchSearchBoxWindow();
+            break;
+        default:
+            break;
+        }
+    }
+    return QFrame::eventFilter(watched, event);
+}
+
+void QuickOpenPopup::updateResults()
+{
+    const QString query = m_searchBox->text().trimmed();
+    if (query.isEmpty() || m_index->rootPath().isEmpty())
+    {
+        hide();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<FileMatch> matches = m_index->find(query, MaxResults);
+    const double elapsedMs = double(timer.nsecsElapsed()) / 1.0e6;
+
+    m_list->setUpdatesEnabled(false);
+    m_list->clear();
+    for (const FileMatch &match : matches)
+    {
+        const int slash = match.path.lastIndexOf(QLatin1Char('/'));
+        const QString name = match.path.mid(slash + 1);
+        const QString folder = slash < 0 ? QString() : match.path.left(slash);
+        auto *item = new QListWidgetItem(folder.isEmpty() ? name : name + QStringLiteral("    ") + folder);
+        item->setData(Qt::UserRole, match.path);
+        item->setToolTip(match.path);
+        m_list->addItem(item);
+    }
+    if (m_list->count() > 0)
+        m_list->setCurrentRow(0);
+    m_list->setUpdatesEnabled(true);
+
+    QString footer = matches.isEmpty() ? tr("No matching files") : tr("%n result(s)", nullptr, int(matches.size()));
+    footer += tr("  |  %1 files  |  %2 ms").arg(m_index->fileCount()).arg(elapsedMs, 0, 'f', 2);
+    if (m_index->isIndexing())
+        footer += tr("  |  indexing...");
+    m_footer->setText(footer);
+
+    placeBelowSearchBox();
+    show();
+    raise();
+}
+
+void QuickOpenPopup::moveSelection(int delta)
+{
+    if (!isVisible() || m_list->count() == 0)
+        return;
+    const int row = qBound(0, m_list->currentRow() + delta, m_list->count() - 1);
+    m_list->setCurrentRow(row);
+}
+
+void QuickOpenPopup::activateCurrent()
+{
+    const QListWidgetItem *item = m_list->currentItem();
+    if (!item)
+        return;
+    const QString relativePath = item->data(Qt::UserRole).toString();
+    hide();
+    m_searchBox->clear();
+    emit fileActivated(QDir(m_index->rootPath()).filePath(relativePath));
+}
+
+void QuickOpenPopup::placeBelowSearchBox()
+{
+    const int rowHeight = m_list->sizeHintForRow(0) > 0 ? m_list->sizeHintForRow(0) : fontMetrics().height() + 6;
+    const int rows = qBound(1, m_list->count(), VisibleRows);
+    const int width = qMax(m_searchBox->width(), MinimumWidth);
+    setFixedSize(width, rows * rowHeight + m_footer->sizeHint().height() + 2 * m_list->frameWidth() + 2);
+    move(m_searchBox->mapToGlobal(QPoint(0, m_searchBox->height() + 2)));
+}
+
+void QuickOpenPopup::watchSearchBoxWindow()
+{
+    QWidget *window = m_searchBox->window();
+    if (window == m_searchBoxWindow)
+        return;
+    if (m_searchBoxWindow && m_searchBoxWindow != m_searchBox)
+        m_searchBoxWindow->removeEventFilter(this);
+    m_searchBoxWindow = window;
+    if (window != m_searchBox)
+        window->installEventFilter(this);
+}
+} // namespace ide_shell
@@ -0,0 +1,180 @@
+#include "IdeShell/DiagnosticsStore.h"
+
+#include <QAbstractItemModelTester>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <memory>
+
+using ide_shell::Diagnostic;
+using ide_shell::DiagnosticsStore;
+
+namespace
+{
+Diagnostic diagnostic(const QString &file, int line, Diagnostic::Severity severity = Diagnostic::Warning,
+                      const QString &message = QStringLiteral("unused variable"))
+{
+    Diagnostic result;
+    result.severity = severity;
+    result.file = file;
+    result.line = line;
+    result.column = 5;
+    result.code = QStringLiteral("-Wunused-variable");
+    result.message = message;
+    return result;
+}
+
+int rowsOf(const DiagnosticsStore &store, const QString &file)
+{
+    for (int row = 0; row < store.rowCount(); ++row)
+    {
+        const QModelIndex index = store.index(row, 0);
+        if (store.data(index, DiagnosticsStore::FileRole).toString() == file)
+            return store.rowCount(index);
+    }
+    return 0;
+}
+} // namespace
+
+class DiagnosticsStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void deduplicatesRecords();
+    void countsRecordsAddedToKnownFiles();
+    void clearFileKeepsOtherSources();
+    void clearSourceRemovesEmptyFiles();
+    void keepsSourcesPastTheFirst64Apart();
+
+private:
+    std::unique_ptr<DiagnosticsStore> m_store;
+    std::unique_ptr<QAbstractItemModelTester> m_tester;
+};
+
+void DiagnosticsStoreTest::init()
+{
+    m_store = std::make_unique<DiagnosticsStore>();
+    m_tester = std::make_unique<QAbstractItemModelTester>(m_store.get(),
+                                                          QAbstractItemModelTester::FailureReportingMode::QtTest);
+}
+
+void DiagnosticsStoreTest::cleanup()
+{
+    m_tester.reset();
+    m_store.reset();
+}
+
+void DiagnosticsStoreTest::deduplicatesRecords()
+{
+    const Diagnostic record = diagnostic(QStringLiteral("a.cpp"), 10);
+    m_store->addDiagnostics(QStringLiteral("build"), {record, record});
+    m_store->addDiagnostics(QStringLiteral("build"), {record});
+    m_store->addDiagnostics(QStringLiteral("clang-tidy"), {record});
+    QCOMPARE(m_store->fileCount(), 1);
+    QCOMPARE(rowsOf(*m_store, QStringLiteral("a.cpp")), 1);
+    QCOMPARE(m_store->diagnosticCount(), 1);
+
+    // Any field differing makes another record
+    Diagnostic other = record;
+    other.column = 6;
+    m_store->addDiagnostics(QStringLiteral("build"), {other});
+    QCOMPARE(rowsOf(*m_store, QStringLiteral("a.cpp")), 2);
+    QCOMPARE(m_store->diagnosticCount(), 2);
+
+    const QString tip = m_store->data(m_store->index(0, 0, m_store->index(0, 0)), Qt::ToolTipRole).toString();
+    QVERIFY(tip.contains(QStringLiteral("build, clang-tidy")));
+}
+
+void DiagnosticsStoreTest::countsRecordsAddedToKnownFiles()
+{
+    QSignalSpy counts(m_store.get(), &DiagnosticsStore::countsChanged);
+    m_store->addDiagnostics(QStringLiteral("build"), {diagnostic(QStringLiteral("a.cpp"), 1, Diagnostic::Error)});
+    m_store->addDiagnostics(QStringLiteral("build"), {diagnostic(QStringLiteral("a.cpp"), 2, Diagnostic::Error),
+                                                      diagnostic(QStringLiteral("a.cpp"), 3, Diagnostic::Warning)});
+    m_store->addDiagnostics(QStringLiteral("lint"), {diagnostic(QStringLiteral("a.cpp"), 4, Diagnostic::Info)});
+    QCOMPARE(counts.count(), 3);
+    QCOMPARE(m_store->count(Diagnostic::Error), 2);
+    QCOMPARE(m_store->count(Diagnostic::Warning), 1);
+    QCOMPARE(m_store->count(Diagnostic::Info), 1);
+    QCOMPARE(m_store->diagnosticCount(), 4);
+
+    m_store->clearSource(QStringLiteral("build"));
+    QCOMPARE(m_store->count(Diagnostic::Error), 0);
+    QCOMPARE(m_store->count(Diagnostic::Warning), 0);
+    QCOMPARE(m_store->count(Diagnostic::Info), 1);
+
+    m_store->clearSource(QStringLiteral("lint"));
+    QCOMPARE(m_store->diagnosticCount(), 0);
+    QCOMPARE(m_store->fileCount(), 0);
+}
+
+void DiagnosticsStoreTest::clearFileKeepsOtherSources()
+{
+    const Diagnostic shared = diagnostic(QStringLiteral("a.cpp"), 1);
+    m_store->addDiagnostics(QStringLiteral("build"), {shared, diagnostic(QStringLiteral("a.cpp"), 2),
+                                                      diagnostic(QStringLiteral("b.cpp"), 1)});
+    m_store->addDiagnostics(QStringLiteral("lint"), {shared});
+
+    m_store->clearFile(QStringLiteral("build"), QStringLiteral("a.cpp"));
+    QCOMPARE(rowsOf(*m_store, QStringLiteral("a.cpp")), 1);
+    QCOMPARE(rowsOf(*m_store, QStringLiteral("b.cpp")), 1);
+    QCOMPARE(m_store->diagnosticCount(), 2);
+
+    // Unknown sources and files change nothing
+    m_store->clearFile(QStringLiteral("other"), QStringLiteral("a.cpp"));
+    m_store->clearFile(QStringLiteral("build"), QStringLiteral("c.cpp"));
+    QCOMPARE(m_store->diagnosticCount(), 2);
+
+    m_store->clearFile(QStringLiteral("lint"), QStringLiteral("a.cpp"));
+    QCOMPARE(m_store->fileCount(), 1);
+    QCOMPARE(m_store->diagnosticCount(), 1);
+    QCOMPARE(m_store->count(Diagnostic::Warning), 1);
+}
+
+void DiagnosticsStoreTest::clearSourceRemovesEmptyFiles()
+{
+    m_store->addDiagnostics(QStringLiteral("build"), {diagnostic(QStringLiteral("a.cpp"), 1),
+                                                      diagnostic(QStringLiteral("b.cpp"), 1),
+                                                      diagnostic(QStringLiteral("c.cpp"), 1)});
+    m_store->addDiagnostics(QStringLiteral("lint"), {diagnostic(QStringLiteral("b.cpp"), 9)});
+
+    m_store->clearSource(QStringLiteral("build"));
+    QCOMPARE(m_store->fileCount(), 1);
+    QCOMPARE(m_store->data(m_store->index(0, 0), DiagnosticsStore::FileRole).toString(), QStringLiteral("b.cpp"));
+    QCOMPARE(m_store->diagnosticCount(), 1);
+
+    m_store->clear();
+    QCOMPARE(m_store->fileCount(), 0);
+    QCOMPARE(m_store->diagnosticCount(), 0);
+}
+
+void DiagnosticsStoreTest::keepsSourcesPastTheFirst64Apart()
+{
+    // Each source reports its own record and one record all of them share
+    const Diagnostic shared = diagnostic(QStringLiteral("a.cpp"), 1);
+    const int sources = 200;
+    for (int i = 0; i < sources; ++i)
+    {
+        const QString source = QStringLiteral("linter %1").arg(i);
+        m_store->addDiagnostics(source, {shared, diagnostic(QStringLiteral("a.cpp"), 100 + i)});
+    }
+    QCOMPARE(m_store->diagnosticCount(), sources + 1);
+
+    // Sources past 64 forget only what they reported themselves
+    m_store->clearSource(QStringLiteral("linter 70"));
+    m_store->clearSource(QStringLiteral("linter 150"));
+    QCOMPARE(m_store->diagnosticCount(), sources - 1);
+
+    for (int i = 0; i < sources; ++i)
+        m_store->clearFile(QStringLiteral("linter %1").arg(i), QStringLiteral("a.cpp"));
+    QCOMPARE(m_store->fileCount(), 0);
+    QCOMPARE(m_store->diagnosticCount(), 0);
+    QCOMPARE(m_store->count(Diagnostic::Warning), 0);
+}
+
+QTEST_GUILESS_MAIN(DiagnosticsStoreTest)
+#include "tst_diagnostics_store.moc"
@@ -0,0 +1,166 @@
+#include "IdeShell/FileIndex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+
+using ide_shell::FileIndex;
+
+namespace
+{
+bool writeFile(const QString &path)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write("x", 1) == 1;
+}
+
+// Whether relativePath is among the matches for its own file name
+bool isIndexed(const FileIndex &index, const QString &relativePath)
+{
+    const QVector<ide_shell::FileMatch> matches = index.find(QFileInfo(relativePath).fileName(), 1000);
+    return std::any_of(matches.cbegin(), matches.cend(),
+                       [&](const ide_shell::FileMatch &match) { return match.path == relativePath; });
+}
+} // namespace
+
+class FileIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void indexesExistingFiles();
+    void addsAndRemovesFiles();
+    void crawlsDirectoryMovedIn();
+    void removesDirectoryButNotSiblingsWithSamePrefix();
+    void renamesDirectory();
+    void keepsChangesMadeWhileIndexing();
+
+private:
+    QString path(const QString &relativePath) const { return m_root->filePath(relativePath); }
+
+    std::unique_ptr<QTemporaryDir> m_root;
+    std::unique_ptr<FileIndex> m_index;
+};
+
+void FileIndexTest::initTestCase()
+{
+    // Keeps the index cache files out of the user's cache directory
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void FileIndexTest::init()
+{
+    m_root = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_root->isValid());
+    QVERIFY(writeFile(path(QStringLiteral("src/main.cpp"))));
+    QVERIFY(writeFile(path(QStringLiteral("src/widget.cpp"))));
+    QVERIFY(writeFile(path(QStringLiteral("src-old/legacy.cpp"))));
+    QVERIFY(writeFile(path(QStringLiteral("README.md"))));
+    m_index = std::make_unique<FileIndex>();
+}
+
+void FileIndexTest::cleanup()
+{
+    m_index.reset();
+    m_root.reset();
+}
+
+void FileIndexTest::indexesExistingFiles()
+{
+    m_index->setRootPath(m_root->path());
+    QTRY_VERIFY(!m_index->isIndexing());
+
+    QCOMPARE(m_index->fileCount(), 4);
+    QVERIFY(isIndexed(*m_index, QStringLiteral("src/main.cpp")));
+    QVERIFY(isIndexed(*m_index, QStringLiteral("src-old/legacy.cpp")));
+    QVERIFY(isIndexed(*m_index, QStringLiteral("README.md")));
+}
+
+void FileIndexTest::addsAndRemovesFiles()
+{
+    m_index->setRootPath(m_root->path());
+    QTRY_VERIFY(!m_index->isIndexing());
+
+    QVERIFY(writeFile(path(QStringLiteral("src/added.cpp"))));
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("src/added.cpp")));
+    QCOMPARE(m_index->fileCount(), 5);
+
+    QVERIFY(QFile::remove(path(QStringLiteral("src/main.cpp"))));
+    QTRY_VERIFY(!isIndexed(*m_index, QStringLiteral("src/main.cpp")));
+    QCOMPARE(m_index->fileCount(), 4);
+}
+
+void FileIndexTest::crawlsDirectoryMovedIn()
+{
+    m_index->setRootPath(m_root->path());
+    QTRY_VERIFY(!m_index->isIndexing());
+
+    QTemporaryDir outside;
+    QVERIFY(writeFile(outside.filePath(QStringLiteral("lib/core/engine.cpp"))));
+    QVERIFY(writeFile(outside.filePath(QStringLiteral("lib/core/detail/engine_impl.cpp"))));
+    QVERIFY(QDir().rename(outside.filePath(QStringLiteral("lib")), path(QStringLiteral("lib"))));
+
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("lib/core/engine.cpp")));
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("lib/core/detail/engine_impl.cpp")));
+
+    // The moved-in directories are watched too
+    QVERIFY(writeFile(path(QStringLiteral("lib/core/detail/later.cpp"))));
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("lib/core/detail/later.cpp")));
+    QCOMPARE(m_index->fileCount(), 7);
+}
+
+void FileIndexTest::removesDirectoryButNotSiblingsWithSamePrefix()
+{
+    m_index->setRootPath(m_root->path());
+    QTRY_VERIFY(!m_index->isIndexing());
+
+    QVERIFY(QDir(path(QStringLiteral("src"))).removeRecursively());
+    QTRY_VERIFY(!isIndexed(*m_index, QStringLiteral("src/main.cpp")));
+    QTRY_VERIFY(!isIndexed(*m_index, QStringLiteral("src/widget.cpp")));
+    QVERIFY(isIndexed(*m_index, QStringLiteral("src-old/legacy.cpp")));
+    QCOMPARE(m_index->fileCount(), 2);
+}
+
+void FileIndexTest::renamesDirectory()
+{
+    m_index->setRootPath(m_root->path());
+    QTRY_VERIFY(!m_index->isIndexing());
+
+    QVERIFY(QDir().rename(path(QStringLiteral("src")), path(QStringLiteral("source"))));
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("source/main.cpp")));
+    QTRY_VERIFY(!isIndexed(*m_index, QStringLiteral("src/main.cpp")));
+    QCOMPARE(m_index->fileCount(), 4);
+
+    // Events under the new name are reported with the new name
+    QVERIFY(writeFile(path(QStringLiteral("source/renamed.cpp"))));
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("source/renamed.cpp")));
+    QVERIFY(!isIndexed(*m_index, QStringLiteral("src/renamed.cpp")));
+}
+
+void FileIndexTest::keepsChangesMadeWhileIndexing()
+{
+    m_index->setRootPath(m_root->path());
+    QVERIFY(m_index->isIndexing());
+    QVERIFY(writeFile(path(QStringLiteral("src/during.cpp"))));
+    QVERIFY(writeFile(path(QStringLiteral("new/during_dir.cpp"))));
+    QVERIFY(QFile::remove(path(QStringLiteral("README.md"))));
+
+    QTRY_VERIFY(!m_index->isIndexing());
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("src/during.cpp")));
+    QTRY_VERIFY(isIndexed(*m_index, QStringLiteral("new/during_dir.cpp")));
+    QTRY_VERIFY(!isIndexed(*m_index, QStringLiteral("README.md")));
+}
+
+QTEST_GUILESS_MAIN(FileIndexTest)
+#include "tst_file_index.moc"
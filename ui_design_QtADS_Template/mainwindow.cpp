@@ -3,11 +3,15 @@
 #include "DockManager.h"
 #include "DockWidget.h"
 
+#include <IdeShell/DiagnosticsStore.h>
+
+#include <QDir>
+#include <QFileInfo>
 #include <QHeaderView>
 #include <QLineEdit>
 #include <QListWidget>
 #include <QPlainTextEdit>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QVBoxLayout>
 #include <QWidget>
 
@@ -15,6 +19,12 @@ MainWindow::MainWindow(QWidget *parent)
     : ide_shell::IdeShellWindow(parent)
 {
     setupDockingArea();
+
+    setProjectRoot(QDir::currentPath());
+    connect(this, &ide_shell::IdeShellWindow::fileOpenRequested, this, [this](const QString &filePath)
+            {
+                setStatusText(QFileInfo(filePath).fileName(), QDir::toNativeSeparators(filePath));
+            });
 }
 
 MainWindow::~MainWindow() = default;
@@ -74,22 +84,47 @@ void MainWindow::setupDockingArea()
     outlineDock->setWidget(outlineList, ads::CDockWidget::ForceNoScrollArea);
     m_dockManager->addDockWidget(ads::RightDockWidgetArea, outlineDock);
 
-    auto *problemsView = new QTreeWidget();
+    m_diagnostics = new ide_shell::DiagnosticsStore(this);
+
+    auto *problemsView = new QTreeView();
     problemsView->setObjectName("problemsTree");
-    problemsView->setColumnCount(3);
-    problemsView->setRootIsDecorated(false);
+    problemsView->setModel(m_diagnostics);
+    problemsView->setUniformRowHeights(true);
     problemsView->setAlternatingRowColors(true);
-    problemsView->setHeaderLabels({"File", "Line", "Message"});
     problemsView->header()->setStretchLastSection(true);
-
-    auto *issueA = new QTreeWidgetItem({"mainwindow.cpp", "29", "Dummy warning: style token mismatch"});
-    auto *issueB = new QTreeWidgetItem({"CMakeLists.txt", "58", "Dummy note: release profile"});
-    problemsView->addTopLevelItem(issueA);
-    problemsView->addTopLevelItem(issueB);
+    connect(m_diagnostics, &QAbstractItemModel::rowsInserted, problemsView, [problemsView](const QModelIndex &parent, int first, int last)
+            {
+                if (parent.isValid())
+                    return;
+                for (int row = first; row <= last; ++row)
+                    problemsView->expand(problemsView->model()->index(row, 0));
+            });
 
     auto *problemsDock = new ads::CDockWidget(m_dockManager, "Problems");
     problemsDock->setWidget(problemsView, ads::CDockWidget::ForceNoScrollArea);
     auto *bottomArea = m_dockManager->addDockWidget(ads::BottomDockWidgetArea, problemsDock);
+    connect(m_diagnostics, &ide_shell::DiagnosticsStore::countsChanged, problemsDock, [this, problemsDock]()
+            {
+                const int count = m_diagnostics->diagnosticCount();
+                problemsDock->setWindowTitle(count > 0 ? QString("Problems (%1)").arg(count) : QString("Problems"));
+            });
+    connect(problemsView, &QTreeView::activated, this, [this](const QModelIndex &index)
+            {
+                if (const ide_shell::Diagnostic *diagnostic = m_diagnostics->diagnostic(index))
+                    emit fileOpenRequested(QFileInfo(diagnostic->file).absoluteFilePath());
+            });
+
+    ide_shell::Diagnostic styleWarning;
+    styleWarning.severity = ide_shell::Diagnostic::Warning;
+    styleWarning.file = "mainwindow.cpp";
+    styleWarning.line = 29;
+    styleWarning.message = "Dummy warning: style token mismatch";
+    ide_shell::Diagnostic releaseNote;
+    releaseNote.severity = ide_shell::Diagnostic::Info;
+    releaseNote.file = "CMakeLists.txt";
+    releaseNote.line = 58;
+    releaseNote.message = "Dummy note: release profile";
+    m_diagnostics->addDiagnostics("sample", {styleWarning, releaseNote});
 
     auto *terminalView = new QPlainTextEdit();
     terminalView->setObjectName("terminalView");
@@ -8,6 +8,11 @@ namespace ads
 class CDockManager;
 }
 
+namespace ide_shell
+{
+class DiagnosticsStore;
+}
+
 class MainWindow : public ide_shell::IdeShellWindow
 {
     Q_OBJECT
@@ -20,6 +25,7 @@ private:
     void setupDockingArea();
 
     ads::CDockManager *m_dockManager = nullptr;
+    ide_shell::DiagnosticsStore *m_diagnostics = nullptr;
 };
 
 #endif // MAINWINDOW_H